@@ -22,6 +22,7 @@
 #pragma once
 
 #include "clutter/clutter-actor.h"
+#include "clutter/clutter-animation-engine.h"
 #include "clutter/clutter-grab.h"
 
 G_BEGIN_DECLS
@@ -268,4 +269,16 @@ const GList * clutter_actor_peek_actions (ClutterActor *self);
 void clutter_actor_set_implicitly_grabbed (ClutterActor *actor,
                                            gboolean      is_implicitly_grabbed);
 
+gboolean clutter_actor_get_animated_property (ClutterActor            *self,
+                                              GParamSpec              *pspec,
+                                              ClutterAnimatedProperty *property);
+
+gboolean clutter_actor_set_animated_value (ClutterActor            *self,
+                                           ClutterAnimatedProperty  property,
+                                           const float             *value);
+
+void clutter_actor_finish_animated_update (ClutterActor *self);
+
+gboolean clutter_actor_needs_relayout (ClutterActor *self);
+
 G_END_DECLS
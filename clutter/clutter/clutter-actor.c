@@ -495,6 +495,7 @@
 #include "clutter/clutter-color.h"
 #include "clutter/clutter-constraint-private.h"
 #include "clutter/clutter-content-private.h"
+#include "clutter/clutter-context-private.h"
 #include "clutter/clutter-debug.h"
 #include "clutter/clutter-easing.h"
 #include "clutter/clutter-effect-private.h"
@@ -542,6 +543,17 @@ typedef enum
  * will ask for 3 different preferred size in each allocation cycle */
 #define N_CACHED_SIZE_REQUESTS 3
 
+/* Layout managers distributing space among many children, like the
+ * grid and flow layouts, may ask for more; actors that run out of
+ * entries get a larger cache */
+#define N_EXTENDED_SIZE_REQUESTS 16
+
+typedef struct _SizeRequestCache
+{
+  SizeRequest width_requests[N_EXTENDED_SIZE_REQUESTS];
+  SizeRequest height_requests[N_EXTENDED_SIZE_REQUESTS];
+} SizeRequestCache;
+
 struct _ClutterActorPrivate
 {
   /* request mode */
@@ -550,6 +562,7 @@ struct _ClutterActorPrivate
   /* our cached size requests for different width / height */
   SizeRequest width_requests[N_CACHED_SIZE_REQUESTS];
   SizeRequest height_requests[N_CACHED_SIZE_REQUESTS];
+  SizeRequestCache *size_request_cache;
 
   /* An age of 0 means the entry is not set */
   guint cached_height_age;
@@ -574,6 +587,9 @@ struct _ClutterActorPrivate
   gint opacity_override;
   unsigned int inhibit_culling_counter;
 
+  /* ClutterAnimatedProperty bits written by the animation engine */
+  unsigned int animated_properties_pending;
+
   ClutterOffscreenRedirect offscreen_redirect;
 
   /* This is an internal effect used to implement the
@@ -889,6 +905,7 @@ enum
 };
 
 static guint actor_signals[LAST_SIGNAL] = { 0, };
+static guint notify_signal_id = 0;
 
 typedef struct _TransitionClosure
 {
@@ -2518,7 +2535,7 @@ _clutter_actor_propagate_queue_redraw (ClutterActor *self)
     }
 }
 
-static inline gboolean
+gboolean
 clutter_actor_needs_relayout (ClutterActor *self)
 {
   ClutterActorPrivate *priv = self->priv;
@@ -2546,6 +2563,8 @@ clutter_actor_real_queue_relayout (ClutterActor *self)
           N_CACHED_SIZE_REQUESTS * sizeof (SizeRequest));
   memset (priv->height_requests, 0,
           N_CACHED_SIZE_REQUESTS * sizeof (SizeRequest));
+  if (priv->size_request_cache != NULL)
+    memset (priv->size_request_cache, 0, sizeof (SizeRequestCache));
 
   /* We may need to go all the way up the hierarchy */
   if (priv->parent != NULL)
@@ -5354,6 +5373,7 @@ clutter_actor_finalize (GObject *object)
   g_free (priv->name);
 
   g_free (priv->debug_name);
+  g_free (priv->size_request_cache);
 
   G_OBJECT_CLASS (clutter_actor_parent_class)->finalize (object);
 }
@@ -5561,6 +5581,8 @@ clutter_actor_class_init (ClutterActorClass *klass)
   quark_actor_transform_info = g_quark_from_static_string ("-clutter-actor-transform-info");
   quark_actor_animation_info = g_quark_from_static_string ("-clutter-actor-animation-info");
 
+  notify_signal_id = g_signal_lookup ("notify", G_TYPE_OBJECT);
+
   quark_key = g_quark_from_static_string ("key");
   quark_motion = g_quark_from_static_string ("motion");
   quark_pointer_focus = g_quark_from_static_string ("pointer-focus");
@@ -7982,13 +8004,14 @@ clutter_actor_adjust_height (ClutterActor *self,
 static gboolean
 _clutter_actor_get_cached_size_request (gfloat         for_size,
                                         SizeRequest   *cached_size_requests,
+                                        guint          n_cached_size_requests,
                                         SizeRequest  **result)
 {
   guint i;
 
   *result = &cached_size_requests[0];
 
-  for (i = 0; i < N_CACHED_SIZE_REQUESTS; i++)
+  for (i = 0; i < n_cached_size_requests; i++)
     {
       SizeRequest *sr;
 
@@ -8012,6 +8035,78 @@ _clutter_actor_get_cached_size_request (gfloat         for_size,
   return FALSE;
 }
 
+static SizeRequest *
+clutter_actor_get_size_requests (ClutterActor       *self,
+                                 ClutterOrientation  orientation,
+                                 guint              *n_size_requests)
+{
+  ClutterActorPrivate *priv = self->priv;
+
+  if (priv->size_request_cache != NULL)
+    {
+      if (n_size_requests)
+        *n_size_requests = N_EXTENDED_SIZE_REQUESTS;
+
+      if (orientation == CLUTTER_ORIENTATION_HORIZONTAL)
+        return priv->size_request_cache->width_requests;
+      else
+        return priv->size_request_cache->height_requests;
+    }
+
+  if (n_size_requests)
+    *n_size_requests = N_CACHED_SIZE_REQUESTS;
+
+  if (orientation == CLUTTER_ORIENTATION_HORIZONTAL)
+    return priv->width_requests;
+  else
+    return priv->height_requests;
+}
+
+/* looks up the cached size request for this for_size; on a miss that
+ * would evict an entry still in use, the actor switches over to the
+ * extended cache instead */
+static gboolean
+clutter_actor_lookup_size_request (ClutterActor        *self,
+                                   ClutterOrientation   orientation,
+                                   gfloat               for_size,
+                                   SizeRequest        **result)
+{
+  ClutterActorPrivate *priv = self->priv;
+  SizeRequest *size_requests;
+  guint n_size_requests;
+
+  size_requests = clutter_actor_get_size_requests (self, orientation,
+                                                   &n_size_requests);
+  if (_clutter_actor_get_cached_size_request (for_size,
+                                              size_requests,
+                                              n_size_requests,
+                                              result))
+    return TRUE;
+
+  if ((*result)->age > 0 && priv->size_request_cache == NULL)
+    {
+      priv->size_request_cache = g_new0 (SizeRequestCache, 1);
+      memcpy (priv->size_request_cache->width_requests,
+              priv->width_requests,
+              N_CACHED_SIZE_REQUESTS * sizeof (SizeRequest));
+      memcpy (priv->size_request_cache->height_requests,
+              priv->height_requests,
+              N_CACHED_SIZE_REQUESTS * sizeof (SizeRequest));
+
+      size_requests = clutter_actor_get_size_requests (self, orientation,
+                                                       &n_size_requests);
+      *result = &size_requests[N_CACHED_SIZE_REQUESTS];
+    }
+
+  return FALSE;
+}
+
+static inline ClutterLayoutStatistics *
+get_layout_statistics (void)
+{
+  return &_clutter_context_get_default ()->layout_statistics;
+}
+
 static void
 clutter_actor_update_preferred_size_for_constraints (ClutterActor *self,
                                                      ClutterOrientation direction,
@@ -8134,18 +8229,26 @@ clutter_actor_get_preferred_width (ClutterActor *self,
   if (!priv->needs_width_request)
     {
       found_in_cache =
-        _clutter_actor_get_cached_size_request (for_height,
-                                                priv->width_requests,
-                                                &cached_size_request);
+        clutter_actor_lookup_size_request (self,
+                                           CLUTTER_ORIENTATION_HORIZONTAL,
+                                           for_height,
+                                           &cached_size_request);
     }
   else
     {
       /* if the actor needs a width request we use the first slot */
       found_in_cache = FALSE;
-      cached_size_request = &priv->width_requests[0];
+      cached_size_request =
+        clutter_actor_get_size_requests (self,
+                                         CLUTTER_ORIENTATION_HORIZONTAL,
+                                         NULL);
     }
 
-  if (!found_in_cache)
+  if (found_in_cache)
+    {
+      get_layout_statistics ()->n_cached_size_requests++;
+    }
+  else
     {
       gfloat minimum_width, natural_width;
       ClutterActorClass *klass;
@@ -8162,6 +8265,8 @@ clutter_actor_get_preferred_width (ClutterActor *self,
 
       CLUTTER_NOTE (LAYOUT, "Width request for %.2f px", for_height);
 
+      get_layout_statistics ()->n_size_requests++;
+
       klass = CLUTTER_ACTOR_GET_CLASS (self);
       klass->get_preferred_width (self, for_height,
                                   &minimum_width,
@@ -8297,17 +8402,25 @@ clutter_actor_get_preferred_height (ClutterActor *self,
   if (!priv->needs_height_request)
     {
       found_in_cache =
-        _clutter_actor_get_cached_size_request (for_width,
-                                                priv->height_requests,
-                                                &cached_size_request);
+        clutter_actor_lookup_size_request (self,
+                                           CLUTTER_ORIENTATION_VERTICAL,
+                                           for_width,
+                                           &cached_size_request);
     }
   else
     {
       found_in_cache = FALSE;
-      cached_size_request = &priv->height_requests[0];
+      cached_size_request =
+        clutter_actor_get_size_requests (self,
+                                         CLUTTER_ORIENTATION_VERTICAL,
+                                         NULL);
     }
 
-  if (!found_in_cache)
+  if (found_in_cache)
+    {
+      get_layout_statistics ()->n_cached_size_requests++;
+    }
+  else
     {
       gfloat minimum_height, natural_height;
       ClutterActorClass *klass;
@@ -8316,6 +8429,8 @@ clutter_actor_get_preferred_height (ClutterActor *self,
 
       CLUTTER_NOTE (LAYOUT, "Height request for %.2f px", for_width);
 
+      get_layout_statistics ()->n_size_requests++;
+
       /* adjust for margin */
       if (for_width >= 0)
         {
@@ -8596,6 +8711,8 @@ clutter_actor_allocate_internal (ClutterActor           *self,
   CLUTTER_NOTE (LAYOUT, "Calling %s::allocate()",
                 _clutter_actor_get_debug_name (self));
 
+  get_layout_statistics ()->n_allocations++;
+
   klass = CLUTTER_ACTOR_GET_CLASS (self);
   klass->allocate (self, allocation);
 
@@ -12229,6 +12346,255 @@ clutter_actor_set_final_state (ClutterAnimatable *animatable,
   g_free (p_name);
 }
 
+/* Set when the transform-set property changes with an animated transform */
+#define ANIMATED_TRANSFORM_SET_CHANGED (1 << CLUTTER_N_ANIMATED_PROPERTIES)
+
+#define ANIMATED_TRANSFORM_PROPERTIES \
+  ((1 << CLUTTER_ANIMATED_PROPERTY_TRANSLATION_X) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Y) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Z) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_SCALE_X) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_SCALE_Y) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_SCALE_Z) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_X) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Y) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Z) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT_Z) | \
+   (1 << CLUTTER_ANIMATED_PROPERTY_TRANSFORM))
+
+static const int animated_properties[] = {
+  [CLUTTER_ANIMATED_PROPERTY_TRANSLATION_X] = PROP_TRANSLATION_X,
+  [CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Y] = PROP_TRANSLATION_Y,
+  [CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Z] = PROP_TRANSLATION_Z,
+  [CLUTTER_ANIMATED_PROPERTY_SCALE_X] = PROP_SCALE_X,
+  [CLUTTER_ANIMATED_PROPERTY_SCALE_Y] = PROP_SCALE_Y,
+  [CLUTTER_ANIMATED_PROPERTY_SCALE_Z] = PROP_SCALE_Z,
+  [CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_X] = PROP_ROTATION_ANGLE_X,
+  [CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Y] = PROP_ROTATION_ANGLE_Y,
+  [CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Z] = PROP_ROTATION_ANGLE_Z,
+  [CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT] = PROP_PIVOT_POINT,
+  [CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT_Z] = PROP_PIVOT_POINT_Z,
+  [CLUTTER_ANIMATED_PROPERTY_OPACITY] = PROP_OPACITY,
+  [CLUTTER_ANIMATED_PROPERTY_BACKGROUND_COLOR] = PROP_BACKGROUND_COLOR,
+  [CLUTTER_ANIMATED_PROPERTY_TRANSFORM] = PROP_TRANSFORM,
+};
+
+/*< private >
+ * clutter_actor_get_animated_property:
+ * @self: a #ClutterActor
+ * @pspec: the #GParamSpec of an animatable property of @self
+ * @property: (out): return location for the animated property
+ *
+ * Checks whether the animation engine can write the animated values of
+ * @pspec directly into @self, instead of going through
+ * clutter_animatable_set_final_state().
+ *
+ * Return value: %TRUE if @pspec can be animated by the animation engine
+ */
+gboolean
+clutter_actor_get_animated_property (ClutterActor            *self,
+                                     GParamSpec              *pspec,
+                                     ClutterAnimatedProperty *property)
+{
+  ClutterAnimatableInterface *iface = CLUTTER_ANIMATABLE_GET_IFACE (self);
+  size_t i;
+
+  /* Subclasses overriding how values are applied need to see them */
+  if (iface->set_final_state != clutter_actor_set_final_state ||
+      iface->interpolate_value != NULL)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (animated_properties); i++)
+    {
+      if (obj_props[animated_properties[i]] != pspec)
+        continue;
+
+      *property = i;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Easing modes such as the back and elastic ones overshoot, which must
+ * not wrap around for byte sized values */
+static inline guint8
+animated_value_to_byte (float value)
+{
+  return (guint8) CLAMP (roundf (value), 0.f, 255.f);
+}
+
+/*< private >
+ * clutter_actor_set_animated_value:
+ * @self: a #ClutterActor
+ * @property: the animated property
+ * @value: the components of the value, as floats
+ *
+ * Stores an animated value in the state of @self without invalidating
+ * anything; clutter_actor_finish_animated_update() does that once for
+ * all the animated properties of @self.
+ *
+ * Return value: %TRUE if @self had no pending animated update yet
+ */
+gboolean
+clutter_actor_set_animated_value (ClutterActor            *self,
+                                  ClutterAnimatedProperty  property,
+                                  const float             *value)
+{
+  ClutterActorPrivate *priv = self->priv;
+  unsigned int pending = priv->animated_properties_pending;
+  ClutterTransformInfo *info;
+
+  switch (property)
+    {
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_X:
+      _clutter_actor_get_transform_info (self)->translation.x = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Y:
+      _clutter_actor_get_transform_info (self)->translation.y = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Z:
+      _clutter_actor_get_transform_info (self)->translation.z = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_X:
+      _clutter_actor_get_transform_info (self)->scale_x = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_Y:
+      _clutter_actor_get_transform_info (self)->scale_y = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_Z:
+      _clutter_actor_get_transform_info (self)->scale_z = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_X:
+      _clutter_actor_get_transform_info (self)->rx_angle = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Y:
+      _clutter_actor_get_transform_info (self)->ry_angle = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Z:
+      _clutter_actor_get_transform_info (self)->rz_angle = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT:
+      _clutter_actor_get_transform_info (self)->pivot =
+        GRAPHENE_POINT_INIT (value[0], value[1]);
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT_Z:
+      _clutter_actor_get_transform_info (self)->pivot_z = value[0];
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_OPACITY:
+      {
+        guint8 opacity = animated_value_to_byte (value[0]);
+
+        if (priv->opacity == opacity)
+          return FALSE;
+
+        priv->opacity = opacity;
+      }
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_BACKGROUND_COLOR:
+      {
+        ClutterColor color = {
+          .red = animated_value_to_byte (value[0]),
+          .green = animated_value_to_byte (value[1]),
+          .blue = animated_value_to_byte (value[2]),
+          .alpha = animated_value_to_byte (value[3]),
+        };
+
+        if (priv->bg_color_set && clutter_color_equal (&color, &priv->bg_color))
+          return FALSE;
+
+        priv->bg_color = color;
+        priv->bg_color_set = TRUE;
+      }
+      break;
+    case CLUTTER_ANIMATED_PROPERTY_TRANSFORM:
+      {
+        gboolean was_set;
+
+        info = _clutter_actor_get_transform_info (self);
+        was_set = info->transform_set;
+
+        graphene_matrix_init_from_float (&info->transform, value);
+        info->transform_set = !graphene_matrix_is_identity (&info->transform);
+
+        if (was_set != info->transform_set)
+          priv->animated_properties_pending |= ANIMATED_TRANSFORM_SET_CHANGED;
+      }
+      break;
+    case CLUTTER_N_ANIMATED_PROPERTIES:
+      g_assert_not_reached ();
+    }
+
+  priv->animated_properties_pending |= 1 << property;
+
+  return pending == 0;
+}
+
+static inline void
+maybe_notify_animated (ClutterActor *self,
+                       GParamSpec   *pspec)
+{
+  /* Animated values change every frame; only pay for the notification
+   * when somebody is listening */
+  if (g_signal_has_handler_pending (self, notify_signal_id,
+                                    g_param_spec_get_name_quark (pspec),
+                                    FALSE))
+    g_object_notify_by_pspec (G_OBJECT (self), pspec);
+}
+
+/*< private >
+ * clutter_actor_finish_animated_update:
+ * @self: a #ClutterActor
+ *
+ * Invalidates @self once for all the values stored by
+ * clutter_actor_set_animated_value() since the last call.
+ */
+void
+clutter_actor_finish_animated_update (ClutterActor *self)
+{
+  ClutterActorPrivate *priv = self->priv;
+  unsigned int pending = priv->animated_properties_pending;
+  GObject *obj = G_OBJECT (self);
+  int i;
+
+  if (pending == 0)
+    return;
+
+  priv->animated_properties_pending = 0;
+
+  if (pending & ANIMATED_TRANSFORM_PROPERTIES)
+    transform_changed (self);
+
+  if (pending == (1 << CLUTTER_ANIMATED_PROPERTY_OPACITY))
+    {
+      /* See clutter_actor_set_opacity_internal() */
+      _clutter_actor_queue_redraw_full (self, NULL, priv->flatten_effect);
+    }
+  else
+    {
+      clutter_actor_queue_redraw (self);
+    }
+
+  g_object_freeze_notify (obj);
+
+  for (i = 0; i < CLUTTER_N_ANIMATED_PROPERTIES; i++)
+    {
+      if (pending & (1 << i))
+        maybe_notify_animated (self, obj_props[animated_properties[i]]);
+    }
+
+  if (pending & (1 << CLUTTER_ANIMATED_PROPERTY_BACKGROUND_COLOR))
+    maybe_notify_animated (self, obj_props[PROP_BACKGROUND_COLOR_SET]);
+
+  if (pending & ANIMATED_TRANSFORM_SET_CHANGED)
+    g_object_notify_by_pspec (obj, obj_props[PROP_TRANSFORM_SET]);
+
+  g_object_thaw_notify (obj);
+
+  clutter_actor_update_devices (self);
+}
+
 static ClutterActor *
 clutter_actor_get_actor (ClutterAnimatable *animatable)
 {
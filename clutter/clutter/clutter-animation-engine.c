@@ -0,0 +1,579 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The animation engine evaluates the property transitions of actors in
+ * bulk. Transitions hand it their progress while the timelines are
+ * advanced, and once all timelines of a frame have been advanced, the
+ * engine evaluates the easing of every updated transition in one pass per
+ * easing mode, interpolates the values, and writes them directly into the
+ * actors, invalidating each actor once.
+ *
+ * Transitions are stored in tracks of packed arrays, one track per number
+ * of value components, so that interpolating a track is a single loop
+ * over plain floats.
+ */
+
+#include "config.h"
+
+#include "clutter/clutter-animation-engine.h"
+
+#include <string.h>
+
+#include "clutter/clutter-actor-private.h"
+#include "clutter/clutter-easing.h"
+#include "clutter/clutter-private.h"
+
+#define MATRIX_N_COMPONENTS 16
+
+typedef enum _ClutterAnimationTrackType
+{
+  CLUTTER_ANIMATION_TRACK_FLOAT,
+  CLUTTER_ANIMATION_TRACK_POINT,
+  CLUTTER_ANIMATION_TRACK_COLOR,
+  CLUTTER_ANIMATION_TRACK_MATRIX,
+
+  CLUTTER_N_ANIMATION_TRACKS
+} ClutterAnimationTrackType;
+
+typedef struct _ClutterAnimationTrack
+{
+  int n_components;
+
+  unsigned int n_slots;
+  unsigned int n_allocated_slots;
+
+  ClutterActor **actors;
+  uint8_t *properties;
+  uint8_t *modes;
+  uint8_t *dirty;
+  float *progress;
+  float *eased;
+  unsigned int *handles;
+
+  float *from;
+  float *to;
+  float *values;
+} ClutterAnimationTrack;
+
+typedef struct _ClutterAnimationHandle
+{
+  int track;
+  unsigned int slot;
+} ClutterAnimationHandle;
+
+struct _ClutterAnimationEngine
+{
+  ClutterAnimationTrack tracks[CLUTTER_N_ANIMATION_TRACKS];
+
+  /* ClutterAnimationHandle, indexed by handle - 1 */
+  GArray *handles;
+  GArray *free_handles;
+
+  unsigned int n_dirty;
+
+  /* Dirty slots of a track, grouped by easing mode */
+  unsigned int n_allocated_scratch;
+  unsigned int *scratch_slots;
+  float *scratch_progress;
+  float *scratch_eased;
+
+  GPtrArray *pending_actors;
+};
+
+int
+clutter_animated_property_get_n_components (ClutterAnimatedProperty property)
+{
+  switch (property)
+    {
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_X:
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Y:
+    case CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Z:
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_X:
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_Y:
+    case CLUTTER_ANIMATED_PROPERTY_SCALE_Z:
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_X:
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Y:
+    case CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Z:
+    case CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT_Z:
+    case CLUTTER_ANIMATED_PROPERTY_OPACITY:
+      return 1;
+    case CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT:
+      return 2;
+    case CLUTTER_ANIMATED_PROPERTY_BACKGROUND_COLOR:
+      return 4;
+    case CLUTTER_ANIMATED_PROPERTY_TRANSFORM:
+      return MATRIX_N_COMPONENTS;
+    case CLUTTER_N_ANIMATED_PROPERTIES:
+      break;
+    }
+
+  g_assert_not_reached ();
+}
+
+static ClutterAnimationTrackType
+get_track_type_for_property (ClutterAnimatedProperty property)
+{
+  switch (clutter_animated_property_get_n_components (property))
+    {
+    case 1:
+      return CLUTTER_ANIMATION_TRACK_FLOAT;
+    case 2:
+      return CLUTTER_ANIMATION_TRACK_POINT;
+    case 4:
+      return CLUTTER_ANIMATION_TRACK_COLOR;
+    case MATRIX_N_COMPONENTS:
+      return CLUTTER_ANIMATION_TRACK_MATRIX;
+    }
+
+  g_assert_not_reached ();
+}
+
+ClutterAnimationEngine *
+clutter_animation_engine_new (void)
+{
+  ClutterAnimationEngine *engine;
+
+  engine = g_new0 (ClutterAnimationEngine, 1);
+  engine->tracks[CLUTTER_ANIMATION_TRACK_FLOAT].n_components = 1;
+  engine->tracks[CLUTTER_ANIMATION_TRACK_POINT].n_components = 2;
+  engine->tracks[CLUTTER_ANIMATION_TRACK_COLOR].n_components = 4;
+  engine->tracks[CLUTTER_ANIMATION_TRACK_MATRIX].n_components =
+    MATRIX_N_COMPONENTS;
+  engine->handles = g_array_new (FALSE, FALSE,
+                                 sizeof (ClutterAnimationHandle));
+  engine->free_handles = g_array_new (FALSE, FALSE, sizeof (unsigned int));
+  engine->pending_actors = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return engine;
+}
+
+static void
+clutter_animation_track_clear (ClutterAnimationTrack *track)
+{
+  g_free (track->actors);
+  g_free (track->properties);
+  g_free (track->modes);
+  g_free (track->dirty);
+  g_free (track->progress);
+  g_free (track->eased);
+  g_free (track->handles);
+  g_free (track->from);
+  g_free (track->to);
+  g_free (track->values);
+}
+
+void
+clutter_animation_engine_free (ClutterAnimationEngine *engine)
+{
+  int i;
+
+  for (i = 0; i < CLUTTER_N_ANIMATION_TRACKS; i++)
+    clutter_animation_track_clear (&engine->tracks[i]);
+
+  g_array_unref (engine->handles);
+  g_array_unref (engine->free_handles);
+  g_ptr_array_unref (engine->pending_actors);
+  g_free (engine->scratch_slots);
+  g_free (engine->scratch_progress);
+  g_free (engine->scratch_eased);
+  g_free (engine);
+}
+
+static void
+clutter_animation_track_grow (ClutterAnimationTrack *track)
+{
+  unsigned int n_slots;
+  size_t n_values;
+
+  n_slots = MAX (track->n_allocated_slots * 2, 16);
+  n_values = (size_t) n_slots * track->n_components;
+
+  track->actors = g_renew (ClutterActor *, track->actors, n_slots);
+  track->properties = g_renew (uint8_t, track->properties, n_slots);
+  track->modes = g_renew (uint8_t, track->modes, n_slots);
+  track->dirty = g_renew (uint8_t, track->dirty, n_slots);
+  track->progress = g_renew (float, track->progress, n_slots);
+  track->eased = g_renew (float, track->eased, n_slots);
+  track->handles = g_renew (unsigned int, track->handles, n_slots);
+  track->from = g_renew (float, track->from, n_values);
+  track->to = g_renew (float, track->to, n_values);
+  track->values = g_renew (float, track->values, n_values);
+
+  track->n_allocated_slots = n_slots;
+}
+
+static inline ClutterAnimationHandle *
+get_handle (ClutterAnimationEngine *engine,
+            unsigned int            handle)
+{
+  g_assert (handle > 0 && handle <= engine->handles->len);
+
+  return &g_array_index (engine->handles, ClutterAnimationHandle, handle - 1);
+}
+
+unsigned int
+clutter_animation_engine_add (ClutterAnimationEngine  *engine,
+                              ClutterActor            *actor,
+                              ClutterAnimatedProperty  property)
+{
+  ClutterAnimationTrack *track;
+  ClutterAnimationHandle *animation_handle;
+  unsigned int handle;
+  unsigned int slot;
+  size_t offset;
+
+  track = &engine->tracks[get_track_type_for_property (property)];
+  if (track->n_slots == track->n_allocated_slots)
+    clutter_animation_track_grow (track);
+
+  if (engine->free_handles->len > 0)
+    {
+      handle = g_array_index (engine->free_handles, unsigned int,
+                              engine->free_handles->len - 1);
+      g_array_set_size (engine->free_handles, engine->free_handles->len - 1);
+    }
+  else
+    {
+      g_array_set_size (engine->handles, engine->handles->len + 1);
+      handle = engine->handles->len;
+    }
+
+  slot = track->n_slots++;
+  offset = (size_t) slot * track->n_components;
+
+  track->actors[slot] = actor;
+  track->properties[slot] = property;
+  track->modes[slot] = CLUTTER_LINEAR;
+  track->dirty[slot] = FALSE;
+  track->progress[slot] = 0.0f;
+  track->eased[slot] = 0.0f;
+  track->handles[slot] = handle;
+  memset (&track->from[offset], 0, track->n_components * sizeof (float));
+  memset (&track->to[offset], 0, track->n_components * sizeof (float));
+  memset (&track->values[offset], 0, track->n_components * sizeof (float));
+
+  animation_handle = get_handle (engine, handle);
+  animation_handle->track = track - engine->tracks;
+  animation_handle->slot = slot;
+
+  return handle;
+}
+
+static inline void
+interpolate_values (const float  *from,
+                    const float  *to,
+                    const float  *eased,
+                    float        *values,
+                    unsigned int  first_slot,
+                    unsigned int  n_slots,
+                    int           n_components)
+{
+  size_t i;
+  int j;
+
+  for (i = first_slot; i < first_slot + n_slots; i++)
+    {
+      for (j = 0; j < n_components; j++)
+        {
+          size_t k = i * n_components + j;
+
+          values[k] = from[k] + (to[k] - from[k]) * eased[i];
+        }
+    }
+}
+
+static void
+interpolate_track (ClutterAnimationTrack *track,
+                   unsigned int           first_slot,
+                   unsigned int           n_slots)
+{
+  unsigned int i;
+
+  /* Dispatching on constant component counts lets the compiler unroll
+   * and vectorize each loop */
+  switch (track->n_components)
+    {
+    case 1:
+      interpolate_values (track->from, track->to, track->eased, track->values,
+                          first_slot, n_slots, 1);
+      break;
+    case 2:
+      interpolate_values (track->from, track->to, track->eased, track->values,
+                          first_slot, n_slots, 2);
+      break;
+    case 4:
+      interpolate_values (track->from, track->to, track->eased, track->values,
+                          first_slot, n_slots, 4);
+      break;
+    case MATRIX_N_COMPONENTS:
+      /* Matrices are decomposed, like the graphene progress function of
+       * ClutterInterval does */
+      for (i = first_slot; i < first_slot + n_slots; i++)
+        {
+          size_t offset = (size_t) i * MATRIX_N_COMPONENTS;
+          graphene_matrix_t from, to, value;
+
+          if (!track->dirty[i])
+            continue;
+
+          graphene_matrix_init_from_float (&from, &track->from[offset]);
+          graphene_matrix_init_from_float (&to, &track->to[offset]);
+          graphene_matrix_interpolate (&from, &to, track->eased[i], &value);
+          graphene_matrix_to_float (&value, &track->values[offset]);
+        }
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+write_slot (ClutterAnimationEngine *engine,
+            ClutterAnimationTrack  *track,
+            unsigned int            slot)
+{
+  ClutterActor *actor = track->actors[slot];
+
+  if (clutter_actor_set_animated_value (actor,
+                                        track->properties[slot],
+                                        &track->values[(size_t) slot *
+                                                       track->n_components]))
+    g_ptr_array_add (engine->pending_actors, g_object_ref (actor));
+
+  track->dirty[slot] = FALSE;
+  engine->n_dirty--;
+}
+
+static void
+finish_pending_actors (ClutterAnimationEngine *engine)
+{
+  g_autoptr (GPtrArray) actors = NULL;
+  unsigned int i;
+
+  if (engine->pending_actors->len == 0)
+    return;
+
+  /* Notification handlers may end transitions, which applies them */
+  actors = g_steal_pointer (&engine->pending_actors);
+  engine->pending_actors = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0; i < actors->len; i++)
+    clutter_actor_finish_animated_update (actors->pdata[i]);
+}
+
+static void
+apply_slot (ClutterAnimationEngine *engine,
+            ClutterAnimationTrack  *track,
+            unsigned int            slot)
+{
+  if (!track->dirty[slot])
+    return;
+
+  clutter_easing_for_mode_batch (track->modes[slot],
+                                 &track->progress[slot],
+                                 &track->eased[slot],
+                                 1);
+  interpolate_track (track, slot, 1);
+  write_slot (engine, track, slot);
+  finish_pending_actors (engine);
+}
+
+void
+clutter_animation_engine_remove (ClutterAnimationEngine *engine,
+                                 unsigned int            handle)
+{
+  ClutterAnimationHandle *animation_handle = get_handle (engine, handle);
+  ClutterAnimationTrack *track = &engine->tracks[animation_handle->track];
+  unsigned int slot = animation_handle->slot;
+  unsigned int last_slot;
+
+  if (track->dirty[slot])
+    {
+      if (!CLUTTER_ACTOR_IN_DESTRUCTION (track->actors[slot]))
+        {
+          apply_slot (engine, track, slot);
+        }
+      else
+        {
+          track->dirty[slot] = FALSE;
+          engine->n_dirty--;
+        }
+    }
+
+  last_slot = track->n_slots - 1;
+  if (slot != last_slot)
+    {
+      size_t offset = (size_t) slot * track->n_components;
+      size_t last_offset = (size_t) last_slot * track->n_components;
+      size_t size = track->n_components * sizeof (float);
+
+      track->actors[slot] = track->actors[last_slot];
+      track->properties[slot] = track->properties[last_slot];
+      track->modes[slot] = track->modes[last_slot];
+      track->dirty[slot] = track->dirty[last_slot];
+      track->progress[slot] = track->progress[last_slot];
+      track->eased[slot] = track->eased[last_slot];
+      track->handles[slot] = track->handles[last_slot];
+      memcpy (&track->from[offset], &track->from[last_offset], size);
+      memcpy (&track->to[offset], &track->to[last_offset], size);
+      memcpy (&track->values[offset], &track->values[last_offset], size);
+
+      get_handle (engine, track->handles[slot])->slot = slot;
+    }
+  track->n_slots--;
+
+  animation_handle->track = -1;
+  g_array_append_val (engine->free_handles, handle);
+}
+
+void
+clutter_animation_engine_update (ClutterAnimationEngine *engine,
+                                 unsigned int            handle,
+                                 ClutterAnimationMode    mode,
+                                 float                   progress,
+                                 const float            *from,
+                                 const float            *to)
+{
+  ClutterAnimationHandle *animation_handle = get_handle (engine, handle);
+  ClutterAnimationTrack *track = &engine->tracks[animation_handle->track];
+  unsigned int slot = animation_handle->slot;
+  size_t offset = (size_t) slot * track->n_components;
+
+  g_assert (mode >= CLUTTER_LINEAR && mode <= CLUTTER_EASE_IN_OUT_BOUNCE);
+
+  memcpy (&track->from[offset], from, track->n_components * sizeof (float));
+  memcpy (&track->to[offset], to, track->n_components * sizeof (float));
+  track->modes[slot] = mode;
+  track->progress[slot] = progress;
+
+  if (!track->dirty[slot])
+    {
+      track->dirty[slot] = TRUE;
+      engine->n_dirty++;
+    }
+}
+
+void
+clutter_animation_engine_apply (ClutterAnimationEngine *engine,
+                                unsigned int            handle)
+{
+  ClutterAnimationHandle *animation_handle = get_handle (engine, handle);
+
+  apply_slot (engine,
+              &engine->tracks[animation_handle->track],
+              animation_handle->slot);
+}
+
+static void
+ensure_scratch_size (ClutterAnimationEngine *engine,
+                     unsigned int            n_slots)
+{
+  if (engine->n_allocated_scratch >= n_slots)
+    return;
+
+  engine->n_allocated_scratch = n_slots;
+  engine->scratch_slots = g_renew (unsigned int, engine->scratch_slots, n_slots);
+  engine->scratch_progress = g_renew (float, engine->scratch_progress, n_slots);
+  engine->scratch_eased = g_renew (float, engine->scratch_eased, n_slots);
+}
+
+static void
+flush_track (ClutterAnimationEngine *engine,
+             ClutterAnimationTrack  *track)
+{
+  unsigned int mode_ends[CLUTTER_ANIMATION_LAST] = { 0, };
+  unsigned int n_dirty = 0;
+  unsigned int offset;
+  unsigned int i;
+  int mode;
+
+  for (i = 0; i < track->n_slots; i++)
+    {
+      if (track->dirty[i])
+        {
+          mode_ends[track->modes[i]]++;
+          n_dirty++;
+        }
+    }
+
+  if (n_dirty == 0)
+    return;
+
+  ensure_scratch_size (engine, n_dirty);
+
+  /* Counting sort of the dirty slots by easing mode */
+  offset = 0;
+  for (mode = 0; mode < CLUTTER_ANIMATION_LAST; mode++)
+    {
+      unsigned int n_mode_slots = mode_ends[mode];
+
+      mode_ends[mode] = offset;
+      offset += n_mode_slots;
+    }
+
+  for (i = 0; i < track->n_slots; i++)
+    {
+      unsigned int j;
+
+      if (!track->dirty[i])
+        continue;
+
+      j = mode_ends[track->modes[i]]++;
+      engine->scratch_slots[j] = i;
+      engine->scratch_progress[j] = track->progress[i];
+    }
+
+  offset = 0;
+  for (mode = 0; mode < CLUTTER_ANIMATION_LAST; mode++)
+    {
+      if (mode_ends[mode] == offset)
+        continue;
+
+      clutter_easing_for_mode_batch (mode,
+                                     &engine->scratch_progress[offset],
+                                     &engine->scratch_eased[offset],
+                                     mode_ends[mode] - offset);
+      offset = mode_ends[mode];
+    }
+
+  for (i = 0; i < n_dirty; i++)
+    track->eased[engine->scratch_slots[i]] = engine->scratch_eased[i];
+
+  interpolate_track (track, 0, track->n_slots);
+
+  for (i = 0; i < n_dirty; i++)
+    write_slot (engine, track, engine->scratch_slots[i]);
+}
+
+void
+clutter_animation_engine_flush (ClutterAnimationEngine *engine)
+{
+  int i;
+
+  if (engine->n_dirty == 0)
+    return;
+
+  for (i = 0; i < CLUTTER_N_ANIMATION_TRACKS; i++)
+    flush_track (engine, &engine->tracks[i]);
+
+  finish_pending_actors (engine);
+}
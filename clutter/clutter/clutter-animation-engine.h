@@ -0,0 +1,89 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "clutter/clutter-types.h"
+
+G_BEGIN_DECLS
+
+/*< private >
+ * ClutterAnimatedProperty:
+ *
+ * The actor properties the animation engine writes directly into the
+ * actor state, bypassing GObject.
+ */
+typedef enum _ClutterAnimatedProperty
+{
+  CLUTTER_ANIMATED_PROPERTY_TRANSLATION_X,
+  CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Y,
+  CLUTTER_ANIMATED_PROPERTY_TRANSLATION_Z,
+  CLUTTER_ANIMATED_PROPERTY_SCALE_X,
+  CLUTTER_ANIMATED_PROPERTY_SCALE_Y,
+  CLUTTER_ANIMATED_PROPERTY_SCALE_Z,
+  CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_X,
+  CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Y,
+  CLUTTER_ANIMATED_PROPERTY_ROTATION_ANGLE_Z,
+  CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT,
+  CLUTTER_ANIMATED_PROPERTY_PIVOT_POINT_Z,
+  CLUTTER_ANIMATED_PROPERTY_OPACITY,
+  CLUTTER_ANIMATED_PROPERTY_BACKGROUND_COLOR,
+  CLUTTER_ANIMATED_PROPERTY_TRANSFORM,
+
+  CLUTTER_N_ANIMATED_PROPERTIES
+} ClutterAnimatedProperty;
+
+typedef struct _ClutterAnimationEngine ClutterAnimationEngine;
+
+G_GNUC_INTERNAL
+int clutter_animated_property_get_n_components (ClutterAnimatedProperty property);
+
+G_GNUC_INTERNAL
+ClutterAnimationEngine * clutter_animation_engine_new (void);
+
+G_GNUC_INTERNAL
+void clutter_animation_engine_free (ClutterAnimationEngine *engine);
+
+G_GNUC_INTERNAL
+unsigned int clutter_animation_engine_add (ClutterAnimationEngine  *engine,
+                                           ClutterActor            *actor,
+                                           ClutterAnimatedProperty  property);
+
+G_GNUC_INTERNAL
+void clutter_animation_engine_remove (ClutterAnimationEngine *engine,
+                                      unsigned int            handle);
+
+G_GNUC_INTERNAL
+void clutter_animation_engine_update (ClutterAnimationEngine *engine,
+                                      unsigned int            handle,
+                                      ClutterAnimationMode    mode,
+                                      float                   progress,
+                                      const float            *from,
+                                      const float            *to);
+
+G_GNUC_INTERNAL
+void clutter_animation_engine_apply (ClutterAnimationEngine *engine,
+                                     unsigned int            handle);
+
+G_GNUC_INTERNAL
+void clutter_animation_engine_flush (ClutterAnimationEngine *engine);
+
+G_END_DECLS
@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include "clutter/clutter-animation-engine.h"
 #include "clutter/clutter-context.h"
+#include "clutter/clutter-private.h"
 
 struct _ClutterContext
 {
@@ -43,6 +45,17 @@ struct _ClutterContext
 
   ClutterSettings *settings;
 
+  ClutterAnimationEngine *animation_engine;
+
+  /* Layout work done since the last frame */
+  ClutterLayoutStatistics layout_statistics;
+
   gboolean is_initialized;
   gboolean show_fps;
 };
+
+static inline ClutterAnimationEngine *
+clutter_context_get_animation_engine (ClutterContext *context)
+{
+  return context->animation_engine;
+}
@@ -30,6 +30,11 @@
 #include "clutter/clutter-paint-node-private.h"
 #include "clutter/clutter-settings-private.h"
 
+/* Printable ASCII, which makes up most of the text of a UI */
+#define PREWARM_GLYPH_CACHE_TEXT \
+  " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
+  "[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"
+
 static gboolean clutter_disable_mipmap_text = FALSE;
 static gboolean clutter_show_fps = FALSE;
 
@@ -79,6 +84,10 @@ static const GDebugKey clutter_paint_debug_keys[] = {
 typedef struct _ClutterContextPrivate
 {
   ClutterTextDirection text_direction;
+
+  guint prewarm_glyph_cache_id;
+  gulong font_changed_id;
+  gulong resolution_changed_id;
 } ClutterContextPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (ClutterContext, clutter_context, G_TYPE_OBJECT)
@@ -87,9 +96,15 @@ static void
 clutter_context_dispose (GObject *object)
 {
   ClutterContext *context = CLUTTER_CONTEXT (object);
+  ClutterContextPrivate *priv = clutter_context_get_instance_private (context);
+
+  g_clear_handle_id (&priv->prewarm_glyph_cache_id, g_source_remove);
+  g_clear_signal_handler (&priv->font_changed_id, context->backend);
+  g_clear_signal_handler (&priv->resolution_changed_id, context->backend);
 
   g_clear_pointer (&context->events_queue, g_async_queue_unref);
   g_clear_pointer (&context->backend, clutter_backend_destroy);
+  g_clear_pointer (&context->animation_engine, clutter_animation_engine_free);
 
   G_OBJECT_CLASS (clutter_context_parent_class)->dispose (object);
 }
@@ -110,6 +125,8 @@ clutter_context_init (ClutterContext *context)
   ClutterContextPrivate *priv = clutter_context_get_instance_private (context);
 
   priv->text_direction = CLUTTER_TEXT_DIRECTION_LTR;
+
+  context->animation_engine = clutter_animation_engine_new ();
 }
 
 ClutterTextDirection
@@ -158,6 +175,70 @@ clutter_get_text_direction (void)
   return dir;
 }
 
+static gboolean
+prewarm_glyph_cache (gpointer user_data)
+{
+  ClutterContext *context = CLUTTER_CONTEXT (user_data);
+  ClutterContextPrivate *priv = clutter_context_get_instance_private (context);
+  const PangoWeight weights[] = { PANGO_WEIGHT_NORMAL, PANGO_WEIGHT_BOLD };
+  g_autoptr (PangoContext) pango_context = NULL;
+  g_autoptr (PangoLayout) layout = NULL;
+  g_autofree char *font_name = NULL;
+  PangoFontDescription *font_desc;
+  CoglPangoFontMap *font_map;
+  double resolution;
+  int i;
+
+  priv->prewarm_glyph_cache_id = 0;
+
+  g_object_get (context->settings, "font-name", &font_name, NULL);
+
+  resolution = clutter_backend_get_resolution (context->backend);
+  if (resolution < 0)
+    resolution = 96.0; /* fall back */
+
+  /* Set up the context the same way actors do, so the glyphs end up
+   * being cached for the very fonts the actors use */
+  font_map = clutter_context_get_pango_fontmap (context);
+  pango_context = cogl_pango_font_map_create_context (font_map);
+  pango_cairo_context_set_font_options (pango_context,
+                                        clutter_backend_get_font_options (context->backend));
+  pango_cairo_context_set_resolution (pango_context, resolution);
+  pango_context_set_language (pango_context, pango_language_get_default ());
+
+  layout = pango_layout_new (pango_context);
+  pango_layout_set_text (layout, PREWARM_GLYPH_CACHE_TEXT, -1);
+
+  CLUTTER_NOTE (PANGO, "Pre-warming glyph cache for '%s'", font_name);
+
+  font_desc = pango_font_description_from_string (font_name);
+
+  for (i = 0; i < G_N_ELEMENTS (weights); i++)
+    {
+      pango_font_description_set_weight (font_desc, weights[i]);
+      pango_layout_set_font_description (layout, font_desc);
+
+      /* This only queues the glyphs, they are drawn in the background */
+      cogl_pango_ensure_glyph_cache_for_layout (layout);
+    }
+
+  pango_font_description_free (font_desc);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_prewarm_glyph_cache (ClutterContext *context)
+{
+  ClutterContextPrivate *priv = clutter_context_get_instance_private (context);
+
+  if (priv->prewarm_glyph_cache_id)
+    return;
+
+  priv->prewarm_glyph_cache_id =
+    g_idle_add_full (G_PRIORITY_LOW, prewarm_glyph_cache, context, NULL);
+}
+
 static gboolean
 clutter_context_init_real (ClutterContext       *context,
                            ClutterContextFlags   flags,
@@ -196,6 +277,18 @@ clutter_context_init_real (ClutterContext       *context,
   /* Initialize types required for paint nodes */
   clutter_paint_node_init_types (context->backend);
 
+  /* Get the glyphs of the UI font ready before the first text is
+   * painted, and again whenever the font changes */
+  priv->font_changed_id =
+    g_signal_connect_swapped (context->backend, "font-changed",
+                              G_CALLBACK (queue_prewarm_glyph_cache),
+                              context);
+  priv->resolution_changed_id =
+    g_signal_connect_swapped (context->backend, "resolution-changed",
+                              G_CALLBACK (queue_prewarm_glyph_cache),
+                              context);
+  queue_prewarm_glyph_cache (context);
+
   return TRUE;
 }
 
@@ -553,3 +553,67 @@ clutter_easing_for_mode (ClutterAnimationMode mode,
 
   return _clutter_animation_modes[mode].func (t, d);
 }
+
+/*< private >
+ * clutter_easing_for_mode_batch:
+ * @mode: a non-parametrized animation mode
+ * @progress: (array length=n_values): linear progress values, between 0 and 1
+ * @eased: (array length=n_values): return location for the eased values
+ * @n_values: the number of values
+ *
+ * Evaluates the easing function of @mode for a whole array of progress
+ * values. The mode is only dispatched once, so that the easing function
+ * can be inlined into a loop the compiler is able to vectorize.
+ */
+void
+clutter_easing_for_mode_batch (ClutterAnimationMode  mode,
+                               const float          *progress,
+                               float                *eased,
+                               int                   n_values)
+{
+  int i;
+
+#define EASE_BATCH(func) \
+  for (i = 0; i < n_values; i++) \
+    eased[i] = (float) func (progress[i], 1.0); \
+  break
+
+  switch (mode)
+    {
+    case CLUTTER_LINEAR: EASE_BATCH (clutter_linear);
+    case CLUTTER_EASE_IN_QUAD: EASE_BATCH (clutter_ease_in_quad);
+    case CLUTTER_EASE_OUT_QUAD: EASE_BATCH (clutter_ease_out_quad);
+    case CLUTTER_EASE_IN_OUT_QUAD: EASE_BATCH (clutter_ease_in_out_quad);
+    case CLUTTER_EASE_IN_CUBIC: EASE_BATCH (clutter_ease_in_cubic);
+    case CLUTTER_EASE_OUT_CUBIC: EASE_BATCH (clutter_ease_out_cubic);
+    case CLUTTER_EASE_IN_OUT_CUBIC: EASE_BATCH (clutter_ease_in_out_cubic);
+    case CLUTTER_EASE_IN_QUART: EASE_BATCH (clutter_ease_in_quart);
+    case CLUTTER_EASE_OUT_QUART: EASE_BATCH (clutter_ease_out_quart);
+    case CLUTTER_EASE_IN_OUT_QUART: EASE_BATCH (clutter_ease_in_out_quart);
+    case CLUTTER_EASE_IN_QUINT: EASE_BATCH (clutter_ease_in_quint);
+    case CLUTTER_EASE_OUT_QUINT: EASE_BATCH (clutter_ease_out_quint);
+    case CLUTTER_EASE_IN_OUT_QUINT: EASE_BATCH (clutter_ease_in_out_quint);
+    case CLUTTER_EASE_IN_SINE: EASE_BATCH (clutter_ease_in_sine);
+    case CLUTTER_EASE_OUT_SINE: EASE_BATCH (clutter_ease_out_sine);
+    case CLUTTER_EASE_IN_OUT_SINE: EASE_BATCH (clutter_ease_in_out_sine);
+    case CLUTTER_EASE_IN_EXPO: EASE_BATCH (clutter_ease_in_expo);
+    case CLUTTER_EASE_OUT_EXPO: EASE_BATCH (clutter_ease_out_expo);
+    case CLUTTER_EASE_IN_OUT_EXPO: EASE_BATCH (clutter_ease_in_out_expo);
+    case CLUTTER_EASE_IN_CIRC: EASE_BATCH (clutter_ease_in_circ);
+    case CLUTTER_EASE_OUT_CIRC: EASE_BATCH (clutter_ease_out_circ);
+    case CLUTTER_EASE_IN_OUT_CIRC: EASE_BATCH (clutter_ease_in_out_circ);
+    case CLUTTER_EASE_IN_ELASTIC: EASE_BATCH (clutter_ease_in_elastic);
+    case CLUTTER_EASE_OUT_ELASTIC: EASE_BATCH (clutter_ease_out_elastic);
+    case CLUTTER_EASE_IN_OUT_ELASTIC: EASE_BATCH (clutter_ease_in_out_elastic);
+    case CLUTTER_EASE_IN_BACK: EASE_BATCH (clutter_ease_in_back);
+    case CLUTTER_EASE_OUT_BACK: EASE_BATCH (clutter_ease_out_back);
+    case CLUTTER_EASE_IN_OUT_BACK: EASE_BATCH (clutter_ease_in_out_back);
+    case CLUTTER_EASE_IN_BOUNCE: EASE_BATCH (clutter_ease_in_bounce);
+    case CLUTTER_EASE_OUT_BOUNCE: EASE_BATCH (clutter_ease_out_bounce);
+    case CLUTTER_EASE_IN_OUT_BOUNCE: EASE_BATCH (clutter_ease_in_out_bounce);
+    default:
+      g_assert_not_reached ();
+    }
+
+#undef EASE_BATCH
+}
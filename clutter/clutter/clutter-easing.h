@@ -26,6 +26,12 @@ double                  clutter_easing_for_mode                 (ClutterAnimatio
                                                                  double               t,
                                                                  double               d);
 
+G_GNUC_INTERNAL
+void                    clutter_easing_for_mode_batch           (ClutterAnimationMode  mode,
+                                                                 const float          *progress,
+                                                                 float                *eased,
+                                                                 int                   n_values);
+
 G_GNUC_INTERNAL
 double  clutter_linear                  (double t,
                                          double d);
@@ -26,6 +26,8 @@
 #include <time.h>
 #endif
 
+#include "clutter/clutter-animation-engine.h"
+#include "clutter/clutter-context-private.h"
 #include "clutter/clutter-debug.h"
 #include "clutter/clutter-frame-private.h"
 #include "clutter/clutter-main.h"
@@ -221,6 +223,14 @@ advance_timelines (ClutterFrameClock *frame_clock,
     }
 
   g_list_free_full (timelines, g_object_unref);
+
+  /* Property transitions only queue their new values while ticking */
+  if (timelines)
+    {
+      ClutterContext *context = _clutter_context_get_default ();
+
+      clutter_animation_engine_flush (clutter_context_get_animation_engine (context));
+    }
 }
 
 static void
@@ -320,6 +330,24 @@ clutter_frame_clock_notify_presented (ClutterFrameClock *frame_clock,
     }
 
 #ifdef HAVE_PROFILER
+  if (cogl_is_trace_ring_enabled () &&
+      cogl_trace_ring_has_trigger () &&
+      frame_clock->has_last_next_presentation_time &&
+      frame_info->presentation_time != 0 &&
+      (frame_info->presentation_time -
+       frame_clock->last_next_presentation_time_us) >
+      frame_clock->refresh_interval_us / 2)
+    {
+      g_autofree char *reason = NULL;
+
+      reason = g_strdup_printf ("%s presented %" G_GINT64_FORMAT " µs "
+                                "after the deadline",
+                                frame_clock->output_name,
+                                frame_info->presentation_time -
+                                frame_clock->last_next_presentation_time_us);
+      cogl_trace_ring_trigger (reason);
+    }
+
   if (G_UNLIKELY (cogl_is_tracing_enabled ()))
     {
       int64_t current_time_us;
@@ -115,6 +115,10 @@ void clutter_get_debug_flags (ClutterDebugFlag     *debug_flags,
 CLUTTER_EXPORT
 void clutter_actor_notify_transform_invalid (ClutterActor *self);
 
+CLUTTER_EXPORT
+void clutter_stage_get_layout_statistics (ClutterStage            *stage,
+                                          ClutterLayoutStatistics *statistics);
+
 CLUTTER_EXPORT
 void clutter_actor_get_relative_transformation_matrix (ClutterActor      *self,
                                                        ClutterActor      *ancestor,
@@ -98,6 +98,24 @@ typedef enum
   CLUTTER_IN_MAP_UNMAP   = 1 << 8,
 } ClutterPrivateFlags;
 
+/*
+ * ClutterLayoutStatistics:
+ * @n_relayouts: number of relayout roots that were allocated
+ * @n_allocations: number of calls to the allocate() virtual function
+ * @n_size_requests: number of preferred size requests that were computed
+ * @n_cached_size_requests: number of preferred size requests that were
+ *   answered from the cache
+ *
+ * Counters of the layout work done during a frame.
+ */
+typedef struct _ClutterLayoutStatistics
+{
+  unsigned int n_relayouts;
+  unsigned int n_allocations;
+  unsigned int n_size_requests;
+  unsigned int n_cached_size_requests;
+} ClutterLayoutStatistics;
+
 ClutterContext *        _clutter_context_get_default                    (void);
 
 CLUTTER_EXPORT
@@ -32,7 +32,10 @@
 
 #include "clutter/clutter-property-transition.h"
 
+#include "clutter/clutter-actor-private.h"
 #include "clutter/clutter-animatable.h"
+#include "clutter/clutter-animation-engine.h"
+#include "clutter/clutter-context-private.h"
 #include "clutter/clutter-debug.h"
 #include "clutter/clutter-interval.h"
 #include "clutter/clutter-private.h"
@@ -43,6 +46,12 @@ typedef struct _ClutterPropertyTransitionPrivate
   char *property_name;
 
   GParamSpec *pspec;
+
+  /* Set if the animatable is an actor that lets the animation engine
+   * write the animated values of the property directly */
+  gboolean use_animation_engine;
+  ClutterAnimatedProperty animated_property;
+  unsigned int animation_handle;
 } ClutterPropertyTransitionPrivate;
 
 enum
@@ -91,6 +100,223 @@ clutter_property_transition_ensure_interval (ClutterPropertyTransition *transiti
     }
 }
 
+static ClutterAnimationEngine *
+get_animation_engine (void)
+{
+  if (!_clutter_context_is_initialized ())
+    return NULL;
+
+  return clutter_context_get_animation_engine (_clutter_context_get_default ());
+}
+
+static void
+clutter_property_transition_update_pspec (ClutterPropertyTransition *transition,
+                                          ClutterAnimatable         *animatable)
+{
+  ClutterPropertyTransitionPrivate *priv =
+    clutter_property_transition_get_instance_private (transition);
+  ClutterAnimationEngine *engine;
+
+  engine = get_animation_engine ();
+  if (priv->animation_handle != 0 && engine != NULL)
+    clutter_animation_engine_remove (engine, priv->animation_handle);
+
+  priv->animation_handle = 0;
+  priv->use_animation_engine = FALSE;
+  priv->pspec = NULL;
+
+  if (animatable == NULL || priv->property_name == NULL)
+    return;
+
+  priv->pspec = clutter_animatable_find_property (animatable,
+                                                  priv->property_name);
+  if (priv->pspec == NULL)
+    return;
+
+  if (CLUTTER_IS_ACTOR (animatable))
+    {
+      priv->use_animation_engine =
+        clutter_actor_get_animated_property (CLUTTER_ACTOR (animatable),
+                                             priv->pspec,
+                                             &priv->animated_property);
+    }
+}
+
+static gboolean
+get_animated_value (const GValue *value,
+                    float        *components)
+{
+  GType value_type = G_VALUE_TYPE (value);
+
+  if (value_type == G_TYPE_FLOAT)
+    {
+      components[0] = g_value_get_float (value);
+    }
+  else if (value_type == G_TYPE_DOUBLE)
+    {
+      components[0] = g_value_get_double (value);
+    }
+  else if (value_type == G_TYPE_UINT)
+    {
+      components[0] = g_value_get_uint (value);
+    }
+  else if (value_type == GRAPHENE_TYPE_POINT)
+    {
+      const graphene_point_t *point = g_value_get_boxed (value);
+
+      if (point == NULL)
+        return FALSE;
+
+      components[0] = point->x;
+      components[1] = point->y;
+    }
+  else if (value_type == CLUTTER_TYPE_COLOR)
+    {
+      const ClutterColor *color = g_value_get_boxed (value);
+
+      if (color == NULL)
+        return FALSE;
+
+      components[0] = color->red;
+      components[1] = color->green;
+      components[2] = color->blue;
+      components[3] = color->alpha;
+    }
+  else if (value_type == GRAPHENE_TYPE_MATRIX)
+    {
+      const graphene_matrix_t *matrix = g_value_get_boxed (value);
+
+      if (matrix == NULL)
+        return FALSE;
+
+      graphene_matrix_to_float (matrix, components);
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Hands the new frame to the animation engine, which evaluates the
+ * transitions of all actors in one go once the timelines have been
+ * advanced; returns FALSE if the transition has to be computed and
+ * applied through ClutterAnimatable instead */
+static gboolean
+clutter_property_transition_queue_frame (ClutterPropertyTransition *transition,
+                                         ClutterAnimatable         *animatable,
+                                         ClutterInterval           *interval)
+{
+  ClutterPropertyTransitionPrivate *priv =
+    clutter_property_transition_get_instance_private (transition);
+  ClutterTimeline *timeline = CLUTTER_TIMELINE (transition);
+  ClutterAnimationEngine *engine;
+  ClutterAnimationMode mode;
+  GType value_type;
+  float from[16], to[16];
+  unsigned int duration;
+  int elapsed;
+  float progress;
+  gboolean is_last_frame;
+
+  if (!priv->use_animation_engine)
+    return FALSE;
+
+  /* Subclasses such as ClutterKeyframeTransition compute their values
+   * differently, through their own ClutterTransition::compute_value() */
+  if (G_OBJECT_TYPE (transition) != CLUTTER_TYPE_PROPERTY_TRANSITION)
+    return FALSE;
+
+  engine = get_animation_engine ();
+  if (engine == NULL)
+    return FALSE;
+
+  /* Subclasses of ClutterInterval may compute values differently, and
+   * so may progress functions registered for the basic types */
+  if (G_OBJECT_TYPE (interval) != CLUTTER_TYPE_INTERVAL)
+    return FALSE;
+
+  value_type = clutter_interval_get_value_type (interval);
+  if (value_type != G_PARAM_SPEC_VALUE_TYPE (priv->pspec))
+    return FALSE;
+
+  if (G_TYPE_IS_FUNDAMENTAL (value_type) &&
+      _clutter_has_progress_function (value_type))
+    return FALSE;
+
+  clutter_property_transition_ensure_interval (transition, animatable,
+                                               interval);
+
+  if (!get_animated_value (clutter_interval_peek_initial_value (interval),
+                           from) ||
+      !get_animated_value (clutter_interval_peek_final_value (interval),
+                           to))
+    return FALSE;
+
+  duration = clutter_timeline_get_duration (timeline);
+  elapsed = clutter_timeline_get_elapsed_time (timeline);
+  mode = clutter_timeline_get_progress_mode (timeline);
+
+  if (duration > 0 &&
+      mode >= CLUTTER_LINEAR && mode <= CLUTTER_EASE_IN_OUT_BOUNCE)
+    {
+      /* Eased by the animation engine, batched by mode */
+      progress = (float) elapsed / (float) duration;
+    }
+  else
+    {
+      /* Parametrized and custom modes are evaluated by the timeline */
+      progress = clutter_timeline_get_progress (timeline);
+      mode = CLUTTER_LINEAR;
+    }
+
+  if (priv->animation_handle == 0)
+    {
+      priv->animation_handle =
+        clutter_animation_engine_add (engine,
+                                      CLUTTER_ACTOR (animatable),
+                                      priv->animated_property);
+    }
+
+  clutter_animation_engine_update (engine, priv->animation_handle,
+                                   mode, progress, from, to);
+
+  /* The final value needs to be in place by the time ::completed and
+   * ::stopped are emitted, as handlers commonly chain from it */
+  if (clutter_timeline_get_direction (timeline) == CLUTTER_TIMELINE_FORWARD)
+    is_last_frame = elapsed >= (int) duration;
+  else
+    is_last_frame = elapsed <= 0;
+
+  if (is_last_frame)
+    clutter_animation_engine_apply (engine, priv->animation_handle);
+
+  return TRUE;
+}
+
+static void
+clutter_property_transition_new_frame (ClutterTimeline *timeline,
+                                       int              elapsed)
+{
+  ClutterPropertyTransition *self = CLUTTER_PROPERTY_TRANSITION (timeline);
+  ClutterPropertyTransitionPrivate *priv =
+    clutter_property_transition_get_instance_private (self);
+  ClutterTransition *transition = CLUTTER_TRANSITION (timeline);
+  ClutterAnimatable *animatable;
+  ClutterInterval *interval;
+
+  animatable = clutter_transition_get_animatable (transition);
+  interval = clutter_transition_get_interval (transition);
+
+  if (priv->pspec != NULL && animatable != NULL && interval != NULL &&
+      clutter_property_transition_queue_frame (self, animatable, interval))
+    return;
+
+  CLUTTER_TIMELINE_CLASS (clutter_property_transition_parent_class)->new_frame (timeline,
+                                                                                 elapsed);
+}
+
 static void
 clutter_property_transition_attached (ClutterTransition *transition,
                                       ClutterAnimatable *animatable)
@@ -100,11 +326,7 @@ clutter_property_transition_attached (ClutterTransition *transition,
     clutter_property_transition_get_instance_private (self);
   ClutterInterval *interval;
 
-  if (priv->property_name == NULL)
-    return;
-
-  priv->pspec =
-    clutter_animatable_find_property (animatable, priv->property_name);
+  clutter_property_transition_update_pspec (self, animatable);
 
   if (priv->pspec == NULL)
     return;
@@ -121,10 +343,8 @@ clutter_property_transition_detached (ClutterTransition *transition,
                                       ClutterAnimatable *animatable)
 {
   ClutterPropertyTransition *self = CLUTTER_PROPERTY_TRANSITION (transition);
-  ClutterPropertyTransitionPrivate *priv =
-    clutter_property_transition_get_instance_private (self);
 
-  priv->pspec = NULL;
+  clutter_property_transition_update_pspec (self, NULL);
 }
 
 static void
@@ -249,8 +469,11 @@ static void
 clutter_property_transition_class_init (ClutterPropertyTransitionClass *klass)
 {
   ClutterTransitionClass *transition_class = CLUTTER_TRANSITION_CLASS (klass);
+  ClutterTimelineClass *timeline_class = CLUTTER_TIMELINE_CLASS (klass);
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
+  timeline_class->new_frame = clutter_property_transition_new_frame;
+
   transition_class->attached = clutter_property_transition_attached;
   transition_class->detached = clutter_property_transition_detached;
   transition_class->compute_value = clutter_property_transition_compute_value;
@@ -337,15 +560,10 @@ clutter_property_transition_set_property_name (ClutterPropertyTransition *transi
 
   g_free (priv->property_name);
   priv->property_name = g_strdup (property_name);
-  priv->pspec = NULL;
 
   animatable =
     clutter_transition_get_animatable (CLUTTER_TRANSITION (transition));
-  if (animatable != NULL)
-    {
-      priv->pspec = clutter_animatable_find_property (animatable,
-                                                      priv->property_name);
-    }
+  clutter_property_transition_update_pspec (transition, animatable);
 
   g_object_notify_by_pspec (G_OBJECT (transition),
                             obj_props[PROP_PROPERTY_NAME]);
@@ -83,6 +83,8 @@ void                _clutter_stage_maybe_setup_viewport  (ClutterStage
 void                clutter_stage_maybe_relayout         (ClutterActor          *stage);
 void                clutter_stage_finish_layout          (ClutterStage          *stage);
 
+void                clutter_stage_take_layout_statistics (ClutterStage          *stage);
+
 CLUTTER_EXPORT
 void     _clutter_stage_queue_event                       (ClutterStage *stage,
                                                            ClutterEvent *event,
@@ -21,10 +21,34 @@
 #include "clutter/clutter-types.h"
 #include "mtk/mtk.h"
 
+/*
+ * ClutterDamageStatistics:
+ * @damaged_area: number of framebuffer pixels covered by the redraw clip
+ *   queued by actors
+ * @repainted_area: number of framebuffer pixels that were repainted, which
+ *   includes the damage history of reused buffers, or the whole view for
+ *   unclipped redraws
+ *
+ * Counters of the damage handled during a frame.
+ */
+typedef struct _ClutterDamageStatistics
+{
+  unsigned int damaged_area;
+  unsigned int repainted_area;
+} ClutterDamageStatistics;
+
 CLUTTER_EXPORT
 void clutter_stage_view_after_paint (ClutterStageView *view,
                                      MtkRegion        *redraw_clip);
 
+CLUTTER_EXPORT
+void clutter_stage_view_record_damage_statistics (ClutterStageView              *view,
+                                                  const ClutterDamageStatistics *statistics);
+
+CLUTTER_EXPORT
+void clutter_stage_view_get_damage_statistics (ClutterStageView        *view,
+                                               ClutterDamageStatistics *statistics);
+
 CLUTTER_EXPORT
 void clutter_stage_view_before_swap_buffer (ClutterStageView *view,
                                             const MtkRegion  *swap_region);
@@ -88,6 +88,8 @@ typedef struct _ClutterStageViewPrivate
   int64_t vblank_duration_us;
   ClutterFrameClock *frame_clock;
 
+  ClutterDamageStatistics damage_statistics;
+
   struct {
     int frame_count;
     int64_t last_print_time_us;
@@ -396,6 +398,39 @@ clutter_stage_view_after_paint (ClutterStageView *view,
     }
 }
 
+/**
+ * clutter_stage_view_record_damage_statistics: (skip)
+ * @view: a #ClutterStageView
+ * @statistics: the damage statistics of the frame that was just painted
+ */
+void
+clutter_stage_view_record_damage_statistics (ClutterStageView              *view,
+                                             const ClutterDamageStatistics *statistics)
+{
+  ClutterStageViewPrivate *priv =
+    clutter_stage_view_get_instance_private (view);
+
+  priv->damage_statistics = *statistics;
+}
+
+/**
+ * clutter_stage_view_get_damage_statistics: (skip)
+ * @view: a #ClutterStageView
+ * @statistics: (out): return location for the statistics
+ *
+ * Retrieves the counters of the damage handled for the most recent
+ * frame painted on @view.
+ */
+void
+clutter_stage_view_get_damage_statistics (ClutterStageView        *view,
+                                          ClutterDamageStatistics *statistics)
+{
+  ClutterStageViewPrivate *priv =
+    clutter_stage_view_get_instance_private (view);
+
+  *statistics = priv->damage_statistics;
+}
+
 static void
 copy_shadowfb_to_onscreen (ClutterStageView *view,
                            const MtkRegion  *swap_region)
@@ -735,8 +770,8 @@ clutter_stage_view_peek_scanout (ClutterStageView *view)
   return priv->next_scanout;
 }
 
-void
-clutter_stage_view_schedule_update (ClutterStageView *view)
+static void
+clutter_stage_view_real_schedule_update (ClutterStageView *view)
 {
   ClutterStageViewPrivate *priv =
     clutter_stage_view_get_instance_private (view);
@@ -744,6 +779,12 @@ clutter_stage_view_schedule_update (ClutterStageView *view)
   clutter_frame_clock_schedule_update (priv->frame_clock);
 }
 
+void
+clutter_stage_view_schedule_update (ClutterStageView *view)
+{
+  CLUTTER_STAGE_VIEW_GET_CLASS (view)->schedule_update (view);
+}
+
 void
 clutter_stage_view_schedule_update_now (ClutterStageView *view)
 {
@@ -888,6 +929,7 @@ handle_frame_clock_frame (ClutterFrameClock *frame_clock,
   clutter_stage_maybe_relayout (CLUTTER_ACTOR (stage));
 
   clutter_stage_finish_layout (stage);
+  clutter_stage_take_layout_statistics (stage);
 
   _clutter_stage_window_prepare_frame (stage_window, view, frame);
   clutter_stage_emit_prepare_frame (stage, view, frame);
@@ -1155,6 +1197,7 @@ clutter_stage_view_class_init (ClutterStageViewClass *klass)
 
   klass->get_offscreen_transformation_matrix =
     clutter_stage_default_get_offscreen_transformation_matrix;
+  klass->schedule_update = clutter_stage_view_real_schedule_update;
 
   object_class->get_property = clutter_stage_view_get_property;
   object_class->set_property = clutter_stage_view_set_property;
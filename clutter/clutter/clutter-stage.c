@@ -128,6 +128,8 @@ typedef struct _ClutterStagePrivate
 
   GSList *pending_relayouts;
 
+  ClutterLayoutStatistics layout_statistics;
+
   int update_freeze_count;
 
   gboolean update_scheduled;
@@ -876,6 +878,10 @@ clutter_stage_maybe_relayout (ClutterActor *actor)
       if (CLUTTER_ACTOR_IN_RELAYOUT (queued_actor))  /* avoid reentrancy */
         continue;
 
+      /* Already allocated as part of a subtree relayed out earlier */
+      if (!clutter_actor_needs_relayout (queued_actor))
+        continue;
+
       if (queued_actor == actor)
         CLUTTER_NOTE (ACTOR, "    Deep relayout of stage %s",
                       _clutter_actor_get_debug_name (queued_actor));
@@ -895,6 +901,8 @@ clutter_stage_maybe_relayout (ClutterActor *actor)
 
   CLUTTER_NOTE (ACTOR, "<<< Completed recomputing layout of %d subtrees", count);
 
+  _clutter_context_get_default ()->layout_statistics.n_relayouts += count;
+
   if (count)
     clutter_stage_invalidate_devices (stage);
 }
@@ -933,6 +941,44 @@ clutter_stage_finish_layout (ClutterStage *stage)
   g_warn_if_fail (!priv->actor_needs_immediate_relayout);
 }
 
+void
+clutter_stage_take_layout_statistics (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = clutter_stage_get_instance_private (stage);
+  ClutterContext *context = _clutter_context_get_default ();
+  ClutterLayoutStatistics *statistics = &context->layout_statistics;
+
+  /* Layout is stage wide and done by whichever view updates first, keep
+   * the other views of the same stage update from replacing the counters
+   * with zeros.
+   */
+  if (statistics->n_relayouts == 0 &&
+      statistics->n_allocations == 0 &&
+      statistics->n_size_requests == 0 &&
+      statistics->n_cached_size_requests == 0)
+    return;
+
+  priv->layout_statistics = *statistics;
+  *statistics = (ClutterLayoutStatistics) { 0 };
+}
+
+/**
+ * clutter_stage_get_layout_statistics: (skip)
+ * @stage: a #ClutterStage
+ * @statistics: (out): return location for the statistics
+ *
+ * Retrieves the counters of the layout work done for the most recent
+ * frame of @stage that did any layout work.
+ */
+void
+clutter_stage_get_layout_statistics (ClutterStage            *stage,
+                                     ClutterLayoutStatistics *statistics)
+{
+  ClutterStagePrivate *priv = clutter_stage_get_instance_private (stage);
+
+  *statistics = priv->layout_statistics;
+}
+
 static void
 clutter_stage_real_queue_relayout (ClutterActor *self)
 {
@@ -193,6 +193,122 @@ clutter_virtual_input_device_notify_touch_up (ClutterVirtualInputDevice *virtual
                           slot);
 }
 
+static gboolean
+is_touch_event (const ClutterVirtualInputEvent *event)
+{
+  switch (event->type)
+    {
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_UP:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/**
+ * clutter_virtual_input_device_notify_events: (skip)
+ * @virtual_device: a #ClutterVirtualInputDevice
+ * @events: (array length=n_events): the events to emit
+ * @n_events: the number of events in @events
+ *
+ * Emits a batch of events in the order they are passed, each with its own
+ * timestamp. Implementations may dispatch the whole batch at once, which is
+ * considerably cheaper than emitting the events one by one.
+ */
+void
+clutter_virtual_input_device_notify_events (ClutterVirtualInputDevice      *virtual_device,
+                                            const ClutterVirtualInputEvent *events,
+                                            size_t                          n_events)
+{
+  ClutterVirtualInputDeviceClass *klass =
+    CLUTTER_VIRTUAL_INPUT_DEVICE_GET_CLASS (virtual_device);
+  size_t i;
+
+  g_return_if_fail (CLUTTER_IS_VIRTUAL_INPUT_DEVICE (virtual_device));
+  g_return_if_fail (events != NULL || n_events == 0);
+
+  for (i = 0; i < n_events; i++)
+    {
+      if (!is_touch_event (&events[i]))
+        continue;
+
+      g_return_if_fail (events[i].touch.slot >= 0 &&
+                        events[i].touch.slot < CLUTTER_VIRTUAL_INPUT_DEVICE_MAX_TOUCH_SLOTS);
+    }
+
+  if (n_events == 0)
+    return;
+
+  klass->notify_events (virtual_device, events, n_events);
+}
+
+static void
+clutter_virtual_input_device_real_notify_events (ClutterVirtualInputDevice      *virtual_device,
+                                                 const ClutterVirtualInputEvent *events,
+                                                 size_t                          n_events)
+{
+  ClutterVirtualInputDeviceClass *klass =
+    CLUTTER_VIRTUAL_INPUT_DEVICE_GET_CLASS (virtual_device);
+  size_t i;
+
+  for (i = 0; i < n_events; i++)
+    {
+      const ClutterVirtualInputEvent *event = &events[i];
+
+      switch (event->type)
+        {
+        case CLUTTER_VIRTUAL_INPUT_EVENT_RELATIVE_MOTION:
+          klass->notify_relative_motion (virtual_device, event->time_us,
+                                         event->motion.x, event->motion.y);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_ABSOLUTE_MOTION:
+          klass->notify_absolute_motion (virtual_device, event->time_us,
+                                         event->motion.x, event->motion.y);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_BUTTON:
+          klass->notify_button (virtual_device, event->time_us,
+                                event->button.button,
+                                event->button.button_state);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_KEY:
+          klass->notify_key (virtual_device, event->time_us,
+                             event->key.key, event->key.key_state);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_KEYVAL:
+          klass->notify_keyval (virtual_device, event->time_us,
+                                event->key.key, event->key.key_state);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_DISCRETE_SCROLL:
+          klass->notify_discrete_scroll (virtual_device, event->time_us,
+                                         event->discrete_scroll.direction,
+                                         event->discrete_scroll.scroll_source);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_SCROLL_CONTINUOUS:
+          klass->notify_scroll_continuous (virtual_device, event->time_us,
+                                           event->scroll.dx, event->scroll.dy,
+                                           event->scroll.scroll_source,
+                                           event->scroll.finish_flags);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN:
+          klass->notify_touch_down (virtual_device, event->time_us,
+                                    event->touch.slot,
+                                    event->touch.x, event->touch.y);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION:
+          klass->notify_touch_motion (virtual_device, event->time_us,
+                                      event->touch.slot,
+                                      event->touch.x, event->touch.y);
+          break;
+        case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_UP:
+          klass->notify_touch_up (virtual_device, event->time_us,
+                                  event->touch.slot);
+          break;
+        }
+    }
+}
+
 int
 clutter_virtual_input_device_get_device_type (ClutterVirtualInputDevice *virtual_device)
 {
@@ -279,6 +395,8 @@ clutter_virtual_input_device_class_init (ClutterVirtualInputDeviceClass *klass)
   object_class->get_property = clutter_virtual_input_device_get_property;
   object_class->set_property = clutter_virtual_input_device_set_property;
 
+  klass->notify_events = clutter_virtual_input_device_real_notify_events;
+
   obj_props[PROP_SEAT] =
     g_param_spec_object ("seat", NULL, NULL,
                          CLUTTER_TYPE_SEAT,
@@ -50,6 +50,68 @@ typedef enum _ClutterKeyState
   CLUTTER_KEY_STATE_PRESSED
 } ClutterKeyState;
 
+typedef enum _ClutterVirtualInputEventType
+{
+  CLUTTER_VIRTUAL_INPUT_EVENT_RELATIVE_MOTION,
+  CLUTTER_VIRTUAL_INPUT_EVENT_ABSOLUTE_MOTION,
+  CLUTTER_VIRTUAL_INPUT_EVENT_BUTTON,
+  CLUTTER_VIRTUAL_INPUT_EVENT_KEY,
+  CLUTTER_VIRTUAL_INPUT_EVENT_KEYVAL,
+  CLUTTER_VIRTUAL_INPUT_EVENT_DISCRETE_SCROLL,
+  CLUTTER_VIRTUAL_INPUT_EVENT_SCROLL_CONTINUOUS,
+  CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN,
+  CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION,
+  CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_UP,
+} ClutterVirtualInputEventType;
+
+/**
+ * ClutterVirtualInputEvent: (skip)
+ *
+ * A single event of a batch passed to
+ * [method@VirtualInputDevice.notify_events]. Only the member of the union
+ * matching @type is used.
+ */
+typedef struct _ClutterVirtualInputEvent
+{
+  ClutterVirtualInputEventType type;
+  uint64_t time_us;
+
+  union {
+    struct {
+      double x;
+      double y;
+    } motion;
+
+    struct {
+      uint32_t button;
+      ClutterButtonState button_state;
+    } button;
+
+    struct {
+      uint32_t key;
+      ClutterKeyState key_state;
+    } key;
+
+    struct {
+      ClutterScrollDirection direction;
+      ClutterScrollSource scroll_source;
+    } discrete_scroll;
+
+    struct {
+      double dx;
+      double dy;
+      ClutterScrollSource scroll_source;
+      ClutterScrollFinishFlags finish_flags;
+    } scroll;
+
+    struct {
+      int slot;
+      double x;
+      double y;
+    } touch;
+  };
+} ClutterVirtualInputEvent;
+
 struct _ClutterVirtualInputDeviceClass
 {
   GObjectClass parent_class;
@@ -105,6 +167,10 @@ struct _ClutterVirtualInputDeviceClass
   void (*notify_touch_up) (ClutterVirtualInputDevice *virtual_device,
                            uint64_t                   time_us,
                            int                        slot);
+
+  void (*notify_events) (ClutterVirtualInputDevice      *virtual_device,
+                         const ClutterVirtualInputEvent *events,
+                         size_t                          n_events);
 };
 
 CLUTTER_EXPORT
@@ -170,6 +236,11 @@ void clutter_virtual_input_device_notify_touch_up (ClutterVirtualInputDevice *vi
                                                    uint64_t                   time_us,
                                                    int                        slot);
 
+CLUTTER_EXPORT
+void clutter_virtual_input_device_notify_events (ClutterVirtualInputDevice      *virtual_device,
+                                                 const ClutterVirtualInputEvent *events,
+                                                 size_t                          n_events);
+
 CLUTTER_EXPORT
 int clutter_virtual_input_device_get_device_type (ClutterVirtualInputDevice *virtual_device);
 
@@ -150,6 +150,25 @@ cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *fm)
     _cogl_pango_renderer_get_use_mipmapping (COGL_PANGO_RENDERER (renderer));
 }
 
+void
+_cogl_pango_font_map_set_rasterizer_paused (CoglPangoFontMap *fm,
+                                            gboolean          paused)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  _cogl_pango_renderer_set_rasterizer_paused (COGL_PANGO_RENDERER (renderer),
+                                              paused);
+}
+
+unsigned int
+_cogl_pango_font_map_get_n_pending_glyphs (CoglPangoFontMap *fm)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  return
+    _cogl_pango_renderer_get_n_pending_glyphs (COGL_PANGO_RENDERER (renderer));
+}
+
 static GQuark
 cogl_pango_font_map_get_priv_key (void)
 {
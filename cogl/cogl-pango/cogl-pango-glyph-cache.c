@@ -31,10 +31,16 @@
 #include <glib.h>
 
 #include "cogl-pango/cogl-pango-glyph-cache.h"
+#include "cogl-pango/cogl-pango-glyph-rasterizer.h"
 #include "cogl-pango/cogl-pango-private.h"
 #include "cogl/cogl-atlas.h"
 #include "cogl/cogl-atlas-texture-private.h"
 
+/* Maximum number of pages of the glyph atlas. Once all of them are
+   full, the glyphs on the least recently used page are dropped to make
+   room */
+#define GLYPH_CACHE_MAX_ATLAS_PAGES 8
+
 typedef struct _CoglPangoGlyphCacheKey     CoglPangoGlyphCacheKey;
 
 struct _CoglPangoGlyphCache
@@ -45,8 +51,11 @@ struct _CoglPangoGlyphCache
      particular font is already cached */
   GHashTable       *hash_table;
 
-  /* List of CoglAtlases */
-  GSList           *atlases;
+  /* Paged atlases holding the glyphs, one for fonts with color glyphs
+     such as emoji. Glyphs only go in the global atlas when they don't
+     fit on a page */
+  CoglAtlas        *atlas;
+  CoglAtlas        *color_atlas;
 
   /* List of callbacks to invoke when an atlas is reorganized */
   GHookList         reorganize_callbacks;
@@ -56,9 +65,10 @@ struct _CoglPangoGlyphCache
      global atlas reorganizations */
   gboolean          using_global_atlas;
 
-  /* True if some of the glyphs are dirty. This is used as an
-     optimization in _cogl_pango_glyph_cache_set_dirty_glyphs to avoid
-     iterating the hash table if we know none of them are dirty */
+  /* True if some of the glyphs are dirty and haven't been handed to
+     the dirty func yet. This is used as an optimization in
+     _cogl_pango_glyph_cache_set_dirty_glyphs to avoid iterating the
+     hash table if we know none of them are dirty */
   gboolean          has_dirty_glyphs;
 
   /* Whether mipmapping is being used for this cache. This only
@@ -72,9 +82,17 @@ struct _CoglPangoGlyphCacheKey
   PangoGlyph  glyph;
 };
 
+typedef struct
+{
+  CoglPangoGlyphCacheDirtyFunc func;
+  void *user_data;
+} CoglPangoGlyphCacheDirtyData;
+
 static void
 cogl_pango_glyph_cache_value_free (CoglPangoGlyphCacheValue *value)
 {
+  if (value->rasterize_job)
+    _cogl_pango_glyph_rasterize_job_cancel (value->rasterize_job);
   if (value->texture)
     g_object_unref (value->texture);
   g_free (value);
@@ -133,7 +151,8 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
      (GDestroyNotify) cogl_pango_glyph_cache_key_free,
      (GDestroyNotify) cogl_pango_glyph_cache_value_free);
 
-  cache->atlases = NULL;
+  cache->atlas = NULL;
+  cache->color_atlas = NULL;
   g_hook_list_init (&cache->reorganize_callbacks, sizeof (GHook));
 
   cache->has_dirty_glyphs = FALSE;
@@ -145,20 +164,33 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
   return cache;
 }
 
+static gboolean
+cogl_pango_glyph_cache_value_is_evicted (void *key,
+                                         void *value,
+                                         void *user_data)
+{
+  return ((CoglPangoGlyphCacheValue *) value)->evicted;
+}
+
 static void
 cogl_pango_glyph_cache_reorganize_cb (void *user_data)
 {
   CoglPangoGlyphCache *cache = user_data;
 
+  /* Forget the glyphs whose atlas page got evicted so they are drawn
+     again the next time they are needed */
+  g_hash_table_foreach_remove (cache->hash_table,
+                               cogl_pango_glyph_cache_value_is_evicted,
+                               NULL);
+
   g_hook_list_invoke (&cache->reorganize_callbacks, FALSE);
 }
 
 void
 cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache)
 {
-  g_slist_foreach (cache->atlases, (GFunc) g_object_unref, NULL);
-  g_slist_free (cache->atlases);
-  cache->atlases = NULL;
+  g_clear_object (&cache->atlas);
+  g_clear_object (&cache->color_atlas);
   cache->has_dirty_glyphs = FALSE;
 
   g_hash_table_remove_all (cache->hash_table);
@@ -210,6 +242,16 @@ cogl_pango_glyph_cache_update_position_cb (void                        *user_dat
   value->dirty = TRUE;
 }
 
+static void
+cogl_pango_glyph_cache_evict_cb (void *user_data)
+{
+  CoglPangoGlyphCacheValue *value = user_data;
+
+  /* The value is removed from the hash table once the eviction is
+     done, see cogl_pango_glyph_cache_reorganize_cb() */
+  value->evicted = TRUE;
+}
+
 static gboolean
 cogl_pango_glyph_cache_add_to_global_atlas (CoglPangoGlyphCache *cache,
                                             PangoFont *font,
@@ -265,46 +307,43 @@ cogl_pango_glyph_cache_add_to_local_atlas (CoglPangoGlyphCache *cache,
                                            PangoGlyph glyph,
                                            CoglPangoGlyphCacheValue *value)
 {
-  CoglAtlas *atlas = NULL;
-  GSList *l;
-
-  /* Look for an atlas that can reserve the space */
-  for (l = cache->atlases; l; l = l->next)
-    if (_cogl_atlas_reserve_space (l->data,
-                                   value->draw_width + 1,
-                                   value->draw_height + 1,
-                                   value))
-      {
-        atlas = l->data;
-        break;
-      }
-
-  /* If we couldn't find one then start a new atlas */
-  if (atlas == NULL)
+  CoglAtlas **atlas;
+  CoglPixelFormat format;
+
+  /* Color glyphs would lose their colors in an alpha only texture, so
+     they get their own atlas in the same format as the global one */
+  if (_cogl_pango_font_has_color_glyphs (font))
+    {
+      atlas = &cache->color_atlas;
+      format = COGL_PIXEL_FORMAT_RGBA_8888;
+    }
+  else
+    {
+      atlas = &cache->atlas;
+      format = COGL_PIXEL_FORMAT_A_8;
+    }
+
+  if (*atlas == NULL)
     {
-      atlas = _cogl_atlas_new (COGL_PIXEL_FORMAT_A_8,
+      /* Adding pages instead of growing the atlas means the glyphs
+         already in it never have to be moved and drawn again */
+      *atlas =
+        _cogl_atlas_new_paged (format,
                                COGL_ATLAS_CLEAR_TEXTURE |
                                COGL_ATLAS_DISABLE_MIGRATION,
-                               cogl_pango_glyph_cache_update_position_cb);
-      COGL_NOTE (ATLAS, "Created new atlas for glyphs: %p", atlas);
-      /* If we still can't reserve space then something has gone
-         seriously wrong so we'll just give up */
-      if (!_cogl_atlas_reserve_space (atlas,
-                                      value->draw_width + 1,
-                                      value->draw_height + 1,
-                                      value))
-        {
-          g_object_unref (atlas);
-          return FALSE;
-        }
+                               GLYPH_CACHE_MAX_ATLAS_PAGES,
+                               cogl_pango_glyph_cache_update_position_cb,
+                               cogl_pango_glyph_cache_evict_cb);
+      COGL_NOTE (ATLAS, "Created new atlas for glyphs: %p", *atlas);
 
       _cogl_atlas_add_reorganize_callback
-        (atlas, cogl_pango_glyph_cache_reorganize_cb, NULL, cache);
-
-      cache->atlases = g_slist_prepend (cache->atlases, atlas);
+        (*atlas, NULL, cogl_pango_glyph_cache_reorganize_cb, cache);
     }
 
-  return TRUE;
+  return _cogl_atlas_reserve_space (*atlas,
+                                    value->draw_width + 1,
+                                    value->draw_height + 1,
+                                    value);
 }
 
 CoglPangoGlyphCacheValue *
@@ -321,6 +360,15 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
 
   value = g_hash_table_lookup (cache->hash_table, &lookup_key);
 
+  /* Keep the atlas page of glyphs still in use from being evicted */
+  if (value && value->texture)
+    {
+      if (cache->atlas)
+        _cogl_atlas_mark_texture_used (cache->atlas, value->texture);
+      if (cache->color_atlas)
+        _cogl_atlas_mark_texture_used (cache->color_atlas, value->texture);
+    }
+
   if (create && value == NULL)
     {
       CoglPangoGlyphCacheKey *key;
@@ -343,16 +391,17 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
         value->dirty = FALSE;
       else
         {
-          /* Try adding the glyph to the global atlas... */
-          if (!cogl_pango_glyph_cache_add_to_global_atlas (cache,
-                                                           font,
-                                                           glyph,
-                                                           value) &&
-              /* If it fails try the local atlas */
-              !cogl_pango_glyph_cache_add_to_local_atlas (cache,
+          /* Try adding the glyph to the paged atlas first, as the
+             global atlas grows by moving everything in it... */
+          if (!cogl_pango_glyph_cache_add_to_local_atlas (cache,
                                                           font,
                                                           glyph,
-                                                          value))
+                                                          value) &&
+              /* If it fails try the global atlas */
+              !cogl_pango_glyph_cache_add_to_global_atlas (cache,
+                                                           font,
+                                                           glyph,
+                                                           value))
             {
               cogl_pango_glyph_cache_value_free (value);
               return NULL;
@@ -379,28 +428,32 @@ _cogl_pango_glyph_cache_set_dirty_glyphs_cb (void *key_ptr,
 {
   CoglPangoGlyphCacheKey *key = key_ptr;
   CoglPangoGlyphCacheValue *value = value_ptr;
-  CoglPangoGlyphCacheDirtyFunc func = user_data;
+  CoglPangoGlyphCacheDirtyData *data = user_data;
 
+  /* The func is responsible for clearing the dirty flag once the
+     glyph is drawn, which may happen later in the background */
   if (value->dirty)
-    {
-      func (key->font, key->glyph, value);
-
-      value->dirty = FALSE;
-    }
+    data->func (key->font, key->glyph, value, data->user_data);
 }
 
 void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
-                                          CoglPangoGlyphCacheDirtyFunc func)
+                                          CoglPangoGlyphCacheDirtyFunc func,
+                                          void *user_data)
 {
+  CoglPangoGlyphCacheDirtyData data;
+
   /* If we know that there are no dirty glyphs then we can shortcut
      out early */
   if (!cache->has_dirty_glyphs)
     return;
 
+  data.func = func;
+  data.user_data = user_data;
+
   g_hash_table_foreach (cache->hash_table,
                         _cogl_pango_glyph_cache_set_dirty_glyphs_cb,
-                        func);
+                        &data);
 
   cache->has_dirty_glyphs = FALSE;
 }
@@ -37,6 +37,7 @@ G_BEGIN_DECLS
 
 typedef struct _CoglPangoGlyphCache      CoglPangoGlyphCache;
 typedef struct _CoglPangoGlyphCacheValue CoglPangoGlyphCacheValue;
+typedef struct _CoglPangoGlyphRasterizeJob CoglPangoGlyphRasterizeJob;
 
 struct _CoglPangoGlyphCacheValue
 {
@@ -55,16 +56,24 @@ struct _CoglPangoGlyphCacheValue
   int draw_width;
   int draw_height;
 
+  /* The pending job drawing the glyph in the background, if any */
+  CoglPangoGlyphRasterizeJob *rasterize_job;
+
   /* This will be set to TRUE when the glyph atlas is reorganized
-     which means the glyph will need to be redrawn */
+     which means the glyph will need to be redrawn. It stays set until
+     the drawn glyph has been copied to the texture */
   guint dirty : 1;
   /* Set to TRUE if the glyph has colors (eg. emoji) */
   guint has_color : 1;
+  /* Set to TRUE when the atlas page of the glyph is evicted, right
+     before the glyph is removed from the cache */
+  guint evicted : 1;
 };
 
 typedef void (* CoglPangoGlyphCacheDirtyFunc) (PangoFont *font,
                                                PangoGlyph glyph,
-                                               CoglPangoGlyphCacheValue *value);
+                                               CoglPangoGlyphCacheValue *value,
+                                               void *user_data);
 
 COGL_EXPORT CoglPangoGlyphCache *
 cogl_pango_glyph_cache_new (CoglContext *ctx,
@@ -94,6 +103,7 @@ _cogl_pango_glyph_cache_remove_reorganize_callback (CoglPangoGlyphCache *cache,
 
 void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
-                                          CoglPangoGlyphCacheDirtyFunc func);
+                                          CoglPangoGlyphCacheDirtyFunc func,
+                                          void *user_data);
 
 G_END_DECLS
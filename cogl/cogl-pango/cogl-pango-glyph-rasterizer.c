@@ -0,0 +1,481 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * The glyph rasterizer draws the glyphs of the glyph cache with cairo
+ * in a worker thread. Glyphs are queued as soon as a layout is made
+ * sure to be in the glyph cache, which usually happens when the layout
+ * is created, so by the time the layout is painted the glyphs are
+ * ready and all that's left is to copy them to their atlas. Glyphs
+ * which aren't ready yet when they are painted are drawn right away
+ * instead of showing a placeholder, stalling the paint.
+ */
+
+#include "config.h"
+
+#include <pango/pangocairo.h>
+#include <cairo.h>
+#include <cairo-ft.h>
+
+#include "cogl/cogl-debug.h"
+#include "cogl/cogl-texture-private.h"
+#include "cogl-pango/cogl-pango-glyph-rasterizer.h"
+
+typedef enum _CoglPangoGlyphRasterizeJobState
+{
+  COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED,
+  COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_RUNNING,
+  COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_DONE,
+  /* The job was taken over by the main thread or isn't needed anymore,
+     the worker thread skips it */
+  COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_STOLEN,
+} CoglPangoGlyphRasterizeJobState;
+
+struct _CoglPangoGlyphRasterizeJob
+{
+  CoglPangoGlyphRasterizer *rasterizer;
+
+  /* Only touched on the main thread. This is cleared when the glyph
+     is removed from the cache before its job is done */
+  CoglPangoGlyphCacheValue *value;
+
+  /* Everything below is set up before the job is queued and is only
+     read by the worker thread */
+  cairo_scaled_font_t *scaled_font;
+  PangoGlyph glyph;
+  int draw_x;
+  int draw_y;
+  int draw_width;
+  int draw_height;
+  cairo_format_t format_cairo;
+  CoglPixelFormat format_cogl;
+
+  /* Written by whoever runs the job */
+  cairo_surface_t *surface;
+  gboolean has_color;
+
+  /* Protected by the rasterizer mutex */
+  CoglPangoGlyphRasterizeJobState state;
+};
+
+struct _CoglPangoGlyphRasterizer
+{
+  GThreadPool *thread_pool;
+
+  GMutex mutex;
+  GCond cond;
+
+  /* Protected by the mutex, keeps the worker thread from picking up
+     jobs. Only used by tests */
+  gboolean paused;
+
+  /* Queued jobs that haven't been uploaded yet, owned by the main
+     thread */
+  GQueue jobs;
+
+  /* Statistics for debugging */
+  uint64_t n_glyphs_rasterized;
+  uint64_t n_glyphs_blocked;
+};
+
+static void
+cogl_pango_glyph_rasterize_job_free (CoglPangoGlyphRasterizeJob *job)
+{
+  g_clear_pointer (&job->surface, cairo_surface_destroy);
+  g_clear_pointer (&job->scaled_font, cairo_scaled_font_destroy);
+}
+
+static void
+cogl_pango_glyph_rasterize_job_unref (CoglPangoGlyphRasterizeJob *job)
+{
+  g_atomic_rc_box_release_full (job,
+                                (GDestroyNotify)
+                                cogl_pango_glyph_rasterize_job_free);
+}
+
+static gboolean
+scaled_font_has_color_glyphs (cairo_scaled_font_t *scaled_font)
+{
+  gboolean has_color = FALSE;
+
+  if (cairo_scaled_font_get_type (scaled_font) == CAIRO_FONT_TYPE_FT)
+    {
+      FT_Face ft_face = cairo_ft_scaled_font_lock_face (scaled_font);
+      has_color = (FT_HAS_COLOR (ft_face) != 0);
+      cairo_ft_scaled_font_unlock_face (scaled_font);
+    }
+
+  return has_color;
+}
+
+gboolean
+_cogl_pango_font_has_color_glyphs (PangoFont *font)
+{
+  cairo_scaled_font_t *scaled_font;
+
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+  if (!scaled_font)
+    return FALSE;
+
+  return scaled_font_has_color_glyphs (scaled_font);
+}
+
+static void
+cogl_pango_glyph_rasterize_job_run (CoglPangoGlyphRasterizeJob *job)
+{
+  cairo_t *cr;
+  cairo_glyph_t cairo_glyph;
+
+  job->surface = cairo_image_surface_create (job->format_cairo,
+                                             job->draw_width,
+                                             job->draw_height);
+  cr = cairo_create (job->surface);
+
+  cairo_set_scaled_font (cr, job->scaled_font);
+
+  cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0);
+
+  cairo_glyph.x = -job->draw_x;
+  cairo_glyph.y = -job->draw_y;
+  /* The PangoCairo glyph numbers directly map to Cairo glyph
+     numbers */
+  cairo_glyph.index = job->glyph;
+  cairo_show_glyphs (cr, &cairo_glyph, 1);
+
+  cairo_destroy (cr);
+  cairo_surface_flush (job->surface);
+
+  job->has_color = scaled_font_has_color_glyphs (job->scaled_font);
+}
+
+static void
+cogl_pango_glyph_rasterizer_thread_func (void *data,
+                                         void *user_data)
+{
+  CoglPangoGlyphRasterizeJob *job = data;
+  CoglPangoGlyphRasterizer *rasterizer = user_data;
+  gboolean run;
+
+  g_mutex_lock (&rasterizer->mutex);
+  while (rasterizer->paused)
+    g_cond_wait (&rasterizer->cond, &rasterizer->mutex);
+  run = job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED;
+  if (run)
+    job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_RUNNING;
+  g_mutex_unlock (&rasterizer->mutex);
+
+  if (run)
+    {
+      cogl_pango_glyph_rasterize_job_run (job);
+
+      g_mutex_lock (&rasterizer->mutex);
+      job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_DONE;
+      g_cond_broadcast (&rasterizer->cond);
+      g_mutex_unlock (&rasterizer->mutex);
+    }
+
+  cogl_pango_glyph_rasterize_job_unref (job);
+}
+
+CoglPangoGlyphRasterizer *
+_cogl_pango_glyph_rasterizer_new (void)
+{
+  CoglPangoGlyphRasterizer *rasterizer;
+
+  rasterizer = g_new0 (CoglPangoGlyphRasterizer, 1);
+
+  g_mutex_init (&rasterizer->mutex);
+  g_cond_init (&rasterizer->cond);
+  g_queue_init (&rasterizer->jobs);
+
+  /* A single thread is enough to stay ahead of painting, and it keeps
+     the glyphs coming in the order they were queued */
+  rasterizer->thread_pool =
+    g_thread_pool_new (cogl_pango_glyph_rasterizer_thread_func,
+                       rasterizer,
+                       1,
+                       FALSE,
+                       NULL);
+
+  return rasterizer;
+}
+
+static void
+cogl_pango_glyph_rasterize_job_forget (CoglPangoGlyphRasterizeJob *job)
+{
+  if (job->value)
+    {
+      job->value->rasterize_job = NULL;
+      job->value = NULL;
+    }
+
+  cogl_pango_glyph_rasterize_job_unref (job);
+}
+
+void
+_cogl_pango_glyph_rasterizer_free (CoglPangoGlyphRasterizer *rasterizer)
+{
+  CoglPangoGlyphRasterizeJob *job;
+  GList *l;
+
+  /* Make the worker thread skip whatever it didn't get to yet */
+  g_mutex_lock (&rasterizer->mutex);
+  rasterizer->paused = FALSE;
+  g_cond_broadcast (&rasterizer->cond);
+  for (l = rasterizer->jobs.head; l; l = l->next)
+    {
+      job = l->data;
+      if (job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED)
+        job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_STOLEN;
+    }
+  g_mutex_unlock (&rasterizer->mutex);
+
+  g_thread_pool_free (rasterizer->thread_pool, FALSE, TRUE);
+
+  while ((job = g_queue_pop_head (&rasterizer->jobs)))
+    cogl_pango_glyph_rasterize_job_forget (job);
+
+  COGL_NOTE (PANGO,
+             "Glyph rasterizer drew %" G_GUINT64_FORMAT " glyphs, "
+             "%" G_GUINT64_FORMAT " of them blocked painting",
+             rasterizer->n_glyphs_rasterized,
+             rasterizer->n_glyphs_blocked);
+
+  g_cond_clear (&rasterizer->cond);
+  g_mutex_clear (&rasterizer->mutex);
+
+  g_free (rasterizer);
+}
+
+void
+_cogl_pango_glyph_rasterizer_queue (CoglPangoGlyphRasterizer *rasterizer,
+                                    PangoFont                *font,
+                                    PangoGlyph                glyph,
+                                    CoglPangoGlyphCacheValue *value)
+{
+  CoglPangoGlyphRasterizeJob *job;
+  cairo_scaled_font_t *scaled_font;
+
+  /* Glyphs that don't take up any space will end up without a
+     texture. These should never become dirty so they shouldn't end up
+     here */
+  g_return_if_fail (value->texture != NULL);
+
+  /* Moving a glyph around in its atlas doesn't change how it looks, so
+     a glyph that's still being drawn just needs to be uploaded to
+     wherever it ends up */
+  if (value->rasterize_job)
+    return;
+
+  COGL_NOTE (PANGO, "queueing glyph %i", glyph);
+
+  job = g_atomic_rc_box_new0 (CoglPangoGlyphRasterizeJob);
+  job->rasterizer = rasterizer;
+  job->value = value;
+  job->glyph = glyph;
+  job->draw_x = value->draw_x;
+  job->draw_y = value->draw_y;
+  job->draw_width = value->draw_width;
+  job->draw_height = value->draw_height;
+  job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED;
+
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+  job->scaled_font = cairo_scaled_font_reference (scaled_font);
+
+  if (_cogl_texture_get_format (value->texture) == COGL_PIXEL_FORMAT_A_8)
+    {
+      job->format_cairo = CAIRO_FORMAT_A8;
+      job->format_cogl = COGL_PIXEL_FORMAT_A_8;
+    }
+  else
+    {
+      job->format_cairo = CAIRO_FORMAT_ARGB32;
+
+      /* Cairo stores the data in native byte order as ARGB but Cogl's
+         pixel formats specify the actual byte order. Therefore we
+         need to use a different format depending on the
+         architecture */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+      job->format_cogl = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
+#else
+      job->format_cogl = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
+#endif
+    }
+
+  value->rasterize_job = job;
+  g_queue_push_tail (&rasterizer->jobs, job);
+
+  g_thread_pool_push (rasterizer->thread_pool,
+                      g_atomic_rc_box_acquire (job),
+                      NULL);
+}
+
+static void
+cogl_pango_glyph_rasterizer_upload_job (CoglPangoGlyphRasterizer   *rasterizer,
+                                        CoglPangoGlyphRasterizeJob *job)
+{
+  CoglPangoGlyphCacheValue *value = job->value;
+
+  if (value)
+    {
+      /* Copy the glyph to the texture */
+      cogl_texture_set_region (value->texture,
+                               0, /* src_x */
+                               0, /* src_y */
+                               value->tx_pixel, /* dst_x */
+                               value->ty_pixel, /* dst_y */
+                               value->draw_width, /* dst_width */
+                               value->draw_height, /* dst_height */
+                               value->draw_width, /* width */
+                               value->draw_height, /* height */
+                               job->format_cogl,
+                               cairo_image_surface_get_stride (job->surface),
+                               cairo_image_surface_get_data (job->surface));
+
+      value->has_color = job->has_color;
+      value->dirty = FALSE;
+
+      rasterizer->n_glyphs_rasterized++;
+    }
+
+  cogl_pango_glyph_rasterize_job_forget (job);
+}
+
+void
+_cogl_pango_glyph_rasterizer_upload (CoglPangoGlyphRasterizer *rasterizer)
+{
+  GQueue done_jobs = G_QUEUE_INIT;
+  CoglPangoGlyphRasterizeJob *job;
+  GList *l, *next;
+
+  if (g_queue_is_empty (&rasterizer->jobs))
+    return;
+
+  g_mutex_lock (&rasterizer->mutex);
+  for (l = rasterizer->jobs.head; l; l = next)
+    {
+      next = l->next;
+      job = l->data;
+
+      /* Cancelled jobs have nothing to upload, just drop them */
+      if (job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_DONE ||
+          !job->value)
+        {
+          g_queue_unlink (&rasterizer->jobs, l);
+          g_queue_push_tail_link (&done_jobs, l);
+        }
+    }
+  g_mutex_unlock (&rasterizer->mutex);
+
+  if (g_queue_is_empty (&done_jobs))
+    return;
+
+  COGL_NOTE (PANGO, "uploading %u glyphs", done_jobs.length);
+
+  while ((job = g_queue_pop_head (&done_jobs)))
+    cogl_pango_glyph_rasterizer_upload_job (rasterizer, job);
+}
+
+void
+_cogl_pango_glyph_rasterize_job_finish (CoglPangoGlyphRasterizeJob *job)
+{
+  CoglPangoGlyphRasterizer *rasterizer = job->rasterizer;
+  gboolean run, blocked;
+
+  g_return_if_fail (job->value != NULL);
+
+  g_queue_remove (&rasterizer->jobs, job);
+
+  /* Draw the glyph ourselves if the worker thread didn't get to it yet,
+     or wait for it if it's drawing it right now */
+  g_mutex_lock (&rasterizer->mutex);
+  run = job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED;
+  blocked = job->state != COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_DONE;
+  if (run)
+    job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_STOLEN;
+  while (job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_RUNNING)
+    g_cond_wait (&rasterizer->cond, &rasterizer->mutex);
+  g_mutex_unlock (&rasterizer->mutex);
+
+  if (run)
+    cogl_pango_glyph_rasterize_job_run (job);
+
+  cogl_pango_glyph_rasterizer_upload_job (rasterizer, job);
+
+  if (blocked)
+    {
+      rasterizer->n_glyphs_blocked++;
+
+      COGL_NOTE (PANGO,
+                 "glyph cache miss blocked painting "
+                 "(%" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " so far)",
+                 rasterizer->n_glyphs_blocked,
+                 rasterizer->n_glyphs_rasterized);
+    }
+}
+
+void
+_cogl_pango_glyph_rasterizer_set_paused (CoglPangoGlyphRasterizer *rasterizer,
+                                         gboolean                  paused)
+{
+  g_mutex_lock (&rasterizer->mutex);
+  rasterizer->paused = paused;
+  g_cond_broadcast (&rasterizer->cond);
+  g_mutex_unlock (&rasterizer->mutex);
+}
+
+unsigned int
+_cogl_pango_glyph_rasterizer_get_n_pending_glyphs (CoglPangoGlyphRasterizer *rasterizer)
+{
+  unsigned int n_pending = 0;
+  GList *l;
+
+  for (l = rasterizer->jobs.head; l; l = l->next)
+    {
+      CoglPangoGlyphRasterizeJob *job = l->data;
+
+      if (job->value)
+        n_pending++;
+    }
+
+  return n_pending;
+}
+
+void
+_cogl_pango_glyph_rasterize_job_cancel (CoglPangoGlyphRasterizeJob *job)
+{
+  CoglPangoGlyphRasterizer *rasterizer = job->rasterizer;
+
+  job->value = NULL;
+
+  g_mutex_lock (&rasterizer->mutex);
+  if (job->state == COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_QUEUED)
+    job->state = COGL_PANGO_GLYPH_RASTERIZE_JOB_STATE_STOLEN;
+  g_mutex_unlock (&rasterizer->mutex);
+}
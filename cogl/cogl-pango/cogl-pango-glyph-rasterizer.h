@@ -0,0 +1,72 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <pango/pango-font.h>
+
+#include "cogl-pango/cogl-pango-glyph-cache.h"
+
+G_BEGIN_DECLS
+
+typedef struct _CoglPangoGlyphRasterizer CoglPangoGlyphRasterizer;
+
+CoglPangoGlyphRasterizer *
+_cogl_pango_glyph_rasterizer_new (void);
+
+void
+_cogl_pango_glyph_rasterizer_free (CoglPangoGlyphRasterizer *rasterizer);
+
+void
+_cogl_pango_glyph_rasterizer_queue (CoglPangoGlyphRasterizer *rasterizer,
+                                    PangoFont                *font,
+                                    PangoGlyph                glyph,
+                                    CoglPangoGlyphCacheValue *value);
+
+void
+_cogl_pango_glyph_rasterizer_upload (CoglPangoGlyphRasterizer *rasterizer);
+
+void
+_cogl_pango_glyph_rasterizer_set_paused (CoglPangoGlyphRasterizer *rasterizer,
+                                         gboolean                  paused);
+
+unsigned int
+_cogl_pango_glyph_rasterizer_get_n_pending_glyphs (CoglPangoGlyphRasterizer *rasterizer);
+
+void
+_cogl_pango_glyph_rasterize_job_finish (CoglPangoGlyphRasterizeJob *job);
+
+void
+_cogl_pango_glyph_rasterize_job_cancel (CoglPangoGlyphRasterizeJob *job);
+
+gboolean
+_cogl_pango_font_has_color_glyphs (PangoFont *font);
+
+G_END_DECLS
@@ -51,6 +51,13 @@ _cogl_pango_renderer_set_use_mipmapping (CoglPangoRenderer *renderer,
 gboolean
 _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer);
 
+void
+_cogl_pango_renderer_set_rasterizer_paused (CoglPangoRenderer *renderer,
+                                            gboolean           paused);
+
+unsigned int
+_cogl_pango_renderer_get_n_pending_glyphs (CoglPangoRenderer *renderer);
+
 
 
 CoglContext *
@@ -59,4 +66,11 @@ _cogl_pango_font_map_get_cogl_context (CoglPangoFontMap *fm);
 PangoRenderer *
 _cogl_pango_font_map_get_renderer (CoglPangoFontMap *fm);
 
+COGL_EXPORT_TEST void
+_cogl_pango_font_map_set_rasterizer_paused (CoglPangoFontMap *fm,
+                                            gboolean          paused);
+
+COGL_EXPORT_TEST unsigned int
+_cogl_pango_font_map_get_n_pending_glyphs (CoglPangoFontMap *fm);
+
 G_END_DECLS
@@ -38,14 +38,13 @@
 #include <pango/pango-fontmap.h>
 #include <pango/pangocairo.h>
 #include <pango/pango-renderer.h>
-#include <cairo.h>
-#include <cairo-ft.h>
 
 #include "cogl/cogl-debug.h"
 #include "cogl/cogl-context-private.h"
 #include "cogl/cogl-texture-private.h"
 #include "cogl-pango/cogl-pango-private.h"
 #include "cogl-pango/cogl-pango-glyph-cache.h"
+#include "cogl-pango/cogl-pango-glyph-rasterizer.h"
 #include "cogl-pango/cogl-pango-display-list.h"
 
 #define PANGO_UNKNOWN_GLYPH_WIDTH 10
@@ -78,6 +77,9 @@ struct _CoglPangoRenderer
 
   gboolean use_mipmapping;
 
+  /* Draws the dirty glyphs of both glyph caches in the background */
+  CoglPangoGlyphRasterizer *glyph_rasterizer;
+
   /* The current display list that is being built */
   CoglPangoDisplayList *display_list;
 };
@@ -223,6 +225,8 @@ _cogl_pango_renderer_constructed (GObject *gobject)
   renderer->mipmap_caches.glyph_cache =
     cogl_pango_glyph_cache_new (ctx, TRUE);
 
+  renderer->glyph_rasterizer = _cogl_pango_glyph_rasterizer_new ();
+
   _cogl_pango_renderer_set_use_mipmapping (renderer, FALSE);
 
   if (G_OBJECT_CLASS (cogl_pango_renderer_parent_class)->constructed)
@@ -291,6 +295,8 @@ cogl_pango_renderer_finalize (GObject *object)
   cogl_pango_glyph_cache_free (priv->no_mipmap_caches.glyph_cache);
   cogl_pango_glyph_cache_free (priv->mipmap_caches.glyph_cache);
 
+  _cogl_pango_glyph_rasterizer_free (priv->glyph_rasterizer);
+
   _cogl_pango_pipeline_cache_free (priv->no_mipmap_caches.pipeline_cache);
   _cogl_pango_pipeline_cache_free (priv->mipmap_caches.pipeline_cache);
 
@@ -372,6 +378,10 @@ cogl_pango_show_layout (CoglFramebuffer *fb,
   if (G_UNLIKELY (!priv))
     return;
 
+  /* Copy the glyphs drawn in the background since the last time text
+     was painted to their textures in one go */
+  _cogl_pango_glyph_rasterizer_upload (priv->glyph_rasterizer);
+
   qdata = g_object_get_qdata (G_OBJECT (layout),
                               cogl_pango_layout_get_qdata_key ());
 
@@ -500,6 +510,21 @@ _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer)
   return renderer->use_mipmapping;
 }
 
+void
+_cogl_pango_renderer_set_rasterizer_paused (CoglPangoRenderer *renderer,
+                                            gboolean           paused)
+{
+  _cogl_pango_glyph_rasterizer_set_paused (renderer->glyph_rasterizer,
+                                           paused);
+}
+
+unsigned int
+_cogl_pango_renderer_get_n_pending_glyphs (CoglPangoRenderer *renderer)
+{
+  return
+    _cogl_pango_glyph_rasterizer_get_n_pending_glyphs (renderer->glyph_rasterizer);
+}
+
 static CoglPangoGlyphCacheValue *
 cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                       gboolean       create,
@@ -515,100 +540,15 @@ cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                         create, font, glyph);
 }
 
-static gboolean
-font_has_color_glyphs (const PangoFont *font)
-{
-  cairo_scaled_font_t *scaled_font;
-  gboolean has_color = FALSE;
-
-  scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *) font);
-
-  if (cairo_scaled_font_get_type (scaled_font) == CAIRO_FONT_TYPE_FT)
-    {
-      FT_Face ft_face = cairo_ft_scaled_font_lock_face (scaled_font);
-      has_color = (FT_HAS_COLOR (ft_face) != 0);
-      cairo_ft_scaled_font_unlock_face (scaled_font);
-    }
-
-  return has_color;
-}
-
 static void
-cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
-                                     PangoGlyph glyph,
-                                     CoglPangoGlyphCacheValue *value)
+cogl_pango_renderer_queue_dirty_glyph (PangoFont                *font,
+                                       PangoGlyph                glyph,
+                                       CoglPangoGlyphCacheValue *value,
+                                       void                     *user_data)
 {
-  cairo_surface_t *surface;
-  cairo_t *cr;
-  cairo_scaled_font_t *scaled_font;
-  cairo_glyph_t cairo_glyph;
-  cairo_format_t format_cairo;
-  CoglPixelFormat format_cogl;
-
-  COGL_NOTE (PANGO, "redrawing glyph %i", glyph);
-
-  /* Glyphs that don't take up any space will end up without a
-     texture. These should never become dirty so they shouldn't end up
-     here */
-  g_return_if_fail (value->texture != NULL);
-
-  if (_cogl_texture_get_format (value->texture) == COGL_PIXEL_FORMAT_A_8)
-    {
-      format_cairo = CAIRO_FORMAT_A8;
-      format_cogl = COGL_PIXEL_FORMAT_A_8;
-    }
-  else
-    {
-      format_cairo = CAIRO_FORMAT_ARGB32;
-
-      /* Cairo stores the data in native byte order as ARGB but Cogl's
-         pixel formats specify the actual byte order. Therefore we
-         need to use a different format depending on the
-         architecture */
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-      format_cogl = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
-#else
-      format_cogl = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
-#endif
-    }
+  CoglPangoGlyphRasterizer *rasterizer = user_data;
 
-  surface = cairo_image_surface_create (format_cairo,
-                                        value->draw_width,
-                                        value->draw_height);
-  cr = cairo_create (surface);
-
-  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
-  cairo_set_scaled_font (cr, scaled_font);
-
-  cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0);
-
-  cairo_glyph.x = -value->draw_x;
-  cairo_glyph.y = -value->draw_y;
-  /* The PangoCairo glyph numbers directly map to Cairo glyph
-     numbers */
-  cairo_glyph.index = glyph;
-  cairo_show_glyphs (cr, &cairo_glyph, 1);
-
-  cairo_destroy (cr);
-  cairo_surface_flush (surface);
-
-  /* Copy the glyph to the texture */
-  cogl_texture_set_region (value->texture,
-                           0, /* src_x */
-                           0, /* src_y */
-                           value->tx_pixel, /* dst_x */
-                           value->ty_pixel, /* dst_y */
-                           value->draw_width, /* dst_width */
-                           value->draw_height, /* dst_height */
-                           value->draw_width, /* width */
-                           value->draw_height, /* height */
-                           format_cogl,
-                           cairo_image_surface_get_stride (surface),
-                           cairo_image_surface_get_data (surface));
-
-  cairo_surface_destroy (surface);
-
-  value->has_color = font_has_color_glyphs (font);
+  _cogl_pango_glyph_rasterizer_queue (rasterizer, font, glyph, value);
 }
 
 static void
@@ -649,9 +589,13 @@ static void
 _cogl_pango_set_dirty_glyphs (CoglPangoRenderer *priv)
 {
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (priv->mipmap_caches.glyph_cache,
+     cogl_pango_renderer_queue_dirty_glyph,
+     priv->glyph_rasterizer);
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->no_mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (priv->no_mipmap_caches.glyph_cache,
+     cogl_pango_renderer_queue_dirty_glyph,
+     priv->glyph_rasterizer);
 }
 
 static void
@@ -665,8 +609,8 @@ _cogl_pango_ensure_glyph_cache_for_layout_line (PangoLayoutLine *line)
 
   _cogl_pango_ensure_glyph_cache_for_layout_line_internal (line);
 
-  /* Now that we know all of the positions are settled we'll fill in
-     any dirty glyphs */
+  /* Now that we know all of the positions are settled we'll start
+     drawing any dirty glyphs */
   _cogl_pango_set_dirty_glyphs (priv);
 }
 
@@ -697,8 +641,8 @@ cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout)
 
   pango_layout_iter_free (iter);
 
-  /* Now that we know all of the positions are settled we'll fill in
-     any dirty glyphs */
+  /* Now that we know all of the positions are settled we'll start
+     drawing any dirty glyphs */
   _cogl_pango_set_dirty_glyphs (priv);
 }
 
@@ -875,6 +819,11 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
                                                   font,
                                                   gi->glyph);
 
+          /* Only wait for the glyphs actually drawn here if they're
+             still being drawn in the background */
+          if (cache_value && cache_value->rasterize_job)
+            _cogl_pango_glyph_rasterize_job_finish (cache_value->rasterize_job);
+
           /* cogl_pango_ensure_glyph_cache_for_layout should always be
              called before rendering a layout so we should never have
              a dirty glyph here */
@@ -121,6 +121,10 @@ cogl_pango_font_map_clear_glyph_cache (CoglPangoFontMap *font_map);
  *
  * This api should be used to avoid mid-scene modifications of
  * glyph-cache textures which can lead to undefined rendering results.
+ *
+ * Glyphs which aren't cached yet are drawn in a background thread, so
+ * calling this as soon as the layout is created gives them time to be
+ * ready by the time the layout is painted.
  */
 COGL_EXPORT void
 cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout);
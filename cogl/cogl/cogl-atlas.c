@@ -45,8 +45,28 @@
 
 #include <stdlib.h>
 
+/* Size of the pages of a paged atlas. Entries that don't fit in a
+   page of this size get a bigger page of their own */
+#define COGL_ATLAS_PAGE_SIZE 2048
+
+typedef struct _CoglAtlasPage
+{
+  CoglRectangleMap *map;
+  CoglTexture *texture;
+  /* Value of the atlas' page_age when the page was last used */
+  uint64_t age;
+} CoglAtlasPage;
+
 G_DEFINE_TYPE (CoglAtlas, cogl_atlas, G_TYPE_OBJECT);
 
+static void
+_cogl_atlas_page_free (CoglAtlasPage *page)
+{
+  _cogl_rectangle_map_free (page->map);
+  g_object_unref (page->texture);
+  g_free (page);
+}
+
 static void
 cogl_atlas_dispose (GObject *object)
 {
@@ -58,6 +78,7 @@ cogl_atlas_dispose (GObject *object)
     g_object_unref (atlas->texture);
   if (atlas->map)
     _cogl_rectangle_map_free (atlas->map);
+  g_clear_pointer (&atlas->pages, g_ptr_array_unref);
 
   g_hook_list_clear (&atlas->pre_reorganize_callbacks);
   g_hook_list_clear (&atlas->post_reorganize_callbacks);
@@ -96,6 +117,25 @@ _cogl_atlas_new (CoglPixelFormat                 texture_format,
   return atlas;
 }
 
+CoglAtlas *
+_cogl_atlas_new_paged (CoglPixelFormat                 texture_format,
+                       CoglAtlasFlags                  flags,
+                       unsigned int                    max_pages,
+                       CoglAtlasUpdatePositionCallback update_position_cb,
+                       CoglAtlasEvictCallback          evict_cb)
+{
+  CoglAtlas *atlas = _cogl_atlas_new (texture_format,
+                                      flags,
+                                      update_position_cb);
+
+  atlas->pages =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) _cogl_atlas_page_free);
+  atlas->max_pages = max_pages;
+  atlas->evict_cb = evict_cb;
+
+  return atlas;
+}
+
 typedef struct _CoglAtlasRepositionData
 {
   /* The current user data for this texture */
@@ -381,6 +421,187 @@ _cogl_atlas_notify_post_reorganize (CoglAtlas *atlas)
   g_hook_list_invoke (&atlas->post_reorganize_callbacks, FALSE);
 }
 
+static gboolean
+_cogl_atlas_get_page_size (CoglAtlas    *atlas,
+                           unsigned int  width,
+                           unsigned int  height,
+                           unsigned int *page_size)
+{
+  unsigned int size = COGL_ATLAS_PAGE_SIZE;
+  GLenum gl_intformat;
+  GLenum gl_format;
+  GLenum gl_type;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                          atlas->texture_format,
+                                          &gl_intformat,
+                                          &gl_format,
+                                          &gl_type);
+
+  while (size < width || size < height)
+    size <<= 1;
+
+  /* Some platforms might not support this large size so we'll
+     decrease the size for as long as the entry still fits */
+  while (!ctx->texture_driver->size_supported (ctx,
+                                               GL_TEXTURE_2D,
+                                               gl_intformat,
+                                               gl_format,
+                                               gl_type,
+                                               size, size))
+    {
+      if ((size >> 1) < width || (size >> 1) < height)
+        return FALSE;
+
+      size >>= 1;
+    }
+
+  *page_size = size;
+
+  return TRUE;
+}
+
+static CoglAtlasPage *
+_cogl_atlas_create_page (CoglAtlas    *atlas,
+                         unsigned int  width,
+                         unsigned int  height)
+{
+  CoglAtlasPage *page;
+  CoglTexture *texture;
+  unsigned int size;
+
+  if (!_cogl_atlas_get_page_size (atlas, width, height, &size))
+    return NULL;
+
+  texture = _cogl_atlas_create_texture (atlas, size, size);
+  if (texture == NULL)
+    return NULL;
+
+  page = g_new0 (CoglAtlasPage, 1);
+  page->map = _cogl_rectangle_map_new_skyline (size, size, NULL);
+  page->texture = texture;
+
+  COGL_NOTE (ATLAS, "%p: Added page %u with size %ux%u",
+             atlas, atlas->pages->len, size, size);
+
+  return page;
+}
+
+static gboolean
+_cogl_atlas_page_reserve_space (CoglAtlas     *atlas,
+                                CoglAtlasPage *page,
+                                unsigned int   width,
+                                unsigned int   height,
+                                void          *user_data)
+{
+  CoglRectangleMapEntry new_position;
+
+  if (!_cogl_rectangle_map_add (page->map, width, height,
+                                user_data,
+                                &new_position))
+    return FALSE;
+
+  page->age = ++atlas->page_age;
+
+  atlas->update_position_cb (user_data,
+                             page->texture,
+                             &new_position);
+
+  return TRUE;
+}
+
+static void
+_cogl_atlas_evict_cb (const CoglRectangleMapEntry *rectangle,
+                      void                        *rect_data,
+                      void                        *user_data)
+{
+  CoglAtlas *atlas = user_data;
+
+  atlas->evict_cb (rect_data);
+}
+
+static void
+_cogl_atlas_evict_page (CoglAtlas *atlas)
+{
+  CoglAtlasPage *page;
+  unsigned int lru_index = 0;
+  unsigned int i;
+
+  for (i = 1; i < atlas->pages->len; i++)
+    {
+      CoglAtlasPage *lru_page = g_ptr_array_index (atlas->pages, lru_index);
+
+      page = g_ptr_array_index (atlas->pages, i);
+      if (page->age < lru_page->age)
+        lru_index = i;
+    }
+
+  page = g_ptr_array_index (atlas->pages, lru_index);
+
+  COGL_NOTE (ATLAS, "%p: Evicting page %u with %u textures",
+             atlas, lru_index,
+             _cogl_rectangle_map_get_n_rectangles (page->map));
+
+  if (atlas->evict_cb)
+    _cogl_rectangle_map_foreach (page->map, _cogl_atlas_evict_cb, atlas);
+
+  g_ptr_array_remove_index (atlas->pages, lru_index);
+}
+
+static gboolean
+_cogl_atlas_reserve_space_paged (CoglAtlas    *atlas,
+                                 unsigned int  width,
+                                 unsigned int  height,
+                                 void         *user_data)
+{
+  CoglAtlasPage *page;
+  gboolean evict;
+  gboolean ret;
+  unsigned int i;
+
+  for (i = 0; i < atlas->pages->len; i++)
+    {
+      page = g_ptr_array_index (atlas->pages, i);
+
+      if (_cogl_atlas_page_reserve_space (atlas, page,
+                                          width, height,
+                                          user_data))
+        return TRUE;
+    }
+
+  /* None of the pages has room left, so we'll add another page
+     instead of reorganizing the existing ones. Only if that would
+     exceed the maximum number of pages, the entries of the least
+     recently used page are dropped to make room */
+  evict = atlas->max_pages > 0 && atlas->pages->len >= atlas->max_pages;
+  if (evict)
+    {
+      _cogl_atlas_notify_pre_reorganize (atlas);
+      _cogl_atlas_evict_page (atlas);
+    }
+
+  page = _cogl_atlas_create_page (atlas, width, height);
+  if (page)
+    {
+      g_ptr_array_add (atlas->pages, page);
+      ret = _cogl_atlas_page_reserve_space (atlas, page,
+                                            width, height,
+                                            user_data);
+    }
+  else
+    {
+      COGL_NOTE (ATLAS, "%p: Could not create a page for the texture", atlas);
+      ret = FALSE;
+    }
+
+  if (evict)
+    _cogl_atlas_notify_post_reorganize (atlas);
+
+  return ret;
+}
+
 gboolean
 _cogl_atlas_reserve_space (CoglAtlas             *atlas,
                            unsigned int           width,
@@ -394,6 +615,9 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
   gboolean ret;
   CoglRectangleMapEntry new_position;
 
+  if (atlas->pages)
+    return _cogl_atlas_reserve_space_paged (atlas, width, height, user_data);
+
   /* Check if we can fit the rectangle into the existing map */
   if (atlas->map &&
       _cogl_rectangle_map_add (atlas->map, width, height,
@@ -556,6 +780,9 @@ void
 _cogl_atlas_remove (CoglAtlas *atlas,
                     const CoglRectangleMapEntry *rectangle)
 {
+  /* The entries of paged atlases only go away by evicting their page */
+  g_return_if_fail (atlas->pages == NULL);
+
   _cogl_rectangle_map_remove (atlas->map, rectangle);
 
   COGL_NOTE (ATLAS, "%p: Removed rectangle sized %ix%i",
@@ -572,6 +799,36 @@ _cogl_atlas_remove (CoglAtlas *atlas,
                     _cogl_rectangle_map_get_height (atlas->map)));
 };
 
+void
+_cogl_atlas_mark_texture_used (CoglAtlas   *atlas,
+                               CoglTexture *texture)
+{
+  unsigned int i;
+
+  if (atlas->pages == NULL)
+    return;
+
+  for (i = 0; i < atlas->pages->len; i++)
+    {
+      CoglAtlasPage *page = g_ptr_array_index (atlas->pages, i);
+
+      if (page->texture == texture)
+        {
+          page->age = ++atlas->page_age;
+          return;
+        }
+    }
+}
+
+unsigned int
+_cogl_atlas_get_n_pages (CoglAtlas *atlas)
+{
+  if (atlas->pages)
+    return atlas->pages->len;
+
+  return atlas->texture ? 1 : 0;
+}
+
 static CoglTexture *
 create_migration_texture (CoglContext *ctx,
                           int width,
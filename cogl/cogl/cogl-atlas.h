@@ -36,6 +36,12 @@ typedef void
                                      CoglTexture *new_texture,
                                      const CoglRectangleMapEntry *rect);
 
+/* Called for every entry of a page of a paged atlas that is about to
+   be evicted. The entry's position in the atlas is no longer valid
+   afterwards */
+typedef void
+(* CoglAtlasEvictCallback) (void *user_data);
+
 typedef enum
 {
   COGL_ATLAS_CLEAR_TEXTURE     = (1 << 0),
@@ -67,6 +73,15 @@ struct _CoglAtlas
 
   GHookList pre_reorganize_callbacks;
   GHookList post_reorganize_callbacks;
+
+  /* Atlases created with _cogl_atlas_new_paged() never migrate
+     entries. Instead of map and texture they have a number of fixed
+     size pages, and once they have max_pages pages and none has room
+     left, the least recently used page is evicted */
+  GPtrArray *pages;
+  unsigned int max_pages;
+  uint64_t page_age;
+  CoglAtlasEvictCallback evict_cb;
 };
 
 COGL_EXPORT CoglAtlas *
@@ -74,6 +89,13 @@ _cogl_atlas_new (CoglPixelFormat texture_format,
                  CoglAtlasFlags flags,
                  CoglAtlasUpdatePositionCallback update_position_cb);
 
+COGL_EXPORT CoglAtlas *
+_cogl_atlas_new_paged (CoglPixelFormat texture_format,
+                       CoglAtlasFlags flags,
+                       unsigned int max_pages,
+                       CoglAtlasUpdatePositionCallback update_position_cb,
+                       CoglAtlasEvictCallback evict_cb);
+
 COGL_EXPORT gboolean
 _cogl_atlas_reserve_space (CoglAtlas             *atlas,
                            unsigned int           width,
@@ -84,6 +106,13 @@ void
 _cogl_atlas_remove (CoglAtlas *atlas,
                     const CoglRectangleMapEntry *rectangle);
 
+COGL_EXPORT void
+_cogl_atlas_mark_texture_used (CoglAtlas   *atlas,
+                               CoglTexture *texture);
+
+COGL_EXPORT unsigned int
+_cogl_atlas_get_n_pages (CoglAtlas *atlas);
+
 CoglTexture *
 _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
                             int x,
@@ -98,7 +127,7 @@ _cogl_atlas_add_reorganize_callback (CoglAtlas            *atlas,
                                      GHookFunc             post_callback,
                                      void                 *user_data);
 
-void
+COGL_EXPORT_TEST void
 _cogl_atlas_remove_reorganize_callback (CoglAtlas            *atlas,
                                         GHookFunc             pre_callback,
                                         GHookFunc             post_callback,
@@ -295,6 +295,36 @@ cogl_clip_stack_push_region (CoglClipStack *stack,
   return entry;
 }
 
+/* Returns a clip stack that clips to the @n-th rectangle of @region
+ * intersected with the parent of @region. Such a clip can always be
+ * flushed as a scissor. The returned stack is owned by @region. */
+CoglClipStack *
+_cogl_clip_stack_region_get_rectangle_clip (CoglClipStackRegion *region,
+                                            int                  n)
+{
+  CoglClipStack *entry = (CoglClipStack *) region;
+
+  if (!region->rectangle_clips)
+    {
+      region->rectangle_clips =
+        g_new0 (CoglClipStack *, mtk_region_num_rectangles (region->region));
+    }
+
+  if (!region->rectangle_clips[n])
+    {
+      g_autoptr (MtkRegion) rectangle_region = NULL;
+      MtkRectangle rectangle;
+
+      rectangle = mtk_region_get_rectangle (region->region, n);
+      rectangle_region = mtk_region_create_rectangle (&rectangle);
+      region->rectangle_clips[n] =
+        cogl_clip_stack_push_region (_cogl_clip_stack_ref (entry->parent),
+                                     rectangle_region);
+    }
+
+  return region->rectangle_clips[n];
+}
+
 CoglClipStack *
 _cogl_clip_stack_ref (CoglClipStack *entry)
 {
@@ -336,6 +366,17 @@ _cogl_clip_stack_unref (CoglClipStack *entry)
         case COGL_CLIP_STACK_REGION:
           {
             CoglClipStackRegion *region = (CoglClipStackRegion *) entry;
+
+            if (region->rectangle_clips)
+              {
+                int i, n_rectangles;
+
+                n_rectangles = mtk_region_num_rectangles (region->region);
+                for (i = 0; i < n_rectangles; i++)
+                  _cogl_clip_stack_unref (region->rectangle_clips[i]);
+                g_free (region->rectangle_clips);
+              }
+
             g_clear_pointer (&region->region, mtk_region_unref);
             g_free (entry);
             break;
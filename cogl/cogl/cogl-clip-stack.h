@@ -158,6 +158,11 @@ struct _CoglClipStackRegion
   CoglClipStack _parent_data;
 
   MtkRegion *region;
+
+  /* Lazily created single rectangle clips, one for each rectangle of
+     the region, that the journal uses to draw geometry it can't clip
+     in software with one scissored pass per rectangle */
+  CoglClipStack **rectangle_clips;
 };
 
 COGL_EXPORT CoglClipStack *
@@ -184,6 +189,10 @@ CoglClipStack *
 cogl_clip_stack_push_region (CoglClipStack *stack,
                              MtkRegion     *region);
 
+CoglClipStack *
+_cogl_clip_stack_region_get_rectangle_clip (CoglClipStackRegion *region,
+                                            int                  n);
+
 CoglClipStack *
 _cogl_clip_stack_pop (CoglClipStack *stack);
 
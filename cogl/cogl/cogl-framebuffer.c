@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "cogl/cogl-debug.h"
+#include "cogl/cogl-bitmap-private.h"
 #include "cogl/cogl-context-private.h"
 #include "cogl/cogl-display-private.h"
 #include "cogl/cogl-renderer-private.h"
@@ -46,6 +47,7 @@
 #include "cogl/cogl-pipeline-state-private.h"
 #include "cogl/cogl-primitive-private.h"
 #include "cogl/cogl-offscreen.h"
+#include "cogl/cogl-fence.h"
 #include "cogl/cogl1-context.h"
 #include "cogl/cogl-private.h"
 #include "cogl/cogl-primitives-private.h"
@@ -1553,6 +1555,168 @@ cogl_framebuffer_read_pixels (CoglFramebuffer *framebuffer,
   return ret;
 }
 
+typedef struct _CoglReadPixelsAsyncData
+{
+  CoglBitmap *bitmap;
+  gboolean needs_flip;
+} CoglReadPixelsAsyncData;
+
+static void
+read_pixels_async_data_free (CoglReadPixelsAsyncData *data)
+{
+  g_clear_object (&data->bitmap);
+  g_free (data);
+}
+
+static gboolean
+flip_bitmap_rows (CoglBitmap  *bitmap,
+                  GError     **error)
+{
+  int rowstride = cogl_bitmap_get_rowstride (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  g_autofree uint8_t *temprow = NULL;
+  uint8_t *pixels;
+  int y;
+
+  pixels = _cogl_bitmap_map (bitmap,
+                             COGL_BUFFER_ACCESS_READ |
+                             COGL_BUFFER_ACCESS_WRITE,
+                             0, /* hints */
+                             error);
+  if (!pixels)
+    return FALSE;
+
+  temprow = g_malloc (rowstride);
+
+  for (y = 0; y < height / 2; y++)
+    {
+      uint8_t *row = pixels + y * rowstride;
+      uint8_t *mirrored_row = pixels + (height - y - 1) * rowstride;
+
+      memcpy (temprow, row, rowstride);
+      memcpy (row, mirrored_row, rowstride);
+      memcpy (mirrored_row, temprow, rowstride);
+    }
+
+  _cogl_bitmap_unmap (bitmap);
+
+  return TRUE;
+}
+
+static void
+complete_read_pixels_async (GTask *task)
+{
+  CoglReadPixelsAsyncData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  if (data->needs_flip && !flip_bitmap_rows (data->bitmap, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_pointer (task, g_object_ref (data->bitmap), g_object_unref);
+}
+
+static void
+on_read_pixels_fence (CoglFence *fence,
+                      void      *user_data)
+{
+  g_autoptr (GTask) task = user_data;
+
+  complete_read_pixels_async (task);
+}
+
+void
+cogl_framebuffer_read_pixels_async (CoglFramebuffer     *framebuffer,
+                                    int                  x,
+                                    int                  y,
+                                    int                  width,
+                                    int                  height,
+                                    CoglPixelFormat      format,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+  CoglContext *ctx = priv->context;
+  g_autoptr (GTask) task = NULL;
+  CoglReadPixelsAsyncData *data;
+  CoglReadPixelsFlags flags = COGL_READ_PIXELS_COLOR_BUFFER;
+  gboolean use_fence;
+  GError *error = NULL;
+
+  g_return_if_fail (cogl_is_framebuffer (framebuffer));
+  g_return_if_fail (cogl_pixel_format_get_n_planes (format) == 1);
+
+  task = g_task_new (framebuffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cogl_framebuffer_read_pixels_async);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  /* Without pixel buffer objects glReadPixels() writes straight into
+   * client memory and has to wait for the GPU anyway */
+  use_fence = (_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_PBOS) &&
+               cogl_has_feature (ctx, COGL_FEATURE_ID_FENCE));
+
+  data = g_new0 (CoglReadPixelsAsyncData, 1);
+  data->bitmap = cogl_bitmap_new_with_size (ctx, width, height, format);
+  g_task_set_task_data (task, data,
+                        (GDestroyNotify) read_pixels_async_data_free);
+
+  /* Flipping the rows in place maps the buffer, which would wait for
+   * the read to finish, so leave it until the fence has signalled */
+  if (use_fence &&
+      !cogl_framebuffer_is_y_flipped (framebuffer) &&
+      !_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_MESA_PACK_INVERT))
+    {
+      flags |= COGL_READ_PIXELS_NO_FLIP;
+      data->needs_flip = TRUE;
+    }
+
+  if (!_cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                  x, y,
+                                                  flags,
+                                                  data->bitmap,
+                                                  &error))
+    {
+      if (error)
+        g_task_return_error (task, error);
+      else
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                 "Failed to read pixels");
+      return;
+    }
+
+  if (use_fence &&
+      cogl_framebuffer_add_fence_callback (framebuffer,
+                                           on_read_pixels_fence,
+                                           task))
+    {
+      g_steal_pointer (&task);
+      return;
+    }
+
+  complete_read_pixels_async (task);
+}
+
+CoglBitmap *
+cogl_framebuffer_read_pixels_finish (CoglFramebuffer  *framebuffer,
+                                     GAsyncResult     *result,
+                                     GError          **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, framebuffer), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        cogl_framebuffer_read_pixels_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 gboolean
 cogl_framebuffer_is_y_flipped (CoglFramebuffer *framebuffer)
 {
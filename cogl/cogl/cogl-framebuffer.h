@@ -40,6 +40,7 @@
 #include "cogl/cogl-texture.h"
 #include "mtk/mtk.h"
 
+#include <gio/gio.h>
 #include <glib-object.h>
 
 #include <graphene.h>
@@ -1266,6 +1267,61 @@ cogl_framebuffer_read_pixels (CoglFramebuffer *framebuffer,
                               CoglPixelFormat format,
                               uint8_t *pixels);
 
+/**
+ * cogl_framebuffer_read_pixels_async:
+ * @framebuffer: A #CoglFramebuffer
+ * @x: The x position to read from
+ * @y: The y position to read from
+ * @width: The width of the region of rectangles to read
+ * @height: The height of the region of rectangles to read
+ * @format: The pixel format to store the data in
+ * @cancellable: (nullable): A #GCancellable
+ * @callback: The callback to call when the pixels are available
+ * @user_data: The data to pass to @callback
+ *
+ * Asynchronous variant of cogl_framebuffer_read_pixels(). The read is
+ * issued into a pixel buffer object and @callback is called from the
+ * main loop once a fence placed after it has been signalled, so the
+ * caller doesn't wait for the GPU to finish rendering.
+ *
+ * Reading in a premultiplied format with the same layout as the
+ * framebuffer avoids any conversion. Other formats are still read
+ * correctly, but the conversion happens when the read is issued and
+ * blocks like cogl_framebuffer_read_pixels() does.
+ *
+ * If fences or pixel buffer objects aren't available the pixels are
+ * read synchronously and @callback is called from an idle.
+ */
+COGL_EXPORT void
+cogl_framebuffer_read_pixels_async (CoglFramebuffer     *framebuffer,
+                                    int                  x,
+                                    int                  y,
+                                    int                  width,
+                                    int                  height,
+                                    CoglPixelFormat      format,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data);
+
+/**
+ * cogl_framebuffer_read_pixels_finish:
+ * @framebuffer: A #CoglFramebuffer
+ * @result: The #GAsyncResult passed to the callback
+ * @error: Return location for a #GError
+ *
+ * Finishes a read started with cogl_framebuffer_read_pixels_async().
+ *
+ * The pixels are stored in the #CoglPixelBuffer of the returned bitmap
+ * with the rows ordered top to bottom. Map it with cogl_buffer_map() to
+ * access them without a further copy.
+ *
+ * Returns: (transfer full): A #CoglBitmap, or %NULL on error
+ */
+COGL_EXPORT CoglBitmap *
+cogl_framebuffer_read_pixels_finish (CoglFramebuffer  *framebuffer,
+                                     GAsyncResult     *result,
+                                     GError          **error);
+
 COGL_EXPORT uint32_t
 cogl_framebuffer_error_quark (void);
 
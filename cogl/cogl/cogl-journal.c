@@ -96,6 +96,10 @@
    worth doing software clipping and it's cheaper to program the GPU
    to do the clip */
 #define COGL_JOURNAL_HARDWARE_CLIP_THRESHOLD 8
+/* The number of scissored passes a quad that can't be clipped to a
+   region in software may take before the region is stencilled
+   instead */
+#define COGL_JOURNAL_MAX_SCISSOR_CLIP_PASSES 8
 
 typedef struct _CoglJournalFlushState
 {
@@ -444,11 +448,7 @@ compare_entry_pipelines (CoglJournalEntry *entry0, CoglJournalEntry *entry1)
 {
   /* batch rectangles using compatible pipelines */
 
-  if (_cogl_pipeline_equal (entry0->pipeline,
-                            entry1->pipeline,
-                            (COGL_PIPELINE_STATE_ALL &
-                             ~COGL_PIPELINE_STATE_COLOR),
-                            COGL_PIPELINE_LAYER_STATE_ALL))
+  if (_cogl_pipeline_journal_equal (entry0->pipeline, entry1->pipeline))
     return TRUE;
   else
     return FALSE;
@@ -1509,14 +1509,14 @@ add_framebuffer_deps_cb (CoglPipelineLayer *layer, void *user_data)
   return TRUE;
 }
 
-void
-_cogl_journal_log_quad (CoglJournal  *journal,
-                        const float  *position,
-                        CoglPipeline *pipeline,
-                        int           n_layers,
-                        CoglTexture  *layer0_override_texture,
-                        const float  *tex_coords,
-                        unsigned int  tex_coords_len)
+static void
+log_quad_with_clip_stack (CoglJournal   *journal,
+                          const float   *position,
+                          CoglPipeline  *pipeline,
+                          int            n_layers,
+                          CoglTexture   *layer0_override_texture,
+                          const float   *tex_coords,
+                          CoglClipStack *clip_stack)
 {
   CoglFramebuffer *framebuffer = journal->framebuffer;
   size_t stride;
@@ -1527,16 +1527,8 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   uint32_t disable_layers;
   CoglJournalEntry *entry;
   CoglPipeline *final_pipeline;
-  CoglClipStack *clip_stack;
   CoglPipelineFlushOptions flush_options;
   CoglMatrixStack *modelview_stack;
-  COGL_STATIC_TIMER (log_timer,
-                     "Mainloop", /* parent */
-                     "Journal Log",
-                     "The time spent logging in the Cogl journal",
-                     0 /* no application private data */);
-
-  COGL_TIMER_START (_cogl_uprof_context, log_timer);
 
   /* The vertex data is logged into a separate array. The data needs
      to be copied into a vertex array before it's given to GL so we
@@ -1615,7 +1607,6 @@ _cogl_journal_log_quad (CoglJournal  *journal,
 
   entry->pipeline = _cogl_pipeline_journal_ref (final_pipeline);
 
-  clip_stack = _cogl_framebuffer_get_clip_stack (framebuffer);
   entry->clip_stack = _cogl_clip_stack_ref (clip_stack);
   entry->dither_enabled = cogl_framebuffer_get_dither_enabled (framebuffer);
 
@@ -1627,63 +1618,40 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   modelview_stack =
     _cogl_framebuffer_get_modelview_stack (framebuffer);
   entry->modelview_entry = cogl_matrix_entry_ref (modelview_stack->last_entry);
-
-  _cogl_pipeline_foreach_layer_internal (pipeline,
-                                         add_framebuffer_deps_cb,
-                                         framebuffer);
-
-  if (COGL_IS_OFFSCREEN (framebuffer))
-    {
-      CoglOffscreen *offscreen = COGL_OFFSCREEN (framebuffer);
-      CoglTexture *texture = cogl_offscreen_get_texture (offscreen);
-
-      _cogl_texture_2d_externally_modified (texture);
-    }
-
-  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_SYNC_PRIMITIVE)))
-    {
-      _cogl_journal_flush (journal);
-      cogl_framebuffer_finish (framebuffer);
-    }
-  else if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING)))
-    {
-      _cogl_journal_flush (journal);
-    }
-
-  COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
 }
 
 static void
-entry_to_screen_polygon (CoglFramebuffer *framebuffer,
-                         const CoglJournalEntry *entry,
-                         float *vertices,
-                         float *poly)
+quad_to_screen_polygon (CoglFramebuffer *framebuffer,
+                        CoglMatrixEntry *modelview_entry,
+                        const float     *viewport,
+                        float            x_1,
+                        float            y_1,
+                        float            x_2,
+                        float            y_2,
+                        float           *poly)
 {
-  size_t array_stride =
-    GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
   CoglMatrixStack *projection_stack;
   graphene_matrix_t projection;
   graphene_matrix_t modelview;
   int i;
-  const float *viewport = entry->viewport;
 
-  poly[0] = vertices[0];
-  poly[1] = vertices[1];
+  poly[0] = x_1;
+  poly[1] = y_1;
   poly[2] = 0;
   poly[3] = 1;
 
-  poly[4] = vertices[0];
-  poly[5] = vertices[array_stride + 1];
+  poly[4] = x_1;
+  poly[5] = y_2;
   poly[6] = 0;
   poly[7] = 1;
 
-  poly[8] = vertices[array_stride];
-  poly[9] = vertices[array_stride + 1];
+  poly[8] = x_2;
+  poly[9] = y_2;
   poly[10] = 0;
   poly[11] = 1;
 
-  poly[12] = vertices[array_stride];
-  poly[13] = vertices[1];
+  poly[12] = x_2;
+  poly[13] = y_1;
   poly[14] = 0;
   poly[15] = 1;
 
@@ -1691,7 +1659,7 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
    * _cogl_transform_points utility...
    */
 
-  cogl_matrix_entry_get (entry->modelview_entry, &modelview);
+  cogl_matrix_entry_get (modelview_entry, &modelview);
   cogl_graphene_matrix_transform_points (&modelview,
                                          2, /* n_components */
                                          sizeof (float) * 4, /* stride_in */
@@ -1745,6 +1713,281 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
 #undef VIEWPORT_TRANSFORM_Y
 }
 
+static gboolean
+log_quad_clipped_to_region (CoglJournal         *journal,
+                            const float         *position,
+                            CoglPipeline        *pipeline,
+                            int                  n_layers,
+                            CoglTexture         *layer0_override_texture,
+                            const float         *tex_coords,
+                            CoglClipStackRegion *region_entry)
+{
+  CoglFramebuffer *framebuffer = journal->framebuffer;
+  CoglClipStack *clip_stack = (CoglClipStack *) region_entry;
+  MtkRegion *region = region_entry->region;
+  const float epsilon = 0.001f;
+  CoglMatrixStack *modelview_stack;
+  float viewport[4];
+  float poly[16];
+  float *sub_tex_coords;
+  float x_1, y_1, x_2, y_2;
+  int n_rectangles, n_passes;
+  int i, j;
+
+  modelview_stack = _cogl_framebuffer_get_modelview_stack (framebuffer);
+  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
+
+  quad_to_screen_polygon (framebuffer,
+                          modelview_stack->last_entry,
+                          viewport,
+                          position[0], position[1],
+                          position[2], position[3],
+                          poly);
+
+  /* Geometry crossing the w = 0 plane can't be bounded in window
+     coordinates so leave it to the stencil buffer */
+  for (i = 0; i < 4; i++)
+    {
+      if (poly[4 * i + 3] <= 0.0f)
+        return FALSE;
+    }
+
+  x_1 = MIN (MIN (poly[0], poly[4]), MIN (poly[8], poly[12]));
+  y_1 = MIN (MIN (poly[1], poly[5]), MIN (poly[9], poly[13]));
+  x_2 = MAX (MAX (poly[0], poly[4]), MAX (poly[8], poly[12]));
+  y_2 = MAX (MAX (poly[1], poly[5]), MAX (poly[9], poly[13]));
+
+  /* Anything outside of the region's extents wouldn't be drawn anyway */
+  if (x_1 >= clip_stack->bounds_x1 ||
+      x_2 <= clip_stack->bounds_x0 ||
+      y_1 >= clip_stack->bounds_y1 ||
+      y_2 <= clip_stack->bounds_y0)
+    return TRUE;
+
+  n_rectangles = mtk_region_num_rectangles (region);
+
+  /* If the local x axis maps to the window x axis and the local y
+     axis to the window y axis then the quad can be cut into one piece
+     per rectangle of the region on the CPU. The corners are (x1, y1),
+     (x1, y2), (x2, y2) and (x2, y1) */
+  if (fabsf (poly[0] - poly[4]) < epsilon &&
+      fabsf (poly[8] - poly[12]) < epsilon &&
+      fabsf (poly[1] - poly[13]) < epsilon &&
+      fabsf (poly[5] - poly[9]) < epsilon &&
+      fabsf (poly[3] - poly[7]) < epsilon &&
+      fabsf (poly[3] - poly[11]) < epsilon &&
+      fabsf (poly[3] - poly[15]) < epsilon &&
+      fabsf (poly[12] - poly[0]) >= epsilon &&
+      fabsf (poly[5] - poly[1]) >= epsilon)
+    {
+      float window_x_1 = poly[0], window_x_2 = poly[12];
+      float window_y_1 = poly[1], window_y_2 = poly[5];
+
+      sub_tex_coords = g_newa (float, n_layers * 4);
+
+      for (i = 0; i < n_rectangles; i++)
+        {
+          MtkRectangle rect = mtk_region_get_rectangle (region, i);
+          float sub_position[4];
+          float clip_x_1, clip_y_1, clip_x_2, clip_y_2;
+          float fx_1, fy_1, fx_2, fy_2;
+
+          clip_x_1 = MAX (x_1, rect.x);
+          clip_y_1 = MAX (y_1, rect.y);
+          clip_x_2 = MIN (x_2, rect.x + rect.width);
+          clip_y_2 = MIN (y_2, rect.y + rect.height);
+
+          if (clip_x_1 >= clip_x_2 || clip_y_1 >= clip_y_2)
+            continue;
+
+          /* Map the clipped window rectangle back to a fraction of the
+             quad, keeping the corner order of the original quad in
+             case the transform mirrors it */
+          if (window_x_1 > window_x_2)
+            {
+              float tmp = clip_x_1;
+
+              clip_x_1 = clip_x_2;
+              clip_x_2 = tmp;
+            }
+          if (window_y_1 > window_y_2)
+            {
+              float tmp = clip_y_1;
+
+              clip_y_1 = clip_y_2;
+              clip_y_2 = tmp;
+            }
+
+          fx_1 = (clip_x_1 - window_x_1) / (window_x_2 - window_x_1);
+          fx_2 = (clip_x_2 - window_x_1) / (window_x_2 - window_x_1);
+          fy_1 = (clip_y_1 - window_y_1) / (window_y_2 - window_y_1);
+          fy_2 = (clip_y_2 - window_y_1) / (window_y_2 - window_y_1);
+
+#define LERP(a, b, t) ((a) + ((b) - (a)) * (t))
+
+          sub_position[0] = LERP (position[0], position[2], fx_1);
+          sub_position[1] = LERP (position[1], position[3], fy_1);
+          sub_position[2] = LERP (position[0], position[2], fx_2);
+          sub_position[3] = LERP (position[1], position[3], fy_2);
+
+          for (j = 0; j < n_layers; j++)
+            {
+              const float *t = tex_coords + j * 4;
+              float *sub_t = sub_tex_coords + j * 4;
+
+              sub_t[0] = LERP (t[0], t[2], fx_1);
+              sub_t[1] = LERP (t[1], t[3], fy_1);
+              sub_t[2] = LERP (t[0], t[2], fx_2);
+              sub_t[3] = LERP (t[1], t[3], fy_2);
+            }
+
+#undef LERP
+
+          log_quad_with_clip_stack (journal,
+                                    sub_position,
+                                    pipeline,
+                                    n_layers,
+                                    layer0_override_texture,
+                                    sub_tex_coords,
+                                    clip_stack->parent);
+        }
+
+      return TRUE;
+    }
+
+  /* Otherwise draw the quad once for each rectangle it touches with
+     that rectangle as a scissor, as long as that doesn't take more
+     passes than stencilling the region would cost */
+  n_passes = 0;
+  for (i = 0; i < n_rectangles; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+
+      if (x_1 < rect.x + rect.width && x_2 > rect.x &&
+          y_1 < rect.y + rect.height && y_2 > rect.y)
+        n_passes++;
+    }
+
+  if (n_passes > COGL_JOURNAL_MAX_SCISSOR_CLIP_PASSES)
+    return FALSE;
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+
+      if (x_1 >= rect.x + rect.width || x_2 <= rect.x ||
+          y_1 >= rect.y + rect.height || y_2 <= rect.y)
+        continue;
+
+      log_quad_with_clip_stack (journal,
+                                position,
+                                pipeline,
+                                n_layers,
+                                layer0_override_texture,
+                                tex_coords,
+                                _cogl_clip_stack_region_get_rectangle_clip (region_entry,
+                                                                            i));
+    }
+
+  return TRUE;
+}
+
+void
+_cogl_journal_log_quad (CoglJournal  *journal,
+                        const float  *position,
+                        CoglPipeline *pipeline,
+                        int           n_layers,
+                        CoglTexture  *layer0_override_texture,
+                        const float  *tex_coords,
+                        unsigned int  tex_coords_len)
+{
+  CoglFramebuffer *framebuffer = journal->framebuffer;
+  CoglClipStack *clip_stack;
+  gboolean logged = FALSE;
+  COGL_STATIC_TIMER (log_timer,
+                     "Mainloop", /* parent */
+                     "Journal Log",
+                     "The time spent logging in the Cogl journal",
+                     0 /* no application private data */);
+
+  COGL_TIMER_START (_cogl_uprof_context, log_timer);
+
+  clip_stack = _cogl_framebuffer_get_clip_stack (framebuffer);
+
+  /* A region clip with more than one rectangle would need the stencil
+     buffer, which means drawing every rectangle of the region into it
+     before the quad can be drawn. Clipping the quad to the rectangles
+     instead only touches the pixels that are actually drawn. */
+  if (clip_stack &&
+      clip_stack->type == COGL_CLIP_STACK_REGION &&
+      mtk_region_num_rectangles (((CoglClipStackRegion *) clip_stack)->region) > 1 &&
+      G_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_CLIP)) &&
+      G_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_STENCILLING)))
+    {
+      logged = log_quad_clipped_to_region (journal,
+                                           position,
+                                           pipeline,
+                                           n_layers,
+                                           layer0_override_texture,
+                                           tex_coords,
+                                           (CoglClipStackRegion *) clip_stack);
+    }
+
+  if (!logged)
+    {
+      log_quad_with_clip_stack (journal,
+                                position,
+                                pipeline,
+                                n_layers,
+                                layer0_override_texture,
+                                tex_coords,
+                                clip_stack);
+    }
+
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         add_framebuffer_deps_cb,
+                                         framebuffer);
+
+  if (COGL_IS_OFFSCREEN (framebuffer))
+    {
+      CoglOffscreen *offscreen = COGL_OFFSCREEN (framebuffer);
+      CoglTexture *texture = cogl_offscreen_get_texture (offscreen);
+
+      _cogl_texture_2d_externally_modified (texture);
+    }
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_SYNC_PRIMITIVE)))
+    {
+      _cogl_journal_flush (journal);
+      cogl_framebuffer_finish (framebuffer);
+    }
+  else if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING)))
+    {
+      _cogl_journal_flush (journal);
+    }
+
+  COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
+}
+
+static void
+entry_to_screen_polygon (CoglFramebuffer *framebuffer,
+                         const CoglJournalEntry *entry,
+                         float *vertices,
+                         float *poly)
+{
+  size_t array_stride =
+    GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
+
+  quad_to_screen_polygon (framebuffer,
+                          entry->modelview_entry,
+                          entry->viewport,
+                          vertices[0],
+                          vertices[1],
+                          vertices[array_stride],
+                          vertices[array_stride + 1],
+                          poly);
+}
+
 static gboolean
 try_checking_point_hits_entry_after_clipping (CoglFramebuffer *framebuffer,
                                               CoglJournalEntry *entry,
@@ -290,6 +290,15 @@ struct _CoglPipeline
    * depends on the old state. */
   unsigned int age;
 
+  /* A digest of the state the journal compares when batching entries,
+   * which is only valid while journal_digest_age matches age.
+   * Pipelines that have been found to have equal state share the same
+   * journal_state_serial so that they can be compared again without
+   * looking at their state. */
+  unsigned int journal_digest;
+  unsigned int journal_digest_age;
+  uint64_t journal_state_serial;
+
   /* This is the primary color of the pipeline.
    *
    * This is a sparse property, ref COGL_PIPELINE_STATE_COLOR */
@@ -353,6 +362,9 @@ struct _CoglPipeline
 
   unsigned int          layers_cache_dirty:1;
 
+  /* Determines if ->journal_digest has ever been calculated */
+  unsigned int          has_journal_digest:1;
+
   /* Debugging, only used when defined(COGL_ENABLE_DEBUG) */
 
   /* For debugging purposes it's possible to associate a static const
@@ -684,6 +696,7 @@ unsigned long
 _cogl_pipeline_compare_differences (CoglPipeline *pipeline0,
                                     CoglPipeline *pipeline1);
 
+COGL_EXPORT_TEST
 gboolean
 _cogl_pipeline_equal (CoglPipeline *pipeline0,
                       CoglPipeline *pipeline1,
@@ -695,6 +708,17 @@ _cogl_pipeline_hash (CoglPipeline *pipeline,
                      unsigned int differences,
                      unsigned long layer_differences);
 
+/*
+ * Compares all the state of two pipelines the journal can't batch
+ * across, which is everything but the color. The result is the same
+ * as _cogl_pipeline_equal() but the comparison is done with cached
+ * digests of the state whenever possible.
+ */
+COGL_EXPORT_TEST
+gboolean
+_cogl_pipeline_journal_equal (CoglPipeline *pipeline0,
+                              CoglPipeline *pipeline1);
+
 /* Makes a copy of the given pipeline that is a child of the root
  * pipeline rather than a child of the source pipeline. That way the
  * new pipeline won't hold a reference to the source pipeline. The
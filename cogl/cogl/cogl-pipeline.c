@@ -2205,6 +2205,83 @@ _cogl_pipeline_update_authority (CoglPipeline *pipeline,
     }
 }
 
+#define JOURNAL_DIGEST_STATE \
+  (COGL_PIPELINE_STATE_ALL & ~(COGL_PIPELINE_STATE_COLOR | \
+                               COGL_PIPELINE_STATE_REAL_BLEND_ENABLE))
+
+static void
+_cogl_pipeline_update_journal_digest (CoglPipeline *pipeline)
+{
+  static uint64_t next_state_serial = 1;
+  CoglPipeline *parent;
+
+  /* Any state change bumps the age, and descendants never see changes
+   * to their ancestors because those are copied on write, so the age
+   * is all that's needed to know whether the digest is stale */
+  if (pipeline->has_journal_digest &&
+      pipeline->journal_digest_age == pipeline->age)
+    return;
+
+  /* Derived pipelines that only differ from their parent in state the
+   * journal doesn't compare, typically the color, have the same digest
+   * and are known to be equal to it */
+  parent = _cogl_pipeline_get_parent (pipeline);
+  if (parent && (pipeline->differences & JOURNAL_DIGEST_STATE) == 0)
+    {
+      _cogl_pipeline_update_journal_digest (parent);
+
+      pipeline->journal_digest = parent->journal_digest;
+      pipeline->journal_digest_age = pipeline->age;
+      pipeline->journal_state_serial = parent->journal_state_serial;
+      pipeline->has_journal_digest = TRUE;
+      return;
+    }
+
+  pipeline->journal_digest = _cogl_pipeline_hash (pipeline,
+                                                  JOURNAL_DIGEST_STATE,
+                                                  COGL_PIPELINE_LAYER_STATE_ALL);
+  pipeline->journal_digest_age = pipeline->age;
+  pipeline->journal_state_serial = next_state_serial++;
+  pipeline->has_journal_digest = TRUE;
+}
+
+gboolean
+_cogl_pipeline_journal_equal (CoglPipeline *pipeline0,
+                              CoglPipeline *pipeline1)
+{
+  if (pipeline0 == pipeline1)
+    return TRUE;
+
+  /* The blend enable is derived lazily without bumping the age so it
+   * is compared separately from the digest */
+  _cogl_pipeline_update_real_blend_enable (pipeline0, FALSE);
+  _cogl_pipeline_update_real_blend_enable (pipeline1, FALSE);
+
+  if (pipeline0->real_blend_enable != pipeline1->real_blend_enable)
+    return FALSE;
+
+  _cogl_pipeline_update_journal_digest (pipeline0);
+  _cogl_pipeline_update_journal_digest (pipeline1);
+
+  if (pipeline0->journal_state_serial == pipeline1->journal_state_serial)
+    return TRUE;
+
+  if (pipeline0->journal_digest != pipeline1->journal_digest)
+    return FALSE;
+
+  /* Equal digests may still be a collision so the state has to be
+   * compared once, after which the pipelines share a serial until
+   * either of them changes */
+  if (!_cogl_pipeline_equal (pipeline0, pipeline1,
+                             JOURNAL_DIGEST_STATE,
+                             COGL_PIPELINE_LAYER_STATE_ALL))
+    return FALSE;
+
+  pipeline1->journal_state_serial = pipeline0->journal_state_serial;
+
+  return TRUE;
+}
+
 unsigned long
 _cogl_pipeline_get_age (CoglPipeline *pipeline)
 {
@@ -44,10 +44,19 @@
    structure. The algorithm for this is based on the description here:
 
    http://www.blackpawn.com/texts/lightmaps/default.html
-*/
+
+   Alternatively the map can pack the rectangles against a skyline,
+   i.e. the outline of the top edges of the rectangles placed so
+   far. Each new rectangle is put where it leaves the skyline the
+   lowest. This is cheaper and packs many small rectangles of similar
+   heights, such as glyphs, more tightly than the tree, but space
+   freed by removing a rectangle is only reused once the map is
+   empty again. */
 
 typedef struct _CoglRectangleMapNode       CoglRectangleMapNode;
 typedef struct _CoglRectangleMapStackEntry CoglRectangleMapStackEntry;
+typedef struct _CoglRectangleMapSegment    CoglRectangleMapSegment;
+typedef struct _CoglRectangleMapSkylineEntry CoglRectangleMapSkylineEntry;
 
 typedef void (* CoglRectangleMapInternalForeachCb) (CoglRectangleMapNode *node,
                                                     void *data);
@@ -61,8 +70,18 @@ typedef enum
 
 struct _CoglRectangleMap
 {
+  unsigned int width, height;
+
+  /* The root of the tree, or NULL if the map packs against a
+     skyline */
   CoglRectangleMapNode *root;
 
+  /* Horizontal segments of the skyline, sorted by x and together
+     spanning the whole width of the map */
+  GArray *skyline;
+  /* The rectangles placed against the skyline */
+  GArray *skyline_entries;
+
   unsigned int n_rectangles;
 
   unsigned int space_remaining;
@@ -99,6 +118,18 @@ struct _CoglRectangleMapNode
   } d;
 };
 
+struct _CoglRectangleMapSegment
+{
+  unsigned int x, y;
+  unsigned int width;
+};
+
+struct _CoglRectangleMapSkylineEntry
+{
+  CoglRectangleMapEntry rectangle;
+  void *data;
+};
+
 struct _CoglRectangleMapStackEntry
 {
   /* The node to search */
@@ -136,7 +167,11 @@ _cogl_rectangle_map_new (unsigned int width,
   root->rectangle.height = height;
   root->largest_gap = width * height;
 
+  map->width = width;
+  map->height = height;
   map->root = root;
+  map->skyline = NULL;
+  map->skyline_entries = NULL;
   map->n_rectangles = 0;
   map->value_destroy_func = value_destroy_func;
   map->space_remaining = width * height;
@@ -146,6 +181,41 @@ _cogl_rectangle_map_new (unsigned int width,
   return map;
 }
 
+static void
+_cogl_rectangle_map_skyline_reset (CoglRectangleMap *map)
+{
+  CoglRectangleMapSegment segment;
+
+  segment.x = 0;
+  segment.y = 0;
+  segment.width = map->width;
+
+  g_array_set_size (map->skyline, 0);
+  g_array_append_val (map->skyline, segment);
+}
+
+CoglRectangleMap *
+_cogl_rectangle_map_new_skyline (unsigned int width,
+                                 unsigned int height,
+                                 GDestroyNotify value_destroy_func)
+{
+  CoglRectangleMap *map = g_new0 (CoglRectangleMap, 1);
+
+  map->width = width;
+  map->height = height;
+  map->n_rectangles = 0;
+  map->value_destroy_func = value_destroy_func;
+  map->space_remaining = width * height;
+
+  map->skyline = g_array_new (FALSE, FALSE, sizeof (CoglRectangleMapSegment));
+  map->skyline_entries =
+    g_array_new (FALSE, FALSE, sizeof (CoglRectangleMapSkylineEntry));
+
+  _cogl_rectangle_map_skyline_reset (map);
+
+  return map;
+}
+
 static void
 _cogl_rectangle_map_stack_push (GArray *stack,
                                 CoglRectangleMapNode *node,
@@ -259,6 +329,186 @@ _cogl_rectangle_map_node_split_vertically (CoglRectangleMapNode *node,
   return top_node;
 }
 
+static gboolean
+_cogl_rectangle_map_skyline_fit (CoglRectangleMap *map,
+                                 unsigned int index,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 unsigned int *y_out)
+{
+  CoglRectangleMapSegment *segment =
+    &g_array_index (map->skyline, CoglRectangleMapSegment, index);
+  unsigned int width_left = width;
+  unsigned int y = 0;
+
+  if (segment->x + width > map->width)
+    return FALSE;
+
+  /* The rectangle has to sit on the highest of the segments it
+     spans */
+  while (TRUE)
+    {
+      segment = &g_array_index (map->skyline, CoglRectangleMapSegment, index);
+
+      y = MAX (y, segment->y);
+      if (y + height > map->height)
+        return FALSE;
+
+      if (segment->width >= width_left)
+        break;
+
+      width_left -= segment->width;
+      index++;
+    }
+
+  *y_out = y;
+
+  return TRUE;
+}
+
+static gboolean
+_cogl_rectangle_map_skyline_add (CoglRectangleMap *map,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 void *data,
+                                 CoglRectangleMapEntry *rectangle)
+{
+  GArray *skyline = map->skyline;
+  CoglRectangleMapSkylineEntry entry;
+  CoglRectangleMapSegment new_segment;
+  unsigned int best_top = G_MAXUINT;
+  unsigned int best_width = G_MAXUINT;
+  unsigned int best_y = 0;
+  int best_index = -1;
+  unsigned int i;
+
+  /* Find the position leaving the lowest skyline, preferring the
+     narrowest segment to keep wide gaps for wide rectangles */
+  for (i = 0; i < skyline->len; i++)
+    {
+      CoglRectangleMapSegment *segment =
+        &g_array_index (skyline, CoglRectangleMapSegment, i);
+      unsigned int y;
+
+      if (!_cogl_rectangle_map_skyline_fit (map, i, width, height, &y))
+        continue;
+
+      if (y + height < best_top ||
+          (y + height == best_top && segment->width < best_width))
+        {
+          best_index = i;
+          best_top = y + height;
+          best_width = segment->width;
+          best_y = y;
+        }
+    }
+
+  if (best_index < 0)
+    return FALSE;
+
+  new_segment.x = g_array_index (skyline, CoglRectangleMapSegment,
+                                 best_index).x;
+  new_segment.y = best_top;
+  new_segment.width = width;
+  g_array_insert_val (skyline, best_index, new_segment);
+
+  /* Shrink or drop the segments now covered by the new one */
+  i = best_index + 1;
+  while (i < skyline->len)
+    {
+      CoglRectangleMapSegment *segment =
+        &g_array_index (skyline, CoglRectangleMapSegment, i);
+      unsigned int covered_end = new_segment.x + new_segment.width;
+      unsigned int overlap;
+
+      if (segment->x >= covered_end)
+        break;
+
+      overlap = covered_end - segment->x;
+      if (overlap < segment->width)
+        {
+          segment->x += overlap;
+          segment->width -= overlap;
+          break;
+        }
+
+      g_array_remove_index (skyline, i);
+    }
+
+  /* Merge neighbouring segments at the same height */
+  i = 1;
+  while (i < skyline->len)
+    {
+      CoglRectangleMapSegment *prev =
+        &g_array_index (skyline, CoglRectangleMapSegment, i - 1);
+      CoglRectangleMapSegment *segment =
+        &g_array_index (skyline, CoglRectangleMapSegment, i);
+
+      if (prev->y == segment->y)
+        {
+          prev->width += segment->width;
+          g_array_remove_index (skyline, i);
+        }
+      else
+        i++;
+    }
+
+  entry.rectangle.x = new_segment.x;
+  entry.rectangle.y = best_y;
+  entry.rectangle.width = width;
+  entry.rectangle.height = height;
+  entry.data = data;
+  g_array_append_val (map->skyline_entries, entry);
+
+  if (rectangle)
+    *rectangle = entry.rectangle;
+
+  map->n_rectangles++;
+  map->space_remaining -= width * height;
+
+  return TRUE;
+}
+
+static void
+_cogl_rectangle_map_skyline_remove (CoglRectangleMap *map,
+                                    const CoglRectangleMapEntry *rectangle)
+{
+  unsigned int i;
+
+  for (i = 0; i < map->skyline_entries->len; i++)
+    {
+      CoglRectangleMapSkylineEntry *entry =
+        &g_array_index (map->skyline_entries,
+                        CoglRectangleMapSkylineEntry, i);
+
+      if (entry->rectangle.x == rectangle->x &&
+          entry->rectangle.y == rectangle->y &&
+          entry->rectangle.width == rectangle->width &&
+          entry->rectangle.height == rectangle->height)
+        {
+          if (map->value_destroy_func)
+            map->value_destroy_func (entry->data);
+
+          g_array_remove_index_fast (map->skyline_entries, i);
+
+          map->n_rectangles--;
+          map->space_remaining += rectangle->width * rectangle->height;
+
+          /* The skyline can't be lowered below the remaining
+             rectangles so the space is only reclaimed once the map
+             is empty */
+          if (map->n_rectangles == 0)
+            _cogl_rectangle_map_skyline_reset (map);
+
+          return;
+        }
+    }
+
+  /* This should only happen if someone tried to remove a rectangle
+     that was not in the map so something has gone wrong */
+  g_return_if_reached ();
+}
+
 gboolean
 _cogl_rectangle_map_add (CoglRectangleMap *map,
                          unsigned int width,
@@ -275,6 +525,10 @@ _cogl_rectangle_map_add (CoglRectangleMap *map,
      so we'll disallow them */
   g_return_val_if_fail (width > 0 && height > 0, FALSE);
 
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_add (map, width, height,
+                                            data, rectangle);
+
   /* Start with the root node */
   g_array_set_size (stack, 0);
   _cogl_rectangle_map_stack_push (stack, map->root, FALSE);
@@ -385,6 +639,12 @@ _cogl_rectangle_map_remove (CoglRectangleMap *map,
   CoglRectangleMapNode *node = map->root;
   unsigned int rectangle_size = rectangle->width * rectangle->height;
 
+  if (map->skyline)
+    {
+      _cogl_rectangle_map_skyline_remove (map, rectangle);
+      return;
+    }
+
   /* We can do a binary-chop down the search tree to find the rectangle */
   while (node->type == COGL_RECTANGLE_MAP_BRANCH)
     {
@@ -457,13 +717,13 @@ _cogl_rectangle_map_remove (CoglRectangleMap *map,
 unsigned int
 _cogl_rectangle_map_get_width (CoglRectangleMap *map)
 {
-  return map->root->rectangle.width;
+  return map->width;
 }
 
 unsigned int
 _cogl_rectangle_map_get_height (CoglRectangleMap *map)
 {
-  return map->root->rectangle.height;
+  return map->height;
 }
 
 unsigned int
@@ -562,6 +822,22 @@ _cogl_rectangle_map_foreach (CoglRectangleMap *map,
 {
   CoglRectangleMapForeachClosure closure;
 
+  if (map->skyline)
+    {
+      unsigned int i;
+
+      for (i = 0; i < map->skyline_entries->len; i++)
+        {
+          CoglRectangleMapSkylineEntry *entry =
+            &g_array_index (map->skyline_entries,
+                            CoglRectangleMapSkylineEntry, i);
+
+          callback (&entry->rectangle, entry->data, data);
+        }
+
+      return;
+    }
+
   closure.callback = callback;
   closure.data = data;
 
@@ -584,6 +860,24 @@ _cogl_rectangle_map_free_cb (CoglRectangleMapNode *node, void *data)
 void
 _cogl_rectangle_map_free (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    {
+      unsigned int i;
+
+      if (map->value_destroy_func)
+        {
+          for (i = 0; i < map->skyline_entries->len; i++)
+            map->value_destroy_func (g_array_index (map->skyline_entries,
+                                                    CoglRectangleMapSkylineEntry,
+                                                    i).data);
+        }
+
+      g_array_free (map->skyline_entries, TRUE);
+      g_array_free (map->skyline, TRUE);
+      g_free (map);
+      return;
+    }
+
   _cogl_rectangle_map_internal_foreach (map,
                                         _cogl_rectangle_map_free_cb,
                                         map);
@@ -45,38 +45,43 @@ struct _CoglRectangleMapEntry
   unsigned int width, height;
 };
 
-CoglRectangleMap *
+COGL_EXPORT_TEST CoglRectangleMap *
 _cogl_rectangle_map_new (unsigned int width,
                          unsigned int height,
                          GDestroyNotify value_destroy_func);
 
-gboolean
+COGL_EXPORT_TEST CoglRectangleMap *
+_cogl_rectangle_map_new_skyline (unsigned int width,
+                                 unsigned int height,
+                                 GDestroyNotify value_destroy_func);
+
+COGL_EXPORT_TEST gboolean
 _cogl_rectangle_map_add (CoglRectangleMap *map,
                          unsigned int width,
                          unsigned int height,
                          void *data,
                          CoglRectangleMapEntry *rectangle);
 
-void
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_remove (CoglRectangleMap *map,
                             const CoglRectangleMapEntry *rectangle);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_width (CoglRectangleMap *map);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_height (CoglRectangleMap *map);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_remaining_space (CoglRectangleMap *map);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_n_rectangles (CoglRectangleMap *map);
 
-void
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_foreach (CoglRectangleMap *map,
                              CoglRectangleMapCallback callback,
                              void *data);
 
-void
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_free (CoglRectangleMap *map);
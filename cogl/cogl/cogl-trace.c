@@ -41,6 +41,9 @@
 #define COGL_TRACE_OUTPUT_FILE "cogl-trace-sp-capture.syscap"
 #define BUFFER_LENGTH (4096 * 4)
 
+/* Number of spans kept per thread, must be a power of two */
+#define COGL_TRACE_RING_SIZE (1 << 15)
+
 struct _CoglTraceContext
 {
   gatomicrefcount ref_count;
@@ -61,6 +64,39 @@ typedef struct
   CoglTraceContext *trace_context;
 } TraceData;
 
+typedef struct _CoglTraceRingSpan
+{
+  int64_t begin_time;
+  int64_t duration;
+  const char *name;
+} CoglTraceRingSpan;
+
+/* A fixed size ring of the most recently ended spans of a thread. Only
+ * the thread itself writes to it, while snapshots may be taken from
+ * any thread. n_spans is updated atomically after a span is written so
+ * that readers can tell which spans might have been overwritten while
+ * they were copying them.
+ */
+typedef struct _CoglTraceRing
+{
+  char *group;
+  GPid pid;
+  gsize n_spans;
+  CoglTraceRingSpan spans[COGL_TRACE_RING_SIZE];
+} CoglTraceRing;
+
+typedef struct _CoglTraceRingCopy
+{
+  char *group;
+  GPid pid;
+  GArray *spans;
+} CoglTraceRingCopy;
+
+struct _CoglTraceRingSnapshot
+{
+  GPtrArray *rings;
+};
+
 static void cogl_trace_context_unref (CoglTraceContext *trace_context);
 
 static void
@@ -75,10 +111,19 @@ trace_data_free (gpointer user_data)
 
 static void cogl_trace_thread_context_free (gpointer data);
 
+static void cogl_trace_ring_free (gpointer data);
+
 GPrivate cogl_trace_thread_data = G_PRIVATE_INIT (cogl_trace_thread_context_free);
 CoglTraceContext *cogl_trace_context;
 GMutex cogl_trace_mutex;
 
+GPrivate cogl_trace_ring_thread_data = G_PRIVATE_INIT (cogl_trace_ring_free);
+static GList *cogl_trace_rings;
+static GMutex cogl_trace_rings_mutex;
+
+static CoglTraceRingTriggerFunc cogl_trace_ring_trigger_func;
+static gpointer cogl_trace_ring_trigger_data;
+
 static CoglTraceContext *
 cogl_trace_context_new (int         fd,
                         const char *filename)
@@ -301,13 +346,12 @@ cogl_set_tracing_disabled_on_thread (GMainContext *main_context)
 
 static void
 cogl_trace_end_with_description (CoglTraceHead *head,
+                                 uint64_t       end_time,
                                  const char    *description)
 {
-  SysprofTimeStamp end_time;
   CoglTraceContext *trace_context;
   CoglTraceThreadContext *trace_thread_context;
 
-  end_time = g_get_monotonic_time () * 1000;
   trace_thread_context = g_private_get (&cogl_trace_thread_data);
   trace_context = trace_thread_context->trace_context;
 
@@ -316,7 +360,7 @@ cogl_trace_end_with_description (CoglTraceHead *head,
                                         head->begin_time,
                                         trace_thread_context->cpu_id,
                                         trace_thread_context->pid,
-                                        (uint64_t) end_time - head->begin_time,
+                                        end_time - head->begin_time,
                                         trace_thread_context->group,
                                         head->name,
                                         description))
@@ -331,10 +375,36 @@ cogl_trace_end_with_description (CoglTraceHead *head,
   g_mutex_unlock (&cogl_trace_mutex);
 }
 
+static inline void
+cogl_trace_ring_add_span (CoglTraceRing *ring,
+                          CoglTraceHead *head,
+                          uint64_t       end_time)
+{
+  CoglTraceRingSpan *span;
+
+  span = &ring->spans[ring->n_spans & (COGL_TRACE_RING_SIZE - 1)];
+  span->begin_time = head->begin_time;
+  span->duration = end_time - head->begin_time;
+  span->name = head->name;
+
+  g_atomic_pointer_set (&ring->n_spans, ring->n_spans + 1);
+}
+
 void
 cogl_trace_end (CoglTraceHead *head)
 {
-  cogl_trace_end_with_description (head, head->description);
+  CoglTraceRing *ring;
+  uint64_t end_time;
+
+  end_time = g_get_monotonic_time () * 1000;
+
+  ring = g_private_get (&cogl_trace_ring_thread_data);
+  if (ring)
+    cogl_trace_ring_add_span (ring, head, end_time);
+
+  if (cogl_is_tracing_enabled ())
+    cogl_trace_end_with_description (head, end_time, head->description);
+
   g_free (head->description);
 }
 
@@ -385,6 +455,283 @@ cogl_trace_describe (CoglTraceHead *head,
     head->description = g_strdup (description);
 }
 
+static CoglTraceRing *
+cogl_trace_ring_new (const char *group)
+{
+  CoglTraceRing *ring;
+  pid_t tid;
+
+  tid = (pid_t) syscall (SYS_gettid);
+
+  ring = g_new0 (CoglTraceRing, 1);
+  ring->pid = getpid ();
+  ring->group = group ? g_strdup (group) : g_strdup_printf ("t:%d", tid);
+
+  return ring;
+}
+
+static void
+cogl_trace_ring_free (gpointer data)
+{
+  CoglTraceRing *ring = data;
+
+  if (!ring)
+    return;
+
+  g_mutex_lock (&cogl_trace_rings_mutex);
+  cogl_trace_rings = g_list_remove (cogl_trace_rings, ring);
+  g_mutex_unlock (&cogl_trace_rings_mutex);
+
+  g_free (ring->group);
+  g_free (ring);
+}
+
+static gboolean
+enable_trace_ring_idle_callback (gpointer user_data)
+{
+  const char *group = user_data;
+  CoglTraceRing *ring;
+
+  if (g_private_get (&cogl_trace_ring_thread_data))
+    return G_SOURCE_REMOVE;
+
+  ring = cogl_trace_ring_new (group);
+
+  g_mutex_lock (&cogl_trace_rings_mutex);
+  cogl_trace_rings = g_list_prepend (cogl_trace_rings, ring);
+  g_mutex_unlock (&cogl_trace_rings_mutex);
+
+  g_private_set (&cogl_trace_ring_thread_data, ring);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+disable_trace_ring_idle_callback (gpointer user_data)
+{
+  g_private_replace (&cogl_trace_ring_thread_data, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+void
+cogl_set_trace_ring_enabled_on_thread (GMainContext *main_context,
+                                       const char   *group)
+{
+  if (main_context == g_main_context_get_thread_default ())
+    {
+      enable_trace_ring_idle_callback ((gpointer) group);
+    }
+  else
+    {
+      GSource *source;
+
+      source = g_idle_source_new ();
+
+      g_source_set_callback (source,
+                             enable_trace_ring_idle_callback,
+                             g_strdup (group),
+                             g_free);
+
+      g_source_attach (source, main_context);
+      g_source_unref (source);
+    }
+}
+
+void
+cogl_set_trace_ring_disabled_on_thread (GMainContext *main_context)
+{
+  if (main_context == g_main_context_get_thread_default ())
+    {
+      disable_trace_ring_idle_callback (NULL);
+    }
+  else
+    {
+      GSource *source;
+
+      source = g_idle_source_new ();
+
+      g_source_set_callback (source,
+                             disable_trace_ring_idle_callback,
+                             NULL, NULL);
+
+      g_source_attach (source, main_context);
+      g_source_unref (source);
+    }
+}
+
+static void
+cogl_trace_ring_copy_free (CoglTraceRingCopy *ring_copy)
+{
+  g_free (ring_copy->group);
+  g_array_unref (ring_copy->spans);
+  g_free (ring_copy);
+}
+
+static CoglTraceRingCopy *
+cogl_trace_ring_copy (CoglTraceRing *ring,
+                      int64_t        since_time)
+{
+  g_autofree CoglTraceRingSpan *spans = NULL;
+  CoglTraceRingCopy *ring_copy;
+  gsize n_spans, first_span, first_valid_span, i;
+
+  n_spans = (gsize) g_atomic_pointer_get (&ring->n_spans);
+  first_span = n_spans > COGL_TRACE_RING_SIZE ?
+    n_spans - COGL_TRACE_RING_SIZE : 0;
+
+  spans = g_new (CoglTraceRingSpan, n_spans - first_span);
+  for (i = first_span; i < n_spans; i++)
+    spans[i - first_span] = ring->spans[i & (COGL_TRACE_RING_SIZE - 1)];
+
+  /* The thread kept on adding spans while they were copied; skip the
+   * ones that might have been overwritten in the meantime, including
+   * the one that might have been in the middle of being written */
+  first_valid_span = (gsize) g_atomic_pointer_get (&ring->n_spans);
+  first_valid_span = first_valid_span >= COGL_TRACE_RING_SIZE ?
+    first_valid_span - COGL_TRACE_RING_SIZE + 1 : 0;
+
+  ring_copy = g_new0 (CoglTraceRingCopy, 1);
+  ring_copy->group = g_strdup (ring->group);
+  ring_copy->pid = ring->pid;
+  ring_copy->spans = g_array_new (FALSE, FALSE, sizeof (CoglTraceRingSpan));
+
+  for (i = MAX (first_span, first_valid_span); i < n_spans; i++)
+    {
+      const CoglTraceRingSpan *span = &spans[i - first_span];
+
+      if (span->begin_time + span->duration < since_time)
+        continue;
+
+      g_array_append_val (ring_copy->spans, *span);
+    }
+
+  return ring_copy;
+}
+
+CoglTraceRingSnapshot *
+cogl_trace_ring_snapshot_new (int64_t duration_us)
+{
+  CoglTraceRingSnapshot *snapshot;
+  int64_t since_time;
+  GList *l;
+
+  since_time = (g_get_monotonic_time () - duration_us) * 1000;
+
+  snapshot = g_new0 (CoglTraceRingSnapshot, 1);
+  snapshot->rings =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) cogl_trace_ring_copy_free);
+
+  g_mutex_lock (&cogl_trace_rings_mutex);
+  for (l = cogl_trace_rings; l; l = l->next)
+    g_ptr_array_add (snapshot->rings, cogl_trace_ring_copy (l->data, since_time));
+  g_mutex_unlock (&cogl_trace_rings_mutex);
+
+  return snapshot;
+}
+
+void
+cogl_trace_ring_snapshot_free (CoglTraceRingSnapshot *snapshot)
+{
+  g_ptr_array_unref (snapshot->rings);
+  g_free (snapshot);
+}
+
+unsigned int
+cogl_trace_ring_snapshot_get_n_spans (CoglTraceRingSnapshot *snapshot)
+{
+  unsigned int n_spans = 0;
+  unsigned int i;
+
+  for (i = 0; i < snapshot->rings->len; i++)
+    {
+      CoglTraceRingCopy *ring_copy = g_ptr_array_index (snapshot->rings, i);
+
+      n_spans += ring_copy->spans->len;
+    }
+
+  return n_spans;
+}
+
+gboolean
+cogl_trace_ring_snapshot_write (CoglTraceRingSnapshot  *snapshot,
+                                const char             *filename,
+                                GError                **error)
+{
+  SysprofCaptureWriter *writer;
+  unsigned int i, j;
+  gboolean ret = TRUE;
+
+  writer = sysprof_capture_writer_new (filename, BUFFER_LENGTH);
+  if (!writer)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to create capture file '%s': %s",
+                   filename, g_strerror (errno));
+      return FALSE;
+    }
+
+  for (i = 0; i < snapshot->rings->len && ret; i++)
+    {
+      CoglTraceRingCopy *ring_copy = g_ptr_array_index (snapshot->rings, i);
+
+      for (j = 0; j < ring_copy->spans->len; j++)
+        {
+          const CoglTraceRingSpan *span =
+            &g_array_index (ring_copy->spans, CoglTraceRingSpan, j);
+
+          if (!sysprof_capture_writer_add_mark (writer,
+                                                span->begin_time,
+                                                -1,
+                                                ring_copy->pid,
+                                                span->duration,
+                                                ring_copy->group,
+                                                span->name,
+                                                NULL))
+            {
+              g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                           "Failed to write to capture file '%s': %s",
+                           filename, g_strerror (errno));
+              ret = FALSE;
+              break;
+            }
+        }
+    }
+
+  if (ret && !sysprof_capture_writer_flush (writer))
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to flush capture file '%s': %s",
+                   filename, g_strerror (errno));
+      ret = FALSE;
+    }
+
+  sysprof_capture_writer_unref (writer);
+
+  return ret;
+}
+
+void
+cogl_set_trace_ring_trigger_func (CoglTraceRingTriggerFunc trigger_func,
+                                  gpointer                 user_data)
+{
+  cogl_trace_ring_trigger_func = trigger_func;
+  cogl_trace_ring_trigger_data = user_data;
+}
+
+void
+cogl_trace_ring_trigger (const char *reason)
+{
+  if (cogl_trace_ring_trigger_func)
+    cogl_trace_ring_trigger_func (reason, cogl_trace_ring_trigger_data);
+}
+
+gboolean
+cogl_trace_ring_has_trigger (void)
+{
+  return cogl_trace_ring_trigger_func != NULL;
+}
+
 #else
 
 #include <string.h>
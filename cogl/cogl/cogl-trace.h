@@ -37,6 +37,10 @@
 #ifdef HAVE_PROFILER
 
 typedef struct _CoglTraceContext CoglTraceContext;
+typedef struct _CoglTraceRingSnapshot CoglTraceRingSnapshot;
+
+typedef void (* CoglTraceRingTriggerFunc) (const char *reason,
+                                           gpointer    user_data);
 
 typedef struct _CoglTraceHead
 {
@@ -51,6 +55,8 @@ COGL_EXPORT
 CoglTraceContext *cogl_trace_context;
 COGL_EXPORT
 GMutex cogl_trace_mutex;
+COGL_EXPORT
+GPrivate cogl_trace_ring_thread_data;
 
 COGL_EXPORT
 gboolean cogl_start_tracing_with_path (const char  *filename,
@@ -70,6 +76,45 @@ void cogl_set_tracing_enabled_on_thread (GMainContext *main_context,
 COGL_EXPORT
 void cogl_set_tracing_disabled_on_thread (GMainContext *main_context);
 
+/*
+ * The trace ring keeps the most recent spans of a thread in memory,
+ * independently of whether a capture is being written. Only the name
+ * and the timing of a span is kept, so span names must be static
+ * strings. Descriptions and messages only end up in captures.
+ */
+COGL_EXPORT
+void cogl_set_trace_ring_enabled_on_thread (GMainContext *main_context,
+                                            const char   *group);
+
+COGL_EXPORT
+void cogl_set_trace_ring_disabled_on_thread (GMainContext *main_context);
+
+COGL_EXPORT
+CoglTraceRingSnapshot * cogl_trace_ring_snapshot_new (int64_t duration_us);
+
+COGL_EXPORT
+void cogl_trace_ring_snapshot_free (CoglTraceRingSnapshot *snapshot);
+
+COGL_EXPORT
+unsigned int cogl_trace_ring_snapshot_get_n_spans (CoglTraceRingSnapshot *snapshot);
+
+COGL_EXPORT
+gboolean cogl_trace_ring_snapshot_write (CoglTraceRingSnapshot  *snapshot,
+                                         const char             *filename,
+                                         GError                **error);
+
+COGL_EXPORT
+void cogl_set_trace_ring_trigger_func (CoglTraceRingTriggerFunc trigger_func,
+                                       gpointer                 user_data);
+
+COGL_EXPORT
+void cogl_trace_ring_trigger (const char *reason);
+
+COGL_EXPORT
+gboolean cogl_trace_ring_has_trigger (void);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (CoglTraceRingSnapshot, cogl_trace_ring_snapshot_free)
+
 static inline void
 cogl_trace_begin (CoglTraceHead *head,
                   const char    *name)
@@ -102,18 +147,30 @@ cogl_is_tracing_enabled (void)
   return !!g_private_get (&cogl_trace_thread_data);
 }
 
+static inline gboolean
+cogl_is_trace_ring_enabled (void)
+{
+  return !!g_private_get (&cogl_trace_ring_thread_data);
+}
+
+static inline gboolean
+cogl_is_tracing_spans (void)
+{
+  return cogl_is_trace_ring_enabled () || cogl_is_tracing_enabled ();
+}
+
 #define COGL_TRACE_BEGIN_SCOPED(Name, name) \
   CoglTraceHead CoglTrace##Name = { 0 }; \
   __attribute__((cleanup (cogl_auto_trace_end_helper))) \
     CoglTraceHead *ScopedCoglTrace##Name = NULL; \
-  if (cogl_is_tracing_enabled ()) \
+  if (cogl_is_tracing_spans ()) \
     { \
       cogl_trace_begin (&CoglTrace##Name, name); \
       ScopedCoglTrace##Name = &CoglTrace##Name; \
     }
 
 #define COGL_TRACE_END(Name)\
-  if (cogl_is_tracing_enabled ()) \
+  if (ScopedCoglTrace##Name) \
     { \
       cogl_trace_end (&CoglTrace##Name); \
       ScopedCoglTrace##Name = NULL; \
@@ -129,7 +186,7 @@ cogl_is_tracing_enabled (void)
     CoglTraceHead *ScopedCoglTrace##Name = NULL; \
 
 #define COGL_TRACE_BEGIN_ANCHORED(Name, name) \
-  if (cogl_is_tracing_enabled ()) \
+  if (cogl_is_tracing_spans ()) \
     { \
       cogl_trace_begin (&CoglTrace##Name, name); \
       ScopedCoglTrace##Name = &CoglTrace##Name; \
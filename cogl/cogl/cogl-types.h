@@ -401,12 +401,16 @@ typedef enum
 /**
  * CoglReadPixelsFlags:
  * @COGL_READ_PIXELS_COLOR_BUFFER: Read from the color buffer
+ * @COGL_READ_PIXELS_NO_FLIP: Leave the rows in the order the driver returns
+ *   them instead of compensating for GL's upside-down coordinate system.
+ *   For onscreen framebuffers this means the last row is read first.
  *
  * Flags for cogl_framebuffer_read_pixels_into_bitmap()
  */
 typedef enum /*< prefix=COGL_READ_PIXELS >*/
 {
-  COGL_READ_PIXELS_COLOR_BUFFER = 1L << 0
+  COGL_READ_PIXELS_COLOR_BUFFER = 1L << 0,
+  COGL_READ_PIXELS_NO_FLIP = 1L << 30
 } CoglReadPixelsFlags;
 
 /**
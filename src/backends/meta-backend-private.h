@@ -32,6 +32,7 @@
 #include "backends/meta-egl.h"
 #include "backends/meta-input-mapper-private.h"
 #include "backends/meta-input-settings-private.h"
+#include "backends/meta-keymap-snapshot.h"
 #include "backends/meta-monitor-manager-private.h"
 #include "backends/meta-orientation-manager.h"
 #include "backends/meta-pointer-constraint.h"
@@ -105,6 +106,8 @@ struct _MetaBackendClass
 
   struct xkb_keymap * (* get_keymap) (MetaBackend *backend);
 
+  MetaKeymapSnapshot * (* get_keymap_snapshot) (MetaBackend *backend);
+
   xkb_layout_index_t (* get_keymap_layout_group) (MetaBackend *backend);
 
   void (* lock_layout_group) (MetaBackend *backend,
@@ -152,6 +155,7 @@ MetaDbusSessionWatcher * meta_backend_get_dbus_session_watcher (MetaBackend *bac
 #ifdef HAVE_REMOTE_DESKTOP
 MetaRemoteDesktop * meta_backend_get_remote_desktop (MetaBackend *backend);
 
+META_EXPORT_TEST
 MetaScreenCast * meta_backend_get_screen_cast (MetaBackend *backend);
 #endif
 
@@ -173,6 +177,8 @@ MetaLogicalMonitor * meta_backend_get_current_logical_monitor (MetaBackend *back
 
 struct xkb_keymap * meta_backend_get_keymap (MetaBackend *backend);
 
+MetaKeymapSnapshot * meta_backend_get_keymap_snapshot (MetaBackend *backend);
+
 xkb_layout_index_t meta_backend_get_keymap_layout_group (MetaBackend *backend);
 
 gboolean meta_backend_is_lid_closed (MetaBackend *backend);
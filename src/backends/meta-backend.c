@@ -171,6 +171,8 @@ struct _MetaBackendPrivate
   MetaPointerConstraint *client_pointer_constraint;
   MetaDnd *dnd;
 
+  MetaKeymapSnapshot *keymap_snapshot;
+
   guint upower_watch_id;
   GDBusProxy *upower_proxy;
   gboolean lid_is_closed;
@@ -219,6 +221,7 @@ meta_backend_dispose (GObject *object)
   g_clear_object (&priv->dbus_session_watcher);
   g_clear_object (&priv->remote_access_controller);
   g_clear_object (&priv->dnd);
+  g_clear_pointer (&priv->keymap_snapshot, meta_keymap_snapshot_unref);
 
 #ifdef HAVE_LIBWACOM
   g_clear_pointer (&priv->wacom_db, libwacom_database_destroy);
@@ -1595,6 +1598,42 @@ meta_backend_get_keymap (MetaBackend *backend)
   return META_BACKEND_GET_CLASS (backend)->get_keymap (backend);
 }
 
+/**
+ * meta_backend_get_keymap_snapshot: (skip)
+ *
+ * Returns: (transfer none): A snapshot of the current keymap, including
+ *   its serialized form
+ */
+MetaKeymapSnapshot *
+meta_backend_get_keymap_snapshot (MetaBackend *backend)
+{
+  MetaBackendPrivate *priv = meta_backend_get_instance_private (backend);
+  MetaBackendClass *backend_class = META_BACKEND_GET_CLASS (backend);
+  g_autoptr (GError) error = NULL;
+  struct xkb_keymap *keymap;
+
+  if (backend_class->get_keymap_snapshot)
+    return backend_class->get_keymap_snapshot (backend);
+
+  keymap = meta_backend_get_keymap (backend);
+  if (!keymap)
+    return NULL;
+
+  if (priv->keymap_snapshot &&
+      meta_keymap_snapshot_get_keymap (priv->keymap_snapshot) == keymap)
+    return priv->keymap_snapshot;
+
+  g_clear_pointer (&priv->keymap_snapshot, meta_keymap_snapshot_unref);
+  priv->keymap_snapshot =
+    meta_keymap_snapshot_new (keymap,
+                              META_KEYMAP_SNAPSHOT_FLAG_SERIALIZE,
+                              &error);
+  if (!priv->keymap_snapshot)
+    g_warning ("Failed to create keymap snapshot: %s", error->message);
+
+  return priv->keymap_snapshot;
+}
+
 xkb_layout_index_t
 meta_backend_get_keymap_layout_group (MetaBackend *backend)
 {
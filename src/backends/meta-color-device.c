@@ -28,6 +28,7 @@
 #include "backends/meta-color-manager-private.h"
 #include "backends/meta-color-profile.h"
 #include "backends/meta-color-store.h"
+#include "backends/meta-crtc.h"
 #include "backends/meta-monitor.h"
 
 #define EFI_PANEL_COLOR_INFO_PATH \
@@ -72,6 +73,9 @@ struct _MetaColorDevice
 
   PendingState pending_state;
   gboolean is_ready;
+
+  /* Reused between updates, e.g. during night light transitions */
+  MetaGammaLut *gamma_lut;
 };
 
 G_DEFINE_TYPE (MetaColorDevice, meta_color_device,
@@ -277,6 +281,7 @@ meta_color_device_dispose (GObject *object)
 
   g_clear_object (&color_device->assigned_profile);
   g_clear_object (&color_device->device_profile);
+  g_clear_pointer (&color_device->gamma_lut, meta_gamma_lut_free);
 
   cd_device = color_device->cd_device;
   cd_device_id = color_device->cd_device_id;
@@ -1268,13 +1273,18 @@ meta_color_device_update (MetaColorDevice *color_device,
   lut_size = meta_monitor_get_gamma_lut_size (monitor);
   if (lut_size > 0)
     {
-      g_autoptr (MetaGammaLut) lut = NULL;
+      if (color_device->gamma_lut &&
+          color_device->gamma_lut->size != lut_size)
+        g_clear_pointer (&color_device->gamma_lut, meta_gamma_lut_free);
+
+      if (!color_device->gamma_lut)
+        color_device->gamma_lut = meta_gamma_lut_new_sized (lut_size);
 
-      lut = meta_color_profile_generate_gamma_lut (color_profile,
-                                                   temperature,
-                                                   lut_size);
+      meta_color_profile_update_gamma_lut (color_profile,
+                                           temperature,
+                                           color_device->gamma_lut);
 
-      meta_monitor_set_gamma_lut (monitor, lut);
+      meta_monitor_set_gamma_lut (monitor, color_device->gamma_lut);
     }
 
   g_signal_emit (color_device, signals[UPDATED], 0);
@@ -26,6 +26,18 @@
 #include <gio/gio.h>
 
 #include "backends/meta-color-manager-private.h"
+#include "backends/meta-crtc.h"
+
+/* Temperatures at which the blackbody color is cached; colord tabulates the
+ * blackbody colors at the same interval and interpolates linearly between
+ * them, so interpolating between the cached anchors gives the same result
+ * without going through colord for every update. */
+#define BLACKBODY_ANCHOR_MIN_TEMPERATURE 1000
+#define BLACKBODY_ANCHOR_MAX_TEMPERATURE 10000
+#define BLACKBODY_ANCHOR_INTERVAL 100
+#define N_BLACKBODY_ANCHORS \
+  ((BLACKBODY_ANCHOR_MAX_TEMPERATURE - BLACKBODY_ANCHOR_MIN_TEMPERATURE) / \
+   BLACKBODY_ANCHOR_INTERVAL + 1)
 
 enum
 {
@@ -53,8 +65,17 @@ struct _MetaColorProfile
   guint notify_ready_id;
 
   gboolean is_ready;
+
+  /* The VCGT curves evaluated for the last used LUT size */
+  struct {
+    size_t size;
+    float *curves[3];
+  } vcgt_samples;
 };
 
+static CdColorRGB blackbody_anchors[N_BLACKBODY_ANCHORS];
+static gboolean blackbody_anchors_initialized;
+
 G_DEFINE_TYPE (MetaColorProfile, meta_color_profile,
                G_TYPE_OBJECT)
 
@@ -149,6 +170,9 @@ meta_color_profile_finalize (GObject *object)
   g_clear_pointer (&color_profile->bytes, g_bytes_unref);
   g_clear_object (&color_profile->cd_profile);
   g_clear_pointer (&color_profile->calibration, meta_color_calibration_free);
+  g_clear_pointer (&color_profile->vcgt_samples.curves[0], g_free);
+  g_clear_pointer (&color_profile->vcgt_samples.curves[1], g_free);
+  g_clear_pointer (&color_profile->vcgt_samples.curves[2], g_free);
 
   G_OBJECT_CLASS (meta_color_profile_parent_class)->finalize (object);
 }
@@ -403,91 +427,151 @@ meta_color_profile_get_brightness_profile (MetaColorProfile *color_profile)
   return color_profile->calibration->brightness_profile;
 }
 
+static void
+ensure_blackbody_anchors (void)
+{
+  int i;
+
+  if (blackbody_anchors_initialized)
+    return;
+
+  for (i = 0; i < N_BLACKBODY_ANCHORS; i++)
+    {
+      unsigned int temperature;
+
+      temperature = (BLACKBODY_ANCHOR_MIN_TEMPERATURE +
+                     i * BLACKBODY_ANCHOR_INTERVAL);
+      if (!cd_color_get_blackbody_rgb_full (temperature,
+                                            &blackbody_anchors[i],
+                                            CD_COLOR_BLACKBODY_FLAG_USE_PLANCKIAN))
+        {
+          g_warning ("Failed to get blackbody for %uK", temperature);
+          cd_color_rgb_set (&blackbody_anchors[i], 1.0, 1.0, 1.0);
+        }
+    }
+
+  blackbody_anchors_initialized = TRUE;
+}
+
 static void
 set_blackbody_color_for_temperature (CdColorRGB   *blackbody_color,
                                      unsigned int  temperature)
 {
-  if (!cd_color_get_blackbody_rgb_full (temperature,
-                                        blackbody_color,
-                                        CD_COLOR_BLACKBODY_FLAG_USE_PLANCKIAN))
+  unsigned int offset;
+  int index;
+
+  if (temperature < BLACKBODY_ANCHOR_MIN_TEMPERATURE ||
+      temperature > BLACKBODY_ANCHOR_MAX_TEMPERATURE)
     {
       g_warning ("Failed to get blackbody for %uK", temperature);
       cd_color_rgb_set (blackbody_color, 1.0, 1.0, 1.0);
+      return;
+    }
+
+  ensure_blackbody_anchors ();
+
+  offset = temperature - BLACKBODY_ANCHOR_MIN_TEMPERATURE;
+  index = offset / BLACKBODY_ANCHOR_INTERVAL;
+  if (index == N_BLACKBODY_ANCHORS - 1)
+    {
+      *blackbody_color = blackbody_anchors[index];
     }
   else
     {
-      meta_topic (META_DEBUG_COLOR,
-                  "Using blackbody color from %uK: %.1f, %.1f, %.1f",
-                  temperature,
-                  blackbody_color->R,
-                  blackbody_color->G,
-                  blackbody_color->B);
+      cd_color_rgb_interpolate (&blackbody_anchors[index],
+                                &blackbody_anchors[index + 1],
+                                (offset % BLACKBODY_ANCHOR_INTERVAL) /
+                                (double) BLACKBODY_ANCHOR_INTERVAL,
+                                blackbody_color);
     }
+
+  meta_topic (META_DEBUG_COLOR,
+              "Using blackbody color from %uK: %.1f, %.1f, %.1f",
+              temperature,
+              blackbody_color->R,
+              blackbody_color->G,
+              blackbody_color->B);
 }
 
-static MetaGammaLut *
-generate_gamma_lut_from_vcgt (MetaColorProfile  *color_profile,
-                              cmsToneCurve     **vcgt,
-                              unsigned int       temperature,
-                              size_t             lut_size)
+static void
+ensure_vcgt_samples (MetaColorProfile  *color_profile,
+                     cmsToneCurve     **vcgt,
+                     size_t             lut_size)
 {
-  CdColorRGB blackbody_color;
-  MetaGammaLut *lut;
   size_t i;
+  int j;
 
-  meta_topic (META_DEBUG_COLOR,
-              "Generating %zu sized GAMMA LUT using temperature %uK and VCGT",
-              lut_size, temperature);
+  if (color_profile->vcgt_samples.size == lut_size)
+    return;
 
-  set_blackbody_color_for_temperature (&blackbody_color, temperature);
+  meta_topic (META_DEBUG_COLOR,
+              "Evaluating VCGT for %zu sized GAMMA LUTs", lut_size);
 
-  lut = g_new0 (MetaGammaLut, 1);
-  lut->size = lut_size;
-  lut->red = g_new0 (uint16_t, lut_size);
-  lut->green = g_new0 (uint16_t, lut_size);
-  lut->blue = g_new0 (uint16_t, lut_size);
+  for (j = 0; j < 3; j++)
+    {
+      g_free (color_profile->vcgt_samples.curves[j]);
+      color_profile->vcgt_samples.curves[j] = g_new (float, lut_size);
+    }
 
   for (i = 0; i < lut_size; i++)
     {
       cmsFloat32Number in;
 
       in = (double) i / (double) (lut_size - 1);
-      lut->red[i] =
-        cmsEvalToneCurveFloat (vcgt[0], in) *
-        blackbody_color.R * (double) 0xffff;
-      lut->green[i] =
-        cmsEvalToneCurveFloat (vcgt[1], in) *
-        blackbody_color.G * (double) 0xffff;
-      lut->blue[i] =
-        cmsEvalToneCurveFloat (vcgt[2], in) *
-        blackbody_color.B * (gdouble) 0xffff;
+      for (j = 0; j < 3; j++)
+        {
+          color_profile->vcgt_samples.curves[j][i] =
+            cmsEvalToneCurveFloat (vcgt[j], in);
+        }
     }
 
-  return lut;
+  color_profile->vcgt_samples.size = lut_size;
 }
 
-static MetaGammaLut *
-generate_gamma_lut (MetaColorProfile *color_profile,
-                    unsigned int      temperature,
-                    size_t            lut_size)
+static void
+update_gamma_lut_from_vcgt (MetaColorProfile  *color_profile,
+                            cmsToneCurve     **vcgt,
+                            unsigned int       temperature,
+                            MetaGammaLut      *lut)
 {
   CdColorRGB blackbody_color;
-  MetaGammaLut *lut;
+  const float *red, *green, *blue;
   size_t i;
 
   meta_topic (META_DEBUG_COLOR,
-              "Generating %zu sized GAMMA LUT using temperature %uK",
-              lut_size, temperature);
+              "Generating %zu sized GAMMA LUT using temperature %uK and VCGT",
+              lut->size, temperature);
 
   set_blackbody_color_for_temperature (&blackbody_color, temperature);
 
-  lut = g_new0 (MetaGammaLut, 1);
-  lut->size = lut_size;
-  lut->red = g_new0 (uint16_t, lut_size);
-  lut->green = g_new0 (uint16_t, lut_size);
-  lut->blue = g_new0 (uint16_t, lut_size);
+  ensure_vcgt_samples (color_profile, vcgt, lut->size);
+  red = color_profile->vcgt_samples.curves[0];
+  green = color_profile->vcgt_samples.curves[1];
+  blue = color_profile->vcgt_samples.curves[2];
 
-  for (i = 0; i < lut_size; i++)
+  for (i = 0; i < lut->size; i++)
+    {
+      lut->red[i] = red[i] * blackbody_color.R * (double) 0xffff;
+      lut->green[i] = green[i] * blackbody_color.G * (double) 0xffff;
+      lut->blue[i] = blue[i] * blackbody_color.B * (double) 0xffff;
+    }
+}
+
+static void
+update_gamma_lut (MetaColorProfile *color_profile,
+                  unsigned int      temperature,
+                  MetaGammaLut     *lut)
+{
+  CdColorRGB blackbody_color;
+  size_t i;
+
+  meta_topic (META_DEBUG_COLOR,
+              "Generating %zu sized GAMMA LUT using temperature %uK",
+              lut->size, temperature);
+
+  set_blackbody_color_for_temperature (&blackbody_color, temperature);
+
+  for (i = 0; i < lut->size; i++)
     {
       uint16_t in;
 
@@ -496,29 +580,48 @@ generate_gamma_lut (MetaColorProfile *color_profile,
       lut->green[i] = in * blackbody_color.G;
       lut->blue[i] = in * blackbody_color.B;
     }
-
-  return lut;
 }
 
-MetaGammaLut *
-meta_color_profile_generate_gamma_lut (MetaColorProfile *color_profile,
-                                       unsigned int      temperature,
-                                       size_t            lut_size)
+/**
+ * meta_color_profile_update_gamma_lut:
+ *
+ * Fills the existing @lut with the gamma curves of the profile adjusted to
+ * @temperature, without allocating a new LUT.
+ */
+void
+meta_color_profile_update_gamma_lut (MetaColorProfile *color_profile,
+                                     unsigned int      temperature,
+                                     MetaGammaLut     *lut)
 {
-  g_assert (lut_size > 0);
+  g_assert (lut->size > 0);
 
   if (color_profile->calibration->has_vcgt)
     {
-      return generate_gamma_lut_from_vcgt (color_profile,
-                                           color_profile->calibration->vcgt,
-                                           temperature, lut_size);
+      update_gamma_lut_from_vcgt (color_profile,
+                                  color_profile->calibration->vcgt,
+                                  temperature, lut);
     }
   else
     {
-      return generate_gamma_lut (color_profile, temperature, lut_size);
+      update_gamma_lut (color_profile, temperature, lut);
     }
 }
 
+MetaGammaLut *
+meta_color_profile_generate_gamma_lut (MetaColorProfile *color_profile,
+                                       unsigned int      temperature,
+                                       size_t            lut_size)
+{
+  MetaGammaLut *lut;
+
+  g_assert (lut_size > 0);
+
+  lut = meta_gamma_lut_new_sized (lut_size);
+  meta_color_profile_update_gamma_lut (color_profile, temperature, lut);
+
+  return lut;
+}
+
 const MetaColorCalibration *
 meta_color_profile_get_calibration (MetaColorProfile *color_profile)
 {
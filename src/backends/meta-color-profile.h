@@ -73,10 +73,15 @@ const char * meta_color_profile_get_file_path (MetaColorProfile *color_profile);
 
 const char * meta_color_profile_get_brightness_profile (MetaColorProfile *color_profile);
 
+META_EXPORT_TEST
 MetaGammaLut * meta_color_profile_generate_gamma_lut (MetaColorProfile *color_profile,
                                                       unsigned int      temperature,
                                                       size_t            lut_size);
 
+void meta_color_profile_update_gamma_lut (MetaColorProfile *color_profile,
+                                          unsigned int      temperature,
+                                          MetaGammaLut     *lut);
+
 META_EXPORT_TEST
 const MetaColorCalibration * meta_color_profile_get_calibration (MetaColorProfile *color_profile);
 
@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A keymap snapshot bundles a compiled XKB keymap with everything that
+ * is derived from it and otherwise recomputed on every use: a keysym
+ * lookup table per layout, and optionally the serialized keymap that is
+ * handed out to clients. A snapshot never changes after creation, so
+ * the same snapshot can be kept around and handed out again whenever the
+ * same keymap is configured.
+ *
+ * The keymap itself is not thread safe, so a snapshot must only be used
+ * by the thread that created it.
+ */
+
+#include "config.h"
+
+#include "backends/meta-keymap-snapshot.h"
+
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backends/meta-backend-private.h"
+#include "backends/meta-keymap-utils.h"
+
+typedef struct _MetaKeysymEntry
+{
+  xkb_keysym_t keysym;
+  xkb_keycode_t keycode;
+  xkb_level_index_t level;
+} MetaKeysymEntry;
+
+typedef struct _MetaKeymapSnapshotLayout
+{
+  /* Sorted by keysym, with only the first keycode and level in keymap
+   * order for each keysym */
+  MetaKeysymEntry *entries;
+  size_t n_entries;
+} MetaKeymapSnapshotLayout;
+
+struct _MetaKeymapSnapshot
+{
+  gatomicrefcount ref_count;
+
+  struct xkb_keymap *keymap;
+  MetaAnonymousFile *keymap_file;
+
+  MetaKeymapSnapshotLayout *layouts;
+  xkb_layout_index_t n_layouts;
+};
+
+typedef struct
+{
+  xkb_layout_index_t layout;
+  GArray *entries;
+} CollectKeysymsData;
+
+static void
+collect_keysyms_iter (struct xkb_keymap *keymap,
+                      xkb_keycode_t      keycode,
+                      void              *user_data)
+{
+  CollectKeysymsData *data = user_data;
+  xkb_level_index_t n_levels, level;
+
+  n_levels = xkb_keymap_num_levels_for_key (keymap, keycode, data->layout);
+  for (level = 0; level < n_levels; level++)
+    {
+      const xkb_keysym_t *keysyms;
+      int n_keysyms, i;
+
+      n_keysyms = xkb_keymap_key_get_syms_by_level (keymap,
+                                                    keycode,
+                                                    data->layout,
+                                                    level,
+                                                    &keysyms);
+      for (i = 0; i < n_keysyms; i++)
+        {
+          MetaKeysymEntry entry = {
+            .keysym = keysyms[i],
+            .keycode = keycode,
+            .level = level,
+          };
+
+          g_array_append_val (data->entries, entry);
+        }
+    }
+}
+
+static int
+compare_keysym_entries (const void *a,
+                        const void *b)
+{
+  const MetaKeysymEntry *entry_a = a;
+  const MetaKeysymEntry *entry_b = b;
+
+  if (entry_a->keysym != entry_b->keysym)
+    return entry_a->keysym < entry_b->keysym ? -1 : 1;
+
+  /* Keep the keymap order for the same keysym, so the first match wins */
+  if (entry_a->keycode != entry_b->keycode)
+    return entry_a->keycode < entry_b->keycode ? -1 : 1;
+
+  if (entry_a->level != entry_b->level)
+    return entry_a->level < entry_b->level ? -1 : 1;
+
+  return 0;
+}
+
+static void
+init_layout (MetaKeymapSnapshot *snapshot,
+             xkb_layout_index_t  layout_index)
+{
+  MetaKeymapSnapshotLayout *layout = &snapshot->layouts[layout_index];
+  g_autoptr (GArray) entries = NULL;
+  CollectKeysymsData data;
+  unsigned int i, n_entries;
+
+  entries = g_array_new (FALSE, FALSE, sizeof (MetaKeysymEntry));
+  data = (CollectKeysymsData) {
+    .layout = layout_index,
+    .entries = entries,
+  };
+  xkb_keymap_key_for_each (snapshot->keymap, collect_keysyms_iter, &data);
+
+  qsort (entries->data, entries->len, sizeof (MetaKeysymEntry),
+         compare_keysym_entries);
+
+  n_entries = 0;
+  for (i = 0; i < entries->len; i++)
+    {
+      MetaKeysymEntry *entry = &g_array_index (entries, MetaKeysymEntry, i);
+
+      if (n_entries > 0 &&
+          g_array_index (entries, MetaKeysymEntry, n_entries - 1).keysym ==
+          entry->keysym)
+        continue;
+
+      g_array_index (entries, MetaKeysymEntry, n_entries++) = *entry;
+    }
+
+  g_array_set_size (entries, n_entries);
+  layout->n_entries = n_entries;
+  layout->entries = (MetaKeysymEntry *) g_array_free (g_steal_pointer (&entries),
+                                                      FALSE);
+}
+
+static gboolean
+serialize_keymap (MetaKeymapSnapshot  *snapshot,
+                  GError             **error)
+{
+  char *keymap_string;
+  size_t keymap_size;
+
+  keymap_string = xkb_keymap_get_as_string (snapshot->keymap,
+                                            XKB_KEYMAP_FORMAT_TEXT_V1);
+  if (!keymap_string)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Failed to get string version of keymap");
+      return FALSE;
+    }
+  keymap_size = strlen (keymap_string) + 1;
+
+  snapshot->keymap_file =
+    meta_anonymous_file_new (keymap_size, (const uint8_t *) keymap_string);
+  free (keymap_string);
+
+  if (!snapshot->keymap_file)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Failed to create anonymous file for keymap");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+MetaKeymapSnapshot *
+meta_keymap_snapshot_new (struct xkb_keymap        *keymap,
+                          MetaKeymapSnapshotFlags   flags,
+                          GError                  **error)
+{
+  g_autoptr (MetaKeymapSnapshot) snapshot = NULL;
+  xkb_layout_index_t i;
+
+  snapshot = g_new0 (MetaKeymapSnapshot, 1);
+  g_atomic_ref_count_init (&snapshot->ref_count);
+  snapshot->keymap = xkb_keymap_ref (keymap);
+
+  snapshot->n_layouts = xkb_keymap_num_layouts (keymap);
+  snapshot->layouts = g_new0 (MetaKeymapSnapshotLayout, snapshot->n_layouts);
+  for (i = 0; i < snapshot->n_layouts; i++)
+    init_layout (snapshot, i);
+
+  if (flags & META_KEYMAP_SNAPSHOT_FLAG_SERIALIZE &&
+      !serialize_keymap (snapshot, error))
+    return NULL;
+
+  return g_steal_pointer (&snapshot);
+}
+
+MetaKeymapSnapshot *
+meta_keymap_snapshot_new_from_names (const char               *layouts,
+                                     const char               *variants,
+                                     const char               *options,
+                                     const char               *model,
+                                     MetaKeymapSnapshotFlags   flags,
+                                     GError                  **error)
+{
+  struct xkb_rule_names names;
+  struct xkb_context *context;
+  struct xkb_keymap *keymap;
+  MetaKeymapSnapshot *snapshot;
+
+  names.rules = DEFAULT_XKB_RULES_FILE;
+  names.model = model;
+  names.layout = layouts;
+  names.variant = variants;
+  names.options = options;
+
+  context = meta_create_xkb_context ();
+  keymap = xkb_keymap_new_from_names (context, &names,
+                                      XKB_KEYMAP_COMPILE_NO_FLAGS);
+  xkb_context_unref (context);
+
+  if (!keymap)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Unable to load configured keymap: rules=%s, model=%s, "
+                   "layout=%s, variant=%s, options=%s",
+                   DEFAULT_XKB_RULES_FILE, model, layouts,
+                   variants, options);
+      return NULL;
+    }
+
+  snapshot = meta_keymap_snapshot_new (keymap, flags, error);
+  xkb_keymap_unref (keymap);
+
+  return snapshot;
+}
+
+char *
+meta_keymap_snapshot_names_to_key (const char *layouts,
+                                   const char *variants,
+                                   const char *options,
+                                   const char *model)
+{
+  return g_strdup_printf ("%s:%s:%s:%s",
+                          layouts, variants, options, model);
+}
+
+MetaKeymapSnapshot *
+meta_keymap_snapshot_ref (MetaKeymapSnapshot *snapshot)
+{
+  g_atomic_ref_count_inc (&snapshot->ref_count);
+  return snapshot;
+}
+
+void
+meta_keymap_snapshot_unref (MetaKeymapSnapshot *snapshot)
+{
+  xkb_layout_index_t i;
+
+  if (!g_atomic_ref_count_dec (&snapshot->ref_count))
+    return;
+
+  for (i = 0; i < snapshot->n_layouts; i++)
+    g_free (snapshot->layouts[i].entries);
+  g_free (snapshot->layouts);
+  g_clear_pointer (&snapshot->keymap_file, meta_anonymous_file_free);
+  xkb_keymap_unref (snapshot->keymap);
+  g_free (snapshot);
+}
+
+struct xkb_keymap *
+meta_keymap_snapshot_get_keymap (MetaKeymapSnapshot *snapshot)
+{
+  return snapshot->keymap;
+}
+
+MetaAnonymousFile *
+meta_keymap_snapshot_get_keymap_file (MetaKeymapSnapshot *snapshot)
+{
+  return snapshot->keymap_file;
+}
+
+static int
+compare_keysym_to_entry (const void *key,
+                         const void *element)
+{
+  xkb_keysym_t keysym = *(const xkb_keysym_t *) key;
+  const MetaKeysymEntry *entry = element;
+
+  if (keysym == entry->keysym)
+    return 0;
+
+  return keysym < entry->keysym ? -1 : 1;
+}
+
+gboolean
+meta_keymap_snapshot_lookup_keysym (MetaKeymapSnapshot *snapshot,
+                                    xkb_layout_index_t  layout,
+                                    xkb_keysym_t        keysym,
+                                    xkb_keycode_t      *keycode_out,
+                                    xkb_level_index_t  *level_out)
+{
+  MetaKeymapSnapshotLayout *snapshot_layout;
+  MetaKeysymEntry *entry;
+
+  if (layout >= snapshot->n_layouts)
+    return FALSE;
+
+  snapshot_layout = &snapshot->layouts[layout];
+  entry = bsearch (&keysym,
+                   snapshot_layout->entries,
+                   snapshot_layout->n_entries,
+                   sizeof (MetaKeysymEntry),
+                   compare_keysym_to_entry);
+  if (!entry)
+    return FALSE;
+
+  if (keycode_out)
+    *keycode_out = entry->keycode;
+  if (level_out)
+    *level_out = entry->level;
+
+  return TRUE;
+}
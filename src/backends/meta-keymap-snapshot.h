@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <xkbcommon/xkbcommon.h>
+
+#include "core/meta-anonymous-file.h"
+#include "core/util-private.h"
+
+typedef enum _MetaKeymapSnapshotFlags
+{
+  META_KEYMAP_SNAPSHOT_FLAG_NONE = 0,
+  META_KEYMAP_SNAPSHOT_FLAG_SERIALIZE = 1 << 0,
+} MetaKeymapSnapshotFlags;
+
+typedef struct _MetaKeymapSnapshot MetaKeymapSnapshot;
+
+META_EXPORT_TEST
+MetaKeymapSnapshot * meta_keymap_snapshot_new (struct xkb_keymap        *keymap,
+                                               MetaKeymapSnapshotFlags   flags,
+                                               GError                  **error);
+
+META_EXPORT_TEST
+MetaKeymapSnapshot * meta_keymap_snapshot_new_from_names (const char               *layouts,
+                                                          const char               *variants,
+                                                          const char               *options,
+                                                          const char               *model,
+                                                          MetaKeymapSnapshotFlags   flags,
+                                                          GError                  **error);
+
+char * meta_keymap_snapshot_names_to_key (const char *layouts,
+                                          const char *variants,
+                                          const char *options,
+                                          const char *model);
+
+META_EXPORT_TEST
+MetaKeymapSnapshot * meta_keymap_snapshot_ref (MetaKeymapSnapshot *snapshot);
+
+META_EXPORT_TEST
+void meta_keymap_snapshot_unref (MetaKeymapSnapshot *snapshot);
+
+META_EXPORT_TEST
+struct xkb_keymap * meta_keymap_snapshot_get_keymap (MetaKeymapSnapshot *snapshot);
+
+META_EXPORT_TEST
+MetaAnonymousFile * meta_keymap_snapshot_get_keymap_file (MetaKeymapSnapshot *snapshot);
+
+META_EXPORT_TEST
+gboolean meta_keymap_snapshot_lookup_keysym (MetaKeymapSnapshot *snapshot,
+                                             xkb_layout_index_t  layout,
+                                             xkb_keysym_t        keysym,
+                                             xkb_keycode_t      *keycode_out,
+                                             xkb_level_index_t  *level_out);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaKeymapSnapshot, meta_keymap_snapshot_unref)
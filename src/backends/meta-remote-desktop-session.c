@@ -48,6 +48,7 @@
 #define META_REMOTE_DESKTOP_SESSION_DBUS_PATH "/org/gnome/Mutter/RemoteDesktop/Session"
 
 #define TRANSFER_REQUEST_CLEANUP_TIMEOUT_MS (s2ms (15))
+#define MAX_DISCRETE_SCROLL_STEPS 100
 
 enum
 {
@@ -65,6 +66,20 @@ typedef enum _MetaRemoteDesktopNotifyAxisFlags
   META_REMOTE_DESKTOP_NOTIFY_AXIS_FLAGS_SOURCE_CONTINUOUS = 1 << 3,
 } MetaRemoteDesktopNotifyAxisFlags;
 
+typedef enum _MetaRemoteDesktopEventType
+{
+  META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYCODE = 1,
+  META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYSYM = 2,
+  META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_BUTTON = 3,
+  META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS = 4,
+  META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS_DISCRETE = 5,
+  META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_RELATIVE = 6,
+  META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_ABSOLUTE = 7,
+  META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_DOWN = 8,
+  META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_MOTION = 9,
+  META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_UP = 10,
+} MetaRemoteDesktopEventType;
+
 typedef struct _SelectionReadData
 {
   MetaRemoteDesktopSession *session;
@@ -905,7 +920,9 @@ handle_notify_pointer_axis_discrete (MetaDBusRemoteDesktopSession *skeleton,
       return TRUE;
     }
 
-  if (steps == 0)
+  if (steps == 0 ||
+      steps < -MAX_DISCRETE_SCROLL_STEPS ||
+      steps > MAX_DISCRETE_SCROLL_STEPS)
     {
       g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
                                              G_DBUS_ERROR_FAILED,
@@ -1177,6 +1194,452 @@ handle_notify_touch_up (MetaDBusRemoteDesktopSession *skeleton,
   return TRUE;
 }
 
+static ClutterVirtualInputDevice *
+get_virtual_device (MetaRemoteDesktopSession *session,
+                    ClutterInputDeviceType    device_type)
+{
+  switch (device_type)
+    {
+    case CLUTTER_POINTER_DEVICE:
+      return session->virtual_pointer;
+    case CLUTTER_KEYBOARD_DEVICE:
+      return session->virtual_keyboard;
+    case CLUTTER_TOUCHSCREEN_DEVICE:
+      return session->virtual_touchscreen;
+    default:
+      g_assert_not_reached ();
+    }
+
+  return NULL;
+}
+
+static void
+add_event (GArray                         *events,
+           GArray                         *device_types,
+           ClutterInputDeviceType          device_type,
+           const ClutterVirtualInputEvent *event)
+{
+  g_array_append_val (events, *event);
+  g_array_append_val (device_types, device_type);
+}
+
+static gboolean
+transform_stream_position (MetaRemoteDesktopSession  *session,
+                           const char                *stream_path,
+                           double                     x,
+                           double                     y,
+                           double                    *abs_x,
+                           double                    *abs_y,
+                           gboolean                  *is_configured,
+                           GError                   **error)
+{
+  MetaScreenCastStream *stream;
+
+  if (!session->screen_cast_session)
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                   "No screen cast active");
+      return FALSE;
+    }
+
+  stream = meta_screen_cast_session_get_stream (session->screen_cast_session,
+                                                stream_path);
+  if (!stream)
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                   "Unknown stream");
+      return FALSE;
+    }
+
+  *is_configured =
+    meta_screen_cast_stream_transform_position (stream, x, y, abs_x, abs_y);
+  return TRUE;
+}
+
+static gboolean
+has_virtual_device (MetaRemoteDesktopSession *session,
+                    ClutterInputDeviceType    device_type,
+                    unsigned int              pending_devices)
+{
+  if (pending_devices & (1 << device_type))
+    return TRUE;
+
+  return get_virtual_device (session, device_type) != NULL;
+}
+
+static gboolean
+parse_event (MetaRemoteDesktopSession  *session,
+             uint32_t                   type,
+             uint64_t                   time_us,
+             GVariant                  *args,
+             GArray                    *events,
+             GArray                    *device_types,
+             unsigned int              *pending_devices,
+             GError                   **error)
+{
+  ClutterVirtualInputEvent event = { .time_us = time_us };
+  const char *args_type;
+
+  switch (type)
+    {
+    case META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYCODE:
+    case META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYSYM:
+      args_type = "(ub)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_BUTTON:
+      args_type = "(ib)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS:
+      args_type = "(ddu)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS_DISCRETE:
+      args_type = "(ui)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_RELATIVE:
+      args_type = "(dd)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_ABSOLUTE:
+      args_type = "(sdd)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_DOWN:
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_MOTION:
+      args_type = "(sudd)";
+      break;
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_UP:
+      args_type = "(u)";
+      break;
+    default:
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                   "Unknown event type %u", type);
+      return FALSE;
+    }
+
+  if (!g_variant_is_of_type (args, G_VARIANT_TYPE (args_type)))
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                   "Invalid arguments '%s' for event type %u, expected '%s'",
+                   g_variant_get_type_string (args), type, args_type);
+      return FALSE;
+    }
+
+  switch ((MetaRemoteDesktopEventType) type)
+    {
+    case META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYCODE:
+    case META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYSYM:
+      {
+        uint32_t key;
+        gboolean pressed;
+
+        g_variant_get (args, "(ub)", &key, &pressed);
+
+        if (pressed)
+          *pending_devices |= 1 << CLUTTER_KEYBOARD_DEVICE;
+        else if (!has_virtual_device (session, CLUTTER_KEYBOARD_DEVICE,
+                                      *pending_devices))
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid key event");
+            return FALSE;
+          }
+
+        if (type == META_REMOTE_DESKTOP_EVENT_TYPE_KEYBOARD_KEYCODE)
+          event.type = CLUTTER_VIRTUAL_INPUT_EVENT_KEY;
+        else
+          event.type = CLUTTER_VIRTUAL_INPUT_EVENT_KEYVAL;
+        event.key.key = key;
+        event.key.key_state = pressed ? CLUTTER_KEY_STATE_PRESSED :
+                                        CLUTTER_KEY_STATE_RELEASED;
+        add_event (events, device_types, CLUTTER_KEYBOARD_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_BUTTON:
+      {
+        int button_code;
+        gboolean pressed;
+
+        g_variant_get (args, "(ib)", &button_code, &pressed);
+
+        if (pressed)
+          *pending_devices |= 1 << CLUTTER_POINTER_DEVICE;
+        else if (!has_virtual_device (session, CLUTTER_POINTER_DEVICE,
+                                      *pending_devices))
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid button event");
+            return FALSE;
+          }
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_BUTTON;
+        event.button.button = meta_evdev_button_to_clutter (button_code);
+        event.button.button_state = pressed ? CLUTTER_BUTTON_STATE_PRESSED :
+                                              CLUTTER_BUTTON_STATE_RELEASED;
+        add_event (events, device_types, CLUTTER_POINTER_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS:
+      {
+        double dx, dy;
+        uint32_t flags;
+        ClutterScrollSource scroll_source;
+
+        g_variant_get (args, "(ddu)", &dx, &dy, &flags);
+
+        if (!clutter_scroll_source_from_axis_flags (flags, &scroll_source))
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid scroll source");
+            return FALSE;
+          }
+
+        *pending_devices |= 1 << CLUTTER_POINTER_DEVICE;
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_SCROLL_CONTINUOUS;
+        event.scroll.dx = dx;
+        event.scroll.dy = dy;
+        event.scroll.scroll_source = scroll_source;
+        event.scroll.finish_flags = CLUTTER_SCROLL_FINISHED_NONE;
+        if (flags & META_REMOTE_DESKTOP_NOTIFY_AXIS_FLAGS_FINISH)
+          {
+            event.scroll.finish_flags |= (CLUTTER_SCROLL_FINISHED_HORIZONTAL |
+                                          CLUTTER_SCROLL_FINISHED_VERTICAL);
+          }
+        add_event (events, device_types, CLUTTER_POINTER_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_AXIS_DISCRETE:
+      {
+        unsigned int axis;
+        int steps;
+        int step_count;
+
+        g_variant_get (args, "(ui)", &axis, &steps);
+
+        if (axis > 1)
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid axis value");
+            return FALSE;
+          }
+
+        if (steps == 0 ||
+            steps < -MAX_DISCRETE_SCROLL_STEPS ||
+            steps > MAX_DISCRETE_SCROLL_STEPS)
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid axis steps value");
+            return FALSE;
+          }
+
+        *pending_devices |= 1 << CLUTTER_POINTER_DEVICE;
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_DISCRETE_SCROLL;
+        event.discrete_scroll.direction =
+          discrete_steps_to_scroll_direction (axis, steps);
+        event.discrete_scroll.scroll_source = CLUTTER_SCROLL_SOURCE_WHEEL;
+        for (step_count = 0; step_count < abs (steps); step_count++)
+          add_event (events, device_types, CLUTTER_POINTER_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_RELATIVE:
+      {
+        *pending_devices |= 1 << CLUTTER_POINTER_DEVICE;
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_RELATIVE_MOTION;
+        g_variant_get (args, "(dd)", &event.motion.x, &event.motion.y);
+        add_event (events, device_types, CLUTTER_POINTER_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_ABSOLUTE:
+      {
+        const char *stream_path;
+        double x, y;
+        gboolean is_configured;
+
+        g_variant_get (args, "(&sdd)", &stream_path, &x, &y);
+
+        if (!transform_stream_position (session, stream_path, x, y,
+                                        &event.motion.x, &event.motion.y,
+                                        &is_configured, error))
+          return FALSE;
+
+        *pending_devices |= 1 << CLUTTER_POINTER_DEVICE;
+
+        if (!is_configured)
+          {
+            meta_topic (META_DEBUG_REMOTE_DESKTOP,
+                        "Dropping early absolute pointer motion (%f, %f)",
+                        x, y);
+            return TRUE;
+          }
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_ABSOLUTE_MOTION;
+        add_event (events, device_types, CLUTTER_POINTER_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_DOWN:
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_MOTION:
+      {
+        const char *stream_path;
+        unsigned int slot;
+        double x, y;
+        gboolean is_configured;
+
+        g_variant_get (args, "(&sudd)", &stream_path, &slot, &x, &y);
+
+        if (slot >= CLUTTER_VIRTUAL_INPUT_DEVICE_MAX_TOUCH_SLOTS)
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Touch slot out of range");
+            return FALSE;
+          }
+
+        if (!transform_stream_position (session, stream_path, x, y,
+                                        &event.touch.x, &event.touch.y,
+                                        &is_configured, error))
+          return FALSE;
+
+        if (type == META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_DOWN)
+          {
+            *pending_devices |= 1 << CLUTTER_TOUCHSCREEN_DEVICE;
+            event.type = CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN;
+          }
+        else
+          {
+            if (!has_virtual_device (session, CLUTTER_TOUCHSCREEN_DEVICE,
+                                     *pending_devices))
+              {
+                g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                             "Invalid touch point");
+                return FALSE;
+              }
+
+            event.type = CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION;
+          }
+
+        if (!is_configured)
+          {
+            meta_topic (META_DEBUG_REMOTE_DESKTOP,
+                        "Dropping early touch event (%f, %f)", x, y);
+            return TRUE;
+          }
+
+        event.touch.slot = slot;
+        add_event (events, device_types, CLUTTER_TOUCHSCREEN_DEVICE, &event);
+        return TRUE;
+      }
+    case META_REMOTE_DESKTOP_EVENT_TYPE_TOUCH_UP:
+      {
+        unsigned int slot;
+
+        g_variant_get (args, "(u)", &slot);
+
+        if (slot >= CLUTTER_VIRTUAL_INPUT_DEVICE_MAX_TOUCH_SLOTS)
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Touch slot out of range");
+            return FALSE;
+          }
+
+        if (!has_virtual_device (session, CLUTTER_TOUCHSCREEN_DEVICE,
+                                 *pending_devices))
+          {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                         "Invalid touch point");
+            return FALSE;
+          }
+
+        event.type = CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_UP;
+        event.touch.slot = slot;
+        add_event (events, device_types, CLUTTER_TOUCHSCREEN_DEVICE, &event);
+        return TRUE;
+      }
+    }
+
+  g_assert_not_reached ();
+  return FALSE;
+}
+
+static gboolean
+handle_notify_events (MetaDBusRemoteDesktopSession *skeleton,
+                      GDBusMethodInvocation        *invocation,
+                      GVariant                     *events_variant)
+{
+  MetaRemoteDesktopSession *session = META_REMOTE_DESKTOP_SESSION (skeleton);
+  g_autoptr (GArray) events = NULL;
+  g_autoptr (GArray) device_types = NULL;
+  g_autoptr (GError) error = NULL;
+  GVariantIter iter;
+  uint32_t type;
+  uint64_t time_us;
+  GVariant *args;
+  size_t n_events;
+  unsigned int pending_devices = 0;
+  unsigned int i, run_start;
+
+  if (!meta_remote_desktop_session_check_can_notify (session, invocation))
+    return TRUE;
+
+  n_events = g_variant_n_children (events_variant);
+  events = g_array_sized_new (FALSE, FALSE, sizeof (ClutterVirtualInputEvent),
+                              n_events);
+  device_types = g_array_sized_new (FALSE, FALSE,
+                                    sizeof (ClutterInputDeviceType),
+                                    n_events);
+
+  /* Validate the whole batch up front, so that either all or none of the
+   * events are emitted. */
+  g_variant_iter_init (&iter, events_variant);
+  while (g_variant_iter_next (&iter, "(utv)", &type, &time_us, &args))
+    {
+      gboolean parsed;
+
+      parsed = parse_event (session, type, time_us, args,
+                            events, device_types, &pending_devices,
+                            &error);
+      g_variant_unref (args);
+
+      if (!parsed)
+        {
+          g_dbus_method_invocation_return_gerror (invocation, error);
+          return TRUE;
+        }
+    }
+
+  /* Only create virtual devices once the whole batch is known to be valid. */
+  if (pending_devices & (1 << CLUTTER_KEYBOARD_DEVICE))
+    ensure_virtual_device (session, CLUTTER_KEYBOARD_DEVICE);
+  if (pending_devices & (1 << CLUTTER_POINTER_DEVICE))
+    ensure_virtual_device (session, CLUTTER_POINTER_DEVICE);
+  if (pending_devices & (1 << CLUTTER_TOUCHSCREEN_DEVICE))
+    ensure_virtual_device (session, CLUTTER_TOUCHSCREEN_DEVICE);
+
+  /* Consecutive events of the same virtual device are handed over as one
+   * batch; each batch is dispatched in order on the input thread. */
+  run_start = 0;
+  for (i = 1; i <= events->len; i++)
+    {
+      ClutterInputDeviceType device_type =
+        g_array_index (device_types, ClutterInputDeviceType, run_start);
+
+      if (i < events->len &&
+          g_array_index (device_types, ClutterInputDeviceType, i) == device_type)
+        continue;
+
+      clutter_virtual_input_device_notify_events (get_virtual_device (session,
+                                                                      device_type),
+                                                  &g_array_index (events,
+                                                                  ClutterVirtualInputEvent,
+                                                                  run_start),
+                                                  i - run_start);
+      run_start = i;
+    }
+
+  meta_dbus_remote_desktop_session_complete_notify_events (skeleton,
+                                                           invocation);
+
+  return TRUE;
+}
+
 static MetaSelectionSourceRemote *
 create_remote_desktop_source (MetaRemoteDesktopSession  *session,
                               GVariant                  *mime_types_variant,
@@ -2016,6 +2479,7 @@ meta_remote_desktop_session_init_iface (MetaDBusRemoteDesktopSessionIface *iface
   iface->handle_notify_touch_down = handle_notify_touch_down;
   iface->handle_notify_touch_motion = handle_notify_touch_motion;
   iface->handle_notify_touch_up = handle_notify_touch_up;
+  iface->handle_notify_events = handle_notify_events;
   iface->handle_enable_clipboard = handle_enable_clipboard;
   iface->handle_disable_clipboard = handle_disable_clipboard;
   iface->handle_set_selection = handle_set_selection;
@@ -38,7 +38,7 @@
 
 #define META_REMOTE_DESKTOP_DBUS_SERVICE "org.gnome.Mutter.RemoteDesktop"
 #define META_REMOTE_DESKTOP_DBUS_PATH "/org/gnome/Mutter/RemoteDesktop"
-#define META_REMOTE_DESKTOP_API_VERSION 1
+#define META_REMOTE_DESKTOP_API_VERSION 2
 
 struct _MetaRemoteDesktop
 {
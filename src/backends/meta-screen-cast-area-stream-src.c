@@ -26,6 +26,7 @@
 #include "backends/meta-cursor-tracker-private.h"
 #include "backends/meta-dbus-session-manager.h"
 #include "backends/meta-screen-cast-area-stream.h"
+#include "backends/meta-screen-cast-capture-hub.h"
 #include "backends/meta-screen-cast-session.h"
 #include "backends/meta-stage-private.h"
 #include "clutter/clutter.h"
@@ -52,6 +53,8 @@ struct _MetaScreenCastAreaStreamSrc
   gulong prepare_frame_handler_id;
 
   guint maybe_record_idle_id;
+
+  MetaScreenCastCaptureHub *capture_hub;
 };
 
 static void
@@ -453,6 +456,7 @@ meta_screen_cast_area_stream_src_disable (MetaScreenCastStreamSrc *src)
                           stage);
 
   g_clear_handle_id (&area_src->maybe_record_idle_id, g_source_remove);
+  g_clear_object (&area_src->capture_hub);
 
   switch (meta_screen_cast_stream_get_cursor_mode (stream))
     {
@@ -465,17 +469,36 @@ meta_screen_cast_area_stream_src_disable (MetaScreenCastStreamSrc *src)
     }
 }
 
-static gboolean
-meta_screen_cast_area_stream_src_record_to_buffer (MetaScreenCastStreamSrc   *src,
-                                                   MetaScreenCastPaintPhase   paint_phase,
-                                                   int                        width,
-                                                   int                        height,
-                                                   int                        stride,
-                                                   uint8_t                   *data,
-                                                   GError                   **error)
+static MetaScreenCastCaptureHub *
+ensure_capture_hub (MetaScreenCastAreaStreamSrc *area_src,
+                    ClutterStage                *stage,
+                    const MtkRectangle          *rect,
+                    float                        scale,
+                    ClutterPaintFlag             paint_flags)
 {
-  MetaScreenCastAreaStreamSrc *area_src =
-    META_SCREEN_CAST_AREA_STREAM_SRC (src);
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (area_src);
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+
+  if (area_src->capture_hub &&
+      meta_screen_cast_capture_hub_matches (area_src->capture_hub, stage, rect,
+                                            scale, paint_flags))
+    return area_src->capture_hub;
+
+  g_clear_object (&area_src->capture_hub);
+  area_src->capture_hub =
+    meta_screen_cast_acquire_capture_hub (screen_cast, stage, rect,
+                                          scale, paint_flags);
+
+  return area_src->capture_hub;
+}
+
+static MetaScreenCastCaptureHub *
+ensure_area_capture_hub (MetaScreenCastAreaStreamSrc *area_src)
+{
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (area_src);
   MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
   MetaScreenCastAreaStream *area_stream = META_SCREEN_CAST_AREA_STREAM (stream);
   ClutterStage *stage;
@@ -498,17 +521,54 @@ meta_screen_cast_area_stream_src_record_to_buffer (MetaScreenCastStreamSrc   *sr
       break;
     }
 
-  if (!clutter_stage_paint_to_buffer (stage, area, scale,
-                                      data,
-                                      stride,
-                                      COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
-                                      paint_flags,
-                                      error))
+  return ensure_capture_hub (area_src, stage, area, scale, paint_flags);
+}
+
+static gboolean
+meta_screen_cast_area_stream_src_record_to_buffer (MetaScreenCastStreamSrc   *src,
+                                                   MetaScreenCastPaintPhase   paint_phase,
+                                                   int                        width,
+                                                   int                        height,
+                                                   int                        stride,
+                                                   uint8_t                   *data,
+                                                   GError                   **error)
+{
+  MetaScreenCastAreaStreamSrc *area_src =
+    META_SCREEN_CAST_AREA_STREAM_SRC (src);
+  MetaScreenCastCaptureHub *capture_hub;
+
+  capture_hub = ensure_area_capture_hub (area_src);
+  if (!meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                      width, height,
+                                                      stride, data,
+                                                      error))
     return FALSE;
 
   return TRUE;
 }
 
+static void
+meta_screen_cast_area_stream_src_record_to_buffer_async (MetaScreenCastStreamSrc *src,
+                                                         int                      width,
+                                                         int                      height,
+                                                         int                      stride,
+                                                         uint8_t                 *data,
+                                                         GCancellable            *cancellable,
+                                                         GAsyncReadyCallback      callback,
+                                                         gpointer                 user_data)
+{
+  MetaScreenCastAreaStreamSrc *area_src =
+    META_SCREEN_CAST_AREA_STREAM_SRC (src);
+  MetaScreenCastCaptureHub *capture_hub;
+
+  capture_hub = ensure_area_capture_hub (area_src);
+  meta_screen_cast_capture_hub_record_to_buffer_async (capture_hub,
+                                                       width, height,
+                                                       stride, data,
+                                                       cancellable,
+                                                       callback, user_data);
+}
+
 static gboolean
 meta_screen_cast_area_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc   *src,
                                                         MetaScreenCastPaintPhase   paint_phase,
@@ -521,6 +581,7 @@ meta_screen_cast_area_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc
   MetaScreenCastAreaStream *area_stream = META_SCREEN_CAST_AREA_STREAM (stream);
   MetaBackend *backend = get_backend (area_src);
   ClutterStage *stage;
+  MetaScreenCastCaptureHub *capture_hub;
   MtkRectangle *area;
   float scale;
   ClutterPaintFlag paint_flags = CLUTTER_PAINT_FLAG_CLEAR;
@@ -539,9 +600,11 @@ meta_screen_cast_area_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc
       paint_flags |= CLUTTER_PAINT_FLAG_FORCE_CURSORS;
       break;
     }
-  clutter_stage_paint_to_framebuffer (stage, framebuffer,
-                                      area, scale,
-                                      paint_flags);
+  capture_hub = ensure_capture_hub (area_src, stage, area, scale, paint_flags);
+  if (!meta_screen_cast_capture_hub_record_to_framebuffer (capture_hub,
+                                                           framebuffer,
+                                                           error))
+    return FALSE;
 
   cogl_framebuffer_flush (framebuffer);
 
@@ -724,6 +787,15 @@ meta_screen_cast_area_stream_src_new (MetaScreenCastAreaStream  *area_stream,
                          NULL);
 }
 
+static MetaScreenCastCaptureHub *
+meta_screen_cast_area_stream_src_get_capture_hub (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastAreaStreamSrc *area_src =
+    META_SCREEN_CAST_AREA_STREAM_SRC (src);
+
+  return area_src->capture_hub;
+}
+
 static void
 meta_screen_cast_area_stream_src_init (MetaScreenCastAreaStreamSrc *area_src)
 {
@@ -743,6 +815,10 @@ meta_screen_cast_area_stream_src_class_init (MetaScreenCastAreaStreamSrcClass *k
     meta_screen_cast_area_stream_src_record_to_buffer;
   src_class->record_to_framebuffer =
     meta_screen_cast_area_stream_src_record_to_framebuffer;
+  src_class->get_capture_hub =
+    meta_screen_cast_area_stream_src_get_capture_hub;
+  src_class->record_to_buffer_async =
+    meta_screen_cast_area_stream_src_record_to_buffer_async;
   src_class->record_follow_up =
     meta_screen_cast_area_stream_record_follow_up;
   src_class->is_cursor_metadata_valid =
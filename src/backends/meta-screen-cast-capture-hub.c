@@ -0,0 +1,606 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A capture hub captures a region of the stage once per painted frame and
+ * hands the result out to every stream source capturing the same region
+ * with the same paint flags. The capture is kept until the stage paints a
+ * view overlapping the region again, so streams recording in between share
+ * it instead of each painting the stage on their own.
+ *
+ * The first stream source recording into a framebuffer, e.g. a DMA buffer,
+ * records straight into it, either by blitting from the view or by painting
+ * the stage, and that framebuffer becomes the capture of the frame. Other
+ * stream sources recording into framebuffers get a blit of it, and stream
+ * sources recording into memory read it back. Only when blitting isn't
+ * possible the stage is painted directly into the stream buffer, once.
+ *
+ * Stream sources recording into memory asynchronously share a single read
+ * back per frame. The pixels are copied into every waiting stream buffer
+ * once they arrive.
+ */
+
+#include "config.h"
+
+#include "backends/meta-screen-cast-capture-hub.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "core/util-private.h"
+
+struct _MetaScreenCastCaptureHub
+{
+  GObject parent;
+
+  ClutterStage *stage;
+  MtkRectangle rect;
+  float scale;
+  ClutterPaintFlag paint_flags;
+
+  int width;
+  int height;
+
+  gulong before_paint_handler_id;
+
+  struct {
+    uint8_t *data;
+    int stride;
+    gboolean is_valid;
+  } cpu;
+
+  struct {
+    /* The framebuffer holding the capture of the current frame, if any */
+    CoglFramebuffer *capture;
+    /* Painted into when no stream recorded into a framebuffer */
+    CoglFramebuffer *offscreen;
+  } gpu;
+
+  struct {
+    /* Tasks waiting for read back pixels, oldest first */
+    GList *tasks;
+    uint64_t frame_serial;
+    gboolean in_flight;
+  } readback;
+
+  /* Bumped every time the captured region is painted again */
+  uint64_t frame_serial;
+
+  uint64_t n_captures;
+  uint64_t n_frames_served;
+};
+
+typedef struct _RecordRequest
+{
+  int width;
+  int height;
+  int stride;
+  uint8_t *data;
+  uint64_t frame_serial;
+} RecordRequest;
+
+G_DEFINE_FINAL_TYPE (MetaScreenCastCaptureHub,
+                     meta_screen_cast_capture_hub,
+                     G_TYPE_OBJECT)
+
+static CoglContext *
+get_cogl_context (void)
+{
+  ClutterBackend *clutter_backend = clutter_get_default_backend ();
+
+  return clutter_backend_get_cogl_context (clutter_backend);
+}
+
+static void
+on_before_paint (ClutterStage             *stage,
+                 ClutterStageView         *stage_view,
+                 ClutterFrame             *frame,
+                 MetaScreenCastCaptureHub *hub)
+{
+  MtkRectangle view_layout;
+
+  clutter_stage_view_get_layout (stage_view, &view_layout);
+  if (!mtk_rectangle_overlap (&hub->rect, &view_layout))
+    return;
+
+  hub->cpu.is_valid = FALSE;
+  g_clear_object (&hub->gpu.capture);
+  hub->frame_serial++;
+}
+
+static void
+ensure_cpu_data (MetaScreenCastCaptureHub *hub)
+{
+  if (hub->cpu.data)
+    return;
+
+  hub->cpu.stride = hub->width * 4;
+  hub->cpu.data = g_malloc (hub->cpu.stride * hub->height);
+}
+
+static gboolean
+ensure_gpu_capture (MetaScreenCastCaptureHub  *hub,
+                    GError                   **error)
+{
+  if (hub->gpu.capture)
+    return TRUE;
+
+  if (!hub->gpu.offscreen)
+    {
+      g_autoptr (CoglTexture) texture = NULL;
+      g_autoptr (CoglFramebuffer) framebuffer = NULL;
+
+      texture = cogl_texture_2d_new_with_size (get_cogl_context (),
+                                               hub->width, hub->height);
+      if (!texture)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       "Failed to create %dx%d texture",
+                       hub->width, hub->height);
+          return FALSE;
+        }
+
+      framebuffer = COGL_FRAMEBUFFER (cogl_offscreen_new_with_texture (texture));
+      if (!cogl_framebuffer_allocate (framebuffer, error))
+        return FALSE;
+
+      hub->gpu.offscreen = g_steal_pointer (&framebuffer);
+    }
+
+  clutter_stage_paint_to_framebuffer (hub->stage, hub->gpu.offscreen,
+                                      &hub->rect, hub->scale,
+                                      hub->paint_flags);
+  hub->n_captures++;
+  hub->gpu.capture = g_object_ref (hub->gpu.offscreen);
+
+  return TRUE;
+}
+
+static gboolean
+ensure_cpu_capture (MetaScreenCastCaptureHub  *hub,
+                    GError                   **error)
+{
+  if (hub->cpu.is_valid)
+    return TRUE;
+
+  ensure_cpu_data (hub);
+
+  if (hub->gpu.capture)
+    {
+      g_autoptr (CoglBitmap) bitmap = NULL;
+
+      /* A stream recording into a framebuffer already captured this frame,
+       * reading back is cheaper than painting again */
+      bitmap = cogl_bitmap_new_for_data (get_cogl_context (),
+                                         hub->width, hub->height,
+                                         COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
+                                         hub->cpu.stride,
+                                         hub->cpu.data);
+      cogl_framebuffer_read_pixels_into_bitmap (hub->gpu.capture,
+                                                0, 0,
+                                                COGL_READ_PIXELS_COLOR_BUFFER,
+                                                bitmap);
+    }
+  else
+    {
+      if (!clutter_stage_paint_to_buffer (hub->stage, &hub->rect, hub->scale,
+                                          hub->cpu.data,
+                                          hub->cpu.stride,
+                                          COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
+                                          hub->paint_flags,
+                                          error))
+        return FALSE;
+
+      hub->n_captures++;
+    }
+
+  hub->cpu.is_valid = TRUE;
+
+  return TRUE;
+}
+
+static void
+copy_capture (MetaScreenCastCaptureHub *hub,
+              int                       width,
+              int                       height,
+              int                       stride,
+              uint8_t                  *data)
+{
+  int row_length;
+  int n_rows;
+  int y;
+
+  row_length = MIN (width, hub->width) * 4;
+  n_rows = MIN (height, hub->height);
+
+  if (stride == hub->cpu.stride && row_length == hub->cpu.stride)
+    {
+      memcpy (data, hub->cpu.data, (size_t) stride * n_rows);
+    }
+  else
+    {
+      for (y = 0; y < n_rows; y++)
+        {
+          memcpy (data + (size_t) y * stride,
+                  hub->cpu.data + (size_t) y * hub->cpu.stride,
+                  row_length);
+        }
+    }
+
+  hub->n_frames_served++;
+}
+
+gboolean
+meta_screen_cast_capture_hub_record_to_buffer (MetaScreenCastCaptureHub  *hub,
+                                               int                        width,
+                                               int                        height,
+                                               int                        stride,
+                                               uint8_t                   *data,
+                                               GError                   **error)
+{
+  if (!ensure_cpu_capture (hub, error))
+    return FALSE;
+
+  copy_capture (hub, width, height, stride, data);
+
+  return TRUE;
+}
+
+static void
+fail_pending_records (MetaScreenCastCaptureHub *hub,
+                      const GError             *error)
+{
+  GList *tasks = g_steal_pointer (&hub->readback.tasks);
+  GList *l;
+
+  for (l = tasks; l; l = l->next)
+    {
+      GTask *task = l->data;
+
+      g_task_return_error (task, g_error_copy (error));
+    }
+
+  g_list_free_full (tasks, g_object_unref);
+}
+
+static gboolean
+copy_bitmap_to_cpu_capture (MetaScreenCastCaptureHub  *hub,
+                            CoglBitmap                *bitmap,
+                            GError                   **error)
+{
+  CoglBuffer *pixel_buffer = COGL_BUFFER (cogl_bitmap_get_buffer (bitmap));
+  int bitmap_rowstride = cogl_bitmap_get_rowstride (bitmap);
+  uint8_t *pixels;
+  int y;
+
+  pixels = cogl_buffer_map (pixel_buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (!pixels)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Failed to map pixel buffer");
+      return FALSE;
+    }
+
+  ensure_cpu_data (hub);
+
+  for (y = 0; y < hub->height; y++)
+    {
+      memcpy (hub->cpu.data + (size_t) y * hub->cpu.stride,
+              pixels + (size_t) y * bitmap_rowstride,
+              MIN (hub->cpu.stride, bitmap_rowstride));
+    }
+
+  cogl_buffer_unmap (pixel_buffer);
+
+  return TRUE;
+}
+
+static void start_readback (MetaScreenCastCaptureHub *hub);
+
+static void
+on_readback_finished (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (source_object);
+  g_autoptr (MetaScreenCastCaptureHub) hub = user_data;
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  g_autoptr (GError) error = NULL;
+  GList *tasks;
+  GList *l;
+
+  hub->readback.in_flight = FALSE;
+
+  bitmap = cogl_framebuffer_read_pixels_finish (framebuffer, result, &error);
+  if (!bitmap || !copy_bitmap_to_cpu_capture (hub, bitmap, &error))
+    {
+      fail_pending_records (hub, error);
+      return;
+    }
+
+  if (hub->readback.frame_serial == hub->frame_serial)
+    hub->cpu.is_valid = TRUE;
+
+  tasks = g_steal_pointer (&hub->readback.tasks);
+  for (l = tasks; l; l = l->next)
+    {
+      GTask *task = l->data;
+      RecordRequest *request = g_task_get_task_data (task);
+
+      /* Asked for after the region was painted again, needs another read */
+      if (request->frame_serial > hub->readback.frame_serial)
+        {
+          hub->readback.tasks = g_list_append (hub->readback.tasks,
+                                               g_object_ref (task));
+          continue;
+        }
+
+      /* The buffer may be gone already, don't touch it */
+      if (g_task_return_error_if_cancelled (task))
+        continue;
+
+      copy_capture (hub,
+                    request->width, request->height,
+                    request->stride, request->data);
+      g_task_return_boolean (task, TRUE);
+    }
+  g_list_free_full (tasks, g_object_unref);
+
+  if (hub->readback.tasks)
+    start_readback (hub);
+}
+
+static void
+start_readback (MetaScreenCastCaptureHub *hub)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!ensure_gpu_capture (hub, &error))
+    {
+      fail_pending_records (hub, error);
+      return;
+    }
+
+  hub->readback.frame_serial = hub->frame_serial;
+  hub->readback.in_flight = TRUE;
+  cogl_framebuffer_read_pixels_async (hub->gpu.capture,
+                                      0, 0,
+                                      hub->width, hub->height,
+                                      COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
+                                      NULL,
+                                      on_readback_finished,
+                                      g_object_ref (hub));
+}
+
+/* Like meta_screen_cast_capture_hub_record_to_buffer(), but without waiting
+ * for the pixels to be read back on the main thread. All streams recording
+ * the same frame share one read back. The data must stay valid until the
+ * callback is called, unless the cancellable is cancelled.
+ */
+void
+meta_screen_cast_capture_hub_record_to_buffer_async (MetaScreenCastCaptureHub *hub,
+                                                     int                       width,
+                                                     int                       height,
+                                                     int                       stride,
+                                                     uint8_t                  *data,
+                                                     GCancellable             *cancellable,
+                                                     GAsyncReadyCallback       callback,
+                                                     gpointer                  user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  RecordRequest *request;
+
+  task = g_task_new (hub, cancellable, callback, user_data);
+  g_task_set_source_tag (task,
+                         meta_screen_cast_capture_hub_record_to_buffer_async);
+
+  /* Without fences reading back would block just the same */
+  if (hub->cpu.is_valid ||
+      !cogl_has_feature (get_cogl_context (), COGL_FEATURE_ID_FENCE))
+    {
+      g_autoptr (GError) error = NULL;
+
+      if (!meta_screen_cast_capture_hub_record_to_buffer (hub,
+                                                          width, height,
+                                                          stride, data,
+                                                          &error))
+        g_task_return_error (task, g_steal_pointer (&error));
+      else
+        g_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  request = g_new0 (RecordRequest, 1);
+  request->width = width;
+  request->height = height;
+  request->stride = stride;
+  request->data = data;
+  request->frame_serial = hub->frame_serial;
+  g_task_set_task_data (task, request, g_free);
+
+  hub->readback.tasks = g_list_append (hub->readback.tasks,
+                                       g_steal_pointer (&task));
+
+  if (!hub->readback.in_flight)
+    start_readback (hub);
+}
+
+gboolean
+meta_screen_cast_capture_hub_record_to_buffer_finish (MetaScreenCastCaptureHub  *hub,
+                                                      GAsyncResult              *result,
+                                                      GError                   **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, hub), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        meta_screen_cast_capture_hub_record_to_buffer_async,
+                        FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Blits the capture of the current frame into the framebuffer, if some
+ * stream source already captured it. Returns FALSE if there was nothing to
+ * share or blitting isn't possible.
+ */
+gboolean
+meta_screen_cast_capture_hub_share_capture (MetaScreenCastCaptureHub *hub,
+                                            CoglFramebuffer          *framebuffer)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!hub->gpu.capture)
+    return FALSE;
+
+  if (hub->gpu.capture != framebuffer &&
+      !cogl_blit_framebuffer (hub->gpu.capture,
+                              framebuffer,
+                              0, 0,
+                              0, 0,
+                              MIN (hub->width,
+                                   cogl_framebuffer_get_width (framebuffer)),
+                              MIN (hub->height,
+                                   cogl_framebuffer_get_height (framebuffer)),
+                              &error))
+    {
+      meta_topic (META_DEBUG_SCREEN_CAST,
+                  "Can't share capture: %s", error->message);
+      return FALSE;
+    }
+
+  hub->n_frames_served++;
+
+  return TRUE;
+}
+
+/* Lets the hub share a framebuffer a stream source recorded the current
+ * frame into on its own, e.g. by blitting from the stage view.
+ */
+void
+meta_screen_cast_capture_hub_add_capture (MetaScreenCastCaptureHub *hub,
+                                          CoglFramebuffer          *framebuffer)
+{
+  hub->n_captures++;
+  hub->n_frames_served++;
+
+  if (hub->gpu.capture)
+    return;
+
+  if (cogl_framebuffer_get_width (framebuffer) != hub->width ||
+      cogl_framebuffer_get_height (framebuffer) != hub->height)
+    return;
+
+  hub->gpu.capture = g_object_ref (framebuffer);
+}
+
+gboolean
+meta_screen_cast_capture_hub_record_to_framebuffer (MetaScreenCastCaptureHub  *hub,
+                                                    CoglFramebuffer           *framebuffer,
+                                                    GError                   **error)
+{
+  if (meta_screen_cast_capture_hub_share_capture (hub, framebuffer))
+    return TRUE;
+
+  clutter_stage_paint_to_framebuffer (hub->stage, framebuffer,
+                                      &hub->rect, hub->scale,
+                                      hub->paint_flags);
+  meta_screen_cast_capture_hub_add_capture (hub, framebuffer);
+
+  return TRUE;
+}
+
+void
+meta_screen_cast_capture_hub_get_stats (MetaScreenCastCaptureHub *hub,
+                                        uint64_t                 *n_captures,
+                                        uint64_t                 *n_frames_served)
+{
+  if (n_captures)
+    *n_captures = hub->n_captures;
+  if (n_frames_served)
+    *n_frames_served = hub->n_frames_served;
+}
+
+gboolean
+meta_screen_cast_capture_hub_matches (MetaScreenCastCaptureHub *hub,
+                                      ClutterStage             *stage,
+                                      const MtkRectangle       *rect,
+                                      float                     scale,
+                                      ClutterPaintFlag          paint_flags)
+{
+  return (hub->stage == stage &&
+          mtk_rectangle_equal (&hub->rect, rect) &&
+          G_APPROX_VALUE (hub->scale, scale, FLT_EPSILON) &&
+          hub->paint_flags == paint_flags);
+}
+
+MetaScreenCastCaptureHub *
+meta_screen_cast_capture_hub_new (ClutterStage       *stage,
+                                  const MtkRectangle *rect,
+                                  float               scale,
+                                  ClutterPaintFlag    paint_flags)
+{
+  MetaScreenCastCaptureHub *hub;
+
+  hub = g_object_new (META_TYPE_SCREEN_CAST_CAPTURE_HUB, NULL);
+  hub->stage = stage;
+  hub->rect = *rect;
+  hub->scale = scale;
+  hub->paint_flags = paint_flags;
+  hub->width = (int) roundf (rect->width * scale);
+  hub->height = (int) roundf (rect->height * scale);
+
+  hub->before_paint_handler_id =
+    g_signal_connect (stage, "before-paint",
+                      G_CALLBACK (on_before_paint), hub);
+
+  return hub;
+}
+
+static void
+meta_screen_cast_capture_hub_finalize (GObject *object)
+{
+  MetaScreenCastCaptureHub *hub = META_SCREEN_CAST_CAPTURE_HUB (object);
+
+  meta_topic (META_DEBUG_SCREEN_CAST,
+              "Capture hub for %dx%d+%d+%d served %" G_GUINT64_FORMAT
+              " frames from %" G_GUINT64_FORMAT " captures",
+              hub->rect.width, hub->rect.height, hub->rect.x, hub->rect.y,
+              hub->n_frames_served, hub->n_captures);
+
+  g_clear_signal_handler (&hub->before_paint_handler_id, hub->stage);
+  g_clear_object (&hub->gpu.capture);
+  g_clear_object (&hub->gpu.offscreen);
+  g_clear_pointer (&hub->cpu.data, g_free);
+
+  G_OBJECT_CLASS (meta_screen_cast_capture_hub_parent_class)->finalize (object);
+}
+
+static void
+meta_screen_cast_capture_hub_init (MetaScreenCastCaptureHub *hub)
+{
+}
+
+static void
+meta_screen_cast_capture_hub_class_init (MetaScreenCastCaptureHubClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_screen_cast_capture_hub_finalize;
+}
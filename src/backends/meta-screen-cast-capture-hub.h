@@ -0,0 +1,84 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "clutter/clutter-mutter.h"
+#include "core/util-private.h"
+#include "mtk/mtk.h"
+
+#define META_TYPE_SCREEN_CAST_CAPTURE_HUB (meta_screen_cast_capture_hub_get_type ())
+G_DECLARE_FINAL_TYPE (MetaScreenCastCaptureHub,
+                      meta_screen_cast_capture_hub,
+                      META, SCREEN_CAST_CAPTURE_HUB,
+                      GObject)
+
+MetaScreenCastCaptureHub * meta_screen_cast_capture_hub_new (ClutterStage       *stage,
+                                                             const MtkRectangle *rect,
+                                                             float               scale,
+                                                             ClutterPaintFlag    paint_flags);
+
+gboolean meta_screen_cast_capture_hub_matches (MetaScreenCastCaptureHub *hub,
+                                               ClutterStage             *stage,
+                                               const MtkRectangle       *rect,
+                                               float                     scale,
+                                               ClutterPaintFlag          paint_flags);
+
+META_EXPORT_TEST
+gboolean meta_screen_cast_capture_hub_record_to_buffer (MetaScreenCastCaptureHub  *hub,
+                                                        int                        width,
+                                                        int                        height,
+                                                        int                        stride,
+                                                        uint8_t                   *data,
+                                                        GError                   **error);
+
+META_EXPORT_TEST
+void meta_screen_cast_capture_hub_record_to_buffer_async (MetaScreenCastCaptureHub *hub,
+                                                          int                       width,
+                                                          int                       height,
+                                                          int                       stride,
+                                                          uint8_t                  *data,
+                                                          GCancellable             *cancellable,
+                                                          GAsyncReadyCallback       callback,
+                                                          gpointer                  user_data);
+
+META_EXPORT_TEST
+gboolean meta_screen_cast_capture_hub_record_to_buffer_finish (MetaScreenCastCaptureHub  *hub,
+                                                               GAsyncResult              *result,
+                                                               GError                   **error);
+
+META_EXPORT_TEST
+gboolean meta_screen_cast_capture_hub_record_to_framebuffer (MetaScreenCastCaptureHub  *hub,
+                                                             CoglFramebuffer           *framebuffer,
+                                                             GError                   **error);
+
+META_EXPORT_TEST
+gboolean meta_screen_cast_capture_hub_share_capture (MetaScreenCastCaptureHub *hub,
+                                                     CoglFramebuffer          *framebuffer);
+
+void meta_screen_cast_capture_hub_add_capture (MetaScreenCastCaptureHub *hub,
+                                               CoglFramebuffer          *framebuffer);
+
+META_EXPORT_TEST
+void meta_screen_cast_capture_hub_get_stats (MetaScreenCastCaptureHub *hub,
+                                             uint64_t                 *n_captures,
+                                             uint64_t                 *n_frames_served);
@@ -28,6 +28,7 @@
 #include "backends/meta-cursor-tracker-private.h"
 #include "backends/meta-logical-monitor.h"
 #include "backends/meta-monitor.h"
+#include "backends/meta-screen-cast-capture-hub.h"
 #include "backends/meta-screen-cast-monitor-stream.h"
 #include "backends/meta-screen-cast-session.h"
 #include "backends/meta-stage-private.h"
@@ -55,6 +56,8 @@ struct _MetaScreenCastMonitorStreamSrc
   gulong stage_prepare_frame_handler_id;
 
   guint maybe_record_idle_id;
+
+  MetaScreenCastCaptureHub *capture_hub;
 };
 
 static void
@@ -535,6 +538,7 @@ meta_screen_cast_monitor_stream_src_disable (MetaScreenCastStreamSrc *src)
                           stage);
 
   g_clear_handle_id (&monitor_src->maybe_record_idle_id, g_source_remove);
+  g_clear_object (&monitor_src->capture_hub);
 
   switch (meta_screen_cast_stream_get_cursor_mode (stream))
     {
@@ -547,17 +551,36 @@ meta_screen_cast_monitor_stream_src_disable (MetaScreenCastStreamSrc *src)
     }
 }
 
-static gboolean
-meta_screen_cast_monitor_stream_src_record_to_buffer (MetaScreenCastStreamSrc   *src,
-                                                      MetaScreenCastPaintPhase   paint_phase,
-                                                      int                        width,
-                                                      int                        height,
-                                                      int                        stride,
-                                                      uint8_t                   *data,
-                                                      GError                   **error)
+static MetaScreenCastCaptureHub *
+ensure_capture_hub (MetaScreenCastMonitorStreamSrc *monitor_src,
+                    ClutterStage                   *stage,
+                    const MtkRectangle             *rect,
+                    float                           scale,
+                    ClutterPaintFlag                paint_flags)
 {
-  MetaScreenCastMonitorStreamSrc *monitor_src =
-    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (monitor_src);
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+
+  if (monitor_src->capture_hub &&
+      meta_screen_cast_capture_hub_matches (monitor_src->capture_hub, stage, rect,
+                                            scale, paint_flags))
+    return monitor_src->capture_hub;
+
+  g_clear_object (&monitor_src->capture_hub);
+  monitor_src->capture_hub =
+    meta_screen_cast_acquire_capture_hub (screen_cast, stage, rect,
+                                          scale, paint_flags);
+
+  return monitor_src->capture_hub;
+}
+
+static MetaScreenCastCaptureHub *
+ensure_monitor_capture_hub (MetaScreenCastMonitorStreamSrc *monitor_src)
+{
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (monitor_src);
   MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
   MetaBackend *backend = get_backend (monitor_src);
   ClutterStage *stage;
@@ -586,17 +609,56 @@ meta_screen_cast_monitor_stream_src_record_to_buffer (MetaScreenCastStreamSrc
       break;
     }
 
-  if (!clutter_stage_paint_to_buffer (stage, &logical_monitor->rect, scale,
-                                      data,
-                                      stride,
-                                      COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
-                                      paint_flags,
-                                      error))
+  return ensure_capture_hub (monitor_src, stage,
+                             &logical_monitor->rect, scale,
+                             paint_flags);
+}
+
+static gboolean
+meta_screen_cast_monitor_stream_src_record_to_buffer (MetaScreenCastStreamSrc   *src,
+                                                      MetaScreenCastPaintPhase   paint_phase,
+                                                      int                        width,
+                                                      int                        height,
+                                                      int                        stride,
+                                                      uint8_t                   *data,
+                                                      GError                   **error)
+{
+  MetaScreenCastMonitorStreamSrc *monitor_src =
+    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+  MetaScreenCastCaptureHub *capture_hub;
+
+  capture_hub = ensure_monitor_capture_hub (monitor_src);
+  if (!meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                      width, height,
+                                                      stride, data,
+                                                      error))
     return FALSE;
 
   return TRUE;
 }
 
+static void
+meta_screen_cast_monitor_stream_src_record_to_buffer_async (MetaScreenCastStreamSrc *src,
+                                                            int                      width,
+                                                            int                      height,
+                                                            int                      stride,
+                                                            uint8_t                 *data,
+                                                            GCancellable            *cancellable,
+                                                            GAsyncReadyCallback      callback,
+                                                            gpointer                 user_data)
+{
+  MetaScreenCastMonitorStreamSrc *monitor_src =
+    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+  MetaScreenCastCaptureHub *capture_hub;
+
+  capture_hub = ensure_monitor_capture_hub (monitor_src);
+  meta_screen_cast_capture_hub_record_to_buffer_async (capture_hub,
+                                                       width, height,
+                                                       stride, data,
+                                                       cancellable,
+                                                       callback, user_data);
+}
+
 static gboolean
 meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc   *src,
                                                            MetaScreenCastPaintPhase   paint_phase,
@@ -610,6 +672,8 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
   MetaRenderer *renderer = meta_backend_get_renderer (backend);
   ClutterStage *stage = get_stage (monitor_src);
   g_autoptr (GError) local_error = NULL;
+  MetaScreenCastCaptureHub *capture_hub;
+  ClutterPaintFlag paint_flags = CLUTTER_PAINT_FLAG_CLEAR;
   MetaMonitor *monitor;
   MetaLogicalMonitor *logical_monitor;
   MetaRendererView *renderer_view;
@@ -617,7 +681,7 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
   MtkRectangle logical_monitor_layout;
   MtkRectangle view_layout;
   MetaCrtc *crtc;
-  gboolean do_stage_paint = TRUE;
+  gboolean blitted = FALSE;
   float view_scale;
   GList *outputs;
   int x, y;
@@ -631,6 +695,26 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
   else
     view_scale = 1.0;
 
+  switch (meta_screen_cast_stream_get_cursor_mode (stream))
+    {
+    case META_SCREEN_CAST_CURSOR_MODE_METADATA:
+    case META_SCREEN_CAST_CURSOR_MODE_HIDDEN:
+      paint_flags |= CLUTTER_PAINT_FLAG_NO_CURSORS;
+      break;
+
+    case META_SCREEN_CAST_CURSOR_MODE_EMBEDDED:
+      paint_flags |= CLUTTER_PAINT_FLAG_FORCE_CURSORS;
+      break;
+    }
+
+  capture_hub = ensure_capture_hub (monitor_src, stage,
+                                    &logical_monitor_layout, view_scale,
+                                    paint_flags);
+
+  /* Another stream of this monitor already recorded the frame */
+  if (meta_screen_cast_capture_hub_share_capture (capture_hub, framebuffer))
+    goto out;
+
   if (paint_phase == META_SCREEN_CAST_PAINT_PHASE_DETACHED)
     goto stage_paint;
 
@@ -657,10 +741,10 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
 
         if (scanout)
           {
-            cogl_scanout_blit_to_framebuffer (scanout,
-                                              framebuffer,
-                                              x, y,
-                                              &local_error);
+            blitted = cogl_scanout_blit_to_framebuffer (scanout,
+                                                        framebuffer,
+                                                        x, y,
+                                                        &local_error);
           }
       }
       break;
@@ -670,13 +754,14 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
         CoglFramebuffer *view_framebuffer =
           clutter_stage_view_get_framebuffer (view);
 
-        cogl_blit_framebuffer (view_framebuffer,
-                               framebuffer,
-                               0, 0,
-                               x, y,
-                               cogl_framebuffer_get_width (view_framebuffer),
-                               cogl_framebuffer_get_height (view_framebuffer),
-                               &local_error);
+        blitted =
+          cogl_blit_framebuffer (view_framebuffer,
+                                 framebuffer,
+                                 0, 0,
+                                 x, y,
+                                 cogl_framebuffer_get_width (view_framebuffer),
+                                 cogl_framebuffer_get_height (view_framebuffer),
+                                 &local_error);
       }
       break;
 
@@ -684,38 +769,27 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
       g_assert_not_reached ();
     }
 
-  if (local_error)
+  if (blitted)
     {
-      g_warning ("Error blitting to screencast framebuffer: %s",
-                 local_error->message);
+      /* Other streams of this monitor blit from this one instead of from
+       * the view */
+      meta_screen_cast_capture_hub_add_capture (capture_hub, framebuffer);
+      goto out;
     }
 
-  do_stage_paint = local_error != NULL;
+  if (!local_error)
+    goto out;
 
-stage_paint:
-  if (do_stage_paint)
-    {
-      ClutterPaintFlag paint_flags = CLUTTER_PAINT_FLAG_CLEAR;
-
-      switch (meta_screen_cast_stream_get_cursor_mode (stream))
-        {
-        case META_SCREEN_CAST_CURSOR_MODE_METADATA:
-        case META_SCREEN_CAST_CURSOR_MODE_HIDDEN:
-          paint_flags |= CLUTTER_PAINT_FLAG_NO_CURSORS;
-          break;
-
-        case META_SCREEN_CAST_CURSOR_MODE_EMBEDDED:
-          paint_flags |= CLUTTER_PAINT_FLAG_FORCE_CURSORS;
-          break;
-        }
+  g_warning ("Error blitting to screencast framebuffer: %s",
+             local_error->message);
 
-      clutter_stage_paint_to_framebuffer (stage,
-                                          framebuffer,
-                                          &logical_monitor_layout,
-                                          view_scale,
-                                          paint_flags);
-    }
+stage_paint:
+  if (!meta_screen_cast_capture_hub_record_to_framebuffer (capture_hub,
+                                                           framebuffer,
+                                                           error))
+    return FALSE;
 
+out:
   cogl_framebuffer_flush (framebuffer);
 
   return TRUE;
@@ -912,6 +986,15 @@ meta_screen_cast_monitor_stream_src_new (MetaScreenCastMonitorStream  *monitor_s
                          NULL);
 }
 
+static MetaScreenCastCaptureHub *
+meta_screen_cast_monitor_stream_src_get_capture_hub (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastMonitorStreamSrc *monitor_src =
+    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+
+  return monitor_src->capture_hub;
+}
+
 static void
 meta_screen_cast_monitor_stream_src_init (MetaScreenCastMonitorStreamSrc *monitor_src)
 {
@@ -931,6 +1014,10 @@ meta_screen_cast_monitor_stream_src_class_init (MetaScreenCastMonitorStreamSrcCl
     meta_screen_cast_monitor_stream_src_record_to_buffer;
   src_class->record_to_framebuffer =
     meta_screen_cast_monitor_stream_src_record_to_framebuffer;
+  src_class->get_capture_hub =
+    meta_screen_cast_monitor_stream_src_get_capture_hub;
+  src_class->record_to_buffer_async =
+    meta_screen_cast_monitor_stream_src_record_to_buffer_async;
   src_class->record_follow_up =
     meta_screen_cast_monitor_stream_record_follow_up;
   src_class->set_cursor_metadata =
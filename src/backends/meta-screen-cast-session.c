@@ -409,6 +409,20 @@ is_valid_cursor_mode (MetaScreenCastCursorMode cursor_mode)
   return FALSE;
 }
 
+static gboolean
+is_valid_clock_mode (MetaVirtualMonitorClockMode clock_mode)
+{
+  switch (clock_mode)
+    {
+    case META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED:
+    case META_VIRTUAL_MONITOR_CLOCK_MODE_VARIABLE:
+    case META_VIRTUAL_MONITOR_CLOCK_MODE_STREAM:
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 static void
 add_stream (MetaScreenCastSession *session,
             MetaScreenCastStream  *stream)
@@ -729,6 +743,7 @@ handle_record_virtual (MetaDBusScreenCastSession *skeleton,
   GDBusInterfaceSkeleton *interface_skeleton;
   GDBusConnection *connection;
   MetaScreenCastCursorMode cursor_mode;
+  MetaVirtualMonitorClockMode clock_mode;
   gboolean is_platform;
   MetaScreenCastFlag flags;
   g_autoptr (GError) error = NULL;
@@ -759,6 +774,21 @@ handle_record_virtual (MetaDBusScreenCastSession *skeleton,
         }
     }
 
+  if (!g_variant_lookup (properties_variant, "clock-mode", "u", &clock_mode))
+    {
+      clock_mode = META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED;
+    }
+  else
+    {
+      if (!is_valid_clock_mode (clock_mode))
+        {
+          g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                                 G_DBUS_ERROR_FAILED,
+                                                 "Unknown clock mode");
+          return TRUE;
+        }
+    }
+
   if (!g_variant_lookup (properties_variant, "is-platform", "b", &is_platform))
     is_platform = FALSE;
 
@@ -772,6 +802,7 @@ handle_record_virtual (MetaDBusScreenCastSession *skeleton,
   virtual_stream = meta_screen_cast_virtual_stream_new (session,
                                                         connection,
                                                         cursor_mode,
+                                                        clock_mode,
                                                         flags,
                                                         &error);
   if (!virtual_stream)
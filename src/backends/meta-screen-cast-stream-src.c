@@ -39,6 +39,7 @@
 
 #include "backends/meta-screen-cast-session.h"
 #include "backends/meta-screen-cast-stream.h"
+#include "backends/meta-screen-cast-yuv-converter.h"
 #include "core/meta-fraction.h"
 
 #define PRIVATE_OWNER_FROM_FIELD(TypeName, field_ptr, field_name) \
@@ -59,6 +60,16 @@
 
 #define DEFAULT_COGL_PIXEL_FORMAT COGL_PIXEL_FORMAT_BGRX_8888
 
+/* The bounds of the frame interval used to throttle a consumer that
+ * falls behind, i.e. doesn't hand back any buffer to record into. */
+#define MIN_THROTTLE_INTERVAL_US (G_USEC_PER_SEC / 60)
+#define MAX_THROTTLE_INTERVAL_US G_USEC_PER_SEC
+
+/* A buffer handed back is only noticed the next time buffers are looked
+ * for. If that is longer ago than this, the stream was idle and the time
+ * it took isn't counted as the consumer holding on to the buffer. */
+#define MAX_BUFFER_RETURN_UNCERTAINTY_US (G_USEC_PER_SEC / 10)
+
 enum
 {
   PROP_0,
@@ -102,6 +113,15 @@ typedef struct _MetaScreenCastStreamSrcPrivate
 
   struct spa_video_info_raw video_format;
 
+  int64_t throttle_interval_us;
+
+  GQueue reserved_buffers;
+  int64_t last_reclaim_us;
+  gboolean is_starved;
+  gboolean is_held_while_starved;
+  guint buffer_poll_source_id;
+  MetaScreenCastStreamStats stats;
+
   int64_t last_frame_timestamp_us;
   guint follow_up_frame_source_id;
 
@@ -114,6 +134,14 @@ typedef struct _MetaScreenCastStreamSrcPrivate
   MtkRegion *redraw_clip;
 
   GHashTable *modifiers;
+
+  MetaScreenCastYuvConverter *yuv_converter;
+
+  CoglFramebuffer *readback_framebuffer;
+  CoglPixelFormat readback_format;
+  GCancellable *readback_cancellable;
+  struct pw_buffer *readback_buffer;
+  gboolean needs_follow_up_after_readback;
 } MetaScreenCastStreamSrcPrivate;
 
 static const struct {
@@ -124,6 +152,15 @@ static const struct {
   { COGL_PIXEL_FORMAT_BGRA_8888_PRE, SPA_VIDEO_FORMAT_BGRA },
 };
 
+/* Converted on the GPU and only offered for memfd buffers */
+static const struct {
+  MetaScreenCastYuvFormat yuv_format;
+  enum spa_video_format spa_video_format;
+} supported_yuv_formats[] = {
+  { META_SCREEN_CAST_YUV_FORMAT_NV12, SPA_VIDEO_FORMAT_NV12 },
+  { META_SCREEN_CAST_YUV_FORMAT_I420, SPA_VIDEO_FORMAT_I420 },
+};
+
 static gboolean
 spa_video_format_from_cogl_pixel_format (CoglPixelFormat        cogl_format,
                                          enum spa_video_format *out_spa_format)
@@ -162,6 +199,25 @@ cogl_pixel_format_from_spa_video_format (enum spa_video_format  spa_format,
   return FALSE;
 }
 
+static gboolean
+yuv_format_from_spa_video_format (enum spa_video_format    spa_format,
+                                  MetaScreenCastYuvFormat *out_yuv_format)
+{
+  size_t i;
+
+  for (i = 0; i < G_N_ELEMENTS (supported_yuv_formats); i++)
+    {
+      if (supported_yuv_formats[i].spa_video_format == spa_format)
+        {
+          if (out_yuv_format)
+            *out_yuv_format = supported_yuv_formats[i].yuv_format;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
 static struct spa_pod *
 push_format_object (enum spa_video_format   format,
                     uint64_t               *modifiers,
@@ -226,6 +282,11 @@ push_format_object (enum spa_video_format   format,
   return spa_pod_builder_pop (&pod_builder.b, &pod_frame);
 }
 
+typedef struct _MetaScreenCastBufferState
+{
+  int64_t queued_us;
+} MetaScreenCastBufferState;
+
 static void
 meta_screen_cast_stream_src_init_initable_iface (GInitableIface *iface);
 
@@ -571,6 +632,7 @@ meta_screen_cast_stream_src_calculate_stride (MetaScreenCastStreamSrc *src,
 {
   MetaScreenCastStreamSrcPrivate *priv =
     meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastYuvFormat yuv_format;
   CoglPixelFormat cogl_format;
   int bpp;
 
@@ -584,6 +646,17 @@ meta_screen_cast_stream_src_calculate_stride (MetaScreenCastStreamSrc *src,
       return cogl_dma_buf_handle_get_stride (dmabuf_handle);
     }
 
+  if (yuv_format_from_spa_video_format (priv->video_format.format, &yuv_format))
+    {
+      MetaScreenCastYuvLayout layout;
+
+      meta_screen_cast_yuv_calculate_layout (yuv_format,
+                                             priv->video_format.size.width,
+                                             priv->video_format.size.height,
+                                             &layout);
+      return layout.strides[0];
+    }
+
   if (!cogl_pixel_format_from_spa_video_format (priv->video_format.format,
                                                 &cogl_format))
     g_assert_not_reached ();
@@ -592,6 +665,86 @@ meta_screen_cast_stream_src_calculate_stride (MetaScreenCastStreamSrc *src,
   return SPA_ROUND_UP_N (priv->video_format.size.width * bpp, 4);
 }
 
+static uint32_t
+meta_screen_cast_stream_src_calculate_size (MetaScreenCastStreamSrc *src,
+                                            struct spa_data         *spa_data)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastYuvFormat yuv_format;
+  int stride;
+
+  if (yuv_format_from_spa_video_format (priv->video_format.format, &yuv_format))
+    {
+      MetaScreenCastYuvLayout layout;
+
+      meta_screen_cast_yuv_calculate_layout (yuv_format,
+                                             priv->video_format.size.width,
+                                             priv->video_format.size.height,
+                                             &layout);
+      return layout.size;
+    }
+
+  stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
+  return stride * priv->video_format.size.height;
+}
+
+static gboolean
+record_yuv_frame (MetaScreenCastStreamSrc   *src,
+                  MetaScreenCastYuvFormat    yuv_format,
+                  MetaScreenCastPaintPhase   paint_phase,
+                  uint8_t                   *data,
+                  GError                   **error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  int width = priv->video_format.size.width;
+  int height = priv->video_format.size.height;
+  CoglFramebuffer *framebuffer;
+
+  COGL_TRACE_BEGIN_SCOPED (RecordYuvFrame,
+                           "Meta::ScreenCastStreamSrc::record_yuv_frame()");
+
+  if (priv->yuv_converter &&
+      !meta_screen_cast_yuv_converter_matches (priv->yuv_converter,
+                                               yuv_format, width, height))
+    g_clear_object (&priv->yuv_converter);
+
+  if (!priv->yuv_converter)
+    {
+      MetaScreenCastStream *stream =
+        meta_screen_cast_stream_src_get_stream (src);
+      MetaScreenCastSession *session =
+        meta_screen_cast_stream_get_session (stream);
+      MetaScreenCast *screen_cast =
+        meta_screen_cast_session_get_screen_cast (session);
+      MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
+      ClutterBackend *clutter_backend =
+        meta_backend_get_clutter_backend (backend);
+      CoglContext *cogl_context =
+        clutter_backend_get_cogl_context (clutter_backend);
+
+      priv->yuv_converter =
+        meta_screen_cast_yuv_converter_new (cogl_context, yuv_format,
+                                            width, height,
+                                            error);
+      if (!priv->yuv_converter)
+        return FALSE;
+    }
+
+  framebuffer =
+    meta_screen_cast_yuv_converter_get_framebuffer (priv->yuv_converter);
+  if (!meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                          paint_phase,
+                                                          framebuffer,
+                                                          error))
+    return FALSE;
+
+  return meta_screen_cast_yuv_converter_convert (priv->yuv_converter,
+                                                 data,
+                                                 error);
+}
+
 static gboolean
 do_record_frame (MetaScreenCastStreamSrc   *src,
                  MetaScreenCastRecordFlag   flags,
@@ -602,8 +755,16 @@ do_record_frame (MetaScreenCastStreamSrc   *src,
   MetaScreenCastStreamSrcPrivate *priv =
     meta_screen_cast_stream_src_get_instance_private (src);
   struct spa_data *spa_data = &spa_buffer->datas[0];
+  MetaScreenCastYuvFormat yuv_format;
 
-  if (spa_data->data || spa_data->type == SPA_DATA_MemFd)
+  if (spa_data->data &&
+      yuv_format_from_spa_video_format (priv->video_format.format,
+                                        &yuv_format))
+    {
+      return record_yuv_frame (src, yuv_format, paint_phase,
+                               spa_data->data, error);
+    }
+  else if (spa_data->data || spa_data->type == SPA_DATA_MemFd)
     {
       int width = priv->video_format.size.width;
       int height = priv->video_format.size.height;
@@ -749,6 +910,581 @@ maybe_add_damaged_regions_metadata (MetaScreenCastStreamSrc *src,
   g_clear_pointer (&priv->redraw_clip, mtk_region_unref);
 }
 
+static int64_t
+get_max_framerate_interval_us (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  if (priv->video_format.max_framerate.num == 0)
+    return 0;
+
+  return ((G_USEC_PER_SEC * ((int64_t) priv->video_format.max_framerate.denom)) /
+          ((int64_t) priv->video_format.max_framerate.num));
+}
+
+static int64_t
+get_min_frame_interval_us (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  return MAX (get_max_framerate_interval_us (src),
+              priv->throttle_interval_us);
+}
+
+/* The shortest frame interval at which a consumer taking as long to hand
+ * back buffers as it did so far doesn't run out of them */
+static int64_t
+get_buffer_return_interval_us (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  if (priv->buffer_count == 0)
+    return 0;
+
+  return priv->stats.average_latency_us / priv->buffer_count;
+}
+
+static void
+throttle_frames (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  int64_t interval_us;
+
+  priv->stats.n_frames_dropped++;
+
+  interval_us = MAX (get_min_frame_interval_us (src), MIN_THROTTLE_INTERVAL_US);
+  interval_us = MAX (interval_us * 3 / 2,
+                     get_buffer_return_interval_us (src));
+  priv->throttle_interval_us = MIN (interval_us, MAX_THROTTLE_INTERVAL_US);
+
+  meta_topic (META_DEBUG_SCREEN_CAST,
+              "Consumer of stream %u is falling behind, "
+              "throttling to %" G_GINT64_FORMAT " us per frame",
+              priv->node_id, priv->throttle_interval_us);
+
+  /* Nothing gets queued up while the consumer catches up, a fresh frame with
+   * all the accumulated damage is recorded once the interval passed. */
+  maybe_schedule_follow_up_frame (src, priv->throttle_interval_us);
+}
+
+static void
+unthrottle_frames (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  if (priv->throttle_interval_us == 0)
+    return;
+
+  /* Stop throttling once the interval is back at what the negotiated frame
+   * rate allows anyway, but not faster than the consumer hands back
+   * buffers */
+  priv->throttle_interval_us = MAX (priv->throttle_interval_us * 7 / 8,
+                                    get_buffer_return_interval_us (src));
+  if (priv->throttle_interval_us <= MAX (get_max_framerate_interval_us (src),
+                                         MIN_THROTTLE_INTERVAL_US))
+    priv->throttle_interval_us = 0;
+}
+
+static void
+on_buffer_dequeued (MetaScreenCastStreamSrc *src,
+                    struct pw_buffer        *buffer,
+                    int64_t                  now_us)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastBufferState *buffer_state = buffer->user_data;
+  int64_t looked_for_us;
+  int64_t latency_us;
+
+  if (!buffer_state || buffer_state->queued_us == 0)
+    return;
+
+  looked_for_us = MAX (priv->last_reclaim_us, buffer_state->queued_us);
+  latency_us = now_us - buffer_state->queued_us;
+  buffer_state->queued_us = 0;
+
+  if (now_us - looked_for_us > MAX_BUFFER_RETURN_UNCERTAINTY_US)
+    return;
+
+  if (priv->stats.average_latency_us == 0)
+    priv->stats.average_latency_us = latency_us;
+  else
+    priv->stats.average_latency_us =
+      (priv->stats.average_latency_us * 7 + latency_us) / 8;
+  priv->stats.max_latency_us = MAX (priv->stats.max_latency_us, latency_us);
+}
+
+static void
+queue_buffer (MetaScreenCastStreamSrc *src,
+              struct pw_buffer        *buffer)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastBufferState *buffer_state = buffer->user_data;
+
+  if (buffer_state)
+    buffer_state->queued_us = g_get_monotonic_time ();
+
+  pw_stream_queue_buffer (priv->pipewire_stream, buffer);
+}
+
+static CoglContext *
+get_cogl_context (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+  MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+
+  return clutter_backend_get_cogl_context (clutter_backend);
+}
+
+static gboolean
+should_record_async (MetaScreenCastStreamSrc *src,
+                     struct spa_data         *spa_data)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastYuvFormat yuv_format;
+
+  if (spa_data->type != SPA_DATA_MemFd)
+    return FALSE;
+
+  if (yuv_format_from_spa_video_format (priv->video_format.format,
+                                        &yuv_format))
+    return FALSE;
+
+  /* Without fences the read back would block just the same, and the
+   * extra copy into an offscreen framebuffer wouldn't buy anything */
+  return cogl_has_feature (get_cogl_context (src), COGL_FEATURE_ID_FENCE);
+}
+
+static void
+cancel_readback (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  g_cancellable_cancel (priv->readback_cancellable);
+  g_clear_object (&priv->readback_cancellable);
+  priv->readback_buffer = NULL;
+  priv->needs_follow_up_after_readback = FALSE;
+}
+
+static gboolean
+ensure_readback_framebuffer (MetaScreenCastStreamSrc  *src,
+                             CoglPixelFormat           format,
+                             int                       width,
+                             int                       height,
+                             GError                  **error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  CoglTexture *texture;
+  CoglOffscreen *offscreen;
+
+  if (priv->readback_framebuffer &&
+      cogl_framebuffer_get_width (priv->readback_framebuffer) == width &&
+      cogl_framebuffer_get_height (priv->readback_framebuffer) == height &&
+      priv->readback_format == format)
+    return TRUE;
+
+  g_clear_object (&priv->readback_framebuffer);
+
+  texture = cogl_texture_2d_new_with_format (get_cogl_context (src),
+                                             width, height,
+                                             format);
+  cogl_primitive_texture_set_auto_mipmap (texture, FALSE);
+  if (!cogl_texture_allocate (texture, error))
+    {
+      g_object_unref (texture);
+      return FALSE;
+    }
+
+  offscreen = cogl_offscreen_new_with_texture (texture);
+  g_object_unref (texture);
+  if (!cogl_framebuffer_allocate (COGL_FRAMEBUFFER (offscreen), error))
+    {
+      g_object_unref (offscreen);
+      return FALSE;
+    }
+
+  priv->readback_framebuffer = COGL_FRAMEBUFFER (offscreen);
+  priv->readback_format = format;
+  return TRUE;
+}
+
+static gboolean
+copy_bitmap_to_buffer (MetaScreenCastStreamSrc  *src,
+                       CoglBitmap               *bitmap,
+                       struct spa_data          *spa_data,
+                       GError                  **error)
+{
+  CoglBuffer *pixel_buffer = COGL_BUFFER (cogl_bitmap_get_buffer (bitmap));
+  int bitmap_rowstride = cogl_bitmap_get_rowstride (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  int stride;
+  uint8_t *pixels;
+  int y;
+
+  pixels = cogl_buffer_map (pixel_buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (!pixels)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Failed to map pixel buffer");
+      return FALSE;
+    }
+
+  stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
+
+  if (stride == bitmap_rowstride)
+    {
+      memcpy (spa_data->data, pixels, (size_t) stride * height);
+    }
+  else
+    {
+      for (y = 0; y < height; y++)
+        {
+          memcpy ((uint8_t *) spa_data->data + y * stride,
+                  pixels + y * bitmap_rowstride,
+                  MIN (stride, bitmap_rowstride));
+        }
+    }
+
+  cogl_buffer_unmap (pixel_buffer);
+
+  return TRUE;
+}
+
+static void
+complete_readback (MetaScreenCastStreamSrc *src,
+                   const GError            *error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  struct pw_buffer *buffer;
+  struct spa_data *spa_data;
+
+  buffer = g_steal_pointer (&priv->readback_buffer);
+  g_clear_object (&priv->readback_cancellable);
+
+  spa_data = &buffer->buffer->datas[0];
+
+  if (error)
+    {
+      g_warning ("Failed to read back screen cast frame: %s", error->message);
+      spa_data->chunk->size = 0;
+      spa_data->chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+      priv->stats.n_frames_produced--;
+      priv->stats.n_frames_dropped++;
+    }
+
+  queue_buffer (src, buffer);
+
+  if (priv->needs_follow_up_after_readback)
+    {
+      priv->needs_follow_up_after_readback = FALSE;
+      maybe_schedule_follow_up_frame (src, 0);
+    }
+}
+
+static void
+on_readback_finished (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (source_object);
+  MetaScreenCastStreamSrc *src = user_data;
+  MetaScreenCastStreamSrcPrivate *priv;
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  g_autoptr (GError) error = NULL;
+  struct spa_data *spa_data;
+
+  bitmap = cogl_framebuffer_read_pixels_finish (framebuffer, result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  COGL_TRACE_BEGIN_SCOPED (ReadbackFinished,
+                           "Meta::ScreenCastStreamSrc::readback_finished()");
+
+  priv = meta_screen_cast_stream_src_get_instance_private (src);
+  spa_data = &priv->readback_buffer->buffer->datas[0];
+
+  if (bitmap)
+    copy_bitmap_to_buffer (src, bitmap, spa_data, &error);
+
+  complete_readback (src, error);
+}
+
+static void
+on_buffer_recorded (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  MetaScreenCastCaptureHub *capture_hub =
+    META_SCREEN_CAST_CAPTURE_HUB (source_object);
+  MetaScreenCastStreamSrc *src = user_data;
+  g_autoptr (GError) error = NULL;
+
+  if (!meta_screen_cast_capture_hub_record_to_buffer_finish (capture_hub,
+                                                             result,
+                                                             &error) &&
+      g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  COGL_TRACE_BEGIN_SCOPED (BufferRecorded,
+                           "Meta::ScreenCastStreamSrc::buffer_recorded()");
+
+  complete_readback (src, error);
+}
+
+static gboolean
+record_frame_async (MetaScreenCastStreamSrc   *src,
+                    MetaScreenCastPaintPhase   paint_phase,
+                    struct pw_buffer          *buffer,
+                    GError                   **error)
+{
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  int width = priv->video_format.size.width;
+  int height = priv->video_format.size.height;
+  CoglPixelFormat cogl_format;
+
+  COGL_TRACE_BEGIN_SCOPED (RecordFrameAsync,
+                           "Meta::ScreenCastStreamSrc::record_frame_async()");
+
+  /* Sources with a capture hub share one read back between all streams
+   * recording the same frame, instead of each reading back on its own */
+  if (klass->record_to_buffer_async)
+    {
+      struct spa_data *spa_data = &buffer->buffer->datas[0];
+      int stride;
+
+      stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
+
+      priv->readback_buffer = buffer;
+      priv->readback_cancellable = g_cancellable_new ();
+      klass->record_to_buffer_async (src,
+                                     width, height, stride,
+                                     spa_data->data,
+                                     priv->readback_cancellable,
+                                     on_buffer_recorded,
+                                     src);
+      return TRUE;
+    }
+
+  if (!cogl_pixel_format_from_spa_video_format (priv->video_format.format,
+                                                &cogl_format))
+    g_assert_not_reached ();
+
+  if (!ensure_readback_framebuffer (src, cogl_format, width, height, error))
+    return FALSE;
+
+  if (!meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                          paint_phase,
+                                                          priv->readback_framebuffer,
+                                                          error))
+    return FALSE;
+
+  /* The buffer is queued once the pixels have arrived, until then no
+   * other frame is recorded on this stream */
+  priv->readback_buffer = buffer;
+  priv->readback_cancellable = g_cancellable_new ();
+  cogl_framebuffer_read_pixels_async (priv->readback_framebuffer,
+                                      0, 0,
+                                      width, height,
+                                      cogl_format,
+                                      priv->readback_cancellable,
+                                      on_readback_finished,
+                                      src);
+
+  return TRUE;
+}
+
+static gboolean
+has_buffer_available (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  return !g_queue_is_empty (&priv->reserved_buffers);
+}
+
+static void
+end_starvation (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+
+  if (!priv->is_starved)
+    return;
+
+  meta_topic (META_DEBUG_SCREEN_CAST,
+              "Consumer of stream %u caught up", priv->node_id);
+
+  g_clear_handle_id (&priv->buffer_poll_source_id, g_source_remove);
+  priv->is_starved = FALSE;
+  priv->is_held_while_starved = FALSE;
+
+  if (klass->notify_buffer_availability)
+    klass->notify_buffer_availability (src, TRUE);
+}
+
+static void
+reclaim_buffers (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  int64_t now_us = g_get_monotonic_time ();
+  struct pw_buffer *buffer;
+
+  /* Buffers handed back by the consumer are only noticed by dequeuing them.
+   * Take all of them, so the time the consumer held on to each is known as
+   * precisely as buffers are looked for, and keep them around for the next
+   * recorded frames. */
+  while ((buffer = pw_stream_dequeue_buffer (priv->pipewire_stream)))
+    {
+      on_buffer_dequeued (src, buffer, now_us);
+      g_queue_push_tail (&priv->reserved_buffers, buffer);
+    }
+
+  priv->last_reclaim_us = now_us;
+}
+
+static gboolean poll_buffers_cb (gpointer user_data);
+
+static void
+schedule_buffer_poll (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  int64_t interval_us;
+
+  /* PipeWire doesn't tell a driving stream when the consumer hands back a
+   * buffer. Look for one about once per frame that could be recorded,
+   * looking more often wouldn't get frames out any sooner. */
+  interval_us = MAX (get_min_frame_interval_us (src), MIN_THROTTLE_INTERVAL_US);
+
+  g_clear_handle_id (&priv->buffer_poll_source_id, g_source_remove);
+  priv->buffer_poll_source_id = g_timeout_add (us2ms (interval_us),
+                                               poll_buffers_cb,
+                                               src);
+}
+
+static gboolean
+poll_buffers_cb (gpointer user_data)
+{
+  MetaScreenCastStreamSrc *src = user_data;
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  priv->buffer_poll_source_id = 0;
+
+  if (priv->pipewire_stream)
+    reclaim_buffers (src);
+
+  /* The throttled frame interval may have changed in the mean time */
+  if (!has_buffer_available (src))
+    {
+      schedule_buffer_poll (src);
+      return G_SOURCE_REMOVE;
+    }
+
+  end_starvation (src);
+
+  if (priv->redraw_clip)
+    {
+      g_clear_handle_id (&priv->follow_up_frame_source_id, g_source_remove);
+      maybe_schedule_follow_up_frame (src, 0);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+starve (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+
+  if (!priv->is_starved)
+    {
+      priv->is_starved = TRUE;
+      schedule_buffer_poll (src);
+
+      if (klass->notify_buffer_availability)
+        {
+          priv->is_held_while_starved =
+            klass->notify_buffer_availability (src, FALSE);
+        }
+    }
+
+  /* A source that stops producing frames while starved already waits for
+   * the consumer, stretching the frame interval on top would only slow it
+   * down after the consumer caught up */
+  if (priv->is_held_while_starved)
+    {
+      priv->stats.n_frames_dropped++;
+      return;
+    }
+
+  throttle_frames (src);
+}
+
+static void
+clear_starvation (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  g_clear_handle_id (&priv->buffer_poll_source_id, g_source_remove);
+  priv->is_starved = FALSE;
+  priv->is_held_while_starved = FALSE;
+}
+
+void
+meta_screen_cast_stream_src_get_stats (MetaScreenCastStreamSrc   *src,
+                                       MetaScreenCastStreamStats *stats)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+  MetaScreenCastCaptureHub *capture_hub = NULL;
+  int64_t min_interval_us;
+
+  *stats = priv->stats;
+
+  min_interval_us = get_min_frame_interval_us (src);
+  if (min_interval_us > 0)
+    stats->effective_frame_rate = (double) G_USEC_PER_SEC / min_interval_us;
+  else
+    stats->effective_frame_rate = 0.0;
+
+  if (klass->get_capture_hub)
+    capture_hub = klass->get_capture_hub (src);
+
+  if (capture_hub)
+    {
+      meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                              &stats->n_source_captures,
+                                              &stats->n_source_frames_served);
+    }
+}
+
 MetaScreenCastRecordResult
 meta_screen_cast_stream_src_maybe_record_frame (MetaScreenCastStreamSrc  *src,
                                                 MetaScreenCastRecordFlag  flags,
@@ -782,6 +1518,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
   struct spa_buffer *spa_buffer;
   struct spa_meta_header *header;
   struct spa_data *spa_data;
+  int64_t min_interval_us;
 
   COGL_TRACE_BEGIN_SCOPED (MaybeRecordFrame,
                            "Meta::ScreenCastStreamSrc::maybe_record_frame_with_timestamp()");
@@ -817,16 +1554,12 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       return record_result;
     }
 
-  if (priv->video_format.max_framerate.num > 0 &&
+  min_interval_us = get_min_frame_interval_us (src);
+  if (min_interval_us > 0 &&
       priv->last_frame_timestamp_us != 0)
     {
-      int64_t min_interval_us;
       int64_t time_since_last_frame_us;
 
-      min_interval_us =
-        ((G_USEC_PER_SEC * ((int64_t) priv->video_format.max_framerate.denom)) /
-         ((int64_t) priv->video_format.max_framerate.num));
-
       time_since_last_frame_us = frame_timestamp_us - priv->last_frame_timestamp_us;
       if (time_since_last_frame_us < min_interval_us)
         {
@@ -849,16 +1582,30 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
               "cursor" : "full",
               priv->node_id);
 
-  buffer = pw_stream_dequeue_buffer (priv->pipewire_stream);
+  if (priv->readback_buffer)
+    {
+      meta_topic (META_DEBUG_SCREEN_CAST,
+                  "Skipped recording frame on stream %u, waiting for readback",
+                  priv->node_id);
+      priv->needs_follow_up_after_readback = TRUE;
+      return record_result;
+    }
+
+  reclaim_buffers (src);
+
+  buffer = g_queue_pop_head (&priv->reserved_buffers);
   if (!buffer)
     {
       meta_topic (META_DEBUG_SCREEN_CAST,
                   "Couldn't dequeue a buffer from pipewire stream (node id %u), "
                   "maybe your encoding is too slow?",
                   pw_stream_get_node_id (priv->pipewire_stream));
+      starve (src);
       return record_result;
     }
 
+  end_starvation (src);
+
   spa_buffer = buffer->buffer;
   spa_data = &spa_buffer->datas[0];
 
@@ -872,16 +1619,22 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       if (header)
         header->flags = SPA_META_HEADER_FLAG_CORRUPTED;
 
-      pw_stream_queue_buffer (priv->pipewire_stream, buffer);
+      queue_buffer (src, buffer);
       return record_result;
     }
 
   if (!(flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY))
     {
       g_autoptr (GError) error = NULL;
+      gboolean recorded;
 
       g_clear_handle_id (&priv->follow_up_frame_source_id, g_source_remove);
-      if (do_record_frame (src, flags, paint_phase, spa_buffer, &error))
+      if (should_record_async (src, spa_data))
+        recorded = record_frame_async (src, paint_phase, buffer, &error);
+      else
+        recorded = do_record_frame (src, flags, paint_phase, spa_buffer, &error);
+
+      if (recorded)
         {
           maybe_add_damaged_regions_metadata (src, spa_buffer);
           struct spa_meta_region *spa_meta_video_crop;
@@ -914,6 +1667,8 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
             }
 
           record_result |= META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME;
+          priv->stats.n_frames_produced++;
+          unthrottle_frames (src);
         }
       else
         {
@@ -921,6 +1676,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
             g_warning ("Failed to record screen cast frame: %s", error->message);
           spa_data->chunk->size = 0;
           spa_data->chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+          priv->stats.n_frames_dropped++;
         }
     }
   else
@@ -939,7 +1695,8 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       header->flags = 0;
     }
 
-  pw_stream_queue_buffer (priv->pipewire_stream, buffer);
+  if (buffer != priv->readback_buffer)
+    queue_buffer (src, buffer);
 
   return record_result;
 }
@@ -973,6 +1730,14 @@ meta_screen_cast_stream_src_disable (MetaScreenCastStreamSrc *src)
   META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src)->disable (src);
 
   g_clear_handle_id (&priv->follow_up_frame_source_id, g_source_remove);
+  g_clear_object (&priv->yuv_converter);
+  clear_starvation (src);
+
+  /* Keep the buffer for later, its pixels never arrived */
+  if (priv->readback_buffer)
+    g_queue_push_tail (&priv->reserved_buffers, priv->readback_buffer);
+  cancel_readback (src);
+  g_clear_object (&priv->readback_framebuffer);
 
   priv->is_enabled = FALSE;
 }
@@ -1090,6 +1855,25 @@ build_format_params (MetaScreenCastStreamSrc *src,
         0);
       g_ptr_array_add (params, g_steal_pointer (&pod));
     }
+  for (i = 0; i < G_N_ELEMENTS (supported_yuv_formats); i++)
+    {
+      pod = push_format_object (
+        supported_yuv_formats[i].spa_video_format, NULL, 0, FALSE,
+        SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
+                                                               &min_size,
+                                                               &max_size),
+        SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
+        SPA_FORMAT_VIDEO_maxFramerate,
+        SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
+                                       &min_framerate,
+                                       &max_framerate),
+        SPA_FORMAT_VIDEO_colorRange, SPA_POD_Id (SPA_VIDEO_COLOR_RANGE_16_235),
+        SPA_FORMAT_VIDEO_colorMatrix, SPA_POD_Id (SPA_VIDEO_COLOR_MATRIX_BT709),
+        SPA_FORMAT_VIDEO_transferFunction, SPA_POD_Id (SPA_VIDEO_TRANSFER_SRGB),
+        SPA_FORMAT_VIDEO_colorPrimaries, SPA_POD_Id (SPA_VIDEO_COLOR_PRIMARIES_BT709),
+        0);
+      g_ptr_array_add (params, g_steal_pointer (&pod));
+    }
 }
 
 static void
@@ -1324,6 +2108,7 @@ on_stream_add_buffer (void             *data,
   int stride;
 
   priv->buffer_count++;
+  buffer->user_data = g_new0 (MetaScreenCastBufferState, 1);
 
   spa_data->mapoffset = 0;
   spa_data->data = NULL;
@@ -1383,7 +2168,8 @@ on_stream_add_buffer (void             *data,
                            dmabuf_handle);
 
       stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
-      spa_data->maxsize = stride * priv->video_format.size.height;
+      spa_data->maxsize = meta_screen_cast_stream_src_calculate_size (src,
+                                                                      spa_data);
     }
   else
     {
@@ -1414,7 +2200,8 @@ on_stream_add_buffer (void             *data,
         }
 
       stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
-      spa_data->maxsize = stride * priv->video_format.size.height;
+      spa_data->maxsize = meta_screen_cast_stream_src_calculate_size (src,
+                                                                      spa_data);
 
       if (ftruncate (spa_data->fd, spa_data->maxsize) < 0)
         {
@@ -1463,6 +2250,13 @@ on_stream_remove_buffer (void             *data,
 
   priv->buffer_count--;
 
+  g_queue_remove (&priv->reserved_buffers, buffer);
+
+  if (buffer == priv->readback_buffer)
+    cancel_readback (src);
+
+  g_clear_pointer (&buffer->user_data, g_free);
+
   if (spa_data->type == SPA_DATA_DmaBuf)
     {
       if (!g_hash_table_remove (priv->dmabuf_handles, GINT_TO_POINTER (spa_data->fd)))
@@ -1722,11 +2516,16 @@ meta_screen_cast_stream_src_dispose (GObject *object)
     g_array_free (value, TRUE);
 
   g_clear_pointer (&priv->modifiers, g_hash_table_destroy);
+  clear_starvation (src);
+  cancel_readback (src);
+  g_clear_object (&priv->readback_framebuffer);
+  g_queue_clear (&priv->reserved_buffers);
   g_clear_pointer (&priv->pipewire_stream, pw_stream_destroy);
   g_clear_pointer (&priv->dmabuf_handles, g_hash_table_destroy);
   g_clear_pointer (&priv->pipewire_core, pw_core_disconnect);
   g_clear_pointer (&priv->pipewire_context, pw_context_destroy);
   g_clear_pointer (&priv->pipewire_source, g_source_destroy);
+  g_clear_object (&priv->yuv_converter);
 
   G_OBJECT_CLASS (meta_screen_cast_stream_src_parent_class)->dispose (object);
 }
@@ -28,6 +28,7 @@
 #include "backends/meta-cursor-renderer.h"
 #include "backends/meta-cursor.h"
 #include "backends/meta-renderer.h"
+#include "backends/meta-screen-cast-capture-hub.h"
 #include "clutter/clutter.h"
 #include "cogl/cogl.h"
 #include "meta/boxes.h"
@@ -54,6 +55,17 @@ typedef enum _MetaScreenCastPaintPhase
   META_SCREEN_CAST_PAINT_PHASE_PRE_SWAP_BUFFER,
 } MetaScreenCastPaintPhase;
 
+typedef struct _MetaScreenCastStreamStats
+{
+  uint64_t n_frames_produced;
+  uint64_t n_frames_dropped;
+  int64_t average_latency_us;
+  int64_t max_latency_us;
+  double effective_frame_rate;
+  uint64_t n_source_captures;
+  uint64_t n_source_frames_served;
+} MetaScreenCastStreamStats;
+
 #define META_TYPE_SCREEN_CAST_STREAM_SRC (meta_screen_cast_stream_src_get_type ())
 G_DECLARE_DERIVABLE_TYPE (MetaScreenCastStreamSrc,
                           meta_screen_cast_stream_src,
@@ -81,6 +93,15 @@ struct _MetaScreenCastStreamSrcClass
                                       MetaScreenCastPaintPhase   paint_phase,
                                       CoglFramebuffer           *framebuffer,
                                       GError                   **error);
+  /* Completes with meta_screen_cast_capture_hub_record_to_buffer_finish() */
+  void (* record_to_buffer_async) (MetaScreenCastStreamSrc *src,
+                                   int                      width,
+                                   int                      height,
+                                   int                      stride,
+                                   uint8_t                 *data,
+                                   GCancellable            *cancellable,
+                                   GAsyncReadyCallback      callback,
+                                   gpointer                 user_data);
   void (* record_follow_up) (MetaScreenCastStreamSrc *src);
 
   gboolean (* get_videocrop) (MetaScreenCastStreamSrc *src,
@@ -91,8 +112,12 @@ struct _MetaScreenCastStreamSrcClass
 
   void (* notify_params_updated) (MetaScreenCastStreamSrc   *src,
                                   struct spa_video_info_raw *video_format);
+  gboolean (* notify_buffer_availability) (MetaScreenCastStreamSrc *src,
+                                           gboolean                 is_available);
 
   CoglPixelFormat (* get_preferred_format) (MetaScreenCastStreamSrc *src);
+
+  MetaScreenCastCaptureHub * (* get_capture_hub) (MetaScreenCastStreamSrc *src);
 };
 
 void meta_screen_cast_stream_src_close (MetaScreenCastStreamSrc *src);
@@ -144,5 +169,8 @@ void meta_screen_cast_stream_src_set_cursor_sprite_metadata (MetaScreenCastStrea
 
 gboolean meta_screen_cast_stream_src_uses_dma_bufs (MetaScreenCastStreamSrc *src);
 
+void meta_screen_cast_stream_src_get_stats (MetaScreenCastStreamSrc   *src,
+                                            MetaScreenCastStreamStats *stats);
+
 CoglPixelFormat
 meta_screen_cast_stream_src_get_preferred_format (MetaScreenCastStreamSrc *src);
@@ -420,11 +420,62 @@ handle_stop (MetaDBusScreenCastStream *skeleton,
   return G_DBUS_METHOD_INVOCATION_HANDLED;
 }
 
+static gboolean
+handle_get_statistics (MetaDBusScreenCastStream *skeleton,
+                       GDBusMethodInvocation    *invocation)
+{
+  MetaScreenCastStream *stream = META_SCREEN_CAST_STREAM (skeleton);
+  MetaScreenCastStreamPrivate *priv =
+    meta_screen_cast_stream_get_instance_private (stream);
+  MetaScreenCastStreamStats stats = { 0 };
+  GVariantBuilder statistics_builder;
+
+  if (!check_permission (stream, invocation))
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                             G_DBUS_ERROR_ACCESS_DENIED,
+                                             "Permission denied");
+      return G_DBUS_METHOD_INVOCATION_HANDLED;
+    }
+
+  if (priv->src)
+    meta_screen_cast_stream_src_get_stats (priv->src, &stats);
+
+  g_variant_builder_init (&statistics_builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "frames-produced",
+                         g_variant_new_uint64 (stats.n_frames_produced));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "frames-dropped",
+                         g_variant_new_uint64 (stats.n_frames_dropped));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "average-latency",
+                         g_variant_new_int64 (stats.average_latency_us));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "max-latency",
+                         g_variant_new_int64 (stats.max_latency_us));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "frame-rate",
+                         g_variant_new_double (stats.effective_frame_rate));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "source-captures",
+                         g_variant_new_uint64 (stats.n_source_captures));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "source-frames-served",
+                         g_variant_new_uint64 (stats.n_source_frames_served));
+
+  meta_dbus_screen_cast_stream_complete_get_statistics (
+    skeleton, invocation, g_variant_builder_end (&statistics_builder));
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
 static void
 meta_screen_cast_stream_init_iface (MetaDBusScreenCastStreamIface *iface)
 {
   iface->handle_start = handle_start;
   iface->handle_stop = handle_stop;
+  iface->handle_get_statistics = handle_get_statistics;
 }
 
 static gboolean
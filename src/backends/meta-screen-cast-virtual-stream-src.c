@@ -27,6 +27,7 @@
 #include "backends/meta-output.h"
 #include "backends/meta-screen-cast-session.h"
 #include "backends/meta-stage-private.h"
+#include "backends/meta-stage-view-private.h"
 #include "backends/meta-virtual-monitor.h"
 #include "core/boxes-private.h"
 
@@ -47,6 +48,8 @@ struct _MetaScreenCastVirtualStreamSrc
 
   MetaStageWatch *watch;
 
+  MetaStageView *held_view;
+
   gulong position_invalidated_handler_id;
   gulong cursor_changed_handler_id;
   gulong prepare_frame_handler_id;
@@ -250,6 +253,32 @@ add_watch (MetaScreenCastVirtualStreamSrc *virtual_src)
     }
 }
 
+static void
+release_presentation (MetaScreenCastVirtualStreamSrc *virtual_src)
+{
+  if (!virtual_src->held_view)
+    return;
+
+  meta_stage_view_release_presentation (virtual_src->held_view);
+  g_clear_object (&virtual_src->held_view);
+}
+
+static void
+hold_presentation (MetaScreenCastVirtualStreamSrc *virtual_src)
+{
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (virtual_src);
+  ClutterStageView *view;
+
+  view = view_from_src (src);
+  if (!view || virtual_src->held_view == META_STAGE_VIEW (view))
+    return;
+
+  release_presentation (virtual_src);
+
+  virtual_src->held_view = g_object_ref (META_STAGE_VIEW (view));
+  meta_stage_view_hold_presentation (virtual_src->held_view);
+}
+
 static void
 on_monitors_changed (MetaMonitorManager             *monitor_manager,
                      MetaScreenCastVirtualStreamSrc *virtual_src)
@@ -262,6 +291,10 @@ on_monitors_changed (MetaMonitorManager             *monitor_manager,
   virtual_src->watch = NULL;
   add_watch (virtual_src);
 
+  /* The view may have been rebuilt, keep holding back the one in use */
+  if (virtual_src->held_view)
+    hold_presentation (virtual_src);
+
   meta_eis_viewport_notify_changed (META_EIS_VIEWPORT (stream));
 }
 
@@ -351,6 +384,8 @@ meta_screen_cast_virtual_stream_src_disable (MetaScreenCastStreamSrc *src)
   if (virtual_src->hw_cursor_inhibited)
     uninhibit_hw_cursor (virtual_src);
 
+  release_presentation (virtual_src);
+
   if (virtual_src->watch)
     {
       meta_stage_remove_watch (META_STAGE (stage_from_src (src)),
@@ -642,6 +677,8 @@ create_virtual_monitor (MetaScreenCastVirtualStreamSrc  *virtual_src,
                         GError                         **error)
 {
   MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (virtual_src);
+  MetaScreenCastVirtualStream *virtual_stream =
+    META_SCREEN_CAST_VIRTUAL_STREAM (meta_screen_cast_stream_src_get_stream (src));
   MetaBackend *backend = backend_from_src (src);
   MetaMonitorManager *monitor_manager =
     meta_backend_get_monitor_manager (backend);
@@ -660,6 +697,8 @@ create_virtual_monitor (MetaScreenCastVirtualStreamSrc  *virtual_src,
                                         "MetaVendor",
                                         "Virtual remote monitor",
                                         serial);
+  info->clock_mode =
+    meta_screen_cast_virtual_stream_get_clock_mode (virtual_stream);
   return meta_monitor_manager_create_virtual_monitor (monitor_manager,
                                                       info,
                                                       error);
@@ -714,6 +753,31 @@ ensure_virtual_monitor (MetaScreenCastVirtualStreamSrc *virtual_src,
   meta_monitor_manager_reload (monitor_manager);
 }
 
+static gboolean
+meta_screen_cast_virtual_stream_src_notify_buffer_availability (MetaScreenCastStreamSrc *src,
+                                                                gboolean                 is_available)
+{
+  MetaScreenCastVirtualStreamSrc *virtual_src =
+    META_SCREEN_CAST_VIRTUAL_STREAM_SRC (src);
+  MetaVirtualMonitor *virtual_monitor = virtual_src->virtual_monitor;
+
+  if (is_available)
+    {
+      release_presentation (virtual_src);
+      return FALSE;
+    }
+
+  if (!virtual_monitor ||
+      meta_virtual_monitor_get_clock_mode (virtual_monitor) !=
+      META_VIRTUAL_MONITOR_CLOCK_MODE_STREAM)
+    return FALSE;
+
+  /* Frames painted while the consumer has no buffer to take them would only
+   * be dropped, so stop the frame clock by not presenting the last one */
+  hold_presentation (virtual_src);
+  return virtual_src->held_view != NULL;
+}
+
 static void
 meta_screen_cast_virtual_stream_src_notify_params_updated (MetaScreenCastStreamSrc   *src,
                                                            struct spa_video_info_raw *video_format)
@@ -791,4 +855,6 @@ meta_screen_cast_virtual_stream_src_class_init (MetaScreenCastVirtualStreamSrcCl
     meta_screen_cast_virtual_stream_src_set_cursor_metadata;
   src_class->notify_params_updated =
     meta_screen_cast_virtual_stream_src_notify_params_updated;
+  src_class->notify_buffer_availability =
+    meta_screen_cast_virtual_stream_src_notify_buffer_availability;
 }
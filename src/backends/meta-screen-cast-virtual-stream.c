@@ -25,9 +25,18 @@
 #include "backends/meta-screen-cast-virtual-stream-src.h"
 #include "backends/meta-virtual-monitor.h"
 
+enum
+{
+  PROP_0,
+
+  PROP_CLOCK_MODE,
+};
+
 struct _MetaScreenCastVirtualStream
 {
   MetaScreenCastStream parent;
+
+  MetaVirtualMonitorClockMode clock_mode;
 };
 
 static void meta_eis_viewport_iface_init (MetaEisViewportInterface *eis_viewport_iface);
@@ -39,11 +48,12 @@ G_DEFINE_TYPE_WITH_CODE (MetaScreenCastVirtualStream,
                                                 meta_eis_viewport_iface_init))
 
 MetaScreenCastVirtualStream *
-meta_screen_cast_virtual_stream_new (MetaScreenCastSession     *session,
-                                     GDBusConnection           *connection,
-                                     MetaScreenCastCursorMode   cursor_mode,
-                                     MetaScreenCastFlag         flags,
-                                     GError                   **error)
+meta_screen_cast_virtual_stream_new (MetaScreenCastSession        *session,
+                                     GDBusConnection              *connection,
+                                     MetaScreenCastCursorMode      cursor_mode,
+                                     MetaVirtualMonitorClockMode   clock_mode,
+                                     MetaScreenCastFlag            flags,
+                                     GError                      **error)
 {
   MetaScreenCastVirtualStream *virtual_stream;
 
@@ -53,6 +63,7 @@ meta_screen_cast_virtual_stream_new (MetaScreenCastSession     *session,
                                    "session", session,
                                    "connection", connection,
                                    "cursor-mode", cursor_mode,
+                                   "clock-mode", clock_mode,
                                    "flags", flags,
                                    NULL);
   if (!virtual_stream)
@@ -61,6 +72,12 @@ meta_screen_cast_virtual_stream_new (MetaScreenCastSession     *session,
   return virtual_stream;
 }
 
+MetaVirtualMonitorClockMode
+meta_screen_cast_virtual_stream_get_clock_mode (MetaScreenCastVirtualStream *virtual_stream)
+{
+  return virtual_stream->clock_mode;
+}
+
 static gboolean
 meta_screen_cast_virtual_stream_is_standalone (MetaEisViewport *viewport)
 {
@@ -203,6 +220,44 @@ meta_screen_cast_virtual_stream_transform_position (MetaScreenCastStream *stream
   return TRUE;
 }
 
+static void
+meta_screen_cast_virtual_stream_set_property (GObject      *object,
+                                              guint         prop_id,
+                                              const GValue *value,
+                                              GParamSpec   *pspec)
+{
+  MetaScreenCastVirtualStream *virtual_stream =
+    META_SCREEN_CAST_VIRTUAL_STREAM (object);
+
+  switch (prop_id)
+    {
+    case PROP_CLOCK_MODE:
+      virtual_stream->clock_mode = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+meta_screen_cast_virtual_stream_get_property (GObject    *object,
+                                              guint       prop_id,
+                                              GValue     *value,
+                                              GParamSpec *pspec)
+{
+  MetaScreenCastVirtualStream *virtual_stream =
+    META_SCREEN_CAST_VIRTUAL_STREAM (object);
+
+  switch (prop_id)
+    {
+    case PROP_CLOCK_MODE:
+      g_value_set_int (value, virtual_stream->clock_mode);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
 static void
 meta_screen_cast_virtual_stream_init (MetaScreenCastVirtualStream *virtual_stream)
 {
@@ -211,10 +266,24 @@ meta_screen_cast_virtual_stream_init (MetaScreenCastVirtualStream *virtual_strea
 static void
 meta_screen_cast_virtual_stream_class_init (MetaScreenCastVirtualStreamClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   MetaScreenCastStreamClass *stream_class =
     META_SCREEN_CAST_STREAM_CLASS (klass);
 
+  object_class->set_property = meta_screen_cast_virtual_stream_set_property;
+  object_class->get_property = meta_screen_cast_virtual_stream_get_property;
+
   stream_class->create_src = meta_screen_cast_virtual_stream_create_src;
   stream_class->set_parameters = meta_screen_cast_virtual_stream_set_parameters;
   stream_class->transform_position = meta_screen_cast_virtual_stream_transform_position;
+
+  g_object_class_install_property (object_class,
+                                   PROP_CLOCK_MODE,
+                                   g_param_spec_int ("clock-mode", NULL, NULL,
+                                                     META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+                                                     META_VIRTUAL_MONITOR_CLOCK_MODE_STREAM,
+                                                     META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT_ONLY |
+                                                     G_PARAM_STATIC_STRINGS));
 }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "backends/meta-screen-cast-stream.h"
+#include "backends/meta-virtual-monitor.h"
 
 #define META_TYPE_SCREEN_CAST_VIRTUAL_STREAM (meta_screen_cast_virtual_stream_get_type ())
 G_DECLARE_FINAL_TYPE (MetaScreenCastVirtualStream,
@@ -26,10 +27,13 @@ G_DECLARE_FINAL_TYPE (MetaScreenCastVirtualStream,
                       META, SCREEN_CAST_VIRTUAL_STREAM,
                       MetaScreenCastStream)
 
-MetaScreenCastVirtualStream * meta_screen_cast_virtual_stream_new (MetaScreenCastSession     *session,
-                                                                   GDBusConnection           *connection,
-                                                                   MetaScreenCastCursorMode   cursor_mode,
-                                                                   MetaScreenCastFlag         flags,
-                                                                   GError                   **error);
+MetaScreenCastVirtualStream * meta_screen_cast_virtual_stream_new (MetaScreenCastSession        *session,
+                                                                   GDBusConnection              *connection,
+                                                                   MetaScreenCastCursorMode      cursor_mode,
+                                                                   MetaVirtualMonitorClockMode   clock_mode,
+                                                                   MetaScreenCastFlag            flags,
+                                                                   GError                      **error);
+
+MetaVirtualMonitorClockMode meta_screen_cast_virtual_stream_get_clock_mode (MetaScreenCastVirtualStream *virtual_stream);
 
 MetaVirtualMonitor * meta_screen_cast_virtual_stream_get_virtual_monitor (MetaScreenCastVirtualStream *virtual_stream);
@@ -0,0 +1,371 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Converts the RGB content of a screen cast frame into a planar YUV layout
+ * on the GPU, so only the converted planes are read back into memory.
+ *
+ * The conversion uses BT.709 coefficients with limited (16-235) range. Each
+ * plane is rendered into an RGBA offscreen where every texel packs the four
+ * consecutive bytes of the plane that end up at its position in memory,
+ * making the read back of the offscreen produce the plane as is. Chroma is
+ * sampled in the middle of each 2x2 block, so linear filtering averages the
+ * four pixels of the block.
+ */
+
+#include "config.h"
+
+#include "backends/meta-screen-cast-yuv-converter.h"
+
+#define ROUND_UP_2(n) (((n) + 1) & ~1)
+#define ROUND_UP_4(n) (((n) + 3) & ~3)
+
+static const char yuv_globals_shader[] =
+  "uniform vec2 source_size;                                                \n"
+  "uniform vec2 plane_size;                                                 \n"
+  "                                                                         \n"
+  "vec3 sample_source (float x, float y)                                    \n"
+  "{                                                                        \n"
+  "  return texture2D (cogl_sampler0, vec2 (x, y) / source_size).rgb;       \n"
+  "}                                                                        \n"
+  "                                                                         \n"
+  "float rgb_to_luma (vec3 rgb)                                             \n"
+  "{                                                                        \n"
+  "  return dot (rgb, vec3 (0.2126, 0.7152, 0.0722));                       \n"
+  "}                                                                        \n"
+  "                                                                         \n"
+  "float rgb_to_y (vec3 rgb)                                                \n"
+  "{                                                                        \n"
+  "  return 16.0/255.0 + 219.0/255.0 * rgb_to_luma (rgb);                   \n"
+  "}                                                                        \n"
+  "                                                                         \n"
+  "float rgb_to_u (vec3 rgb)                                                \n"
+  "{                                                                        \n"
+  "  return 128.0/255.0 + 224.0/255.0 * (rgb.b - rgb_to_luma (rgb)) / 1.8556;\n"
+  "}                                                                        \n"
+  "                                                                         \n"
+  "float rgb_to_v (vec3 rgb)                                                \n"
+  "{                                                                        \n"
+  "  return 128.0/255.0 + 224.0/255.0 * (rgb.r - rgb_to_luma (rgb)) / 1.5748;\n"
+  "}                                                                        \n";
+
+static const char y_plane_shader[] =
+  "vec2 texel = floor (cogl_tex_coord0_in.st * plane_size);                 \n"
+  "float x = texel.x * 4.0 + 0.5;                                           \n"
+  "float y = texel.y + 0.5;                                                 \n"
+  "cogl_color_out = vec4 (rgb_to_y (sample_source (x, y)),                  \n"
+  "                       rgb_to_y (sample_source (x + 1.0, y)),            \n"
+  "                       rgb_to_y (sample_source (x + 2.0, y)),            \n"
+  "                       rgb_to_y (sample_source (x + 3.0, y)));           \n";
+
+static const char uv_plane_shader[] =
+  "vec2 texel = floor (cogl_tex_coord0_in.st * plane_size);                 \n"
+  "float x = texel.x * 4.0 + 1.0;                                           \n"
+  "float y = texel.y * 2.0 + 1.0;                                           \n"
+  "vec3 rgb0 = sample_source (x, y);                                        \n"
+  "vec3 rgb1 = sample_source (x + 2.0, y);                                  \n"
+  "cogl_color_out = vec4 (rgb_to_u (rgb0), rgb_to_v (rgb0),                 \n"
+  "                       rgb_to_u (rgb1), rgb_to_v (rgb1));                \n";
+
+static const char u_plane_shader[] =
+  "vec2 texel = floor (cogl_tex_coord0_in.st * plane_size);                 \n"
+  "float x = texel.x * 8.0 + 1.0;                                           \n"
+  "float y = texel.y * 2.0 + 1.0;                                           \n"
+  "cogl_color_out = vec4 (rgb_to_u (sample_source (x, y)),                  \n"
+  "                       rgb_to_u (sample_source (x + 2.0, y)),            \n"
+  "                       rgb_to_u (sample_source (x + 4.0, y)),            \n"
+  "                       rgb_to_u (sample_source (x + 6.0, y)));           \n";
+
+static const char v_plane_shader[] =
+  "vec2 texel = floor (cogl_tex_coord0_in.st * plane_size);                 \n"
+  "float x = texel.x * 8.0 + 1.0;                                           \n"
+  "float y = texel.y * 2.0 + 1.0;                                           \n"
+  "cogl_color_out = vec4 (rgb_to_v (sample_source (x, y)),                  \n"
+  "                       rgb_to_v (sample_source (x + 2.0, y)),            \n"
+  "                       rgb_to_v (sample_source (x + 4.0, y)),            \n"
+  "                       rgb_to_v (sample_source (x + 6.0, y)));           \n";
+
+typedef struct _MetaScreenCastYuvPlane
+{
+  CoglFramebuffer *framebuffer;
+  CoglPipeline *pipeline;
+  int width;
+  int height;
+} MetaScreenCastYuvPlane;
+
+struct _MetaScreenCastYuvConverter
+{
+  GObject parent;
+
+  MetaScreenCastYuvFormat format;
+  int width;
+  int height;
+  MetaScreenCastYuvLayout layout;
+
+  CoglTexture *source_texture;
+  CoglFramebuffer *source_framebuffer;
+
+  MetaScreenCastYuvPlane planes[META_SCREEN_CAST_YUV_MAX_PLANES];
+};
+
+G_DEFINE_FINAL_TYPE (MetaScreenCastYuvConverter,
+                     meta_screen_cast_yuv_converter,
+                     G_TYPE_OBJECT)
+
+void
+meta_screen_cast_yuv_calculate_layout (MetaScreenCastYuvFormat  format,
+                                       int                      width,
+                                       int                      height,
+                                       MetaScreenCastYuvLayout *layout)
+{
+  int chroma_height = ROUND_UP_2 (height) / 2;
+
+  /* Same layout as GStreamer's default for these formats, which is what
+   * consumers of single block buffers expect. */
+  *layout = (MetaScreenCastYuvLayout) { 0 };
+  layout->strides[0] = ROUND_UP_4 (width);
+  layout->heights[0] = height;
+
+  switch (format)
+    {
+    case META_SCREEN_CAST_YUV_FORMAT_NV12:
+      layout->n_planes = 2;
+      layout->strides[1] = layout->strides[0];
+      layout->offsets[1] = layout->strides[0] * ROUND_UP_2 (height);
+      layout->heights[1] = chroma_height;
+      layout->size = layout->offsets[1] + layout->strides[1] * chroma_height;
+      return;
+    case META_SCREEN_CAST_YUV_FORMAT_I420:
+      layout->n_planes = 3;
+      layout->strides[1] = ROUND_UP_4 (ROUND_UP_2 (width) / 2);
+      layout->strides[2] = layout->strides[1];
+      layout->offsets[1] = layout->strides[0] * ROUND_UP_2 (height);
+      layout->offsets[2] = layout->offsets[1] + layout->strides[1] * chroma_height;
+      layout->heights[1] = chroma_height;
+      layout->heights[2] = chroma_height;
+      layout->size = layout->offsets[2] + layout->strides[2] * chroma_height;
+      return;
+    }
+
+  g_assert_not_reached ();
+}
+
+static const char *
+get_plane_shader (MetaScreenCastYuvFormat format,
+                  int                     plane)
+{
+  if (plane == 0)
+    return y_plane_shader;
+
+  switch (format)
+    {
+    case META_SCREEN_CAST_YUV_FORMAT_NV12:
+      return uv_plane_shader;
+    case META_SCREEN_CAST_YUV_FORMAT_I420:
+      return plane == 1 ? u_plane_shader : v_plane_shader;
+    }
+
+  g_assert_not_reached ();
+}
+
+static gboolean
+init_plane (MetaScreenCastYuvConverter  *converter,
+            CoglContext                 *context,
+            int                          plane_index,
+            GError                     **error)
+{
+  MetaScreenCastYuvPlane *plane = &converter->planes[plane_index];
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (CoglSnippet) globals_snippet = NULL;
+  g_autoptr (CoglSnippet) plane_snippet = NULL;
+  float source_size[2];
+  float plane_size[2];
+
+  plane->width = converter->layout.strides[plane_index] / 4;
+  plane->height = converter->layout.heights[plane_index];
+
+  texture = cogl_texture_2d_new_with_format (context,
+                                             plane->width, plane->height,
+                                             COGL_PIXEL_FORMAT_RGBA_8888);
+  cogl_texture_set_premultiplied (texture, FALSE);
+  if (!cogl_texture_allocate (texture, error))
+    return FALSE;
+
+  plane->framebuffer =
+    COGL_FRAMEBUFFER (cogl_offscreen_new_with_texture (texture));
+  if (!cogl_framebuffer_allocate (plane->framebuffer, error))
+    return FALSE;
+
+  cogl_framebuffer_set_dither_enabled (plane->framebuffer, FALSE);
+  cogl_framebuffer_orthographic (plane->framebuffer,
+                                 0, 0, plane->width, plane->height,
+                                 -1, 1);
+
+  plane->pipeline = cogl_pipeline_new (context);
+  cogl_pipeline_set_layer_texture (plane->pipeline, 0,
+                                   converter->source_texture);
+  cogl_pipeline_set_layer_filters (plane->pipeline, 0,
+                                   COGL_PIPELINE_FILTER_LINEAR,
+                                   COGL_PIPELINE_FILTER_LINEAR);
+  cogl_pipeline_set_layer_wrap_mode (plane->pipeline, 0,
+                                     COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE);
+  cogl_pipeline_set_blend (plane->pipeline, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+
+  globals_snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT_GLOBALS,
+                                      yuv_globals_shader,
+                                      NULL);
+  cogl_pipeline_add_snippet (plane->pipeline, globals_snippet);
+  plane_snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT,
+                                    NULL,
+                                    get_plane_shader (converter->format,
+                                                      plane_index));
+  cogl_pipeline_add_snippet (plane->pipeline, plane_snippet);
+
+  source_size[0] = converter->width;
+  source_size[1] = converter->height;
+  cogl_pipeline_set_uniform_float (plane->pipeline,
+                                   cogl_pipeline_get_uniform_location (plane->pipeline,
+                                                                       "source_size"),
+                                   2, 1, source_size);
+
+  plane_size[0] = plane->width;
+  plane_size[1] = plane->height;
+  cogl_pipeline_set_uniform_float (plane->pipeline,
+                                   cogl_pipeline_get_uniform_location (plane->pipeline,
+                                                                       "plane_size"),
+                                   2, 1, plane_size);
+
+  return TRUE;
+}
+
+gboolean
+meta_screen_cast_yuv_converter_convert (MetaScreenCastYuvConverter  *converter,
+                                        uint8_t                     *data,
+                                        GError                     **error)
+{
+  int i;
+
+  for (i = 0; i < converter->layout.n_planes; i++)
+    {
+      MetaScreenCastYuvPlane *plane = &converter->planes[i];
+
+      cogl_framebuffer_draw_textured_rectangle (plane->framebuffer,
+                                                plane->pipeline,
+                                                0, 0,
+                                                plane->width, plane->height,
+                                                0, 0, 1, 1);
+      if (!cogl_framebuffer_read_pixels (plane->framebuffer,
+                                         0, 0,
+                                         plane->width, plane->height,
+                                         COGL_PIXEL_FORMAT_RGBA_8888,
+                                         data + converter->layout.offsets[i]))
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       "Failed to read back YUV plane %d", i);
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+CoglFramebuffer *
+meta_screen_cast_yuv_converter_get_framebuffer (MetaScreenCastYuvConverter *converter)
+{
+  return converter->source_framebuffer;
+}
+
+gboolean
+meta_screen_cast_yuv_converter_matches (MetaScreenCastYuvConverter *converter,
+                                        MetaScreenCastYuvFormat     format,
+                                        int                         width,
+                                        int                         height)
+{
+  return (converter->format == format &&
+          converter->width == width &&
+          converter->height == height);
+}
+
+MetaScreenCastYuvConverter *
+meta_screen_cast_yuv_converter_new (CoglContext              *context,
+                                    MetaScreenCastYuvFormat   format,
+                                    int                       width,
+                                    int                       height,
+                                    GError                  **error)
+{
+  g_autoptr (MetaScreenCastYuvConverter) converter = NULL;
+  int i;
+
+  converter = g_object_new (META_TYPE_SCREEN_CAST_YUV_CONVERTER, NULL);
+  converter->format = format;
+  converter->width = width;
+  converter->height = height;
+  meta_screen_cast_yuv_calculate_layout (format, width, height,
+                                         &converter->layout);
+
+  converter->source_texture = cogl_texture_2d_new_with_size (context,
+                                                             width, height);
+  if (!cogl_texture_allocate (converter->source_texture, error))
+    return NULL;
+
+  converter->source_framebuffer =
+    COGL_FRAMEBUFFER (cogl_offscreen_new_with_texture (converter->source_texture));
+  if (!cogl_framebuffer_allocate (converter->source_framebuffer, error))
+    return NULL;
+
+  for (i = 0; i < converter->layout.n_planes; i++)
+    {
+      if (!init_plane (converter, context, i, error))
+        return NULL;
+    }
+
+  return g_steal_pointer (&converter);
+}
+
+static void
+meta_screen_cast_yuv_converter_finalize (GObject *object)
+{
+  MetaScreenCastYuvConverter *converter = META_SCREEN_CAST_YUV_CONVERTER (object);
+  int i;
+
+  for (i = 0; i < META_SCREEN_CAST_YUV_MAX_PLANES; i++)
+    {
+      g_clear_object (&converter->planes[i].pipeline);
+      g_clear_object (&converter->planes[i].framebuffer);
+    }
+
+  g_clear_object (&converter->source_framebuffer);
+  g_clear_object (&converter->source_texture);
+
+  G_OBJECT_CLASS (meta_screen_cast_yuv_converter_parent_class)->finalize (object);
+}
+
+static void
+meta_screen_cast_yuv_converter_init (MetaScreenCastYuvConverter *converter)
+{
+}
+
+static void
+meta_screen_cast_yuv_converter_class_init (MetaScreenCastYuvConverterClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_screen_cast_yuv_converter_finalize;
+}
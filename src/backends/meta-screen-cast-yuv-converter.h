@@ -0,0 +1,75 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "cogl/cogl.h"
+#include "core/util-private.h"
+
+typedef enum _MetaScreenCastYuvFormat
+{
+  META_SCREEN_CAST_YUV_FORMAT_NV12,
+  META_SCREEN_CAST_YUV_FORMAT_I420,
+} MetaScreenCastYuvFormat;
+
+#define META_SCREEN_CAST_YUV_MAX_PLANES 3
+
+typedef struct _MetaScreenCastYuvLayout
+{
+  int n_planes;
+  int strides[META_SCREEN_CAST_YUV_MAX_PLANES];
+  int offsets[META_SCREEN_CAST_YUV_MAX_PLANES];
+  int heights[META_SCREEN_CAST_YUV_MAX_PLANES];
+  size_t size;
+} MetaScreenCastYuvLayout;
+
+#define META_TYPE_SCREEN_CAST_YUV_CONVERTER (meta_screen_cast_yuv_converter_get_type ())
+G_DECLARE_FINAL_TYPE (MetaScreenCastYuvConverter,
+                      meta_screen_cast_yuv_converter,
+                      META, SCREEN_CAST_YUV_CONVERTER,
+                      GObject)
+
+META_EXPORT_TEST
+void meta_screen_cast_yuv_calculate_layout (MetaScreenCastYuvFormat  format,
+                                            int                      width,
+                                            int                      height,
+                                            MetaScreenCastYuvLayout *layout);
+
+META_EXPORT_TEST
+MetaScreenCastYuvConverter * meta_screen_cast_yuv_converter_new (CoglContext              *context,
+                                                                 MetaScreenCastYuvFormat   format,
+                                                                 int                       width,
+                                                                 int                       height,
+                                                                 GError                  **error);
+
+META_EXPORT_TEST
+CoglFramebuffer * meta_screen_cast_yuv_converter_get_framebuffer (MetaScreenCastYuvConverter *converter);
+
+META_EXPORT_TEST
+gboolean meta_screen_cast_yuv_converter_convert (MetaScreenCastYuvConverter  *converter,
+                                                 uint8_t                     *data,
+                                                 GError                     **error);
+
+gboolean meta_screen_cast_yuv_converter_matches (MetaScreenCastYuvConverter *converter,
+                                                 MetaScreenCastYuvFormat     format,
+                                                 int                         width,
+                                                 int                         height);
@@ -26,6 +26,7 @@
 
 #include "backends/meta-backend-private.h"
 #include "backends/meta-remote-desktop-session.h"
+#include "backends/meta-screen-cast-capture-hub.h"
 #include "backends/meta-screen-cast-session.h"
 
 #ifdef HAVE_NATIVE_BACKEND
@@ -40,11 +41,13 @@
 
 #define META_SCREEN_CAST_DBUS_SERVICE "org.gnome.Mutter.ScreenCast"
 #define META_SCREEN_CAST_DBUS_PATH "/org/gnome/Mutter/ScreenCast"
-#define META_SCREEN_CAST_API_VERSION 4
+#define META_SCREEN_CAST_API_VERSION 6
 
 struct _MetaScreenCast
 {
   MetaDbusSessionManager parent;
+
+  GList *capture_hubs;
 };
 
 G_DEFINE_TYPE (MetaScreenCast, meta_screen_cast,
@@ -302,6 +305,46 @@ meta_screen_cast_create_dma_buf_handle (MetaScreenCast  *screen_cast,
 #endif
 }
 
+static void
+on_capture_hub_finalized (gpointer  user_data,
+                          GObject  *where_the_object_was)
+{
+  MetaScreenCast *screen_cast = user_data;
+
+  screen_cast->capture_hubs = g_list_remove (screen_cast->capture_hubs,
+                                             where_the_object_was);
+}
+
+MetaScreenCastCaptureHub *
+meta_screen_cast_acquire_capture_hub (MetaScreenCast     *screen_cast,
+                                      ClutterStage       *stage,
+                                      const MtkRectangle *rect,
+                                      float               scale,
+                                      ClutterPaintFlag    paint_flags)
+{
+  MetaScreenCastCaptureHub *capture_hub;
+  GList *l;
+
+  for (l = screen_cast->capture_hubs; l; l = l->next)
+    {
+      capture_hub = l->data;
+
+      if (meta_screen_cast_capture_hub_matches (capture_hub, stage, rect,
+                                                scale, paint_flags))
+        return g_object_ref (capture_hub);
+    }
+
+  capture_hub = meta_screen_cast_capture_hub_new (stage, rect,
+                                                  scale, paint_flags);
+  g_object_weak_ref (G_OBJECT (capture_hub),
+                     on_capture_hub_finalized,
+                     screen_cast);
+  screen_cast->capture_hubs = g_list_prepend (screen_cast->capture_hubs,
+                                              capture_hub);
+
+  return capture_hub;
+}
+
 static MetaRemoteDesktopSession *
 find_remote_desktop_session (MetaDbusSessionManager  *session_manager,
                              const char              *remote_desktop_session_id,
@@ -406,6 +449,23 @@ meta_screen_cast_constructed (GObject *object)
   G_OBJECT_CLASS (meta_screen_cast_parent_class)->constructed (object);
 }
 
+static void
+meta_screen_cast_finalize (GObject *object)
+{
+  MetaScreenCast *screen_cast = META_SCREEN_CAST (object);
+  GList *l;
+
+  for (l = screen_cast->capture_hubs; l; l = l->next)
+    {
+      g_object_weak_unref (G_OBJECT (l->data),
+                           on_capture_hub_finalized,
+                           screen_cast);
+    }
+  g_clear_pointer (&screen_cast->capture_hubs, g_list_free);
+
+  G_OBJECT_CLASS (meta_screen_cast_parent_class)->finalize (object);
+}
+
 MetaScreenCast *
 meta_screen_cast_new (MetaBackend *backend)
 {
@@ -443,4 +503,5 @@ meta_screen_cast_class_init (MetaScreenCastClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->constructed = meta_screen_cast_constructed;
+  object_class->finalize = meta_screen_cast_finalize;
 }
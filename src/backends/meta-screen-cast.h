@@ -25,6 +25,7 @@
 #include "backends/meta-backend-private.h"
 #include "backends/meta-dbus-session-manager.h"
 #include "backends/meta-dbus-session-watcher.h"
+#include "backends/meta-screen-cast-capture-hub.h"
 
 #include "meta-dbus-screen-cast.h"
 
@@ -65,4 +66,11 @@ CoglDmaBufHandle * meta_screen_cast_create_dma_buf_handle (MetaScreenCast  *scre
                                                            int              width,
                                                            int              height);
 
+META_EXPORT_TEST
+MetaScreenCastCaptureHub * meta_screen_cast_acquire_capture_hub (MetaScreenCast     *screen_cast,
+                                                                 ClutterStage       *stage,
+                                                                 const MtkRectangle *rect,
+                                                                 float               scale,
+                                                                 ClutterPaintFlag    paint_flags);
+
 MetaScreenCast * meta_screen_cast_new (MetaBackend *backend);
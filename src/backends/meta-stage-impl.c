@@ -131,20 +131,61 @@ meta_stage_impl_resize (ClutterStageWindow *stage_window,
 {
 }
 
+static unsigned int
+get_region_area (const MtkRegion *region)
+{
+  unsigned int area = 0;
+  int n_rects, i;
+
+  n_rects = mtk_region_num_rectangles (region);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect;
+
+      rect = mtk_region_get_rectangle (region, i);
+      area += mtk_rectangle_area (&rect);
+    }
+
+  return area;
+}
+
+static void
+paint_overlay_region (CoglFramebuffer *framebuffer,
+                      CoglPipeline    *overlay,
+                      MtkRegion       *region)
+{
+  int n_rects, i;
+
+  n_rects = mtk_region_num_rectangles (region);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect;
+      float x_1, x_2, y_1, y_2;
+
+      rect = mtk_region_get_rectangle (region, i);
+      x_1 = rect.x;
+      x_2 = rect.x + rect.width;
+      y_1 = rect.y;
+      y_2 = rect.y + rect.height;
+
+      cogl_framebuffer_draw_rectangle (framebuffer, overlay, x_1, y_1, x_2, y_2);
+    }
+}
+
 static void
 paint_damage_region (ClutterStageWindow *stage_window,
                      ClutterStageView   *view,
                      MtkRegion          *swap_region,
+                     MtkRegion          *history_region,
                      MtkRegion          *queued_redraw_clip)
 {
   CoglFramebuffer *framebuffer = clutter_stage_view_get_framebuffer (view);
   CoglContext *ctx = cogl_framebuffer_get_context (framebuffer);
   static CoglPipeline *overlay_blue = NULL;
-  CoglColor blue_color, red_color;
+  CoglColor blue_color, green_color, red_color;
   MetaStageImpl *stage_impl = META_STAGE_IMPL (stage_window);
   ClutterActor *actor = CLUTTER_ACTOR (stage_impl->wrapper);
   graphene_matrix_t transform;
-  int n_rects, i;
 
   COGL_TRACE_BEGIN_SCOPED (PaintDamageRegion,
                            "Meta::StageImpl::paint_damage_region()");
@@ -161,19 +202,21 @@ paint_damage_region (ClutterStageWindow *stage_window,
       cogl_pipeline_set_color (overlay_blue, &blue_color);
     }
 
-  n_rects = mtk_region_num_rectangles (swap_region);
-  for (i = 0; i < n_rects; i++)
+  paint_overlay_region (framebuffer, overlay_blue, swap_region);
+
+  /* Green for what is repainted only to repair older buffers */
+  if (history_region)
     {
-      MtkRectangle rect;
-      float x_1, x_2, y_1, y_2;
+      static CoglPipeline *overlay_green = NULL;
 
-      rect = mtk_region_get_rectangle (swap_region, i);
-      x_1 = rect.x;
-      x_2 = rect.x + rect.width;
-      y_1 = rect.y;
-      y_2 = rect.y + rect.height;
+      if (G_UNLIKELY (overlay_green == NULL))
+        {
+          overlay_green = cogl_pipeline_new (ctx);
+          cogl_color_init_from_4f (&green_color, 0.0, 0.2, 0.0, 0.2);
+          cogl_pipeline_set_color (overlay_green, &green_color);
+        }
 
-      cogl_framebuffer_draw_rectangle (framebuffer, overlay_blue, x_1, y_1, x_2, y_2);
+      paint_overlay_region (framebuffer, overlay_green, history_region);
     }
 
   /* Red for the clip */
@@ -188,20 +231,7 @@ paint_damage_region (ClutterStageWindow *stage_window,
           cogl_pipeline_set_color (overlay_red, &red_color);
         }
 
-      n_rects = mtk_region_num_rectangles (queued_redraw_clip);
-      for (i = 0; i < n_rects; i++)
-        {
-          MtkRectangle rect;
-          float x_1, x_2, y_1, y_2;
-
-          rect = mtk_region_get_rectangle (queued_redraw_clip, i);
-          x_1 = rect.x;
-          x_2 = rect.x + rect.width;
-          y_1 = rect.y;
-          y_2 = rect.y + rect.height;
-
-          cogl_framebuffer_draw_rectangle (framebuffer, overlay_red, x_1, y_1, x_2, y_2);
-        }
+      paint_overlay_region (framebuffer, overlay_red, queued_redraw_clip);
     }
 
   cogl_framebuffer_pop_matrix (framebuffer);
@@ -520,8 +550,10 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
   g_autoptr (MtkRegion) queued_redraw_clip = NULL;
   g_autoptr (MtkRegion) fb_clip_region = NULL;
   g_autoptr (MtkRegion) swap_region = NULL;
+  g_autoptr (MtkRegion) history_redraw_clip = NULL;
   ClutterDrawDebugFlag paint_debug_flags;
   ClutterDamageHistory *damage_history;
+  ClutterDamageStatistics damage_statistics = { 0 };
   float fb_scale;
   int fb_width, fb_height;
   int buffer_age = 0;
@@ -572,6 +604,7 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
                                                       -view_rect.x,
                                                       -view_rect.y,
                                                       fb_scale);
+      damage_statistics.damaged_area = get_region_area (fb_clip_region);
 
       if (G_UNLIKELY (paint_debug_flags & CLUTTER_DEBUG_PAINT_DAMAGE_REGION))
         {
@@ -592,6 +625,22 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
       };
       fb_clip_region = mtk_region_create_rectangle (&fb_rect);
 
+      if (redraw_clip)
+        {
+          g_autoptr (MtkRegion) fb_redraw_clip = NULL;
+
+          fb_redraw_clip = offset_scale_and_clamp_region (redraw_clip,
+                                                          -view_rect.x,
+                                                          -view_rect.y,
+                                                          fb_scale);
+          mtk_region_intersect_rectangle (fb_redraw_clip, &fb_rect);
+          damage_statistics.damaged_area = get_region_area (fb_redraw_clip);
+        }
+      else
+        {
+          damage_statistics.damaged_area = fb_width * fb_height;
+        }
+
       g_clear_pointer (&redraw_clip, mtk_region_unref);
       redraw_clip = mtk_region_create_rectangle (&view_rect);
 
@@ -661,8 +710,18 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
                                                    1.0 / fb_scale,
                                                    view_rect.x,
                                                    view_rect.y);
+
+      if (G_UNLIKELY (queued_redraw_clip))
+        {
+          history_redraw_clip = mtk_region_copy (redraw_clip);
+          mtk_region_subtract (history_redraw_clip, queued_redraw_clip);
+        }
     }
 
+  damage_statistics.repainted_area = get_region_area (fb_clip_region);
+  clutter_stage_view_record_damage_statistics (stage_view,
+                                               &damage_statistics);
+
   if (paint_debug_flags & CLUTTER_DEBUG_PAINT_DAMAGE_REGION)
     {
       g_autoptr (MtkRegion) debug_redraw_clip = NULL;
@@ -701,9 +760,13 @@ meta_stage_impl_redraw_view_primary (MetaStageImpl    *stage_impl,
                                        view_rect.y);
 
       mtk_region_subtract (swap_region_in_stage_space, queued_redraw_clip);
+      if (history_redraw_clip)
+        mtk_region_subtract (swap_region_in_stage_space, history_redraw_clip);
 
       paint_damage_region (stage_window, stage_view,
-                           swap_region_in_stage_space, queued_redraw_clip);
+                           swap_region_in_stage_space,
+                           history_redraw_clip,
+                           queued_redraw_clip);
     }
 
   if (clutter_stage_view_get_onscreen (stage_view) !=
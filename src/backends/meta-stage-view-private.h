@@ -26,6 +26,7 @@
 #pragma once
 
 #include "backends/meta-stage-view.h"
+#include "core/util-private.h"
 
 G_BEGIN_DECLS
 
@@ -38,3 +39,9 @@ struct _MetaStageViewClass
 ClutterDamageHistory * meta_stage_view_get_damage_history (MetaStageView *view);
 void meta_stage_view_perform_fake_swap (MetaStageView *view,
                                         int64_t        counter);
+
+META_EXPORT_TEST
+void meta_stage_view_hold_presentation (MetaStageView *view);
+
+META_EXPORT_TEST
+void meta_stage_view_release_presentation (MetaStageView *view);
@@ -25,6 +25,8 @@
 
 #include "backends/meta-stage-view-private.h"
 
+typedef struct _NotifyPresentedClosure NotifyPresentedClosure;
+
 typedef struct _MetaStageViewPrivate
 {
   /* Damage history, in stage view render target framebuffer coordinate space.
@@ -32,6 +34,8 @@ typedef struct _MetaStageViewPrivate
   ClutterDamageHistory *damage_history;
 
   guint notify_presented_handle_id;
+  NotifyPresentedClosure *pending_presentation;
+  int hold_presentation_count;
 
   CoglFrameClosure *frame_cb_closure;
 
@@ -41,6 +45,8 @@ typedef struct _MetaStageViewPrivate
 G_DEFINE_TYPE_WITH_PRIVATE (MetaStageView, meta_stage_view,
                             CLUTTER_TYPE_STAGE_VIEW)
 
+static void notify_presented_closure_free (NotifyPresentedClosure *closure);
+
 static void
 frame_cb (CoglOnscreen  *onscreen,
           CoglFrameEvent frame_event,
@@ -97,6 +103,8 @@ meta_stage_view_dispose (GObject *object)
   ClutterStageView *stage_view = CLUTTER_STAGE_VIEW (view);
 
   g_clear_handle_id (&priv->notify_presented_handle_id, g_source_remove);
+  g_clear_pointer (&priv->pending_presentation,
+                   notify_presented_closure_free);
   g_clear_pointer (&priv->damage_history, clutter_damage_history_free);
 
   if (priv->frame_cb_closure)
@@ -178,11 +186,30 @@ meta_stage_view_get_damage_history (MetaStageView *view)
   return priv->damage_history;
 }
 
-typedef struct _NotifyPresentedClosure
+struct _NotifyPresentedClosure
 {
   ClutterStageView *view;
   ClutterFrameInfo frame_info;
-} NotifyPresentedClosure;
+
+  CoglTimestampQuery *timestamp_query;
+  int64_t gpu_time_before_buffer_swap_ns;
+};
+
+static void
+notify_presented_closure_free (NotifyPresentedClosure *closure)
+{
+  if (closure->timestamp_query)
+    {
+      CoglFramebuffer *framebuffer =
+        clutter_stage_view_get_framebuffer (closure->view);
+      CoglContext *cogl_context = cogl_framebuffer_get_context (framebuffer);
+
+      cogl_context_free_timestamp_query (cogl_context,
+                                         closure->timestamp_query);
+    }
+
+  g_free (closure);
+}
 
 static gboolean
 notify_presented_idle (gpointer user_data)
@@ -193,11 +220,45 @@ notify_presented_idle (gpointer user_data)
     meta_stage_view_get_instance_private (view);
 
   priv->notify_presented_handle_id = 0;
+
+  if (closure->timestamp_query)
+    {
+      CoglFramebuffer *framebuffer =
+        clutter_stage_view_get_framebuffer (closure->view);
+      CoglContext *cogl_context = cogl_framebuffer_get_context (framebuffer);
+      int64_t gpu_time_rendering_done_ns;
+
+      gpu_time_rendering_done_ns =
+        cogl_context_timestamp_query_get_time_ns (cogl_context,
+                                                  closure->timestamp_query);
+      closure->frame_info.gpu_rendering_duration_ns =
+        gpu_time_rendering_done_ns - closure->gpu_time_before_buffer_swap_ns;
+    }
+
+  /* Nothing scans out a virtual view, so the frame is presented as soon as
+   * it is handed over, which may have been delayed by a presentation hold */
+  closure->frame_info.presentation_time = g_get_monotonic_time ();
+
   clutter_stage_view_notify_presented (closure->view, &closure->frame_info);
 
   return G_SOURCE_REMOVE;
 }
 
+static void
+queue_notify_presented (MetaStageView          *view,
+                        NotifyPresentedClosure *closure)
+{
+  MetaStageViewPrivate *priv =
+    meta_stage_view_get_instance_private (view);
+
+  g_warn_if_fail (priv->notify_presented_handle_id == 0);
+  priv->notify_presented_handle_id =
+    g_idle_add_full (G_PRIORITY_DEFAULT,
+                     notify_presented_idle,
+                     closure,
+                     (GDestroyNotify) notify_presented_closure_free);
+}
+
 void
 meta_stage_view_perform_fake_swap (MetaStageView *view,
                                    int64_t        counter)
@@ -205,6 +266,9 @@ meta_stage_view_perform_fake_swap (MetaStageView *view,
   ClutterStageView *clutter_view = CLUTTER_STAGE_VIEW (view);
   MetaStageViewPrivate *priv =
     meta_stage_view_get_instance_private (view);
+  CoglFramebuffer *framebuffer =
+    clutter_stage_view_get_framebuffer (clutter_view);
+  CoglContext *cogl_context = cogl_framebuffer_get_context (framebuffer);
   NotifyPresentedClosure *closure;
 
   closure = g_new0 (NotifyPresentedClosure, 1);
@@ -212,16 +276,64 @@ meta_stage_view_perform_fake_swap (MetaStageView *view,
   closure->frame_info = (ClutterFrameInfo) {
     .frame_counter = counter,
     .refresh_rate = clutter_stage_view_get_refresh_rate (clutter_view),
-    .presentation_time = g_get_monotonic_time (),
     .flags = CLUTTER_FRAME_INFO_FLAG_NONE,
     .sequence = 0,
+    .cpu_time_before_buffer_swap_us = g_get_monotonic_time (),
+    .has_valid_gpu_rendering_duration = TRUE,
   };
 
-  g_warn_if_fail (priv->notify_presented_handle_id == 0);
-  priv->notify_presented_handle_id =
-    g_idle_add_full (G_PRIORITY_DEFAULT,
-                     notify_presented_idle,
-                     closure, g_free);
+  /* Without timestamp queries the GPU time is left out, which still gives
+   * the frame clock the CPU side of the update duration to work with */
+  if (cogl_has_feature (cogl_context, COGL_FEATURE_ID_TIMESTAMP_QUERY))
+    {
+      closure->gpu_time_before_buffer_swap_ns =
+        cogl_context_get_gpu_time_ns (cogl_context);
+      closure->timestamp_query =
+        cogl_framebuffer_create_timestamp_query (framebuffer);
+    }
+
+  if (priv->hold_presentation_count > 0)
+    {
+      g_warn_if_fail (!priv->pending_presentation);
+      g_clear_pointer (&priv->pending_presentation,
+                       notify_presented_closure_free);
+      priv->pending_presentation = closure;
+      return;
+    }
+
+  queue_notify_presented (view, closure);
+}
+
+/**
+ * meta_stage_view_hold_presentation:
+ * @view: a #MetaStageView
+ *
+ * Holds back the presentation of frames swapped with
+ * meta_stage_view_perform_fake_swap() until
+ * meta_stage_view_release_presentation() is called, keeping the frame clock
+ * from producing new frames meanwhile.
+ */
+void
+meta_stage_view_hold_presentation (MetaStageView *view)
+{
+  MetaStageViewPrivate *priv =
+    meta_stage_view_get_instance_private (view);
+
+  priv->hold_presentation_count++;
+}
+
+void
+meta_stage_view_release_presentation (MetaStageView *view)
+{
+  MetaStageViewPrivate *priv =
+    meta_stage_view_get_instance_private (view);
+
+  g_return_if_fail (priv->hold_presentation_count > 0);
+
+  priv->hold_presentation_count--;
+
+  if (priv->hold_presentation_count == 0 && priv->pending_presentation)
+    queue_notify_presented (view, g_steal_pointer (&priv->pending_presentation));
 }
 
 void
@@ -40,6 +40,7 @@ enum
   PROP_CRTC,
   PROP_CRTC_MODE,
   PROP_OUTPUT,
+  PROP_CLOCK_MODE,
 
   N_PROPS
 };
@@ -51,6 +52,7 @@ typedef struct _MetaVirtualMonitorPrivate
   MetaCrtc *crtc;
   MetaCrtcMode *crtc_mode;
   MetaOutput *output;
+  MetaVirtualMonitorClockMode clock_mode;
 
   gboolean is_destroyed;
 } MetaVirtualMonitorPrivate;
@@ -117,6 +119,15 @@ meta_virtual_monitor_get_output (MetaVirtualMonitor *virtual_monitor)
   return priv->output;
 }
 
+MetaVirtualMonitorClockMode
+meta_virtual_monitor_get_clock_mode (MetaVirtualMonitor *virtual_monitor)
+{
+  MetaVirtualMonitorPrivate *priv =
+    meta_virtual_monitor_get_instance_private (virtual_monitor);
+
+  return priv->clock_mode;
+}
+
 static void
 meta_virtual_monitor_set_property (GObject      *object,
                                    guint         prop_id,
@@ -139,6 +150,9 @@ meta_virtual_monitor_set_property (GObject      *object,
     case PROP_OUTPUT:
       priv->output = g_value_get_object (value);
       break;
+    case PROP_CLOCK_MODE:
+      priv->clock_mode = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -165,6 +179,9 @@ meta_virtual_monitor_get_property (GObject    *object,
     case PROP_OUTPUT:
       g_value_set_object (value, priv->output);
       break;
+    case PROP_CLOCK_MODE:
+      g_value_set_int (value, priv->clock_mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -221,6 +238,14 @@ meta_virtual_monitor_class_init (MetaVirtualMonitorClass *klass)
                          G_PARAM_READWRITE |
                          G_PARAM_CONSTRUCT_ONLY |
                          G_PARAM_STATIC_STRINGS);
+  obj_props[PROP_CLOCK_MODE] =
+    g_param_spec_int ("clock-mode", NULL, NULL,
+                      META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+                      META_VIRTUAL_MONITOR_CLOCK_MODE_STREAM,
+                      META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+                      G_PARAM_READWRITE |
+                      G_PARAM_CONSTRUCT_ONLY |
+                      G_PARAM_STATIC_STRINGS);
   g_object_class_install_properties (object_class, N_PROPS, obj_props);
 
   signals[DESTROY] =
@@ -23,6 +23,13 @@
 #include "backends/meta-backend-types.h"
 #include "core/util-private.h"
 
+typedef enum _MetaVirtualMonitorClockMode
+{
+  META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+  META_VIRTUAL_MONITOR_CLOCK_MODE_VARIABLE,
+  META_VIRTUAL_MONITOR_CLOCK_MODE_STREAM,
+} MetaVirtualMonitorClockMode;
+
 struct _MetaVirtualModeInfo
 {
   int width;
@@ -33,6 +40,7 @@ struct _MetaVirtualModeInfo
 struct _MetaVirtualMonitorInfo
 {
   MetaVirtualModeInfo mode_info;
+  MetaVirtualMonitorClockMode clock_mode;
 
   char *vendor;
   char *product;
@@ -73,6 +81,9 @@ MetaCrtcMode * meta_virtual_monitor_get_crtc_mode (MetaVirtualMonitor *virtual_m
 META_EXPORT_TEST
 MetaOutput * meta_virtual_monitor_get_output (MetaVirtualMonitor *virtual_monitor);
 
+META_EXPORT_TEST
+MetaVirtualMonitorClockMode meta_virtual_monitor_get_clock_mode (MetaVirtualMonitor *virtual_monitor);
+
 META_EXPORT_TEST
 void meta_virtual_monitor_set_mode (MetaVirtualMonitor *virtual_monitor,
                                     int                 width,
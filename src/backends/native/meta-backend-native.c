@@ -307,6 +307,16 @@ meta_backend_native_get_keymap_layout_group (MetaBackend *backend)
   return meta_seat_native_get_keyboard_layout_index (META_SEAT_NATIVE (seat));
 }
 
+static MetaKeymapSnapshot *
+meta_backend_native_get_keymap_snapshot (MetaBackend *backend)
+{
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  ClutterSeat *seat;
+
+  seat = clutter_backend_get_default_seat (clutter_backend);
+  return meta_seat_native_get_keymap_snapshot (META_SEAT_NATIVE (seat));
+}
+
 static void
 meta_backend_native_lock_layout_group (MetaBackend *backend,
                                        guint        idx)
@@ -807,6 +817,7 @@ meta_backend_native_class_init (MetaBackendNativeClass *klass)
 
   backend_class->set_keymap = meta_backend_native_set_keymap;
   backend_class->get_keymap = meta_backend_native_get_keymap;
+  backend_class->get_keymap_snapshot = meta_backend_native_get_keymap_snapshot;
   backend_class->get_keymap_layout_group = meta_backend_native_get_keymap_layout_group;
   backend_class->lock_layout_group = meta_backend_native_lock_layout_group;
   backend_class->update_stage = meta_backend_native_update_stage;
@@ -186,13 +186,23 @@ meta_crtc_kms_set_gamma_lut (MetaCrtc           *crtc,
   MetaMonitorManagerNative *monitor_manager_native =
     monitor_manager_from_crtc (crtc);
   ClutterActor *stage = meta_backend_get_stage (backend);
-  g_autofree char *gamma_ramp_string = NULL;
   MetaGammaLut *new_gamma;
 
-  gamma_ramp_string = generate_gamma_ramp_string (lut);
-  meta_topic (META_DEBUG_COLOR,
-              "Setting CRTC (%" G_GUINT64_FORMAT ") gamma to %s",
-              meta_crtc_get_id (crtc), gamma_ramp_string);
+  /* Gamma changes are applied with the next frame's KMS update; avoid
+   * scheduling one when the LUT didn't actually change, e.g. when the night
+   * light temperature changed too little to affect any entry. */
+  if (lut && meta_gamma_lut_equal (meta_crtc_kms_peek_gamma_lut (crtc_kms), lut))
+    return;
+
+  if (meta_is_topic_enabled (META_DEBUG_COLOR))
+    {
+      g_autofree char *gamma_ramp_string = NULL;
+
+      gamma_ramp_string = generate_gamma_ramp_string (lut);
+      meta_topic (META_DEBUG_COLOR,
+                  "Setting CRTC (%" G_GUINT64_FORMAT ") gamma to %s",
+                  meta_crtc_get_id (crtc), gamma_ramp_string);
+    }
 
   new_gamma = meta_gamma_lut_copy (lut);
   if (!new_gamma)
@@ -22,6 +22,8 @@
 struct _MetaCrtcVirtual
 {
   MetaCrtcNative parent;
+
+  MetaVirtualMonitorClockMode clock_mode;
 };
 
 #define META_CRTC_VIRTUAL_ID_BIT (((uint64_t) 1) << 63)
@@ -29,13 +31,25 @@ struct _MetaCrtcVirtual
 G_DEFINE_TYPE (MetaCrtcVirtual, meta_crtc_virtual, META_TYPE_CRTC_NATIVE)
 
 MetaCrtcVirtual *
-meta_crtc_virtual_new (MetaBackend *backend,
-                       uint64_t     id)
+meta_crtc_virtual_new (MetaBackend                 *backend,
+                       uint64_t                     id,
+                       MetaVirtualMonitorClockMode  clock_mode)
+{
+  MetaCrtcVirtual *crtc_virtual;
+
+  crtc_virtual = g_object_new (META_TYPE_CRTC_VIRTUAL,
+                               "backend", backend,
+                               "id", META_CRTC_VIRTUAL_ID_BIT | id,
+                               NULL);
+  crtc_virtual->clock_mode = clock_mode;
+
+  return crtc_virtual;
+}
+
+MetaVirtualMonitorClockMode
+meta_crtc_virtual_get_clock_mode (MetaCrtcVirtual *crtc_virtual)
 {
-  return g_object_new (META_TYPE_CRTC_VIRTUAL,
-                       "backend", backend,
-                       "id", META_CRTC_VIRTUAL_ID_BIT | id,
-                       NULL);
+  return crtc_virtual->clock_mode;
 }
 
 static size_t
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "backends/meta-virtual-monitor.h"
 #include "backends/native/meta-crtc-native.h"
 
 #define META_TYPE_CRTC_VIRTUAL (meta_crtc_virtual_get_type ())
@@ -25,5 +26,8 @@ G_DECLARE_FINAL_TYPE (MetaCrtcVirtual, meta_crtc_virtual,
                       META, CRTC_VIRTUAL,
                       MetaCrtcNative)
 
-MetaCrtcVirtual * meta_crtc_virtual_new (MetaBackend *backend,
-                                         uint64_t     id);
+MetaCrtcVirtual * meta_crtc_virtual_new (MetaBackend                 *backend,
+                                         uint64_t                     id,
+                                         MetaVirtualMonitorClockMode  clock_mode);
+
+MetaVirtualMonitorClockMode meta_crtc_virtual_get_clock_mode (MetaCrtcVirtual *crtc_virtual);
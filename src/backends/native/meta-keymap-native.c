@@ -19,15 +19,18 @@
 
 #include "config.h"
 
-#include "backends/meta-keymap-utils.h"
+#include "backends/meta-keymap-snapshot.h"
 #include "backends/native/meta-input-thread.h"
 #include "backends/native/meta-seat-impl.h"
 #include "backends/native/meta-seat-native.h"
 #include "clutter/clutter-keymap-private.h"
 
+#define MAX_CACHED_KEYMAPS 8
+
 static const char *option_xkb_layout = "us";
 static const char *option_xkb_variant = "";
 static const char *option_xkb_options = "";
+static const char *option_xkb_model = "pc105";
 
 typedef struct _MetaKeymapNative MetaKeymapNative;
 
@@ -35,7 +38,11 @@ struct _MetaKeymapNative
 {
   ClutterKeymap parent_instance;
 
-  struct xkb_keymap *keymap;
+  MetaKeymapSnapshot *snapshot;
+
+  /* Snapshots of previously used keymaps, by XKB rule names */
+  GHashTable *snapshots;
+
   gboolean num_lock;
   gboolean caps_lock;
 };
@@ -48,7 +55,8 @@ meta_keymap_native_finalize (GObject *object)
 {
   MetaKeymapNative *keymap = META_KEYMAP_NATIVE (object);
 
-  xkb_keymap_unref (keymap->keymap);
+  g_clear_pointer (&keymap->snapshot, meta_keymap_snapshot_unref);
+  g_clear_pointer (&keymap->snapshots, g_hash_table_unref);
 
   G_OBJECT_CLASS (meta_keymap_native_parent_class)->finalize (object);
 }
@@ -73,36 +81,71 @@ meta_keymap_native_class_init (MetaKeymapNativeClass *klass)
 static void
 meta_keymap_native_init (MetaKeymapNative *keymap)
 {
-  struct xkb_context *ctx;
-  struct xkb_rule_names names;
-
-  names.rules = "evdev";
-  names.model = "pc105";
-  names.layout = option_xkb_layout;
-  names.variant = option_xkb_variant;
-  names.options = option_xkb_options;
-
-  ctx = meta_create_xkb_context ();
-  g_assert (ctx);
-  keymap->keymap = xkb_keymap_new_from_names (ctx, &names, 0);
-  xkb_context_unref (ctx);
+  keymap->snapshots =
+    g_hash_table_new_full (g_str_hash, g_str_equal,
+                           g_free,
+                           (GDestroyNotify) meta_keymap_snapshot_unref);
+
+  meta_keymap_native_set_keyboard_map_in_impl (keymap,
+                                               option_xkb_layout,
+                                               option_xkb_variant,
+                                               option_xkb_options,
+                                               option_xkb_model);
 }
 
-void
-meta_keymap_native_set_keyboard_map_in_impl (MetaKeymapNative  *keymap,
-                                             struct xkb_keymap *xkb_keymap)
+gboolean
+meta_keymap_native_set_keyboard_map_in_impl (MetaKeymapNative *keymap,
+                                             const char       *layouts,
+                                             const char       *variants,
+                                             const char       *options,
+                                             const char       *model)
 {
-  g_return_if_fail (xkb_keymap != NULL);
-
-  if (keymap->keymap)
-    xkb_keymap_unref (keymap->keymap);
-  keymap->keymap = xkb_keymap_ref (xkb_keymap);
+  g_autofree char *key = NULL;
+  MetaKeymapSnapshot *snapshot;
+
+  key = meta_keymap_snapshot_names_to_key (layouts, variants, options, model);
+  snapshot = g_hash_table_lookup (keymap->snapshots, key);
+  if (!snapshot)
+    {
+      g_autoptr (GError) error = NULL;
+
+      snapshot = meta_keymap_snapshot_new_from_names (layouts,
+                                                      variants,
+                                                      options,
+                                                      model,
+                                                      META_KEYMAP_SNAPSHOT_FLAG_NONE,
+                                                      &error);
+      if (!snapshot)
+        {
+          g_warning ("%s", error->message);
+          return FALSE;
+        }
+
+      if (g_hash_table_size (keymap->snapshots) >= MAX_CACHED_KEYMAPS)
+        g_hash_table_remove_all (keymap->snapshots);
+
+      g_hash_table_insert (keymap->snapshots, g_steal_pointer (&key), snapshot);
+    }
+
+  g_clear_pointer (&keymap->snapshot, meta_keymap_snapshot_unref);
+  keymap->snapshot = meta_keymap_snapshot_ref (snapshot);
+
+  return TRUE;
 }
 
 struct xkb_keymap *
 meta_keymap_native_get_keyboard_map_in_impl (MetaKeymapNative *keymap)
 {
-  return keymap->keymap;
+  if (!keymap->snapshot)
+    return NULL;
+
+  return meta_keymap_snapshot_get_keymap (keymap->snapshot);
+}
+
+MetaKeymapSnapshot *
+meta_keymap_native_get_snapshot_in_impl (MetaKeymapNative *keymap)
+{
+  return keymap->snapshot;
 }
 
 typedef struct
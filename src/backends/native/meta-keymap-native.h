@@ -23,6 +23,7 @@
 #error "This header cannot be included directly. Use "backends/native/meta-input-thread.h""
 #endif /* META_INPUT_THREAD_H_INSIDE */
 
+#include "backends/meta-keymap-snapshot.h"
 #include "backends/native/meta-xkb-utils.h"
 #include "clutter/clutter.h"
 
@@ -31,9 +32,13 @@ G_DECLARE_FINAL_TYPE (MetaKeymapNative, meta_keymap_native,
                       META, KEYMAP_NATIVE,
                       ClutterKeymap)
 
-void meta_keymap_native_set_keyboard_map_in_impl (MetaKeymapNative  *keymap,
-                                                  struct xkb_keymap *xkb_keymap);
+gboolean meta_keymap_native_set_keyboard_map_in_impl (MetaKeymapNative *keymap,
+                                                      const char       *layouts,
+                                                      const char       *variants,
+                                                      const char       *options,
+                                                      const char       *model);
 struct xkb_keymap * meta_keymap_native_get_keyboard_map_in_impl (MetaKeymapNative *keymap);
+MetaKeymapSnapshot * meta_keymap_native_get_snapshot_in_impl (MetaKeymapNative *keymap);
 void meta_keymap_native_update_in_impl (MetaKeymapNative *keymap,
                                         MetaSeatImpl     *seat_impl,
                                         struct xkb_state *xkb_state);
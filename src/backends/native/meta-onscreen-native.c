@@ -30,6 +30,7 @@
 #include "backends/native/meta-onscreen-native.h"
 
 #include <drm_fourcc.h>
+#include <string.h>
 
 #include "backends/meta-egl-ext.h"
 #include "backends/native/meta-crtc-kms.h"
@@ -77,6 +78,21 @@ typedef struct _MetaOnscreenNativeSecondaryGpuState
   struct {
     MetaDrmBufferDumb *current_dumb_fb;
     MetaDrmBufferDumb *dumb_fbs[2];
+
+    /* Damage-aware readback, see copy_shared_framebuffer_cpu_damage() */
+    gboolean use_damage;
+    int dumb_fb_ages[2];
+    ClutterDamageHistory *damage_history;
+    CoglPixelBuffer *readback_buffer;
+
+    struct {
+      MetaDrmBufferDumb *dumb_fb;
+      MtkRegion *region;
+    } pending_readback;
+
+    uint64_t n_frames;
+    uint64_t n_bytes_copied;
+    int64_t stall_time_us;
   } cpu;
 
   gboolean noted_primary_gpu_copy_ok;
@@ -737,8 +753,31 @@ secondary_gpu_release_dumb (MetaOnscreenNativeSecondaryGpuState *secondary_gpu_s
 {
   unsigned i;
 
+  if (secondary_gpu_state->cpu.n_frames > 0)
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "CPU copy read back %" G_GUINT64_FORMAT " bytes in %"
+                  G_GUINT64_FORMAT " frames, stalling for %" G_GINT64_FORMAT
+                  " us",
+                  secondary_gpu_state->cpu.n_bytes_copied,
+                  secondary_gpu_state->cpu.n_frames,
+                  secondary_gpu_state->cpu.stall_time_us);
+    }
+
+  g_clear_object (&secondary_gpu_state->cpu.pending_readback.dumb_fb);
+  g_clear_pointer (&secondary_gpu_state->cpu.pending_readback.region,
+                   mtk_region_unref);
+  g_clear_object (&secondary_gpu_state->cpu.readback_buffer);
+  g_clear_pointer (&secondary_gpu_state->cpu.damage_history,
+                   clutter_damage_history_free);
+
   for (i = 0; i < G_N_ELEMENTS (secondary_gpu_state->cpu.dumb_fbs); i++)
-    g_clear_object (&secondary_gpu_state->cpu.dumb_fbs[i]);
+    {
+      g_clear_object (&secondary_gpu_state->cpu.dumb_fbs[i]);
+      secondary_gpu_state->cpu.dumb_fb_ages[i] = 0;
+    }
+
+  secondary_gpu_state->cpu.n_frames = 0;
 }
 
 static void
@@ -1098,6 +1137,315 @@ copy_shared_framebuffer_cpu (CoglOnscreen                        *onscreen,
   return g_object_ref (buffer);
 }
 
+static int
+secondary_gpu_get_dumb_buffer_index (MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state,
+                                     MetaDrmBufferDumb                   *buffer_dumb)
+{
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS (secondary_gpu_state->cpu.dumb_fbs); i++)
+    {
+      if (secondary_gpu_state->cpu.dumb_fbs[i] == buffer_dumb)
+        return i;
+    }
+
+  g_assert_not_reached ();
+  return -1;
+}
+
+static void
+secondary_gpu_invalidate_dumb_damage (MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state)
+{
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS (secondary_gpu_state->cpu.dumb_fb_ages); i++)
+    secondary_gpu_state->cpu.dumb_fb_ages[i] = 0;
+}
+
+static MtkRegion *
+calculate_dumb_buffer_readback_region (MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state,
+                                       int                                  dumb_fb_index,
+                                       int                                  width,
+                                       int                                  height,
+                                       const int                           *rectangles,
+                                       int                                  n_rectangles)
+{
+  ClutterDamageHistory *damage_history =
+    secondary_gpu_state->cpu.damage_history;
+  MtkRectangle fb_rect = { .width = width, .height = height };
+  g_autoptr (MtkRegion) damage = NULL;
+  MtkRegion *region;
+  int buffer_age;
+  int i;
+
+  if (n_rectangles == 0)
+    {
+      damage = mtk_region_create_rectangle (&fb_rect);
+    }
+  else
+    {
+      damage = mtk_region_create ();
+      for (i = 0; i < n_rectangles; i++)
+        {
+          MtkRectangle rect = {
+            .x = rectangles[i * 4],
+            .y = rectangles[i * 4 + 1],
+            .width = rectangles[i * 4 + 2],
+            .height = rectangles[i * 4 + 3],
+          };
+
+          mtk_region_union_rectangle (damage, &rect);
+        }
+      mtk_region_intersect_rectangle (damage, &fb_rect);
+    }
+
+  clutter_damage_history_record (damage_history, damage);
+
+  /* Like an EGL buffer age: a dumb buffer of age N misses the damage of the
+   * current frame and of the N - 1 frames before it. */
+  buffer_age = secondary_gpu_state->cpu.dumb_fb_ages[dumb_fb_index];
+  if (buffer_age == 1 ||
+      (buffer_age > 1 &&
+       clutter_damage_history_is_age_valid (damage_history, buffer_age - 1)))
+    {
+      int age;
+
+      region = mtk_region_copy (damage);
+      for (age = 1; age < buffer_age; age++)
+        {
+          const MtkRegion *old_damage;
+
+          old_damage = clutter_damage_history_lookup (damage_history, age);
+          mtk_region_union (region, old_damage);
+        }
+    }
+  else
+    {
+      region = mtk_region_create_rectangle (&fb_rect);
+    }
+
+  clutter_damage_history_step (damage_history);
+
+  for (i = 0; i < (int) G_N_ELEMENTS (secondary_gpu_state->cpu.dumb_fb_ages); i++)
+    {
+      if (secondary_gpu_state->cpu.dumb_fb_ages[i] > 0)
+        secondary_gpu_state->cpu.dumb_fb_ages[i]++;
+    }
+  secondary_gpu_state->cpu.dumb_fb_ages[dumb_fb_index] = 1;
+
+  return region;
+}
+
+static void
+finish_dumb_buffer_readback (MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state)
+{
+  MetaDrmBufferDumb *buffer_dumb = secondary_gpu_state->cpu.pending_readback.dumb_fb;
+  g_autoptr (MtkRegion) region = NULL;
+  MetaDrmBuffer *buffer;
+  CoglBuffer *readback_buffer;
+  g_autoptr (GError) error = NULL;
+  int height, stride, bpp;
+  uint8_t *buffer_data;
+  const uint8_t *readback_data;
+  uint64_t n_bytes = 0;
+  int64_t start_time_us, stall_time_us;
+  int n_rects, i;
+
+  COGL_TRACE_BEGIN_SCOPED (FinishDumbBufferReadback,
+                           "Meta::OnscreenNative::finish_dumb_buffer_readback()");
+
+  if (!buffer_dumb)
+    return;
+
+  region = g_steal_pointer (&secondary_gpu_state->cpu.pending_readback.region);
+  buffer = META_DRM_BUFFER (buffer_dumb);
+  height = meta_drm_buffer_get_height (buffer);
+  stride = meta_drm_buffer_get_stride (buffer);
+  bpp = meta_drm_buffer_get_bpp (buffer) / 8;
+  buffer_data = meta_drm_buffer_dumb_get_data (buffer_dumb);
+  readback_buffer = COGL_BUFFER (secondary_gpu_state->cpu.readback_buffer);
+
+  /* Mapping waits for the GPU to finish writing the pixel buffer; the
+   * readback was queued before swapping buffers, so it has been running
+   * while the frame was submitted. */
+  start_time_us = g_get_monotonic_time ();
+  readback_data = cogl_buffer_map (readback_buffer,
+                                   COGL_BUFFER_ACCESS_READ,
+                                   0);
+  stall_time_us = g_get_monotonic_time () - start_time_us;
+
+  if (!readback_data)
+    {
+      g_warning ("Failed to map CPU copy readback buffer");
+      secondary_gpu_invalidate_dumb_damage (secondary_gpu_state);
+      g_clear_object (&secondary_gpu_state->cpu.pending_readback.dumb_fb);
+      return;
+    }
+
+  n_rects = mtk_region_num_rectangles (region);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+      size_t row_length = (size_t) rect.width * bpp;
+      int y;
+
+      /* The readback buffer holds the frame bottom-up, flip while copying */
+      for (y = rect.y; y < rect.y + rect.height; y++)
+        {
+          size_t x_offset = (size_t) rect.x * bpp;
+          size_t dst_offset = (size_t) y * stride + x_offset;
+          size_t src_offset = (size_t) (height - y - 1) * stride + x_offset;
+
+          memcpy (buffer_data + dst_offset, readback_data + src_offset,
+                  row_length);
+        }
+
+      n_bytes += row_length * rect.height;
+    }
+
+  cogl_buffer_unmap (readback_buffer);
+
+  secondary_gpu_state->cpu.n_frames++;
+  secondary_gpu_state->cpu.n_bytes_copied += n_bytes;
+  secondary_gpu_state->cpu.stall_time_us += stall_time_us;
+
+#ifdef HAVE_PROFILER
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      g_autofree char *description = NULL;
+
+      description =
+        g_strdup_printf ("%" G_GUINT64_FORMAT " bytes in %d rectangles, "
+                         "stalled for %" G_GINT64_FORMAT " us",
+                         n_bytes, n_rects, stall_time_us);
+      COGL_TRACE_DESCRIBE (FinishDumbBufferReadback, description);
+    }
+#endif
+
+  g_clear_object (&secondary_gpu_state->cpu.pending_readback.dumb_fb);
+}
+
+static MetaDrmBuffer *
+copy_shared_framebuffer_cpu_damage (CoglOnscreen                        *onscreen,
+                                    MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state,
+                                    const int                           *rectangles,
+                                    int                                  n_rectangles)
+{
+  CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (onscreen);
+  CoglContext *cogl_context = cogl_framebuffer_get_context (framebuffer);
+  MetaDrmBufferDumb *buffer_dumb;
+  MetaDrmBuffer *buffer;
+  g_autoptr (MtkRegion) region = NULL;
+  int width, height, stride, bpp;
+  uint32_t drm_format;
+  CoglPixelFormat cogl_format;
+  const MetaFormatInfo *format_info;
+  int n_rects, i;
+
+  COGL_TRACE_BEGIN_SCOPED (CopySharedFramebufferCpuDamage,
+                           "copy_shared_framebuffer_cpu_damage()");
+
+  /* A readback left over from an aborted swap still belongs in its dumb
+   * buffer, otherwise the buffer age bookkeeping would be wrong. */
+  finish_dumb_buffer_readback (secondary_gpu_state);
+
+  buffer_dumb = secondary_gpu_get_next_dumb_buffer (secondary_gpu_state);
+  buffer = META_DRM_BUFFER (buffer_dumb);
+
+  width = meta_drm_buffer_get_width (buffer);
+  height = meta_drm_buffer_get_height (buffer);
+  stride = meta_drm_buffer_get_stride (buffer);
+  bpp = meta_drm_buffer_get_bpp (buffer) / 8;
+  drm_format = meta_drm_buffer_get_format (buffer);
+
+  g_assert (cogl_framebuffer_get_width (framebuffer) == width);
+  g_assert (cogl_framebuffer_get_height (framebuffer) == height);
+
+  format_info = meta_format_info_from_drm_format (drm_format);
+  g_assert (format_info);
+  cogl_format = format_info->cogl_format;
+
+  if (!secondary_gpu_state->cpu.readback_buffer)
+    {
+      CoglPixelBuffer *readback_buffer;
+
+      /* Laid out like the dumb buffers but upside down, so damage can be
+       * copied over row by row. Without pixel buffer object support, this is
+       * a plain malloc() buffer and the readback is synchronous. */
+      readback_buffer = cogl_pixel_buffer_new (cogl_context,
+                                               (size_t) stride * height,
+                                               NULL);
+      cogl_buffer_set_update_hint (COGL_BUFFER (readback_buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+      secondary_gpu_state->cpu.readback_buffer = readback_buffer;
+    }
+
+  region = calculate_dumb_buffer_readback_region (
+    secondary_gpu_state,
+    secondary_gpu_get_dumb_buffer_index (secondary_gpu_state, buffer_dumb),
+    width, height,
+    rectangles, n_rectangles);
+
+  n_rects = mtk_region_num_rectangles (region);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+      g_autoptr (CoglBitmap) bitmap = NULL;
+
+      /* Flipping the rows in place would touch every full-stride row the
+       * rectangle spans, including other rectangles sharing them, and map
+       * the pixel buffer right away. Keep the rows bottom-up instead and
+       * flip them when copying into the dumb buffer. */
+      bitmap =
+        cogl_bitmap_new_from_buffer (COGL_BUFFER (secondary_gpu_state->cpu.readback_buffer),
+                                     cogl_format,
+                                     rect.width, rect.height,
+                                     stride,
+                                     (height - rect.y - rect.height) * stride +
+                                     rect.x * bpp);
+
+      if (!cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                     rect.x, rect.y,
+                                                     COGL_READ_PIXELS_COLOR_BUFFER |
+                                                     COGL_READ_PIXELS_NO_FLIP,
+                                                     bitmap))
+        {
+          g_warning ("Failed to CPU-copy to a secondary GPU output");
+          secondary_gpu_invalidate_dumb_damage (secondary_gpu_state);
+          break;
+        }
+    }
+
+  secondary_gpu_state->cpu.pending_readback.dumb_fb = g_object_ref (buffer_dumb);
+  secondary_gpu_state->cpu.pending_readback.region = g_steal_pointer (&region);
+
+  secondary_gpu_state->cpu.current_dumb_fb = buffer_dumb;
+
+  return g_object_ref (buffer);
+}
+
+static MetaDrmBuffer *
+copy_shared_framebuffer_cpu_fallback (CoglOnscreen                        *onscreen,
+                                      MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state,
+                                      MetaRendererNativeGpuData           *renderer_gpu_data,
+                                      const int                           *rectangles,
+                                      int                                  n_rectangles)
+{
+  if (secondary_gpu_state->cpu.use_damage)
+    {
+      return copy_shared_framebuffer_cpu_damage (onscreen,
+                                                 secondary_gpu_state,
+                                                 rectangles,
+                                                 n_rectangles);
+    }
+  else
+    {
+      return copy_shared_framebuffer_cpu (onscreen,
+                                          secondary_gpu_state,
+                                          renderer_gpu_data);
+    }
+}
+
 static MetaDrmBuffer *
 update_secondary_gpu_state_pre_swap_buffers (CoglOnscreen *onscreen,
                                              const int    *rectangles,
@@ -1106,6 +1454,7 @@ update_secondary_gpu_state_pre_swap_buffers (CoglOnscreen *onscreen,
   MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
   MetaOnscreenNativeSecondaryGpuState *secondary_gpu_state;
   MetaDrmBuffer *copy = NULL;
+  gboolean used_cpu_copy = FALSE;
 
   COGL_TRACE_BEGIN_SCOPED (MetaRendererNativeGpuStatePreSwapBuffers,
                            "update_secondary_gpu_state_pre_swap_buffers()");
@@ -1145,9 +1494,12 @@ update_secondary_gpu_state_pre_swap_buffers (CoglOnscreen *onscreen,
                   secondary_gpu_state->noted_primary_gpu_copy_failed = TRUE;
                 }
 
-              copy = copy_shared_framebuffer_cpu (onscreen,
-                                                  secondary_gpu_state,
-                                                  renderer_gpu_data);
+              copy = copy_shared_framebuffer_cpu_fallback (onscreen,
+                                                           secondary_gpu_state,
+                                                           renderer_gpu_data,
+                                                           rectangles,
+                                                           n_rectangles);
+              used_cpu_copy = TRUE;
             }
           else if (!secondary_gpu_state->noted_primary_gpu_copy_ok)
             {
@@ -1158,6 +1510,10 @@ update_secondary_gpu_state_pre_swap_buffers (CoglOnscreen *onscreen,
             }
           break;
         }
+
+      /* Dumb buffers are only tracked while the CPU copy fills them */
+      if (!used_cpu_copy)
+        secondary_gpu_invalidate_dumb_damage (secondary_gpu_state);
     }
 
   return copy;
@@ -1185,6 +1541,9 @@ update_secondary_gpu_state_post_swap_buffers (CoglOnscreen   *onscreen,
       renderer_gpu_data =
         meta_renderer_native_get_gpu_data (renderer_native,
                                            secondary_gpu_state->gpu_kms);
+
+      finish_dumb_buffer_readback (secondary_gpu_state);
+
       switch (renderer_gpu_data->secondary.copy_mode)
         {
         case META_SHARED_FRAMEBUFFER_COPY_MODE_ZERO:
@@ -2591,6 +2950,17 @@ init_secondary_gpu_state_cpu_copy_mode (MetaRendererNative         *renderer_nat
   secondary_gpu_state->gpu_kms = gpu_kms;
   secondary_gpu_state->egl_surface = EGL_NO_SURFACE;
 
+  secondary_gpu_state->cpu.use_damage =
+    g_strcmp0 (g_getenv ("MUTTER_DEBUG_FULL_CPU_COPY"), "1") != 0;
+  if (secondary_gpu_state->cpu.use_damage)
+    secondary_gpu_state->cpu.damage_history = clutter_damage_history_new ();
+
+  meta_topic (META_DEBUG_KMS,
+              "CPU copy for %s reads back %s",
+              meta_render_device_get_name (render_device),
+              secondary_gpu_state->cpu.use_damage ?
+              "damage asynchronously" : "full frames");
+
   for (i = 0; i < G_N_ELEMENTS (secondary_gpu_state->cpu.dumb_fbs); i++)
     {
       MetaDrmBuffer *dumb_buffer;
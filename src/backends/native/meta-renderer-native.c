@@ -1486,6 +1486,17 @@ meta_renderer_native_create_view (MetaRenderer       *renderer,
                               "vblank-duration-us", crtc_mode_info->vblank_duration_us,
                               NULL);
 
+  if (META_IS_CRTC_VIRTUAL (crtc) &&
+      meta_crtc_virtual_get_clock_mode (META_CRTC_VIRTUAL (crtc)) ==
+      META_VIRTUAL_MONITOR_CLOCK_MODE_VARIABLE)
+    {
+      ClutterFrameClock *frame_clock =
+        clutter_stage_view_get_frame_clock (CLUTTER_STAGE_VIEW (view_native));
+
+      clutter_frame_clock_set_mode (frame_clock,
+                                    CLUTTER_FRAME_CLOCK_MODE_VARIABLE);
+    }
+
   if (META_IS_ONSCREEN_NATIVE (framebuffer))
     {
       CoglDisplayEGL *cogl_display_egl;
@@ -24,6 +24,7 @@
 
 #include "backends/native/meta-renderer-view-native.h"
 
+#include "backends/native/meta-crtc-virtual.h"
 #include "backends/native/meta-frame-native.h"
 
 struct _MetaRendererViewNative
@@ -40,12 +41,37 @@ meta_renderer_view_native_new_frame (ClutterStageView *stage_view)
   return (ClutterFrame *) meta_frame_native_new ();
 }
 
+static void
+meta_renderer_view_native_schedule_update (ClutterStageView *stage_view)
+{
+  MetaCrtc *crtc = meta_renderer_view_get_crtc (META_RENDERER_VIEW (stage_view));
+  ClutterStageViewClass *parent_class =
+    CLUTTER_STAGE_VIEW_CLASS (meta_renderer_view_native_parent_class);
+
+  /* Virtual monitors with a variable rate have no frame sync surface driving
+   * them, so any update is one that should be presented as soon as possible */
+  if (META_IS_CRTC_VIRTUAL (crtc) &&
+      meta_crtc_virtual_get_clock_mode (META_CRTC_VIRTUAL (crtc)) ==
+      META_VIRTUAL_MONITOR_CLOCK_MODE_VARIABLE)
+    {
+      ClutterFrameClock *frame_clock =
+        clutter_stage_view_get_frame_clock (stage_view);
+
+      clutter_frame_clock_schedule_update_now (frame_clock);
+      return;
+    }
+
+  parent_class->schedule_update (stage_view);
+}
+
 static void
 meta_renderer_view_native_class_init (MetaRendererViewNativeClass *klass)
 {
   ClutterStageViewClass *stage_view_class = CLUTTER_STAGE_VIEW_CLASS (klass);
 
   stage_view_class->new_frame = meta_renderer_view_native_new_frame;
+  stage_view_class->schedule_update =
+    meta_renderer_view_native_schedule_update;
 }
 
 static void
@@ -3528,17 +3528,41 @@ meta_seat_impl_reclaim_devices (MetaSeatImpl *seat_impl)
   g_object_unref (task);
 }
 
+typedef struct
+{
+  char *layouts;
+  char *variants;
+  char *options;
+  char *model;
+} SetKeyboardMapData;
+
+static void
+set_keyboard_map_data_free (SetKeyboardMapData *data)
+{
+  g_free (data->layouts);
+  g_free (data->variants);
+  g_free (data->options);
+  g_free (data->model);
+  g_free (data);
+}
+
 static gboolean
 set_keyboard_map (GTask *task)
 {
   MetaSeatImpl *seat_impl = g_task_get_source_object (task);
-  struct xkb_keymap *xkb_keymap = g_task_get_task_data (task);
+  SetKeyboardMapData *data = g_task_get_task_data (task);
   MetaKeymapNative *keymap;
 
+  /* The keymap is compiled here, on the input thread, unless it was
+   * used before */
   keymap = seat_impl->keymap;
-  meta_keymap_native_set_keyboard_map_in_impl (keymap, xkb_keymap);
+  if (meta_keymap_native_set_keyboard_map_in_impl (keymap,
+                                                   data->layouts,
+                                                   data->variants,
+                                                   data->options,
+                                                   data->model))
+    meta_seat_impl_update_xkb_state_in_impl (seat_impl);
 
-  meta_seat_impl_update_xkb_state_in_impl (seat_impl);
   g_task_return_boolean (task, TRUE);
 
   return G_SOURCE_REMOVE;
@@ -3547,7 +3571,10 @@ set_keyboard_map (GTask *task)
 /**
  * meta_seat_impl_set_keyboard_map: (skip)
  * @seat_impl: the #ClutterSeat created by the evdev backend
- * @keymap: the new keymap
+ * @layouts: the XKB layouts
+ * @variants: the XKB variants
+ * @options: the XKB options
+ * @model: the XKB model
  *
  * Instructs @evdev to use the specified keyboard map. This will cause
  * the backend to drop the state and create a new one with the new
@@ -3555,18 +3582,26 @@ set_keyboard_map (GTask *task)
  * is pressed when calling this function.
  */
 void
-meta_seat_impl_set_keyboard_map (MetaSeatImpl      *seat_impl,
-                                 struct xkb_keymap *xkb_keymap)
+meta_seat_impl_set_keyboard_map (MetaSeatImpl *seat_impl,
+                                 const char   *layouts,
+                                 const char   *variants,
+                                 const char   *options,
+                                 const char   *model)
 {
+  SetKeyboardMapData *data;
   GTask *task;
 
   g_return_if_fail (META_IS_SEAT_IMPL (seat_impl));
-  g_return_if_fail (xkb_keymap != NULL);
+
+  data = g_new0 (SetKeyboardMapData, 1);
+  data->layouts = g_strdup (layouts);
+  data->variants = g_strdup (variants);
+  data->options = g_strdup (options);
+  data->model = g_strdup (model);
 
   task = g_task_new (seat_impl, NULL, NULL, NULL);
-  g_task_set_task_data (task,
-                        xkb_keymap_ref (xkb_keymap),
-                        (GDestroyNotify) xkb_keymap_unref);
+  g_task_set_task_data (task, data,
+                        (GDestroyNotify) set_keyboard_map_data_free);
   meta_seat_impl_run_input_task (seat_impl, task, (GSourceFunc) set_keyboard_map);
   g_object_unref (task);
 }
@@ -207,8 +207,11 @@ void  meta_seat_impl_reclaim_devices (MetaSeatImpl *seat_impl);
 
 struct xkb_state * meta_seat_impl_get_xkb_state_in_impl (MetaSeatImpl *seat_impl);
 
-void meta_seat_impl_set_keyboard_map (MetaSeatImpl      *seat_impl,
-                                      struct xkb_keymap *keymap);
+void meta_seat_impl_set_keyboard_map (MetaSeatImpl *seat_impl,
+                                      const char   *layouts,
+                                      const char   *variants,
+                                      const char   *options,
+                                      const char   *model);
 
 void meta_seat_impl_set_keyboard_layout_index (MetaSeatImpl       *seat_impl,
                                                xkb_layout_index_t  idx);
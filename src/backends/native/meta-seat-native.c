@@ -29,7 +29,7 @@
 #include "backends/native/meta-seat-native.h"
 
 #include "backends/meta-cursor-tracker-private.h"
-#include "backends/meta-keymap-utils.h"
+#include "backends/meta-keymap-snapshot.h"
 #include "backends/native/meta-barrier-native.h"
 #include "backends/native/meta-input-thread.h"
 #include "backends/native/meta-keymap-native.h"
@@ -39,6 +39,8 @@
 
 #include "meta-private-enum-types.h"
 
+#define MAX_CACHED_KEYMAPS 8
+
 enum
 {
   PROP_0,
@@ -157,6 +159,10 @@ meta_seat_native_constructed (GObject *object)
   seat->core_pointer = meta_seat_impl_get_pointer (seat->impl);
   seat->core_keyboard = meta_seat_impl_get_keyboard (seat->impl);
 
+  seat->keymap_snapshots =
+    g_hash_table_new_full (g_str_hash, g_str_equal,
+                           g_free,
+                           (GDestroyNotify) meta_keymap_snapshot_unref);
   meta_seat_native_set_keyboard_map (seat, "us", "", "", DEFAULT_XKB_MODEL);
 
   if (G_OBJECT_CLASS (meta_seat_native_parent_class)->constructed)
@@ -220,7 +226,8 @@ meta_seat_native_dispose (GObject *object)
 {
   MetaSeatNative *seat = META_SEAT_NATIVE (object);
 
-  g_clear_pointer (&seat->xkb_keymap, xkb_keymap_unref);
+  g_clear_pointer (&seat->keymap_snapshot, meta_keymap_snapshot_unref);
+  g_clear_pointer (&seat->keymap_snapshots, g_hash_table_unref);
   g_clear_object (&seat->core_pointer);
   g_clear_object (&seat->core_keyboard);
   g_clear_pointer (&seat->impl, meta_seat_impl_destroy);
@@ -477,33 +484,13 @@ meta_seat_native_reclaim_devices (MetaSeatNative *seat)
   seat->released = FALSE;
 }
 
-static struct xkb_keymap *
-create_keymap (const char *layouts,
-               const char *variants,
-               const char *options,
-               const char *model)
-{
-  struct xkb_rule_names names;
-  struct xkb_keymap *keymap;
-  struct xkb_context *context;
-
-  names.rules = DEFAULT_XKB_RULES_FILE;
-  names.model = model;
-  names.layout = layouts;
-  names.variant = variants;
-  names.options = options;
-
-  context = meta_create_xkb_context ();
-  keymap = xkb_keymap_new_from_names (context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
-  xkb_context_unref (context);
-
-  return keymap;
-}
-
 /**
  * meta_seat_native_set_keyboard_map: (skip)
  * @seat: the #ClutterSeat created by the evdev backend
- * @keymap: the new keymap
+ * @layouts: the XKB layouts
+ * @variants: the XKB variants
+ * @options: the XKB options
+ * @model: the XKB model
  *
  * Instructs @evdev to use the specified keyboard map. This will cause
  * the backend to drop the state and create a new one with the new
@@ -517,25 +504,44 @@ meta_seat_native_set_keyboard_map (MetaSeatNative *seat,
                                    const char     *options,
                                    const char     *model)
 {
-  struct xkb_keymap *keymap, *impl_keymap;
-
-  keymap = create_keymap (layouts, variants, options, model);
-  impl_keymap = create_keymap (layouts, variants, options, model);
+  g_autofree char *key = NULL;
+  MetaKeymapSnapshot *snapshot;
 
-  if (keymap == NULL)
+  /* Switching between input sources often goes back and forth between
+   * the same few keymaps, so these are only compiled and serialized
+   * the first time */
+  key = meta_keymap_snapshot_names_to_key (layouts, variants, options, model);
+  snapshot = g_hash_table_lookup (seat->keymap_snapshots, key);
+  if (!snapshot)
     {
-      g_warning ("Unable to load configured keymap: rules=%s, model=%s, layout=%s, variant=%s, options=%s",
-                 DEFAULT_XKB_RULES_FILE, model, layouts,
-                 variants, options);
-      return;
+      g_autoptr (GError) error = NULL;
+
+      snapshot =
+        meta_keymap_snapshot_new_from_names (layouts,
+                                             variants,
+                                             options,
+                                             model,
+                                             META_KEYMAP_SNAPSHOT_FLAG_SERIALIZE,
+                                             &error);
+      if (!snapshot)
+        {
+          g_warning ("%s", error->message);
+          return;
+        }
+
+      if (g_hash_table_size (seat->keymap_snapshots) >= MAX_CACHED_KEYMAPS)
+        g_hash_table_remove_all (seat->keymap_snapshots);
+
+      g_hash_table_insert (seat->keymap_snapshots,
+                           g_steal_pointer (&key),
+                           snapshot);
     }
 
-  if (seat->xkb_keymap)
-    xkb_keymap_unref (seat->xkb_keymap);
-  seat->xkb_keymap = keymap;
+  g_clear_pointer (&seat->keymap_snapshot, meta_keymap_snapshot_unref);
+  seat->keymap_snapshot = meta_keymap_snapshot_ref (snapshot);
 
-  meta_seat_impl_set_keyboard_map (seat->impl, impl_keymap);
-  xkb_keymap_unref (impl_keymap);
+  meta_seat_impl_set_keyboard_map (seat->impl,
+                                   layouts, variants, options, model);
 }
 
 /**
@@ -551,7 +557,26 @@ meta_seat_native_get_keyboard_map (MetaSeatNative *seat)
 {
   g_return_val_if_fail (META_IS_SEAT_NATIVE (seat), NULL);
 
-  return seat->xkb_keymap;
+  if (!seat->keymap_snapshot)
+    return NULL;
+
+  return meta_keymap_snapshot_get_keymap (seat->keymap_snapshot);
+}
+
+/**
+ * meta_seat_native_get_keymap_snapshot: (skip)
+ * @seat: the #ClutterSeat created by the evdev backend
+ *
+ * Retrieves the snapshot of the keymap in use by the evdev backend.
+ *
+ * Return value: (transfer none): the #MetaKeymapSnapshot.
+ */
+MetaKeymapSnapshot *
+meta_seat_native_get_keymap_snapshot (MetaSeatNative *seat)
+{
+  g_return_val_if_fail (META_IS_SEAT_NATIVE (seat), NULL);
+
+  return seat->keymap_snapshot;
 }
 
 /**
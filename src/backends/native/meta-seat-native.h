@@ -26,6 +26,7 @@
 #include <linux/input-event-codes.h>
 
 #include "backends/meta-input-settings-private.h"
+#include "backends/meta-keymap-snapshot.h"
 #include "backends/meta-viewport-info.h"
 #include "backends/native/meta-backend-native-types.h"
 #include "backends/native/meta-barrier-native.h"
@@ -48,7 +49,8 @@ struct _MetaSeatNative
   MetaSeatNativeFlag flags;
 
   GList *devices;
-  struct xkb_keymap *xkb_keymap;
+  MetaKeymapSnapshot *keymap_snapshot;
+  GHashTable *keymap_snapshots;
   xkb_layout_index_t xkb_layout_index;
 
   ClutterInputDevice *core_pointer;
@@ -108,6 +110,8 @@ void meta_seat_native_set_keyboard_map (MetaSeatNative *seat,
 
 struct xkb_keymap * meta_seat_native_get_keyboard_map (MetaSeatNative *seat);
 
+MetaKeymapSnapshot * meta_seat_native_get_keymap_snapshot (MetaSeatNative *seat);
+
 void meta_seat_native_set_keyboard_layout_index (MetaSeatNative     *seat,
                                                  xkb_layout_index_t  idx);
 
@@ -97,6 +97,12 @@ typedef struct
   double y;
 } MetaVirtualEventTouch;
 
+typedef struct
+{
+  ClutterVirtualInputEvent *events;
+  size_t n_events;
+} MetaVirtualEventBatch;
+
 G_DEFINE_TYPE (MetaVirtualInputDeviceNative,
                meta_virtual_input_device_native,
                CLUTTER_TYPE_VIRTUAL_INPUT_DEVICE)
@@ -211,13 +217,11 @@ release_device_in_impl (GTask *task)
   return G_SOURCE_REMOVE;
 }
 
-static gboolean
-notify_relative_motion_in_impl (GTask *task)
+static void
+emit_relative_motion_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                              MetaVirtualEventMotion       *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventMotion *event = g_task_get_task_data (task);
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
     event->time_us = g_get_monotonic_time ();
@@ -228,6 +232,17 @@ notify_relative_motion_in_impl (GTask *task)
 						 event->x, event->y,
 						 event->x, event->y,
 						 NULL);
+}
+
+static gboolean
+notify_relative_motion_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventMotion *event = g_task_get_task_data (task);
+
+  emit_relative_motion_in_impl (virtual_evdev, event);
+
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -257,13 +272,11 @@ meta_virtual_input_device_native_notify_relative_motion (ClutterVirtualInputDevi
   g_object_unref (task);
 }
 
-static gboolean
-notify_absolute_motion_in_impl (GTask *task)
+static void
+emit_absolute_motion_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                              MetaVirtualEventMotion       *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventMotion *event = g_task_get_task_data (task);
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
     event->time_us = g_get_monotonic_time ();
@@ -273,6 +286,17 @@ notify_absolute_motion_in_impl (GTask *task)
 						 event->time_us,
 						 event->x, event->y,
 						 NULL);
+}
+
+static gboolean
+notify_absolute_motion_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventMotion *event = g_task_get_task_data (task);
+
+  emit_absolute_motion_in_impl (virtual_evdev, event);
+
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -302,13 +326,11 @@ meta_virtual_input_device_native_notify_absolute_motion (ClutterVirtualInputDevi
   g_object_unref (task);
 }
 
-static gboolean
-notify_button_in_impl (GTask *task)
+static void
+emit_button_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                     MetaVirtualEventButton       *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventButton *event = g_task_get_task_data (task);
   int button_count;
   int evdev_button;
 
@@ -321,7 +343,7 @@ notify_button_in_impl (GTask *task)
     {
       g_warning ("Unknown/invalid virtual device button 0x%x pressed",
                  evdev_button);
-      goto out;
+      return;
     }
 
   button_count = update_button_count_in_impl (virtual_evdev, evdev_button,
@@ -332,7 +354,7 @@ notify_button_in_impl (GTask *task)
                  event->button_state == CLUTTER_BUTTON_STATE_PRESSED ?
                  "presses" : "releases");
       update_button_count_in_impl (virtual_evdev, evdev_button, 1 - event->button_state);
-      goto out;
+      return;
     }
 
   meta_topic (META_DEBUG_INPUT,
@@ -346,7 +368,17 @@ notify_button_in_impl (GTask *task)
 					event->time_us,
 					evdev_button,
 					event->button_state);
- out:
+}
+
+static gboolean
+notify_button_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventButton *event = g_task_get_task_data (task);
+
+  emit_button_in_impl (virtual_evdev, event);
+
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -376,13 +408,11 @@ meta_virtual_input_device_native_notify_button (ClutterVirtualInputDevice *virtu
   g_object_unref (task);
 }
 
-static gboolean
-notify_key_in_impl (GTask *task)
+static void
+emit_key_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                  MetaVirtualEventKey          *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventKey *event = g_task_get_task_data (task);
   int key_count;
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
@@ -391,7 +421,7 @@ notify_key_in_impl (GTask *task)
   if (get_button_type (event->key) != EVDEV_BUTTON_TYPE_KEY)
     {
       g_warning ("Unknown/invalid virtual device key 0x%x pressed", event->key);
-      goto out;
+      return;
     }
 
   key_count = update_button_count_in_impl (virtual_evdev, event->key, event->key_state);
@@ -401,7 +431,7 @@ notify_key_in_impl (GTask *task)
                  event->key_state == CLUTTER_KEY_STATE_PRESSED ?
                  "presses" : "releases");
       update_button_count_in_impl (virtual_evdev, event->key, 1 - event->key_state);
-      goto out;
+      return;
     }
 
   meta_topic (META_DEBUG_INPUT,
@@ -415,8 +445,17 @@ notify_key_in_impl (GTask *task)
 				     event->key,
 				     event->key_state,
 				     TRUE);
+}
+
+static gboolean
+notify_key_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventKey *event = g_task_get_task_data (task);
+
+  emit_key_in_impl (virtual_evdev, event);
 
- out:
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -456,42 +495,30 @@ pick_keycode_for_keyval_in_current_group_in_impl (ClutterVirtualInputDevice *vir
     META_VIRTUAL_INPUT_DEVICE_NATIVE (virtual_device);
   ClutterBackend *backend;
   ClutterKeymap *keymap;
-  struct xkb_keymap *xkb_keymap;
+  MetaKeymapSnapshot *snapshot;
   struct xkb_state  *state;
-  guint keycode, layout;
-  xkb_keycode_t min_keycode, max_keycode;
+  xkb_keycode_t keycode;
+  xkb_level_index_t level;
+  guint layout;
 
   backend = clutter_get_default_backend ();
   keymap = clutter_seat_get_keymap (clutter_backend_get_default_seat (backend));
-  xkb_keymap = meta_keymap_native_get_keyboard_map_in_impl (META_KEYMAP_NATIVE (keymap));
+  snapshot = meta_keymap_native_get_snapshot_in_impl (META_KEYMAP_NATIVE (keymap));
   state = meta_seat_impl_get_xkb_state_in_impl (virtual_evdev->seat->impl);
 
+  if (!snapshot)
+    return FALSE;
+
   layout = xkb_state_serialize_layout (state, XKB_STATE_LAYOUT_EFFECTIVE);
-  min_keycode = xkb_keymap_min_keycode (xkb_keymap);
-  max_keycode = xkb_keymap_max_keycode (xkb_keymap);
-  for (keycode = min_keycode; keycode < max_keycode; keycode++)
-    {
-      gint num_levels, level;
-      num_levels = xkb_keymap_num_levels_for_key (xkb_keymap, keycode, layout);
-      for (level = 0; level < num_levels; level++)
-        {
-          const xkb_keysym_t *syms;
-          gint num_syms, sym;
-          num_syms = xkb_keymap_key_get_syms_by_level (xkb_keymap, keycode, layout, level, &syms);
-          for (sym = 0; sym < num_syms; sym++)
-            {
-              if (syms[sym] == keyval)
-                {
-                  *keycode_out = keycode;
-                  if (level_out)
-                    *level_out = level;
-                  return TRUE;
-                }
-            }
-        }
-    }
+  if (!meta_keymap_snapshot_lookup_keysym (snapshot, layout, keyval,
+                                           &keycode, &level))
+    return FALSE;
 
-  return FALSE;
+  *keycode_out = keycode;
+  if (level_out)
+    *level_out = level;
+
+  return TRUE;
 }
 
 static void
@@ -540,15 +567,13 @@ apply_level_modifiers_in_impl (ClutterVirtualInputDevice *virtual_device,
 				     TRUE);
 }
 
-static gboolean
-notify_keyval_in_impl (GTask *task)
+static void
+emit_keyval_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                     MetaVirtualEventKey          *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   ClutterVirtualInputDevice *virtual_device =
     CLUTTER_VIRTUAL_INPUT_DEVICE (virtual_evdev);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventKey *event = g_task_get_task_data (task);
   int key_count;
   guint keycode = 0, level = 0, evcode = 0;
 
@@ -560,7 +585,7 @@ notify_keyval_in_impl (GTask *task)
 							 &keycode, &level))
     {
       g_warning ("No keycode found for keyval %x in current group", event->key);
-      goto out;
+      return;
     }
 
   evcode = meta_xkb_keycode_to_evdev (keycode);
@@ -568,7 +593,7 @@ notify_keyval_in_impl (GTask *task)
   if (get_button_type (evcode) != EVDEV_BUTTON_TYPE_KEY)
     {
       g_warning ("Unknown/invalid virtual device key 0x%x pressed", evcode);
-      goto out;
+      return;
     }
 
   key_count = update_button_count_in_impl (virtual_evdev, evcode, event->key_state);
@@ -578,7 +603,7 @@ notify_keyval_in_impl (GTask *task)
                  event->key_state == CLUTTER_KEY_STATE_PRESSED ?
                  "presses" : "releases");
       update_button_count_in_impl (virtual_evdev, evcode, 1 - event->key_state);
-      goto out;
+      return;
     }
 
   meta_topic (META_DEBUG_INPUT,
@@ -605,8 +630,17 @@ notify_keyval_in_impl (GTask *task)
       apply_level_modifiers_in_impl (virtual_device, event->time_us,
                                      level, event->key_state);
     }
+}
+
+static gboolean
+notify_keyval_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventKey *event = g_task_get_task_data (task);
+
+  emit_keyval_in_impl (virtual_evdev, event);
 
- out:
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -665,13 +699,11 @@ direction_to_discrete (ClutterScrollDirection direction,
     }
 }
 
-static gboolean
-notify_discrete_scroll_in_impl (GTask *task)
+static void
+emit_discrete_scroll_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                              MetaVirtualEventScroll       *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventScroll *event = g_task_get_task_data (task);
   double discrete_dx = 0.0, discrete_dy = 0.0;
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
@@ -685,6 +717,16 @@ notify_discrete_scroll_in_impl (GTask *task)
                                                  discrete_dx * 120.0,
                                                  discrete_dy * 120.0,
                                                  event->scroll_source);
+}
+
+static gboolean
+notify_discrete_scroll_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventScroll *event = g_task_get_task_data (task);
+
+  emit_discrete_scroll_in_impl (virtual_evdev, event);
 
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
@@ -715,13 +757,11 @@ meta_virtual_input_device_native_notify_discrete_scroll (ClutterVirtualInputDevi
   g_object_unref (task);
 }
 
-static gboolean
-notify_scroll_continuous_in_impl (GTask *task)
+static void
+emit_scroll_continuous_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                                MetaVirtualEventScroll       *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventScroll *event = g_task_get_task_data (task);
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
     event->time_us = g_get_monotonic_time ();
@@ -744,6 +784,16 @@ notify_scroll_continuous_in_impl (GTask *task)
                                                        event->scroll_source,
                                                        CLUTTER_SCROLL_FINISHED_NONE);
     }
+}
+
+static gboolean
+notify_scroll_continuous_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventScroll *event = g_task_get_task_data (task);
+
+  emit_scroll_continuous_in_impl (virtual_evdev, event);
 
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
@@ -778,13 +828,11 @@ meta_virtual_input_device_native_notify_scroll_continuous (ClutterVirtualInputDe
   g_object_unref (task);
 }
 
-static gboolean
-notify_touch_down_in_impl (GTask *task)
+static void
+emit_touch_down_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                         MetaVirtualEventTouch        *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventTouch *event = g_task_get_task_data (task);
   MetaTouchState *touch_state;
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
@@ -793,7 +841,7 @@ notify_touch_down_in_impl (GTask *task)
   touch_state = meta_seat_impl_acquire_touch_state_in_impl (seat,
                                                             event->device_slot);
   if (!touch_state)
-    goto out;
+    return;
 
   touch_state->coords.x = event->x;
   touch_state->coords.y = event->y;
@@ -805,8 +853,17 @@ notify_touch_down_in_impl (GTask *task)
                                              touch_state->seat_slot,
                                              touch_state->coords.x,
                                              touch_state->coords.y);
+}
+
+static gboolean
+notify_touch_down_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventTouch *event = g_task_get_task_data (task);
+
+  emit_touch_down_in_impl (virtual_evdev, event);
 
- out:
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -838,13 +895,11 @@ meta_virtual_input_device_native_notify_touch_down (ClutterVirtualInputDevice *v
   g_object_unref (task);
 }
 
-static gboolean
-notify_touch_motion_in_impl (GTask *task)
+static void
+emit_touch_motion_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                           MetaVirtualEventTouch        *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventTouch *event = g_task_get_task_data (task);
   MetaTouchState *touch_state;
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
@@ -853,7 +908,7 @@ notify_touch_motion_in_impl (GTask *task)
   touch_state = meta_seat_impl_lookup_touch_state_in_impl (seat,
                                                            event->device_slot);
   if (!touch_state)
-    goto out;
+    return;
 
   touch_state->coords.x = event->x;
   touch_state->coords.y = event->y;
@@ -865,8 +920,17 @@ notify_touch_motion_in_impl (GTask *task)
                                              touch_state->seat_slot,
                                              touch_state->coords.x,
                                              touch_state->coords.y);
+}
+
+static gboolean
+notify_touch_motion_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventTouch *event = g_task_get_task_data (task);
+
+  emit_touch_motion_in_impl (virtual_evdev, event);
 
- out:
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -898,13 +962,11 @@ meta_virtual_input_device_native_notify_touch_motion (ClutterVirtualInputDevice
   g_object_unref (task);
 }
 
-static gboolean
-notify_touch_up_in_impl (GTask *task)
+static void
+emit_touch_up_in_impl (MetaVirtualInputDeviceNative *virtual_evdev,
+                       MetaVirtualEventTouch        *event)
 {
-  MetaVirtualInputDeviceNative *virtual_evdev =
-    g_task_get_source_object (task);
   MetaSeatImpl *seat = virtual_evdev->seat->impl;
-  MetaVirtualEventTouch *event = g_task_get_task_data (task);
   MetaTouchState *touch_state;
 
   if (event->time_us == CLUTTER_CURRENT_TIME)
@@ -913,7 +975,7 @@ notify_touch_up_in_impl (GTask *task)
   touch_state = meta_seat_impl_lookup_touch_state_in_impl (seat,
                                                            event->device_slot);
   if (!touch_state)
-    goto out;
+    return;
 
   meta_seat_impl_notify_touch_event_in_impl (seat,
                                              virtual_evdev->impl_state->device,
@@ -925,8 +987,17 @@ notify_touch_up_in_impl (GTask *task)
 
   meta_seat_impl_release_touch_state_in_impl (virtual_evdev->seat->impl,
                                               touch_state->seat_slot);
+}
+
+static gboolean
+notify_touch_up_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventTouch *event = g_task_get_task_data (task);
+
+  emit_touch_up_in_impl (virtual_evdev, event);
 
- out:
   g_task_return_boolean (task, TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -954,6 +1025,146 @@ meta_virtual_input_device_native_notify_touch_up (ClutterVirtualInputDevice *vir
   g_object_unref (task);
 }
 
+static void
+emit_event_in_impl (MetaVirtualInputDeviceNative   *virtual_evdev,
+                    const ClutterVirtualInputEvent *event)
+{
+  switch (event->type)
+    {
+    case CLUTTER_VIRTUAL_INPUT_EVENT_RELATIVE_MOTION:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_ABSOLUTE_MOTION:
+      {
+        MetaVirtualEventMotion motion = {
+          .time_us = event->time_us,
+          .x = event->motion.x,
+          .y = event->motion.y,
+        };
+
+        if (event->type == CLUTTER_VIRTUAL_INPUT_EVENT_RELATIVE_MOTION)
+          emit_relative_motion_in_impl (virtual_evdev, &motion);
+        else
+          emit_absolute_motion_in_impl (virtual_evdev, &motion);
+        break;
+      }
+    case CLUTTER_VIRTUAL_INPUT_EVENT_BUTTON:
+      {
+        MetaVirtualEventButton button = {
+          .time_us = event->time_us,
+          .button = event->button.button,
+          .button_state = event->button.button_state,
+        };
+
+        emit_button_in_impl (virtual_evdev, &button);
+        break;
+      }
+    case CLUTTER_VIRTUAL_INPUT_EVENT_KEY:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_KEYVAL:
+      {
+        MetaVirtualEventKey key = {
+          .time_us = event->time_us,
+          .key = event->key.key,
+          .key_state = event->key.key_state,
+        };
+
+        if (event->type == CLUTTER_VIRTUAL_INPUT_EVENT_KEY)
+          emit_key_in_impl (virtual_evdev, &key);
+        else
+          emit_keyval_in_impl (virtual_evdev, &key);
+        break;
+      }
+    case CLUTTER_VIRTUAL_INPUT_EVENT_DISCRETE_SCROLL:
+      {
+        MetaVirtualEventScroll scroll = {
+          .time_us = event->time_us,
+          .direction = event->discrete_scroll.direction,
+          .scroll_source = event->discrete_scroll.scroll_source,
+        };
+
+        emit_discrete_scroll_in_impl (virtual_evdev, &scroll);
+        break;
+      }
+    case CLUTTER_VIRTUAL_INPUT_EVENT_SCROLL_CONTINUOUS:
+      {
+        MetaVirtualEventScroll scroll = {
+          .time_us = event->time_us,
+          .dx = event->scroll.dx,
+          .dy = event->scroll.dy,
+          .scroll_source = event->scroll.scroll_source,
+          .finish_flags = event->scroll.finish_flags,
+        };
+
+        emit_scroll_continuous_in_impl (virtual_evdev, &scroll);
+        break;
+      }
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION:
+    case CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_UP:
+      {
+        MetaVirtualEventTouch touch = {
+          .time_us = event->time_us,
+          .device_slot = virtual_evdev->slot_base + (guint) event->touch.slot,
+          .x = event->touch.x,
+          .y = event->touch.y,
+        };
+
+        if (event->type == CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_DOWN)
+          emit_touch_down_in_impl (virtual_evdev, &touch);
+        else if (event->type == CLUTTER_VIRTUAL_INPUT_EVENT_TOUCH_MOTION)
+          emit_touch_motion_in_impl (virtual_evdev, &touch);
+        else
+          emit_touch_up_in_impl (virtual_evdev, &touch);
+        break;
+      }
+    }
+}
+
+static gboolean
+notify_events_in_impl (GTask *task)
+{
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    g_task_get_source_object (task);
+  MetaVirtualEventBatch *batch = g_task_get_task_data (task);
+  size_t i;
+
+  for (i = 0; i < batch->n_events; i++)
+    emit_event_in_impl (virtual_evdev, &batch->events[i]);
+
+  g_task_return_boolean (task, TRUE);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+virtual_event_batch_free (MetaVirtualEventBatch *batch)
+{
+  g_free (batch->events);
+  g_free (batch);
+}
+
+static void
+meta_virtual_input_device_native_notify_events (ClutterVirtualInputDevice      *virtual_device,
+                                                const ClutterVirtualInputEvent *events,
+                                                size_t                          n_events)
+{
+  MetaVirtualEventBatch *batch;
+  MetaVirtualInputDeviceNative *virtual_evdev =
+    META_VIRTUAL_INPUT_DEVICE_NATIVE (virtual_device);
+  GTask *task;
+
+  g_return_if_fail (virtual_evdev->impl_state->device != NULL);
+
+  /* The whole batch is emitted from a single input thread dispatch, in
+   * order, instead of queuing one task per event. */
+  batch = g_new0 (MetaVirtualEventBatch, 1);
+  batch->events = g_memdup2 (events, n_events * sizeof (ClutterVirtualInputEvent));
+  batch->n_events = n_events;
+
+  task = g_task_new (virtual_device, NULL, NULL, NULL);
+  g_task_set_task_data (task, batch, (GDestroyNotify) virtual_event_batch_free);
+  meta_seat_impl_run_input_task (virtual_evdev->seat->impl, task,
+                                 (GSourceFunc) notify_events_in_impl);
+  g_object_unref (task);
+}
+
 static void
 meta_virtual_input_device_native_get_property (GObject    *object,
                                                guint       prop_id,
@@ -1094,6 +1305,7 @@ meta_virtual_input_device_native_class_init (MetaVirtualInputDeviceNativeClass *
   virtual_input_device_class->notify_touch_down = meta_virtual_input_device_native_notify_touch_down;
   virtual_input_device_class->notify_touch_motion = meta_virtual_input_device_native_notify_touch_motion;
   virtual_input_device_class->notify_touch_up = meta_virtual_input_device_native_notify_touch_up;
+  virtual_input_device_class->notify_events = meta_virtual_input_device_native_notify_events;
 
   obj_props[PROP_SEAT] = g_param_spec_pointer ("seat", NULL, NULL,
                                                G_PARAM_READWRITE |
@@ -79,7 +79,7 @@ meta_virtual_monitor_native_new (MetaBackend                  *backend,
   MetaCrtcModeVirtual *crtc_mode_virtual;
   MetaOutputVirtual *output_virtual;
 
-  crtc_virtual = meta_crtc_virtual_new (backend, id);
+  crtc_virtual = meta_crtc_virtual_new (backend, id, info->clock_mode);
   crtc_mode_virtual = meta_crtc_mode_virtual_new (mode_id++, &info->mode_info);
   output_virtual = meta_output_virtual_new (id, info,
                                             crtc_virtual,
@@ -89,6 +89,7 @@ meta_virtual_monitor_native_new (MetaBackend                  *backend,
                                          "crtc", crtc_virtual,
                                          "crtc-mode", crtc_mode_virtual,
                                          "output", output_virtual,
+                                         "clock-mode", info->clock_mode,
                                          NULL);
   virtual_monitor_native->id = id;
 
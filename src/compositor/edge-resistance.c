@@ -37,6 +37,21 @@ struct _MetaEdgeResistanceData
   GArray *right_edges;
   GArray *top_edges;
   GArray *bottom_edges;
+
+  /* The windows relevant for edges, bottom to top, their frame rects and the
+   * (unobscured) edges each of them contributes, so that the edges can be
+   * updated incrementally when some of them move during the drag.
+   */
+  MtkRectangle display_rect;
+  GPtrArray *windows;
+  MetaRectangleStack *window_stack;
+  GPtrArray *window_edges;
+
+  /* Set when windows were mapped, unmapped or restacked since */
+  gboolean windows_changed;
+  MetaDisplay *display;
+  gulong stack_changed_handler_id;
+  gulong visibility_updated_handler_id;
 };
 
 static GQuark edge_resistance_data_quark = 0;
@@ -639,68 +654,30 @@ apply_edge_resistance_to_each_side (MetaEdgeResistanceData  *edge_data,
 }
 
 static void
-meta_edge_resistance_data_free (MetaEdgeResistanceData *edge_data)
+free_edge_list (gpointer data)
 {
-  guint i,j;
-  GHashTable *edges_to_be_freed;
-
-  /* We first need to clean out any window edges */
-  edges_to_be_freed = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-                                             g_free, NULL);
-  for (i = 0; i < 4; i++)
-    {
-      GArray *tmp = NULL;
-      MetaSide side;
-      switch (i)
-        {
-        case 0:
-          tmp = edge_data->left_edges;
-          side = META_SIDE_LEFT;
-          break;
-        case 1:
-          tmp = edge_data->right_edges;
-          side = META_SIDE_RIGHT;
-          break;
-        case 2:
-          tmp = edge_data->top_edges;
-          side = META_SIDE_TOP;
-          break;
-        case 3:
-          tmp = edge_data->bottom_edges;
-          side = META_SIDE_BOTTOM;
-          break;
-        default:
-          g_assert_not_reached ();
-        }
+  g_list_free_full (data, g_free);
+}
 
-      for (j = 0; j < tmp->len; j++)
-        {
-          MetaEdge *edge = g_array_index (tmp, MetaEdge*, j);
-          if (edge->edge_type == META_EDGE_WINDOW &&
-              edge->side_type == side)
-            {
-              /* The same edge will appear in two arrays, and we can't free
-               * it yet we still need to compare edge->side_type for the other
-               * array that it is in.  So store it in a hash table for later
-               * freeing.  Could also do this in a simple linked list.
-               */
-              g_hash_table_insert (edges_to_be_freed, edge, edge);
-            }
-        }
-    }
+static void
+meta_edge_resistance_data_free (MetaEdgeResistanceData *edge_data)
+{
+  /* The arrays only reference the edges; window edges are owned by
+   * window_edges, monitor and screen edges by the workspace.
+   */
+  g_clear_pointer (&edge_data->left_edges, g_array_unref);
+  g_clear_pointer (&edge_data->right_edges, g_array_unref);
+  g_clear_pointer (&edge_data->top_edges, g_array_unref);
+  g_clear_pointer (&edge_data->bottom_edges, g_array_unref);
 
-  /* Now free all the window edges (the key destroy function is g_free) */
-  g_hash_table_destroy (edges_to_be_freed);
+  g_clear_pointer (&edge_data->window_edges, g_ptr_array_unref);
+  g_clear_pointer (&edge_data->window_stack, meta_rectangle_stack_free);
+  g_clear_pointer (&edge_data->windows, g_ptr_array_unref);
 
-  /* Now free the arrays and data */
-  g_array_free (edge_data->left_edges, TRUE);
-  g_array_free (edge_data->right_edges, TRUE);
-  g_array_free (edge_data->top_edges, TRUE);
-  g_array_free (edge_data->bottom_edges, TRUE);
-  edge_data->left_edges = NULL;
-  edge_data->right_edges = NULL;
-  edge_data->top_edges = NULL;
-  edge_data->bottom_edges = NULL;
+  g_clear_signal_handler (&edge_data->stack_changed_handler_id,
+                          edge_data->display->stack);
+  g_clear_signal_handler (&edge_data->visibility_updated_handler_id,
+                          edge_data->display);
 
   g_free (edge_data);
 }
@@ -723,13 +700,12 @@ stupid_sort_requiring_extra_pointer_dereference (gconstpointer a,
   return meta_rectangle_edge_cmp_ignore_type (*a_edge, *b_edge);
 }
 
-static MetaEdgeResistanceData *
-cache_edges (MetaDisplay *display,
-             GList *window_edges,
-             GList *monitor_edges,
-             GList *screen_edges)
+static void
+cache_edges (MetaEdgeResistanceData *edge_data,
+             GList                  *window_edges,
+             GList                  *monitor_edges,
+             GList                  *screen_edges)
 {
-  MetaEdgeResistanceData *edge_data;
   GList *tmp;
   int num_left, num_right, num_top, num_bottom;
   int i;
@@ -806,25 +782,34 @@ cache_edges (MetaDisplay *display,
     }
 
   /*
-   * 2nd: Allocate the edges
+   * 2nd: Allocate the edges, or reuse the arrays when updating
    */
-  edge_data = g_new0 (MetaEdgeResistanceData, 1);
-  edge_data->left_edges   = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(MetaEdge*),
-                                               num_left + num_right);
-  edge_data->right_edges  = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(MetaEdge*),
-                                               num_left + num_right);
-  edge_data->top_edges    = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(MetaEdge*),
-                                               num_top + num_bottom);
-  edge_data->bottom_edges = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(MetaEdge*),
-                                               num_top + num_bottom);
+  if (!edge_data->left_edges)
+    {
+      edge_data->left_edges   = g_array_sized_new (FALSE,
+                                                   FALSE,
+                                                   sizeof(MetaEdge*),
+                                                   num_left + num_right);
+      edge_data->right_edges  = g_array_sized_new (FALSE,
+                                                   FALSE,
+                                                   sizeof(MetaEdge*),
+                                                   num_left + num_right);
+      edge_data->top_edges    = g_array_sized_new (FALSE,
+                                                   FALSE,
+                                                   sizeof(MetaEdge*),
+                                                   num_top + num_bottom);
+      edge_data->bottom_edges = g_array_sized_new (FALSE,
+                                                   FALSE,
+                                                   sizeof(MetaEdge*),
+                                                   num_top + num_bottom);
+    }
+  else
+    {
+      g_array_set_size (edge_data->left_edges, 0);
+      g_array_set_size (edge_data->right_edges, 0);
+      g_array_set_size (edge_data->top_edges, 0);
+      g_array_set_size (edge_data->bottom_edges, 0);
+    }
 
   /*
    * 3rd: Add the edges to the arrays
@@ -883,8 +868,80 @@ cache_edges (MetaDisplay *display,
                 stupid_sort_requiring_extra_pointer_dereference);
   g_array_sort (edge_data->bottom_edges,
                 stupid_sort_requiring_extra_pointer_dereference);
+}
 
-  return edge_data;
+static void
+update_window_edges (MetaEdgeResistanceData *edge_data,
+                     int                     index)
+{
+  MetaWindow *cur_window = g_ptr_array_index (edge_data->windows, index);
+  GList *edges = NULL;
+
+  /* Dock edges are considered screen edges which are handled separately,
+   * but docks still obscure the edges of the windows below them.
+   */
+  if (cur_window->type != META_WINDOW_DOCK)
+    {
+      edges = meta_rectangle_stack_add_window_edges (edge_data->window_stack,
+                                                     index,
+                                                     &edge_data->display_rect,
+                                                     NULL);
+    }
+
+  free_edge_list (g_ptr_array_index (edge_data->window_edges, index));
+  g_ptr_array_index (edge_data->window_edges, index) = edges;
+}
+
+static void
+recache_edges (MetaEdgeResistanceData *edge_data,
+               MetaWorkspace          *workspace)
+{
+  g_autoptr (GList) edges = NULL;
+  guint i;
+
+  for (i = 0; i < edge_data->window_edges->len; i++)
+    {
+      GList *window_edges = g_ptr_array_index (edge_data->window_edges, i);
+
+      edges = g_list_concat (g_list_copy (window_edges), edges);
+    }
+
+  cache_edges (edge_data,
+               edges,
+               meta_workspace_get_monitor_edges (workspace),
+               meta_workspace_get_screen_edges (workspace));
+}
+
+static void
+on_stack_changed (MetaStack              *stack,
+                  MetaEdgeResistanceData *edge_data)
+{
+  edge_data->windows_changed = TRUE;
+}
+
+static void
+on_window_visibility_updated (MetaDisplay            *display,
+                              GList                  *unplaced,
+                              GList                  *should_show,
+                              GList                  *should_hide,
+                              MetaEdgeResistanceData *edge_data)
+{
+  GList *l;
+
+  for (l = should_show; l; l = l->next)
+    {
+      MetaWindow *window = l->data;
+
+      if (is_window_relevant_for_edges (window) &&
+          !g_ptr_array_find (edge_data->windows, window, NULL))
+        edge_data->windows_changed = TRUE;
+    }
+
+  for (l = should_hide; l; l = l->next)
+    {
+      if (g_ptr_array_find (edge_data->windows, l->data, NULL))
+        edge_data->windows_changed = TRUE;
+    }
 }
 
 static MetaEdgeResistanceData *
@@ -892,178 +949,142 @@ compute_resistance_and_snapping_edges (MetaWindowDrag *window_drag)
 {
   MetaEdgeResistanceData *edge_data;
   GList *l;
-  /* Lists of window positions (rects) and their relative stacking positions */
-  int stack_position;
-  g_autoslist (MtkRectangle) obscuring_windows = NULL;
   g_autoptr (GList) stacked_windows = NULL;
-  g_autoptr (GSList) window_stacking = NULL;
-  g_autoptr (GList) edges = NULL;
-  /* The portions of the above lists that still remain at the stacking position
-   * in the layer that we are working on
-   */
-  GSList *rem_windows, *rem_win_stacking;
   MetaWindow *window = meta_window_drag_get_window (window_drag);
   MetaDisplay *display = window->display;
   MetaWorkspaceManager *workspace_manager = display->workspace_manager;
+  guint i;
 
   meta_topic (META_DEBUG_WINDOW_OPS,
               "Computing edges to resist-movement or snap-to for %s.",
               meta_window_drag_get_window (window_drag)->desc);
 
+  edge_data = g_new0 (MetaEdgeResistanceData, 1);
+  meta_display_get_size (display,
+                         &edge_data->display_rect.width,
+                         &edge_data->display_rect.height);
+  edge_data->windows = g_ptr_array_new_with_free_func (g_object_unref);
+  edge_data->window_stack = meta_rectangle_stack_new ();
+  edge_data->window_edges = g_ptr_array_new_with_free_func (free_edge_list);
+
+  edge_data->display = display;
+  edge_data->stack_changed_handler_id =
+    g_signal_connect (display->stack, "changed",
+                      G_CALLBACK (on_stack_changed), edge_data);
+  edge_data->visibility_updated_handler_id =
+    g_signal_connect (display, "window-visibility-updated",
+                      G_CALLBACK (on_window_visibility_updated), edge_data);
+
   /*
-   * 1st: Get the list of relevant windows, from bottom to top
+   * 1st: Get the list of relevant windows, from bottom to top, and index
+   * their frame rects so we can quickly find which windows obscure the
+   * edges of the ones below them.
    */
   stacked_windows =
     meta_stack_list_windows (display->stack,
                              workspace_manager->active_workspace);
 
-  /*
-   * 2nd: we need to separate that stacked list into a list of windows that
-   * can obscure other edges.  To make sure we only have windows obscuring
-   * those below it instead of going both ways, we also need to keep a
-   * counter list.  Messy, I know.
-   */
-  stack_position = 0;
   for (l = stacked_windows; l; l = l->next)
     {
       MetaWindow *cur_window = l->data;
+      MtkRectangle cur_rect;
 
-      if (is_window_relevant_for_edges (cur_window))
-        {
-          MtkRectangle *new_rect;
+      if (!is_window_relevant_for_edges (cur_window))
+        continue;
 
-          new_rect = mtk_rectangle_new_empty ();
-          meta_window_get_frame_rect (cur_window, new_rect);
-          obscuring_windows = g_slist_prepend (obscuring_windows, new_rect);
-          window_stacking =
-            g_slist_prepend (window_stacking, GINT_TO_POINTER (stack_position));
-        }
-
-      stack_position++;
+      meta_window_get_frame_rect (cur_window, &cur_rect);
+      meta_rectangle_stack_push (edge_data->window_stack, &cur_rect);
+      g_ptr_array_add (edge_data->windows, g_object_ref (cur_window));
+      g_ptr_array_add (edge_data->window_edges, NULL);
     }
-  /* Put 'em in bottom to top order */
-  rem_windows = obscuring_windows = g_slist_reverse (obscuring_windows);
-  rem_win_stacking = window_stacking = g_slist_reverse (window_stacking);
 
   /*
-   * 3rd: loop over the windows again, this time getting the edges from
-   * them and removing intersections with the relevant obscuring_windows &
-   * obscuring_docks.
+   * 2nd: Get the edges of each window, without the parts that are offscreen
+   * or covered by other windows or docks higher up in the stack.
    */
-  edges = NULL;
-  stack_position = 0;
-  for (l = stacked_windows; l; l = l->next)
-    {
-      MetaWindow *cur_window = l->data;
-      MtkRectangle  cur_rect;
-      meta_window_get_frame_rect (cur_window, &cur_rect);
+  for (i = 0; i < edge_data->windows->len; i++)
+    update_window_edges (edge_data, i);
 
-      /* Check if we want to use this window's edges for edge
-       * resistance (note that dock edges are considered screen edges
-       * which are handled separately
-       */
-      if (is_window_relevant_for_edges (cur_window) &&
-          cur_window->type != META_WINDOW_DOCK)
-        {
-          GList *new_edges;
-          MetaEdge *new_edge;
-          MtkRectangle display_rect = { 0 };
-          MtkRectangle reduced;
+  /*
+   * 3rd: Cache the combination of these edges with the onscreen and
+   * monitor edges in sorted arrays for quick access.
+   */
+  recache_edges (edge_data, workspace_manager->active_workspace);
 
-          meta_display_get_size (display,
-                                 &display_rect.width, &display_rect.height);
+  return edge_data;
+}
 
-          /* We don't care about snapping to any portion of the window that
-           * is offscreen (we also don't care about parts of edges covered
-           * by other windows or DOCKS, but that's handled below).
-           */
-          mtk_rectangle_intersect (&cur_rect,
-                                   &display_rect,
-                                   &reduced);
+static gboolean
+rectangles_touch (const MtkRectangle *rect1,
+                  const MtkRectangle *rect2)
+{
+  return BOX_LEFT (*rect1) <= BOX_RIGHT (*rect2) &&
+         BOX_LEFT (*rect2) <= BOX_RIGHT (*rect1) &&
+         BOX_TOP (*rect1) <= BOX_BOTTOM (*rect2) &&
+         BOX_TOP (*rect2) <= BOX_BOTTOM (*rect1);
+}
 
-          new_edges = NULL;
+/* Updates the cached edges for windows that moved or resized since the
+ * edges were computed.  Only the edges of the moved windows and of the
+ * windows below them that they touch (before or after moving) need to be
+ * recomputed.  Returns FALSE if windows were mapped, unmapped or restacked,
+ * in which case the edges need to be computed from scratch.
+ */
+static gboolean
+maybe_update_edge_resistance_data (MetaEdgeResistanceData *edge_data,
+                                   MetaWindowDrag         *window_drag)
+{
+  MetaWindow *window = meta_window_drag_get_window (window_drag);
+  MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
+  g_autoptr (GArray) damaged = NULL;
+  guint i, j;
 
-          /* Left side of this window is resistance for the right edge of
-           * the window being moved.
-           */
-          new_edge = g_new (MetaEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.width = 0;
-          new_edge->side_type = META_SIDE_RIGHT;
-          new_edge->edge_type = META_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Right side of this window is resistance for the left edge of
-           * the window being moved.
-           */
-          new_edge = g_new (MetaEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.x += new_edge->rect.width;
-          new_edge->rect.width = 0;
-          new_edge->side_type = META_SIDE_LEFT;
-          new_edge->edge_type = META_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Top side of this window is resistance for the bottom edge of
-           * the window being moved.
-           */
-          new_edge = g_new (MetaEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.height = 0;
-          new_edge->side_type = META_SIDE_BOTTOM;
-          new_edge->edge_type = META_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Top side of this window is resistance for the bottom edge of
-           * the window being moved.
-           */
-          new_edge = g_new (MetaEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.y += new_edge->rect.height;
-          new_edge->rect.height = 0;
-          new_edge->side_type = META_SIDE_TOP;
-          new_edge->edge_type = META_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Update the remaining windows to only those at a higher
-           * stacking position than this one.
-           */
-          while (rem_win_stacking &&
-                 stack_position >= GPOINTER_TO_INT (rem_win_stacking->data))
-            {
-              rem_windows      = rem_windows->next;
-              rem_win_stacking = rem_win_stacking->next;
-            }
+  if (edge_data->windows_changed)
+    return FALSE;
+
+  for (i = 0; i < edge_data->windows->len; i++)
+    {
+      MetaWindow *cur_window = g_ptr_array_index (edge_data->windows, i);
+      const MtkRectangle *old_rect;
+      MtkRectangle new_rect;
 
-          /* Remove edge portions overlapped by rem_windows and rem_docks */
-          new_edges =
-            meta_rectangle_remove_intersections_with_boxes_from_edges (
-              new_edges,
-              rem_windows);
+      old_rect = meta_rectangle_stack_get_rect (edge_data->window_stack, i);
+      meta_window_get_frame_rect (cur_window, &new_rect);
+      if (mtk_rectangle_equal (old_rect, &new_rect))
+        continue;
 
-          /* Save the new edges */
-          edges = g_list_concat (new_edges, edges);
-        }
+      if (!damaged)
+        damaged = g_array_new (FALSE, FALSE, sizeof (MtkRectangle));
 
-      stack_position++;
+      g_array_append_val (damaged, *old_rect);
+      g_array_append_val (damaged, new_rect);
+      meta_rectangle_stack_set_rect (edge_data->window_stack, i, &new_rect);
     }
 
-  /* Sort the list.  FIXME: Should I bother with this sorting?  I just
-   * sort again later in cache_edges() anyway...
-   */
-  edges = g_list_sort (edges, meta_rectangle_edge_cmp);
+  if (!damaged)
+    return TRUE;
 
-  /*
-   * 5th: Cache the combination of these edges with the onscreen and
-   * monitor edges in an array for quick access.  Free the edges since
-   * they've been cached elsewhere.
-   */
-  edge_data = cache_edges (display,
-                           edges,
-                           workspace_manager->active_workspace->monitor_edges,
-                           workspace_manager->active_workspace->screen_edges);
+  meta_topic (META_DEBUG_EDGE_RESISTANCE,
+              "Updating edges for %u moved windows", damaged->len / 2);
 
-  return edge_data;
+  for (i = 0; i < edge_data->windows->len; i++)
+    {
+      const MtkRectangle *rect =
+        meta_rectangle_stack_get_rect (edge_data->window_stack, i);
+
+      for (j = 0; j < damaged->len; j++)
+        {
+          if (rectangles_touch (rect, &g_array_index (damaged, MtkRectangle, j)))
+            {
+              update_window_edges (edge_data, i);
+              break;
+            }
+        }
+    }
+
+  recache_edges (edge_data, workspace_manager->active_workspace);
+
+  return TRUE;
 }
 
 static MetaEdgeResistanceData *
@@ -1080,6 +1101,10 @@ meta_window_drag_ensure_edge_resistance_data (MetaWindowDrag *window_drag)
   edge_data = g_object_get_qdata (G_OBJECT (window_drag),
                                   edge_resistance_data_quark);
 
+  if (edge_data &&
+      !maybe_update_edge_resistance_data (edge_data, window_drag))
+    edge_data = NULL;
+
   if (!edge_data)
     {
       edge_data = compute_resistance_and_snapping_edges (window_drag);
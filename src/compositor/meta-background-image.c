@@ -20,8 +20,12 @@
 
 #include "meta/meta-background-image.h"
 
+#include <errno.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <math.h>
+#include <sys/stat.h>
 
 #ifdef HAVE_MALLOC_TRIM
 #include <malloc.h>
@@ -29,6 +33,21 @@
 
 #include "clutter/clutter.h"
 #include "compositor/cogl-utils.h"
+#include "compositor/meta-background-private.h"
+#include "core/util-private.h"
+
+/* Images decoded below their original size are kept on disk, so that the
+ * next session can skip decoding the original. The cached copy carries the
+ * modification time and size of the original in a text chunk and is only
+ * used as long as those still match.
+ */
+#define DISK_CACHE_SOURCE_KEY "tEXt::mutter-source"
+
+/* Once the cached copies take up more than this, the least recently used
+ * ones are removed */
+#define DISK_CACHE_MAX_SIZE (128 * 1024 * 1024)
+
+#define LOAD_BUFFER_SIZE (64 * 1024)
 
 enum
 {
@@ -51,8 +70,16 @@ struct _MetaBackgroundImageCache
   GObject parent_instance;
 
   GHashTable *images;
+  goffset disk_cache_max_size;
 };
 
+typedef struct _MetaBackgroundImageKey
+{
+  GFile *file;
+  int max_width;
+  int max_height;
+} MetaBackgroundImageKey;
+
 /**
  * MetaBackgroundImage:
  *
@@ -61,19 +88,56 @@ struct _MetaBackgroundImageCache
 struct _MetaBackgroundImage
 {
   GObject parent_instance;
-  GFile *file;
+  MetaBackgroundImageKey key;
   MetaBackgroundImageCache *cache;
   gboolean in_cache;
   gboolean loaded;
   CoglTexture *texture;
 };
 
+typedef struct _LoadData
+{
+  GFile *file;
+  int max_width;
+  int max_height;
+  gboolean transposed;
+
+  int source_width;
+  int source_height;
+  gboolean from_disk_cache;
+  size_t peak_size;
+  int64_t start_time_us;
+  goffset disk_cache_max_size;
+} LoadData;
+
 G_DEFINE_TYPE (MetaBackgroundImageCache, meta_background_image_cache, G_TYPE_OBJECT);
 
+static guint
+image_key_hash (gconstpointer data)
+{
+  const MetaBackgroundImageKey *key = data;
+
+  return (g_file_hash (key->file) ^
+          (guint) (key->max_width * 31 + key->max_height));
+}
+
+static gboolean
+image_key_equal (gconstpointer data1,
+                 gconstpointer data2)
+{
+  const MetaBackgroundImageKey *key1 = data1;
+  const MetaBackgroundImageKey *key2 = data2;
+
+  return (key1->max_width == key2->max_width &&
+          key1->max_height == key2->max_height &&
+          g_file_equal (key1->file, key2->file));
+}
+
 static void
 meta_background_image_cache_init (MetaBackgroundImageCache *cache)
 {
-  cache->images = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  cache->images = g_hash_table_new (image_key_hash, image_key_equal);
+  cache->disk_cache_max_size = DISK_CACHE_MAX_SIZE;
 }
 
 static void
@@ -119,25 +183,383 @@ meta_background_image_cache_get_default (void)
   return cache;
 }
 
+static char *
+get_source_stamp (GFile         *file,
+                  GCancellable  *cancellable,
+                  GError       **error)
+{
+  g_autoptr (GFileInfo) info = NULL;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            cancellable,
+                            error);
+  if (!info)
+    return NULL;
+
+  return g_strdup_printf ("%" G_GUINT64_FORMAT ".%06u:%" G_GOFFSET_FORMAT,
+                          g_file_info_get_attribute_uint64 (info,
+                                                            G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                          g_file_info_get_attribute_uint32 (info,
+                                                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+                          g_file_info_get_size (info));
+}
+
+static char *
+get_disk_cache_path (LoadData *data)
+{
+  g_autofree char *uri = NULL;
+  g_autofree char *checksum = NULL;
+  g_autofree char *basename = NULL;
+
+  uri = g_file_get_uri (data->file);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, uri, -1);
+  basename = g_strdup_printf ("%s-%dx%d.png",
+                              checksum, data->max_width, data->max_height);
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           "mutter", "backgrounds", basename,
+                           NULL);
+}
+
+static GdkPixbuf *
+load_from_disk_cache (const char *cache_path,
+                      const char *source_stamp)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+
+  if (!g_file_test (cache_path, G_FILE_TEST_EXISTS))
+    return NULL;
+
+  pixbuf = gdk_pixbuf_new_from_file (cache_path, NULL);
+  if (!pixbuf)
+    return NULL;
+
+  if (g_strcmp0 (gdk_pixbuf_get_option (pixbuf, DISK_CACHE_SOURCE_KEY),
+                 source_stamp) != 0)
+    {
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Ignoring outdated cached background %s", cache_path);
+      return NULL;
+    }
+
+  /* The modification time tracks when the copy was last used, which is
+   * what eviction goes by */
+  g_utime (cache_path, NULL);
+
+  return g_steal_pointer (&pixbuf);
+}
+
+typedef struct _DiskCacheEntry
+{
+  char *path;
+  time_t mtime;
+  goffset size;
+} DiskCacheEntry;
+
+static void
+disk_cache_entry_free (DiskCacheEntry *entry)
+{
+  g_free (entry->path);
+  g_free (entry);
+}
+
+static int
+compare_disk_cache_entries (gconstpointer a,
+                            gconstpointer b)
+{
+  const DiskCacheEntry *entry_a = *(const DiskCacheEntry **) a;
+  const DiskCacheEntry *entry_b = *(const DiskCacheEntry **) b;
+
+  if (entry_a->mtime < entry_b->mtime)
+    return -1;
+  else if (entry_a->mtime > entry_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+prune_disk_cache (const char *cache_dir,
+                  const char *keep_path,
+                  goffset     max_size)
+{
+  g_autoptr (GDir) dir = NULL;
+  g_autoptr (GPtrArray) entries = NULL;
+  const char *name;
+  goffset total_size = 0;
+  unsigned int i;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  entries = g_ptr_array_new_with_free_func ((GDestroyNotify) disk_cache_entry_free);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      DiskCacheEntry *entry;
+      GStatBuf stat_buf;
+      g_autofree char *path = NULL;
+
+      if (!g_str_has_suffix (name, ".png"))
+        continue;
+
+      path = g_build_filename (cache_dir, name, NULL);
+      if (g_stat (path, &stat_buf) != 0 || !S_ISREG (stat_buf.st_mode))
+        continue;
+
+      total_size += stat_buf.st_size;
+
+      if (g_strcmp0 (path, keep_path) == 0)
+        continue;
+
+      entry = g_new0 (DiskCacheEntry, 1);
+      entry->path = g_steal_pointer (&path);
+      entry->mtime = stat_buf.st_mtime;
+      entry->size = stat_buf.st_size;
+      g_ptr_array_add (entries, entry);
+    }
+
+  g_ptr_array_sort (entries, compare_disk_cache_entries);
+
+  for (i = 0; i < entries->len && total_size > max_size; i++)
+    {
+      DiskCacheEntry *entry = g_ptr_array_index (entries, i);
+
+      if (g_unlink (entry->path) != 0)
+        continue;
+
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Evicted cached background %s", entry->path);
+      total_size -= entry->size;
+    }
+}
+
+static void
+save_to_disk_cache (GdkPixbuf  *pixbuf,
+                    const char *cache_path,
+                    const char *source_stamp,
+                    goffset     max_size)
+{
+  g_autofree char *cache_dir = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GFileOutputStream) stream = NULL;
+  g_autoptr (GCancellable) cancellable = NULL;
+  g_autoptr (GError) error = NULL;
+
+  cache_dir = g_path_get_dirname (cache_path);
+  if (g_mkdir_with_parents (cache_dir, 0700) != 0)
+    {
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Failed to create background cache directory %s: %s",
+                  cache_dir, g_strerror (errno));
+      return;
+    }
+
+  file = g_file_new_for_path (cache_path);
+  stream = g_file_replace (file, NULL, FALSE,
+                           G_FILE_CREATE_PRIVATE |
+                           G_FILE_CREATE_REPLACE_DESTINATION,
+                           NULL, &error);
+  if (!stream)
+    {
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Failed to write cached background %s: %s",
+                  cache_path, error->message);
+      return;
+    }
+
+  if (!gdk_pixbuf_save_to_stream (pixbuf, G_OUTPUT_STREAM (stream),
+                                  "png", NULL, &error,
+                                  DISK_CACHE_SOURCE_KEY, source_stamp,
+                                  NULL))
+    {
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Failed to write cached background %s: %s",
+                  cache_path, error->message);
+
+      /* Closing with a cancelled cancellable discards the partial file
+       * instead of moving it in place */
+      cancellable = g_cancellable_new ();
+      g_cancellable_cancel (cancellable);
+      g_output_stream_close (G_OUTPUT_STREAM (stream), cancellable, NULL);
+      return;
+    }
+
+  if (!g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, &error))
+    {
+      meta_topic (META_DEBUG_BACKGROUND,
+                  "Failed to write cached background %s: %s",
+                  cache_path, error->message);
+      return;
+    }
+
+  prune_disk_cache (cache_dir, cache_path, max_size);
+}
+
+static void
+on_size_prepared (GdkPixbufLoader *loader,
+                  int              width,
+                  int              height,
+                  LoadData        *data)
+{
+  int max_width, max_height;
+  double scale;
+
+  data->source_width = width;
+  data->source_height = height;
+
+  if (data->max_width == 0 || data->max_height == 0)
+    return;
+
+  /* The maximum size is in monitor orientation, the loader reports the size
+   * the image is stored in */
+  if (data->transposed)
+    {
+      max_width = data->max_height;
+      max_height = data->max_width;
+    }
+  else
+    {
+      max_width = data->max_width;
+      max_height = data->max_height;
+    }
+
+  /* Keep the aspect ratio while still covering the maximum size in both
+   * directions, and never scale up */
+  scale = MAX ((double) max_width / width, (double) max_height / height);
+  if (scale >= 1.0)
+    return;
+
+  gdk_pixbuf_loader_set_size (loader,
+                              MAX (1, (int) ceil (width * scale)),
+                              MAX (1, (int) ceil (height * scale)));
+}
+
+static GdkPixbuf *
+decode_file (LoadData      *data,
+             GCancellable  *cancellable,
+             GError       **error)
+{
+  g_autoptr (GFileInputStream) stream = NULL;
+  g_autoptr (GdkPixbufLoader) loader = NULL;
+  g_autofree guchar *buffer = NULL;
+  GdkPixbuf *pixbuf;
+
+  stream = g_file_read (data->file, cancellable, error);
+  if (!stream)
+    return NULL;
+
+  /* Letting the loader know the size up front allows e.g. JPEG images to be
+   * scaled while decoding, without ever holding the full size image */
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (on_size_prepared), data);
+
+  buffer = g_malloc (LOAD_BUFFER_SIZE);
+  while (TRUE)
+    {
+      gssize n_read;
+
+      n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+                                    buffer, LOAD_BUFFER_SIZE,
+                                    cancellable, error);
+      if (n_read < 0)
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          return NULL;
+        }
+
+      if (n_read == 0)
+        break;
+
+      if (!gdk_pixbuf_loader_write (loader, buffer, n_read, error))
+        return NULL;
+    }
+
+  if (!gdk_pixbuf_loader_close (loader, error))
+    return NULL;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (!pixbuf)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+                   "Image loader didn't produce an image");
+      return NULL;
+    }
+
+  return g_object_ref (pixbuf);
+}
+
+static gboolean
+has_transposing_orientation (GdkPixbuf *pixbuf)
+{
+  const char *orientation;
+  int64_t value;
+
+  orientation = gdk_pixbuf_get_option (pixbuf, "orientation");
+  if (!orientation)
+    return FALSE;
+
+  /* Exif orientations 5 to 8 swap width and height */
+  value = g_ascii_strtoll (orientation, NULL, 10);
+  return value >= 5 && value <= 8;
+}
+
 static void
 load_file (GTask               *task,
            MetaBackgroundImage *image,
-           gpointer             task_data,
+           LoadData            *data,
            GCancellable        *cancellable)
 {
   GError *error = NULL;
-  GdkPixbuf *pixbuf;
-  GFileInputStream *stream;
+  g_autofree char *source_stamp = NULL;
+  g_autofree char *cache_path = NULL;
+  GdkPixbuf *pixbuf, *rotated;
+  gboolean scaled;
 
-  stream = g_file_read (image->file, NULL, &error);
-  if (stream == NULL)
+  if (data->max_width > 0 && data->max_height > 0)
     {
-      g_task_return_error (task, error);
-      return;
+      source_stamp = get_source_stamp (data->file, cancellable, &error);
+      if (source_stamp)
+        {
+          cache_path = get_disk_cache_path (data);
+          pixbuf = load_from_disk_cache (cache_path, source_stamp);
+          if (pixbuf)
+            {
+              data->from_disk_cache = TRUE;
+              data->peak_size = gdk_pixbuf_get_byte_length (pixbuf);
+              g_task_return_pointer (task, pixbuf,
+                                     (GDestroyNotify) g_object_unref);
+              return;
+            }
+        }
+      else
+        {
+          /* Without a way to tell whether a cached copy is still current,
+           * decode the original and leave the disk cache alone */
+          meta_topic (META_DEBUG_BACKGROUND,
+                      "Not using background disk cache: %s", error->message);
+          g_clear_error (&error);
+        }
     }
 
-  pixbuf = gdk_pixbuf_new_from_stream (G_INPUT_STREAM (stream), NULL, &error);
-  g_object_unref (stream);
+  pixbuf = decode_file (data, cancellable, &error);
+
+  if (pixbuf &&
+      gdk_pixbuf_get_width (pixbuf) < data->source_width &&
+      has_transposing_orientation (pixbuf))
+    {
+      /* The size was picked assuming the image is shown the way it is
+       * stored, decode it again now that the orientation is known */
+      g_object_unref (pixbuf);
+      data->transposed = TRUE;
+      pixbuf = decode_file (data, cancellable, &error);
+    }
 
 #ifdef HAVE_MALLOC_TRIM
   malloc_trim (0);
@@ -149,7 +571,26 @@ load_file (GTask               *task,
       return;
     }
 
-  g_task_return_pointer (task, pixbuf, (GDestroyNotify) g_object_unref);
+  scaled = gdk_pixbuf_get_width (pixbuf) < data->source_width;
+  data->peak_size = gdk_pixbuf_get_byte_length (pixbuf);
+
+  rotated = gdk_pixbuf_apply_embedded_orientation (pixbuf);
+  if (rotated != NULL)
+    {
+      data->peak_size += gdk_pixbuf_get_byte_length (rotated);
+      g_object_unref (pixbuf);
+      pixbuf = rotated;
+    }
+
+  g_task_return_pointer (task, g_object_ref (pixbuf),
+                         (GDestroyNotify) g_object_unref);
+
+  /* Writing the cache doesn't hold back showing the background */
+  if (cache_path && scaled)
+    save_to_disk_cache (pixbuf, cache_path, source_stamp,
+                        data->disk_cache_max_size);
+
+  g_object_unref (pixbuf);
 }
 
 static void
@@ -161,31 +602,26 @@ file_loaded (GObject      *source_object,
   g_autoptr (GError) error = NULL;
   g_autoptr (GError) local_error = NULL;
   GTask *task;
+  LoadData *data;
   CoglTexture *texture;
-  GdkPixbuf *pixbuf, *rotated;
+  GdkPixbuf *pixbuf;
   int width, height, row_stride;
   guchar *pixels;
   gboolean has_alpha;
 
   task = G_TASK (result);
+  data = g_task_get_task_data (task);
   pixbuf = g_task_propagate_pointer (task, &error);
 
   if (pixbuf == NULL)
     {
-      char *uri = g_file_get_uri (image->file);
+      char *uri = g_file_get_uri (image->key.file);
       g_warning ("Failed to load background '%s': %s",
                  uri, error->message);
       g_free (uri);
       goto out;
     }
 
-  rotated = gdk_pixbuf_apply_embedded_orientation (pixbuf);
-  if (rotated != NULL)
-    {
-      g_object_unref (pixbuf);
-      pixbuf = rotated;
-    }
-
   width = gdk_pixbuf_get_width (pixbuf);
   height = gdk_pixbuf_get_height (pixbuf);
   row_stride = gdk_pixbuf_get_rowstride (pixbuf);
@@ -209,6 +645,32 @@ file_loaded (GObject      *source_object,
 
   image->texture = texture;
 
+  if (meta_is_topic_enabled (META_DEBUG_BACKGROUND))
+    {
+      g_autofree char *uri = g_file_get_uri (image->key.file);
+      int64_t load_time_us = g_get_monotonic_time () - data->start_time_us;
+
+      if (data->from_disk_cache)
+        {
+          meta_topic (META_DEBUG_BACKGROUND,
+                      "Loaded background %s at %dx%d from disk cache "
+                      "in %.1f ms, peak pixbuf memory %zu KiB",
+                      uri, width, height,
+                      load_time_us / 1000.0,
+                      data->peak_size / 1024);
+        }
+      else
+        {
+          meta_topic (META_DEBUG_BACKGROUND,
+                      "Loaded %dx%d background %s at %dx%d "
+                      "in %.1f ms, peak pixbuf memory %zu KiB",
+                      data->source_width, data->source_height,
+                      uri, width, height,
+                      load_time_us / 1000.0,
+                      data->peak_size / 1024);
+        }
+    }
+
 out:
   if (pixbuf != NULL)
     g_object_unref (pixbuf);
@@ -237,23 +699,71 @@ MetaBackgroundImage *
 meta_background_image_cache_load (MetaBackgroundImageCache *cache,
                                   GFile                    *file)
 {
+  return meta_background_image_cache_load_scaled (cache, file, 0, 0);
+}
+
+/**
+ * meta_background_image_cache_load_scaled:
+ * @cache: a #MetaBackgroundImageCache
+ * @file: #GFile to load
+ * @max_width: the width the image needs to cover, or 0
+ * @max_height: the height the image needs to cover, or 0
+ *
+ * Like meta_background_image_cache_load(), but an image larger than needed
+ * to cover @max_width by @max_height pixels is scaled down while loading,
+ * keeping its aspect ratio. The scaled down image is also kept in the user
+ * cache directory, to speed up loading it the next time.
+ *
+ * Passing 0 for either size loads the image at its original size.
+ *
+ * Return value: (transfer full): a #MetaBackgroundImage to dereference to get the loaded texture
+ */
+MetaBackgroundImage *
+meta_background_image_cache_load_scaled (MetaBackgroundImageCache *cache,
+                                         GFile                    *file,
+                                         int                       max_width,
+                                         int                       max_height)
+{
+  MetaBackgroundImageKey key;
   MetaBackgroundImage *image;
+  LoadData *data;
   GTask *task;
 
   g_return_val_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache), NULL);
   g_return_val_if_fail (file != NULL, NULL);
 
-  image = g_hash_table_lookup (cache->images, file);
+  if (max_width <= 0 || max_height <= 0)
+    {
+      max_width = 0;
+      max_height = 0;
+    }
+
+  key = (MetaBackgroundImageKey) {
+    .file = file,
+    .max_width = max_width,
+    .max_height = max_height,
+  };
+
+  image = g_hash_table_lookup (cache->images, &key);
   if (image != NULL)
     return g_object_ref (image);
 
   image = g_object_new (META_TYPE_BACKGROUND_IMAGE, NULL);
   image->cache = cache;
   image->in_cache = TRUE;
-  image->file = g_object_ref (file);
-  g_hash_table_insert (cache->images, image->file, image);
+  image->key = key;
+  image->key.file = g_object_ref (file);
+  g_hash_table_insert (cache->images, &image->key, image);
+
+  data = g_new0 (LoadData, 1);
+  data->file = image->key.file;
+  data->max_width = max_width;
+  data->max_height = max_height;
+  data->start_time_us = g_get_monotonic_time ();
+  data->disk_cache_max_size = cache->disk_cache_max_size;
 
   task = g_task_new (image, NULL, file_loaded, NULL);
+  g_task_set_task_data (task, data, g_free);
 
   g_task_run_in_thread (task, (GTaskThreadFunc) load_file);
   g_object_unref (task);
@@ -266,24 +776,39 @@ meta_background_image_cache_load (MetaBackgroundImageCache *cache,
  * @cache: a #MetaBackgroundImageCache
  * @file: file to remove from the cache
  *
- * Remove an entry from the cache; this would be used if monitoring
- * showed that the file changed.
+ * Remove the entries of a file from the cache, at any size; this would
+ * be used if monitoring showed that the file changed.
  */
 void
 meta_background_image_cache_purge (MetaBackgroundImageCache *cache,
                                    GFile                    *file)
 {
-  MetaBackgroundImage *image;
+  GHashTableIter iter;
+  gpointer value;
 
   g_return_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache));
   g_return_if_fail (file != NULL);
 
-  image = g_hash_table_lookup (cache->images, file);
-  if (image == NULL)
-    return;
+  g_hash_table_iter_init (&iter, cache->images);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      MetaBackgroundImage *image = value;
+
+      if (!g_file_equal (image->key.file, file))
+        continue;
+
+      g_hash_table_iter_remove (&iter);
+      image->in_cache = FALSE;
+    }
+}
+
+void
+meta_background_image_cache_set_disk_cache_max_size (MetaBackgroundImageCache *cache,
+                                                     goffset                   max_size)
+{
+  g_return_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache));
 
-  g_hash_table_remove (cache->images, image->file);
-  image->in_cache = FALSE;
+  cache->disk_cache_max_size = max_size;
 }
 
 G_DEFINE_TYPE (MetaBackgroundImage, meta_background_image, G_TYPE_OBJECT);
@@ -299,12 +824,12 @@ meta_background_image_finalize (GObject *object)
   MetaBackgroundImage *image = META_BACKGROUND_IMAGE (object);
 
   if (image->in_cache)
-    g_hash_table_remove (image->cache->images, image->file);
+    g_hash_table_remove (image->cache->images, &image->key);
 
   if (image->texture)
     g_object_unref (image->texture);
-  if (image->file)
-    g_object_unref (image->file);
+  if (image->key.file)
+    g_object_unref (image->key.file);
 
   G_OBJECT_CLASS (meta_background_image_parent_class)->finalize (object);
 }
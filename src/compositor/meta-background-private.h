@@ -3,9 +3,15 @@
 #pragma once
 
 #include "cogl/cogl.h"
+#include "core/util-private.h"
 #include "meta/meta-background.h"
+#include "meta/meta-background-image.h"
 
 CoglTexture * meta_background_get_texture (MetaBackground         *self,
                                            int                     monitor_index,
                                            MtkRectangle           *texture_area,
                                            CoglPipelineWrapMode   *wrap_mode);
+
+META_EXPORT_TEST
+void meta_background_image_cache_set_disk_cache_max_size (MetaBackgroundImageCache *cache,
+                                                          goffset                   max_size);
@@ -21,6 +21,7 @@
 
 #include "compositor/meta-background-private.h"
 
+#include <math.h>
 #include <string.h>
 
 #include "backends/meta-backend-private.h"
@@ -66,6 +67,9 @@ struct _MetaBackground
   GFile *file2;
   MetaBackgroundImage *background_image2;
 
+  int image_max_width;
+  int image_max_height;
+
   CoglTexture *color_texture;
   CoglTexture *wallpaper_texture;
 
@@ -133,10 +137,116 @@ invalidate_monitor_backgrounds (MetaBackground *self)
     }
 }
 
+static void
+get_image_max_size (MetaBackground *self,
+                    int            *max_width,
+                    int            *max_height)
+{
+  MetaContext *context;
+  MetaBackend *backend;
+  gboolean stage_views_scaled;
+  int n_monitors;
+  int i;
+
+  *max_width = 0;
+  *max_height = 0;
+
+  if (!self->display)
+    return;
+
+  /* Only styles scaling the image to the monitor can do with a smaller
+   * image, the others show it at its original size */
+  switch (self->style)
+    {
+    case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+    case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
+    case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+    case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
+      break;
+    case G_DESKTOP_BACKGROUND_STYLE_NONE:
+    case G_DESKTOP_BACKGROUND_STYLE_WALLPAPER:
+    case G_DESKTOP_BACKGROUND_STYLE_CENTERED:
+    default:
+      return;
+    }
+
+  context = meta_display_get_context (self->display);
+  backend = meta_context_get_backend (context);
+  stage_views_scaled = meta_backend_is_stage_views_scaled (backend);
+
+  n_monitors = meta_display_get_n_monitors (self->display);
+  for (i = 0; i < n_monitors; i++)
+    {
+      MtkRectangle geometry;
+      float scale = 1.0f;
+      int width, height;
+
+      meta_display_get_monitor_geometry (self->display, i, &geometry);
+      if (stage_views_scaled)
+        scale = meta_display_get_monitor_scale (self->display, i);
+
+      if (self->style == G_DESKTOP_BACKGROUND_STYLE_SPANNED)
+        {
+          int screen_width, screen_height;
+
+          meta_display_get_size (self->display, &screen_width, &screen_height);
+          width = (int) ceilf (screen_width * scale);
+          height = (int) ceilf (screen_height * scale);
+        }
+      else
+        {
+          width = (int) ceilf (geometry.width * scale);
+          height = (int) ceilf (geometry.height * scale);
+        }
+
+      *max_width = MAX (*max_width, width);
+      *max_height = MAX (*max_height, height);
+    }
+}
+
+static gboolean
+image_max_size_covers (int width,
+                       int height,
+                       int max_width,
+                       int max_height)
+{
+  if (width == 0 || height == 0)
+    return TRUE;
+
+  if (max_width == 0 || max_height == 0)
+    return FALSE;
+
+  return width >= max_width && height >= max_height;
+}
+
+static void set_file (MetaBackground       *self,
+                      GFile               **filep,
+                      MetaBackgroundImage **imagep,
+                      GFile                *file,
+                      gboolean              force_reload);
+
+static void mark_changed (MetaBackground *self);
+
 static void
 on_monitors_changed (MetaBackground *self)
 {
+  int max_width, max_height;
+
   invalidate_monitor_backgrounds (self);
+
+  get_image_max_size (self, &max_width, &max_height);
+  if (!image_max_size_covers (self->image_max_width, self->image_max_height,
+                              max_width, max_height))
+    {
+      self->image_max_width = max_width;
+      self->image_max_height = max_height;
+
+      set_file (self, &self->file1, &self->background_image1,
+                self->file1, TRUE);
+      set_file (self, &self->file2, &self->background_image2,
+                self->file2, TRUE);
+      mark_changed (self);
+    }
 }
 
 static void
@@ -256,7 +366,9 @@ set_file (MetaBackground       *self,
         {
           MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
 
-          *imagep = meta_background_image_cache_load (cache, file);
+          *imagep = meta_background_image_cache_load_scaled (cache, file,
+                                                             self->image_max_width,
+                                                             self->image_max_height);
           g_signal_connect (*imagep, "loaded",
                             G_CALLBACK (on_background_loaded), self);
         }
@@ -1001,14 +1113,31 @@ meta_background_set_blend (MetaBackground          *self,
                            double                   blend_factor,
                            GDesktopBackgroundStyle  style)
 {
+  int max_width, max_height;
+  gboolean force_reload;
+
   g_return_if_fail (META_IS_BACKGROUND (self));
   g_return_if_fail (blend_factor >= 0.0 && blend_factor <= 1.0);
 
-  set_file (self, &self->file1, &self->background_image1, file1, FALSE);
-  set_file (self, &self->file2, &self->background_image2, file2, FALSE);
+  self->style = style;
+
+  /* Images already loaded large enough for the new style are kept */
+  get_image_max_size (self, &max_width, &max_height);
+  force_reload = !image_max_size_covers (self->image_max_width,
+                                         self->image_max_height,
+                                         max_width, max_height);
+  if (force_reload ||
+      !file_equal0 (self->file1, file1) ||
+      !file_equal0 (self->file2, file2))
+    {
+      self->image_max_width = max_width;
+      self->image_max_height = max_height;
+    }
+
+  set_file (self, &self->file1, &self->background_image1, file1, force_reload);
+  set_file (self, &self->file2, &self->background_image2, file2, force_reload);
 
   self->blend_factor = blend_factor;
-  self->style = style;
 
   free_wallpaper_texture (self);
   mark_changed (self);
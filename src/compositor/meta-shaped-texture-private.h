@@ -27,6 +27,9 @@
 #include "backends/meta-monitor-manager-private.h"
 #include "meta/meta-shaped-texture.h"
 
+typedef void (* MetaShapedTextureFlushFunc) (MetaShapedTexture *stex,
+                                             gpointer           user_data);
+
 MetaShapedTexture * meta_shaped_texture_new (void);
 void meta_shaped_texture_set_texture (MetaShapedTexture *stex,
                                       MetaMultiTexture  *multi_texture);
@@ -73,3 +76,9 @@ void meta_shaped_texture_set_opaque_region (MetaShapedTexture *stex,
 void meta_shaped_texture_ensure_size_valid (MetaShapedTexture *stex);
 
 gboolean meta_shaped_texture_should_get_via_offscreen (MetaShapedTexture *stex);
+
+void meta_shaped_texture_set_flush_func (MetaShapedTexture          *stex,
+                                         MetaShapedTextureFlushFunc  flush_func,
+                                         gpointer                    user_data);
+
+void meta_shaped_texture_flush (MetaShapedTexture *stex);
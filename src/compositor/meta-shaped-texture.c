@@ -107,6 +107,11 @@ struct _MetaShapedTexture
 
   int buffer_scale;
 
+  /* Uploads content the texture owner held back, e.g. damage of culled
+   * out surfaces */
+  MetaShapedTextureFlushFunc flush_func;
+  gpointer flush_data;
+
   guint create_mipmaps : 1;
 };
 
@@ -1439,6 +1444,8 @@ meta_shaped_texture_get_image (MetaShapedTexture *stex,
 
   g_return_val_if_fail (META_IS_SHAPED_TEXTURE (stex), NULL);
 
+  meta_shaped_texture_flush (stex);
+
   if (stex->texture == NULL)
     return NULL;
 
@@ -1638,3 +1645,22 @@ meta_shaped_texture_get_unscaled_height (MetaShapedTexture *stex)
 
   return unscaled_size.height;
 }
+
+void
+meta_shaped_texture_set_flush_func (MetaShapedTexture          *stex,
+                                    MetaShapedTextureFlushFunc  flush_func,
+                                    gpointer                    user_data)
+{
+  stex->flush_func = flush_func;
+  stex->flush_data = user_data;
+}
+
+/* Makes sure the texture holds the latest content, uploading anything its
+ * owner held back because it wasn't visible. Needed before the content is
+ * used for anything else than painting it on screen. */
+void
+meta_shaped_texture_flush (MetaShapedTexture *stex)
+{
+  if (stex->flush_func)
+    stex->flush_func (stex, stex->flush_data);
+}
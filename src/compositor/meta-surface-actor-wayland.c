@@ -260,6 +260,16 @@ out:
   parent_class->apply_transform (actor, matrix);
 }
 
+static void
+flush_deferred_damage (MetaShapedTexture *stex,
+                       gpointer           user_data)
+{
+  MetaSurfaceActorWayland *self = user_data;
+
+  if (self->surface)
+    meta_wayland_surface_flush_deferred_damage (self->surface);
+}
+
 static void
 on_surface_disposed (gpointer user_data,
                      GObject *destroyed_object)
@@ -280,7 +290,10 @@ meta_surface_actor_wayland_dispose (GObject *object)
 
   stex = meta_surface_actor_get_texture (META_SURFACE_ACTOR (self));
   if (stex)
-    meta_shaped_texture_set_texture (stex, NULL);
+    {
+      meta_shaped_texture_set_flush_func (stex, NULL, NULL);
+      meta_shaped_texture_set_texture (stex, NULL);
+    }
 
   if (self->surface)
     {
@@ -325,6 +338,10 @@ meta_surface_actor_wayland_new (MetaWaylandSurface *surface)
                      on_surface_disposed,
                      self);
 
+  meta_shaped_texture_set_flush_func (meta_surface_actor_get_texture (META_SURFACE_ACTOR (self)),
+                                      flush_deferred_damage,
+                                      self);
+
   return META_SURFACE_ACTOR (self);
 }
 
@@ -492,6 +492,21 @@ meta_surface_actor_is_effectively_obscured (MetaSurfaceActor *surface_actor)
     return priv->is_obscured;
 }
 
+/* Unlike the is-obscured state, this is only TRUE if the last culling pass
+ * actually computed an empty unobscured region and nothing paints the actor
+ * through a clone. Actors that weren't culled, e.g. because they are hidden,
+ * are never considered culled out.
+ */
+gboolean
+meta_surface_actor_is_culled_out (MetaSurfaceActor *surface_actor)
+{
+  MtkRegion *unobscured_region;
+
+  unobscured_region = effective_unobscured_region (surface_actor);
+
+  return unobscured_region && mtk_region_is_empty (unobscured_region);
+}
+
 gboolean
 meta_surface_actor_is_obscured_on_stage_view (MetaSurfaceActor *self,
                                               ClutterStageView *stage_view,
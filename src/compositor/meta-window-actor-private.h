@@ -35,6 +35,7 @@ struct _MetaWindowActorClass
 
   void (*sync_geometry) (MetaWindowActor *actor);
   gboolean (*is_single_surface_actor) (MetaWindowActor *actor);
+  void (*appears_focused_changed) (MetaWindowActor *actor);
 };
 
 typedef enum
@@ -469,6 +469,29 @@ static void
 meta_window_actor_wayland_before_paint (MetaWindowActor  *actor,
                                         ClutterStageView *stage_view)
 {
+  MetaWindowActorWayland *self = META_WINDOW_ACTOR_WAYLAND (actor);
+  gboolean is_streaming;
+  ClutterActor *child;
+  ClutterActorIter iter;
+
+  is_streaming = meta_window_actor_is_streaming (actor);
+
+  /* Culling just happened, so upload whatever damage was deferred while a
+   * surface was culled out, if it might be painted again now. */
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (self->surface_container));
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      MetaSurfaceActorWayland *surface_actor = META_SURFACE_ACTOR_WAYLAND (child);
+      MetaWaylandSurface *surface;
+
+      if (!is_streaming &&
+          meta_surface_actor_is_culled_out (META_SURFACE_ACTOR (surface_actor)))
+        continue;
+
+      surface = meta_surface_actor_wayland_get_surface (surface_actor);
+      if (surface)
+        meta_wayland_surface_flush_deferred_damage (surface);
+    }
 }
 
 static void
@@ -531,6 +554,14 @@ meta_window_actor_wayland_is_single_surface_actor (MetaWindowActor *actor)
          !self->background;
 }
 
+static void
+meta_window_actor_wayland_appears_focused_changed (MetaWindowActor *actor)
+{
+  /* Wayland clients draw their own decorations and shadows, so anything
+   * that changes with the focus is damaged by the client itself.
+   */
+}
+
 static gboolean
 maybe_configure_black_background (MetaWindowActorWayland *self,
                                   float                  *surfaces_width,
@@ -714,6 +745,7 @@ meta_window_actor_wayland_class_init (MetaWindowActorWaylandClass *klass)
   window_actor_class->can_freeze_commits = meta_window_actor_wayland_can_freeze_commits;
   window_actor_class->sync_geometry = meta_window_actor_wayland_sync_geometry;
   window_actor_class->is_single_surface_actor = meta_window_actor_wayland_is_single_surface_actor;
+  window_actor_class->appears_focused_changed = meta_window_actor_wayland_appears_focused_changed;
 
   clutter_actor_class->map = meta_window_actor_wayland_map;
 
@@ -1171,6 +1171,61 @@ handle_updates (MetaWindowActorX11 *actor_x11)
   check_needs_shadow (actor_x11);
 }
 
+static void
+meta_window_actor_x11_appears_focused_changed (MetaWindowActor *actor)
+{
+  MetaWindowActorX11 *actor_x11 = META_WINDOW_ACTOR_X11 (actor);
+  MetaWindow *window;
+  gboolean appears_focused;
+  MetaShadow *old_shadow;
+  MetaShadow *new_shadow;
+  MtkRectangle shadow_bounds;
+  g_autoptr (MtkRegion) damage = NULL;
+  int n_rects, i;
+
+  handle_updates (actor_x11);
+
+  window = meta_window_actor_get_meta_window (actor);
+  appears_focused = meta_window_appears_focused (window);
+  old_shadow = appears_focused ? actor_x11->unfocused_shadow
+                               : actor_x11->focused_shadow;
+  new_shadow = appears_focused ? actor_x11->focused_shadow
+                               : actor_x11->unfocused_shadow;
+
+  /* The window contents, including the frame, are not drawn differently
+   * depending on the focus; they are damaged by the client when needed.
+   * Only the shadow is, so that is all that needs to be repainted.
+   */
+  if (!old_shadow && !new_shadow)
+    return;
+
+  if (!old_shadow || !new_shadow || !actor_x11->shape_region)
+    {
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (actor));
+      return;
+    }
+
+  get_shadow_bounds (actor_x11, !appears_focused, &shadow_bounds);
+  damage = mtk_region_create_rectangle (&shadow_bounds);
+  get_shadow_bounds (actor_x11, appears_focused, &shadow_bounds);
+  mtk_region_union_rectangle (damage, &shadow_bounds);
+
+  if (clip_shadow_under_window (actor_x11))
+    {
+      if (actor_x11->frame_bounds)
+        mtk_region_subtract (damage, actor_x11->frame_bounds);
+    }
+
+  n_rects = mtk_region_num_rectangles (damage);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect;
+
+      rect = mtk_region_get_rectangle (damage, i);
+      clutter_actor_queue_redraw_with_clip (CLUTTER_ACTOR (actor), &rect);
+    }
+}
+
 static void
 handle_stage_views_changed (MetaWindowActorX11 *actor_x11)
 {
@@ -1594,6 +1649,7 @@ meta_window_actor_x11_class_init (MetaWindowActorX11Class *klass)
   window_actor_class->can_freeze_commits = meta_window_actor_x11_can_freeze_commits;
   window_actor_class->sync_geometry = meta_window_actor_x11_sync_geometry;
   window_actor_class->is_single_surface_actor = meta_window_actor_x11_is_single_surface_actor;
+  window_actor_class->appears_focused_changed = meta_window_actor_x11_appears_focused_changed;
 
   actor_class->paint = meta_window_actor_x11_paint;
   actor_class->get_paint_volume = meta_window_actor_x11_get_paint_volume;
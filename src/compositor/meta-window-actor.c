@@ -240,7 +240,9 @@ window_appears_focused_notify (MetaWindow *mw,
                                GParamSpec *arg1,
                                gpointer    data)
 {
-  clutter_actor_queue_redraw (CLUTTER_ACTOR (data));
+  MetaWindowActor *window_actor = META_WINDOW_ACTOR (data);
+
+  META_WINDOW_ACTOR_GET_CLASS (window_actor)->appears_focused_changed (window_actor);
 }
 
 gboolean
@@ -1627,6 +1629,66 @@ meta_window_actor_is_single_surface_actor (MetaWindowActor *self)
   return META_WINDOW_ACTOR_GET_CLASS (self)->is_single_surface_actor (self);
 }
 
+static gboolean
+get_framebuffer_clip (MetaWindowActor *self,
+                      MtkRectangle    *clip,
+                      MtkRectangle    *out_framebuffer_clip)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (self);
+  MtkRectangle framebuffer_clip;
+  float x, y, width, height;
+
+  clutter_actor_get_position (actor, &x, &y);
+  clutter_actor_get_size (actor, &width, &height);
+
+  if (width == 0 || height == 0)
+    return FALSE;
+
+  framebuffer_clip = (MtkRectangle) {
+    .x = floorf (x),
+    .y = floorf (y),
+    .width = ceilf (width),
+    .height = ceilf (height),
+  };
+
+  if (clip)
+    {
+      MtkRectangle tmp_clip;
+      MtkRectangle intersected_clip;
+
+      tmp_clip = *clip;
+      tmp_clip.x += floorf (x);
+      tmp_clip.y += floorf (y);
+      if (!mtk_rectangle_intersect (&framebuffer_clip,
+                                    &tmp_clip,
+                                    &intersected_clip))
+        return FALSE;
+
+      framebuffer_clip = intersected_clip;
+    }
+
+  *out_framebuffer_clip = framebuffer_clip;
+  return TRUE;
+}
+
+static void
+flush_surface_contents (ClutterActor *actor)
+{
+  ClutterActor *child;
+  ClutterActorIter iter;
+
+  if (META_IS_SURFACE_ACTOR (actor))
+    {
+      MetaSurfaceActor *surface_actor = META_SURFACE_ACTOR (actor);
+
+      meta_shaped_texture_flush (meta_surface_actor_get_texture (surface_actor));
+    }
+
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    flush_surface_contents (child);
+}
+
 /**
  * meta_window_actor_get_image:
  * @self: A #MetaWindowActor
@@ -1651,11 +1713,13 @@ meta_window_actor_get_image (MetaWindowActor *self,
   CoglFramebuffer *framebuffer;
   MtkRectangle framebuffer_clip;
   float resource_scale;
-  float x, y, width, height;
 
   if (!priv->surface)
     return NULL;
 
+  /* Culled out surfaces may not have uploaded their latest content */
+  flush_surface_contents (actor);
+
   clutter_actor_inhibit_culling (actor);
 
   stex = meta_surface_actor_get_texture (priv->surface);
@@ -1682,35 +1746,9 @@ meta_window_actor_get_image (MetaWindowActor *self,
       goto out;
     }
 
-  clutter_actor_get_position (actor, &x, &y);
-  clutter_actor_get_size (actor, &width, &height);
-
-  if (width == 0 || height == 0)
+  if (!get_framebuffer_clip (self, clip, &framebuffer_clip))
     goto out;
 
-  framebuffer_clip = (MtkRectangle) {
-    .x = floorf (x),
-    .y = floorf (y),
-    .width = ceilf (width),
-    .height = ceilf (height),
-  };
-
-  if (clip)
-    {
-      MtkRectangle tmp_clip;
-      MtkRectangle intersected_clip;
-
-      tmp_clip = *clip;
-      tmp_clip.x += floorf (x);
-      tmp_clip.y += floorf (y);
-      if (!mtk_rectangle_intersect (&framebuffer_clip,
-                                    &tmp_clip,
-                                    &intersected_clip))
-        goto out;
-
-      framebuffer_clip = intersected_clip;
-    }
-
   framebuffer = create_framebuffer_from_window_actor (self,
                                                       &framebuffer_clip,
                                                       NULL);
@@ -1739,6 +1777,152 @@ out:
   return surface;
 }
 
+static void
+on_image_read (GObject      *source_object,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (source_object);
+  g_autoptr (GTask) task = user_data;
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  GError *error = NULL;
+  CoglBuffer *pixel_buffer;
+  cairo_surface_t *surface;
+  uint8_t *pixels;
+  uint8_t *surface_data;
+  int width, height, rowstride, surface_stride;
+  int y;
+
+  bitmap = cogl_framebuffer_read_pixels_finish (framebuffer, result, &error);
+  if (!bitmap)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  pixel_buffer = COGL_BUFFER (cogl_bitmap_get_buffer (bitmap));
+  pixels = cogl_buffer_map (pixel_buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (!pixels)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to map pixel buffer");
+      return;
+    }
+
+  width = cogl_bitmap_get_width (bitmap);
+  height = cogl_bitmap_get_height (bitmap);
+  rowstride = cogl_bitmap_get_rowstride (bitmap);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  surface_data = cairo_image_surface_get_data (surface);
+  surface_stride = cairo_image_surface_get_stride (surface);
+
+  for (y = 0; y < height; y++)
+    {
+      memcpy (surface_data + y * surface_stride,
+              pixels + y * rowstride,
+              width * 4);
+    }
+
+  cogl_buffer_unmap (pixel_buffer);
+  cairo_surface_mark_dirty (surface);
+
+  g_task_return_pointer (task, surface,
+                         (GDestroyNotify) cairo_surface_destroy);
+}
+
+/**
+ * meta_window_actor_get_image_async:
+ * @self: A #MetaWindowActor
+ * @clip: (nullable): A clipping rectangle, to help prevent extra processing.
+ * In the case that the clipping rectangle is partially or fully
+ * outside the bounds of the actor, the rectangle will be clipped.
+ * @cancellable: (nullable): A #GCancellable
+ * @callback: The callback to call when the image is ready
+ * @user_data: The data to pass to @callback
+ *
+ * Asynchronous variant of meta_window_actor_get_image(). The window is
+ * always painted into an offscreen framebuffer at the resource scale of
+ * @self, and the pixels are read back without waiting for the GPU.
+ */
+void
+meta_window_actor_get_image_async (MetaWindowActor     *self,
+                                   MtkRectangle        *clip,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  MetaWindowActorPrivate *priv = meta_window_actor_get_instance_private (self);
+  ClutterActor *actor = CLUTTER_ACTOR (self);
+  g_autoptr (GTask) task = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglFramebuffer *framebuffer;
+  MtkRectangle framebuffer_clip;
+  float resource_scale;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, meta_window_actor_get_image_async);
+
+  if (!priv->surface ||
+      !get_framebuffer_clip (self, clip, &framebuffer_clip))
+    {
+      g_task_return_pointer (task, NULL, NULL);
+      return;
+    }
+
+  flush_surface_contents (actor);
+
+  clutter_actor_inhibit_culling (actor);
+  framebuffer = create_framebuffer_from_window_actor (self,
+                                                      &framebuffer_clip,
+                                                      &error);
+  clutter_actor_uninhibit_culling (actor);
+
+  if (!framebuffer)
+    {
+      if (error)
+        g_task_return_error (task, g_steal_pointer (&error));
+      else
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                 "Failed to create offscreen framebuffer");
+      return;
+    }
+
+  resource_scale = clutter_actor_get_resource_scale (actor);
+  cogl_framebuffer_read_pixels_async (framebuffer,
+                                      0, 0,
+                                      framebuffer_clip.width * resource_scale,
+                                      framebuffer_clip.height * resource_scale,
+                                      COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
+                                      cancellable,
+                                      on_image_read,
+                                      g_steal_pointer (&task));
+  g_object_unref (framebuffer);
+}
+
+/**
+ * meta_window_actor_get_image_finish:
+ * @self: A #MetaWindowActor
+ * @result: The #GAsyncResult passed to the callback
+ * @error: Return location for a #GError
+ *
+ * Finishes an operation started with meta_window_actor_get_image_async().
+ *
+ * Returns: (nullable) (transfer full): a new cairo surface to be freed with
+ * cairo_surface_destroy().
+ */
+cairo_surface_t *
+meta_window_actor_get_image_finish (MetaWindowActor  *self,
+                                    GAsyncResult     *result,
+                                    GError          **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        meta_window_actor_get_image_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * meta_window_actor_paint_to_content:
  * @self: A #MetaWindowActor
@@ -1766,6 +1950,8 @@ meta_window_actor_paint_to_content (MetaWindowActor  *self,
   if (!priv->surface)
     return NULL;
 
+  flush_surface_contents (actor);
+
   clutter_actor_inhibit_culling (actor);
 
   clutter_actor_get_position (actor, &x, &y);
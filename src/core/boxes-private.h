@@ -179,6 +179,84 @@ void     meta_rectangle_shove_into_region(
                                          FixedDirections  fixed_directions,
                                          MtkRectangle    *rect);
 
+/* A region given by its minimal spanning set of rectangles, like the GList
+ * based functions above, but stored contiguously in a single allocation.
+ * The rectangles are sorted by decreasing area.
+ */
+typedef struct _MetaSpanningRegion
+{
+  int n_rects;
+  MtkRectangle rects[];
+} MetaSpanningRegion;
+
+/* Same as meta_rectangle_get_minimal_spanning_set_for_region() */
+META_EXPORT_TEST
+MetaSpanningRegion * meta_spanning_region_new_for_struts (
+                                         const MtkRectangle *basic_rect,
+                                         const GSList       *all_struts);
+
+MetaSpanningRegion * meta_spanning_region_new_for_rect (
+                                         const MtkRectangle *rect);
+
+/* Same as meta_rectangle_expand_region_conditionally(), but returns an
+ * expanded copy, leaving region untouched.
+ */
+MetaSpanningRegion * meta_spanning_region_copy_expanded (
+                                         const MetaSpanningRegion *region,
+                                         const int                 left_expand,
+                                         const int                 right_expand,
+                                         const int                 top_expand,
+                                         const int                 bottom_expand,
+                                         const int                 min_x,
+                                         const int                 min_y);
+
+META_EXPORT_TEST
+void     meta_spanning_region_free      (MetaSpanningRegion *region);
+
+META_EXPORT_TEST
+gboolean meta_spanning_region_is_empty  (const MetaSpanningRegion *region);
+
+META_EXPORT_TEST
+gboolean meta_spanning_region_could_fit_rect (
+                                         const MetaSpanningRegion *region,
+                                         const MtkRectangle       *rect);
+
+META_EXPORT_TEST
+gboolean meta_spanning_region_contains_rect (
+                                         const MetaSpanningRegion *region,
+                                         const MtkRectangle       *rect);
+
+gboolean meta_spanning_region_overlaps_rect (
+                                         const MetaSpanningRegion *region,
+                                         const MtkRectangle       *rect);
+
+META_EXPORT_TEST
+void     meta_spanning_region_clamp_to_fit (
+                                         const MetaSpanningRegion *region,
+                                         FixedDirections           fixed_directions,
+                                         MtkRectangle             *rect,
+                                         const MtkRectangle       *min_size);
+
+META_EXPORT_TEST
+void     meta_spanning_region_clip      (const MetaSpanningRegion *region,
+                                         FixedDirections           fixed_directions,
+                                         MtkRectangle             *rect);
+
+META_EXPORT_TEST
+void     meta_spanning_region_shove     (const MetaSpanningRegion *region,
+                                         FixedDirections           fixed_directions,
+                                         MtkRectangle             *rect);
+
+/* The output buffer needs to be as big as for
+ * meta_rectangle_region_to_string(), with n_rects instead of the list
+ * length.
+ */
+char*    meta_spanning_region_to_string (const MetaSpanningRegion *region,
+                                         const char               *separator_string,
+                                         char                     *output);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaSpanningRegion, meta_spanning_region_free)
+
 /* Finds the point on the line connecting (x1,y1) to (x2,y2) which is closest
  * to (px, py).  Useful for finding an optimal rectangle size when given a
  * range between two sizes that are all candidates.
@@ -218,10 +296,47 @@ gint   meta_rectangle_edge_cmp_ignore_type (gconstpointer a, gconstpointer b);
 /* Removes an parts of edges in the given list that intersect any box in the
  * given rectangle list.  Returns the result.
  */
+META_EXPORT_TEST
 GList* meta_rectangle_remove_intersections_with_boxes_from_edges (
                                            GList *edges,
                                            const GSList *rectangles);
 
+/* A stack of rectangles (bottom to top) indexed for quickly finding which
+ * rectangles obscure the edges of the ones below them.  Used for building
+ * the window edges for edge resistance and snapping.
+ */
+typedef struct _MetaRectangleStack MetaRectangleStack;
+
+META_EXPORT_TEST
+MetaRectangleStack * meta_rectangle_stack_new (void);
+
+META_EXPORT_TEST
+void meta_rectangle_stack_free (MetaRectangleStack *stack);
+
+META_EXPORT_TEST
+int meta_rectangle_stack_push (MetaRectangleStack *stack,
+                               const MtkRectangle *rect);
+
+int meta_rectangle_stack_get_length (MetaRectangleStack *stack);
+
+const MtkRectangle * meta_rectangle_stack_get_rect (MetaRectangleStack *stack,
+                                                    int                 index);
+
+void meta_rectangle_stack_set_rect (MetaRectangleStack *stack,
+                                    int                 index,
+                                    const MtkRectangle *rect);
+
+/* Adds the edges of the rectangle at index, clipped to clip, minus the parts
+ * obscured by rectangles higher up in the stack, to edges.
+ */
+META_EXPORT_TEST
+GList* meta_rectangle_stack_add_window_edges (MetaRectangleStack *stack,
+                                              int                 index,
+                                              const MtkRectangle *clip,
+                                              GList              *edges);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaRectangleStack, meta_rectangle_stack_free)
+
 /* Finds all the edges of an onscreen region, returning a GList* of
  * MetaEdgeRect's.
  */
@@ -28,6 +28,7 @@
 #include "core/boxes-private.h"
 
 #include <math.h>
+#include <string.h>
 
 #include "meta/util.h"
 
@@ -636,6 +637,292 @@ meta_rectangle_free_list_and_elements (GList *filled_list)
   g_list_free_full (filled_list, g_free);
 }
 
+/* Split rect into the up to four maximal rectangles around strut_rect that
+ * don't overlap it, and append them to pieces.
+ */
+static void
+split_rect_around_strut (const MtkRectangle *rect,
+                         const MtkRectangle *strut_rect,
+                         GArray             *pieces)
+{
+  MtkRectangle piece;
+
+  /* If there is area in rect left of strut */
+  if (BOX_LEFT (*rect) < BOX_LEFT (*strut_rect))
+    {
+      piece = *rect;
+      piece.width = BOX_LEFT (*strut_rect) - BOX_LEFT (*rect);
+      g_array_append_val (pieces, piece);
+    }
+  /* If there is area in rect right of strut */
+  if (BOX_RIGHT (*rect) > BOX_RIGHT (*strut_rect))
+    {
+      piece = *rect;
+      piece.x = BOX_RIGHT (*strut_rect);
+      piece.width = BOX_RIGHT (*rect) - piece.x;
+      g_array_append_val (pieces, piece);
+    }
+  /* If there is area in rect above strut */
+  if (BOX_TOP (*rect) < BOX_TOP (*strut_rect))
+    {
+      piece = *rect;
+      piece.height = BOX_TOP (*strut_rect) - BOX_TOP (*rect);
+      g_array_append_val (pieces, piece);
+    }
+  /* If there is area in rect below strut */
+  if (BOX_BOTTOM (*rect) > BOX_BOTTOM (*strut_rect))
+    {
+      piece = *rect;
+      piece.y = BOX_BOTTOM (*strut_rect);
+      piece.height = BOX_BOTTOM (*rect) - piece.y;
+      g_array_append_val (pieces, piece);
+    }
+}
+
+static MetaSpanningRegion *
+spanning_region_new (const MtkRectangle *rects,
+                     int                 n_rects)
+{
+  MetaSpanningRegion *region;
+
+  region = g_malloc (sizeof (MetaSpanningRegion) +
+                     n_rects * sizeof (MtkRectangle));
+  region->n_rects = n_rects;
+  if (n_rects > 0)
+    memcpy (region->rects, rects, n_rects * sizeof (MtkRectangle));
+
+  return region;
+}
+
+static MetaSpanningRegion *
+spanning_region_new_from_list (const GList *spanning_rects)
+{
+  MetaSpanningRegion *region;
+  const GList *l;
+  int i;
+
+  region = g_malloc (sizeof (MetaSpanningRegion) +
+                     g_list_length ((GList *) spanning_rects) *
+                     sizeof (MtkRectangle));
+
+  for (l = spanning_rects, i = 0; l; l = l->next, i++)
+    region->rects[i] = *(MtkRectangle *) l->data;
+  region->n_rects = i;
+
+  return region;
+}
+
+/**
+ * meta_spanning_region_new_for_struts: (skip)
+ *
+ * Finds the minimal spanning set of the region given by taking basic_rect
+ * and removing the areas covered by all_struts, exactly like
+ * meta_rectangle_get_minimal_spanning_set_for_region(), but stores it in a
+ * single contiguous block.
+ *
+ * Instead of splitting everything and then merging the resulting list
+ * pairwise, this keeps the set of maximal rectangles up to date as each
+ * strut is applied: only the rectangles overlapping the strut are split,
+ * and only the new pieces need to be checked for being contained in the
+ * other rectangles, since none of the untouched (maximal) rectangles can be
+ * contained in a piece of another one.  The pieces are checked in order of
+ * decreasing area so the check is a single pass, and the result is sorted
+ * by area like the list version.
+ */
+MetaSpanningRegion *
+meta_spanning_region_new_for_struts (const MtkRectangle *basic_rect,
+                                     const GSList       *all_struts)
+{
+  g_autoptr (GArray) rects = NULL;
+  g_autoptr (GArray) pieces = NULL;
+  const GSList *strut_iter;
+
+  rects = g_array_new (FALSE, FALSE, sizeof (MtkRectangle));
+  pieces = g_array_new (FALSE, FALSE, sizeof (MtkRectangle));
+  g_array_append_val (rects, *basic_rect);
+
+  for (strut_iter = all_struts; strut_iter; strut_iter = strut_iter->next)
+    {
+      MetaStrut *strut = (MetaStrut*) strut_iter->data;
+      MtkRectangle *strut_rect = &strut->rect;
+      guint i, j;
+
+      if (!check_strut_align (strut, basic_rect))
+        continue;
+
+      /* Replace the rectangles overlapping the strut with their pieces */
+      g_array_set_size (pieces, 0);
+      i = 0;
+      while (i < rects->len)
+        {
+          MtkRectangle *rect = &g_array_index (rects, MtkRectangle, i);
+
+          if (!mtk_rectangle_overlap (strut_rect, rect))
+            {
+              i++;
+              continue;
+            }
+
+          split_rect_around_strut (rect, strut_rect, pieces);
+          g_array_remove_index_fast (rects, i);
+        }
+
+      g_array_sort (pieces, compare_rect_areas);
+      for (i = 0; i < pieces->len; i++)
+        {
+          MtkRectangle *piece = &g_array_index (pieces, MtkRectangle, i);
+          gboolean contained = FALSE;
+
+          for (j = 0; j < rects->len && !contained; j++)
+            {
+              contained =
+                mtk_rectangle_contains_rect (&g_array_index (rects,
+                                                             MtkRectangle,
+                                                             j),
+                                             piece);
+            }
+
+          if (!contained)
+            g_array_append_val (rects, *piece);
+        }
+    }
+
+  if (rects->len == 0)
+    {
+      g_warning ("Region to merge was empty! Either you have some "
+                 "pathological STRUT list or there's a bug somewhere!");
+    }
+
+  /* Sort by maximal area, same as the list version */
+  g_array_sort (rects, compare_rect_areas);
+
+  return spanning_region_new ((MtkRectangle *) rects->data, rects->len);
+}
+
+MetaSpanningRegion *
+meta_spanning_region_new_for_rect (const MtkRectangle *rect)
+{
+  return spanning_region_new (rect, 1);
+}
+
+/* Returns a copy of region with the rectangles expanded the same way
+ * meta_rectangle_expand_region_conditionally() does.
+ */
+MetaSpanningRegion *
+meta_spanning_region_copy_expanded (const MetaSpanningRegion *region,
+                                    const int                 left_expand,
+                                    const int                 right_expand,
+                                    const int                 top_expand,
+                                    const int                 bottom_expand,
+                                    const int                 min_x,
+                                    const int                 min_y)
+{
+  MetaSpanningRegion *expanded;
+  int i;
+
+  expanded = spanning_region_new (region->rects, region->n_rects);
+  for (i = 0; i < expanded->n_rects; i++)
+    {
+      MtkRectangle *rect = &expanded->rects[i];
+
+      if (rect->width >= min_x)
+        {
+          rect->x      -= left_expand;
+          rect->width  += (left_expand + right_expand);
+        }
+      if (rect->height >= min_y)
+        {
+          rect->y      -= top_expand;
+          rect->height += (top_expand + bottom_expand);
+        }
+    }
+
+  return expanded;
+}
+
+void
+meta_spanning_region_free (MetaSpanningRegion *region)
+{
+  g_free (region);
+}
+
+gboolean
+meta_spanning_region_is_empty (const MetaSpanningRegion *region)
+{
+  return region->n_rects == 0;
+}
+
+gboolean
+meta_spanning_region_could_fit_rect (const MetaSpanningRegion *region,
+                                     const MtkRectangle       *rect)
+{
+  int i;
+
+  for (i = 0; i < region->n_rects; i++)
+    {
+      if (mtk_rectangle_could_fit_rect (&region->rects[i], rect))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+gboolean
+meta_spanning_region_contains_rect (const MetaSpanningRegion *region,
+                                    const MtkRectangle       *rect)
+{
+  int i;
+
+  for (i = 0; i < region->n_rects; i++)
+    {
+      if (mtk_rectangle_contains_rect (&region->rects[i], rect))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+gboolean
+meta_spanning_region_overlaps_rect (const MetaSpanningRegion *region,
+                                    const MtkRectangle       *rect)
+{
+  int i;
+
+  for (i = 0; i < region->n_rects; i++)
+    {
+      if (mtk_rectangle_overlap (&region->rects[i], rect))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+char *
+meta_spanning_region_to_string (const MetaSpanningRegion *region,
+                                const char               *separator_string,
+                                char                     *output)
+{
+  char rect_string[RECT_LENGTH];
+  char *cur = output;
+  int i;
+
+  if (region->n_rects == 0)
+    g_snprintf (output, 10, "(EMPTY)");
+
+  for (i = 0; i < region->n_rects; i++)
+    {
+      const MtkRectangle *rect = &region->rects[i];
+
+      g_snprintf (rect_string, RECT_LENGTH, "[%d,%d +%d,%d]",
+                  rect->x, rect->y, rect->width, rect->height);
+      cur = g_stpcpy (cur, rect_string);
+      if (i + 1 < region->n_rects)
+        cur = g_stpcpy (cur, separator_string);
+    }
+
+  return output;
+}
+
 gboolean
 meta_rectangle_could_fit_in_region (const GList        *spanning_rects,
                                     const MtkRectangle *rect)
@@ -716,17 +1003,29 @@ meta_rectangle_clamp_to_fit_into_region (const GList        *spanning_rects,
                                          MtkRectangle       *rect,
                                          const MtkRectangle *min_size)
 {
-  const GList *temp;
+  g_autoptr (MetaSpanningRegion) region = NULL;
+
+  region = spanning_region_new_from_list (spanning_rects);
+  meta_spanning_region_clamp_to_fit (region, fixed_directions, rect, min_size);
+}
+
+void
+meta_spanning_region_clamp_to_fit (const MetaSpanningRegion *region,
+                                   FixedDirections           fixed_directions,
+                                   MtkRectangle             *rect,
+                                   const MtkRectangle       *min_size)
+{
   const MtkRectangle *best_rect = NULL;
   int                  best_overlap = 0;
+  int                  i;
 
-  /* First, find best rectangle from spanning_rects to which we can clamp
+  /* First, find best rectangle from the spanning rects to which we can clamp
    * rect to fit into.
    */
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; i < region->n_rects; i++)
     {
-      MtkRectangle *compare_rect = temp->data;
-      int            maximal_overlap_amount_for_compare;
+      const MtkRectangle *compare_rect = &region->rects[i];
+      int                 maximal_overlap_amount_for_compare;
 
       /* If x is fixed and the entire width of rect doesn't fit in compare,
        * skip this rectangle.
@@ -785,18 +1084,29 @@ meta_rectangle_clip_to_region (const GList     *spanning_rects,
                                FixedDirections  fixed_directions,
                                MtkRectangle    *rect)
 {
-  const GList *temp;
+  g_autoptr (MetaSpanningRegion) region = NULL;
+
+  region = spanning_region_new_from_list (spanning_rects);
+  meta_spanning_region_clip (region, fixed_directions, rect);
+}
+
+void
+meta_spanning_region_clip (const MetaSpanningRegion *region,
+                           FixedDirections           fixed_directions,
+                           MtkRectangle             *rect)
+{
   const MtkRectangle *best_rect = NULL;
   int                  best_overlap = 0;
+  int                  i;
 
-  /* First, find best rectangle from spanning_rects to which we will clip
+  /* First, find best rectangle from the spanning rects to which we will clip
    * rect into.
    */
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; i < region->n_rects; i++)
     {
-      MtkRectangle *compare_rect = temp->data;
-      MtkRectangle  overlap;
-      int            maximal_overlap_amount_for_compare;
+      const MtkRectangle *compare_rect = &region->rects[i];
+      MtkRectangle        overlap;
+      int                 maximal_overlap_amount_for_compare;
 
       /* If x is fixed and the entire width of rect doesn't fit in compare,
        * skip the rectangle.
@@ -864,20 +1174,31 @@ meta_rectangle_shove_into_region (const GList     *spanning_rects,
                                   FixedDirections  fixed_directions,
                                   MtkRectangle    *rect)
 {
-  const GList *temp;
+  g_autoptr (MetaSpanningRegion) region = NULL;
+
+  region = spanning_region_new_from_list (spanning_rects);
+  meta_spanning_region_shove (region, fixed_directions, rect);
+}
+
+void
+meta_spanning_region_shove (const MetaSpanningRegion *region,
+                            FixedDirections           fixed_directions,
+                            MtkRectangle             *rect)
+{
   const MtkRectangle *best_rect = NULL;
   int                  best_overlap = 0;
   int                  shortest_distance = G_MAXINT;
+  int                  i;
 
-  /* First, find best rectangle from spanning_rects to which we will shove
-   * rect into.
+  /* First, find best rectangle from the spanning rects to which we will
+   * shove rect into.
    */
 
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; i < region->n_rects; i++)
     {
-      MtkRectangle  *compare_rect = temp->data;
-      int            maximal_overlap_amount_for_compare;
-      int            dist_to_compare;
+      const MtkRectangle *compare_rect = &region->rects[i];
+      int                 maximal_overlap_amount_for_compare;
+      int                 dist_to_compare;
 
       /* If x is fixed and the entire width of rect doesn't fit in compare,
        * skip this rectangle.
@@ -1601,6 +1922,426 @@ meta_rectangle_remove_intersections_with_boxes_from_edges (
   return edges;
 }
 
+/* A span of one of the rectangles in a MetaRectangleStack, projected on
+ * either the x or the y axis.  The spans are kept sorted by start so that
+ * they form an implicit balanced binary search tree, with each node (the
+ * middle element of an index range) caching the maximum end of its subtree.
+ */
+typedef struct
+{
+  int start;
+  int end;
+  int max_end;
+  int index;
+} RectangleSpan;
+
+typedef struct
+{
+  int start;
+  int end;
+} CoveredInterval;
+
+struct _MetaRectangleStack
+{
+  GArray *rects;
+
+  GArray *x_spans;
+  GArray *y_spans;
+  gboolean spans_dirty;
+};
+
+/**
+ * meta_rectangle_stack_new: (skip)
+ *
+ * Creates an empty stack of rectangles, ordered from bottom to top, which
+ * can be queried for the parts of a rectangle's edges that are not obscured
+ * by the rectangles stacked above it.
+ */
+MetaRectangleStack *
+meta_rectangle_stack_new (void)
+{
+  MetaRectangleStack *stack;
+
+  stack = g_new0 (MetaRectangleStack, 1);
+  stack->rects = g_array_new (FALSE, FALSE, sizeof (MtkRectangle));
+  stack->x_spans = g_array_new (FALSE, FALSE, sizeof (RectangleSpan));
+  stack->y_spans = g_array_new (FALSE, FALSE, sizeof (RectangleSpan));
+
+  return stack;
+}
+
+void
+meta_rectangle_stack_free (MetaRectangleStack *stack)
+{
+  g_array_free (stack->rects, TRUE);
+  g_array_free (stack->x_spans, TRUE);
+  g_array_free (stack->y_spans, TRUE);
+  g_free (stack);
+}
+
+/* Adds rect on top of the stack and returns its index */
+int
+meta_rectangle_stack_push (MetaRectangleStack *stack,
+                           const MtkRectangle *rect)
+{
+  g_array_append_val (stack->rects, *rect);
+  stack->spans_dirty = TRUE;
+
+  return stack->rects->len - 1;
+}
+
+int
+meta_rectangle_stack_get_length (MetaRectangleStack *stack)
+{
+  return stack->rects->len;
+}
+
+const MtkRectangle *
+meta_rectangle_stack_get_rect (MetaRectangleStack *stack,
+                               int                 index)
+{
+  g_return_val_if_fail (index >= 0 && index < (int) stack->rects->len, NULL);
+
+  return &g_array_index (stack->rects, MtkRectangle, index);
+}
+
+/* Replaces the rectangle at the given stacking position, e.g. because the
+ * corresponding window moved.
+ */
+void
+meta_rectangle_stack_set_rect (MetaRectangleStack *stack,
+                               int                 index,
+                               const MtkRectangle *rect)
+{
+  g_return_if_fail (index >= 0 && index < (int) stack->rects->len);
+
+  g_array_index (stack->rects, MtkRectangle, index) = *rect;
+  stack->spans_dirty = TRUE;
+}
+
+static int
+compare_rectangle_spans (gconstpointer a,
+                         gconstpointer b)
+{
+  const RectangleSpan *span_a = a;
+  const RectangleSpan *span_b = b;
+
+  if (span_a->start != span_b->start)
+    return span_a->start < span_b->start ? -1 : 1;
+
+  return span_a->index - span_b->index;
+}
+
+static int
+update_span_max_ends (GArray *spans,
+                      int     low,
+                      int     high)
+{
+  RectangleSpan *span;
+  int mid;
+
+  if (low >= high)
+    return G_MININT;
+
+  mid = low + (high - low) / 2;
+  span = &g_array_index (spans, RectangleSpan, mid);
+  span->max_end = MAX (span->end,
+                       MAX (update_span_max_ends (spans, low, mid),
+                            update_span_max_ends (spans, mid + 1, high)));
+
+  return span->max_end;
+}
+
+static void
+build_spans (GArray       *spans,
+             GArray       *rects,
+             MetaDirection direction)
+{
+  guint i;
+
+  g_array_set_size (spans, rects->len);
+  for (i = 0; i < rects->len; i++)
+    {
+      MtkRectangle *rect = &g_array_index (rects, MtkRectangle, i);
+      RectangleSpan *span = &g_array_index (spans, RectangleSpan, i);
+
+      if (direction == META_DIRECTION_HORIZONTAL)
+        {
+          span->start = BOX_LEFT (*rect);
+          span->end = BOX_RIGHT (*rect);
+        }
+      else
+        {
+          span->start = BOX_TOP (*rect);
+          span->end = BOX_BOTTOM (*rect);
+        }
+      span->index = i;
+    }
+
+  g_array_sort (spans, compare_rectangle_spans);
+  update_span_max_ends (spans, 0, spans->len);
+}
+
+static void
+ensure_spans (MetaRectangleStack *stack)
+{
+  if (!stack->spans_dirty)
+    return;
+
+  build_spans (stack->x_spans, stack->rects, META_DIRECTION_HORIZONTAL);
+  build_spans (stack->y_spans, stack->rects, META_DIRECTION_VERTICAL);
+  stack->spans_dirty = FALSE;
+}
+
+/* Appends the index of all spans in [low, high) containing position
+ * (inclusively at both ends) and stacked above min_index to indices.
+ */
+static void
+find_spans_containing (GArray *spans,
+                       int     low,
+                       int     high,
+                       int     position,
+                       int     min_index,
+                       GArray *indices)
+{
+  RectangleSpan *span;
+  int mid;
+
+  while (low < high)
+    {
+      mid = low + (high - low) / 2;
+      span = &g_array_index (spans, RectangleSpan, mid);
+
+      if (span->max_end < position)
+        return;
+
+      find_spans_containing (spans, low, mid, position, min_index, indices);
+
+      if (span->start > position)
+        return;
+
+      if (span->end >= position && span->index > min_index)
+        g_array_append_val (indices, span->index);
+
+      low = mid + 1;
+    }
+}
+
+static int
+compare_covered_intervals (gconstpointer a,
+                           gconstpointer b)
+{
+  const CoveredInterval *interval_a = a;
+  const CoveredInterval *interval_b = b;
+
+  if (interval_a->start != interval_b->start)
+    return interval_a->start < interval_b->start ? -1 : 1;
+
+  return 0;
+}
+
+/* Adds the parts of edge not covered by any rect stacked above index to
+ * edges.  This matches what
+ * meta_rectangle_remove_intersections_with_boxes_from_edges() does, i.e.
+ * obscuring rectangles touching the edge from the opposing side do not
+ * split it.
+ */
+static GList *
+add_unobscured_edge_parts (MetaRectangleStack *stack,
+                           int                 index,
+                           const MetaEdge     *edge,
+                           GArray             *indices,
+                           GArray             *intervals,
+                           GList              *edges)
+{
+  gboolean vertical;
+  int position, start, end, cursor;
+  guint i;
+
+  vertical = edge->side_type == META_SIDE_LEFT ||
+             edge->side_type == META_SIDE_RIGHT;
+  position = vertical ? BOX_LEFT (edge->rect) : BOX_TOP (edge->rect);
+  start = vertical ? BOX_TOP (edge->rect) : BOX_LEFT (edge->rect);
+  end = vertical ? BOX_BOTTOM (edge->rect) : BOX_RIGHT (edge->rect);
+
+  g_array_set_size (indices, 0);
+  find_spans_containing (vertical ? stack->x_spans : stack->y_spans,
+                         0, stack->rects->len,
+                         position, index,
+                         indices);
+
+  g_array_set_size (intervals, 0);
+  for (i = 0; i < indices->len; i++)
+    {
+      MtkRectangle *rect = &g_array_index (stack->rects, MtkRectangle,
+                                           g_array_index (indices, int, i));
+      CoveredInterval interval;
+      int near, far;
+
+      near = vertical ? BOX_LEFT (*rect) : BOX_TOP (*rect);
+      far = vertical ? BOX_RIGHT (*rect) : BOX_BOTTOM (*rect);
+
+      /* Opposing sides touching the edge don't count, see
+       * rectangle_and_edge_intersection() for the details.
+       */
+      switch (edge->side_type)
+        {
+        case META_SIDE_RIGHT:
+        case META_SIDE_BOTTOM:
+          if (position == far && near != far)
+            continue;
+          break;
+        case META_SIDE_LEFT:
+        case META_SIDE_TOP:
+          if (position == near)
+            continue;
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+
+      interval.start = MAX (start,
+                            vertical ? BOX_TOP (*rect) : BOX_LEFT (*rect));
+      interval.end = MIN (end,
+                          vertical ? BOX_BOTTOM (*rect) : BOX_RIGHT (*rect));
+      if (interval.end > interval.start)
+        g_array_append_val (intervals, interval);
+    }
+
+  /* Sweep over the covered intervals in order and emit the gaps */
+  g_array_sort (intervals, compare_covered_intervals);
+
+  cursor = start;
+  for (i = 0; i < intervals->len && cursor < end; i++)
+    {
+      CoveredInterval *covered = &g_array_index (intervals, CoveredInterval, i);
+
+      if (covered->start > cursor)
+        {
+          MetaEdge *part = g_new (MetaEdge, 1);
+
+          *part = *edge;
+          if (vertical)
+            {
+              part->rect.y = cursor;
+              part->rect.height = covered->start - cursor;
+            }
+          else
+            {
+              part->rect.x = cursor;
+              part->rect.width = covered->start - cursor;
+            }
+          edges = g_list_prepend (edges, part);
+        }
+
+      cursor = MAX (cursor, covered->end);
+    }
+
+  if (cursor < end)
+    {
+      MetaEdge *part = g_new (MetaEdge, 1);
+
+      *part = *edge;
+      if (vertical)
+        {
+          part->rect.y = cursor;
+          part->rect.height = end - cursor;
+        }
+      else
+        {
+          part->rect.x = cursor;
+          part->rect.width = end - cursor;
+        }
+      edges = g_list_prepend (edges, part);
+    }
+
+  return edges;
+}
+
+/**
+ * meta_rectangle_stack_add_window_edges: (skip)
+ *
+ * Adds the edges of the rectangle at the given index, clipped to clip and
+ * with the parts obscured by any rectangle stacked above it removed, to
+ * edges.  The edges are of type META_EDGE_WINDOW and their side type is
+ * what the opposite side of a window being moved should snap to, same as
+ * the edges built in edge-resistance.c.
+ *
+ * Obscuring rectangles are looked up with an interval tree, so building the
+ * edges of all n rectangles in a stack is O(n log n) for typical layouts,
+ * instead of the quadratic splitting done by
+ * meta_rectangle_remove_intersections_with_boxes_from_edges().
+ */
+GList *
+meta_rectangle_stack_add_window_edges (MetaRectangleStack *stack,
+                                       int                 index,
+                                       const MtkRectangle *clip,
+                                       GList              *edges)
+{
+  g_autoptr (GArray) indices = NULL;
+  g_autoptr (GArray) intervals = NULL;
+  MtkRectangle reduced;
+  MetaEdge edge;
+
+  g_return_val_if_fail (index >= 0 && index < (int) stack->rects->len, edges);
+
+  /* We don't care about snapping to any portion of the window that is
+   * offscreen.
+   */
+  if (!mtk_rectangle_intersect (&g_array_index (stack->rects, MtkRectangle,
+                                                index),
+                                clip,
+                                &reduced))
+    return edges;
+
+  ensure_spans (stack);
+
+  indices = g_array_new (FALSE, FALSE, sizeof (int));
+  intervals = g_array_new (FALSE, FALSE, sizeof (CoveredInterval));
+
+  edge.edge_type = META_EDGE_WINDOW;
+
+  /* Left side of this window is resistance for the right edge of the window
+   * being moved.
+   */
+  edge.rect = reduced;
+  edge.rect.width = 0;
+  edge.side_type = META_SIDE_RIGHT;
+  edges = add_unobscured_edge_parts (stack, index, &edge,
+                                     indices, intervals, edges);
+
+  /* Right side of this window is resistance for the left edge of the window
+   * being moved.
+   */
+  edge.rect = reduced;
+  edge.rect.x += edge.rect.width;
+  edge.rect.width = 0;
+  edge.side_type = META_SIDE_LEFT;
+  edges = add_unobscured_edge_parts (stack, index, &edge,
+                                     indices, intervals, edges);
+
+  /* Top side of this window is resistance for the bottom edge of the window
+   * being moved.
+   */
+  edge.rect = reduced;
+  edge.rect.height = 0;
+  edge.side_type = META_SIDE_BOTTOM;
+  edges = add_unobscured_edge_parts (stack, index, &edge,
+                                     indices, intervals, edges);
+
+  /* Bottom side of this window is resistance for the top edge of the window
+   * being moved.
+   */
+  edge.rect = reduced;
+  edge.rect.y += edge.rect.height;
+  edge.rect.height = 0;
+  edge.side_type = META_SIDE_TOP;
+  edges = add_unobscured_edge_parts (stack, index, &edge,
+                                     indices, intervals, edges);
+
+  return edges;
+}
+
 /**
  * meta_rectangle_find_onscreen_edges: (skip)
  *
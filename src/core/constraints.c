@@ -148,16 +148,16 @@ typedef struct
   /* Spanning rectangles for the non-covered (by struts) region of the
    * screen and also for just the current monitor
    */
-  GList  *usable_screen_region;
-  GList  *usable_monitor_region;
+  MetaSpanningRegion *usable_screen_region;
+  MetaSpanningRegion *usable_monitor_region;
 
   MetaMoveResizeFlags  flags;
 } ConstraintInfo;
 
-static gboolean do_screen_and_monitor_relative_constraints (MetaWindow     *window,
-                                                            GList          *region_spanning_rectangles,
-                                                            ConstraintInfo *info,
-                                                            gboolean        check_only);
+static gboolean do_screen_and_monitor_relative_constraints (MetaWindow               *window,
+                                                            const MetaSpanningRegion *region,
+                                                            ConstraintInfo           *info,
+                                                            gboolean                  check_only);
 static gboolean constrain_custom_rule        (MetaWindow         *window,
                                               ConstraintInfo     *info,
                                               ConstraintPriority  priority,
@@ -684,7 +684,7 @@ update_onscreen_requirements (MetaWindow     *window,
    */
   old = window->require_fully_onscreen;
   window->require_fully_onscreen =
-    meta_rectangle_contained_in_region (info->usable_screen_region,
+    meta_spanning_region_contains_rect (info->usable_screen_region,
                                         &info->current);
   if (old != window->require_fully_onscreen)
     meta_topic (META_DEBUG_GEOMETRY,
@@ -697,7 +697,7 @@ update_onscreen_requirements (MetaWindow     *window,
    */
   old = window->require_on_single_monitor;
   window->require_on_single_monitor =
-    meta_rectangle_contained_in_region (info->usable_monitor_region,
+    meta_spanning_region_contains_rect (info->usable_monitor_region,
                                         &info->current);
   if (old != window->require_on_single_monitor)
     meta_topic (META_DEBUG_GEOMETRY,
@@ -721,8 +721,8 @@ update_onscreen_requirements (MetaWindow     *window,
 
       old = window->require_titlebar_visible;
       window->require_titlebar_visible =
-        meta_rectangle_overlaps_with_region (info->usable_screen_region,
-                                             &titlebar_rect);
+        meta_spanning_region_overlaps_rect (info->usable_screen_region,
+                                            &titlebar_rect);
       if (old != window->require_titlebar_visible)
         meta_topic (META_DEBUG_GEOMETRY,
                     "require_titlebar_visible for %s toggled to %s",
@@ -1227,13 +1227,14 @@ constrain_maximization (MetaWindow         *window,
        * by that partial strut.
        */
       MetaDirection  direction;
-      GSList        *active_workspace_struts;
+      const GSList  *active_workspace_struts;
 
       if (window->maximized_horizontally)
         direction = META_DIRECTION_HORIZONTAL;
       else
         direction = META_DIRECTION_VERTICAL;
-      active_workspace_struts = workspace_manager->active_workspace->all_struts;
+      active_workspace_struts =
+        meta_workspace_get_all_struts (workspace_manager->active_workspace);
 
       target_size = info->current;
       meta_rectangle_expand_to_avoiding_struts (&target_size,
@@ -1629,10 +1630,10 @@ constrain_aspect_ratio (MetaWindow         *window,
 
 static gboolean
 do_screen_and_monitor_relative_constraints (
-  MetaWindow     *window,
-  GList          *region_spanning_rectangles,
-  ConstraintInfo *info,
-  gboolean        check_only)
+  MetaWindow               *window,
+  const MetaSpanningRegion *region,
+  ConstraintInfo           *info,
+  gboolean                  check_only)
 {
   gboolean exit_early = FALSE, constraint_satisfied;
   MtkRectangle how_far_it_can_be_smushed, min_size, max_size;
@@ -1641,12 +1642,12 @@ do_screen_and_monitor_relative_constraints (
   if (meta_is_verbose ())
     {
       /* First, log some debugging information */
-      char spanning_region[1 + 28 * g_list_length (region_spanning_rectangles)];
+      char spanning_region[1 + 28 * region->n_rects];
 
       meta_topic (META_DEBUG_GEOMETRY,
                   "screen/monitor constraint; region_spanning_rectangles: %s",
-                  meta_rectangle_region_to_string (region_spanning_rectangles, ", ",
-                                                   spanning_region));
+                  meta_spanning_region_to_string (region, ", ",
+                                                  spanning_region));
     }
 #endif
 
@@ -1662,14 +1663,13 @@ do_screen_and_monitor_relative_constraints (
       if (!(info->fixed_directions & FIXED_DIRECTION_Y))
         how_far_it_can_be_smushed.height = min_size.height;
     }
-  if (!meta_rectangle_could_fit_in_region (region_spanning_rectangles,
-                                           &how_far_it_can_be_smushed))
+  if (!meta_spanning_region_could_fit_rect (region,
+                                            &how_far_it_can_be_smushed))
     exit_early = TRUE;
 
   /* Determine whether constraint is already satisfied; exit if it is */
   constraint_satisfied =
-    meta_rectangle_contained_in_region (region_spanning_rectangles,
-                                        &info->current);
+    meta_spanning_region_contains_rect (region, &info->current);
   if (exit_early || constraint_satisfied || check_only)
     return constraint_satisfied;
 
@@ -1677,21 +1677,21 @@ do_screen_and_monitor_relative_constraints (
 
   /* Clamp rectangle size for resize or move+resize actions */
   if (info->action_type != ACTION_MOVE)
-    meta_rectangle_clamp_to_fit_into_region (region_spanning_rectangles,
-                                             info->fixed_directions,
-                                             &info->current,
-                                             &min_size);
+    meta_spanning_region_clamp_to_fit (region,
+                                       info->fixed_directions,
+                                       &info->current,
+                                       &min_size);
 
   if (info->is_user_action && info->action_type == ACTION_RESIZE)
     /* For user resize, clip to the relevant region */
-    meta_rectangle_clip_to_region (region_spanning_rectangles,
-                                   info->fixed_directions,
-                                   &info->current);
+    meta_spanning_region_clip (region,
+                               info->fixed_directions,
+                               &info->current);
   else
     /* For everything else, shove the rectangle into the relevant region */
-    meta_rectangle_shove_into_region (region_spanning_rectangles,
-                                      info->fixed_directions,
-                                      &info->current);
+    meta_spanning_region_shove (region,
+                                info->fixed_directions,
+                                &info->current);
 
   return TRUE;
 }
@@ -1770,6 +1770,7 @@ constrain_titlebar_visible (MetaWindow         *window,
   int horiz_amount_offscreen, vert_amount_offscreen;
   int horiz_amount_onscreen,  vert_amount_onscreen;
   MetaWindowDrag *window_drag;
+  g_autoptr (MetaSpanningRegion) expanded_region = NULL;
 
   if (priority > PRIORITY_TITLEBAR_VISIBLE)
     return TRUE;
@@ -1840,28 +1841,20 @@ constrain_titlebar_visible (MetaWindow         *window,
   else
     bottom_amount = vert_amount_offscreen;
 
-  /* Extend the region, have a helper function handle the constraint,
-   * then return the region to its original size.
-   */
-  meta_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              horiz_amount_offscreen,
-                                              horiz_amount_offscreen,
-                                              0, /* Don't let titlebar off */
-                                              bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  /* Extend the region and have a helper function handle the constraint */
+  expanded_region =
+    meta_spanning_region_copy_expanded (info->usable_screen_region,
+                                        horiz_amount_offscreen,
+                                        horiz_amount_offscreen,
+                                        0, /* Don't let titlebar off */
+                                        bottom_amount,
+                                        horiz_amount_onscreen,
+                                        vert_amount_onscreen);
   retval =
     do_screen_and_monitor_relative_constraints (window,
-                                                info->usable_screen_region,
+                                                expanded_region,
                                                 info,
                                                 check_only);
-  meta_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              -horiz_amount_offscreen,
-                                              -horiz_amount_offscreen,
-                                              0, /* Don't let titlebar off */
-                                              -bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
 
   return retval;
 }
@@ -1876,6 +1869,7 @@ constrain_partially_onscreen (MetaWindow         *window,
   int top_amount, bottom_amount;
   int horiz_amount_offscreen, vert_amount_offscreen;
   int horiz_amount_onscreen,  vert_amount_onscreen;
+  g_autoptr (MetaSpanningRegion) expanded_region = NULL;
 
   if (priority > PRIORITY_PARTIALLY_VISIBLE_ON_WORKAREA)
     return TRUE;
@@ -1919,28 +1913,20 @@ constrain_partially_onscreen (MetaWindow         *window,
   else
     bottom_amount = vert_amount_offscreen;
 
-  /* Extend the region, have a helper function handle the constraint,
-   * then return the region to its original size.
-   */
-  meta_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              horiz_amount_offscreen,
-                                              horiz_amount_offscreen,
-                                              top_amount,
-                                              bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  /* Extend the region and have a helper function handle the constraint */
+  expanded_region =
+    meta_spanning_region_copy_expanded (info->usable_screen_region,
+                                        horiz_amount_offscreen,
+                                        horiz_amount_offscreen,
+                                        top_amount,
+                                        bottom_amount,
+                                        horiz_amount_onscreen,
+                                        vert_amount_onscreen);
   retval =
     do_screen_and_monitor_relative_constraints (window,
-                                                info->usable_screen_region,
+                                                expanded_region,
                                                 info,
                                                 check_only);
-  meta_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              -horiz_amount_offscreen,
-                                              -horiz_amount_offscreen,
-                                              -top_amount,
-                                              -bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
 
   return retval;
 }
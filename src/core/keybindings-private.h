@@ -97,14 +97,45 @@ typedef struct _MetaKeyBindingKeyboardLayout
   struct xkb_keymap *keymap;
   xkb_layout_index_t index;
   xkb_level_index_t n_levels;
+
+  /* Maps keysyms to the keycodes producing them on the lowest level */
+  GHashTable *keysym_keycodes;
+  gboolean needs_secondary_layout;
 } MetaKeyBindingKeyboardLayout;
 
+typedef enum
+{
+  META_SPECIAL_KEY_OVERLAY = 1 << 0,
+  META_SPECIAL_KEY_LOCATE_POINTER = 1 << 1,
+  META_SPECIAL_KEY_ISO_NEXT_GROUP = 1 << 2,
+} MetaSpecialKeyFlags;
+
+typedef struct _MetaKeyBindingDispatchEntry
+{
+  xkb_mod_mask_t mask;
+  MetaKeyBinding *binding;
+} MetaKeyBindingDispatchEntry;
+
+typedef struct _MetaKeyBindingDispatchSlot
+{
+  MetaKeyBindingDispatchEntry *entries;
+  unsigned int n_entries;
+  MetaSpecialKeyFlags special_keys;
+} MetaKeyBindingDispatchSlot;
+
 typedef struct
 {
   MetaBackend *backend;
 
   GHashTable *key_bindings;
-  GHashTable *key_bindings_index;
+
+  /*
+   * Indexed by keycode, each slot holds the bindings for the modifier
+   * masks used with that keycode.
+   */
+  MetaKeyBindingDispatchSlot *dispatch_table;
+  unsigned int dispatch_table_size;
+
   xkb_mod_mask_t ignored_modifier_mask;
   xkb_mod_mask_t hyper_mask;
   xkb_mod_mask_t virtual_hyper_mask;
@@ -125,7 +156,15 @@ typedef struct
    * A primary layout, and an optional secondary layout for when the
    * primary layout does not use the latin alphabet.
    */
-  MetaKeyBindingKeyboardLayout active_layouts[2];
+  MetaKeyBindingKeyboardLayout *active_layouts[2];
+
+  /*
+   * The layouts of the current keymap that have been active, indexed by
+   * layout index, so switching between them doesn't walk the keymap.
+   */
+  struct xkb_keymap *layouts_keymap;
+  GPtrArray *layouts;
+  MetaKeyBindingKeyboardLayout *us_layout;
 
   /* Alt+click button grabs */
   ClutterModifierType window_grab_modifiers;
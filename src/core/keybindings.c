@@ -107,19 +107,6 @@ resolved_key_combo_has_keycode (MetaResolvedKeyCombo *resolved_combo,
   return FALSE;
 }
 
-static gboolean
-resolved_key_combo_intersect (MetaResolvedKeyCombo *a,
-                              MetaResolvedKeyCombo *b)
-{
-  int i;
-
-  for (i = 0; i < a->len; i++)
-    if (resolved_key_combo_has_keycode (b, a->keycodes[i]))
-      return TRUE;
-
-  return FALSE;
-}
-
 static void
 meta_key_binding_free (MetaKeyBinding *binding)
 {
@@ -229,20 +216,117 @@ meta_key_grab_free (MetaKeyGrab *grab)
   g_free (grab);
 }
 
-static guint32
-key_combo_key (MetaResolvedKeyCombo *resolved_combo,
-               int                   i)
+static xkb_mod_mask_t
+dispatch_mask (xkb_mod_mask_t mask)
+{
+  /* The bits that mutter cares about in the modifier mask are all in
+     the lower 8 bits both on X and clutter key events. */
+  return mask & 0xffff;
+}
+
+static MetaKeyBindingDispatchSlot *
+get_dispatch_slot (MetaKeyBindingManager *keys,
+                   xkb_keycode_t          keycode)
+{
+  if (keycode >= keys->dispatch_table_size)
+    return NULL;
+
+  return &keys->dispatch_table[keycode];
+}
+
+static MetaKeyBindingDispatchSlot *
+ensure_dispatch_slot (MetaKeyBindingManager *keys,
+                      xkb_keycode_t          keycode)
+{
+  if (keycode >= keys->dispatch_table_size)
+    {
+      unsigned int old_size = keys->dispatch_table_size;
+      unsigned int new_size;
+
+      /* XKB keymaps rarely go beyond 8 bit keycodes, so this only grows
+       * once in practice */
+      new_size = MAX (MAX (old_size * 2, 256), keycode + 1);
+      keys->dispatch_table = g_renew (MetaKeyBindingDispatchSlot,
+                                      keys->dispatch_table,
+                                      new_size);
+      memset (&keys->dispatch_table[old_size], 0,
+              (new_size - old_size) * sizeof (MetaKeyBindingDispatchSlot));
+      keys->dispatch_table_size = new_size;
+    }
+
+  return &keys->dispatch_table[keycode];
+}
+
+static MetaKeyBindingDispatchEntry *
+dispatch_slot_lookup (MetaKeyBindingDispatchSlot *slot,
+                      xkb_mod_mask_t              mask)
+{
+  unsigned int i;
+
+  for (i = 0; i < slot->n_entries; i++)
+    {
+      if (slot->entries[i].mask == mask)
+        return &slot->entries[i];
+    }
+
+  return NULL;
+}
+
+static void
+clear_dispatch_table (MetaKeyBindingManager *keys)
 {
-  /* On X, keycodes are only 8 bits while libxkbcommon supports 32 bit
-     keycodes, but since we're using the same XKB keymaps that X uses,
-     we won't find keycodes bigger than 8 bits in practice. The bits
-     that mutter cares about in the modifier mask are also all in the
-     lower 8 bits both on X and clutter key events. This means that we
-     can use a 32 bit integer to safely concatenate both keycode and
-     mask and thus making it easy to use them as an index in a
-     GHashTable. */
-  guint32 key = resolved_combo->keycodes[i] & 0xffff;
-  return (key << 16) | (resolved_combo->mask & 0xffff);
+  unsigned int i;
+
+  for (i = 0; i < keys->dispatch_table_size; i++)
+    {
+      MetaKeyBindingDispatchSlot *slot = &keys->dispatch_table[i];
+
+      g_clear_pointer (&slot->entries, g_free);
+      slot->n_entries = 0;
+      slot->special_keys = 0;
+    }
+}
+
+static void
+mark_special_keys (MetaKeyBindingManager *keys,
+                   MetaResolvedKeyCombo  *resolved_combo,
+                   MetaSpecialKeyFlags    flag)
+{
+  int i;
+
+  for (i = 0; i < resolved_combo->len; i++)
+    {
+      MetaKeyBindingDispatchSlot *slot;
+
+      slot = ensure_dispatch_slot (keys, resolved_combo->keycodes[i]);
+      slot->special_keys |= flag;
+    }
+}
+
+static gboolean
+is_special_key (MetaKeyBindingManager *keys,
+                xkb_keycode_t          keycode,
+                MetaSpecialKeyFlags    flag)
+{
+  MetaKeyBindingDispatchSlot *slot = get_dispatch_slot (keys, keycode);
+
+  return slot && (slot->special_keys & flag);
+}
+
+static gboolean
+resolved_key_combo_has_special_key (MetaKeyBindingManager *keys,
+                                    MetaResolvedKeyCombo  *resolved_combo,
+                                    MetaSpecialKeyFlags    flag)
+{
+  int i;
+
+  for (i = 0; i < resolved_combo->len; i++)
+    {
+      if (is_special_key (keys, resolved_combo->keycodes[i], flag))
+        return TRUE;
+    }
+
+  return FALSE;
 }
 
 static void
@@ -301,86 +385,6 @@ reload_modmap (MetaKeyBindingManager *keys)
               keys->meta_mask);
 }
 
-static gboolean
-is_keycode_for_keysym (struct xkb_keymap *keymap,
-                       xkb_layout_index_t layout,
-                       xkb_level_index_t  level,
-                       xkb_keycode_t      keycode,
-                       xkb_keysym_t       keysym)
-{
-  const xkb_keysym_t *syms;
-  int num_syms, k;
-
-  num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode, layout, level, &syms);
-  for (k = 0; k < num_syms; k++)
-    {
-      if (syms[k] == keysym)
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
-typedef struct
-{
-  GArray *keycodes;
-  xkb_keysym_t keysym;
-  xkb_layout_index_t layout;
-  xkb_level_index_t level;
-} FindKeysymData;
-
-static void
-get_keycodes_for_keysym_iter (struct xkb_keymap *keymap,
-                              xkb_keycode_t      keycode,
-                              void              *data)
-{
-  FindKeysymData *search_data = data;
-  GArray *keycodes = search_data->keycodes;
-  xkb_keysym_t keysym = search_data->keysym;
-  xkb_layout_index_t layout = search_data->layout;
-  xkb_level_index_t level = search_data->level;
-
-  if (is_keycode_for_keysym (keymap, layout, level, keycode, keysym))
-    {
-      guint i;
-      gboolean missing = TRUE;
-
-      /* duplicate keycode detection */
-      for (i = 0; i < keycodes->len; i++)
-        if (g_array_index (keycodes, xkb_keysym_t, i) == keycode)
-          {
-            missing = FALSE;
-            break;
-          }
-
-      if (missing)
-        g_array_append_val (keycodes, keycode);
-    }
-}
-
-static void
-add_keysym_keycodes_from_layout (int                           keysym,
-                                 MetaKeyBindingKeyboardLayout *layout,
-                                 GArray                       *keycodes)
-{
-  xkb_level_index_t layout_level;
-
-  for (layout_level = 0;
-       layout_level < layout->n_levels && keycodes->len == 0;
-       layout_level++)
-    {
-      FindKeysymData search_data = (FindKeysymData) {
-        .keycodes = keycodes,
-        .keysym = keysym,
-        .layout = layout->index,
-        .level = layout_level
-      };
-      xkb_keymap_key_for_each (layout->keymap,
-                               get_keycodes_for_keysym_iter,
-                               &search_data);
-    }
-}
-
 /* Original code from gdk_x11_keymap_get_entries_for_keyval() in
  * gdkkeys-x11.c */
 static void
@@ -402,14 +406,25 @@ get_keycodes_for_keysym (MetaKeyBindingManager  *keys,
       goto out;
     }
 
+  /* The secondary layout is only used for keysyms the primary layout
+   * doesn't have */
   for (i = 0; i < G_N_ELEMENTS (keys->active_layouts); i++)
     {
-      MetaKeyBindingKeyboardLayout *layout = &keys->active_layouts[i];
+      MetaKeyBindingKeyboardLayout *layout = keys->active_layouts[i];
+      GArray *layout_keycodes;
 
-      if (!layout->keymap)
+      if (!layout)
         continue;
 
-      add_keysym_keycodes_from_layout (keysym, layout, keycodes);
+      layout_keycodes = g_hash_table_lookup (layout->keysym_keycodes,
+                                             GUINT_TO_POINTER (keysym));
+      if (layout_keycodes)
+        {
+          g_array_append_vals (keycodes,
+                               layout_keycodes->data,
+                               layout_keycodes->len);
+          break;
+        }
     }
 
  out:
@@ -575,17 +590,16 @@ static void
 index_binding (MetaKeyBindingManager *keys,
                MetaKeyBinding         *binding)
 {
+  xkb_mod_mask_t mask = dispatch_mask (binding->resolved_combo.mask);
   int i;
 
   for (i = 0; i < binding->resolved_combo.len; i++)
     {
-      MetaKeyBinding *existing;
-      guint32 index_key;
-
-      index_key = key_combo_key (&binding->resolved_combo, i);
+      MetaKeyBindingDispatchSlot *slot;
+      MetaKeyBindingDispatchEntry *existing;
 
-      existing = g_hash_table_lookup (keys->key_bindings_index,
-                                      GINT_TO_POINTER (index_key));
+      slot = ensure_dispatch_slot (keys, binding->resolved_combo.keycodes[i]);
+      existing = dispatch_slot_lookup (slot, mask);
       if (existing != NULL)
         {
           /* Overwrite already indexed keycodes only for the first
@@ -597,12 +611,44 @@ index_binding (MetaKeyBindingManager *keys,
           meta_warning ("Overwriting existing binding of keysym %x"
                         " with keysym %x (keycode %x).",
                         binding->combo.keysym,
-                        existing->combo.keysym,
+                        existing->binding->combo.keysym,
                         binding->resolved_combo.keycodes[i]);
+
+          existing->binding = binding;
+          continue;
         }
 
-      g_hash_table_replace (keys->key_bindings_index,
-                            GINT_TO_POINTER (index_key), binding);
+      slot->entries = g_renew (MetaKeyBindingDispatchEntry,
+                               slot->entries,
+                               slot->n_entries + 1);
+      slot->entries[slot->n_entries++] = (MetaKeyBindingDispatchEntry) {
+        .mask = mask,
+        .binding = binding,
+      };
+    }
+}
+
+static void
+unindex_binding (MetaKeyBindingManager *keys,
+                 MetaKeyBinding         *binding)
+{
+  xkb_mod_mask_t mask = dispatch_mask (binding->resolved_combo.mask);
+  int i;
+
+  for (i = 0; i < binding->resolved_combo.len; i++)
+    {
+      MetaKeyBindingDispatchSlot *slot;
+      MetaKeyBindingDispatchEntry *entry;
+
+      slot = get_dispatch_slot (keys, binding->resolved_combo.keycodes[i]);
+      if (!slot)
+        continue;
+
+      entry = dispatch_slot_lookup (slot, mask);
+      if (!entry)
+        continue;
+
+      *entry = slot->entries[--slot->n_entries];
     }
 }
 
@@ -640,106 +686,162 @@ binding_reload_combos_foreach (gpointer key,
   index_binding (keys, binding);
 }
 
-typedef struct _FindLatinKeysymsState
+typedef struct _IndexKeysymsState
 {
   MetaKeyBindingKeyboardLayout *layout;
-  gboolean *required_keysyms_found;
-  int n_required_keysyms;
-} FindLatinKeysymsState;
+  GHashTable *keysym_levels;
+} IndexKeysymsState;
 
 static void
-find_latin_keysym (struct xkb_keymap *keymap,
-                   xkb_keycode_t      key,
-                   void              *data)
+index_keysym_keycode (IndexKeysymsState *state,
+                      xkb_keysym_t       keysym,
+                      xkb_level_index_t  level,
+                      xkb_keycode_t      keycode)
 {
-  FindLatinKeysymsState *state = data;
-  int n_keysyms, i;
-  const xkb_keysym_t *keysyms;
+  MetaKeyBindingKeyboardLayout *layout = state->layout;
+  GArray *keycodes;
+  gpointer keysym_level;
 
-  n_keysyms = xkb_keymap_key_get_syms_by_level (state->layout->keymap,
-                                                key,
-                                                state->layout->index,
-                                                0,
-                                                &keysyms);
-  for (i = 0; i < n_keysyms; i++)
+  keycodes = g_hash_table_lookup (layout->keysym_keycodes,
+                                  GUINT_TO_POINTER (keysym));
+  if (!keycodes)
+    {
+      keycodes = g_array_new (FALSE, FALSE, sizeof (xkb_keycode_t));
+      g_hash_table_insert (layout->keysym_keycodes,
+                           GUINT_TO_POINTER (keysym), keycodes);
+      g_hash_table_insert (state->keysym_levels,
+                           GUINT_TO_POINTER (keysym),
+                           GUINT_TO_POINTER (level));
+    }
+  else
     {
-      xkb_keysym_t keysym = keysyms[i];
+      keysym_level = g_hash_table_lookup (state->keysym_levels,
+                                          GUINT_TO_POINTER (keysym));
 
-      if (keysym >= XKB_KEY_a && keysym <= XKB_KEY_z)
-        {
-          unsigned int keysym_index = keysym - XKB_KEY_a;
+      /* Only the keycodes of the lowest level the keysym is found on
+       * are used */
+      if (level > GPOINTER_TO_UINT (keysym_level))
+        return;
 
-          if (!state->required_keysyms_found[keysym_index])
-            {
-              state->required_keysyms_found[keysym_index] = TRUE;
-              state->n_required_keysyms--;
-            }
+      if (level < GPOINTER_TO_UINT (keysym_level))
+        {
+          g_array_set_size (keycodes, 0);
+          g_hash_table_insert (state->keysym_levels,
+                               GUINT_TO_POINTER (keysym),
+                               GUINT_TO_POINTER (level));
         }
     }
+
+  /* Keys are visited in order, so duplicates can only be the last one */
+  if (keycodes->len > 0 &&
+      g_array_index (keycodes, xkb_keycode_t, keycodes->len - 1) == keycode)
+    return;
+
+  g_array_append_val (keycodes, keycode);
+}
+
+static void
+index_keysyms_iter (struct xkb_keymap *keymap,
+                    xkb_keycode_t      keycode,
+                    void              *data)
+{
+  IndexKeysymsState *state = data;
+  MetaKeyBindingKeyboardLayout *layout = state->layout;
+  xkb_level_index_t level;
+
+  for (level = 0; level < layout->n_levels; level++)
+    {
+      const xkb_keysym_t *keysyms;
+      int n_keysyms, i;
+
+      n_keysyms = xkb_keymap_key_get_syms_by_level (keymap,
+                                                    keycode,
+                                                    layout->index,
+                                                    level,
+                                                    &keysyms);
+      for (i = 0; i < n_keysyms; i++)
+        index_keysym_keycode (state, keysyms[i], level, keycode);
+    }
 }
 
 static gboolean
-needs_secondary_layout (MetaKeyBindingKeyboardLayout *layout)
-{
-  gboolean required_keysyms_found[] = {
-    FALSE, /* XKB_KEY_a */
-    FALSE, /* XKB_KEY_b */
-    FALSE, /* XKB_KEY_c */
-    FALSE, /* XKB_KEY_d */
-    FALSE, /* XKB_KEY_e */
-    FALSE, /* XKB_KEY_f */
-    FALSE, /* XKB_KEY_g */
-    FALSE, /* XKB_KEY_h */
-    FALSE, /* XKB_KEY_i */
-    FALSE, /* XKB_KEY_j */
-    FALSE, /* XKB_KEY_k */
-    FALSE, /* XKB_KEY_l */
-    FALSE, /* XKB_KEY_m */
-    FALSE, /* XKB_KEY_n */
-    FALSE, /* XKB_KEY_o */
-    FALSE, /* XKB_KEY_p */
-    FALSE, /* XKB_KEY_q */
-    FALSE, /* XKB_KEY_r */
-    FALSE, /* XKB_KEY_s */
-    FALSE, /* XKB_KEY_t */
-    FALSE, /* XKB_KEY_u */
-    FALSE, /* XKB_KEY_v */
-    FALSE, /* XKB_KEY_w */
-    FALSE, /* XKB_KEY_x */
-    FALSE, /* XKB_KEY_y */
-    FALSE, /* XKB_KEY_z */
-  };
-  FindLatinKeysymsState state = {
+needs_secondary_layout (GHashTable *keysym_levels)
+{
+  xkb_keysym_t keysym;
+
+  /* Every latin letter has to be on the first level */
+  for (keysym = XKB_KEY_a; keysym <= XKB_KEY_z; keysym++)
+    {
+      gpointer level;
+
+      if (!g_hash_table_lookup_extended (keysym_levels,
+                                         GUINT_TO_POINTER (keysym),
+                                         NULL, &level) ||
+          GPOINTER_TO_UINT (level) != 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+meta_key_binding_keyboard_layout_free (MetaKeyBindingKeyboardLayout *layout)
+{
+  g_clear_pointer (&layout->keymap, xkb_keymap_unref);
+  g_clear_pointer (&layout->keysym_keycodes, g_hash_table_destroy);
+  g_free (layout);
+}
+
+static MetaKeyBindingKeyboardLayout *
+meta_key_binding_keyboard_layout_new (struct xkb_keymap  *keymap,
+                                      xkb_layout_index_t  layout_index)
+{
+  MetaKeyBindingKeyboardLayout *layout;
+  g_autoptr (GHashTable) keysym_levels = NULL;
+  IndexKeysymsState state;
+
+  COGL_TRACE_BEGIN_SCOPED (IndexLayout,
+                           "Meta::KeyBindings::index_layout()");
+
+  layout = g_new0 (MetaKeyBindingKeyboardLayout, 1);
+  layout->keymap = xkb_keymap_ref (keymap);
+  layout->index = layout_index;
+  layout->n_levels = calculate_n_layout_levels (keymap, layout_index);
+  layout->keysym_keycodes =
+    g_hash_table_new_full (NULL, NULL,
+                           NULL, (GDestroyNotify) g_array_unref);
+
+  /* Walk the keymap once, rather than once per resolved binding */
+  keysym_levels = g_hash_table_new (NULL, NULL);
+  state = (IndexKeysymsState) {
     .layout = layout,
-    .required_keysyms_found = required_keysyms_found,
-    .n_required_keysyms = G_N_ELEMENTS (required_keysyms_found),
+    .keysym_levels = keysym_levels,
   };
+  xkb_keymap_key_for_each (keymap, index_keysyms_iter, &state);
 
-  xkb_keymap_key_for_each (layout->keymap, find_latin_keysym, &state);
+  layout->needs_secondary_layout =
+    needs_secondary_layout (keysym_levels);
 
-  return state.n_required_keysyms != 0;
+  return layout;
 }
 
 static void
-clear_active_keyboard_layouts (MetaKeyBindingManager *keys)
+clear_keyboard_layouts (MetaKeyBindingManager *keys)
 {
-  unsigned int i;
-
-  for (i = 0; i < G_N_ELEMENTS (keys->active_layouts); i++)
-    {
-      MetaKeyBindingKeyboardLayout *layout = &keys->active_layouts[i];
+  keys->active_layouts[META_KEY_BINDING_PRIMARY_LAYOUT] = NULL;
+  keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = NULL;
 
-      g_clear_pointer (&layout->keymap, xkb_keymap_unref);
-      *layout = (MetaKeyBindingKeyboardLayout) { 0 };
-    }
+  g_clear_pointer (&keys->layouts, g_ptr_array_unref);
+  g_clear_pointer (&keys->layouts_keymap, xkb_keymap_unref);
 }
 
-static MetaKeyBindingKeyboardLayout
+static MetaKeyBindingKeyboardLayout *
 create_us_layout (void)
 {
   struct xkb_rule_names names;
   struct xkb_keymap *keymap;
   struct xkb_context *context;
+  MetaKeyBindingKeyboardLayout *layout;
 
   names.rules = DEFAULT_XKB_RULES_FILE;
   names.model = DEFAULT_XKB_MODEL;
@@ -751,10 +853,10 @@ create_us_layout (void)
   keymap = xkb_keymap_new_from_names (context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
   xkb_context_unref (context);
 
-  return (MetaKeyBindingKeyboardLayout) {
-    .keymap = keymap,
-    .n_levels = calculate_n_layout_levels (keymap, 0),
-  };
+  layout = meta_key_binding_keyboard_layout_new (keymap, 0);
+  xkb_keymap_unref (keymap);
+
+  return layout;
 }
 
 static void
@@ -762,33 +864,53 @@ reload_active_keyboard_layouts (MetaKeyBindingManager *keys)
 {
   struct xkb_keymap *keymap;
   xkb_layout_index_t layout_index;
-  MetaKeyBindingKeyboardLayout primary_layout;
-
-  clear_active_keyboard_layouts (keys);
+  MetaKeyBindingKeyboardLayout *primary_layout;
 
   keymap = meta_backend_get_keymap (keys->backend);
   layout_index = meta_backend_get_keymap_layout_group (keys->backend);
-  primary_layout = (MetaKeyBindingKeyboardLayout) {
-    .keymap = xkb_keymap_ref (keymap),
-    .index = layout_index,
-    .n_levels = calculate_n_layout_levels (keymap, layout_index),
-  };
+
+  /* Layouts are kept around until the keymap itself changes */
+  if (keys->layouts_keymap != keymap)
+    {
+      clear_keyboard_layouts (keys);
+
+      keys->layouts_keymap = xkb_keymap_ref (keymap);
+      keys->layouts =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) meta_key_binding_keyboard_layout_free);
+    }
+
+  if (layout_index >= keys->layouts->len)
+    g_ptr_array_set_size (keys->layouts, layout_index + 1);
+
+  primary_layout = g_ptr_array_index (keys->layouts, layout_index);
+  if (!primary_layout)
+    {
+      primary_layout = meta_key_binding_keyboard_layout_new (keymap,
+                                                             layout_index);
+      g_ptr_array_index (keys->layouts, layout_index) = primary_layout;
+    }
 
   keys->active_layouts[META_KEY_BINDING_PRIMARY_LAYOUT] = primary_layout;
+  keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = NULL;
 
-  if (needs_secondary_layout (&primary_layout))
+  if (primary_layout->needs_secondary_layout)
     {
-      MetaKeyBindingKeyboardLayout us_layout;
+      if (!keys->us_layout)
+        keys->us_layout = create_us_layout ();
 
-      us_layout = create_us_layout ();
-      keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = us_layout;
+      keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = keys->us_layout;
     }
 }
 
 static void
 reload_combos (MetaKeyBindingManager *keys)
 {
-  g_hash_table_remove_all (keys->key_bindings_index);
+  int i;
+
+  COGL_TRACE_BEGIN_SCOPED (ReloadCombos,
+                           "Meta::KeyBindings::reload_combos()");
+
+  clear_dispatch_table (keys);
 
   reload_active_keyboard_layouts (keys);
 
@@ -802,6 +924,19 @@ reload_combos (MetaKeyBindingManager *keys)
 
   reload_iso_next_group_combos (keys);
 
+  mark_special_keys (keys,
+                     &keys->overlay_resolved_key_combo,
+                     META_SPECIAL_KEY_OVERLAY);
+  mark_special_keys (keys,
+                     &keys->locate_pointer_resolved_key_combo,
+                     META_SPECIAL_KEY_LOCATE_POINTER);
+  for (i = 0; i < keys->n_iso_next_group_combos; i++)
+    {
+      mark_special_keys (keys,
+                         &keys->iso_next_group_combo[i],
+                         META_SPECIAL_KEY_ISO_NEXT_GROUP);
+    }
+
   g_hash_table_foreach (keys->key_bindings, binding_reload_combos_foreach, keys);
 }
 
@@ -937,15 +1072,20 @@ get_keybinding (MetaKeyBindingManager *keys,
                 MetaResolvedKeyCombo  *resolved_combo)
 {
   MetaKeyBinding *binding = NULL;
+  xkb_mod_mask_t mask = dispatch_mask (resolved_combo->mask);
   int i;
 
   for (i = 0; i < resolved_combo->len; i++)
     {
-      guint32 key;
+      MetaKeyBindingDispatchSlot *slot;
+      MetaKeyBindingDispatchEntry *entry;
 
-      key = key_combo_key (resolved_combo, i);
-      binding = g_hash_table_lookup (keys->key_bindings_index,
-                                     GINT_TO_POINTER (key));
+      slot = get_dispatch_slot (keys, resolved_combo->keycodes[i]);
+      if (!slot)
+        continue;
+
+      entry = dispatch_slot_lookup (slot, mask);
+      binding = entry ? entry->binding : NULL;
 
       if (binding && binding->handler->removed)
         binding = NULL;
@@ -1097,12 +1237,12 @@ get_keybinding_action (MetaKeyBindingManager *keys,
    * of mutter keybindings while holding a grab, the overlay-key-only-pressed
    * tracking is left to the plugin here.
    */
-  if (resolved_key_combo_intersect (resolved_combo,
-                                    &keys->overlay_resolved_key_combo))
+  if (resolved_key_combo_has_special_key (keys, resolved_combo,
+                                          META_SPECIAL_KEY_OVERLAY))
     return META_KEYBINDING_ACTION_OVERLAY_KEY;
 
-  if (resolved_key_combo_intersect (resolved_combo,
-                                    &keys->locate_pointer_resolved_key_combo))
+  if (resolved_key_combo_has_special_key (keys, resolved_combo,
+                                          META_SPECIAL_KEY_LOCATE_POINTER))
     return META_KEYBINDING_ACTION_LOCATE_POINTER_KEY;
 
   binding = get_keybinding (keys, resolved_combo);
@@ -1443,10 +1583,13 @@ meta_display_shutdown_keys (MetaDisplay *display)
 
   meta_prefs_remove_listener (prefs_changed_callback, display);
 
-  g_hash_table_destroy (keys->key_bindings_index);
+  clear_dispatch_table (keys);
+  g_clear_pointer (&keys->dispatch_table, g_free);
+  keys->dispatch_table_size = 0;
   g_hash_table_destroy (keys->key_bindings);
 
-  clear_active_keyboard_layouts (keys);
+  clear_keyboard_layouts (keys);
+  g_clear_pointer (&keys->us_layout, meta_key_binding_keyboard_layout_free);
 }
 
 /* Grab/ungrab, ignoring all annoying modifiers like NumLock etc. */
@@ -1780,19 +1923,13 @@ meta_display_ungrab_accelerator (MetaDisplay *display,
   binding = get_keybinding (keys, &resolved_combo);
   if (binding)
     {
-      int i;
-
       if (!meta_is_wayland_compositor ())
         {
           meta_change_keygrab (keys, display->x11_display->xroot,
                                FALSE, &binding->resolved_combo);
         }
 
-      for (i = 0; i < binding->resolved_combo.len; i++)
-        {
-          guint32 index_key = key_combo_key (&binding->resolved_combo, i);
-          g_hash_table_remove (keys->key_bindings_index, GINT_TO_POINTER (index_key));
-        }
+      unindex_binding (keys, binding);
 
       g_hash_table_remove (keys->key_bindings, binding);
     }
@@ -2066,6 +2203,12 @@ process_overlay_key (MetaDisplay     *display,
                      MetaWindow      *window)
 {
   MetaKeyBindingManager *keys = &display->key_binding_manager;
+  xkb_keycode_t keycode =
+    (xkb_keycode_t) clutter_event_get_key_code ((ClutterEvent *) event);
+
+  if (!keys->overlay_key_only_pressed &&
+      !is_special_key (keys, keycode, META_SPECIAL_KEY_OVERLAY))
+    return FALSE;
 
   if (display->focus_window && !keys->overlay_key_only_pressed)
     {
@@ -2096,6 +2239,12 @@ process_locate_pointer_key (MetaDisplay     *display,
                             MetaWindow      *window)
 {
   MetaKeyBindingManager *keys = &display->key_binding_manager;
+  xkb_keycode_t keycode =
+    (xkb_keycode_t) clutter_event_get_key_code ((ClutterEvent *) event);
+
+  if (!keys->locate_pointer_key_only_pressed &&
+      !is_special_key (keys, keycode, META_SPECIAL_KEY_LOCATE_POINTER))
+    return FALSE;
 
   return process_special_modifier_key (display,
                                        event,
@@ -2122,6 +2271,9 @@ process_iso_next_group (MetaDisplay *display,
   if (clutter_event_type ((ClutterEvent *) event) == CLUTTER_KEY_RELEASE)
     return FALSE;
 
+  if (!is_special_key (keys, keycode, META_SPECIAL_KEY_ISO_NEXT_GROUP))
+    return FALSE;
+
   activate = FALSE;
   modifiers = get_modifiers ((ClutterEvent *) event);
   mask = mask_from_event_params (keys, modifiers);
@@ -3229,7 +3381,6 @@ meta_display_init_keys (MetaDisplay *display)
   keys->meta_mask = 0;
 
   keys->key_bindings = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) meta_key_binding_free);
-  keys->key_bindings_index = g_hash_table_new (NULL, NULL);
 
   reload_modmap (keys);
 
@@ -20,6 +20,8 @@
 
 #include "core/meta-debug-control.h"
 
+#include "clutter/clutter-mutter.h"
+#include "core/meta-context-private.h"
 #include "core/util-private.h"
 #include "meta/meta-backend.h"
 #include "meta/meta-context.h"
@@ -55,9 +57,136 @@ G_DEFINE_TYPE_WITH_CODE (MetaDebugControl,
                          G_IMPLEMENT_INTERFACE (META_DBUS_TYPE_DEBUG_CONTROL,
                                                 meta_dbus_debug_control_iface_init))
 
+#ifdef HAVE_PROFILER
+static void
+on_trace_dumped (GObject      *source_object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  MetaProfiler *profiler = META_PROFILER (source_object);
+  GDBusMethodInvocation *invocation = user_data;
+  g_autoptr (GError) error = NULL;
+
+  if (!meta_profiler_dump_trace_ring_finish (profiler, result, &error))
+    {
+      g_dbus_method_invocation_return_error (invocation,
+                                             G_DBUS_ERROR,
+                                             G_DBUS_ERROR_FAILED,
+                                             "Failed to dump trace: %s",
+                                             error->message);
+      return;
+    }
+
+  g_dbus_method_invocation_return_value (invocation, NULL);
+}
+#endif
+
+static gboolean
+handle_dump_trace (MetaDBusDebugControl  *dbus_debug_control,
+                   GDBusMethodInvocation *invocation,
+                   unsigned int           seconds,
+                   const char            *filename)
+{
+#ifdef HAVE_PROFILER
+  MetaDebugControl *debug_control = META_DEBUG_CONTROL (dbus_debug_control);
+  MetaProfiler *profiler = meta_context_get_profiler (debug_control->context);
+
+  if (!g_path_is_absolute (filename))
+    {
+      g_dbus_method_invocation_return_error (invocation,
+                                             G_DBUS_ERROR,
+                                             G_DBUS_ERROR_INVALID_ARGS,
+                                             "Trace file path must be absolute");
+      return G_DBUS_METHOD_INVOCATION_HANDLED;
+    }
+
+  meta_profiler_dump_trace_ring (profiler,
+                                 (int64_t) seconds * G_USEC_PER_SEC,
+                                 filename,
+                                 NULL,
+                                 on_trace_dumped,
+                                 invocation);
+#else
+  g_dbus_method_invocation_return_error (invocation,
+                                         G_DBUS_ERROR,
+                                         G_DBUS_ERROR_NOT_SUPPORTED,
+                                         "Profiler disabled at build time");
+#endif
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_get_layout_statistics (MetaDBusDebugControl  *dbus_debug_control,
+                              GDBusMethodInvocation *invocation)
+{
+  MetaDebugControl *debug_control = META_DEBUG_CONTROL (dbus_debug_control);
+  MetaBackend *backend = meta_context_get_backend (debug_control->context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  ClutterLayoutStatistics statistics;
+  GVariantBuilder builder;
+
+  clutter_stage_get_layout_statistics (CLUTTER_STAGE (stage), &statistics);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+  g_variant_builder_add (&builder, "{su}",
+                         "relayouts", statistics.n_relayouts);
+  g_variant_builder_add (&builder, "{su}",
+                         "allocations", statistics.n_allocations);
+  g_variant_builder_add (&builder, "{su}",
+                         "size-requests", statistics.n_size_requests);
+  g_variant_builder_add (&builder, "{su}",
+                         "cached-size-requests",
+                         statistics.n_cached_size_requests);
+
+  meta_dbus_debug_control_complete_get_layout_statistics (dbus_debug_control,
+                                                          invocation,
+                                                          g_variant_builder_end (&builder));
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_get_damage_statistics (MetaDBusDebugControl  *dbus_debug_control,
+                              GDBusMethodInvocation *invocation)
+{
+  MetaDebugControl *debug_control = META_DEBUG_CONTROL (dbus_debug_control);
+  MetaBackend *backend = meta_context_get_backend (debug_control->context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  unsigned int damaged_area = 0;
+  unsigned int repainted_area = 0;
+  GVariantBuilder builder;
+  GList *l;
+
+  for (l = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage)); l; l = l->next)
+    {
+      ClutterStageView *view = l->data;
+      ClutterDamageStatistics statistics;
+
+      clutter_stage_view_get_damage_statistics (view, &statistics);
+      damaged_area += statistics.damaged_area;
+      repainted_area += statistics.repainted_area;
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+  g_variant_builder_add (&builder, "{su}",
+                         "damaged-pixels", damaged_area);
+  g_variant_builder_add (&builder, "{su}",
+                         "repainted-pixels", repainted_area);
+
+  meta_dbus_debug_control_complete_get_damage_statistics (dbus_debug_control,
+                                                          invocation,
+                                                          g_variant_builder_end (&builder));
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
 static void
 meta_dbus_debug_control_iface_init (MetaDBusDebugControlIface *iface)
 {
+  iface->handle_dump_trace = handle_dump_trace;
+  iface->handle_get_layout_statistics = handle_get_layout_statistics;
+  iface->handle_get_damage_statistics = handle_get_damage_statistics;
 }
 
 static void
@@ -122,6 +251,22 @@ on_experimental_hdr_changed (MetaMonitorManager *monitor_manager,
                                           g_strcmp0 (experimental_hdr, "on") == 0);
 }
 
+static void
+on_dump_trace_on_missed_frame_changed (MetaDebugControl *debug_control,
+                                       GParamSpec       *pspec)
+{
+#ifdef HAVE_PROFILER
+  MetaDBusDebugControl *dbus_debug_control =
+    META_DBUS_DEBUG_CONTROL (debug_control);
+  MetaProfiler *profiler = meta_context_get_profiler (debug_control->context);
+  gboolean enable;
+
+  enable =
+    meta_dbus_debug_control_get_dump_trace_on_missed_frame (dbus_debug_control);
+  meta_profiler_set_dump_on_missed_frame (profiler, enable);
+#endif
+}
+
 static void
 on_context_started (MetaContext      *context,
                     MetaDebugControl *debug_control)
@@ -147,6 +292,11 @@ meta_debug_control_constructed (GObject *object)
                            G_CALLBACK (on_enable_hdr_changed), debug_control,
                            G_CONNECT_DEFAULT);
 
+  g_signal_connect_object (debug_control, "notify::dump-trace-on-missed-frame",
+                           G_CALLBACK (on_dump_trace_on_missed_frame_changed),
+                           debug_control,
+                           G_CONNECT_DEFAULT);
+
   G_OBJECT_CLASS (meta_debug_control_parent_class)->constructed (object);
 }
 
@@ -19,6 +19,7 @@
 
 #include "src/core/meta-profiler.h"
 
+#include <errno.h>
 #include <glib-unix.h>
 #include <glib/gi18n.h>
 #include <gio/gunixfdlist.h>
@@ -27,6 +28,11 @@
 
 #define META_SYSPROF_PROFILER_DBUS_PATH "/org/gnome/Sysprof3/Profiler"
 
+/* How much of the trace ring to dump when a frame misses its deadline,
+ * and how long to wait before dumping again */
+#define MISSED_FRAME_DUMP_DURATION_US (5 * G_USEC_PER_SEC)
+#define MISSED_FRAME_DUMP_INTERVAL_US (30 * G_USEC_PER_SEC)
+
 typedef struct
 {
   GMainContext *main_context;
@@ -45,6 +51,9 @@ struct _MetaProfiler
 
   GMutex mutex;
   GList *threads;
+
+  gboolean dump_on_missed_frame;
+  int64_t last_missed_frame_dump_us;
 };
 
 static void
@@ -203,6 +212,133 @@ handle_stop (MetaDBusSysprof3Profiler *dbus_profiler,
   return TRUE;
 }
 
+static void
+dump_trace_ring_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+  CoglTraceRingSnapshot *snapshot = task_data;
+  const char *filename = g_object_get_data (G_OBJECT (task), "filename");
+  g_autoptr (GError) error = NULL;
+
+  if (!cogl_trace_ring_snapshot_write (snapshot, filename, &error))
+    g_task_return_error (task, g_steal_pointer (&error));
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+void
+meta_profiler_dump_trace_ring (MetaProfiler        *profiler,
+                               int64_t              duration_us,
+                               const char          *filename,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  CoglTraceRingSnapshot *snapshot;
+
+  /* Copying the spans is quick, writing them out is left to a thread */
+  snapshot = cogl_trace_ring_snapshot_new (duration_us);
+
+  g_debug ("Dumping %u trace spans to %s",
+           cogl_trace_ring_snapshot_get_n_spans (snapshot), filename);
+
+  task = g_task_new (profiler, cancellable, callback, user_data);
+  g_task_set_source_tag (task, meta_profiler_dump_trace_ring);
+  g_task_set_task_data (task, snapshot,
+                        (GDestroyNotify) cogl_trace_ring_snapshot_free);
+  g_object_set_data_full (G_OBJECT (task), "filename",
+                          g_strdup (filename), g_free);
+  g_task_run_in_thread (task, dump_trace_ring_thread);
+}
+
+gboolean
+meta_profiler_dump_trace_ring_finish (MetaProfiler  *profiler,
+                                      GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, profiler), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        meta_profiler_dump_trace_ring, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+on_missed_frame_dumped (GObject      *source_object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  MetaProfiler *profiler = META_PROFILER (source_object);
+  g_autofree char *filename = user_data;
+  g_autoptr (GError) error = NULL;
+
+  if (!meta_profiler_dump_trace_ring_finish (profiler, result, &error))
+    g_warning ("Failed to dump trace of missed frame: %s", error->message);
+  else
+    g_message ("Dumped trace of missed frame to %s", filename);
+}
+
+static void
+on_trace_ring_trigger (const char *reason,
+                       gpointer    user_data)
+{
+  MetaProfiler *profiler = META_PROFILER (user_data);
+  g_autoptr (GDateTime) date_time = NULL;
+  g_autofree char *directory = NULL;
+  g_autofree char *basename = NULL;
+  char *filename;
+  int64_t now_us;
+
+  now_us = g_get_monotonic_time ();
+  if (profiler->last_missed_frame_dump_us != 0 &&
+      now_us - profiler->last_missed_frame_dump_us <
+      MISSED_FRAME_DUMP_INTERVAL_US)
+    return;
+
+  profiler->last_missed_frame_dump_us = now_us;
+
+  g_debug ("Missed frame deadline: %s", reason);
+
+  directory = g_build_filename (g_get_user_cache_dir (),
+                                "mutter", "traces", NULL);
+  if (g_mkdir_with_parents (directory, 0700) != 0)
+    {
+      g_warning ("Failed to create trace directory %s: %s",
+                 directory, g_strerror (errno));
+      return;
+    }
+
+  date_time = g_date_time_new_now_local ();
+  basename = g_date_time_format (date_time,
+                                 "missed-frame-%Y%m%d-%H%M%S.syscap");
+  filename = g_build_filename (directory, basename, NULL);
+
+  meta_profiler_dump_trace_ring (profiler,
+                                 MISSED_FRAME_DUMP_DURATION_US,
+                                 filename,
+                                 profiler->cancellable,
+                                 on_missed_frame_dumped,
+                                 filename);
+}
+
+void
+meta_profiler_set_dump_on_missed_frame (MetaProfiler *profiler,
+                                        gboolean      dump_on_missed_frame)
+{
+  if (profiler->dump_on_missed_frame == dump_on_missed_frame)
+    return;
+
+  profiler->dump_on_missed_frame = dump_on_missed_frame;
+
+  if (dump_on_missed_frame)
+    cogl_set_trace_ring_trigger_func (on_trace_ring_trigger, profiler);
+  else
+    cogl_set_trace_ring_trigger_func (NULL, NULL);
+}
+
 static void
 meta_sysprof_capturer_init_iface (MetaDBusSysprof3ProfilerIface *iface)
 {
@@ -252,6 +388,9 @@ meta_profiler_finalize (GObject *object)
   if (self->persistent)
     cogl_stop_tracing ();
 
+  meta_profiler_set_dump_on_missed_frame (self, FALSE);
+  cogl_set_trace_ring_disabled_on_thread (g_main_context_default ());
+
   g_cancellable_cancel (self->cancellable);
 
   g_clear_object (&self->cancellable);
@@ -285,19 +424,23 @@ meta_profiler_init (MetaProfiler *self)
 MetaProfiler *
 meta_profiler_new (const char *trace_file)
 {
+  GMainContext *main_context = g_main_context_default ();
   MetaProfiler *profiler;
+  const char *group_name;
 
   profiler = g_object_new (META_TYPE_PROFILER, NULL);
 
+  /* Translators: this string will appear in Sysprof */
+  group_name = _("Compositor");
+
+  /* Always keep the latest spans around, so that a trace of what
+   * happened can be dumped after the fact */
+  cogl_set_trace_ring_enabled_on_thread (main_context, group_name);
+
   if (trace_file)
     {
-      GMainContext *main_context = g_main_context_default ();
-      const char *group_name;
       g_autoptr (GError) error = NULL;
 
-      /* Translators: this string will appear in Sysprof */
-      group_name = _("Compositor");
-
       if (!cogl_start_tracing_with_path (trace_file, &error))
         {
           g_warning ("Failed to start persistent profiling: %s",
@@ -323,6 +466,7 @@ meta_profiler_register_thread (MetaProfiler *profiler,
   g_warn_if_fail (!g_list_find (profiler->threads, main_context));
   profiler->threads = g_list_prepend (profiler->threads,
                                       thread_info_new (main_context, name));
+  cogl_set_trace_ring_enabled_on_thread (main_context, name);
   if (profiler->running)
     cogl_set_tracing_enabled_on_thread (main_context, name);
   g_mutex_unlock (&profiler->mutex);
@@ -349,6 +493,7 @@ meta_profiler_unregister_thread (MetaProfiler *profiler,
 
   if (profiler->running)
     cogl_set_tracing_disabled_on_thread (main_context);
+  cogl_set_trace_ring_disabled_on_thread (main_context);
 
   g_mutex_unlock (&profiler->mutex);
 }
@@ -40,4 +40,18 @@ void meta_profiler_register_thread (MetaProfiler *profiler,
 void meta_profiler_unregister_thread (MetaProfiler *profiler,
                                       GMainContext *main_context);
 
+void meta_profiler_dump_trace_ring (MetaProfiler        *profiler,
+                                    int64_t              duration_us,
+                                    const char          *filename,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data);
+
+gboolean meta_profiler_dump_trace_ring_finish (MetaProfiler  *profiler,
+                                               GAsyncResult  *result,
+                                               GError       **error);
+
+void meta_profiler_set_dump_on_missed_frame (MetaProfiler *profiler,
+                                             gboolean      dump_on_missed_frame);
+
 G_END_DECLS
@@ -43,6 +43,10 @@ struct _MetaWorkspaceManager
   MetaDisplayCorner starting_corner;
   guint vertical_workspaces : 1;
   guint workspace_layout_overridden : 1;
+
+  /* Work area sets currently in use by at least one workspace, keyed by
+   * their struts and monitor layout. */
+  GHashTable *work_area_sets;
 };
 
 MetaWorkspaceManager *meta_workspace_manager_new (MetaDisplay *display);
@@ -55,6 +59,9 @@ void meta_workspace_manager_update_workspace_layout (MetaWorkspaceManager *works
 
 void meta_workspace_manager_reload_work_areas (MetaWorkspaceManager *workspace_manager);
 
+META_EXPORT_TEST
+int meta_workspace_manager_get_n_work_area_sets (MetaWorkspaceManager *workspace_manager);
+
 typedef struct MetaWorkspaceLayout MetaWorkspaceLayout;
 
 struct MetaWorkspaceLayout
@@ -96,6 +96,8 @@ meta_workspace_manager_finalize (GObject *object)
 
   meta_prefs_remove_listener (prefs_changed_callback, workspace_manager);
 
+  g_clear_pointer (&workspace_manager->work_area_sets, g_hash_table_unref);
+
   G_OBJECT_CLASS (meta_workspace_manager_parent_class)->finalize (object);
 }
 
@@ -187,6 +189,8 @@ meta_workspace_manager_class_init (MetaWorkspaceManagerClass *klass)
 static void
 meta_workspace_manager_init (MetaWorkspaceManager *workspace_manager)
 {
+  workspace_manager->work_area_sets =
+    g_hash_table_new (meta_work_area_set_hash, meta_work_area_set_equal);
 }
 
 void
@@ -202,6 +206,18 @@ meta_workspace_manager_reload_work_areas (MetaWorkspaceManager *workspace_manage
     }
 }
 
+/*
+ * meta_workspace_manager_get_n_work_area_sets:
+ *
+ * Returns the number of distinct work area sets currently shared between
+ * the workspaces; workspaces with identical struts share a single set.
+ */
+int
+meta_workspace_manager_get_n_work_area_sets (MetaWorkspaceManager *workspace_manager)
+{
+  return g_hash_table_size (workspace_manager->work_area_sets);
+}
+
 MetaWorkspaceManager *
 meta_workspace_manager_new (MetaDisplay *display)
 {
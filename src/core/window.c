@@ -5777,8 +5777,9 @@ void
 meta_window_shove_titlebar_onscreen (MetaWindow *window)
 {
   MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
+  MetaWorkspace *workspace = workspace_manager->active_workspace;
   MtkRectangle  frame_rect;
-  GList         *onscreen_region;
+  g_autoptr (MetaSpanningRegion) onscreen_region = NULL;
   int            horiz_amount, vert_amount;
 
   g_return_if_fail (!window->override_redirect);
@@ -5789,27 +5790,23 @@ meta_window_shove_titlebar_onscreen (MetaWindow *window)
 
   /* Get the basic info we need */
   meta_window_get_frame_rect (window, &frame_rect);
-  onscreen_region = workspace_manager->active_workspace->screen_region;
 
   /* Extend the region (just in case the window is too big to fit on the
-   * screen), then shove the window on screen, then return the region to
-   * normal.
+   * screen), then shove the window on screen.
    */
   horiz_amount = frame_rect.width;
   vert_amount  = frame_rect.height;
-  meta_rectangle_expand_region (onscreen_region,
-                                horiz_amount,
-                                horiz_amount,
-                                0,
-                                vert_amount);
-  meta_rectangle_shove_into_region(onscreen_region,
-                                   FIXED_DIRECTION_X,
-                                   &frame_rect);
-  meta_rectangle_expand_region (onscreen_region,
-                                -horiz_amount,
-                                -horiz_amount,
-                                0,
-                                -vert_amount);
+  onscreen_region =
+    meta_spanning_region_copy_expanded (meta_workspace_get_onscreen_region (workspace),
+                                        horiz_amount,
+                                        horiz_amount,
+                                        0,
+                                        vert_amount,
+                                        0,
+                                        0);
+  meta_spanning_region_shove (onscreen_region,
+                              FIXED_DIRECTION_X,
+                              &frame_rect);
 
   meta_window_move_frame (window, FALSE, frame_rect.x, frame_rect.y);
 }
@@ -5819,8 +5816,9 @@ meta_window_titlebar_is_onscreen (MetaWindow *window)
 {
   MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
   MtkRectangle  titlebar_rect, frame_rect;
-  GList         *onscreen_region;
+  MetaSpanningRegion *onscreen_region;
   gboolean       is_onscreen;
+  int            i;
 
   const int min_height_needed  = 8;
   const float min_width_percent  = 0.5;
@@ -5842,10 +5840,11 @@ meta_window_titlebar_is_onscreen (MetaWindow *window)
    * them overlaps with the titlebar sufficiently to consider it onscreen.
    */
   is_onscreen = FALSE;
-  onscreen_region = workspace_manager->active_workspace->screen_region;
-  while (onscreen_region)
+  onscreen_region =
+    meta_workspace_get_onscreen_region (workspace_manager->active_workspace);
+  for (i = 0; i < onscreen_region->n_rects; i++)
     {
-      MtkRectangle *spanning_rect = onscreen_region->data;
+      MtkRectangle *spanning_rect = &onscreen_region->rects[i];
       MtkRectangle overlap;
 
       mtk_rectangle_intersect (&titlebar_rect, spanning_rect, &overlap);
@@ -5856,8 +5855,6 @@ meta_window_titlebar_is_onscreen (MetaWindow *window)
           is_onscreen = TRUE;
           break;
         }
-
-      onscreen_region = onscreen_region->next;
     }
 
   return is_onscreen;
@@ -30,9 +30,12 @@
 
 #pragma once
 
+#include "core/boxes-private.h"
 #include "core/window-private.h"
 #include "meta/workspace.h"
 
+typedef struct _MetaWorkAreaSet MetaWorkAreaSet;
+
 struct _MetaWorkspace
 {
   GObject parent_instance;
@@ -54,15 +57,10 @@ struct _MetaWorkspace
 
   GList  *list_containing_self;
 
-  GHashTable *logical_monitor_data;
-
-  MtkRectangle work_area_screen;
-  GList  *screen_region;
-  GList  *screen_edges;
-  GList  *monitor_edges;
+  /* Shared with other workspaces that have an identical set of struts;
+   * NULL while the work areas are invalid. */
+  MetaWorkAreaSet *work_area_set;
   GSList *builtin_struts;
-  GSList *all_struts;
-  guint work_areas_invalid : 1;
 
   guint showing_desktop : 1;
 };
@@ -87,9 +85,20 @@ void meta_workspace_get_work_area_for_logical_monitor (MetaWorkspace      *works
 
 void meta_workspace_invalidate_work_area (MetaWorkspace *workspace);
 
-GList* meta_workspace_get_onscreen_region       (MetaWorkspace *workspace);
-GList * meta_workspace_get_onmonitor_region (MetaWorkspace      *workspace,
-                                             MetaLogicalMonitor *logical_monitor);
+guint meta_work_area_set_hash (gconstpointer key);
+
+gboolean meta_work_area_set_equal (gconstpointer a,
+                                   gconstpointer b);
+
+MetaSpanningRegion * meta_workspace_get_onscreen_region (MetaWorkspace *workspace);
+MetaSpanningRegion * meta_workspace_get_onmonitor_region (MetaWorkspace      *workspace,
+                                                          MetaLogicalMonitor *logical_monitor);
+
+const GSList * meta_workspace_get_all_struts (MetaWorkspace *workspace);
+
+GList * meta_workspace_get_screen_edges (MetaWorkspace *workspace);
+
+GList * meta_workspace_get_monitor_edges (MetaWorkspace *workspace);
 
 void meta_workspace_focus_default_window (MetaWorkspace *workspace,
                                           MetaWindow    *not_this_one,
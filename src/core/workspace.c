@@ -79,11 +79,43 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
-typedef struct _MetaWorkspaceLogicalMonitorData
+typedef struct _MetaWorkAreaMonitor
 {
-  GList *logical_monitor_region;
-  MtkRectangle logical_monitor_work_area;
-} MetaWorkspaceLogicalMonitorData;
+  MetaLogicalMonitor *logical_monitor;
+  MtkRectangle rect;
+
+  MetaSpanningRegion *region;
+  MtkRectangle work_area;
+} MetaWorkAreaMonitor;
+
+/*
+ * MetaWorkAreaSet:
+ *
+ * The work areas, spanning regions and edges computed from a set of struts
+ * on a given monitor layout. Workspaces whose struts are identical (e.g.
+ * because all struts come from sticky panels) share the same immutable set;
+ * it is looked up in the workspace manager's cache when a workspace first
+ * needs its work areas, and dropped from the cache with its last reference.
+ */
+struct _MetaWorkAreaSet
+{
+  grefcount ref_count;
+  GHashTable *cache;
+  guint hash;
+
+  /* Key */
+  MtkRectangle display_rect;
+  GArray *monitors;
+  GSList *all_struts;
+
+  MtkRectangle work_area_screen;
+  MetaSpanningRegion *screen_region;
+
+  /* Only needed for edge resistance, computed on first use */
+  gboolean edges_valid;
+  GList *screen_edges;
+  GList *monitor_edges;
+};
 
 typedef struct _MetaWorkspaceFocusableAncestorData
 {
@@ -91,52 +123,178 @@ typedef struct _MetaWorkspaceFocusableAncestorData
   MetaWindow *out_window;
 } MetaWorkspaceFocusableAncestorData;
 
-static MetaWorkspaceLogicalMonitorData *
-meta_workspace_get_logical_monitor_data (MetaWorkspace      *workspace,
-                                         MetaLogicalMonitor *logical_monitor)
+static guint
+hash_rectangle (guint               hash,
+                const MtkRectangle *rect)
 {
-  if (!workspace->logical_monitor_data)
-    return NULL;
-  return g_hash_table_lookup (workspace->logical_monitor_data, logical_monitor);
+  hash = hash * 31 + rect->x;
+  hash = hash * 31 + rect->y;
+  hash = hash * 31 + rect->width;
+  hash = hash * 31 + rect->height;
+
+  return hash;
 }
 
-static void
-workspace_logical_monitor_data_free (MetaWorkspaceLogicalMonitorData *data)
+static guint
+hash_strut (const MetaStrut *strut)
 {
-  g_clear_pointer (&data->logical_monitor_region,
-                   meta_rectangle_free_list_and_elements);
-  g_free (data);
+  return hash_rectangle (17 * 31 + strut->side, &strut->rect);
 }
 
-static MetaWorkspaceLogicalMonitorData *
-meta_workspace_ensure_logical_monitor_data (MetaWorkspace      *workspace,
-                                            MetaLogicalMonitor *logical_monitor)
+static guint
+work_area_set_compute_hash (MetaWorkAreaSet *set)
 {
-  MetaWorkspaceLogicalMonitorData *data;
+  guint hash;
+  GSList *l;
+  guint i;
 
-  data = meta_workspace_get_logical_monitor_data (workspace, logical_monitor);
-  if (data)
-    return data;
+  hash = hash_rectangle (17, &set->display_rect);
 
-  if (!workspace->logical_monitor_data)
+  for (i = 0; i < set->monitors->len; i++)
     {
-      workspace->logical_monitor_data =
-        g_hash_table_new_full (g_direct_hash,
-                               g_direct_equal,
-                               NULL,
-                               (GDestroyNotify) workspace_logical_monitor_data_free);
+      MetaWorkAreaMonitor *monitor =
+        &g_array_index (set->monitors, MetaWorkAreaMonitor, i);
+
+      hash = hash * 31 + g_direct_hash (monitor->logical_monitor);
+      hash = hash_rectangle (hash, &monitor->rect);
     }
 
-  data = g_new0 (MetaWorkspaceLogicalMonitorData, 1);
-  g_hash_table_insert (workspace->logical_monitor_data, logical_monitor, data);
+  /* Struts are combined commutatively so that the hash, like
+   * strut_lists_equal(), doesn't depend on the order of the list.
+   */
+  for (l = set->all_struts; l; l = l->next)
+    hash += hash_strut (l->data);
+
+  return hash;
+}
+
+guint
+meta_work_area_set_hash (gconstpointer key)
+{
+  const MetaWorkAreaSet *set = key;
+
+  return set->hash;
+}
+
+static gboolean strut_lists_equal (GSList *l,
+                                   GSList *m);
+
+gboolean
+meta_work_area_set_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const MetaWorkAreaSet *set_a = a;
+  const MetaWorkAreaSet *set_b = b;
+  guint i;
+
+  if (set_a->hash != set_b->hash)
+    return FALSE;
+
+  if (!mtk_rectangle_equal (&set_a->display_rect, &set_b->display_rect))
+    return FALSE;
+
+  if (set_a->monitors->len != set_b->monitors->len)
+    return FALSE;
+
+  for (i = 0; i < set_a->monitors->len; i++)
+    {
+      MetaWorkAreaMonitor *monitor_a =
+        &g_array_index (set_a->monitors, MetaWorkAreaMonitor, i);
+      MetaWorkAreaMonitor *monitor_b =
+        &g_array_index (set_b->monitors, MetaWorkAreaMonitor, i);
+
+      if (monitor_a->logical_monitor != monitor_b->logical_monitor ||
+          !mtk_rectangle_equal (&monitor_a->rect, &monitor_b->rect))
+        return FALSE;
+    }
+
+  return strut_lists_equal (set_a->all_struts, set_b->all_struts);
+}
+
+static void
+work_area_monitor_clear (MetaWorkAreaMonitor *monitor)
+{
+  g_clear_pointer (&monitor->region, meta_spanning_region_free);
+}
+
+static void
+work_area_set_free (MetaWorkAreaSet *set)
+{
+  g_array_unref (set->monitors);
+  g_slist_free_full (set->all_struts, g_free);
+  g_clear_pointer (&set->screen_region, meta_spanning_region_free);
+  meta_rectangle_free_list_and_elements (set->screen_edges);
+  meta_rectangle_free_list_and_elements (set->monitor_edges);
+  g_clear_pointer (&set->cache, g_hash_table_unref);
+  g_free (set);
+}
+
+static MetaWorkAreaSet *
+work_area_set_ref (MetaWorkAreaSet *set)
+{
+  g_ref_count_inc (&set->ref_count);
+  return set;
+}
+
+static void
+work_area_set_unref (MetaWorkAreaSet *set)
+{
+  if (!g_ref_count_dec (&set->ref_count))
+    return;
+
+  g_hash_table_remove (set->cache, set);
+
+  meta_topic (META_DEBUG_WORKAREA,
+              "Freed work area set, %u distinct sets in use",
+              g_hash_table_size (set->cache));
 
-  return data;
+  work_area_set_free (set);
+}
+
+static MetaWorkAreaMonitor *
+work_area_set_get_monitor (MetaWorkAreaSet    *set,
+                           MetaLogicalMonitor *logical_monitor)
+{
+  guint i;
+
+  for (i = 0; i < set->monitors->len; i++)
+    {
+      MetaWorkAreaMonitor *monitor =
+        &g_array_index (set->monitors, MetaWorkAreaMonitor, i);
+
+      if (monitor->logical_monitor == logical_monitor)
+        return monitor;
+    }
+
+  return NULL;
 }
 
 static void
-meta_workspace_clear_logical_monitor_data (MetaWorkspace *workspace)
+work_area_set_ensure_edges (MetaWorkAreaSet *set)
 {
-  g_clear_pointer (&workspace->logical_monitor_data, g_hash_table_destroy);
+  GList *monitor_rects = NULL;
+  guint i;
+
+  if (set->edges_valid)
+    return;
+
+  set->screen_edges =
+    meta_rectangle_find_onscreen_edges (&set->display_rect,
+                                        set->all_struts);
+
+  for (i = 0; i < set->monitors->len; i++)
+    {
+      MetaWorkAreaMonitor *monitor =
+        &g_array_index (set->monitors, MetaWorkAreaMonitor, i);
+
+      monitor_rects = g_list_prepend (monitor_rects, &monitor->rect);
+    }
+  set->monitor_edges =
+    meta_rectangle_find_nonintersected_monitor_edges (monitor_rects,
+                                                       set->all_struts);
+  g_list_free (monitor_rects);
+
+  set->edges_valid = TRUE;
 }
 
 static void
@@ -224,19 +382,10 @@ meta_workspace_new (MetaWorkspaceManager *workspace_manager)
   workspace->windows = NULL;
   workspace->mru_list = NULL;
 
-  workspace->work_areas_invalid = TRUE;
-  workspace->work_area_screen.x = 0;
-  workspace->work_area_screen.y = 0;
-  workspace->work_area_screen.width = 0;
-  workspace->work_area_screen.height = 0;
-
-  workspace->screen_region = NULL;
-  workspace->screen_edges = NULL;
-  workspace->monitor_edges = NULL;
+  workspace->work_area_set = NULL;
   workspace->list_containing_self = g_list_prepend (NULL, workspace);
 
   workspace->builtin_struts = NULL;
-  workspace->all_struts = NULL;
 
   workspace->showing_desktop = FALSE;
 
@@ -250,22 +399,6 @@ meta_workspace_new (MetaWorkspaceManager *workspace_manager)
   return workspace;
 }
 
-/**
- * workspace_free_all_struts:
- * @workspace: The workspace.
- *
- * Frees the combined struts list of a workspace.
- */
-static void
-workspace_free_all_struts (MetaWorkspace *workspace)
-{
-  if (workspace->all_struts == NULL)
-    return;
-
-  g_slist_free_full (workspace->all_struts, g_free);
-  workspace->all_struts = NULL;
-}
-
 /**
  * workspace_free_builtin_struts:
  * @workspace: The workspace.
@@ -307,8 +440,6 @@ meta_workspace_remove (MetaWorkspace *workspace)
   manager->workspaces =
     g_list_remove (manager->workspaces, workspace);
 
-  meta_workspace_clear_logical_monitor_data (workspace);
-
   g_list_free (workspace->mru_list);
   g_list_free (workspace->list_containing_self);
 
@@ -316,18 +447,9 @@ meta_workspace_remove (MetaWorkspace *workspace)
 
   /* screen.c:update_num_workspaces(), which calls us, removes windows from
    * workspaces first, which can cause the workareas on the workspace to be
-   * invalidated (and hence for struts/regions/edges to be freed).
-   * So, no point trying to double free it; that causes a crash
-   * anyway.  #361804.
+   * invalidated (and hence for the work area set to be released already).
    */
-
-  if (!workspace->work_areas_invalid)
-    {
-      workspace_free_all_struts (workspace);
-      meta_rectangle_free_list_and_elements (workspace->screen_region);
-      meta_rectangle_free_list_and_elements (workspace->screen_edges);
-      meta_rectangle_free_list_and_elements (workspace->monitor_edges);
-    }
+  g_clear_pointer (&workspace->work_area_set, work_area_set_unref);
 
   g_object_unref (workspace);
 
@@ -764,7 +886,7 @@ meta_workspace_invalidate_work_area (MetaWorkspace *workspace)
   MetaWindowDrag *window_drag;
   GList *windows, *l;
 
-  if (workspace->work_areas_invalid)
+  if (!workspace->work_area_set)
     {
       meta_topic (META_DEBUG_WORKAREA,
                   "Work area for workspace %d is already invalid",
@@ -785,18 +907,7 @@ meta_workspace_invalidate_work_area (MetaWorkspace *workspace)
       workspace == workspace->manager->active_workspace)
     meta_window_drag_update_edges (window_drag);
 
-  meta_workspace_clear_logical_monitor_data (workspace);
-
-  workspace_free_all_struts (workspace);
-
-  meta_rectangle_free_list_and_elements (workspace->screen_region);
-  meta_rectangle_free_list_and_elements (workspace->screen_edges);
-  meta_rectangle_free_list_and_elements (workspace->monitor_edges);
-  workspace->screen_region = NULL;
-  workspace->screen_edges = NULL;
-  workspace->monitor_edges = NULL;
-
-  workspace->work_areas_invalid = TRUE;
+  g_clear_pointer (&workspace->work_area_set, work_area_set_unref);
 
   /* redo the size/position constraints on all windows */
   windows = meta_workspace_list_windows (workspace);
@@ -830,85 +941,40 @@ copy_strut_list(GSList *original)
 }
 
 static void
-ensure_work_areas_validated (MetaWorkspace *workspace)
+work_area_set_compute (MetaWorkAreaSet *set,
+                       MetaWorkspace   *workspace)
 {
-  MetaContext *context = meta_display_get_context (workspace->display);
-  MetaBackend *backend = meta_context_get_backend (context);
-  MetaMonitorManager *monitor_manager =
-    meta_backend_get_monitor_manager (backend);
-  GList *windows;
-  GList *tmp;
-  GList *logical_monitors, *l;
-  MtkRectangle display_rect = { 0 };
+  MtkRectangle display_rect = set->display_rect;
   MtkRectangle work_area;
-
-  if (!workspace->work_areas_invalid)
-    return;
-
-  g_assert (workspace->all_struts == NULL);
-  g_assert (workspace->screen_region == NULL);
-  g_assert (workspace->screen_edges == NULL);
-  g_assert (workspace->monitor_edges == NULL);
-
-  meta_display_get_size (workspace->display,
-                         &display_rect.width,
-                         &display_rect.height);
-
-  /* STEP 1: Get the list of struts */
-
-  workspace->all_struts = copy_strut_list (workspace->builtin_struts);
-
-  windows = meta_workspace_list_windows (workspace);
-  for (tmp = windows; tmp != NULL; tmp = tmp->next)
-    {
-      MetaWindow *win = tmp->data;
-      GSList *s_iter;
-
-      for (s_iter = win->struts; s_iter != NULL; s_iter = s_iter->next) {
-        workspace->all_struts = g_slist_prepend (workspace->all_struts,
-                                                 copy_strut(s_iter->data));
-      }
-    }
-  g_list_free (windows);
+  guint i;
 
   /* STEP 2: Get the maximal/spanning rects for the onscreen and
    *         on-single-monitor regions
    */
-  g_assert (workspace->screen_region   == NULL);
-
-  logical_monitors =
-    meta_monitor_manager_get_logical_monitors (monitor_manager);
-  for (l = logical_monitors; l; l = l->next)
+  for (i = 0; i < set->monitors->len; i++)
     {
-      MetaLogicalMonitor *logical_monitor = l->data;
-      MetaWorkspaceLogicalMonitorData *data;
-
-      g_assert (!meta_workspace_get_logical_monitor_data (workspace,
-                                                          logical_monitor));
+      MetaWorkAreaMonitor *monitor =
+        &g_array_index (set->monitors, MetaWorkAreaMonitor, i);
 
-      data = meta_workspace_ensure_logical_monitor_data (workspace,
-                                                         logical_monitor);
-      data->logical_monitor_region =
-        meta_rectangle_get_minimal_spanning_set_for_region (
-          &logical_monitor->rect,
-          workspace->all_struts);
+      monitor->region =
+        meta_spanning_region_new_for_struts (&monitor->rect,
+                                             set->all_struts);
     }
 
-  workspace->screen_region =
-    meta_rectangle_get_minimal_spanning_set_for_region (
-      &display_rect,
-      workspace->all_struts);
+  set->screen_region =
+    meta_spanning_region_new_for_struts (&display_rect,
+                                         set->all_struts);
 
   /* STEP 3: Get the work areas (region-to-maximize-to) for the screen and
    *         monitors.
    */
   work_area = display_rect;  /* start with the screen */
-  if (workspace->screen_region == NULL)
+  if (meta_spanning_region_is_empty (set->screen_region))
     work_area = MTK_RECTANGLE_INIT (0, 0, -1, -1);
   else
-    meta_rectangle_clip_to_region (workspace->screen_region,
-                                   FIXED_DIRECTION_NONE,
-                                   &work_area);
+    meta_spanning_region_clip (set->screen_region,
+                               FIXED_DIRECTION_NONE,
+                               &work_area);
 
   /* Lots of paranoia checks, forcing work_area_screen to be sane */
 #define MIN_SANE_AREA 100
@@ -948,96 +1014,191 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
           work_area.height += 2*amount;
         }
     }
-  workspace->work_area_screen = work_area;
+  set->work_area_screen = work_area;
   meta_topic (META_DEBUG_WORKAREA,
               "Computed work area for workspace %d: %d,%d %d x %d",
               meta_workspace_index (workspace),
-              workspace->work_area_screen.x,
-              workspace->work_area_screen.y,
-              workspace->work_area_screen.width,
-              workspace->work_area_screen.height);
+              set->work_area_screen.x,
+              set->work_area_screen.y,
+              set->work_area_screen.width,
+              set->work_area_screen.height);
 
   /* Now find the work areas for each monitor */
-  for (l = logical_monitors; l; l = l->next)
+  for (i = 0; i < set->monitors->len; i++)
     {
-      MetaLogicalMonitor *logical_monitor = l->data;
-      MetaWorkspaceLogicalMonitorData *data;
+      MetaWorkAreaMonitor *monitor =
+        &g_array_index (set->monitors, MetaWorkAreaMonitor, i);
 
-      data = meta_workspace_get_logical_monitor_data (workspace,
-                                                      logical_monitor);
-      work_area = logical_monitor->rect;
+      work_area = monitor->rect;
 
-      if (!data->logical_monitor_region)
+      if (meta_spanning_region_is_empty (monitor->region))
         /* FIXME: constraints.c untested with this, but it might be nice for
          * a screen reader or magnifier.
          */
         work_area = MTK_RECTANGLE_INIT (work_area.x, work_area.y, -1, -1);
       else
-        meta_rectangle_clip_to_region (data->logical_monitor_region,
-                                       FIXED_DIRECTION_NONE,
-                                       &work_area);
+        meta_spanning_region_clip (monitor->region,
+                                   FIXED_DIRECTION_NONE,
+                                   &work_area);
 
-      data->logical_monitor_work_area = work_area;
+      monitor->work_area = work_area;
 
       meta_topic (META_DEBUG_WORKAREA,
                   "Computed work area for workspace %d "
                   "monitor %d: %d,%d %d x %d",
                   meta_workspace_index (workspace),
-                  logical_monitor->number,
-                  data->logical_monitor_work_area.x,
-                  data->logical_monitor_work_area.y,
-                  data->logical_monitor_work_area.width,
-                  data->logical_monitor_work_area.height);
+                  monitor->logical_monitor->number,
+                  monitor->work_area.x,
+                  monitor->work_area.y,
+                  monitor->work_area.width,
+                  monitor->work_area.height);
     }
 
   /* STEP 4: Make sure the screen_region is nonempty (separate from step 2
    *         since it relies on step 3).
    */
-  if (workspace->screen_region == NULL)
+  if (meta_spanning_region_is_empty (set->screen_region))
     {
-      MtkRectangle *nonempty_region;
-      nonempty_region = g_new (MtkRectangle, 1);
-      *nonempty_region = workspace->work_area_screen;
-      workspace->screen_region = g_list_prepend (NULL, nonempty_region);
+      meta_spanning_region_free (set->screen_region);
+      set->screen_region =
+        meta_spanning_region_new_for_rect (&set->work_area_screen);
     }
 
-  /* STEP 5: Cache screen and monitor edges for edge resistance and snapping */
-  g_assert (workspace->screen_edges    == NULL);
-  g_assert (workspace->monitor_edges  == NULL);
-  workspace->screen_edges =
-    meta_rectangle_find_onscreen_edges (&display_rect,
-                                        workspace->all_struts);
-  tmp = NULL;
+  /* STEP 5: Screen and monitor edges for edge resistance and snapping are
+   *         computed on demand, see work_area_set_ensure_edges().
+   */
+}
+
+static void
+ensure_work_areas_validated (MetaWorkspace *workspace)
+{
+  MetaContext *context = meta_display_get_context (workspace->display);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaMonitorManager *monitor_manager =
+    meta_backend_get_monitor_manager (backend);
+  GHashTable *cache = workspace->manager->work_area_sets;
+  GList *windows;
+  GList *tmp;
+  GList *logical_monitors, *l;
+  MetaWorkAreaSet *set;
+
+  if (workspace->work_area_set)
+    return;
+
+  set = g_new0 (MetaWorkAreaSet, 1);
+  g_ref_count_init (&set->ref_count);
+
+  meta_display_get_size (workspace->display,
+                         &set->display_rect.width,
+                         &set->display_rect.height);
+
+  set->monitors = g_array_new (FALSE, FALSE, sizeof (MetaWorkAreaMonitor));
+  g_array_set_clear_func (set->monitors,
+                          (GDestroyNotify) work_area_monitor_clear);
+
+  logical_monitors =
+    meta_monitor_manager_get_logical_monitors (monitor_manager);
   for (l = logical_monitors; l; l = l->next)
     {
       MetaLogicalMonitor *logical_monitor = l->data;
+      MetaWorkAreaMonitor monitor = {
+        .logical_monitor = logical_monitor,
+        .rect = logical_monitor->rect,
+      };
+
+      g_array_append_val (set->monitors, monitor);
+    }
+
+  /* STEP 1: Get the list of struts */
+
+  set->all_struts = copy_strut_list (workspace->builtin_struts);
+
+  windows = meta_workspace_list_windows (workspace);
+  for (tmp = windows; tmp != NULL; tmp = tmp->next)
+    {
+      MetaWindow *win = tmp->data;
+      GSList *s_iter;
+
+      for (s_iter = win->struts; s_iter != NULL; s_iter = s_iter->next) {
+        set->all_struts = g_slist_prepend (set->all_struts,
+                                           copy_strut(s_iter->data));
+      }
+    }
+  g_list_free (windows);
 
-      tmp = g_list_prepend (tmp, &logical_monitor->rect);
+  set->hash = work_area_set_compute_hash (set);
+
+  /* Workspaces usually share their struts (e.g. from sticky panels), so
+   * reuse the work areas of another workspace if they match. */
+  workspace->work_area_set = g_hash_table_lookup (cache, set);
+  if (workspace->work_area_set)
+    {
+      work_area_set_ref (workspace->work_area_set);
+      work_area_set_free (set);
+
+      meta_topic (META_DEBUG_WORKAREA,
+                  "Reusing work area set for workspace %d",
+                  meta_workspace_index (workspace));
+      return;
     }
-  workspace->monitor_edges =
-    meta_rectangle_find_nonintersected_monitor_edges (tmp,
-                                                       workspace->all_struts);
-  g_list_free (tmp);
 
-  /* We're all done, YAAY!  Record that everything has been validated. */
-  workspace->work_areas_invalid = FALSE;
+  work_area_set_compute (set, workspace);
+
+  set->cache = g_hash_table_ref (cache);
+  g_hash_table_add (cache, set);
+  workspace->work_area_set = set;
+
+  meta_topic (META_DEBUG_WORKAREA,
+              "Added work area set for workspace %d, %u distinct sets in use",
+              meta_workspace_index (workspace),
+              g_hash_table_size (cache));
+}
+
+static int
+compare_struts (gconstpointer a,
+                gconstpointer b)
+{
+  const MetaStrut *strut_a = a;
+  const MetaStrut *strut_b = b;
+
+  if (strut_a->side != strut_b->side)
+    return strut_a->side < strut_b->side ? -1 : 1;
+  if (strut_a->rect.x != strut_b->rect.x)
+    return strut_a->rect.x < strut_b->rect.x ? -1 : 1;
+  if (strut_a->rect.y != strut_b->rect.y)
+    return strut_a->rect.y < strut_b->rect.y ? -1 : 1;
+  if (strut_a->rect.width != strut_b->rect.width)
+    return strut_a->rect.width < strut_b->rect.width ? -1 : 1;
+  if (strut_a->rect.height != strut_b->rect.height)
+    return strut_a->rect.height < strut_b->rect.height ? -1 : 1;
+
+  return 0;
 }
 
+/* Compares the lists as sets of struts; the order struts are listed in
+ * has no effect on the work area.
+ */
 static gboolean
 strut_lists_equal (GSList *l,
                    GSList *m)
 {
-  for (; l && m; l = l->next, m = m->next)
-    {
-      MetaStrut *a = l->data;
-      MetaStrut *b = m->data;
+  g_autoptr (GSList) sorted_l = NULL;
+  g_autoptr (GSList) sorted_m = NULL;
+  GSList *a, *b;
+
+  if (g_slist_length (l) != g_slist_length (m))
+    return FALSE;
+
+  sorted_l = g_slist_sort (g_slist_copy (l), compare_struts);
+  sorted_m = g_slist_sort (g_slist_copy (m), compare_struts);
 
-      if (a->side != b->side ||
-          !mtk_rectangle_equal (&a->rect, &b->rect))
+  for (a = sorted_l, b = sorted_m; a && b; a = a->next, b = b->next)
+    {
+      if (compare_struts (a->data, b->data) != 0)
         return FALSE;
     }
 
-  return l == NULL && m == NULL;
+  return TRUE;
 }
 
 /**
@@ -1111,9 +1272,6 @@ meta_workspace_set_builtin_struts (MetaWorkspace *workspace,
         }
     }
 
-  /* Reordering doesn't actually matter, so we don't catch all
-   * no-impact changes, but this is just a (possibly unnecessary
-   * anyways) optimization */
   if (strut_lists_equal (struts, workspace->builtin_struts))
     return;
 
@@ -1152,7 +1310,7 @@ meta_workspace_get_work_area_for_monitor (MetaWorkspace *workspace,
   MetaMonitorManager *monitor_manager =
     meta_backend_get_monitor_manager (backend);
   MetaLogicalMonitor *logical_monitor;
-  MetaWorkspaceLogicalMonitorData *data;
+  MetaWorkAreaMonitor *monitor;
 
   logical_monitor =
     meta_monitor_manager_get_logical_monitor_from_number (monitor_manager,
@@ -1160,11 +1318,12 @@ meta_workspace_get_work_area_for_monitor (MetaWorkspace *workspace,
   g_return_if_fail (logical_monitor != NULL);
 
   ensure_work_areas_validated (workspace);
-  data = meta_workspace_get_logical_monitor_data (workspace, logical_monitor);
+  monitor = work_area_set_get_monitor (workspace->work_area_set,
+                                       logical_monitor);
 
-  g_return_if_fail (data != NULL);
+  g_return_if_fail (monitor != NULL);
 
-  *area = data->logical_monitor_work_area;
+  *area = monitor->work_area;
 }
 
 /**
@@ -1180,28 +1339,55 @@ meta_workspace_get_work_area_all_monitors (MetaWorkspace *workspace,
 {
   ensure_work_areas_validated (workspace);
 
-  *area = workspace->work_area_screen;
+  *area = workspace->work_area_set->work_area_screen;
 }
 
-GList*
+MetaSpanningRegion *
 meta_workspace_get_onscreen_region (MetaWorkspace *workspace)
 {
   ensure_work_areas_validated (workspace);
 
-  return workspace->screen_region;
+  return workspace->work_area_set->screen_region;
 }
 
-GList *
+MetaSpanningRegion *
 meta_workspace_get_onmonitor_region (MetaWorkspace      *workspace,
                                      MetaLogicalMonitor *logical_monitor)
 {
-  MetaWorkspaceLogicalMonitorData *data;
+  MetaWorkAreaMonitor *monitor;
 
   ensure_work_areas_validated (workspace);
 
-  data = meta_workspace_get_logical_monitor_data (workspace, logical_monitor);
+  monitor = work_area_set_get_monitor (workspace->work_area_set,
+                                       logical_monitor);
+
+  return monitor->region;
+}
+
+const GSList *
+meta_workspace_get_all_struts (MetaWorkspace *workspace)
+{
+  ensure_work_areas_validated (workspace);
+
+  return workspace->work_area_set->all_struts;
+}
+
+GList *
+meta_workspace_get_screen_edges (MetaWorkspace *workspace)
+{
+  ensure_work_areas_validated (workspace);
+  work_area_set_ensure_edges (workspace->work_area_set);
+
+  return workspace->work_area_set->screen_edges;
+}
+
+GList *
+meta_workspace_get_monitor_edges (MetaWorkspace *workspace)
+{
+  ensure_work_areas_validated (workspace);
+  work_area_set_ensure_edges (workspace->work_area_set);
 
-  return data->logical_monitor_region;
+  return workspace->work_area_set->monitor_edges;
 }
 
 #ifdef WITH_VERBOSE_MODE
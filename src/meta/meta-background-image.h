@@ -61,6 +61,12 @@ META_EXPORT
 MetaBackgroundImage *meta_background_image_cache_load  (MetaBackgroundImageCache *cache,
                                                         GFile                    *file);
 
+META_EXPORT
+MetaBackgroundImage *meta_background_image_cache_load_scaled (MetaBackgroundImageCache *cache,
+                                                              GFile                    *file,
+                                                              int                       max_width,
+                                                              int                       max_height);
+
 META_EXPORT
 void                 meta_background_image_cache_purge (MetaBackgroundImageCache *cache,
                                                         GFile                    *file);
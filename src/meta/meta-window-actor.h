@@ -50,6 +50,18 @@ META_EXPORT
 cairo_surface_t * meta_window_actor_get_image (MetaWindowActor *self,
                                                MtkRectangle    *clip);
 
+META_EXPORT
+void meta_window_actor_get_image_async (MetaWindowActor     *self,
+                                        MtkRectangle        *clip,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data);
+
+META_EXPORT
+cairo_surface_t * meta_window_actor_get_image_finish (MetaWindowActor  *self,
+                                                      GAsyncResult     *result,
+                                                      GError          **error);
+
 META_EXPORT
 ClutterContent * meta_window_actor_paint_to_content (MetaWindowActor  *self,
                                                      MtkRectangle     *clip,
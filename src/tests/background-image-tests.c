@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2026 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+#include <utime.h>
+
+#include "compositor/meta-background-private.h"
+#include "meta-test/meta-context-test.h"
+#include "meta/meta-background-image.h"
+
+#define SOURCE_WIDTH 64
+#define SOURCE_HEIGHT 32
+#define MAX_SIZE 16
+
+#define FAKE_ENTRY_SIZE (64 * 1024)
+#define DEFAULT_DISK_CACHE_MAX_SIZE (128 * 1024 * 1024)
+
+static char *test_dir;
+
+/* Wraps a file, but can't be queried for information, as happens when
+ * e.g. a remote file system doesn't provide modification times */
+struct _MetaTestUnstatableFile
+{
+  GObject parent;
+
+  GFile *file;
+};
+
+static void meta_test_unstatable_file_iface_init (GFileIface *iface);
+
+#define META_TYPE_TEST_UNSTATABLE_FILE (meta_test_unstatable_file_get_type ())
+G_DECLARE_FINAL_TYPE (MetaTestUnstatableFile, meta_test_unstatable_file,
+                      META, TEST_UNSTATABLE_FILE, GObject)
+
+G_DEFINE_TYPE_WITH_CODE (MetaTestUnstatableFile, meta_test_unstatable_file,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_FILE,
+                                                meta_test_unstatable_file_iface_init))
+
+static GFile *
+meta_test_unstatable_file_new (GFile *file)
+{
+  MetaTestUnstatableFile *unstatable_file;
+
+  unstatable_file = g_object_new (META_TYPE_TEST_UNSTATABLE_FILE, NULL);
+  unstatable_file->file = g_object_ref (file);
+
+  return G_FILE (unstatable_file);
+}
+
+static GFile *
+unstatable_file_dup (GFile *file)
+{
+  MetaTestUnstatableFile *unstatable_file = META_TEST_UNSTATABLE_FILE (file);
+
+  return meta_test_unstatable_file_new (unstatable_file->file);
+}
+
+static guint
+unstatable_file_hash (GFile *file)
+{
+  MetaTestUnstatableFile *unstatable_file = META_TEST_UNSTATABLE_FILE (file);
+
+  return g_file_hash (unstatable_file->file);
+}
+
+static gboolean
+unstatable_file_equal (GFile *file1,
+                       GFile *file2)
+{
+  MetaTestUnstatableFile *unstatable_file1 = META_TEST_UNSTATABLE_FILE (file1);
+  MetaTestUnstatableFile *unstatable_file2 = META_TEST_UNSTATABLE_FILE (file2);
+
+  return g_file_equal (unstatable_file1->file, unstatable_file2->file);
+}
+
+static char *
+unstatable_file_get_uri (GFile *file)
+{
+  MetaTestUnstatableFile *unstatable_file = META_TEST_UNSTATABLE_FILE (file);
+
+  return g_file_get_uri (unstatable_file->file);
+}
+
+static GFileInputStream *
+unstatable_file_read (GFile         *file,
+                      GCancellable  *cancellable,
+                      GError       **error)
+{
+  MetaTestUnstatableFile *unstatable_file = META_TEST_UNSTATABLE_FILE (file);
+
+  return g_file_read (unstatable_file->file, cancellable, error);
+}
+
+static void
+meta_test_unstatable_file_iface_init (GFileIface *iface)
+{
+  /* Leaving out query_info makes querying fail with
+   * G_IO_ERROR_NOT_SUPPORTED */
+  iface->dup = unstatable_file_dup;
+  iface->hash = unstatable_file_hash;
+  iface->equal = unstatable_file_equal;
+  iface->get_uri = unstatable_file_get_uri;
+  iface->read_fn = unstatable_file_read;
+}
+
+static void
+meta_test_unstatable_file_finalize (GObject *object)
+{
+  MetaTestUnstatableFile *unstatable_file = META_TEST_UNSTATABLE_FILE (object);
+
+  g_clear_object (&unstatable_file->file);
+
+  G_OBJECT_CLASS (meta_test_unstatable_file_parent_class)->finalize (object);
+}
+
+static void
+meta_test_unstatable_file_class_init (MetaTestUnstatableFileClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_test_unstatable_file_finalize;
+}
+
+static void
+meta_test_unstatable_file_init (MetaTestUnstatableFile *unstatable_file)
+{
+}
+
+static GFile *
+create_source_image (const char *name)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree char *path = NULL;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8,
+                           SOURCE_WIDTH, SOURCE_HEIGHT);
+  gdk_pixbuf_fill (pixbuf, 0x00ff00ff);
+
+  path = g_build_filename (test_dir, name, NULL);
+  gdk_pixbuf_save (pixbuf, path, "png", &error, NULL);
+  g_assert_no_error (error);
+
+  return g_file_new_for_path (path);
+}
+
+static char *
+get_disk_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "mutter", "backgrounds",
+                           NULL);
+}
+
+static void
+create_fake_cache_entry (const char *cache_dir,
+                         const char *name,
+                         time_t      mtime)
+{
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+  g_autoptr (GError) error = NULL;
+  struct utimbuf times;
+
+  path = g_build_filename (cache_dir, name, NULL);
+  contents = g_malloc0 (FAKE_ENTRY_SIZE);
+  g_file_set_contents (path, contents, FAKE_ENTRY_SIZE, &error);
+  g_assert_no_error (error);
+
+  times.actime = mtime;
+  times.modtime = mtime;
+  g_assert_cmpint (g_utime (path, &times), ==, 0);
+}
+
+static GList *
+list_cache_entries (const char *cache_dir)
+{
+  g_autoptr (GDir) dir = NULL;
+  g_autoptr (GError) error = NULL;
+  GList *names = NULL;
+  const char *name;
+
+  dir = g_dir_open (cache_dir, 0, &error);
+  g_assert_no_error (error);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".png"))
+        names = g_list_prepend (names, g_strdup (name));
+    }
+
+  return g_list_sort (names, (GCompareFunc) g_strcmp0);
+}
+
+static void
+clear_disk_cache (void)
+{
+  g_autofree char *cache_dir = NULL;
+  GList *names = NULL;
+  GList *l;
+
+  cache_dir = get_disk_cache_dir ();
+  if (!g_file_test (cache_dir, G_FILE_TEST_IS_DIR))
+    return;
+
+  names = list_cache_entries (cache_dir);
+  for (l = names; l; l = l->next)
+    {
+      g_autofree char *path = NULL;
+
+      path = g_build_filename (cache_dir, l->data, NULL);
+      g_assert_cmpint (g_unlink (path), ==, 0);
+    }
+
+  g_list_free_full (names, g_free);
+}
+
+static void
+wait_for_load (MetaBackgroundImage *image)
+{
+  while (!meta_background_image_is_loaded (image))
+    g_main_context_iteration (NULL, TRUE);
+
+  /* The load task holds a reference on the image until the loading
+   * thread, which writes the disk cache after handing over the image,
+   * is done */
+  while (g_atomic_int_get (&G_OBJECT (image)->ref_count) > 1)
+    {
+      g_main_context_iteration (NULL, FALSE);
+      g_usleep (1000);
+    }
+}
+
+static void
+assert_loaded_scaled (MetaBackgroundImage *image)
+{
+  CoglTexture *texture;
+
+  g_assert_true (meta_background_image_get_success (image));
+
+  texture = meta_background_image_get_texture (image);
+  g_assert_nonnull (texture);
+  g_assert_cmpint (cogl_texture_get_width (texture), ==,
+                   SOURCE_WIDTH * MAX_SIZE / SOURCE_HEIGHT);
+  g_assert_cmpint (cogl_texture_get_height (texture), ==, MAX_SIZE);
+}
+
+static void
+meta_test_background_image_disk_cache_eviction (void)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (MetaBackgroundImage) image = NULL;
+  g_autofree char *cache_dir = NULL;
+  GList *names = NULL;
+
+  clear_disk_cache ();
+
+  cache_dir = get_disk_cache_dir ();
+  g_assert_cmpint (g_mkdir_with_parents (cache_dir, 0700), ==, 0);
+
+  create_fake_cache_entry (cache_dir, "oldest.png", 1000);
+  create_fake_cache_entry (cache_dir, "older.png", 2000);
+  create_fake_cache_entry (cache_dir, "old.png", 3000);
+
+  /* Adding the new copy exceeds the bound until the two least recently
+   * used entries are gone, while the new copy itself is far smaller than
+   * an entry */
+  meta_background_image_cache_set_disk_cache_max_size (cache,
+                                                       FAKE_ENTRY_SIZE * 3 / 2);
+
+  file = create_source_image ("eviction.png");
+  image = meta_background_image_cache_load_scaled (cache, file,
+                                                   MAX_SIZE, MAX_SIZE);
+  wait_for_load (image);
+  assert_loaded_scaled (image);
+
+  names = list_cache_entries (cache_dir);
+  g_assert_cmpuint (g_list_length (names), ==, 2);
+  g_assert_nonnull (g_list_find_custom (names, "old.png",
+                                        (GCompareFunc) g_strcmp0));
+  g_assert_null (g_list_find_custom (names, "older.png",
+                                     (GCompareFunc) g_strcmp0));
+  g_assert_null (g_list_find_custom (names, "oldest.png",
+                                     (GCompareFunc) g_strcmp0));
+  g_list_free_full (names, g_free);
+
+  meta_background_image_cache_set_disk_cache_max_size (cache,
+                                                       DEFAULT_DISK_CACHE_MAX_SIZE);
+}
+
+static void
+meta_test_background_image_unstatable_source (void)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  g_autoptr (GFile) source_file = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (MetaBackgroundImage) image = NULL;
+  g_autofree char *cache_dir = NULL;
+  GList *names = NULL;
+
+  clear_disk_cache ();
+
+  source_file = create_source_image ("unstatable.png");
+  file = meta_test_unstatable_file_new (source_file);
+  image = meta_background_image_cache_load_scaled (cache, file,
+                                                   MAX_SIZE, MAX_SIZE);
+  wait_for_load (image);
+  assert_loaded_scaled (image);
+
+  cache_dir = get_disk_cache_dir ();
+  if (g_file_test (cache_dir, G_FILE_TEST_IS_DIR))
+    names = list_cache_entries (cache_dir);
+  g_assert_null (names);
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/background-image/disk-cache/eviction",
+                   meta_test_background_image_disk_cache_eviction);
+  g_test_add_func ("/background-image/disk-cache/unstatable-source",
+                   meta_test_background_image_unstatable_source);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree char *cache_home = NULL;
+  int ret;
+
+  test_dir = g_dir_make_tmp ("mutter-background-image-test-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  /* Keep the disk cache away from the one of the user running the tests */
+  cache_home = g_build_filename (test_dir, "cache", NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_home, TRUE);
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NO_X11);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  init_tests ();
+
+  ret = meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                     META_TEST_RUN_FLAG_NONE);
+
+  g_free (test_dir);
+
+  return ret;
+}
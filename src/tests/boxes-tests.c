@@ -571,6 +571,186 @@ test_region_fitting (void)
   meta_rectangle_free_list_and_elements (region);
 }
 
+static void
+verify_region_matches_list (MetaSpanningRegion *region,
+                            GList              *answer)
+{
+  GList *code = NULL;
+  int i;
+
+  for (i = region->n_rects - 1; i >= 0; i--)
+    code = g_list_prepend (code, &region->rects[i]);
+
+  verify_lists_are_equal (code, answer);
+  g_list_free (code);
+}
+
+static MetaSpanningRegion *
+get_screen_spanning_region (int which)
+{
+  MetaSpanningRegion *ret;
+  GSList *struts;
+  MtkRectangle basic_rect;
+
+  basic_rect = MTK_RECTANGLE_INIT (0, 0, 1600, 1200);
+
+  struts = get_strut_list (which);
+  ret = meta_spanning_region_new_for_struts (&basic_rect, struts);
+  free_strut_list (struts);
+
+  return ret;
+}
+
+static void
+test_spanning_regions (void)
+{
+  MetaSpanningRegion *region;
+  GList *answer;
+  MtkRectangle rect;
+  int which, i;
+
+  for (which = 0; which <= 4; which++)
+    {
+      region = get_screen_spanning_region (which);
+      answer = get_screen_region (which);
+      verify_region_matches_list (region, answer);
+
+      for (i = 0; i < NUM_RANDOM_RUNS; i++)
+        {
+          get_random_rect (&rect);
+          g_assert (meta_spanning_region_contains_rect (region, &rect) ==
+                    meta_rectangle_contained_in_region (answer, &rect));
+          g_assert (meta_spanning_region_could_fit_rect (region, &rect) ==
+                    meta_rectangle_could_fit_in_region (answer, &rect));
+        }
+
+      meta_rectangle_free_list_and_elements (answer);
+      meta_spanning_region_free (region);
+    }
+
+  g_test_expect_message ("libmutter", G_LOG_LEVEL_WARNING,
+                         "Region to merge was empty!*");
+  region = get_screen_spanning_region (5);
+  g_test_assert_expected_messages ();
+
+  g_assert_true (meta_spanning_region_is_empty (region));
+  meta_spanning_region_free (region);
+}
+
+#define NUM_TIMING_MONITORS 8
+#define NUM_TIMING_RUNS 20
+
+static void
+test_spanning_region_timing (void)
+{
+  MtkRectangle monitors[NUM_TIMING_MONITORS];
+  MtkRectangle screen = MTK_RECTANGLE_INIT (0, 0, 4 * 1920, 2 * 1080);
+  GSList *struts = NULL;
+  gint64 start_us, list_us, array_us;
+  int run, i;
+
+  /* A 4x2 grid of monitors, each with a top panel, a partial bottom dock
+   * and three more partial struts; 40 struts in total.
+   */
+  for (i = 0; i < NUM_TIMING_MONITORS; i++)
+    {
+      MtkRectangle *monitor = &monitors[i];
+      int x, y;
+
+      *monitor = MTK_RECTANGLE_INIT ((i % 4) * 1920, (i / 4) * 1080,
+                                     1920, 1080);
+      x = monitor->x;
+      y = monitor->y;
+
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (x, y, 1920, 32,
+                                                META_SIDE_TOP));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (x + 460 + i * 10, y + 1016,
+                                                1000, 64,
+                                                META_SIDE_BOTTOM));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (x, y + 200 + i * 20,
+                                                48, 600,
+                                                META_SIDE_LEFT));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (x + 1880, y + 300,
+                                                40, 400 + i * 20,
+                                                META_SIDE_RIGHT));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (x + 100 + i * 30, y + 1040,
+                                                200, 40,
+                                                META_SIDE_BOTTOM));
+    }
+  g_assert_cmpuint (g_slist_length (struts), ==, 40);
+
+  /* Do what ensure_work_areas_validated() does for a workspace */
+  start_us = g_get_monotonic_time ();
+  for (run = 0; run < NUM_TIMING_RUNS; run++)
+    {
+      for (i = 0; i < NUM_TIMING_MONITORS; i++)
+        {
+          GList *region;
+
+          region =
+            meta_rectangle_get_minimal_spanning_set_for_region (&monitors[i],
+                                                                struts);
+          meta_rectangle_free_list_and_elements (region);
+        }
+      meta_rectangle_free_list_and_elements (
+        meta_rectangle_get_minimal_spanning_set_for_region (&screen, struts));
+    }
+  list_us = g_get_monotonic_time () - start_us;
+
+  start_us = g_get_monotonic_time ();
+  for (run = 0; run < NUM_TIMING_RUNS; run++)
+    {
+      for (i = 0; i < NUM_TIMING_MONITORS; i++)
+        {
+          meta_spanning_region_free (
+            meta_spanning_region_new_for_struts (&monitors[i], struts));
+        }
+      meta_spanning_region_free (
+        meta_spanning_region_new_for_struts (&screen, struts));
+    }
+  array_us = g_get_monotonic_time () - start_us;
+
+  g_test_message ("Spanning sets for %d monitors and %u struts: "
+                  "%" G_GINT64_FORMAT " us using lists, "
+                  "%" G_GINT64_FORMAT " us using arrays",
+                  NUM_TIMING_MONITORS, g_slist_length (struts),
+                  list_us / NUM_TIMING_RUNS, array_us / NUM_TIMING_RUNS);
+
+  /* Make sure both describe the same region */
+  for (i = 0; i < NUM_TIMING_MONITORS; i++)
+    {
+      g_autoptr (MetaSpanningRegion) region = NULL;
+      GList *answer;
+      int j;
+
+      region = meta_spanning_region_new_for_struts (&monitors[i], struts);
+      answer = meta_rectangle_get_minimal_spanning_set_for_region (&monitors[i],
+                                                                   struts);
+
+      for (j = 0; j < NUM_RANDOM_RUNS / 10; j++)
+        {
+          MtkRectangle rect;
+
+          rect.x = monitors[i].x + rand () % 1920;
+          rect.y = monitors[i].y + rand () % 1080;
+          rect.width = rand () % 1920 + 1;
+          rect.height = rand () % 1080 + 1;
+
+          g_assert (meta_spanning_region_contains_rect (region, &rect) ==
+                    meta_rectangle_contained_in_region (answer, &rect));
+        }
+
+      meta_rectangle_free_list_and_elements (answer);
+    }
+
+  free_strut_list (struts);
+}
+
 static void
 test_clamping_to_region (void)
 {
@@ -998,6 +1178,156 @@ test_find_onscreen_edges (void)
   meta_rectangle_free_list_and_elements (edges);
 }
 
+#define NUM_EDGE_BENCHMARK_WINDOWS 200
+
+static int
+edge_cmp_strict (gconstpointer a, gconstpointer b)
+{
+  const MetaEdge *a_edge = a;
+  const MetaEdge *b_edge = b;
+  int cmp;
+
+  cmp = meta_rectangle_edge_cmp (a, b);
+  if (cmp != 0)
+    return cmp;
+
+  return (a_edge->rect.width + a_edge->rect.height) -
+         (b_edge->rect.width + b_edge->rect.height);
+}
+
+/* The way edge-resistance.c built window edges before using
+ * MetaRectangleStack, splitting a list of edges by every window above.
+ */
+static GList *
+get_window_edges_by_splitting (const MtkRectangle *rects,
+                               int                 n_rects,
+                               const MtkRectangle *clip)
+{
+  GList *edges = NULL;
+  int i, j;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      g_autoptr (GSList) above = NULL;
+      MtkRectangle reduced;
+      GList *new_edges = NULL;
+      MetaEdge *edge;
+
+      if (!mtk_rectangle_intersect (&rects[i], clip, &reduced))
+        continue;
+
+      for (j = n_rects - 1; j > i; j--)
+        above = g_slist_prepend (above, (gpointer) &rects[j]);
+
+      edge = g_new (MetaEdge, 1);
+      edge->rect = reduced;
+      edge->rect.width = 0;
+      edge->side_type = META_SIDE_RIGHT;
+      edge->edge_type = META_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, edge);
+
+      edge = g_new (MetaEdge, 1);
+      edge->rect = reduced;
+      edge->rect.x += edge->rect.width;
+      edge->rect.width = 0;
+      edge->side_type = META_SIDE_LEFT;
+      edge->edge_type = META_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, edge);
+
+      edge = g_new (MetaEdge, 1);
+      edge->rect = reduced;
+      edge->rect.height = 0;
+      edge->side_type = META_SIDE_BOTTOM;
+      edge->edge_type = META_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, edge);
+
+      edge = g_new (MetaEdge, 1);
+      edge->rect = reduced;
+      edge->rect.y += edge->rect.height;
+      edge->rect.height = 0;
+      edge->side_type = META_SIDE_TOP;
+      edge->edge_type = META_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, edge);
+
+      new_edges =
+        meta_rectangle_remove_intersections_with_boxes_from_edges (new_edges,
+                                                                   above);
+      edges = g_list_concat (new_edges, edges);
+    }
+
+  return g_list_sort (edges, edge_cmp_strict);
+}
+
+static GList *
+get_window_edges_from_stack (MetaRectangleStack *stack,
+                             const MtkRectangle *clip)
+{
+  GList *edges = NULL;
+  int i;
+
+  for (i = 0; i < meta_rectangle_stack_get_length (stack); i++)
+    edges = meta_rectangle_stack_add_window_edges (stack, i, clip, edges);
+
+  return g_list_sort (edges, edge_cmp_strict);
+}
+
+static void
+test_window_edges (void)
+{
+  MtkRectangle clip = MTK_RECTANGLE_INIT (0, 0, 1600, 1200);
+  MtkRectangle rects[NUM_EDGE_BENCHMARK_WINDOWS];
+  g_autoptr (MetaRectangleStack) stack = NULL;
+  GList *edges, *answer;
+  gint64 start_us, split_us, stack_us;
+  int i;
+
+  /* Windows sharing sides with each other and the clip exercise the
+   * special handling of opposing sides.
+   */
+  rects[0] = MTK_RECTANGLE_INIT (0, 0, 800, 600);
+  rects[1] = MTK_RECTANGLE_INIT (800, 0, 800, 600);
+  rects[2] = MTK_RECTANGLE_INIT (400, 300, 800, 600);
+  rects[3] = MTK_RECTANGLE_INIT (400, 300, 400, 300);
+  for (i = 4; i < NUM_EDGE_BENCHMARK_WINDOWS; i++)
+    get_random_rect (&rects[i]);
+
+  start_us = g_get_monotonic_time ();
+  answer = get_window_edges_by_splitting (rects,
+                                          NUM_EDGE_BENCHMARK_WINDOWS,
+                                          &clip);
+  split_us = g_get_monotonic_time () - start_us;
+
+  start_us = g_get_monotonic_time ();
+  stack = meta_rectangle_stack_new ();
+  for (i = 0; i < NUM_EDGE_BENCHMARK_WINDOWS; i++)
+    meta_rectangle_stack_push (stack, &rects[i]);
+  edges = get_window_edges_from_stack (stack, &clip);
+  stack_us = g_get_monotonic_time () - start_us;
+
+  g_test_message ("Edges of %d windows: %" G_GINT64_FORMAT " us splitting, "
+                  "%" G_GINT64_FORMAT " us using a rectangle stack",
+                  NUM_EDGE_BENCHMARK_WINDOWS, split_us, stack_us);
+
+  verify_edge_lists_are_equal (edges, answer);
+  meta_rectangle_free_list_and_elements (edges);
+  meta_rectangle_free_list_and_elements (answer);
+
+  /* Move some windows around, as happens when windows move while dragging */
+  for (i = 0; i < NUM_EDGE_BENCHMARK_WINDOWS; i += 17)
+    {
+      get_random_rect (&rects[i]);
+      meta_rectangle_stack_set_rect (stack, i, &rects[i]);
+    }
+
+  answer = get_window_edges_by_splitting (rects,
+                                          NUM_EDGE_BENCHMARK_WINDOWS,
+                                          &clip);
+  edges = get_window_edges_from_stack (stack, &clip);
+  verify_edge_lists_are_equal (edges, answer);
+  meta_rectangle_free_list_and_elements (edges);
+  meta_rectangle_free_list_and_elements (answer);
+}
+
 static void
 test_find_nonintersected_monitor_edges (void)
 {
@@ -1242,6 +1572,9 @@ init_boxes_tests (void)
 
   g_test_add_func ("/util/boxes/regions-ok", test_regions_okay);
   g_test_add_func ("/util/boxes/regions-fitting", test_region_fitting);
+  g_test_add_func ("/util/boxes/spanning-regions", test_spanning_regions);
+  g_test_add_func ("/util/boxes/spanning-region-timing",
+                   test_spanning_region_timing);
 
   g_test_add_func ("/util/boxes/clamp-to-region", test_clamping_to_region);
   g_test_add_func ("/util/boxes/clip-to-region", test_clipping_to_region);
@@ -1251,6 +1584,7 @@ init_boxes_tests (void)
   g_test_add_func ("/util/boxes/onscreen-edges", test_find_onscreen_edges);
   g_test_add_func ("/util/boxes/nonintersected-monitor-edges",
                    test_find_nonintersected_monitor_edges);
+  g_test_add_func ("/util/boxes/window-edges", test_window_edges);
 
   /* And now the misfit functions that don't quite fit in anywhere else... */
   g_test_add_func ("/util/boxes/gravity-resize", test_gravity_resize);
@@ -16,6 +16,8 @@ struct _TestActor
 
   guint preferred_width_called  : 1;
   guint preferred_height_called : 1;
+
+  guint n_width_requests;
 };
 
 GType test_actor_get_type (void);
@@ -31,6 +33,7 @@ test_actor_get_preferred_width (ClutterActor *self,
   TestActor *test = (TestActor *) self;
 
   test->preferred_width_called = TRUE;
+  test->n_width_requests++;
 
   if (for_height == 10)
     {
@@ -140,6 +143,44 @@ actor_preferred_size (void)
   clutter_actor_destroy (test);
 }
 
+static void
+actor_preferred_size_cache (void)
+{
+  ClutterActor *test;
+  TestActor *self;
+  gfloat min_width, nat_width;
+  int i;
+
+  test = g_object_new (TEST_TYPE_ACTOR, NULL);
+  self = (TestActor *) test;
+
+  /* More different sizes than the initial cache holds, like a layout
+   * manager distributing space among its children would ask for */
+  for (i = 0; i < 8; i++)
+    clutter_actor_get_preferred_width (test, i * 10, &min_width, &nat_width);
+
+  g_assert_cmpuint (self->n_width_requests, ==, 8);
+
+  for (i = 0; i < 8; i++)
+    {
+      clutter_actor_get_preferred_width (test, i * 10, &min_width, &nat_width);
+      g_assert_cmpfloat (min_width, ==, i == 1 ? 10 : 100);
+      g_assert_cmpfloat (nat_width, ==, 100);
+    }
+
+  g_assert_cmpuint (self->n_width_requests, ==, 8);
+
+  /* Queueing a relayout drops all cached requests */
+  clutter_actor_queue_relayout (test);
+
+  for (i = 0; i < 8; i++)
+    clutter_actor_get_preferred_width (test, i * 10, &min_width, &nat_width);
+
+  g_assert_cmpuint (self->n_width_requests, ==, 16);
+
+  clutter_actor_destroy (test);
+}
+
 static void
 actor_fixed_size (void)
 {
@@ -214,5 +255,6 @@ actor_fixed_size (void)
 
 CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/actor/size/preferred", actor_preferred_size)
+  CLUTTER_TEST_UNIT ("/actor/size/preferred-cache", actor_preferred_size_cache)
   CLUTTER_TEST_UNIT ("/actor/size/fixed", actor_fixed_size)
 )
@@ -663,6 +663,108 @@ event_delivery_actor_stop_sequence_event (void)
   g_signal_handlers_disconnect_by_func (stage, on_after_update, &was_updated);
 }
 
+#define N_TOUCHES 10
+#define N_TOUCH_UPDATES 8
+
+static void
+event_delivery_touch_implicit_grab_crossings (void)
+{
+  ClutterActor *stage = clutter_test_get_stage ();
+  ClutterSeat *seat =
+    clutter_backend_get_default_seat (clutter_get_default_backend ());
+  g_autoptr (ClutterVirtualInputDevice) virtual_touchscreen = NULL;
+  int64_t now_us;
+  ClutterActor *child;
+  gboolean was_updated;
+  unsigned int n_child_touch_events;
+  unsigned int n_child_leave_events = 0;
+  int i, j;
+
+  virtual_touchscreen =
+    clutter_seat_create_virtual_device (seat, CLUTTER_TOUCHSCREEN_DEVICE);
+  now_us = g_get_monotonic_time ();
+
+  child = clutter_actor_new ();
+  clutter_actor_set_reactive (child, TRUE);
+  clutter_actor_set_size (child, 20, 20);
+  clutter_actor_add_child (stage, child);
+
+  g_signal_connect (stage, "after-update", G_CALLBACK (on_after_update),
+                    &was_updated);
+  g_signal_connect (child, "captured-event::touch", G_CALLBACK (on_event_return_propagate),
+                    &n_child_touch_events);
+  g_signal_connect (child, "leave-event", G_CALLBACK (on_event_return_propagate),
+                    &n_child_leave_events);
+
+  clutter_actor_show (stage);
+  wait_stage_updated (&was_updated);
+
+  n_child_touch_events = 0;
+  for (i = 0; i < N_TOUCHES; i++)
+    {
+      clutter_virtual_input_device_notify_touch_down (virtual_touchscreen,
+                                                      now_us, i,
+                                                      1 + i, 1 + i);
+    }
+  wait_stage_updated (&was_updated);
+  g_assert_cmpint (n_child_touch_events, ==, N_TOUCHES);
+
+  /* Updates staying within the child reach it without any crossing */
+  n_child_touch_events = 0;
+  for (j = 0; j < N_TOUCH_UPDATES; j++)
+    {
+      for (i = 0; i < N_TOUCHES; i++)
+        {
+          clutter_virtual_input_device_notify_touch_motion (virtual_touchscreen,
+                                                            now_us, i,
+                                                            2 + i + j,
+                                                            2 + i + j);
+        }
+      wait_stage_updated (&was_updated);
+    }
+  g_assert_cmpint (n_child_touch_events, ==, N_TOUCHES * N_TOUCH_UPDATES);
+  g_assert_cmpint (n_child_leave_events, ==, 0);
+
+  /* Leaving the child emits the crossing right away, while the child still
+   * holds the implicit grab.
+   */
+  n_child_touch_events = 0;
+  for (i = 0; i < N_TOUCHES; i++)
+    {
+      clutter_virtual_input_device_notify_touch_motion (virtual_touchscreen,
+                                                        now_us, i,
+                                                        100 + i, 100 + i);
+    }
+  wait_stage_updated (&was_updated);
+  g_assert_cmpint (n_child_touch_events, ==, N_TOUCHES);
+  g_assert_cmpint (n_child_leave_events, ==, N_TOUCHES);
+
+  /* Moving around outside the child doesn't break the grab */
+  n_child_touch_events = 0;
+  for (j = 0; j < N_TOUCH_UPDATES; j++)
+    {
+      for (i = 0; i < N_TOUCHES; i++)
+        {
+          clutter_virtual_input_device_notify_touch_motion (virtual_touchscreen,
+                                                            now_us, i,
+                                                            101 + i + j,
+                                                            101 + i + j);
+        }
+      wait_stage_updated (&was_updated);
+    }
+  g_assert_cmpint (n_child_touch_events, ==, N_TOUCHES * N_TOUCH_UPDATES);
+  g_assert_cmpint (n_child_leave_events, ==, N_TOUCHES);
+
+  for (i = 0; i < N_TOUCHES; i++)
+    clutter_virtual_input_device_notify_touch_up (virtual_touchscreen, now_us, i);
+  wait_stage_updated (&was_updated);
+
+  g_signal_handlers_disconnect_by_func (child, on_event_return_propagate, &n_child_leave_events);
+  g_signal_handlers_disconnect_by_func (child, on_event_return_propagate, &n_child_touch_events);
+  clutter_actor_destroy (child);
+  g_signal_handlers_disconnect_by_func (stage, on_after_update, &was_updated);
+}
+
 CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/event/delivery/consecutive-touch-begin-end", event_delivery_consecutive_touch_begin_end);
   CLUTTER_TEST_UNIT ("/event/delivery/implicit-grabbing", event_delivery_implicit_grabbing);
@@ -670,4 +772,5 @@ CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/event/delivery/implicit-grab-existing-clutter-grab", event_delivery_implicit_grab_existing_clutter_grab);
   CLUTTER_TEST_UNIT ("/event/delivery/stop-discrete-event", event_delivery_stop_discrete_event);
   CLUTTER_TEST_UNIT ("/event/delivery/actor-stop-sequence-event", event_delivery_actor_stop_sequence_event);
+  CLUTTER_TEST_UNIT ("/event/delivery/touch-implicit-grab-crossings", event_delivery_touch_implicit_grab_crossings);
 )
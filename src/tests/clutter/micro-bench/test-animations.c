@@ -0,0 +1,136 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+
+#include "tests/clutter-test-utils.h"
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define N_ACTORS 1000
+#define ACTOR_SIZE 16
+#define N_TRANSITIONS 5
+
+static const ClutterAnimationMode modes[] = {
+  CLUTTER_LINEAR,
+  CLUTTER_EASE_IN_OUT_QUAD,
+  CLUTTER_EASE_OUT_CUBIC,
+  CLUTTER_EASE_IN_OUT_SINE,
+  CLUTTER_EASE_OUT_BOUNCE,
+};
+
+static void
+on_after_paint (ClutterActor     *actor,
+                ClutterStageView *view,
+                ClutterFrame     *frame,
+                gconstpointer     data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, frame time=%.3f ms, transitions/sec=%d\n",
+              fps,
+              fps > 0 ? g_timer_elapsed (timer, NULL) * 1000.0 / fps : 0.0,
+              fps * N_ACTORS * N_TRANSITIONS);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+static void
+repeat_transition (ClutterActor *actor,
+                   const char   *name)
+{
+  ClutterTransition *transition;
+
+  transition = clutter_actor_get_transition (actor, name);
+  clutter_timeline_set_repeat_count (CLUTTER_TIMELINE (transition), -1);
+  clutter_timeline_set_auto_reverse (CLUTTER_TIMELINE (transition), TRUE);
+}
+
+static void
+animate_actor (ClutterActor *actor,
+               int           i)
+{
+  clutter_actor_save_easing_state (actor);
+  clutter_actor_set_easing_mode (actor, modes[i % G_N_ELEMENTS (modes)]);
+  clutter_actor_set_easing_duration (actor, 1000 + (i % 7) * 250);
+
+  clutter_actor_set_translation (actor,
+                                 g_random_double_range (-100, 100),
+                                 g_random_double_range (-100, 100),
+                                 0.f);
+  clutter_actor_set_opacity (actor, 0);
+  clutter_actor_set_scale (actor, 2.0, 2.0);
+
+  clutter_actor_restore_easing_state (actor);
+
+  repeat_transition (actor, "translation-x");
+  repeat_transition (actor, "translation-y");
+  repeat_transition (actor, "opacity");
+  repeat_transition (actor, "scale-x");
+  repeat_transition (actor, "scale-y");
+}
+
+int
+main (int argc, char **argv)
+{
+  ClutterActor *stage;
+  int i;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  clutter_test_init (&argc, &argv);
+
+  stage = clutter_test_get_stage ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_title (CLUTTER_STAGE (stage), "Animations");
+
+  printf ("Animation performance test with %d actors, "
+          "each running %d transitions\n",
+          N_ACTORS, N_TRANSITIONS);
+
+  for (i = 0; i < N_ACTORS; i++)
+    {
+      ClutterActor *actor;
+      ClutterColor color;
+
+      clutter_color_init (&color,
+                          g_random_int_range (0, 255),
+                          g_random_int_range (0, 255),
+                          g_random_int_range (0, 255),
+                          255);
+
+      actor = clutter_actor_new ();
+      clutter_actor_set_background_color (actor, &color);
+      clutter_actor_set_size (actor, ACTOR_SIZE, ACTOR_SIZE);
+      clutter_actor_set_pivot_point (actor, 0.5, 0.5);
+      clutter_actor_set_position (actor,
+                                  g_random_int_range (0, STAGE_WIDTH - ACTOR_SIZE),
+                                  g_random_int_range (0, STAGE_HEIGHT - ACTOR_SIZE));
+      clutter_actor_add_child (stage, actor);
+
+      animate_actor (actor, i);
+    }
+
+  clutter_actor_show (stage);
+
+  g_signal_connect (stage, "after-paint", G_CALLBACK (on_after_paint), NULL);
+
+  clutter_test_main ();
+
+  clutter_actor_destroy (stage);
+
+  return 0;
+}
@@ -0,0 +1,411 @@
+#include "config.h"
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-atlas.h"
+#include "cogl/cogl-rectangle-map.h"
+#include "cogl-pango/cogl-pango.h"
+#include "cogl-pango/cogl-pango-glyph-cache.h"
+#include "tests/cogl-test-utils.h"
+
+#define N_GLYPHS_PER_FONT_SIZE 96
+
+typedef struct
+{
+  CoglTexture *texture;
+  CoglRectangleMapEntry rectangle;
+  gboolean evicted;
+  unsigned int n_updates;
+} TestEntry;
+
+typedef struct
+{
+  unsigned int n_reorganizations;
+} TestAtlasStats;
+
+typedef struct
+{
+  PangoFont *font;
+  PangoGlyph glyph;
+  CoglPangoGlyphCacheValue *value;
+  CoglTexture *texture;
+  int tx_pixel;
+  int ty_pixel;
+} TestCachedGlyph;
+
+static void
+collect_rectangle_cb (const CoglRectangleMapEntry *rectangle,
+                      void                        *rectangle_data,
+                      void                        *user_data)
+{
+  GArray *rectangles = user_data;
+
+  g_array_append_val (rectangles, *rectangle);
+}
+
+static gboolean
+rectangles_overlap (const CoglRectangleMapEntry *a,
+                    const CoglRectangleMapEntry *b)
+{
+  return (a->x < b->x + b->width &&
+          b->x < a->x + a->width &&
+          a->y < b->y + b->height &&
+          b->y < a->y + a->height);
+}
+
+static void
+check_skyline_packing (void)
+{
+  g_autoptr (GRand) rand = g_rand_new_with_seed (0x5eed);
+  g_autoptr (GArray) rectangles = NULL;
+  CoglRectangleMap *map;
+  unsigned int used_space = 0;
+  unsigned int n_failed = 0;
+  unsigned int i, j;
+
+  map = _cogl_rectangle_map_new_skyline (256, 256, NULL);
+
+  /* Keep adding glyph sized rectangles until a few of them didn't fit
+     anymore */
+  while (n_failed < 16)
+    {
+      unsigned int width = g_rand_int_range (rand, 1, 24);
+      unsigned int height = g_rand_int_range (rand, 8, 24);
+      CoglRectangleMapEntry rectangle;
+
+      if (_cogl_rectangle_map_add (map, width, height, NULL, &rectangle))
+        {
+          g_assert_cmpuint (rectangle.width, ==, width);
+          g_assert_cmpuint (rectangle.height, ==, height);
+          used_space += width * height;
+        }
+      else
+        {
+          n_failed++;
+        }
+    }
+
+  g_assert_cmpuint (_cogl_rectangle_map_get_remaining_space (map),
+                    ==,
+                    256 * 256 - used_space);
+
+  /* Skyline packing should leave little waste for similar sizes */
+  g_assert_cmpuint (used_space, >, 256 * 256 * 3 / 4);
+
+  rectangles = g_array_new (FALSE, FALSE, sizeof (CoglRectangleMapEntry));
+  _cogl_rectangle_map_foreach (map, collect_rectangle_cb, rectangles);
+  g_assert_cmpuint (rectangles->len,
+                    ==,
+                    _cogl_rectangle_map_get_n_rectangles (map));
+
+  for (i = 0; i < rectangles->len; i++)
+    {
+      CoglRectangleMapEntry *a =
+        &g_array_index (rectangles, CoglRectangleMapEntry, i);
+
+      g_assert_cmpuint (a->x + a->width, <=, 256);
+      g_assert_cmpuint (a->y + a->height, <=, 256);
+
+      for (j = i + 1; j < rectangles->len; j++)
+        {
+          CoglRectangleMapEntry *b =
+            &g_array_index (rectangles, CoglRectangleMapEntry, j);
+
+          g_assert_false (rectangles_overlap (a, b));
+        }
+    }
+
+  /* Once empty, the whole map is available again */
+  for (i = 0; i < rectangles->len; i++)
+    {
+      _cogl_rectangle_map_remove (map,
+                                  &g_array_index (rectangles,
+                                                  CoglRectangleMapEntry,
+                                                  i));
+    }
+
+  g_assert_cmpuint (_cogl_rectangle_map_get_n_rectangles (map), ==, 0);
+  g_assert_cmpuint (_cogl_rectangle_map_get_remaining_space (map),
+                    ==,
+                    256 * 256);
+  g_assert_true (_cogl_rectangle_map_add (map, 256, 256, NULL, NULL));
+
+  _cogl_rectangle_map_free (map);
+}
+
+static void
+update_position_cb (void                        *user_data,
+                    CoglTexture                 *new_texture,
+                    const CoglRectangleMapEntry *rectangle)
+{
+  TestEntry *entry = user_data;
+
+  entry->texture = new_texture;
+  entry->rectangle = *rectangle;
+  entry->n_updates++;
+}
+
+static void
+evict_cb (void *user_data)
+{
+  TestEntry *entry = user_data;
+
+  entry->evicted = TRUE;
+}
+
+static void
+reorganize_cb (void *user_data)
+{
+  TestAtlasStats *stats = user_data;
+
+  stats->n_reorganizations++;
+}
+
+static void
+check_paged_atlas_eviction (void)
+{
+  TestAtlasStats stats = { 0 };
+  TestEntry entries[9] = { 0 };
+  CoglTexture *first_page, *second_page;
+  CoglAtlas *atlas;
+  int i;
+
+  atlas = _cogl_atlas_new_paged (COGL_PIXEL_FORMAT_A_8,
+                                 COGL_ATLAS_CLEAR_TEXTURE |
+                                 COGL_ATLAS_DISABLE_MIGRATION,
+                                 2,
+                                 update_position_cb,
+                                 evict_cb);
+  _cogl_atlas_add_reorganize_callback (atlas, NULL, reorganize_cb, &stats);
+
+  /* Each page fits four of these */
+  for (i = 0; i < 8; i++)
+    {
+      g_assert_true (_cogl_atlas_reserve_space (atlas, 1024, 1024,
+                                                &entries[i]));
+    }
+
+  g_assert_cmpuint (_cogl_atlas_get_n_pages (atlas), ==, 2);
+  g_assert_cmpuint (stats.n_reorganizations, ==, 0);
+
+  first_page = entries[0].texture;
+  second_page = entries[4].texture;
+  g_assert_true (first_page != second_page);
+
+  for (i = 0; i < 8; i++)
+    {
+      g_assert_cmpuint (entries[i].n_updates, ==, 1);
+      g_assert_true (entries[i].texture == (i < 4 ? first_page : second_page));
+    }
+
+  /* Using the first page again makes the second one the least recently
+     used, so that's the one to go */
+  _cogl_atlas_mark_texture_used (atlas, first_page);
+
+  g_assert_true (_cogl_atlas_reserve_space (atlas, 1024, 1024, &entries[8]));
+
+  g_assert_cmpuint (_cogl_atlas_get_n_pages (atlas), ==, 2);
+  g_assert_cmpuint (stats.n_reorganizations, ==, 1);
+
+  for (i = 0; i < 8; i++)
+    g_assert_cmpint (entries[i].evicted, ==, i >= 4);
+
+  g_assert_false (entries[8].evicted);
+  g_assert_true (entries[8].texture != first_page);
+
+  g_object_unref (atlas);
+}
+
+static void
+get_glyph_size (unsigned int  font_size,
+                unsigned int  glyph,
+                unsigned int *width,
+                unsigned int *height)
+{
+  /* Roughly the ink rectangles of the printable ASCII glyphs of a
+     font, plus the pixel of padding the glyph cache adds */
+  *width = MAX (1, font_size * (3 + glyph % 5) / 8) + 1;
+  *height = MAX (1, font_size * (6 + glyph % 3) / 8) + 1;
+}
+
+static void
+benchmark_glyph_insertion (CoglAtlas      *atlas,
+                           TestEntry      *entries,
+                           unsigned int    n_font_sizes,
+                           const char     *name)
+{
+  TestAtlasStats stats = { 0 };
+  unsigned int n_glyphs = n_font_sizes * N_GLYPHS_PER_FONT_SIZE;
+  unsigned int n_updates = 0;
+  int64_t start_time_us, elapsed_us;
+  unsigned int i;
+
+  _cogl_atlas_add_reorganize_callback (atlas, NULL, reorganize_cb, &stats);
+
+  start_time_us = g_get_monotonic_time ();
+
+  for (i = 0; i < n_glyphs; i++)
+    {
+      unsigned int width, height;
+
+      get_glyph_size (8 + i / N_GLYPHS_PER_FONT_SIZE,
+                      i % N_GLYPHS_PER_FONT_SIZE,
+                      &width, &height);
+
+      g_assert_true (_cogl_atlas_reserve_space (atlas, width, height,
+                                                &entries[i]));
+    }
+
+  elapsed_us = MAX (1, g_get_monotonic_time () - start_time_us);
+
+  for (i = 0; i < n_glyphs; i++)
+    n_updates += entries[i].n_updates;
+
+  g_test_message ("%s: %u glyphs in %" G_GINT64_FORMAT " us "
+                  "(%.0f glyphs/s), %u pages, %u migrations, "
+                  "%u glyph redraws",
+                  name, n_glyphs, elapsed_us,
+                  n_glyphs * (double) G_USEC_PER_SEC / elapsed_us,
+                  _cogl_atlas_get_n_pages (atlas),
+                  stats.n_reorganizations,
+                  n_updates);
+
+  _cogl_atlas_remove_reorganize_callback (atlas, NULL, reorganize_cb, &stats);
+}
+
+static void
+check_glyph_insertion_benchmark (void)
+{
+  unsigned int n_font_sizes = 40;
+  g_autofree TestEntry *migrating_entries = NULL;
+  g_autofree TestEntry *paged_entries = NULL;
+  unsigned int n_glyphs = n_font_sizes * N_GLYPHS_PER_FONT_SIZE;
+  CoglAtlas *paged_atlas;
+  unsigned int n_paged_updates = 0;
+  unsigned int i;
+
+  paged_entries = g_new0 (TestEntry, n_glyphs);
+
+  /* The way glyphs were stored before, growing a single atlas. This is
+     only there to compare against, so it's left out of normal runs */
+  if (g_test_perf ())
+    {
+      g_autoptr (CoglAtlas) migrating_atlas = NULL;
+
+      migrating_entries = g_new0 (TestEntry, n_glyphs);
+      migrating_atlas = _cogl_atlas_new (COGL_PIXEL_FORMAT_A_8,
+                                         COGL_ATLAS_CLEAR_TEXTURE |
+                                         COGL_ATLAS_DISABLE_MIGRATION,
+                                         update_position_cb);
+      benchmark_glyph_insertion (migrating_atlas, migrating_entries,
+                                 n_font_sizes, "Migrating atlas");
+    }
+
+  paged_atlas = _cogl_atlas_new_paged (COGL_PIXEL_FORMAT_A_8,
+                                       COGL_ATLAS_CLEAR_TEXTURE |
+                                       COGL_ATLAS_DISABLE_MIGRATION,
+                                       0,
+                                       update_position_cb,
+                                       evict_cb);
+  benchmark_glyph_insertion (paged_atlas, paged_entries,
+                             n_font_sizes, "Paged atlas");
+
+  /* Every glyph is positioned exactly once, so none of them ever needs
+     to be drawn again */
+  for (i = 0; i < n_glyphs; i++)
+    {
+      g_assert_false (paged_entries[i].evicted);
+      n_paged_updates += paged_entries[i].n_updates;
+    }
+  g_assert_cmpuint (n_paged_updates, ==, n_glyphs);
+
+  g_object_unref (paged_atlas);
+}
+
+static void
+check_glyph_cache_no_migration (void)
+{
+  g_autoptr (PangoFontMap) font_map = NULL;
+  g_autoptr (PangoContext) context = NULL;
+  g_autoptr (GPtrArray) fonts = NULL;
+  g_autoptr (GArray) first_glyphs = NULL;
+  CoglPangoGlyphCache *cache;
+  unsigned int font_size;
+  unsigned int i;
+
+  font_map = cogl_pango_font_map_new ();
+  context =
+    cogl_pango_font_map_create_context (COGL_PANGO_FONT_MAP (font_map));
+  fonts = g_ptr_array_new_with_free_func (g_object_unref);
+  first_glyphs = g_array_new (FALSE, FALSE, sizeof (TestCachedGlyph));
+
+  cache = cogl_pango_glyph_cache_new (test_ctx, FALSE);
+
+  for (font_size = 8; font_size < 48; font_size++)
+    {
+      g_autoptr (PangoFontDescription) font_desc = NULL;
+      PangoFont *font;
+      PangoGlyph glyph;
+
+      font_desc = pango_font_description_from_string ("Sans");
+      pango_font_description_set_absolute_size (font_desc,
+                                                font_size * PANGO_SCALE);
+      font = pango_context_load_font (context, font_desc);
+      g_assert_nonnull (font);
+      g_ptr_array_add (fonts, font);
+
+      for (glyph = 0; glyph < N_GLYPHS_PER_FONT_SIZE; glyph++)
+        {
+          CoglPangoGlyphCacheValue *value;
+
+          value = cogl_pango_glyph_cache_lookup (cache, TRUE, font, glyph);
+          g_assert_nonnull (value);
+
+          if (font_size == 8 && value->texture)
+            {
+              TestCachedGlyph cached_glyph = {
+                .font = font,
+                .glyph = glyph,
+                .value = value,
+                .texture = value->texture,
+                .tx_pixel = value->tx_pixel,
+                .ty_pixel = value->ty_pixel,
+              };
+
+              g_array_append_val (first_glyphs, cached_glyph);
+            }
+        }
+    }
+
+  g_assert_cmpuint (first_glyphs->len, >, 0);
+
+  /* The glyphs added first are still where they were put, even though
+     thousands of glyphs were added after them */
+  for (i = 0; i < first_glyphs->len; i++)
+    {
+      TestCachedGlyph *cached_glyph =
+        &g_array_index (first_glyphs, TestCachedGlyph, i);
+      CoglPangoGlyphCacheValue *value;
+
+      value = cogl_pango_glyph_cache_lookup (cache, FALSE,
+                                             cached_glyph->font,
+                                             cached_glyph->glyph);
+      g_assert_true (value == cached_glyph->value);
+      g_assert_true (value->texture == cached_glyph->texture);
+      g_assert_cmpint (value->tx_pixel, ==, cached_glyph->tx_pixel);
+      g_assert_cmpint (value->ty_pixel, ==, cached_glyph->ty_pixel);
+
+      /* Glyphs of this size never end up in the migrating global atlas */
+      g_assert_false (COGL_IS_ATLAS_TEXTURE (value->texture));
+    }
+
+  cogl_pango_glyph_cache_free (cache);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/atlas/skyline-packing", check_skyline_packing);
+  g_test_add_func ("/atlas/paged/eviction", check_paged_atlas_eviction);
+  g_test_add_func ("/atlas/paged/glyph-insertion-benchmark",
+                   check_glyph_insertion_benchmark);
+  g_test_add_func ("/atlas/glyph-cache/no-migration",
+                   check_glyph_cache_no_migration);
+)
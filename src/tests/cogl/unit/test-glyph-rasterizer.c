@@ -0,0 +1,86 @@
+#include "config.h"
+
+#include "cogl/cogl.h"
+#include "cogl-pango/cogl-pango-private.h"
+#include "tests/cogl-test-utils.h"
+
+static PangoLayout *
+create_layout (PangoContext *context,
+               const char   *font,
+               const char   *text)
+{
+  g_autoptr (PangoFontDescription) font_desc = NULL;
+  PangoLayout *layout;
+
+  font_desc = pango_font_description_from_string (font);
+
+  layout = pango_layout_new (context);
+  pango_layout_set_font_description (layout, font_desc);
+  pango_layout_set_text (layout, text, -1);
+
+  return layout;
+}
+
+static void
+test_glyph_rasterizer_paint_waits_for_own_glyphs (void)
+{
+  g_autoptr (PangoFontMap) font_map = NULL;
+  g_autoptr (PangoContext) context = NULL;
+  g_autoptr (PangoLayout) small_layout = NULL;
+  g_autoptr (PangoLayout) large_layout = NULL;
+  CoglPangoFontMap *cogl_font_map;
+  unsigned int n_small_glyphs, n_large_glyphs;
+  CoglColor color;
+
+  font_map = cogl_pango_font_map_new ();
+  cogl_font_map = COGL_PANGO_FONT_MAP (font_map);
+  context = cogl_pango_font_map_create_context (cogl_font_map);
+
+  /* Different sizes, so the layouts don't share any glyph */
+  small_layout = create_layout (context, "Sans 10", "small");
+  large_layout = create_layout (context, "Sans 40",
+                                "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+
+  cogl_color_init_from_4f (&color, 1.0, 1.0, 1.0, 1.0);
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+
+  /* Keep the worker thread from drawing anything, so all that gets
+   * drawn is what painting itself waits for.
+   */
+  _cogl_pango_font_map_set_rasterizer_paused (cogl_font_map, TRUE);
+
+  cogl_pango_ensure_glyph_cache_for_layout (small_layout);
+  n_small_glyphs = _cogl_pango_font_map_get_n_pending_glyphs (cogl_font_map);
+  g_assert_cmpuint (n_small_glyphs, >, 0);
+
+  cogl_pango_ensure_glyph_cache_for_layout (large_layout);
+  n_large_glyphs =
+    _cogl_pango_font_map_get_n_pending_glyphs (cogl_font_map) - n_small_glyphs;
+  g_assert_cmpuint (n_large_glyphs, >, 0);
+
+  /* Painting the small layout only draws its own glyphs */
+  cogl_pango_show_layout (test_fb, small_layout, 0, 0, &color);
+  g_assert_cmpuint (_cogl_pango_font_map_get_n_pending_glyphs (cogl_font_map),
+                    ==,
+                    n_large_glyphs);
+
+  /* Painting it again doesn't touch the remaining glyphs either */
+  cogl_pango_show_layout (test_fb, small_layout, 0, 0, &color);
+  g_assert_cmpuint (_cogl_pango_font_map_get_n_pending_glyphs (cogl_font_map),
+                    ==,
+                    n_large_glyphs);
+
+  _cogl_pango_font_map_set_rasterizer_paused (cogl_font_map, FALSE);
+
+  cogl_pango_show_layout (test_fb, large_layout, 0, 50, &color);
+  g_assert_cmpuint (_cogl_pango_font_map_get_n_pending_glyphs (cogl_font_map),
+                    ==,
+                    0);
+
+  cogl_framebuffer_finish (test_fb);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/glyph-rasterizer/paint-waits-for-own-glyphs",
+                   test_glyph_rasterizer_paint_waits_for_own_glyphs);
+)
@@ -0,0 +1,227 @@
+#include "config.h"
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-pipeline-private.h"
+#include "tests/cogl-test-utils.h"
+
+#define N_ENTRIES 2000
+#define N_TEMPLATES 4
+#define N_ENTRIES_PER_RUN 8
+#define N_BENCHMARK_FRAMES 50
+
+static CoglPipeline *
+create_template (CoglTexture *texture,
+                 int          n)
+{
+  CoglPipeline *pipeline;
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+
+  /* Roughly the variants MetaShapedTexture switches between */
+  if (n & 1)
+    {
+      cogl_pipeline_set_layer_combine (pipeline, 1,
+                                       "RGBA = MODULATE (PREVIOUS, TEXTURE[A])",
+                                       NULL);
+      cogl_pipeline_set_layer_texture (pipeline, 1, texture);
+    }
+  if (n & 2)
+    cogl_pipeline_set_blend (pipeline, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+
+  return pipeline;
+}
+
+static void
+test_journal_equal (void)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (CoglPipeline) template = NULL;
+  g_autoptr (CoglPipeline) a = NULL;
+  g_autoptr (CoglPipeline) b = NULL;
+  g_autoptr (CoglPipeline) c = NULL;
+  g_autoptr (CoglPipeline) d = NULL;
+  g_autoptr (CoglPipeline) e = NULL;
+  CoglColor color;
+
+  texture = test_utils_create_color_texture (test_ctx, 0xff0000ff);
+  template = create_template (texture, 0);
+
+  a = cogl_pipeline_copy (template);
+  b = cogl_pipeline_copy (template);
+  g_assert_true (_cogl_pipeline_journal_equal (a, b));
+  g_assert_true (_cogl_pipeline_journal_equal (b, a));
+
+  /* The color is logged with the vertices so it doesn't matter */
+  cogl_color_init_from_4f (&color, 0.0, 1.0, 0.0, 1.0);
+  cogl_pipeline_set_color (b, &color);
+  g_assert_true (_cogl_pipeline_journal_equal (a, b));
+
+  /* Changes after the digest has been calculated have to be noticed */
+  cogl_pipeline_set_layer_filters (b, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+  g_assert_false (_cogl_pipeline_journal_equal (a, b));
+  g_assert_false (_cogl_pipeline_journal_equal (b, a));
+
+  cogl_pipeline_set_layer_filters (a, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+  g_assert_true (_cogl_pipeline_journal_equal (a, b));
+
+  c = create_template (texture, 3);
+  g_assert_false (_cogl_pipeline_journal_equal (a, c));
+  g_assert_cmpint (_cogl_pipeline_journal_equal (a, c),
+                   ==,
+                   _cogl_pipeline_equal (a, c,
+                                         COGL_PIPELINE_STATE_ALL &
+                                         ~COGL_PIPELINE_STATE_COLOR,
+                                         COGL_PIPELINE_LAYER_STATE_ALL));
+
+  /* Whether blending is needed isn't part of the digest, but a
+     translucent color still has to split a batch */
+  d = cogl_pipeline_new (test_ctx);
+  e = cogl_pipeline_new (test_ctx);
+  g_assert_true (_cogl_pipeline_journal_equal (d, e));
+
+  cogl_color_init_from_4f (&color, 0.0, 0.5, 0.0, 0.5);
+  cogl_pipeline_set_color (e, &color);
+  g_assert_false (_cogl_pipeline_journal_equal (d, e));
+}
+
+static void
+create_entry_pipelines (CoglPipeline **templates,
+                        CoglPipeline **pipelines)
+{
+  int i;
+
+  /* Short lived derived pipelines, a new one for every entry, in
+     runs that the journal can batch */
+  for (i = 0; i < N_ENTRIES; i++)
+    {
+      CoglColor color;
+
+      pipelines[i] =
+        cogl_pipeline_copy (templates[(i / N_ENTRIES_PER_RUN) % N_TEMPLATES]);
+
+      cogl_color_init_from_4f (&color, 1.0, 1.0, 1.0, 1.0);
+      cogl_pipeline_set_color (pipelines[i], &color);
+    }
+}
+
+static int64_t
+time_comparisons (CoglPipeline **pipelines,
+                  gboolean       use_digest,
+                  int           *n_batches)
+{
+  int64_t start_time_us;
+  int i;
+
+  *n_batches = 1;
+
+  start_time_us = g_get_monotonic_time ();
+
+  for (i = 1; i < N_ENTRIES; i++)
+    {
+      gboolean equal;
+
+      if (use_digest)
+        {
+          equal = _cogl_pipeline_journal_equal (pipelines[i - 1],
+                                                pipelines[i]);
+        }
+      else
+        {
+          equal = _cogl_pipeline_equal (pipelines[i - 1],
+                                        pipelines[i],
+                                        COGL_PIPELINE_STATE_ALL &
+                                        ~COGL_PIPELINE_STATE_COLOR,
+                                        COGL_PIPELINE_LAYER_STATE_ALL);
+        }
+
+      if (!equal)
+        (*n_batches)++;
+    }
+
+  return g_get_monotonic_time () - start_time_us;
+}
+
+static void
+test_journal_batching (void)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  CoglPipeline *templates[N_TEMPLATES];
+  g_autofree CoglPipeline **pipelines = NULL;
+  int64_t equal_us, digest_us, cached_digest_us;
+  int64_t flush_us = 0;
+  int n_batches, n_digest_batches, n_cached_digest_batches;
+  int frame, i;
+
+  texture = test_utils_create_color_texture (test_ctx, 0xff0000ff);
+  for (i = 0; i < N_TEMPLATES; i++)
+    templates[i] = create_template (texture, i);
+
+  pipelines = g_new0 (CoglPipeline *, N_ENTRIES);
+  create_entry_pipelines (templates, pipelines);
+
+  equal_us = time_comparisons (pipelines, FALSE, &n_batches);
+  digest_us = time_comparisons (pipelines, TRUE, &n_digest_batches);
+  cached_digest_us = time_comparisons (pipelines, TRUE,
+                                       &n_cached_digest_batches);
+
+  g_assert_cmpint (n_batches, ==, N_ENTRIES / N_ENTRIES_PER_RUN);
+  g_assert_cmpint (n_digest_batches, ==, n_batches);
+  g_assert_cmpint (n_cached_digest_batches, ==, n_batches);
+
+  for (i = 0; i < N_ENTRIES; i++)
+    g_object_unref (pipelines[i]);
+
+  /* Everything below only measures how long things take */
+  if (!g_test_perf ())
+    goto out;
+
+  g_test_message ("Comparing %d entries: %" G_GINT64_FORMAT " us "
+                  "with full comparisons, %" G_GINT64_FORMAT " us "
+                  "calculating digests, %" G_GINT64_FORMAT " us "
+                  "with cached digests",
+                  N_ENTRIES, equal_us, digest_us, cached_digest_us);
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+
+  for (frame = 0; frame < N_BENCHMARK_FRAMES; frame++)
+    {
+      int64_t start_time_us;
+
+      create_entry_pipelines (templates, pipelines);
+
+      for (i = 0; i < N_ENTRIES; i++)
+        {
+          float x = i % 64 * 8;
+          float y = i / 64 * 8;
+
+          cogl_framebuffer_draw_rectangle (test_fb, pipelines[i],
+                                           x, y, x + 8, y + 8);
+          g_object_unref (pipelines[i]);
+        }
+
+      start_time_us = g_get_monotonic_time ();
+      cogl_framebuffer_flush (test_fb);
+      flush_us += g_get_monotonic_time () - start_time_us;
+
+      cogl_framebuffer_finish (test_fb);
+    }
+
+  g_test_message ("Flushing a journal with %d entries in %d batches: "
+                  "%.1f us per flush",
+                  N_ENTRIES, n_batches,
+                  flush_us / (double) N_BENCHMARK_FRAMES);
+
+out:
+  for (i = 0; i < N_TEMPLATES; i++)
+    g_object_unref (templates[i]);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/pipeline/journal-equal", test_journal_equal);
+  g_test_add_func ("/journal/batching", test_journal_batching);
+)
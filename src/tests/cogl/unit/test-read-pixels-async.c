@@ -0,0 +1,250 @@
+#include "config.h"
+
+#include "cogl/cogl.h"
+#include "tests/cogl-test-utils.h"
+
+#define BENCHMARK_WIDTH 3840
+#define BENCHMARK_HEIGHT 2160
+#define N_BENCHMARK_FRAMES 20
+#define N_BENCHMARK_RECTANGLES 200
+
+typedef struct
+{
+  CoglBitmap *bitmap;
+  GError *error;
+  gboolean done;
+} ReadPixelsResult;
+
+static void
+on_read_pixels (GObject      *source_object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  ReadPixelsResult *read_result = user_data;
+
+  read_result->bitmap =
+    cogl_framebuffer_read_pixels_finish (COGL_FRAMEBUFFER (source_object),
+                                         result,
+                                         &read_result->error);
+  read_result->done = TRUE;
+}
+
+static void
+wait_for_read_pixels (ReadPixelsResult *read_result)
+{
+  while (!read_result->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static CoglFramebuffer *
+create_offscreen (int width,
+                  int height)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglOffscreen *offscreen;
+
+  texture = cogl_texture_2d_new_with_size (test_ctx, width, height);
+  offscreen = cogl_offscreen_new_with_texture (texture);
+  cogl_framebuffer_allocate (COGL_FRAMEBUFFER (offscreen), &error);
+  g_assert_no_error (error);
+
+  return COGL_FRAMEBUFFER (offscreen);
+}
+
+static void
+draw_rectangles (CoglFramebuffer *framebuffer,
+                 int              n_rectangles)
+{
+  g_autoptr (CoglPipeline) pipeline = NULL;
+  int width = cogl_framebuffer_get_width (framebuffer);
+  int height = cogl_framebuffer_get_height (framebuffer);
+  int i;
+
+  pipeline = cogl_pipeline_new (test_ctx);
+
+  cogl_framebuffer_orthographic (framebuffer, 0, 0, width, height, -1, 100);
+  cogl_framebuffer_clear4f (framebuffer, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* Overlapping blended quads, to keep the GPU busy for a while */
+  for (i = 0; i < n_rectangles; i++)
+    {
+      CoglColor color;
+
+      cogl_color_init_from_4f (&color,
+                               (i % 3) / 4.0f,
+                               (i % 5) / 8.0f,
+                               (i % 7) / 12.0f,
+                               0.5f);
+      cogl_pipeline_set_color (pipeline, &color);
+      cogl_framebuffer_draw_rectangle (framebuffer, pipeline,
+                                       (i * 37) % (width / 2),
+                                       (i * 53) % (height / 2),
+                                       (i * 37) % (width / 2) + width / 2,
+                                       (i * 53) % (height / 2) + height / 2);
+    }
+}
+
+static void
+check_bitmap_pixel (CoglBitmap *bitmap,
+                    int         x,
+                    int         y,
+                    uint32_t    expected_pixel)
+{
+  CoglBuffer *buffer = COGL_BUFFER (cogl_bitmap_get_buffer (bitmap));
+  int rowstride = cogl_bitmap_get_rowstride (bitmap);
+  uint8_t *pixels;
+
+  pixels = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0);
+  g_assert_nonnull (pixels);
+
+  test_utils_compare_pixel (pixels + y * rowstride + x * 4, expected_pixel);
+
+  cogl_buffer_unmap (buffer);
+}
+
+static void
+test_read_pixels_async (void)
+{
+  ReadPixelsResult read_result = { 0 };
+  g_autoptr (CoglPipeline) pipeline = NULL;
+  CoglColor color;
+
+  /* Red on the top, blue on the bottom, to catch flipped reads */
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+  cogl_color_init_from_4f (&color, 1.0, 0.0, 0.0, 1.0);
+  cogl_pipeline_set_color (pipeline, &color);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                   0, 0, FB_WIDTH, FB_HEIGHT / 2);
+  cogl_color_init_from_4f (&color, 0.0, 0.0, 1.0, 1.0);
+  cogl_pipeline_set_color (pipeline, &color);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                   0, FB_HEIGHT / 2, FB_WIDTH, FB_HEIGHT);
+
+  cogl_framebuffer_read_pixels_async (test_fb,
+                                      0, 0,
+                                      FB_WIDTH, FB_HEIGHT,
+                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                      NULL,
+                                      on_read_pixels,
+                                      &read_result);
+  g_assert_false (read_result.done);
+
+  wait_for_read_pixels (&read_result);
+  g_assert_no_error (read_result.error);
+  g_assert_nonnull (read_result.bitmap);
+
+  g_assert_cmpint (cogl_bitmap_get_width (read_result.bitmap), ==, FB_WIDTH);
+  g_assert_cmpint (cogl_bitmap_get_height (read_result.bitmap), ==, FB_HEIGHT);
+  check_bitmap_pixel (read_result.bitmap, 10, 10, 0xff0000ff);
+  check_bitmap_pixel (read_result.bitmap, 10, FB_HEIGHT - 10, 0x0000ffff);
+
+  g_object_unref (read_result.bitmap);
+}
+
+static void
+test_read_pixels_async_cancel (void)
+{
+  ReadPixelsResult read_result = { 0 };
+  g_autoptr (GCancellable) cancellable = NULL;
+
+  cancellable = g_cancellable_new ();
+  cogl_framebuffer_read_pixels_async (test_fb,
+                                      0, 0,
+                                      FB_WIDTH, FB_HEIGHT,
+                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                      cancellable,
+                                      on_read_pixels,
+                                      &read_result);
+  g_cancellable_cancel (cancellable);
+
+  wait_for_read_pixels (&read_result);
+  g_assert_error (read_result.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (read_result.bitmap);
+
+  g_error_free (read_result.error);
+}
+
+static void
+test_read_pixels_async_benchmark (void)
+{
+  g_autoptr (CoglFramebuffer) framebuffer = NULL;
+  g_autofree uint8_t *pixels = NULL;
+  int64_t sync_blocked_us = 0;
+  int64_t async_blocked_us = 0;
+  int64_t async_latency_us = 0;
+  int frame;
+
+  framebuffer = create_offscreen (BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+  pixels = g_malloc (BENCHMARK_WIDTH * BENCHMARK_HEIGHT * 4);
+
+  for (frame = 0; frame < N_BENCHMARK_FRAMES; frame++)
+    {
+      int64_t start_time_us;
+
+      draw_rectangles (framebuffer, N_BENCHMARK_RECTANGLES);
+
+      /* The whole read, including waiting for the rendering, happens
+       * on the calling thread */
+      start_time_us = g_get_monotonic_time ();
+      cogl_framebuffer_read_pixels (framebuffer,
+                                    0, 0,
+                                    BENCHMARK_WIDTH, BENCHMARK_HEIGHT,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    pixels);
+      sync_blocked_us += g_get_monotonic_time () - start_time_us;
+    }
+
+  for (frame = 0; frame < N_BENCHMARK_FRAMES; frame++)
+    {
+      ReadPixelsResult read_result = { 0 };
+      CoglBuffer *buffer;
+      int64_t start_time_us;
+      int64_t issued_time_us;
+      void *data;
+
+      draw_rectangles (framebuffer, N_BENCHMARK_RECTANGLES);
+
+      /* Only issuing the read and mapping the result block, the main
+       * loop is free to run in between */
+      start_time_us = g_get_monotonic_time ();
+      cogl_framebuffer_read_pixels_async (framebuffer,
+                                          0, 0,
+                                          BENCHMARK_WIDTH, BENCHMARK_HEIGHT,
+                                          COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                          NULL,
+                                          on_read_pixels,
+                                          &read_result);
+      issued_time_us = g_get_monotonic_time ();
+      async_blocked_us += issued_time_us - start_time_us;
+
+      wait_for_read_pixels (&read_result);
+      g_assert_no_error (read_result.error);
+
+      start_time_us = g_get_monotonic_time ();
+      buffer = COGL_BUFFER (cogl_bitmap_get_buffer (read_result.bitmap));
+      data = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0);
+      g_assert_nonnull (data);
+      cogl_buffer_unmap (buffer);
+      async_blocked_us += g_get_monotonic_time () - start_time_us;
+      async_latency_us += g_get_monotonic_time () - issued_time_us;
+
+      g_object_unref (read_result.bitmap);
+    }
+
+  g_test_message ("Reading back %dx%d pixels: %.3f ms blocked per frame "
+                  "synchronously, %.3f ms blocked per frame asynchronously "
+                  "with %.3f ms until the pixels were mapped",
+                  BENCHMARK_WIDTH, BENCHMARK_HEIGHT,
+                  sync_blocked_us / (double) N_BENCHMARK_FRAMES / 1000.0,
+                  async_blocked_us / (double) N_BENCHMARK_FRAMES / 1000.0,
+                  async_latency_us / (double) N_BENCHMARK_FRAMES / 1000.0);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/read-pixels/async", test_read_pixels_async);
+  g_test_add_func ("/read-pixels/async-cancel", test_read_pixels_async_cancel);
+  g_test_add_func ("/read-pixels/async-benchmark",
+                   test_read_pixels_async_benchmark);
+)
@@ -0,0 +1,243 @@
+#include "config.h"
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-debug.h"
+#include "tests/cogl-test-utils.h"
+
+#define CELL_PADDING 2
+
+#define N_BENCHMARK_FRAMES 100
+#define N_BENCHMARK_WINDOWS 16
+
+static MtkRegion *
+create_damage_region (int n_columns,
+                      int n_rows)
+{
+  g_autofree MtkRectangle *rects = NULL;
+  int cell_width = FB_WIDTH / n_columns;
+  int cell_height = FB_HEIGHT / n_rows;
+  int x, y;
+
+  rects = g_new0 (MtkRectangle, n_columns * n_rows);
+
+  /* A grid of rectangles that don't touch, so the region can't merge
+     any of them */
+  for (y = 0; y < n_rows; y++)
+    {
+      for (x = 0; x < n_columns; x++)
+        {
+          rects[y * n_columns + x] = (MtkRectangle) {
+            .x = x * cell_width + CELL_PADDING,
+            .y = y * cell_height + CELL_PADDING,
+            .width = cell_width - 2 * CELL_PADDING,
+            .height = cell_height - 2 * CELL_PADDING,
+          };
+        }
+    }
+
+  return mtk_region_create_rectangles (rects, n_columns * n_rows);
+}
+
+static void
+set_software_clip_enabled (gboolean enabled)
+{
+  /* The decision is made when logging, so anything drawn before needs
+     to be flushed with the previous setting */
+  cogl_framebuffer_flush (test_fb);
+
+  if (enabled)
+    COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_SOFTWARE_CLIP);
+  else
+    COGL_DEBUG_SET_FLAG (COGL_DEBUG_DISABLE_SOFTWARE_CLIP);
+}
+
+static CoglPipeline *
+create_split_pipeline (void)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  CoglPipeline *pipeline;
+  uint8_t data[] = {
+    0xff, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0xff, 0xff,
+  };
+
+  /* A red texel on the left and a blue one on the right */
+  texture = cogl_texture_2d_new_from_data (test_ctx,
+                                           2, 1,
+                                           COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                           8,
+                                           data,
+                                           NULL);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  return pipeline;
+}
+
+static void
+draw_clipped_quads (gboolean software_clip)
+{
+  g_autoptr (MtkRegion) region = NULL;
+  g_autoptr (CoglPipeline) split_pipeline = NULL;
+  g_autoptr (CoglPipeline) white_pipeline = NULL;
+
+  set_software_clip_enabled (software_clip);
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* 4x4 cells of 128x128 pixels */
+  region = create_damage_region (4, 4);
+  split_pipeline = create_split_pipeline ();
+  white_pipeline = cogl_pipeline_new (test_ctx);
+
+  cogl_framebuffer_push_region_clip (test_fb, region);
+
+  /* Top half as is, red on the left */
+  cogl_framebuffer_draw_textured_rectangle (test_fb, split_pipeline,
+                                            0, 0,
+                                            FB_WIDTH, FB_HEIGHT / 2,
+                                            0, 0, 1, 1);
+
+  /* Bottom half mirrored, blue on the left */
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, FB_WIDTH, 0, 0);
+  cogl_framebuffer_scale (test_fb, -1, 1, 1);
+  cogl_framebuffer_draw_textured_rectangle (test_fb, split_pipeline,
+                                            0, FB_HEIGHT / 2,
+                                            FB_WIDTH, FB_HEIGHT,
+                                            0, 0, 1, 1);
+  cogl_framebuffer_pop_matrix (test_fb);
+
+  /* A small diamond in the middle, which isn't axis aligned */
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, FB_WIDTH / 2, FB_HEIGHT / 2, 0);
+  cogl_framebuffer_rotate (test_fb, 45, 0, 0, 1);
+  cogl_framebuffer_draw_rectangle (test_fb, white_pipeline,
+                                   -75, -75, 75, 75);
+  cogl_framebuffer_pop_matrix (test_fb);
+
+  cogl_framebuffer_pop_clip (test_fb);
+}
+
+static void
+check_clipped_quads (void)
+{
+  /* Inside the cells */
+  test_utils_check_pixel (test_fb, 64, 64, 0xff0000ff);
+  test_utils_check_pixel (test_fb, 448, 64, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 64, 448, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 448, 448, 0xff0000ff);
+
+  /* Between the cells */
+  test_utils_check_pixel (test_fb, 0, 0, 0x000000ff);
+  test_utils_check_pixel (test_fb, 127, 64, 0x000000ff);
+  test_utils_check_pixel (test_fb, 64, 128, 0x000000ff);
+  test_utils_check_pixel (test_fb, 511, 511, 0x000000ff);
+
+  /* The diamond, inside a cell, between cells, and outside of it */
+  test_utils_check_pixel (test_fb, 220, 220, 0xffffffff);
+  test_utils_check_pixel (test_fb, 292, 292, 0xffffffff);
+  test_utils_check_pixel (test_fb, 256, 230, 0x000000ff);
+  test_utils_check_pixel (test_fb, 160, 160, 0xff0000ff);
+}
+
+static void
+test_region_clip_software (void)
+{
+  draw_clipped_quads (TRUE);
+  check_clipped_quads ();
+
+  draw_clipped_quads (FALSE);
+  check_clipped_quads ();
+
+  set_software_clip_enabled (TRUE);
+}
+
+static double
+benchmark_frames (MtkRegion *region,
+                  gboolean   software_clip)
+{
+  g_autoptr (CoglPipeline) pipeline = NULL;
+  int64_t start_time_us;
+  int frame, i;
+
+  set_software_clip_enabled (software_clip);
+  cogl_framebuffer_finish (test_fb);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+
+  start_time_us = g_get_monotonic_time ();
+
+  for (frame = 0; frame < N_BENCHMARK_FRAMES; frame++)
+    {
+      cogl_framebuffer_push_region_clip (test_fb, region);
+
+      /* Overlapping window sized quads, like a stacked desktop */
+      for (i = 0; i < N_BENCHMARK_WINDOWS; i++)
+        {
+          float x = (i * 37) % (FB_WIDTH / 2);
+          float y = (i * 53) % (FB_HEIGHT / 2);
+          CoglColor color;
+
+          cogl_color_init_from_4f (&color,
+                                   (i % 3) / 2.0f,
+                                   (i % 5) / 4.0f,
+                                   (i % 7) / 6.0f,
+                                   1.0f);
+          cogl_pipeline_set_color (pipeline, &color);
+          cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                           x, y,
+                                           x + FB_WIDTH / 2,
+                                           y + FB_HEIGHT / 2);
+        }
+
+      cogl_framebuffer_pop_clip (test_fb);
+      cogl_framebuffer_finish (test_fb);
+    }
+
+  return ((g_get_monotonic_time () - start_time_us) /
+          (double) N_BENCHMARK_FRAMES / 1000.0);
+}
+
+static void
+test_region_clip_benchmark (void)
+{
+  static const int grid_sizes[] = { 1, 4, 8 };
+  unsigned int i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Only timed in performance mode");
+      return;
+    }
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+
+  for (i = 0; i < G_N_ELEMENTS (grid_sizes); i++)
+    {
+      g_autoptr (MtkRegion) region = NULL;
+      int n_rectangles;
+      double stencil_ms, software_ms;
+
+      region = create_damage_region (grid_sizes[i], grid_sizes[i]);
+      n_rectangles = mtk_region_num_rectangles (region);
+      g_assert_cmpint (n_rectangles, ==, grid_sizes[i] * grid_sizes[i]);
+
+      stencil_ms = benchmark_frames (region, FALSE);
+      software_ms = benchmark_frames (region, TRUE);
+
+      g_test_message ("%d damage rectangles: %.3f ms per frame stencilled, "
+                      "%.3f ms per frame clipped in software",
+                      n_rectangles, stencil_ms, software_ms);
+    }
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/region-clip/software", test_region_clip_software);
+  g_test_add_func ("/region-clip/benchmark", test_region_clip_benchmark);
+)
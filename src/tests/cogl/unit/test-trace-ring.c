@@ -0,0 +1,122 @@
+#include "config.h"
+
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#include "cogl/cogl-trace.h"
+#include "tests/cogl-test-utils.h"
+
+#define N_OVERHEAD_SPANS 1000000
+
+/* Recording a span is supposed to be cheap enough to never turn it off;
+   this leaves plenty of room for slow test machines. Only checked in
+   performance test runs, as it depends on the load of the machine */
+#define MAX_SPAN_OVERHEAD_NS 1000
+
+#ifdef HAVE_PROFILER
+static void G_GNUC_NOINLINE
+record_span (void)
+{
+  COGL_TRACE_BEGIN_SCOPED (TestSpan, "Test::span()");
+}
+
+static void
+enable_trace_ring (void)
+{
+  cogl_set_trace_ring_enabled_on_thread (g_main_context_get_thread_default (),
+                                         "Test");
+  g_assert_true (cogl_is_trace_ring_enabled ());
+  g_assert_false (cogl_is_tracing_enabled ());
+}
+
+static void
+disable_trace_ring (void)
+{
+  cogl_set_trace_ring_disabled_on_thread (g_main_context_get_thread_default ());
+  g_assert_false (cogl_is_trace_ring_enabled ());
+}
+#endif
+
+static void
+check_span_overhead (void)
+{
+#ifdef HAVE_PROFILER
+  int64_t start_time_us, elapsed_us;
+  double span_overhead_ns;
+  int i;
+
+  enable_trace_ring ();
+
+  start_time_us = g_get_monotonic_time ();
+  for (i = 0; i < N_OVERHEAD_SPANS; i++)
+    record_span ();
+  elapsed_us = g_get_monotonic_time () - start_time_us;
+
+  span_overhead_ns = elapsed_us * 1000.0 / N_OVERHEAD_SPANS;
+  g_test_message ("%d spans in %" G_GINT64_FORMAT " us, %.1f ns per span",
+                  N_OVERHEAD_SPANS, elapsed_us, span_overhead_ns);
+  if (g_test_perf ())
+    g_assert_cmpfloat (span_overhead_ns, <, MAX_SPAN_OVERHEAD_NS);
+
+  disable_trace_ring ();
+#else
+  g_test_skip ("Tracing disabled at build time");
+#endif
+}
+
+static void
+check_snapshot (void)
+{
+#ifdef HAVE_PROFILER
+  g_autoptr (CoglTraceRingSnapshot) snapshot = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree char *filename = NULL;
+  GStatBuf stat_buf;
+  unsigned int n_spans;
+  int fd;
+  int i;
+
+  enable_trace_ring ();
+
+  for (i = 0; i < 10; i++)
+    record_span ();
+
+  snapshot = cogl_trace_ring_snapshot_new (10 * G_USEC_PER_SEC);
+  g_assert_cmpuint (cogl_trace_ring_snapshot_get_n_spans (snapshot), ==, 10);
+  g_clear_pointer (&snapshot, cogl_trace_ring_snapshot_free);
+
+  /* Only the most recent spans are kept around */
+  for (i = 0; i < N_OVERHEAD_SPANS / 10; i++)
+    record_span ();
+
+  snapshot = cogl_trace_ring_snapshot_new (10 * G_USEC_PER_SEC);
+  n_spans = cogl_trace_ring_snapshot_get_n_spans (snapshot);
+  g_assert_cmpuint (n_spans, >, 0);
+  g_assert_cmpuint (n_spans, <, N_OVERHEAD_SPANS / 10);
+
+  fd = g_file_open_tmp ("cogl-trace-ring-XXXXXX.syscap", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  g_assert_true (cogl_trace_ring_snapshot_write (snapshot, filename, &error));
+  g_assert_no_error (error);
+
+  g_assert_cmpint (g_stat (filename, &stat_buf), ==, 0);
+  g_assert_cmpint (stat_buf.st_size, >, 0);
+  g_unlink (filename);
+
+  disable_trace_ring ();
+
+  /* Disabling the ring of the thread drops its spans */
+  g_clear_pointer (&snapshot, cogl_trace_ring_snapshot_free);
+  snapshot = cogl_trace_ring_snapshot_new (10 * G_USEC_PER_SEC);
+  g_assert_cmpuint (cogl_trace_ring_snapshot_get_n_spans (snapshot), ==, 0);
+#else
+  g_test_skip ("Tracing disabled at build time");
+#endif
+}
+
+COGL_TEST_SUITE_MINIMAL (
+  g_test_add_func ("/trace-ring/span-overhead", check_span_overhead);
+  g_test_add_func ("/trace-ring/snapshot", check_snapshot);
+)
@@ -23,6 +23,7 @@
 #include "backends/meta-color-device.h"
 #include "backends/meta-color-manager-private.h"
 #include "backends/meta-color-profile.h"
+#include "backends/meta-crtc.h"
 #include "meta-test/meta-context-test.h"
 #include "tests/meta-monitor-test-utils.h"
 
@@ -319,6 +320,105 @@ set_night_light_active (gboolean active)
     g_error ("Failed to set enable or disable night light: %s", error->message);
 }
 
+static void
+assert_gamma_lut_close_to_exact (const MetaColorCalibration *calibration,
+                                 const MetaGammaLut         *lut,
+                                 unsigned int                temperature)
+{
+  CdColorRGB blackbody_color;
+  size_t i;
+
+  g_assert_true (cd_color_get_blackbody_rgb_full (temperature,
+                                                  &blackbody_color,
+                                                  CD_COLOR_BLACKBODY_FLAG_USE_PLANCKIAN));
+
+  for (i = 0; i < lut->size; i++)
+    {
+      cmsFloat32Number in;
+      uint16_t red, green, blue;
+
+      in = (double) i / (double) (lut->size - 1);
+      red = cmsEvalToneCurveFloat (calibration->vcgt[0], in) *
+            blackbody_color.R * (double) 0xffff;
+      green = cmsEvalToneCurveFloat (calibration->vcgt[1], in) *
+              blackbody_color.G * (double) 0xffff;
+      blue = cmsEvalToneCurveFloat (calibration->vcgt[2], in) *
+             blackbody_color.B * (double) 0xffff;
+
+      g_assert_cmpint (abs (lut->red[i] - red), <=, 1);
+      g_assert_cmpint (abs (lut->green[i] - green), <=, 1);
+      g_assert_cmpint (abs (lut->blue[i] - blue), <=, 1);
+    }
+}
+
+static void
+meta_test_color_management_night_light_interpolated (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaMonitorManager *monitor_manager =
+    meta_backend_get_monitor_manager (backend);
+  MetaMonitorManagerTest *monitor_manager_test =
+    META_MONITOR_MANAGER_TEST (monitor_manager);
+  MetaColorManager *color_manager =
+    meta_backend_get_color_manager (backend);
+  MonitorTestCaseSetup test_case_setup = base_monitor_setup;
+  MetaMonitorTestSetup *test_setup;
+  MetaMonitor *monitor;
+  MetaColorDevice *color_device;
+  MetaColorProfile *color_profile;
+  const MetaColorCalibration *calibration;
+  const char *path;
+  const char *color_profiles[1];
+  const char *profile_id = VX239_ICC_PROFILE_ID;
+  size_t lut_sizes[] = { 256, 1024, 256 };
+  size_t i;
+
+  test_case_setup.outputs[0].edid_info = ANCOR_VX239_EDID;
+  test_case_setup.outputs[0].has_edid_info = TRUE;
+  test_setup = meta_create_monitor_test_setup (backend, &test_case_setup,
+                                               MONITOR_TEST_FLAG_NO_STORED);
+  meta_monitor_manager_test_emulate_hotplug (monitor_manager_test, test_setup);
+
+  monitor = meta_monitor_manager_get_monitors (monitor_manager)->data;
+  color_device = meta_color_manager_get_color_device (color_manager, monitor);
+  g_assert_nonnull (color_device);
+
+  while (!meta_color_device_is_ready (color_device))
+    g_main_context_iteration (NULL, TRUE);
+
+  path = g_test_get_filename (G_TEST_DIST,
+                              "tests", "icc-profiles", "vx239-calibrated.icc",
+                              NULL);
+  add_colord_system_profile (profile_id, path);
+  color_profiles[0] = profile_id;
+  set_colord_device_profiles (meta_color_device_get_id (color_device),
+                              color_profiles, G_N_ELEMENTS (color_profiles));
+
+  wait_for_profile_assigned (color_device, profile_id);
+
+  color_profile = meta_color_device_get_assigned_profile (color_device);
+  calibration = meta_color_profile_get_calibration (color_profile);
+  g_assert_true (calibration->has_vcgt);
+
+  /* Sweep the temperatures like a night light transition would, changing
+   * the LUT size in between to make sure cached curves are invalidated. */
+  for (i = 0; i < G_N_ELEMENTS (lut_sizes); i++)
+    {
+      unsigned int temperature;
+
+      for (temperature = 1000; temperature <= 10000; temperature += 37)
+        {
+          g_autoptr (MetaGammaLut) lut = NULL;
+
+          lut = meta_color_profile_generate_gamma_lut (color_profile,
+                                                       temperature,
+                                                       lut_sizes[i]);
+          g_assert_cmpuint (lut->size, ==, lut_sizes[i]);
+          assert_gamma_lut_close_to_exact (calibration, lut, temperature);
+        }
+    }
+}
+
 static void
 prepare_color_test (void)
 {
@@ -1423,6 +1523,8 @@ init_tests (void)
                   meta_test_color_management_night_light_calibrated);
   add_color_test ("/color-management/night-light/uncalibrated",
                   meta_test_color_management_night_light_uncalibrated);
+  add_color_test ("/color-management/night-light/interpolated",
+                  meta_test_color_management_night_light_interpolated);
 }
 
 int
@@ -25,8 +25,22 @@
 #include "meta-test/meta-context-test.h"
 #include "tests/meta-test-utils.h"
 
+#define N_BENCHMARK_LAYOUT_SWITCHES 200
+#define N_BENCHMARK_LOOKUPS 1000000
+
 static MetaContext *test_context;
 
+static const char *benchmark_modifiers[] = {
+  "<Super>",
+  "<Control>",
+  "<Alt>",
+  "<Control><Alt>",
+  "<Control><Shift>",
+  "<Super><Shift>",
+  "<Super><Control>",
+  "<Alt><Shift>",
+};
+
 static void
 test_handler (MetaDisplay           *display,
               MetaWindow            *window,
@@ -122,10 +136,125 @@ test_keybinding_remove_trigger (void)
   while (g_main_context_iteration (NULL, FALSE)) {}
 }
 
+static GArray *
+grab_benchmark_accelerators (MetaDisplay *display)
+{
+  GArray *actions;
+  unsigned int i;
+  char key;
+
+  actions = g_array_new (FALSE, FALSE, sizeof (unsigned int));
+
+  /* Letters, which need the secondary layout on non-latin layouts, and
+   * function keys, which don't */
+  for (i = 0; i < G_N_ELEMENTS (benchmark_modifiers); i++)
+    {
+      int n;
+
+      for (key = 'a'; key <= 'z'; key++)
+        {
+          g_autofree char *accelerator = NULL;
+          unsigned int action;
+
+          accelerator = g_strdup_printf ("%s%c", benchmark_modifiers[i], key);
+          action = meta_display_grab_accelerator (display, accelerator,
+                                                  META_KEY_BINDING_NONE);
+          g_assert_cmpuint (action, !=, META_KEYBINDING_ACTION_NONE);
+          g_array_append_val (actions, action);
+        }
+
+      for (n = 1; n <= 12; n++)
+        {
+          g_autofree char *accelerator = NULL;
+          unsigned int action;
+
+          accelerator = g_strdup_printf ("%sF%d", benchmark_modifiers[i], n);
+          action = meta_display_grab_accelerator (display, accelerator,
+                                                  META_KEY_BINDING_NONE);
+          g_assert_cmpuint (action, !=, META_KEYBINDING_ACTION_NONE);
+          g_array_append_val (actions, action);
+        }
+    }
+
+  return actions;
+}
+
+static void
+test_keybinding_dispatch_benchmark (void)
+{
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterModifierType mask = CLUTTER_CONTROL_MASK | CLUTTER_MOD1_MASK;
+  g_autoptr (GArray) actions = NULL;
+  unsigned int expected_action;
+  int64_t start_time_us;
+  int64_t rebuild_us;
+  int64_t switch_us;
+  int64_t lookup_us;
+  unsigned int i;
+
+  actions = grab_benchmark_accelerators (display);
+
+  /* <Control><Alt>a, with the evdev keycode offset by 8 for XKB */
+  expected_action = g_array_index (actions, unsigned int, 3 * (26 + 12));
+  g_assert_cmpuint (meta_display_get_keybinding_action (display,
+                                                        KEY_A + 8,
+                                                        mask),
+                    ==,
+                    expected_action);
+
+  /* A new keymap indexes the primary layout and rebuilds every binding */
+  start_time_us = g_get_monotonic_time ();
+  meta_backend_set_keymap (backend, "us,ru", "", "", "");
+  rebuild_us = g_get_monotonic_time () - start_time_us;
+
+  /* Switching groups only indexes each layout the first time */
+  start_time_us = g_get_monotonic_time ();
+  for (i = 0; i < N_BENCHMARK_LAYOUT_SWITCHES; i++)
+    meta_backend_lock_layout_group (backend, (i + 1) % 2);
+  switch_us = g_get_monotonic_time () - start_time_us;
+
+  /* The latin letters are found through the secondary layout */
+  g_assert_cmpuint (meta_display_get_keybinding_action (display,
+                                                        KEY_A + 8,
+                                                        mask),
+                    ==,
+                    expected_action);
+
+  start_time_us = g_get_monotonic_time ();
+  for (i = 0; i < N_BENCHMARK_LOOKUPS; i++)
+    {
+      meta_display_get_keybinding_action (display,
+                                          KEY_Q + 8 + i % 26,
+                                          mask);
+    }
+  lookup_us = g_get_monotonic_time () - start_time_us;
+
+  g_test_message ("%u bindings: %.3f ms rebuilding for a new keymap, "
+                  "%.3f ms per layout switch, %.1f ns per lookup",
+                  actions->len,
+                  rebuild_us / 1000.0,
+                  switch_us / (double) N_BENCHMARK_LAYOUT_SWITCHES / 1000.0,
+                  lookup_us * 1000.0 / N_BENCHMARK_LOOKUPS);
+
+  for (i = 0; i < actions->len; i++)
+    {
+      g_assert_true (meta_display_ungrab_accelerator (display,
+                                                      g_array_index (actions,
+                                                                     unsigned int,
+                                                                     i)));
+    }
+
+  meta_backend_lock_layout_group (backend, 0);
+  meta_backend_set_keymap (backend, "us", "", "", "");
+}
+
 static void
 init_tests (void)
 {
   g_test_add_func ("/core/keybindings/remove-trigger", test_keybinding_remove_trigger);
+  g_test_add_func ("/core/keybindings/dispatch-benchmark",
+                   test_keybinding_dispatch_benchmark);
 }
 
 int
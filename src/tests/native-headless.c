@@ -27,7 +27,7 @@ static void
 init_tests (MetaContext *context)
 {
   init_virtual_monitor_tests (context);
-  init_screen_cast_tests ();
+  init_screen_cast_tests (context);
   init_bezier_tests ();
 }
 
@@ -57,6 +57,8 @@ typedef struct
     guint repaint_guard_id;
     ClutterStageView *scanout_failed_view;
   } scanout_fallback;
+
+  gboolean damage_readback_checked;
 } KmsRenderingTest;
 
 static MetaContext *test_context;
@@ -474,6 +476,158 @@ meta_test_kms_render_client_scanout_fallback (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+read_damage_rectangle (CoglFramebuffer *framebuffer,
+                       CoglPixelBuffer *pixel_buffer,
+                       int              stride,
+                       gboolean         is_flipped,
+                       MtkRectangle    *rect)
+{
+  int height = cogl_framebuffer_get_height (framebuffer);
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  int row;
+
+  row = is_flipped ? height - rect->y - rect->height : rect->y;
+  bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (pixel_buffer),
+                                        COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+                                        rect->width, rect->height,
+                                        stride,
+                                        row * stride + rect->x * 4);
+  g_assert_true (cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                           rect->x, rect->y,
+                                                           COGL_READ_PIXELS_COLOR_BUFFER |
+                                                           COGL_READ_PIXELS_NO_FLIP,
+                                                           bitmap));
+}
+
+static void
+on_damage_readback_paint_view (ClutterStage     *stage,
+                               ClutterStageView *stage_view,
+                               MtkRegion        *region,
+                               ClutterFrame     *frame,
+                               KmsRenderingTest *test)
+{
+  CoglFramebuffer *framebuffer = clutter_stage_view_get_framebuffer (stage_view);
+  CoglContext *cogl_context = cogl_framebuffer_get_context (framebuffer);
+  g_autoptr (CoglPixelBuffer) pixel_buffer = NULL;
+  g_autofree uint8_t *reference = NULL;
+  g_autofree uint8_t *zeroes = NULL;
+  const uint8_t *data;
+  int width, height, stride;
+  gboolean is_flipped;
+  MtkRectangle rects[3];
+  int gap_x, gap_width, y;
+  size_t i;
+
+  if (test->damage_readback_checked)
+    return;
+
+  width = cogl_framebuffer_get_width (framebuffer);
+  height = cogl_framebuffer_get_height (framebuffer);
+  stride = width * 4;
+
+  /* Without flipping, rows of onscreen framebuffers come out bottom-up */
+  is_flipped = COGL_IS_ONSCREEN (framebuffer);
+
+  reference = g_malloc0 ((size_t) stride * height);
+  g_assert_true (cogl_framebuffer_read_pixels (framebuffer,
+                                               0, 0, width, height,
+                                               COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+                                               reference));
+
+  zeroes = g_malloc0 ((size_t) stride * height);
+  pixel_buffer = cogl_pixel_buffer_new (cogl_context,
+                                        (size_t) stride * height,
+                                        zeroes);
+
+  /* The first two rectangles share rows, like damage of a CPU copy to a
+   * secondary GPU often does. */
+  rects[0] = (MtkRectangle) { width / 8, height / 4, width / 4, height / 2 };
+  rects[1] = (MtkRectangle) { width / 2, height / 8, width / 4, height / 2 };
+  rects[2] = (MtkRectangle) { 0, height * 7 / 8, width, height / 8 };
+
+  for (i = 0; i < G_N_ELEMENTS (rects); i++)
+    read_damage_rectangle (framebuffer, pixel_buffer, stride, is_flipped,
+                           &rects[i]);
+
+  data = cogl_buffer_map (COGL_BUFFER (pixel_buffer),
+                          COGL_BUFFER_ACCESS_READ, 0);
+  g_assert_nonnull (data);
+
+  for (i = 0; i < G_N_ELEMENTS (rects); i++)
+    {
+      MtkRectangle *rect = &rects[i];
+
+      for (y = rect->y; y < rect->y + rect->height; y++)
+        {
+          int row = is_flipped ? height - y - 1 : y;
+
+          g_assert_cmpmem (data + row * stride + rect->x * 4,
+                           rect->width * 4,
+                           reference + y * stride + rect->x * 4,
+                           rect->width * 4);
+        }
+    }
+
+  /* Pixels between rectangles sharing rows must be left alone */
+  gap_x = rects[0].x + rects[0].width;
+  gap_width = rects[1].x - gap_x;
+  for (y = rects[0].y; y < rects[0].y + rects[0].height; y++)
+    {
+      int row = is_flipped ? height - y - 1 : y;
+
+      g_assert_cmpmem (data + row * stride + gap_x * 4, gap_width * 4,
+                       zeroes, gap_width * 4);
+    }
+
+  cogl_buffer_unmap (COGL_BUFFER (pixel_buffer));
+
+  test->damage_readback_checked = TRUE;
+  g_main_loop_quit (test->loop);
+}
+
+static void
+meta_test_kms_render_damage_readback (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  ClutterActor *actors[3];
+  KmsRenderingTest test;
+  gulong handler_id;
+  size_t i;
+
+  for (i = 0; i < G_N_ELEMENTS (actors); i++)
+    {
+      actors[i] = clutter_actor_new ();
+      clutter_actor_set_position (actors[i], 100 + i * 150.0f, 50 + i * 100.0f);
+      clutter_actor_set_size (actors[i], 200, 300);
+      clutter_actor_set_background_color (actors[i],
+                                          &CLUTTER_COLOR_INIT (255 * (i == 0),
+                                                               255 * (i == 1),
+                                                               255 * (i == 2),
+                                                               255));
+      clutter_actor_add_child (stage, actors[i]);
+    }
+
+  test = (KmsRenderingTest) {
+    .loop = g_main_loop_new (NULL, FALSE),
+  };
+  handler_id = g_signal_connect_after (stage, "paint-view",
+                                       G_CALLBACK (on_damage_readback_paint_view),
+                                       &test);
+
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+  g_main_loop_unref (test.loop);
+
+  g_assert_true (test.damage_readback_checked);
+
+  g_signal_handler_disconnect (stage, handler_id);
+
+  for (i = 0; i < G_N_ELEMENTS (actors); i++)
+    clutter_actor_destroy (actors[i]);
+}
+
 static void
 meta_test_kms_render_empty_config (void)
 {
@@ -513,6 +667,8 @@ init_tests (void)
                    meta_test_kms_render_client_scanout_fallback);
   g_test_add_func ("/backends/native/kms/render/empty-config",
                    meta_test_kms_render_empty_config);
+  g_test_add_func ("/backends/native/kms/render/damage-readback",
+                   meta_test_kms_render_damage_readback);
 }
 
 int
@@ -22,10 +22,19 @@
 
 #include <errno.h>
 #include <gio/gio.h>
+#include <math.h>
 #include <unistd.h>
 
+#include "backends/meta-backend-private.h"
+#include "backends/meta-logical-monitor.h"
+#include "backends/meta-monitor-manager-private.h"
+#include "backends/meta-screen-cast.h"
+#include "backends/meta-screen-cast-yuv-converter.h"
+#include "backends/meta-virtual-monitor.h"
 #include "meta/util.h"
 
+static MetaContext *test_context;
+
 static void
 test_client_exited (GObject      *source_object,
                     GAsyncResult *result,
@@ -84,9 +93,490 @@ meta_test_screen_cast_record_virtual (void)
   meta_remove_verbose_topic (META_DEBUG_SCREEN_CAST);
 }
 
+static void
+on_after_paint (ClutterStage     *stage,
+                ClutterStageView *view,
+                ClutterFrame     *frame,
+                gboolean         *painted)
+{
+  *painted = TRUE;
+}
+
+static void
+wait_for_paint (ClutterActor *stage)
+{
+  gboolean painted = FALSE;
+  gulong after_paint_handler_id;
+
+  after_paint_handler_id = g_signal_connect (stage, "after-paint",
+                                             G_CALLBACK (on_after_paint),
+                                             &painted);
+  clutter_actor_queue_redraw (stage);
+  while (!painted)
+    g_main_context_iteration (NULL, TRUE);
+  g_signal_handler_disconnect (stage, after_paint_handler_id);
+}
+
+static CoglFramebuffer *
+create_framebuffer (CoglContext *cogl_context,
+                    int          width,
+                    int          height)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (CoglFramebuffer) framebuffer = NULL;
+  g_autoptr (GError) error = NULL;
+
+  texture = cogl_texture_2d_new_with_size (cogl_context, width, height);
+  framebuffer = COGL_FRAMEBUFFER (cogl_offscreen_new_with_texture (texture));
+  if (!cogl_framebuffer_allocate (framebuffer, &error))
+    g_error ("Failed to allocate framebuffer: %s", error->message);
+
+  return g_steal_pointer (&framebuffer);
+}
+
+static void
+meta_test_screen_cast_capture_hub (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaMonitorManager *monitor_manager =
+    meta_backend_get_monitor_manager (backend);
+  MetaScreenCast *screen_cast = meta_backend_get_screen_cast (backend);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  g_autoptr (MetaVirtualMonitorInfo) monitor_info = NULL;
+  g_autoptr (MetaVirtualMonitor) virtual_monitor = NULL;
+  g_autoptr (MetaScreenCastCaptureHub) capture_hub = NULL;
+  g_autoptr (MetaScreenCastCaptureHub) other_capture_hub = NULL;
+  g_autoptr (MetaScreenCastCaptureHub) cursor_capture_hub = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree uint8_t *data = NULL;
+  g_autofree uint8_t *blitted_data = NULL;
+  g_autoptr (CoglFramebuffer) framebuffer = NULL;
+  g_autoptr (CoglFramebuffer) other_framebuffer = NULL;
+  MetaLogicalMonitor *logical_monitor;
+  ClutterPaintFlag paint_flags;
+  uint64_t n_captures;
+  uint64_t n_frames_served;
+  int width, height, stride;
+
+  monitor_info = meta_virtual_monitor_info_new (80, 60, 60.0,
+                                                "MetaTestVendor",
+                                                "MetaVirtualMonitor",
+                                                "0x1234");
+  virtual_monitor = meta_monitor_manager_create_virtual_monitor (monitor_manager,
+                                                                 monitor_info,
+                                                                 &error);
+  if (!virtual_monitor)
+    g_error ("Failed to create virtual monitor: %s", error->message);
+  meta_monitor_manager_reload (monitor_manager);
+
+  logical_monitor =
+    meta_monitor_manager_get_logical_monitors (monitor_manager)->data;
+  width = logical_monitor->rect.width;
+  height = logical_monitor->rect.height;
+  stride = width * 4;
+  data = g_malloc0 (stride * height);
+
+  wait_for_paint (stage);
+
+  paint_flags = CLUTTER_PAINT_FLAG_CLEAR | CLUTTER_PAINT_FLAG_NO_CURSORS;
+  capture_hub = meta_screen_cast_acquire_capture_hub (screen_cast,
+                                                      CLUTTER_STAGE (stage),
+                                                      &logical_monitor->rect,
+                                                      1.0,
+                                                      paint_flags);
+  other_capture_hub =
+    meta_screen_cast_acquire_capture_hub (screen_cast,
+                                          CLUTTER_STAGE (stage),
+                                          &logical_monitor->rect,
+                                          1.0,
+                                          paint_flags);
+  g_assert_true (capture_hub == other_capture_hub);
+
+  cursor_capture_hub =
+    meta_screen_cast_acquire_capture_hub (screen_cast,
+                                          CLUTTER_STAGE (stage),
+                                          &logical_monitor->rect,
+                                          1.0,
+                                          CLUTTER_PAINT_FLAG_CLEAR |
+                                          CLUTTER_PAINT_FLAG_FORCE_CURSORS);
+  g_assert_true (capture_hub != cursor_capture_hub);
+
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                                width, height,
+                                                                stride, data,
+                                                                &error));
+  g_assert_no_error (error);
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer (other_capture_hub,
+                                                                width, height,
+                                                                stride, data,
+                                                                &error));
+  g_assert_no_error (error);
+
+  meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                          &n_captures, &n_frames_served);
+  g_assert_cmpuint (n_captures, ==, 1);
+  g_assert_cmpuint (n_frames_served, ==, 2);
+
+  wait_for_paint (stage);
+
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                                width, height,
+                                                                stride, data,
+                                                                &error));
+  g_assert_no_error (error);
+
+  meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                          &n_captures, &n_frames_served);
+  g_assert_cmpuint (n_captures, ==, 2);
+  g_assert_cmpuint (n_frames_served, ==, 3);
+
+  wait_for_paint (stage);
+
+  /* Recording into framebuffers paints the stage into the first one only,
+   * the others get a blit of it, and recording into memory reads it back */
+  framebuffer = create_framebuffer (cogl_context, width, height);
+  other_framebuffer = create_framebuffer (cogl_context, width, height);
+
+  g_assert_true (meta_screen_cast_capture_hub_record_to_framebuffer (capture_hub,
+                                                                     framebuffer,
+                                                                     &error));
+  g_assert_no_error (error);
+  g_assert_true (meta_screen_cast_capture_hub_record_to_framebuffer (capture_hub,
+                                                                     other_framebuffer,
+                                                                     &error));
+  g_assert_no_error (error);
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                                width, height,
+                                                                stride, data,
+                                                                &error));
+  g_assert_no_error (error);
+
+  meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                          &n_captures, &n_frames_served);
+  if (cogl_has_feature (cogl_context, COGL_FEATURE_ID_BLIT_FRAMEBUFFER))
+    g_assert_cmpuint (n_captures, ==, 3);
+  else
+    g_assert_cmpuint (n_captures, ==, 4);
+  g_assert_cmpuint (n_frames_served, ==, 6);
+
+  blitted_data = g_malloc0 (stride * height);
+  g_assert_true (cogl_framebuffer_read_pixels (other_framebuffer,
+                                               0, 0, width, height,
+                                               COGL_PIXEL_FORMAT_CAIRO_ARGB32_COMPAT,
+                                               blitted_data));
+  g_assert_cmpmem (blitted_data, stride * height, data, stride * height);
+
+  g_clear_object (&virtual_monitor);
+  meta_monitor_manager_reload (monitor_manager);
+}
+
+static void
+on_buffer_recorded (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  MetaScreenCastCaptureHub *capture_hub =
+    META_SCREEN_CAST_CAPTURE_HUB (source_object);
+  int *n_pending = user_data;
+  g_autoptr (GError) error = NULL;
+
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer_finish (capture_hub,
+                                                                       result,
+                                                                       &error));
+  g_assert_no_error (error);
+  (*n_pending)--;
+}
+
+static void
+meta_test_screen_cast_capture_hub_async (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaMonitorManager *monitor_manager =
+    meta_backend_get_monitor_manager (backend);
+  MetaScreenCast *screen_cast = meta_backend_get_screen_cast (backend);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  g_autoptr (MetaVirtualMonitorInfo) monitor_info = NULL;
+  g_autoptr (MetaVirtualMonitor) virtual_monitor = NULL;
+  g_autoptr (MetaScreenCastCaptureHub) capture_hub = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree uint8_t *data = NULL;
+  g_autofree uint8_t *other_data = NULL;
+  g_autofree uint8_t *sync_data = NULL;
+  MetaLogicalMonitor *logical_monitor;
+  uint64_t n_captures;
+  uint64_t n_frames_served;
+  int width, height, stride;
+  int n_pending;
+
+  if (!cogl_has_feature (cogl_context, COGL_FEATURE_ID_FENCE))
+    {
+      g_test_skip ("Reading back asynchronously needs fences");
+      return;
+    }
+
+  monitor_info = meta_virtual_monitor_info_new (80, 60, 60.0,
+                                                "MetaTestVendor",
+                                                "MetaVirtualMonitor",
+                                                "0x1234");
+  virtual_monitor = meta_monitor_manager_create_virtual_monitor (monitor_manager,
+                                                                 monitor_info,
+                                                                 &error);
+  if (!virtual_monitor)
+    g_error ("Failed to create virtual monitor: %s", error->message);
+  meta_monitor_manager_reload (monitor_manager);
+
+  logical_monitor =
+    meta_monitor_manager_get_logical_monitors (monitor_manager)->data;
+  width = logical_monitor->rect.width;
+  height = logical_monitor->rect.height;
+  stride = width * 4;
+  data = g_malloc0 (stride * height);
+  other_data = g_malloc0 (stride * height);
+  sync_data = g_malloc0 (stride * height);
+
+  wait_for_paint (stage);
+
+  capture_hub = meta_screen_cast_acquire_capture_hub (screen_cast,
+                                                      CLUTTER_STAGE (stage),
+                                                      &logical_monitor->rect,
+                                                      1.0,
+                                                      CLUTTER_PAINT_FLAG_CLEAR |
+                                                      CLUTTER_PAINT_FLAG_NO_CURSORS);
+
+  /* Both streams are served by a single capture and read back */
+  n_pending = 2;
+  meta_screen_cast_capture_hub_record_to_buffer_async (capture_hub,
+                                                       width, height,
+                                                       stride, data,
+                                                       NULL,
+                                                       on_buffer_recorded,
+                                                       &n_pending);
+  meta_screen_cast_capture_hub_record_to_buffer_async (capture_hub,
+                                                       width, height,
+                                                       stride, other_data,
+                                                       NULL,
+                                                       on_buffer_recorded,
+                                                       &n_pending);
+  while (n_pending > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                          &n_captures, &n_frames_served);
+  g_assert_cmpuint (n_captures, ==, 1);
+  g_assert_cmpuint (n_frames_served, ==, 2);
+  g_assert_cmpmem (data, stride * height, other_data, stride * height);
+
+  /* The read back pixels are kept for the rest of the frame */
+  g_assert_true (meta_screen_cast_capture_hub_record_to_buffer (capture_hub,
+                                                                width, height,
+                                                                stride,
+                                                                sync_data,
+                                                                &error));
+  g_assert_no_error (error);
+
+  meta_screen_cast_capture_hub_get_stats (capture_hub,
+                                          &n_captures, &n_frames_served);
+  g_assert_cmpuint (n_captures, ==, 1);
+  g_assert_cmpuint (n_frames_served, ==, 3);
+  g_assert_cmpmem (data, stride * height, sync_data, stride * height);
+
+  g_clear_object (&virtual_monitor);
+  meta_monitor_manager_reload (monitor_manager);
+}
+
+static void
+reference_rgb_to_yuv (const float *rgb,
+                      float       *yuv)
+{
+  float luma = 0.2126f * rgb[0] + 0.7152f * rgb[1] + 0.0722f * rgb[2];
+
+  yuv[0] = 16.0f + 219.0f * luma;
+  yuv[1] = 128.0f + 224.0f * (rgb[2] - luma) / 1.8556f;
+  yuv[2] = 128.0f + 224.0f * (rgb[0] - luma) / 1.5748f;
+}
+
+static void
+reference_pixel_to_yuv (const uint8_t *pixels,
+                        int            width,
+                        int            height,
+                        int            x,
+                        int            y,
+                        int            block_size,
+                        float         *yuv)
+{
+  float rgb[3] = { 0 };
+  int i, j, k;
+
+  for (j = 0; j < block_size; j++)
+    {
+      for (i = 0; i < block_size; i++)
+        {
+          int px = MIN (x + i, width - 1);
+          int py = MIN (y + j, height - 1);
+          const uint8_t *pixel = pixels + (py * width + px) * 4;
+
+          for (k = 0; k < 3; k++)
+            rgb[k] += pixel[k] / 255.0f / (block_size * block_size);
+        }
+    }
+
+  reference_rgb_to_yuv (rgb, yuv);
+}
+
+static void
+assert_yuv_value (uint8_t value,
+                  float   expected)
+{
+  g_assert_cmpint (ABS ((int) value - (int) roundf (expected)), <=, 2);
+}
+
+static void
+verify_yuv_conversion (CoglContext             *cogl_context,
+                       CoglTexture             *texture,
+                       MetaScreenCastYuvFormat  format)
+{
+  int width = cogl_texture_get_width (texture);
+  int height = cogl_texture_get_height (texture);
+  g_autoptr (MetaScreenCastYuvConverter) converter = NULL;
+  g_autoptr (CoglPipeline) pipeline = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree uint8_t *source = NULL;
+  g_autofree uint8_t *data = NULL;
+  MetaScreenCastYuvLayout layout;
+  CoglFramebuffer *framebuffer;
+  int x, y;
+
+  converter = meta_screen_cast_yuv_converter_new (cogl_context, format,
+                                                  width, height,
+                                                  &error);
+  g_assert_no_error (error);
+
+  framebuffer = meta_screen_cast_yuv_converter_get_framebuffer (converter);
+  cogl_framebuffer_orthographic (framebuffer, 0, 0, width, height, -1, 1);
+
+  pipeline = cogl_pipeline_new (cogl_context);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+  cogl_pipeline_set_blend (pipeline, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+  cogl_framebuffer_draw_textured_rectangle (framebuffer, pipeline,
+                                            0, 0, width, height,
+                                            0, 0, 1, 1);
+
+  source = g_malloc0 (width * height * 4);
+  g_assert_true (cogl_framebuffer_read_pixels (framebuffer,
+                                               0, 0, width, height,
+                                               COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                               source));
+
+  meta_screen_cast_yuv_calculate_layout (format, width, height, &layout);
+  data = g_malloc0 (layout.size);
+  g_assert_true (meta_screen_cast_yuv_converter_convert (converter,
+                                                         data,
+                                                         &error));
+  g_assert_no_error (error);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          float yuv[3];
+
+          reference_pixel_to_yuv (source, width, height, x, y, 1, yuv);
+          assert_yuv_value (data[y * layout.strides[0] + x], yuv[0]);
+        }
+    }
+
+  for (y = 0; y < layout.heights[1]; y++)
+    {
+      for (x = 0; x < (width + 1) / 2; x++)
+        {
+          uint8_t u, v;
+          float yuv[3];
+
+          reference_pixel_to_yuv (source, width, height, x * 2, y * 2, 2, yuv);
+
+          switch (format)
+            {
+            case META_SCREEN_CAST_YUV_FORMAT_NV12:
+              u = data[layout.offsets[1] + y * layout.strides[1] + x * 2];
+              v = data[layout.offsets[1] + y * layout.strides[1] + x * 2 + 1];
+              break;
+            case META_SCREEN_CAST_YUV_FORMAT_I420:
+              u = data[layout.offsets[1] + y * layout.strides[1] + x];
+              v = data[layout.offsets[2] + y * layout.strides[2] + x];
+              break;
+            default:
+              g_assert_not_reached ();
+            }
+
+          assert_yuv_value (u, yuv[1]);
+          assert_yuv_value (v, yuv[2]);
+        }
+    }
+}
+
+static void
+meta_test_screen_cast_yuv_conversion (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree uint8_t *pixels = NULL;
+  /* Odd sizes to cover row padding and incomplete chroma blocks */
+  int width = 30;
+  int height = 17;
+  int x, y;
+
+  pixels = g_malloc0 (width * height * 4);
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          uint8_t *pixel = pixels + (y * width + x) * 4;
+
+          pixel[0] = (x * 8) & 0xff;
+          pixel[1] = (y * 15) & 0xff;
+          pixel[2] = ((x + y) * 37) & 0xff;
+          pixel[3] = 0xff;
+        }
+    }
+
+  texture = cogl_texture_2d_new_from_data (cogl_context,
+                                           width, height,
+                                           COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                           width * 4,
+                                           pixels,
+                                           &error);
+  g_assert_no_error (error);
+
+  verify_yuv_conversion (cogl_context, texture,
+                         META_SCREEN_CAST_YUV_FORMAT_NV12);
+  verify_yuv_conversion (cogl_context, texture,
+                         META_SCREEN_CAST_YUV_FORMAT_I420);
+}
+
 void
-init_screen_cast_tests (void)
+init_screen_cast_tests (MetaContext *context)
 {
+  test_context = context;
+
   g_test_add_func ("/backends/native/screen-cast/record-virtual",
                    meta_test_screen_cast_record_virtual);
+  g_test_add_func ("/backends/native/screen-cast/capture-hub",
+                   meta_test_screen_cast_capture_hub);
+  g_test_add_func ("/backends/native/screen-cast/capture-hub-async",
+                   meta_test_screen_cast_capture_hub_async);
+  g_test_add_func ("/backends/native/screen-cast/yuv-conversion",
+                   meta_test_screen_cast_yuv_conversion);
 }
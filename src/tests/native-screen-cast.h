@@ -18,4 +18,6 @@
 
 #pragma once
 
-void init_screen_cast_tests (void);
+#include "meta/meta-context.h"
+
+void init_screen_cast_tests (MetaContext *context);
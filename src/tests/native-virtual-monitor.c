@@ -23,6 +23,7 @@
 #include "backends/meta-backend-private.h"
 #include "backends/meta-logical-monitor.h"
 #include "backends/meta-monitor-config-manager.h"
+#include "backends/meta-stage-view-private.h"
 #include "backends/meta-virtual-monitor.h"
 #include "backends/native/meta-renderer-native.h"
 #include "tests/meta-ref-test.h"
@@ -127,6 +128,204 @@ meta_test_virtual_monitor_create (void)
   clutter_actor_destroy (actor);
 }
 
+typedef struct
+{
+  ClutterStageView *view;
+  int n_presentations;
+  int64_t last_presentation_time_us;
+  int64_t min_interval_us;
+  gboolean got_timings;
+} PresentationStats;
+
+static void
+on_presented (ClutterStage      *stage,
+              ClutterStageView  *view,
+              ClutterFrameInfo  *frame_info,
+              PresentationStats *stats)
+{
+  int i;
+
+  for (i = 0; i < 2; i++)
+    {
+      if (stats[i].view != view)
+        continue;
+
+      if (stats[i].last_presentation_time_us != 0)
+        {
+          int64_t interval_us;
+
+          interval_us = (frame_info->presentation_time -
+                         stats[i].last_presentation_time_us);
+          stats[i].min_interval_us = MIN (stats[i].min_interval_us,
+                                          interval_us);
+        }
+
+      stats[i].n_presentations++;
+      stats[i].last_presentation_time_us = frame_info->presentation_time;
+
+      if (frame_info->cpu_time_before_buffer_swap_us != 0 &&
+          frame_info->has_valid_gpu_rendering_duration)
+        stats[i].got_timings = TRUE;
+    }
+}
+
+static void
+queue_redraw_on_presented (ClutterStage     *stage,
+                           ClutterStageView *view,
+                           ClutterFrameInfo *frame_info,
+                           gpointer          user_data)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+}
+
+static void
+set_done (gpointer user_data)
+{
+  gboolean *done = user_data;
+
+  *done = TRUE;
+}
+
+static void
+run_main_loop_for (unsigned int timeout_ms)
+{
+  gboolean done = FALSE;
+
+  g_timeout_add_once (timeout_ms, set_done, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static MetaVirtualMonitor *
+create_virtual_monitor_with_clock_mode (float                        refresh_rate,
+                                        MetaVirtualMonitorClockMode  clock_mode,
+                                        const char                  *serial)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaMonitorManager *monitor_manager = meta_backend_get_monitor_manager (backend);
+  g_autoptr (MetaVirtualMonitorInfo) monitor_info = NULL;
+  g_autoptr (GError) error = NULL;
+  MetaVirtualMonitor *virtual_monitor;
+
+  monitor_info = meta_virtual_monitor_info_new (80, 60, refresh_rate,
+                                                "MetaTestVendor",
+                                                "MetaVirtualMonitor",
+                                                serial);
+  monitor_info->clock_mode = clock_mode;
+  virtual_monitor = meta_monitor_manager_create_virtual_monitor (monitor_manager,
+                                                                 monitor_info,
+                                                                 &error);
+  if (!virtual_monitor)
+    g_error ("Failed to create virtual monitor: %s", error->message);
+
+  g_assert_cmpint (meta_virtual_monitor_get_clock_mode (virtual_monitor),
+                   ==,
+                   clock_mode);
+
+  return virtual_monitor;
+}
+
+static void
+meta_test_virtual_monitor_clock_modes (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaMonitorManager *monitor_manager = meta_backend_get_monitor_manager (backend);
+  MetaRenderer *renderer = meta_backend_get_renderer (backend);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  PresentationStats stats[2] = { 0 };
+  MetaVirtualMonitor *fixed_monitor;
+  MetaVirtualMonitor *variable_monitor;
+  MetaStageView *held_view;
+  gulong presented_handler_id;
+  gulong redraw_handler_id;
+  int n_held_presentations;
+  int i;
+
+  fixed_monitor =
+    create_virtual_monitor_with_clock_mode (60.0,
+                                            META_VIRTUAL_MONITOR_CLOCK_MODE_FIXED,
+                                            "0x1235");
+  variable_monitor =
+    create_virtual_monitor_with_clock_mode (20.0,
+                                            META_VIRTUAL_MONITOR_CLOCK_MODE_VARIABLE,
+                                            "0x1236");
+  meta_monitor_manager_reload (monitor_manager);
+
+  g_assert_cmpint (g_list_length (meta_renderer_get_views (renderer)), ==, 2);
+
+  stats[0].view = CLUTTER_STAGE_VIEW (
+    meta_renderer_get_view_for_crtc (renderer,
+                                     meta_virtual_monitor_get_crtc (fixed_monitor)));
+  stats[1].view = CLUTTER_STAGE_VIEW (
+    meta_renderer_get_view_for_crtc (renderer,
+                                     meta_virtual_monitor_get_crtc (variable_monitor)));
+  for (i = 0; i < 2; i++)
+    {
+      g_assert_nonnull (stats[i].view);
+      stats[i].min_interval_us = G_MAXINT64;
+    }
+
+  presented_handler_id = g_signal_connect (stage, "presented",
+                                           G_CALLBACK (on_presented),
+                                           stats);
+  redraw_handler_id = g_signal_connect (stage, "presented",
+                                        G_CALLBACK (queue_redraw_on_presented),
+                                        NULL);
+
+  /* Keep both views busy, each one is paced by its own clock */
+  clutter_actor_queue_redraw (stage);
+  run_main_loop_for (1000);
+
+  g_test_message ("Fixed 60 Hz: %d frames, shortest interval %" G_GINT64_FORMAT " us",
+                  stats[0].n_presentations, stats[0].min_interval_us);
+  g_test_message ("Variable 20 Hz: %d frames, shortest interval %" G_GINT64_FORMAT " us",
+                  stats[1].n_presentations, stats[1].min_interval_us);
+
+  for (i = 0; i < 2; i++)
+    {
+      g_assert_cmpint (stats[i].n_presentations, >, 1);
+      g_assert_true (stats[i].got_timings);
+    }
+
+  /* Neither clock may run faster than its refresh rate, allowing for the
+   * presentation times of virtual views being taken from an idle callback */
+  g_assert_cmpint (stats[0].n_presentations, <=, 66);
+  g_assert_cmpint (stats[1].n_presentations, <=, 22);
+  g_assert_cmpint (stats[1].min_interval_us, >=, (G_USEC_PER_SEC / 20) * 3 / 4);
+  g_assert_cmpint (stats[0].n_presentations, >, stats[1].n_presentations);
+
+  /* Holding back presentation, as done when pacing by a stream, stops the
+   * clock of that view without affecting the other one */
+  g_signal_handler_disconnect (stage, redraw_handler_id);
+  run_main_loop_for (200);
+
+  held_view = META_STAGE_VIEW (stats[1].view);
+  meta_stage_view_hold_presentation (held_view);
+  n_held_presentations = stats[1].n_presentations;
+  stats[0].n_presentations = 0;
+
+  for (i = 0; i < 3; i++)
+    {
+      clutter_actor_queue_redraw (stage);
+      run_main_loop_for (100);
+    }
+
+  g_assert_cmpint (stats[0].n_presentations, >=, 1);
+  g_assert_cmpint (stats[1].n_presentations, ==, n_held_presentations);
+
+  meta_stage_view_release_presentation (held_view);
+  while (stats[1].n_presentations == n_held_presentations)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_signal_handler_disconnect (stage, presented_handler_id);
+
+  g_object_unref (variable_monitor);
+  g_object_unref (fixed_monitor);
+  meta_monitor_manager_reload (monitor_manager);
+
+  g_assert_null (meta_renderer_get_views (renderer));
+}
+
 void
 init_virtual_monitor_tests (MetaContext *context)
 {
@@ -134,4 +333,6 @@ init_virtual_monitor_tests (MetaContext *context)
 
   g_test_add_func ("/backends/native/virtual-monitor/create",
                    meta_test_virtual_monitor_create);
+  g_test_add_func ("/backends/native/virtual-monitor/clock-modes",
+                   meta_test_virtual_monitor_clock_modes);
 }
@@ -46,6 +46,15 @@ enum
     CURSOR_MODE_METADATA = 2,
   };
 
+enum
+  {
+    REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_ABSOLUTE = 7,
+  };
+
+#define N_INPUT_BENCHMARK_EVENTS 10000
+#define N_CONSUMER_FRAMES 10
+#define CONSUMER_HOLD_TIME_MS 50
+
 typedef struct _Stream
 {
   MetaDBusScreenCastStream *proxy;
@@ -56,6 +65,12 @@ typedef struct _Stream
   enum pw_stream_state state;
   int buffer_count;
 
+  gboolean hold_buffers;
+  GList *held_buffers;
+
+  int hold_time_ms;
+  int n_lingering_buffers;
+
   int target_width;
   int target_height;
 
@@ -336,6 +351,25 @@ process_buffer (Stream            *stream,
     g_assert_not_reached ();
 }
 
+typedef struct _LingeringBuffer
+{
+  Stream *stream;
+  struct pw_buffer *buffer;
+} LingeringBuffer;
+
+static gboolean
+return_lingering_buffer (gpointer user_data)
+{
+  LingeringBuffer *lingering_buffer = user_data;
+  Stream *stream = lingering_buffer->stream;
+
+  pw_stream_queue_buffer (stream->pipewire_stream, lingering_buffer->buffer);
+  stream->n_lingering_buffers--;
+  g_free (lingering_buffer);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 on_stream_process (void *user_data)
 {
@@ -346,6 +380,35 @@ on_stream_process (void *user_data)
   if (!stream->pipewire_stream)
     return;
 
+  /* Act like a consumer that fell behind, and keep every buffer */
+  if (stream->hold_buffers)
+    {
+      while ((buffer = pw_stream_dequeue_buffer (stream->pipewire_stream)))
+        stream->held_buffers = g_list_prepend (stream->held_buffers, buffer);
+      return;
+    }
+
+  /* Act like a consumer taking its time with every frame */
+  if (stream->hold_time_ms > 0)
+    {
+      while ((buffer = pw_stream_dequeue_buffer (stream->pipewire_stream)))
+        {
+          LingeringBuffer *lingering_buffer;
+
+          process_buffer (stream, buffer->buffer);
+          stream->buffer_count++;
+
+          lingering_buffer = g_new0 (LingeringBuffer, 1);
+          lingering_buffer->stream = stream;
+          lingering_buffer->buffer = buffer;
+          stream->n_lingering_buffers++;
+          g_timeout_add (stream->hold_time_ms,
+                         return_lingering_buffer,
+                         lingering_buffer);
+        }
+      return;
+    }
+
   next_buffer = pw_stream_dequeue_buffer (stream->pipewire_stream);
   if (next_buffer)
     g_debug ("Dequeued buffer, queue previous");
@@ -487,6 +550,55 @@ stream_resize (Stream *stream,
                            params, G_N_ELEMENTS (params));
 }
 
+static void
+stream_get_statistics (Stream   *stream,
+                       uint64_t *frames_produced,
+                       uint64_t *frames_dropped)
+{
+  g_autoptr (GVariant) statistics = NULL;
+  GError *error = NULL;
+  int64_t average_latency;
+  int64_t max_latency;
+
+  if (!meta_dbus_screen_cast_stream_call_get_statistics_sync (stream->proxy,
+                                                              &statistics,
+                                                              NULL,
+                                                              &error))
+    g_error ("Failed to get stream statistics: %s", error->message);
+
+  g_assert_true (g_variant_lookup (statistics, "frames-produced", "t",
+                                   frames_produced));
+  g_assert_true (g_variant_lookup (statistics, "frames-dropped", "t",
+                                   frames_dropped));
+  g_assert_true (g_variant_lookup (statistics, "average-latency", "x",
+                                   &average_latency));
+  g_assert_true (g_variant_lookup (statistics, "max-latency", "x",
+                                   &max_latency));
+
+  g_assert_cmpint (average_latency, >=, 0);
+  g_assert_cmpint (max_latency, >=, average_latency);
+}
+
+static void
+stream_get_latency (Stream  *stream,
+                    int64_t *average_latency,
+                    int64_t *max_latency)
+{
+  g_autoptr (GVariant) statistics = NULL;
+  GError *error = NULL;
+
+  if (!meta_dbus_screen_cast_stream_call_get_statistics_sync (stream->proxy,
+                                                              &statistics,
+                                                              NULL,
+                                                              &error))
+    g_error ("Failed to get stream statistics: %s", error->message);
+
+  g_assert_true (g_variant_lookup (statistics, "average-latency", "x",
+                                   average_latency));
+  g_assert_true (g_variant_lookup (statistics, "max-latency", "x",
+                                   max_latency));
+}
+
 static void
 on_pipewire_stream_added (MetaDBusScreenCastStream *proxy,
                           unsigned int              node_id,
@@ -548,6 +660,184 @@ session_notify_absolute_pointer (Session *session,
     g_error ("Failed to send absolute pointer motion event: %s", error->message);
 }
 
+static void
+session_benchmark_absolute_pointer (Session *session,
+                                    Stream  *stream,
+                                    double   final_x,
+                                    double   final_y)
+{
+  const char *stream_path =
+    g_dbus_proxy_get_object_path (G_DBUS_PROXY (stream->proxy));
+  GVariantBuilder events_builder;
+  GError *error = NULL;
+  int64_t start_time_us;
+  int64_t per_event_duration_us;
+  int64_t batched_duration_us;
+  int i;
+
+  start_time_us = g_get_monotonic_time ();
+  for (i = 0; i < N_INPUT_BENCHMARK_EVENTS; i++)
+    session_notify_absolute_pointer (session, stream, i % 20, i % 10);
+  per_event_duration_us = g_get_monotonic_time () - start_time_us;
+
+  g_variant_builder_init (&events_builder, G_VARIANT_TYPE ("a(utv)"));
+  for (i = 0; i < N_INPUT_BENCHMARK_EVENTS; i++)
+    {
+      double x, y;
+
+      if (i == N_INPUT_BENCHMARK_EVENTS - 1)
+        {
+          x = final_x;
+          y = final_y;
+        }
+      else
+        {
+          x = i % 20;
+          y = i % 10;
+        }
+
+      g_variant_builder_add (&events_builder, "(utv)",
+                             REMOTE_DESKTOP_EVENT_TYPE_POINTER_MOTION_ABSOLUTE,
+                             (uint64_t) g_get_monotonic_time (),
+                             g_variant_new ("(sdd)", stream_path, x, y));
+    }
+
+  start_time_us = g_get_monotonic_time ();
+  if (!meta_dbus_remote_desktop_session_call_notify_events_sync (
+        session->remote_desktop_session_proxy,
+        g_variant_builder_end (&events_builder),
+        NULL, &error))
+    g_error ("Failed to send batched pointer motion events: %s", error->message);
+  batched_duration_us = g_get_monotonic_time () - start_time_us;
+
+  g_debug ("Injected %d events one by one in %" G_GINT64_FORMAT " us "
+           "(%.0f events/s), batched in %" G_GINT64_FORMAT " us "
+           "(%.0f events/s)",
+           N_INPUT_BENCHMARK_EVENTS,
+           per_event_duration_us,
+           N_INPUT_BENCHMARK_EVENTS * (double) G_USEC_PER_SEC /
+           MAX (per_event_duration_us, 1),
+           batched_duration_us,
+           N_INPUT_BENCHMARK_EVENTS * (double) G_USEC_PER_SEC /
+           MAX (batched_duration_us, 1));
+
+  g_assert_cmpint (batched_duration_us, <, per_event_duration_us);
+}
+
+static void
+stream_check_fast_consumer (Session *session,
+                            Stream  *stream)
+{
+  uint64_t frames_produced;
+  uint64_t frames_dropped, initial_frames_dropped;
+  int initial_buffer_count = stream->buffer_count;
+  int i;
+
+  stream_get_statistics (stream, &frames_produced, &initial_frames_dropped);
+
+  /* A consumer handing back every buffer right away never misses a frame */
+  for (i = 0; i < N_CONSUMER_FRAMES; i++)
+    {
+      session_notify_absolute_pointer (session, stream, 10 + i, 10);
+      stream_wait_for_render (stream);
+    }
+
+  stream_get_statistics (stream, &frames_produced, &frames_dropped);
+  g_debug ("Fast consumer: %d frames received, %" G_GUINT64_FORMAT " dropped",
+           stream->buffer_count - initial_buffer_count,
+           frames_dropped - initial_frames_dropped);
+
+  g_assert_cmpuint (frames_dropped, ==, initial_frames_dropped);
+}
+
+static void
+stream_check_lingering_consumer (Session *session,
+                                 Stream  *stream)
+{
+  int64_t average_latency, initial_average_latency;
+  int64_t max_latency;
+  int i;
+
+  stream_get_latency (stream, &initial_average_latency, &max_latency);
+
+  /* The time a consumer holds on to every buffer shows in the latency */
+  stream->hold_time_ms = CONSUMER_HOLD_TIME_MS;
+  for (i = 0; i < N_CONSUMER_FRAMES; i++)
+    {
+      session_notify_absolute_pointer (session, stream, 10 + i, 15);
+      stream_wait_for_render (stream);
+    }
+
+  stream->hold_time_ms = 0;
+  while (stream->n_lingering_buffers > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  stream_get_latency (stream, &average_latency, &max_latency);
+  g_debug ("Lingering consumer: %" G_GINT64_FORMAT " us average latency, "
+           "%" G_GINT64_FORMAT " us max",
+           average_latency, max_latency);
+
+  g_assert_cmpint (max_latency, >=, CONSUMER_HOLD_TIME_MS * 1000);
+  g_assert_cmpint (average_latency, >, initial_average_latency);
+}
+
+static void
+stream_check_slow_consumer (Session *session,
+                            Stream  *stream)
+{
+  uint64_t frames_produced;
+  uint64_t frames_dropped, initial_frames_dropped;
+  int initial_buffer_count;
+  GList *l;
+  int i;
+
+  stream_get_statistics (stream, &frames_produced, &initial_frames_dropped);
+
+  /* With every buffer held by the consumer, frames are dropped */
+  stream->hold_buffers = TRUE;
+  i = 0;
+  do
+    {
+      session_notify_absolute_pointer (session, stream, 10 + i++ % 20, 20);
+      while (g_main_context_iteration (NULL, FALSE));
+
+      stream_get_statistics (stream, &frames_produced, &frames_dropped);
+    }
+  while (frames_dropped == initial_frames_dropped);
+
+  g_debug ("Slow consumer: %" G_GUINT64_FORMAT " frames dropped "
+           "holding %u buffers",
+           frames_dropped - initial_frames_dropped,
+           g_list_length (stream->held_buffers));
+  g_assert_nonnull (stream->held_buffers);
+
+  /* Once the buffers are handed back, frames get through again, and
+   * nothing else is dropped */
+  stream->hold_buffers = FALSE;
+  for (l = stream->held_buffers; l; l = l->next)
+    pw_stream_queue_buffer (stream->pipewire_stream, l->data);
+  g_clear_pointer (&stream->held_buffers, g_list_free);
+  session_notify_absolute_pointer (session, stream, 30, 30);
+  stream_wait_for_render (stream);
+
+  stream_get_statistics (stream, &frames_produced, &initial_frames_dropped);
+  initial_buffer_count = stream->buffer_count;
+
+  for (i = 0; i < N_CONSUMER_FRAMES; i++)
+    {
+      session_notify_absolute_pointer (session, stream, 40 + i, 30);
+      stream_wait_for_render (stream);
+    }
+
+  stream_get_statistics (stream, &frames_produced, &frames_dropped);
+  g_debug ("Slow consumer caught up: %d frames received, "
+           "%" G_GUINT64_FORMAT " dropped",
+           stream->buffer_count - initial_buffer_count,
+           frames_dropped - initial_frames_dropped);
+
+  g_assert_cmpuint (frames_dropped, ==, initial_frames_dropped);
+}
+
 static void
 session_start (Session *session)
 {
@@ -780,6 +1070,12 @@ main (int    argc,
   g_assert_cmpint (stream->spa_format.size.width, ==, 50);
   g_assert_cmpint (stream->spa_format.size.height, ==, 40);
 
+  /* Check that batched events are emitted in order */
+  g_debug ("Injecting pointer motion events");
+  session_benchmark_absolute_pointer (session, stream, 8, 9);
+  stream_wait_for_render (stream);
+  stream_wait_for_cursor_position (stream, 8, 9);
+
   /* Check that resizing works */
   g_debug ("Resizing stream");
   stream_resize (stream, 70, 60);
@@ -798,6 +1094,15 @@ main (int    argc,
   /* Check that resizing works */
   stream_resize (stream, 60, 60);
 
+  g_debug ("Checking a consumer keeping up");
+  stream_check_fast_consumer (session, stream);
+
+  g_debug ("Checking a consumer holding on to buffers");
+  stream_check_lingering_consumer (session, stream);
+
+  g_debug ("Checking a consumer falling behind");
+  stream_check_slow_consumer (session, stream);
+
   g_debug ("Stopping session");
   session_stop (session);
 
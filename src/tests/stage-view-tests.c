@@ -1317,6 +1317,73 @@ meta_test_timeline_actor_tree_clear (void)
   clutter_actor_destroy (container2);
 }
 
+typedef struct
+{
+  ClutterStageView *view;
+  gboolean was_painted;
+} ViewPaintData;
+
+static void
+on_view_after_paint (ClutterStage     *stage,
+                     ClutterStageView *view,
+                     ClutterFrame     *frame,
+                     ViewPaintData    *data)
+{
+  if (view == data->view)
+    data->was_painted = TRUE;
+}
+
+static void
+wait_for_view_paint (ClutterActor     *stage,
+                     ClutterStageView *view)
+{
+  ViewPaintData data = { .view = view };
+  gulong was_painted_id;
+
+  was_painted_id = g_signal_connect (CLUTTER_STAGE (stage),
+                                     "after-paint",
+                                     G_CALLBACK (on_view_after_paint),
+                                     &data);
+
+  while (!data.was_painted)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_signal_handler_disconnect (stage, was_painted_id);
+}
+
+static void
+meta_test_actor_damage_statistics (void)
+{
+  ClutterActor *stage;
+  ClutterActor *actor;
+  ClutterStageView *view;
+  ClutterDamageStatistics statistics;
+  MtkRectangle clip = { 10, 10, 20, 20 };
+
+  stage = meta_backend_get_stage (test_backend);
+
+  actor = clutter_actor_new ();
+  clutter_actor_set_background_color (actor, &CLUTTER_COLOR_INIT (255, 0, 0, 255));
+  clutter_actor_set_size (actor, 100, 100);
+  clutter_actor_add_child (stage, actor);
+
+  wait_for_paint (stage);
+
+  view = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage))->data;
+  is_on_stage_views (actor, 1, view);
+
+  /* Only the clip is damaged, and without buffer age nothing else needs
+   * to be repainted */
+  clutter_actor_queue_redraw_with_clip (actor, &clip);
+  wait_for_view_paint (stage, view);
+
+  clutter_stage_view_get_damage_statistics (view, &statistics);
+  g_assert_cmpuint (statistics.damaged_area, ==, 20 * 20);
+  g_assert_cmpuint (statistics.repainted_area, >=, statistics.damaged_area);
+
+  clutter_actor_destroy (actor);
+}
+
 static void
 on_before_tests (MetaContext *context)
 {
@@ -1356,6 +1423,8 @@ init_tests (void)
                    meta_test_timeline_actor_destroyed);
   g_test_add_func ("/stage-views/timeline/tree-clear",
                    meta_test_timeline_actor_tree_clear);
+  g_test_add_func ("/stage-views/damage-statistics",
+                   meta_test_actor_damage_statistics);
 }
 
 int
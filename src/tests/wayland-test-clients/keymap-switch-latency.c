@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+/* Keep in sync with wayland-unit-tests.c */
+#define N_KEYBOARDS 200
+#define N_KEYMAP_SWITCHES 20
+
+static struct wl_seat *wl_seat;
+static int n_keymaps;
+
+static void
+keyboard_handle_keymap (void               *data,
+                        struct wl_keyboard *wl_keyboard,
+                        uint32_t            format,
+                        int32_t             fd,
+                        uint32_t            size)
+{
+  g_assert_cmpuint (format, ==, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1);
+  g_assert_cmpuint (size, >, 0);
+
+  close (fd);
+  n_keymaps++;
+}
+
+static void
+keyboard_handle_enter (void               *data,
+                       struct wl_keyboard *wl_keyboard,
+                       uint32_t            serial,
+                       struct wl_surface  *surface,
+                       struct wl_array    *keys)
+{
+}
+
+static void
+keyboard_handle_leave (void               *data,
+                       struct wl_keyboard *wl_keyboard,
+                       uint32_t            serial,
+                       struct wl_surface  *surface)
+{
+}
+
+static void
+keyboard_handle_key (void               *data,
+                     struct wl_keyboard *wl_keyboard,
+                     uint32_t            serial,
+                     uint32_t            time,
+                     uint32_t            key,
+                     uint32_t            state)
+{
+}
+
+static void
+keyboard_handle_modifiers (void               *data,
+                           struct wl_keyboard *wl_keyboard,
+                           uint32_t            serial,
+                           uint32_t            mods_depressed,
+                           uint32_t            mods_latched,
+                           uint32_t            mods_locked,
+                           uint32_t            group)
+{
+}
+
+static void
+keyboard_handle_repeat_info (void               *data,
+                             struct wl_keyboard *wl_keyboard,
+                             int32_t             rate,
+                             int32_t             delay)
+{
+}
+
+static const struct wl_keyboard_listener keyboard_listener = {
+  keyboard_handle_keymap,
+  keyboard_handle_enter,
+  keyboard_handle_leave,
+  keyboard_handle_key,
+  keyboard_handle_modifiers,
+  keyboard_handle_repeat_info,
+};
+
+static void
+handle_registry_global (void               *data,
+                        struct wl_registry *registry,
+                        uint32_t            id,
+                        const char         *interface,
+                        uint32_t            version)
+{
+  if (strcmp (interface, "wl_seat") == 0)
+    {
+      /* Version 7 and later get the keymap as a sealed file, which can
+       * be shared between all the keyboards */
+      wl_seat = wl_registry_bind (registry, id,
+                                  &wl_seat_interface,
+                                  MIN (version, 7));
+    }
+}
+
+static void
+handle_registry_global_remove (void               *data,
+                               struct wl_registry *registry,
+                               uint32_t            name)
+{
+}
+
+static const struct wl_registry_listener registry_listener = {
+  handle_registry_global,
+  handle_registry_global_remove
+};
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (WaylandDisplay) display = NULL;
+  struct wl_registry *wl_registry;
+  struct wl_keyboard *keyboards[N_KEYBOARDS];
+  int i;
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  wl_registry = wl_display_get_registry (display->display);
+  wl_registry_add_listener (wl_registry, &registry_listener, display);
+  wl_display_roundtrip (display->display);
+  g_assert_nonnull (wl_seat);
+
+  for (i = 0; i < N_KEYBOARDS; i++)
+    {
+      keyboards[i] = wl_seat_get_keyboard (wl_seat);
+      wl_keyboard_add_listener (keyboards[i], &keyboard_listener, NULL);
+    }
+
+  wl_display_roundtrip (display->display);
+  g_assert_cmpint (n_keymaps, ==, N_KEYBOARDS);
+
+  test_driver_sync_point (display->test_driver, 0, NULL);
+
+  /* The compositor switches the keymap after each sync point, and
+   * measures until every keyboard has received the new one */
+  for (i = 0; i < N_KEYMAP_SWITCHES; i++)
+    {
+      while (n_keymaps < (i + 2) * N_KEYBOARDS)
+        wayland_display_dispatch (display);
+
+      test_driver_sync_point (display->test_driver, i + 1, NULL);
+    }
+
+  wl_display_roundtrip (display->display);
+  g_assert_cmpint (n_keymaps, ==, (N_KEYMAP_SWITCHES + 1) * N_KEYBOARDS);
+
+  for (i = 0; i < N_KEYBOARDS; i++)
+    wl_keyboard_release (keyboards[i]);
+  wl_seat_release (wl_seat);
+  wl_registry_destroy (wl_registry);
+
+  return EXIT_SUCCESS;
+}
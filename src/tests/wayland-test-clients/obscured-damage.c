@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+enum
+{
+  OBSCURED_DAMAGE_COMMAND_ACTIVATE_WINDOW = 0,
+  OBSCURED_DAMAGE_COMMAND_CHECK_OBSCURED = 1,
+  OBSCURED_DAMAGE_COMMAND_CHECK_REVEALED = 2,
+};
+
+static void
+wait_for_state (WaylandSurface          *surface,
+                enum xdg_toplevel_state  state)
+{
+  while (!wayland_surface_has_state (surface, state))
+    wayland_display_dispatch (surface->display);
+}
+
+static void
+wait_for_no_state (WaylandSurface          *surface,
+                   enum xdg_toplevel_state  state)
+{
+  while (wayland_surface_has_state (surface, state))
+    wayland_display_dispatch (surface->display);
+}
+
+static void
+redraw_surface (WaylandSurface *surface,
+                uint32_t        color)
+{
+  draw_surface (surface->display, surface->wl_surface,
+                surface->width, surface->height,
+                color);
+  wl_surface_damage_buffer (surface->wl_surface,
+                            0, 0,
+                            surface->width, surface->height);
+  wl_surface_commit (surface->wl_surface);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (WaylandDisplay) display = NULL;
+  g_autoptr (WaylandSurface) surface = NULL;
+  g_autoptr (WaylandSurface) cover_surface = NULL;
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER |
+                                 WAYLAND_DISPLAY_CAPABILITY_XDG_SHELL_V6);
+
+  surface = wayland_surface_new (display, "obscured-damage",
+                                 100, 100, 0xffff0000);
+  wl_surface_commit (surface->wl_surface);
+  wait_for_window_shown (display, surface->wl_surface);
+
+  cover_surface = wayland_surface_new (display, "obscured-damage-cover",
+                                       100, 100, 0xffffffff);
+  xdg_toplevel_set_maximized (cover_surface->xdg_toplevel);
+  wl_surface_commit (cover_surface->wl_surface);
+  wait_for_window_shown (display, cover_surface->wl_surface);
+
+  test_driver_sync_point (display->test_driver,
+                          OBSCURED_DAMAGE_COMMAND_ACTIVATE_WINDOW,
+                          cover_surface->wl_surface);
+  wait_for_state (surface, XDG_TOPLEVEL_STATE_SUSPENDED);
+
+  /* Update the content of the window while it is entirely covered */
+  redraw_surface (surface, 0xff00ff00);
+  test_driver_sync_point (display->test_driver,
+                          OBSCURED_DAMAGE_COMMAND_CHECK_OBSCURED,
+                          surface->wl_surface);
+  wait_for_sync_event (display, 0);
+
+  g_clear_object (&cover_surface);
+  wait_for_no_state (surface, XDG_TOPLEVEL_STATE_SUSPENDED);
+
+  test_driver_sync_point (display->test_driver,
+                          OBSCURED_DAMAGE_COMMAND_CHECK_REVEALED,
+                          surface->wl_surface);
+  wait_for_sync_event (display, 1);
+
+  return EXIT_SUCCESS;
+}
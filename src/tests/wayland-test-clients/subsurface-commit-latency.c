@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+/* 4 children with 4 grand-children each, i.e. 20 sub-surfaces */
+#define N_CHILDREN 4
+#define N_GRANDCHILDREN 4
+#define N_SUBSURFACES (N_CHILDREN + N_CHILDREN * N_GRANDCHILDREN)
+#define N_COMMITS 500
+
+typedef struct
+{
+  struct wl_surface *wl_surface;
+  struct wl_subsurface *wl_subsurface;
+} Subsurface;
+
+static void
+create_subsurface (WaylandDisplay    *display,
+                   Subsurface        *subsurface,
+                   struct wl_surface *parent,
+                   uint32_t           color)
+{
+  subsurface->wl_surface = wl_compositor_create_surface (display->compositor);
+  subsurface->wl_subsurface =
+    wl_subcompositor_get_subsurface (display->subcompositor,
+                                     subsurface->wl_surface,
+                                     parent);
+  draw_surface (display, subsurface->wl_surface, 10, 10, color);
+}
+
+static void
+commit_tree (Subsurface         *subsurfaces,
+             struct wl_surface  *toplevel_surface,
+             int                 offset)
+{
+  int i;
+
+  /* Commit descendants before their ancestors, like a client updating a
+   * synchronized sub-surface tree would */
+  for (i = N_SUBSURFACES - 1; i >= 0; i--)
+    {
+      wl_subsurface_set_position (subsurfaces[i].wl_subsurface,
+                                  (i * 5 + offset) % 50,
+                                  (i * 3 + offset) % 50);
+      wl_surface_commit (subsurfaces[i].wl_surface);
+    }
+
+  wl_surface_commit (toplevel_surface);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (WaylandDisplay) display = NULL;
+  g_autoptr (WaylandSurface) toplevel = NULL;
+  Subsurface subsurfaces[N_SUBSURFACES];
+  int64_t total_latency_us = 0;
+  int64_t max_latency_us = 0;
+  int i, j;
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  toplevel = wayland_surface_new (display,
+                                  "subsurface-commit-latency",
+                                  100, 100, 0xffffffff);
+  wl_surface_commit (toplevel->wl_surface);
+  wait_for_window_shown (display, toplevel->wl_surface);
+
+  for (i = 0; i < N_CHILDREN; i++)
+    {
+      Subsurface *child = &subsurfaces[i];
+
+      create_subsurface (display, child, toplevel->wl_surface, 0xff000000u);
+
+      for (j = 0; j < N_GRANDCHILDREN; j++)
+        {
+          Subsurface *grandchild =
+            &subsurfaces[N_CHILDREN + i * N_GRANDCHILDREN + j];
+
+          create_subsurface (display, grandchild, child->wl_surface,
+                             0xffff0000u);
+        }
+    }
+
+  commit_tree (subsurfaces, toplevel->wl_surface, 0);
+  wl_display_roundtrip (display->display);
+
+  /* Without new buffers, the transaction of each tree commit is applied
+   * before the compositor handles the following wl_display.sync */
+  for (i = 0; i < N_COMMITS; i++)
+    {
+      int64_t start_us, latency_us;
+
+      start_us = g_get_monotonic_time ();
+      commit_tree (subsurfaces, toplevel->wl_surface, i + 1);
+      g_assert_cmpint (wl_display_roundtrip (display->display), !=, -1);
+      latency_us = g_get_monotonic_time () - start_us;
+
+      total_latency_us += latency_us;
+      max_latency_us = MAX (max_latency_us, latency_us);
+    }
+
+  g_message ("Committed a tree of %d sub-surfaces %d times, "
+             "commit-to-apply latency: average %.3f ms, max %.3f ms",
+             N_SUBSURFACES, N_COMMITS,
+             total_latency_us / 1000.0 / N_COMMITS,
+             max_latency_us / 1000.0);
+
+  for (i = 0; i < N_SUBSURFACES; i++)
+    {
+      wl_subsurface_destroy (subsurfaces[i].wl_subsurface);
+      wl_surface_destroy (subsurfaces[i].wl_surface);
+    }
+
+  return EXIT_SUCCESS;
+}
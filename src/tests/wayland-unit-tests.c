@@ -34,6 +34,7 @@
 #include "tests/meta-monitor-test-utils.h"
 #include "tests/meta-wayland-test-driver.h"
 #include "tests/meta-wayland-test-utils.h"
+#include "wayland/meta-wayland-buffer.h"
 #include "wayland/meta-wayland-client-private.h"
 #include "wayland/meta-wayland-filter-manager.h"
 #include "wayland/meta-wayland-surface-private.h"
@@ -298,6 +299,16 @@ subsurface_corner_cases (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+subsurface_commit_latency (void)
+{
+  MetaWaylandTestClient *wayland_test_client;
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "subsurface-commit-latency");
+  meta_wayland_test_client_finish (wayland_test_client);
+}
+
 static void
 subsurface_reparenting (void)
 {
@@ -716,6 +727,80 @@ toplevel_bounds_struts (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+workspace_shared_work_areas (void)
+{
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaWorkspaceManager *workspace_manager =
+    meta_display_get_workspace_manager (display);
+  MetaWorkspace *workspace1;
+  MetaWorkspace *workspace2;
+  MtkRectangle logical_monitor_layout;
+  MtkRectangle work_area1;
+  MtkRectangle work_area2;
+  MetaStrut strut;
+  g_autoptr (GSList) struts = NULL;
+
+  /*
+   * This test case makes sure that workspaces with identical struts share
+   * their work areas, and stop doing so once their struts differ.
+   */
+
+  logical_monitor_layout = get_primary_logical_monitor_layout ();
+  workspace1 = meta_workspace_manager_get_active_workspace (workspace_manager);
+  workspace2 =
+    meta_workspace_manager_append_new_workspace (workspace_manager,
+                                                 FALSE,
+                                                 META_CURRENT_TIME);
+
+  set_struts ((MtkRectangle) {
+                .x = 0,
+                .y = 0,
+                .width = logical_monitor_layout.width,
+                .height = 10,
+              },
+              META_SIDE_TOP);
+
+  meta_workspace_get_work_area_all_monitors (workspace1, &work_area1);
+  meta_workspace_get_work_area_all_monitors (workspace2, &work_area2);
+  g_assert_true (mtk_rectangle_equal (&work_area1, &work_area2));
+  g_assert_cmpint (work_area1.height, ==, logical_monitor_layout.height - 10);
+  g_assert_cmpint (meta_workspace_manager_get_n_work_area_sets (workspace_manager),
+                   ==, 1);
+
+  strut = (MetaStrut) {
+    .rect = {
+      .x = 0,
+      .y = logical_monitor_layout.height - 20,
+      .width = logical_monitor_layout.width,
+      .height = 20,
+    },
+    .side = META_SIDE_BOTTOM,
+  };
+  struts = g_slist_append (NULL, &strut);
+  meta_workspace_set_builtin_struts (workspace2, struts);
+
+  meta_workspace_get_work_area_all_monitors (workspace1, &work_area1);
+  meta_workspace_get_work_area_all_monitors (workspace2, &work_area2);
+  g_assert_cmpint (work_area1.y, ==, 10);
+  g_assert_cmpint (work_area2.y, ==, 0);
+  g_assert_cmpint (work_area2.height, ==, logical_monitor_layout.height - 20);
+  g_assert_cmpint (meta_workspace_manager_get_n_work_area_sets (workspace_manager),
+                   ==, 2);
+
+  clear_struts ();
+
+  meta_workspace_get_work_area_all_monitors (workspace1, &work_area1);
+  meta_workspace_get_work_area_all_monitors (workspace2, &work_area2);
+  g_assert_true (mtk_rectangle_equal (&work_area1, &work_area2));
+  g_assert_cmpint (meta_workspace_manager_get_n_work_area_sets (workspace_manager),
+                   ==, 1);
+
+  meta_workspace_manager_remove_workspace (workspace_manager,
+                                           workspace2,
+                                           META_CURRENT_TIME);
+}
+
 static void
 wait_for_cursor_position (float x,
                           float y)
@@ -964,6 +1049,142 @@ toplevel_suspended (void)
   g_signal_handler_disconnect (test_driver, sync_point_id);
 }
 
+enum
+{
+  OBSCURED_DAMAGE_COMMAND_ACTIVATE_WINDOW = 0,
+  OBSCURED_DAMAGE_COMMAND_CHECK_OBSCURED = 1,
+  OBSCURED_DAMAGE_COMMAND_CHECK_REVEALED = 2,
+};
+
+static uint32_t
+get_window_texture_pixel (MetaWindow *window,
+                          int         x,
+                          int         y)
+{
+  MetaWindowActor *window_actor = meta_window_actor_from_window (window);
+  MetaShapedTexture *stex = meta_window_actor_get_texture (window_actor);
+  cairo_surface_t *image;
+  uint8_t *data;
+  uint32_t pixel;
+
+  image = meta_shaped_texture_get_image (stex, NULL);
+  g_assert_nonnull (image);
+
+  cairo_surface_flush (image);
+  data = cairo_image_surface_get_data (image);
+  pixel = *(uint32_t *) (data +
+                         y * cairo_image_surface_get_stride (image) +
+                         x * 4);
+  cairo_surface_destroy (image);
+
+  return pixel;
+}
+
+static void
+on_obscured_damage_sync_point (MetaWaylandTestDriver *test_driver,
+                               unsigned int           sequence,
+                               struct wl_resource    *surface_resource,
+                               struct wl_client      *wl_client)
+{
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaWaylandSurface *surface = wl_resource_get_user_data (surface_resource);
+  MetaWindow *window = meta_wayland_surface_get_window (surface);
+  uint32_t now_ms;
+
+  switch (sequence)
+    {
+    case OBSCURED_DAMAGE_COMMAND_ACTIVATE_WINDOW:
+      now_ms = meta_display_get_current_time_roundtrip (display);
+      meta_window_activate (window, now_ms);
+      break;
+    case OBSCURED_DAMAGE_COMMAND_CHECK_OBSCURED:
+      /* The new content of a covered shm window is not uploaded yet, but
+       * anyone asking for the window content still gets it */
+      if (surface->buffer->type == META_WAYLAND_BUFFER_TYPE_SHM)
+        g_assert_nonnull (surface->deferred_damage.region);
+      g_assert_cmphex (get_window_texture_pixel (window, 50, 50),
+                       ==, 0xff00ff00);
+      g_assert_null (surface->deferred_damage.region);
+      meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+      break;
+    case OBSCURED_DAMAGE_COMMAND_CHECK_REVEALED:
+      /* Once revealed, the texture must have caught up with the client */
+      g_assert_cmphex (get_window_texture_pixel (window, 50, 50),
+                       ==, 0xff00ff00);
+      meta_wayland_test_driver_emit_sync_event (test_driver, 1);
+      break;
+    }
+}
+
+static void
+obscured_damage (void)
+{
+  MetaWaylandTestClient *wayland_test_client;
+  gulong sync_point_id;
+
+  sync_point_id =
+    g_signal_connect (test_driver, "sync-point",
+                      G_CALLBACK (on_obscured_damage_sync_point),
+                      NULL);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "obscured-damage");
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_signal_handler_disconnect (test_driver, sync_point_id);
+}
+
+/* Keep in sync with keymap-switch-latency.c */
+#define N_KEYBOARDS 200
+#define N_KEYMAP_SWITCHES 20
+
+static void
+keyboard_keymap_switch_latency (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  static const char *layouts[] = { "us,ru", "de" };
+  MetaWaylandTestClient *wayland_test_client;
+  int64_t uncached_us = 0;
+  int64_t cached_us = 0;
+  int i;
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "keymap-switch-latency");
+  wait_for_sync_point (0);
+
+  /* The client acknowledges each switch once all of its keyboards got
+   * the new keymap. The first switch to each layout compiles the keymap,
+   * later ones reuse the cached snapshot. */
+  for (i = 0; i < N_KEYMAP_SWITCHES; i++)
+    {
+      int64_t start_time_us;
+      int64_t latency_us;
+
+      start_time_us = g_get_monotonic_time ();
+      meta_backend_set_keymap (backend, layouts[i % G_N_ELEMENTS (layouts)],
+                               "", "", "");
+      wait_for_sync_point (i + 1);
+      latency_us = g_get_monotonic_time () - start_time_us;
+
+      if (i < (int) G_N_ELEMENTS (layouts))
+        uncached_us += latency_us;
+      else
+        cached_us += latency_us;
+    }
+
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_test_message ("Switching keymaps with %d keyboards: %.3f ms for a new "
+                  "keymap, %.3f ms for a cached keymap",
+                  N_KEYBOARDS,
+                  uncached_us / (double) G_N_ELEMENTS (layouts) / 1000.0,
+                  cached_us /
+                  (double) (N_KEYMAP_SWITCHES - G_N_ELEMENTS (layouts)) /
+                  1000.0);
+
+  meta_backend_set_keymap (backend, "us", "", "", "");
+}
+
 static void
 on_before_tests (void)
 {
@@ -1012,8 +1233,12 @@ init_tests (void)
                    buffer_ycbcr_basic);
   g_test_add_func ("/wayland/idle-inhibit/instant-destroy",
                    idle_inhibit_instant_destroy);
+  g_test_add_func ("/wayland/keyboard/keymap-switch-latency",
+                   keyboard_keymap_switch_latency);
   g_test_add_func ("/wayland/registry/filter",
                    registry_filter);
+  g_test_add_func ("/wayland/surface/obscured-damage",
+                   obscured_damage);
   g_test_add_func ("/wayland/subsurface/remap-toplevel",
                    subsurface_remap_toplevel);
   g_test_add_func ("/wayland/subsurface/reparent",
@@ -1024,6 +1249,8 @@ init_tests (void)
                    subsurface_invalid_xdg_shell_actions);
   g_test_add_func ("/wayland/subsurface/corner-cases",
                    subsurface_corner_cases);
+  g_test_add_func ("/wayland/subsurface/commit-latency",
+                   subsurface_commit_latency);
   g_test_add_func ("/wayland/subsurface/parent-unmapped",
                    subsurface_parent_unmapped);
   g_test_add_func ("/wayland/toplevel/apply-limits",
@@ -1033,11 +1260,14 @@ init_tests (void)
 #ifdef MUTTER_PRIVILEGED_TEST
   (void)(toplevel_bounds_struts);
   (void)(toplevel_bounds_monitors);
+  (void)(workspace_shared_work_areas);
 #else
   g_test_add_func ("/wayland/toplevel/bounds/struts",
                    toplevel_bounds_struts);
   g_test_add_func ("/wayland/toplevel/bounds/monitors",
                    toplevel_bounds_monitors);
+  g_test_add_func ("/wayland/workspace/shared-work-areas",
+                   workspace_shared_work_areas);
 #endif
   g_test_add_func ("/wayland/xdg-foreign/set-parent-of",
                    xdg_foreign_set_parent_of);
@@ -58,9 +58,9 @@
 
 typedef struct
 {
+  MetaKeymapSnapshot *keymap_snapshot;
   struct xkb_keymap *keymap;
   struct xkb_state *state;
-  MetaAnonymousFile *keymap_rofile;
 } MetaWaylandXkbInfo;
 
 struct _MetaWaylandKeyboard
@@ -115,17 +115,22 @@ send_keymap (MetaWaylandKeyboard *keyboard,
              struct wl_resource  *resource)
 {
   MetaWaylandXkbInfo *xkb_info = &keyboard->xkb_info;
+  MetaAnonymousFile *keymap_file;
   int fd;
   size_t size;
   MetaAnonymousFileMapmode mapmode;
 
+  if (!xkb_info->keymap_snapshot)
+    return;
+
   if (wl_resource_get_version (resource) < 7)
     mapmode = META_ANONYMOUS_FILE_MAPMODE_SHARED;
   else
     mapmode = META_ANONYMOUS_FILE_MAPMODE_PRIVATE;
 
-  fd = meta_anonymous_file_open_fd (xkb_info->keymap_rofile, mapmode);
-  size = meta_anonymous_file_size (xkb_info->keymap_rofile);
+  keymap_file = meta_keymap_snapshot_get_keymap_file (xkb_info->keymap_snapshot);
+  fd = meta_anonymous_file_open_fd (keymap_file, mapmode);
+  size = meta_anonymous_file_size (keymap_file);
 
   if (fd == -1)
     {
@@ -153,45 +158,31 @@ inform_clients_of_new_keymap (MetaWaylandKeyboard *keyboard)
 
 static void
 meta_wayland_keyboard_take_keymap (MetaWaylandKeyboard *keyboard,
-				   struct xkb_keymap   *keymap)
+                                   MetaKeymapSnapshot  *keymap_snapshot)
 {
   MetaWaylandXkbInfo *xkb_info = &keyboard->xkb_info;
-  char *keymap_string;
-  size_t keymap_size;
+  gboolean keymap_changed;
 
-  if (keymap == NULL)
+  if (keymap_snapshot == NULL)
     {
       g_warning ("Attempting to set null keymap (compilation probably failed)");
       return;
     }
 
-  xkb_keymap_unref (xkb_info->keymap);
-  xkb_info->keymap = xkb_keymap_ref (keymap);
-
-  meta_wayland_keyboard_update_xkb_state (keyboard);
-
-  keymap_string =
-    xkb_keymap_get_as_string (xkb_info->keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
-  if (!keymap_string)
+  /* Snapshots are reused for the same keymap, in which case clients
+   * already have it */
+  keymap_changed = xkb_info->keymap_snapshot != keymap_snapshot;
+  if (keymap_changed)
     {
-      g_warning ("Failed to get string version of keymap");
-      return;
+      g_clear_pointer (&xkb_info->keymap_snapshot, meta_keymap_snapshot_unref);
+      xkb_info->keymap_snapshot = meta_keymap_snapshot_ref (keymap_snapshot);
+      xkb_info->keymap = meta_keymap_snapshot_get_keymap (keymap_snapshot);
     }
-  keymap_size = strlen (keymap_string) + 1;
 
-  g_clear_pointer (&xkb_info->keymap_rofile, meta_anonymous_file_free);
-  xkb_info->keymap_rofile =
-    meta_anonymous_file_new (keymap_size, (const uint8_t *) keymap_string);
-
-  free (keymap_string);
-
-  if (!xkb_info->keymap_rofile)
-    {
-      g_warning ("Failed to create anonymous file for keymap");
-      return;
-    }
+  meta_wayland_keyboard_update_xkb_state (keyboard);
 
-  inform_clients_of_new_keymap (keyboard);
+  if (keymap_changed)
+    inform_clients_of_new_keymap (keyboard);
 
   notify_modifiers (keyboard);
 }
@@ -229,7 +220,8 @@ on_keymap_changed (MetaBackend *backend,
 {
   MetaWaylandKeyboard *keyboard = data;
 
-  meta_wayland_keyboard_take_keymap (keyboard, meta_backend_get_keymap (backend));
+  meta_wayland_keyboard_take_keymap (keyboard,
+                                     meta_backend_get_keymap_snapshot (backend));
 }
 
 static void
@@ -568,7 +560,8 @@ meta_wayland_keyboard_enable (MetaWaylandKeyboard *keyboard)
 		    "kbd-a11y-mods-state-changed",
                     G_CALLBACK (on_kbd_a11y_mask_changed), keyboard);
 
-  meta_wayland_keyboard_take_keymap (keyboard, meta_backend_get_keymap (backend));
+  meta_wayland_keyboard_take_keymap (keyboard,
+                                     meta_backend_get_keymap_snapshot (backend));
 
   meta_wayland_keyboard_set_focus (keyboard, seat->input_focus);
 }
@@ -576,9 +569,9 @@ meta_wayland_keyboard_enable (MetaWaylandKeyboard *keyboard)
 static void
 meta_wayland_xkb_info_destroy (MetaWaylandXkbInfo *xkb_info)
 {
-  g_clear_pointer (&xkb_info->keymap, xkb_keymap_unref);
   g_clear_pointer (&xkb_info->state, xkb_state_unref);
-  g_clear_pointer (&xkb_info->keymap_rofile, meta_anonymous_file_free);
+  g_clear_pointer (&xkb_info->keymap_snapshot, meta_keymap_snapshot_unref);
+  xkb_info->keymap = NULL;
 }
 
 void
@@ -86,7 +86,8 @@ typedef struct
 {
   MetaWaylandPointerConstraint *constraint;
   MtkRegion *region;
-  gulong applied_handler_id;
+  MetaWaylandSurfaceState *pending;
+  gulong applied_hook_id;
 } MetaWaylandPendingConstraintState;
 
 typedef struct
@@ -693,8 +694,8 @@ pending_constraint_state_free (MetaWaylandPendingConstraintState *constraint_pen
 static MetaWaylandPendingConstraintStateContainer *
 get_pending_constraint_state_container (MetaWaylandSurfaceState *pending)
 {
-  return g_object_get_qdata (G_OBJECT (pending),
-                             quark_pending_constraint_state);
+  return meta_wayland_surface_state_get_qdata (pending,
+                                               quark_pending_constraint_state);
 }
 
 static MetaWaylandPendingConstraintState *
@@ -734,10 +735,10 @@ ensure_pending_constraint_state_container (MetaWaylandSurfaceState *pending)
   if (!container)
     {
       container = g_new0 (MetaWaylandPendingConstraintStateContainer, 1);
-      g_object_set_qdata_full (G_OBJECT (pending),
-                               quark_pending_constraint_state,
-                               container,
-                               (GDestroyNotify) pending_constraint_state_container_free);
+      meta_wayland_surface_state_set_qdata_full (pending,
+                                                 quark_pending_constraint_state,
+                                                 container,
+                                                 (GDestroyNotify) pending_constraint_state_container_free);
 
     }
 
@@ -766,10 +767,10 @@ remove_pending_constraint_state (MetaWaylandPointerConstraint *constraint,
 }
 
 static void
-pending_constraint_state_applied (MetaWaylandSurfaceState           *pending,
-                                  MetaWaylandPendingConstraintState *constraint_pending)
+pending_constraint_state_applied (MetaWaylandPendingConstraintState *constraint_pending)
 {
   MetaWaylandPointerConstraint *constraint = constraint_pending->constraint;
+  MetaWaylandSurfaceState *pending = constraint_pending->pending;
 
   if (!constraint)
     return;
@@ -785,7 +786,8 @@ pending_constraint_state_applied (MetaWaylandSurfaceState           *pending,
       constraint->region = NULL;
     }
 
-  g_clear_signal_handler (&constraint_pending->applied_handler_id, pending);
+  meta_wayland_surface_state_remove_applied_hook (pending,
+                                                  &constraint_pending->applied_hook_id);
   remove_pending_constraint_state (constraint, pending);
 
   /* The pointer is potentially warped by the actor paint signal callback if
@@ -807,10 +809,11 @@ ensure_pending_constraint_state (MetaWaylandPointerConstraint *constraint)
     {
       constraint_pending = g_new0 (MetaWaylandPendingConstraintState, 1);
       constraint_pending->constraint = constraint;
-      constraint_pending->applied_handler_id =
-        g_signal_connect (pending, "applied",
-                          G_CALLBACK (pending_constraint_state_applied),
-                          constraint_pending);
+      constraint_pending->pending = pending;
+      constraint_pending->applied_hook_id =
+        meta_wayland_surface_state_add_applied_hook (pending,
+                                                     (GHookFunc) pending_constraint_state_applied,
+                                                     constraint_pending);
       g_object_add_weak_pointer (G_OBJECT (constraint),
                                  (gpointer *) &constraint_pending->constraint);
 
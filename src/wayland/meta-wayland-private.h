@@ -111,6 +111,12 @@ struct _MetaWaylandCompositor
    * order they were committed.
    */
   GQueue committed_transactions;
+
+  /* Released transactions, transaction entries and surface states, kept for
+   * reuse to avoid allocating on every wl_surface.commit */
+  GPtrArray *transaction_pool;
+  GPtrArray *transaction_entry_pool;
+  GPtrArray *surface_state_pool;
 };
 
 gboolean meta_wayland_compositor_is_egl_display_bound (MetaWaylandCompositor *compositor);
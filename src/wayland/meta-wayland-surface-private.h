@@ -35,12 +35,6 @@
 G_DECLARE_DERIVABLE_TYPE (MetaWaylandSurfaceRole, meta_wayland_surface_role,
                           META, WAYLAND_SURFACE_ROLE, GObject);
 
-#define META_TYPE_WAYLAND_SURFACE_STATE (meta_wayland_surface_state_get_type ())
-G_DECLARE_FINAL_TYPE (MetaWaylandSurfaceState,
-                      meta_wayland_surface_state,
-                      META, WAYLAND_SURFACE_STATE,
-                      GObject)
-
 struct _MetaWaylandSurfaceRoleClass
 {
   GObjectClass parent_class;
@@ -70,7 +64,12 @@ struct _MetaWaylandSurfaceRoleClass
 
 struct _MetaWaylandSurfaceState
 {
-  GObject parent;
+  MetaWaylandCompositor *compositor;
+
+  /* Data attached by other protocol implementations */
+  GData *qdata;
+  /* Invoked when the state has been applied to its surface */
+  GHookList applied_hooks;
 
   /* wl_surface.attach */
   gboolean newly_attached;
@@ -178,6 +177,13 @@ struct _MetaWaylandSurface
   /* Buffer renderer state. */
   gboolean buffer_held;
 
+  /* Shm buffer damage not yet uploaded because the surface was culled out.
+   * The buffer it is to be uploaded from is kept in use until then. */
+  struct {
+    MtkRegion *region;
+    MetaWaylandBuffer *buffer;
+  } deferred_damage;
+
   /* Intermediate state for when no role has been assigned. */
   struct {
     struct wl_list pending_frame_callback_list;
@@ -305,6 +311,8 @@ gboolean            meta_wayland_surface_assign_role (MetaWaylandSurface *surfac
 
 MetaWaylandBuffer  *meta_wayland_surface_get_buffer (MetaWaylandSurface *surface);
 
+void                meta_wayland_surface_flush_deferred_damage (MetaWaylandSurface *surface);
+
 void                meta_wayland_surface_configure_notify (MetaWaylandSurface             *surface,
                                                            MetaWaylandWindowConfiguration *configuration);
 
@@ -413,11 +421,31 @@ void meta_wayland_surface_notify_highest_scale_monitor (MetaWaylandSurface *surf
 
 void meta_wayland_surface_notify_actor_changed (MetaWaylandSurface *surface);
 
-static inline MetaWaylandSurfaceState *
-meta_wayland_surface_state_new (void)
-{
-  return g_object_new (META_TYPE_WAYLAND_SURFACE_STATE, NULL);
-}
+MetaWaylandSurfaceState * meta_wayland_surface_state_new (MetaWaylandCompositor *compositor);
+
+void meta_wayland_surface_state_free (MetaWaylandSurfaceState *state);
+
+gpointer meta_wayland_surface_state_get_qdata (MetaWaylandSurfaceState *state,
+                                               GQuark                   quark);
+
+void meta_wayland_surface_state_set_qdata_full (MetaWaylandSurfaceState *state,
+                                                GQuark                   quark,
+                                                gpointer                 data,
+                                                GDestroyNotify           destroy);
+
+gulong meta_wayland_surface_state_add_applied_hook (MetaWaylandSurfaceState *state,
+                                                    GHookFunc                func,
+                                                    gpointer                 user_data);
+
+void meta_wayland_surface_state_remove_applied_hook (MetaWaylandSurfaceState *state,
+                                                     gulong                  *hook_id);
+
+void meta_wayland_surface_state_pool_init (MetaWaylandCompositor *compositor);
+
+void meta_wayland_surface_state_pool_finalize (MetaWaylandCompositor *compositor);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaWaylandSurfaceState,
+                               meta_wayland_surface_state_free)
 gboolean meta_wayland_surface_is_xwayland (MetaWaylandSurface *surface);
 
 static inline GNode *
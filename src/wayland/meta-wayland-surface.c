@@ -54,12 +54,8 @@
 #include "wayland/meta-xwayland-private.h"
 #endif
 
-enum
-{
-  SURFACE_STATE_SIGNAL_APPLIED,
-
-  SURFACE_STATE_SIGNAL_N_SIGNALS
-};
+/* Number of released surface states kept around for reuse */
+#define SURFACE_STATE_POOL_SIZE 64
 
 enum
 {
@@ -68,8 +64,6 @@ enum
   SURFACE_ROLE_PROP_SURFACE,
 };
 
-static guint surface_state_signals[SURFACE_STATE_SIGNAL_N_SIGNALS];
-
 typedef struct _MetaWaylandSurfaceRolePrivate
 {
   MetaWaylandSurface *surface;
@@ -93,10 +87,6 @@ G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (MetaWaylandSurfaceRole,
                                      meta_wayland_surface_role,
                                      G_TYPE_OBJECT)
 
-G_DEFINE_TYPE (MetaWaylandSurfaceState,
-               meta_wayland_surface_state,
-               G_TYPE_OBJECT)
-
 enum
 {
   SURFACE_DESTROY,
@@ -290,6 +280,156 @@ region_transform (const MtkRegion      *region,
   return transformed_region;
 }
 
+static void
+surface_upload_damage (MetaWaylandSurface *surface,
+                       MetaWaylandBuffer  *buffer,
+                       MtkRegion          *buffer_region)
+{
+  MetaSurfaceActor *actor;
+
+  meta_wayland_buffer_process_damage (buffer, surface->applied_state.texture,
+                                      buffer_region);
+
+  actor = meta_wayland_surface_get_actor (surface);
+  if (actor)
+    {
+      int i, n_rectangles;
+
+      n_rectangles = mtk_region_num_rectangles (buffer_region);
+      for (i = 0; i < n_rectangles; i++)
+        {
+          MtkRectangle rect;
+          rect = mtk_region_get_rectangle (buffer_region, i);
+
+          meta_surface_actor_process_damage (actor,
+                                             rect.x, rect.y,
+                                             rect.width, rect.height);
+        }
+    }
+}
+
+static void
+clear_deferred_damage (MetaWaylandSurface *surface)
+{
+  g_clear_pointer (&surface->deferred_damage.region, mtk_region_unref);
+
+  if (surface->deferred_damage.buffer)
+    {
+      meta_wayland_buffer_dec_use_count (surface->deferred_damage.buffer);
+      g_clear_object (&surface->deferred_damage.buffer);
+    }
+}
+
+static void
+hold_deferred_damage_buffer (MetaWaylandSurface *surface,
+                             MetaWaylandBuffer  *buffer)
+{
+  if (surface->deferred_damage.buffer == buffer)
+    return;
+
+  /* Keep the buffer from being released, as the client must not change its
+   * content before the deferred damage has been uploaded from it. */
+  g_object_ref (buffer);
+  meta_wayland_buffer_inc_use_count (buffer);
+
+  if (surface->deferred_damage.buffer)
+    {
+      meta_wayland_buffer_dec_use_count (surface->deferred_damage.buffer);
+      g_object_unref (surface->deferred_damage.buffer);
+    }
+
+  surface->deferred_damage.buffer = buffer;
+}
+
+static gboolean
+should_defer_damage (MetaWaylandSurface *surface,
+                     MetaWaylandBuffer  *buffer)
+{
+  MetaSurfaceActor *actor;
+  MetaWindow *toplevel_window;
+
+  /* Only shm buffers are copied into the texture on damage, for anything
+   * else there is no upload to avoid. */
+  if (buffer->type != META_WAYLAND_BUFFER_TYPE_SHM || !buffer->resource)
+    return FALSE;
+
+  /* Deferred damage is flushed by the Wayland window actors before painting,
+   * X11 window actors of Xwayland surfaces never do that. */
+  if (meta_wayland_surface_is_xwayland (surface))
+    return FALSE;
+
+  actor = meta_wayland_surface_get_actor (surface);
+  if (!actor || !meta_surface_actor_is_culled_out (actor))
+    return FALSE;
+
+  toplevel_window = meta_wayland_surface_get_toplevel_window (surface);
+  if (toplevel_window)
+    {
+      MetaWindowActor *toplevel_window_actor;
+
+      toplevel_window_actor = meta_window_actor_from_window (toplevel_window);
+      if (toplevel_window_actor &&
+          meta_window_actor_is_streaming (toplevel_window_actor))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+update_deferred_damage_buffer (MetaWaylandSurface *surface,
+                               MetaMultiTexture   *old_texture)
+{
+  MetaWaylandBuffer *buffer = surface->buffer;
+
+  if (!surface->deferred_damage.region)
+    return;
+
+  /* Damage is relative to the previous content of the texture, so as long as
+   * the same texture is reused for the new shm buffer, the new buffer has
+   * valid content for the deferred region too. A newly created texture was
+   * filled completely when the buffer was attached. */
+  if (buffer &&
+      buffer->type == META_WAYLAND_BUFFER_TYPE_SHM &&
+      buffer->resource &&
+      surface->applied_state.texture == old_texture)
+    hold_deferred_damage_buffer (surface, buffer);
+  else
+    clear_deferred_damage (surface);
+}
+
+void
+meta_wayland_surface_flush_deferred_damage (MetaWaylandSurface *surface)
+{
+  g_autoptr (MtkRegion) region = NULL;
+  MetaWaylandBuffer *buffer;
+  MetaWindow *toplevel_window;
+
+  if (!surface->deferred_damage.region)
+    return;
+
+  region = g_steal_pointer (&surface->deferred_damage.region);
+  buffer = surface->deferred_damage.buffer;
+
+  COGL_TRACE_BEGIN_SCOPED (MetaWaylandSurfaceFlushDeferredDamage,
+                           "Meta::WaylandSurface::flush_deferred_damage()");
+
+  if (buffer == surface->buffer && buffer->resource)
+    surface_upload_damage (surface, buffer, region);
+
+  clear_deferred_damage (surface);
+
+  toplevel_window = meta_wayland_surface_get_toplevel_window (surface);
+  if (toplevel_window)
+    {
+      MetaWindowActor *toplevel_window_actor;
+
+      toplevel_window_actor = meta_window_actor_from_window (toplevel_window);
+      if (toplevel_window_actor)
+        meta_window_actor_notify_damaged (toplevel_window_actor);
+    }
+}
+
 static void
 surface_process_damage (MetaWaylandSurface *surface,
                         MtkRegion          *surface_region,
@@ -297,7 +437,6 @@ surface_process_damage (MetaWaylandSurface *surface,
 {
   MetaWaylandBuffer *buffer = meta_wayland_surface_get_buffer (surface);
   MtkRectangle buffer_rect;
-  MetaSurfaceActor *actor;
 
   /* If the client destroyed the buffer it attached before committing, but
    * still posted damage, or posted damage without any buffer, don't try to
@@ -378,25 +517,29 @@ surface_process_damage (MetaWaylandSurface *surface,
 
   mtk_region_intersect_rectangle (buffer_region, &buffer_rect);
 
-  meta_wayland_buffer_process_damage (buffer, surface->applied_state.texture,
-                                      buffer_region);
-
-  actor = meta_wayland_surface_get_actor (surface);
-  if (actor)
+  /* Nothing of a culled out surface ends up on screen, so don't spend time
+   * on uploading its damage until it becomes visible again, see
+   * meta_wayland_surface_flush_deferred_damage(). */
+  if (should_defer_damage (surface, buffer))
     {
-      int i, n_rectangles;
+      if (surface->deferred_damage.region)
+        mtk_region_union (surface->deferred_damage.region, buffer_region);
+      else
+        surface->deferred_damage.region = mtk_region_copy (buffer_region);
 
-      n_rectangles = mtk_region_num_rectangles (buffer_region);
-      for (i = 0; i < n_rectangles; i++)
-        {
-          MtkRectangle rect;
-          rect = mtk_region_get_rectangle (buffer_region, i);
+      hold_deferred_damage_buffer (surface, buffer);
+      return;
+    }
 
-          meta_surface_actor_process_damage (actor,
-                                             rect.x, rect.y,
-                                             rect.width, rect.height);
-        }
+  if (surface->deferred_damage.region)
+    {
+      mtk_region_union (buffer_region, surface->deferred_damage.region);
+      g_clear_pointer (&surface->deferred_damage.region, mtk_region_unref);
     }
+
+  surface_upload_damage (surface, buffer, buffer_region);
+
+  clear_deferred_damage (surface);
 }
 
 MetaWaylandBuffer *
@@ -429,8 +572,12 @@ meta_wayland_surface_state_set_default (MetaWaylandSurfaceState *state)
   state->opaque_region = NULL;
   state->opaque_region_set = FALSE;
 
-  state->surface_damage = mtk_region_create ();
-  state->buffer_damage = mtk_region_create ();
+  /* Damage regions are emptied in place when clearing, and only allocated
+   * for new states */
+  if (!state->surface_damage)
+    state->surface_damage = mtk_region_create ();
+  if (!state->buffer_damage)
+    state->buffer_damage = mtk_region_create ();
   wl_list_init (&state->frame_callback_list);
 
   state->has_new_geometry = FALSE;
@@ -446,6 +593,8 @@ meta_wayland_surface_state_set_default (MetaWaylandSurfaceState *state)
 
   wl_list_init (&state->presentation_feedback_list);
 
+  state->derived.surface_size_changed = FALSE;
+
   state->xdg_popup_reposition_token = 0;
 
   state->drm_syncobj.acquire = NULL;
@@ -473,8 +622,9 @@ meta_wayland_surface_state_clear (MetaWaylandSurfaceState *state)
   g_clear_object (&state->drm_syncobj.acquire);
   g_clear_object (&state->drm_syncobj.release);
 
-  g_clear_pointer (&state->surface_damage, mtk_region_unref);
-  g_clear_pointer (&state->buffer_damage, mtk_region_unref);
+  /* Subtracting a region from itself empties it without reallocating */
+  mtk_region_subtract (state->surface_damage, state->surface_damage);
+  mtk_region_subtract (state->buffer_damage, state->buffer_damage);
   g_clear_pointer (&state->input_region, mtk_region_unref);
   g_clear_pointer (&state->opaque_region, mtk_region_unref);
   g_clear_pointer (&state->xdg_positioner, g_free);
@@ -540,7 +690,7 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
       if (to->input_region)
         mtk_region_union (to->input_region, from->input_region);
       else
-        to->input_region = mtk_region_ref (from->input_region);
+        to->input_region = g_steal_pointer (&from->input_region);
 
       to->input_region_set = TRUE;
     }
@@ -550,7 +700,7 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
       if (to->opaque_region)
         mtk_region_union (to->opaque_region, from->opaque_region);
       else
-        to->opaque_region = mtk_region_ref (from->opaque_region);
+        to->opaque_region = g_steal_pointer (&from->opaque_region);
 
       to->opaque_region_set = TRUE;
     }
@@ -645,35 +795,105 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
 }
 
 static void
-meta_wayland_surface_state_finalize (GObject *object)
+meta_wayland_surface_state_destroy (MetaWaylandSurfaceState *state)
 {
-  MetaWaylandSurfaceState *state = META_WAYLAND_SURFACE_STATE (object);
-
   meta_wayland_surface_state_clear (state);
-
-  G_OBJECT_CLASS (meta_wayland_surface_state_parent_class)->finalize (object);
+  g_clear_pointer (&state->surface_damage, mtk_region_unref);
+  g_clear_pointer (&state->buffer_damage, mtk_region_unref);
+  g_free (state);
 }
 
-static void
-meta_wayland_surface_state_init (MetaWaylandSurfaceState *state)
+MetaWaylandSurfaceState *
+meta_wayland_surface_state_new (MetaWaylandCompositor *compositor)
 {
+  GPtrArray *pool = compositor->surface_state_pool;
+  MetaWaylandSurfaceState *state;
+
+  if (pool && pool->len > 0)
+    return g_ptr_array_steal_index_fast (pool, pool->len - 1);
+
+  state = g_new0 (MetaWaylandSurfaceState, 1);
+  state->compositor = compositor;
   meta_wayland_surface_state_set_default (state);
+
+  return state;
 }
 
-static void
-meta_wayland_surface_state_class_init (MetaWaylandSurfaceStateClass *klass)
+void
+meta_wayland_surface_state_free (MetaWaylandSurfaceState *state)
 {
-  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GPtrArray *pool = state->compositor->surface_state_pool;
 
-  object_class->finalize = meta_wayland_surface_state_finalize;
+  if (state->applied_hooks.is_setup)
+    g_hook_list_clear (&state->applied_hooks);
+  g_datalist_clear (&state->qdata);
 
-  surface_state_signals[SURFACE_STATE_SIGNAL_APPLIED] =
-    g_signal_new ("applied",
-                  G_TYPE_FROM_CLASS (object_class),
-                  G_SIGNAL_RUN_LAST,
-                  0,
-                  NULL, NULL, NULL,
-                  G_TYPE_NONE, 0);
+  if (!pool || pool->len >= SURFACE_STATE_POOL_SIZE)
+    {
+      meta_wayland_surface_state_destroy (state);
+      return;
+    }
+
+  meta_wayland_surface_state_reset (state);
+  g_ptr_array_add (pool, state);
+}
+
+gpointer
+meta_wayland_surface_state_get_qdata (MetaWaylandSurfaceState *state,
+                                      GQuark                   quark)
+{
+  return g_datalist_id_get_data (&state->qdata, quark);
+}
+
+void
+meta_wayland_surface_state_set_qdata_full (MetaWaylandSurfaceState *state,
+                                           GQuark                   quark,
+                                           gpointer                 data,
+                                           GDestroyNotify           destroy)
+{
+  g_datalist_id_set_data_full (&state->qdata, quark, data, destroy);
+}
+
+gulong
+meta_wayland_surface_state_add_applied_hook (MetaWaylandSurfaceState *state,
+                                             GHookFunc                func,
+                                             gpointer                 user_data)
+{
+  GHook *hook;
+
+  if (!state->applied_hooks.is_setup)
+    g_hook_list_init (&state->applied_hooks, sizeof (GHook));
+
+  hook = g_hook_alloc (&state->applied_hooks);
+  hook->func = func;
+  hook->data = user_data;
+  g_hook_append (&state->applied_hooks, hook);
+
+  return hook->hook_id;
+}
+
+void
+meta_wayland_surface_state_remove_applied_hook (MetaWaylandSurfaceState *state,
+                                                gulong                  *hook_id)
+{
+  if (*hook_id == 0)
+    return;
+
+  g_hook_destroy (&state->applied_hooks, *hook_id);
+  *hook_id = 0;
+}
+
+void
+meta_wayland_surface_state_pool_init (MetaWaylandCompositor *compositor)
+{
+  compositor->surface_state_pool =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) meta_wayland_surface_state_destroy);
+}
+
+void
+meta_wayland_surface_state_pool_finalize (MetaWaylandCompositor *compositor)
+{
+  g_clear_pointer (&compositor->surface_state_pool, g_ptr_array_unref);
 }
 
 static void
@@ -764,12 +984,16 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
        * wl_surface.attach+commit and wl_buffer.release on the attached buffer
        * is symmetric.
        */
+      MetaMultiTexture *old_texture;
+
       if (surface->buffer_held)
         meta_wayland_buffer_dec_use_count (surface->buffer);
 
       g_set_object (&surface->buffer, state->buffer);
-      g_clear_object (&surface->applied_state.texture);
+      old_texture = g_steal_pointer (&surface->applied_state.texture);
       surface->applied_state.texture = g_steal_pointer (&state->texture);
+      update_deferred_damage_buffer (surface, old_texture);
+      g_clear_object (&old_texture);
 
       /* If the newly attached buffer is going to be accessed directly without
        * making a copy, such as an EGL buffer, mark it as in-use don't release
@@ -880,9 +1104,8 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
   if (state->newly_attached && surface->buffer_held)
     g_clear_object (&state->buffer);
 
-  g_signal_emit (state,
-                 surface_state_signals[SURFACE_STATE_SIGNAL_APPLIED],
-                 0);
+  if (state->applied_hooks.is_setup)
+    g_hook_list_invoke (&state->applied_hooks, FALSE);
 
   if (had_damage)
     {
@@ -1538,6 +1761,8 @@ meta_wayland_surface_dispose (GObject *object)
       surface->buffer_held = FALSE;
     }
 
+  clear_deferred_damage (surface);
+
   g_clear_object (&surface->applied_state.texture);
   g_clear_object (&surface->buffer);
 
@@ -1582,7 +1807,7 @@ wl_surface_destructor (struct wl_resource *resource)
 
   g_signal_emit (surface, surface_signals[SURFACE_DESTROY], 0);
 
-  g_clear_object (&surface->pending_state);
+  g_clear_pointer (&surface->pending_state, meta_wayland_surface_state_free);
   g_clear_pointer (&surface->sub.transaction, meta_wayland_transaction_free);
 
   if (surface->resource)
@@ -1615,6 +1840,7 @@ meta_wayland_surface_create (MetaWaylandCompositor *compositor,
   int surface_version;
 
   surface->compositor = compositor;
+  surface->pending_state = meta_wayland_surface_state_new (compositor);
   surface->applied_state.scale = 1;
   surface->committed_state.scale = 1;
 
@@ -1835,8 +2061,6 @@ meta_wayland_surface_get_absolute_coordinates (MetaWaylandSurface  *surface,
 static void
 meta_wayland_surface_init (MetaWaylandSurface *surface)
 {
-  surface->pending_state = meta_wayland_surface_state_new ();
-
   surface->applied_state.subsurface_branch_node = g_node_new (surface);
   surface->applied_state.subsurface_leaf_node =
     g_node_prepend_data (surface->applied_state.subsurface_branch_node, surface);
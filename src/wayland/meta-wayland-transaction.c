@@ -30,6 +30,10 @@
 
 #define META_WAYLAND_TRANSACTION_NONE ((void *)(uintptr_t) G_MAXSIZE)
 
+/* Number of released transactions and entries kept around for reuse */
+#define TRANSACTION_POOL_SIZE 16
+#define TRANSACTION_ENTRY_POOL_SIZE 64
+
 struct _MetaWaylandTransaction
 {
   GList node;
@@ -45,6 +49,10 @@ struct _MetaWaylandTransaction
 
   /* Sources for buffers which are not ready yet */
   GHashTable *buf_sources;
+
+  /* Scratch arrays used while applying, kept when the transaction is reused */
+  GPtrArray *apply_surfaces;
+  GPtrArray *apply_states;
 };
 
 struct _MetaWaylandTransactionEntry
@@ -168,9 +176,9 @@ static void
 meta_wayland_transaction_apply (MetaWaylandTransaction  *transaction,
                                 MetaWaylandTransaction **first_candidate)
 {
-  g_autofree MetaWaylandSurface **surfaces = NULL;
-  g_autofree MetaWaylandSurfaceState **states = NULL;
-  unsigned int num_surfaces;
+  GPtrArray *surfaces;
+  GPtrArray *states;
+  GHashTableIter iter;
   MetaWaylandSurface *surface;
   MetaWaylandTransactionEntry *entry;
   int i;
@@ -178,15 +186,23 @@ meta_wayland_transaction_apply (MetaWaylandTransaction  *transaction,
   if (g_hash_table_size (transaction->entries) == 0)
     goto free;
 
-  surfaces = (MetaWaylandSurface **)
-    g_hash_table_get_keys_as_array (transaction->entries, &num_surfaces);
-  states = g_new (MetaWaylandSurfaceState *, num_surfaces);
+  if (!transaction->apply_surfaces)
+    {
+      transaction->apply_surfaces = g_ptr_array_new ();
+      transaction->apply_states = g_ptr_array_new ();
+    }
+
+  surfaces = transaction->apply_surfaces;
+  states = transaction->apply_states;
+  g_ptr_array_set_size (surfaces, 0);
+  g_ptr_array_set_size (states, 0);
 
   /* Apply sub-surface states to ensure output surface hierarchy is up to date */
-  for (i = 0; i < num_surfaces; i++)
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
     {
-      surface = surfaces[i];
-      entry = meta_wayland_transaction_get_entry (transaction, surface);
+      g_ptr_array_add (surfaces, surface);
       meta_wayland_transaction_apply_subsurface_position (surface, entry);
 
       if (entry->state && entry->state->subsurface_placement_ops)
@@ -194,16 +210,15 @@ meta_wayland_transaction_apply (MetaWaylandTransaction  *transaction,
     }
 
   /* Sort surfaces from ancestors to descendants */
-  qsort (surfaces, num_surfaces, sizeof (MetaWaylandSurface *),
-         meta_wayland_transaction_compare);
+  g_ptr_array_sort (surfaces, meta_wayland_transaction_compare);
 
   /* Apply states from ancestors to descendants */
-  for (i = 0; i < num_surfaces; i++)
+  for (i = 0; i < surfaces->len; i++)
     {
-      surface = surfaces[i];
+      surface = g_ptr_array_index (surfaces, i);
       entry = meta_wayland_transaction_get_entry (transaction, surface);
 
-      states[i] = entry->state;
+      g_ptr_array_add (states, entry->state);
       if (entry->state)
         meta_wayland_surface_apply_state (surface, entry->state);
 
@@ -225,10 +240,10 @@ meta_wayland_transaction_apply (MetaWaylandTransaction  *transaction,
     }
 
   /* Synchronize child states from descendants to ancestors */
-  for (i = num_surfaces - 1; i >= 0; i--)
+  for (i = surfaces->len - 1; i >= 0; i--)
     {
-      if (states[i])
-        meta_wayland_transaction_sync_child_states (surfaces[i]);
+      if (g_ptr_array_index (states, i))
+        meta_wayland_transaction_sync_child_states (g_ptr_array_index (surfaces, i));
     }
 
 free:
@@ -461,6 +476,7 @@ meta_wayland_transaction_ensure_entry (MetaWaylandTransaction *transaction,
                                        MetaWaylandSurface     *surface)
 {
   MetaWaylandTransactionEntry *entry;
+  GPtrArray *pool;
 
   entry = meta_wayland_transaction_get_entry (transaction, surface);
   if (entry)
@@ -470,24 +486,53 @@ meta_wayland_transaction_ensure_entry (MetaWaylandTransaction *transaction,
   surface = g_object_ref (surface);
   g_return_val_if_fail (surface, NULL);
 
-  entry = g_new0 (MetaWaylandTransactionEntry, 1);
+  pool = transaction->compositor->transaction_entry_pool;
+  if (pool && pool->len > 0)
+    entry = g_ptr_array_steal_index_fast (pool, pool->len - 1);
+  else
+    entry = g_new0 (MetaWaylandTransactionEntry, 1);
+
   g_hash_table_insert (transaction->entries, surface, entry);
 
   return entry;
 }
 
 static void
-meta_wayland_transaction_entry_free (MetaWaylandTransactionEntry *entry)
+meta_wayland_transaction_entry_free (MetaWaylandCompositor       *compositor,
+                                     MetaWaylandTransactionEntry *entry)
 {
+  GPtrArray *pool = compositor->transaction_entry_pool;
+
   if (entry->state)
     {
       if (entry->state->buffer)
         meta_wayland_buffer_dec_use_count (entry->state->buffer);
 
-      g_clear_object (&entry->state);
+      g_clear_pointer (&entry->state, meta_wayland_surface_state_free);
+    }
+
+  if (!pool || pool->len >= TRANSACTION_ENTRY_POOL_SIZE)
+    {
+      g_free (entry);
+      return;
     }
 
-  g_free (entry);
+  *entry = (MetaWaylandTransactionEntry) { 0 };
+  g_ptr_array_add (pool, entry);
+}
+
+static void
+meta_wayland_transaction_clear_entries (MetaWaylandTransaction *transaction)
+{
+  GHashTableIter iter;
+  MetaWaylandTransactionEntry *entry;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    meta_wayland_transaction_entry_free (transaction->compositor, entry);
+
+  /* Drops the surface references, but keeps the table storage around */
+  g_hash_table_remove_all (transaction->entries);
 }
 
 void
@@ -501,7 +546,7 @@ meta_wayland_transaction_add_placement_op (MetaWaylandTransaction           *tra
   entry = meta_wayland_transaction_ensure_entry (transaction, surface);
 
   if (!entry->state)
-    entry->state = meta_wayland_surface_state_new ();
+    entry->state = meta_wayland_surface_state_new (transaction->compositor);
 
   state = entry->state;
   state->subsurface_placement_ops =
@@ -536,7 +581,7 @@ meta_wayland_transaction_add_xdg_popup_reposition (MetaWaylandTransaction *trans
   if (entry->state)
     g_clear_pointer (&entry->state->xdg_positioner, g_free);
   else
-    entry->state = meta_wayland_surface_state_new ();
+    entry->state = meta_wayland_surface_state_new (transaction->compositor);
 
   state = entry->state;
   state->xdg_positioner = xdg_positioner;
@@ -559,7 +604,7 @@ meta_wayland_transaction_entry_merge_into (MetaWaylandTransactionEntry *from,
       if (to->state)
         {
           meta_wayland_surface_state_merge_into (from->state, to->state);
-          g_clear_object (&from->state);
+          g_clear_pointer (&from->state, meta_wayland_surface_state_free);
         }
       else
         {
@@ -589,6 +634,7 @@ meta_wayland_transaction_merge_into (MetaWaylandTransaction *from,
         }
 
       meta_wayland_transaction_entry_merge_into (from_entry, to_entry);
+      meta_wayland_transaction_entry_free (from->compositor, from_entry);
       g_hash_table_iter_remove (&iter);
     }
 
@@ -607,7 +653,8 @@ meta_wayland_transaction_merge_pending_state (MetaWaylandTransaction *transactio
   if (!entry->state)
     {
       entry->state = pending;
-      surface->pending_state = meta_wayland_surface_state_new ();
+      surface->pending_state =
+        meta_wayland_surface_state_new (transaction->compositor);
       return;
     }
 
@@ -618,20 +665,38 @@ meta_wayland_transaction_merge_pending_state (MetaWaylandTransaction *transactio
 MetaWaylandTransaction *
 meta_wayland_transaction_new (MetaWaylandCompositor *compositor)
 {
+  GPtrArray *pool = compositor->transaction_pool;
   MetaWaylandTransaction *transaction;
 
+  if (pool && pool->len > 0)
+    return g_ptr_array_steal_index_fast (pool, pool->len - 1);
+
   transaction = g_new0 (MetaWaylandTransaction, 1);
 
   transaction->compositor = compositor;
   transaction->entries = g_hash_table_new_full (NULL, NULL, g_object_unref,
-                                                (GDestroyNotify) meta_wayland_transaction_entry_free);
+                                                NULL);
 
   return transaction;
 }
 
+static void
+meta_wayland_transaction_destroy (MetaWaylandTransaction *transaction)
+{
+  meta_wayland_transaction_clear_entries (transaction);
+
+  g_clear_pointer (&transaction->buf_sources, g_hash_table_destroy);
+  g_hash_table_destroy (transaction->entries);
+  g_clear_pointer (&transaction->apply_surfaces, g_ptr_array_unref);
+  g_clear_pointer (&transaction->apply_states, g_ptr_array_unref);
+  g_free (transaction);
+}
+
 void
 meta_wayland_transaction_free (MetaWaylandTransaction *transaction)
 {
+  GPtrArray *pool = transaction->compositor->transaction_pool;
+
   if (transaction->node.data)
     {
       GQueue *committed_queue =
@@ -640,9 +705,21 @@ meta_wayland_transaction_free (MetaWaylandTransaction *transaction)
       g_queue_unlink (committed_queue, &transaction->node);
     }
 
-  g_clear_pointer (&transaction->buf_sources, g_hash_table_destroy);
-  g_hash_table_destroy (transaction->entries);
-  g_free (transaction);
+  if (!pool || pool->len >= TRANSACTION_POOL_SIZE)
+    {
+      meta_wayland_transaction_destroy (transaction);
+      return;
+    }
+
+  meta_wayland_transaction_clear_entries (transaction);
+  if (transaction->buf_sources)
+    g_hash_table_remove_all (transaction->buf_sources);
+
+  transaction->node.data = NULL;
+  transaction->next_candidate = NULL;
+  transaction->committed_sequence = 0;
+
+  g_ptr_array_add (pool, transaction);
 }
 
 void
@@ -661,6 +738,9 @@ meta_wayland_transaction_finalize (MetaWaylandCompositor *compositor)
 
       meta_wayland_transaction_free (transaction);
     }
+
+  g_clear_pointer (&compositor->transaction_pool, g_ptr_array_unref);
+  g_clear_pointer (&compositor->transaction_entry_pool, g_ptr_array_unref);
 }
 
 void
@@ -670,4 +750,8 @@ meta_wayland_transaction_init (MetaWaylandCompositor *compositor)
 
   transactions = meta_wayland_compositor_get_committed_transactions (compositor);
   g_queue_init (transactions);
+
+  compositor->transaction_pool =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) meta_wayland_transaction_destroy);
+  compositor->transaction_entry_pool = g_ptr_array_new_with_free_func (g_free);
 }